@@ -24,6 +24,15 @@ macro(define_opencv_module name)
     endif()
     source_group("Src" FILES ${lib_srcs} ${lib_int_hdrs})
 
+    # the kernels for the instruction sets that are checked at runtime, see ENABLE_RUNTIME_DISPATCH
+    foreach(isa SSSE3 SSE4_1 AVX)
+        string(TOLOWER ${isa} isa_suffix)
+        file(GLOB isa_srcs "src/*.${isa_suffix}.cpp")
+        if(isa_srcs AND HAVE_DISPATCH_${isa})
+            set_source_files_properties(${isa_srcs} PROPERTIES COMPILE_FLAGS "${OPENCV_DISPATCH_${isa}_FLAGS}")
+        endif()
+    endforeach()
+
     file(GLOB lib_hdrs "include/opencv2/${name}/*.h*")
     source_group("Include" FILES ${lib_hdrs})
 
@@ -165,5 +174,58 @@ macro(define_opencv_module name)
         #    install(TARGETS ${the_target} RUNTIME DESTINATION bin COMPONENT main)
         #endif()
     endif()    
+
+    if(BUILD_PERF_TESTS AND EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/perf)
+        include_directories("${CMAKE_CURRENT_SOURCE_DIR}/include"
+                            "${CMAKE_CURRENT_SOURCE_DIR}/perf"
+                            "${CMAKE_CURRENT_BINARY_DIR}")
+
+        set(perf_deps opencv_${name} ${ARGN} opencv_ts opencv_highgui ${EXTRA_opencv_${name}_DEPS})
+        foreach(d ${perf_deps})
+            if(${d} MATCHES "opencv_")
+                if(${d} MATCHES "opencv_lapack")
+                else()
+                    string(REPLACE "opencv_" "${CMAKE_CURRENT_SOURCE_DIR}/../" d_dir ${d})
+                    include_directories("${d_dir}/include")
+                endif()
+            endif()
+        endforeach()
+
+        file(GLOB perf_srcs "perf/*.cpp")
+        file(GLOB perf_hdrs "perf/*.h*")
+
+        source_group("Src" FILES ${perf_srcs})
+        source_group("Include" FILES ${perf_hdrs})
+
+        set(the_target "opencv_perf_${name}")
+
+        add_executable(${the_target} ${perf_srcs} ${perf_hdrs})
+
+        if(PCHSupport_FOUND AND USE_PRECOMPILED_HEADERS)
+            set(pch_header ${CMAKE_CURRENT_SOURCE_DIR}/perf/perf_precomp.hpp)
+            if(${CMAKE_GENERATOR} MATCHES "Visual*" OR ${CMAKE_GENERATOR} MATCHES "Xcode*")
+                if(${CMAKE_GENERATOR} MATCHES "Visual*")
+                    set(${the_target}_pch "perf/perf_precomp.cpp")
+                endif()
+                add_native_precompiled_header(${the_target} ${pch_header})
+            elseif(CMAKE_COMPILER_IS_GNUCXX AND ${CMAKE_GENERATOR} MATCHES ".*Makefiles")
+                add_precompiled_header(${the_target} ${pch_header})
+            endif()
+        endif()
+
+        set_target_properties(${the_target} PROPERTIES
+            DEBUG_POSTFIX "${OPENCV_DEBUG_POSTFIX}"
+            RUNTIME_OUTPUT_DIRECTORY "${EXECUTABLE_OUTPUT_PATH}"
+            )
+
+        if(ENABLE_SOLUTION_FOLDERS)
+            set_target_properties(${the_target} PROPERTIES FOLDER "perf tests")
+        endif()
+
+        add_dependencies(${the_target} ${perf_deps})
+        target_link_libraries(${the_target} ${OPENCV_LINKER_LIBS} ${perf_deps})
+
+        # the performance tests are run manually, they are not registered in ctest
+    endif()
         
 endmacro()
@@ -160,12 +160,23 @@
 /* Intel Threading Building Blocks */
 #cmakedefine  HAVE_TBB
 
-/* Threading Framework --- temporary decision for ARM instead of Intel TBB  */
-#cmakedefine  HAVE_THREADING_FRAMEWORK
+/* Thread-caching small-block pool in cv::fastMalloc */
+#cmakedefine  HAVE_FAST_MALLOC_POOL
+
+/* Trace regions in the main functions, see cv::setTraceEnabled */
+#cmakedefine  HAVE_TRACE
+
+/* Kernels built for SSSE3, SSE4.1 and AVX and selected at runtime */
+#cmakedefine  HAVE_DISPATCH_SSSE3
+#cmakedefine  HAVE_DISPATCH_SSE4_1
+#cmakedefine  HAVE_DISPATCH_AVX
 
 /* Eigen Matrix & Linear Algebra Library */
 #cmakedefine  HAVE_EIGEN
 
+/* External CBLAS library used by cv::gemm */
+#cmakedefine  HAVE_CBLAS
+
 /* NVidia Cuda Runtime API*/
 #cmakedefine HAVE_CUDA
 
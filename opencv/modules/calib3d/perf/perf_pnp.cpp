@@ -0,0 +1,43 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef PerfTestWithParam<int> PointsNum;
+
+static void generatePnPData(int npoints, vector<Point3f>& objectPoints, vector<Point2f>& imagePoints,
+                            Mat& cameraMatrix, Mat& distCoeffs, int noutliers)
+{
+    RNG rng(0x12345678);
+    objectPoints.resize(npoints);
+    for( int i = 0; i < npoints; i++ )
+        objectPoints[i] = Point3f(rng.uniform(-1.f, 1.f), rng.uniform(-1.f, 1.f), rng.uniform(4.f, 6.f));
+    cameraMatrix = (Mat_<double>(3, 3) << 500, 0, 320, 0, 500, 240, 0, 0, 1);
+    distCoeffs = Mat::zeros(5, 1, CV_64F);
+    Mat rvec = (Mat_<double>(3, 1) << 0.1, -0.2, 0.05), tvec = (Mat_<double>(3, 1) << 0.3, -0.1, 0.5);
+    projectPoints(Mat(objectPoints), rvec, tvec, cameraMatrix, distCoeffs, imagePoints);
+    for( int i = 0; i < noutliers && i < npoints; i++ )
+        imagePoints[i] += Point2f(rng.uniform(-50.f, 50.f), rng.uniform(-50.f, 50.f));
+}
+
+PERF_TEST_P(PointsNum, solvePnP, testing::Values(10, 100, 1000))
+{
+    vector<Point3f> objectPoints;
+    vector<Point2f> imagePoints;
+    Mat cameraMatrix, distCoeffs, rvec, tvec;
+    generatePnPData(GetParam(), objectPoints, imagePoints, cameraMatrix, distCoeffs, 0);
+
+    TEST_CYCLE() solvePnP(Mat(objectPoints), Mat(imagePoints), cameraMatrix, distCoeffs, rvec, tvec);
+}
+
+PERF_TEST_P(PointsNum, solvePnPRansac, testing::Values(100, 1000))
+{
+    vector<Point3f> objectPoints;
+    vector<Point2f> imagePoints;
+    Mat cameraMatrix, distCoeffs, rvec, tvec;
+    generatePnPData(GetParam(), objectPoints, imagePoints, cameraMatrix, distCoeffs, GetParam()/5);
+
+    TEST_CYCLE() solvePnPRansac(Mat(objectPoints), Mat(imagePoints), cameraMatrix, distCoeffs, rvec, tvec);
+}
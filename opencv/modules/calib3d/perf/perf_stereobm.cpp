@@ -0,0 +1,20 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef PerfTestWithParam<int> NumDisparities;
+
+PERF_TEST_P(NumDisparities, StereoBM, testing::Values(32, 64))
+{
+    Mat left = imread(getDataPath("stereomatching/datasets/tsukuba/im2.png"), 0);
+    Mat right = imread(getDataPath("stereomatching/datasets/tsukuba/im6.png"), 0);
+    ASSERT_FALSE(left.empty() || right.empty()) << "Unable to load the tsukuba stereo pair";
+    StereoBM bm(StereoBM::BASIC_PRESET, GetParam(), 15);
+    Mat disp;
+    declareBytes(left, right);
+
+    TEST_CYCLE() bm(left, right, disp);
+}
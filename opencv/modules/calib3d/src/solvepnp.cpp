@@ -81,31 +81,6 @@ namespace cv
             transform(points, modif_points, transformation);
         }
         
-        class Mutex
-        {
-        public:
-            Mutex() {}
-            void lock()
-            {
-#ifdef HAVE_TBB
-                slock.acquire(resultsMutex);
-#endif
-            }
-            
-            void unlock()
-            {
-#ifdef HAVE_TBB
-                slock.release();
-#endif
-            }
-            
-        private:
-#ifdef HAVE_TBB
-            tbb::mutex resultsMutex;
-            tbb::mutex::scoped_lock slock;
-#endif
-        };
-        
         struct CameraParameters
         {
             void init(Mat _intrinsics, Mat _distCoeffs)
@@ -182,15 +157,17 @@ namespace cv
             
             if (localInliers.size() > inliers.size())
             {
-                resultsMutex.lock();
-                
-                inliers.clear();
-                inliers.resize(localInliers.size());
-                memcpy(&inliers[0], &localInliers[0], sizeof(int) * localInliers.size());
-                localRvec.copyTo(rvec);
-                localTvec.copyTo(tvec);
+                AutoLock lock(resultsMutex);
                 
-                resultsMutex.unlock();
+                // another thread could find a better solution in the meantime
+                if (localInliers.size() > inliers.size())
+                {
+                    inliers.clear();
+                    inliers.resize(localInliers.size());
+                    memcpy(&inliers[0], &localInliers[0], sizeof(int) * localInliers.size());
+                    localRvec.copyTo(rvec);
+                    localTvec.copyTo(tvec);
+                }
             }
         }
         
@@ -240,6 +217,7 @@ namespace cv
             void generateVar(vector<char>& mask) const
             {
                 size_t size = mask.size();
+                AutoLock lock(syncMutex);
                 for (size_t i = 0; i < size; i++)
                 {
                     int i1 = generator.uniform(0, size);
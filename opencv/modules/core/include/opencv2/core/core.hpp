@@ -204,10 +204,61 @@ CV_EXPORTS ErrorCallback redirectError( ErrorCallback errCallback,
 #define CV_DbgAssert(expr)
 #endif
 
+/*!
+  Sets the number of threads used by cv::parallel_for, cv::parallel_do and cv::parallel_reduce
+
+  When OpenCV is built without TBB, the parallel loops are executed by the built-in thread pool.
+  nthreads is the total number of threads, including the calling one. nthreads=1 makes all
+  the loops serial, nthreads<=0 resets the number to the number of available CPUs (the default).
+  The function should not be called from inside a parallel loop.
+*/
 CV_EXPORTS void setNumThreads(int nthreads);
+
+//! returns the number of threads used by the parallel loops
 CV_EXPORTS int getNumThreads();
+
+//! returns the index of the current thread within the pool: 0 for the calling thread, 1..getNumThreads()-1 for the workers
 CV_EXPORTS int getThreadNum();
 
+//! returns the number of logical CPUs available to the process
+CV_EXPORTS int getNumberOfCPUs();
+
+/*!
+  Simple non-recursive mutex.
+
+  The mutex is reference-counted, so copies of cv::Mutex refer to the same lock.
+  Use cv::AutoLock to lock it for the duration of a scope.
+*/
+class CV_EXPORTS Mutex
+{
+public:
+    Mutex();
+    ~Mutex();
+    Mutex(const Mutex& m);
+    Mutex& operator = (const Mutex& m);
+
+    void lock();
+    bool trylock();
+    void unlock();
+
+    struct Impl;
+protected:
+    Impl* impl;
+};
+
+//! locks the mutex in the constructor and unlocks it in the destructor
+class CV_EXPORTS AutoLock
+{
+public:
+    AutoLock(Mutex& m) : mutex(&m) { mutex->lock(); }
+    ~AutoLock() { mutex->unlock(); }
+protected:
+    Mutex* mutex;
+private:
+    AutoLock(const AutoLock&);
+    AutoLock& operator = (const AutoLock&);
+};
+
 //! Returns the number of ticks.
 
 /*!
@@ -242,6 +293,45 @@ CV_EXPORTS_W double getTickFrequency();
 */
 CV_EXPORTS int64 getCPUTickCount();
 
+//! the accumulated statistics of a trace region, see cv::getTraceStats()
+struct CV_EXPORTS TraceStat
+{
+    TraceStat();
+
+    string name; //!< the region name, normally the function name, e.g. "cv::cvtColor"
+    int64 calls; //!< the number of times the region has been entered
+    double totalTime; //!< the total time spent in the region, in milliseconds
+    double maxTime; //!< the longest single call, in milliseconds
+    double bytes; //!< the amount of processed data reported by the region (0 if it does not report it)
+};
+
+/*!
+  Turns the instrumentation of the main functions on or off.
+
+  When it is on, cvtColor, resize, remap, FilterEngine::apply, CascadeClassifier::detectMultiScale,
+  imread, imdecode and some other functions record the time of every call into a ring buffer of the
+  calling thread and update the per-function statistics. When it is off (the default), a region costs
+  one flag check. The instrumentation can also be turned on by setting the OPENCV_TRACE environment
+  variable to a non-zero value, and it is not compiled at all when OpenCV is built with ENABLE_TRACE=OFF.
+*/
+CV_EXPORTS void setTraceEnabled(bool enabled);
+
+//! returns true if the instrumentation is on
+CV_EXPORTS bool isTraceEnabled();
+
+//! retrieves the statistics of all the regions collected so far, from all the threads, sorted by the total time
+CV_EXPORTS void getTraceStats(vector<TraceStat>& stats);
+
+/*!
+  Writes the recorded calls into a JSON file in the Chrome trace event format
+  (open it in chrome://tracing). Each thread keeps only the last 65536 calls;
+  the aggregated statistics are written into the "stats" field of the file as well.
+*/
+CV_EXPORTS void writeTrace(const string& filename);
+
+//! discards the recorded calls and the statistics
+CV_EXPORTS void clearTrace();
+
 /*!
   Returns SSE etc. support status
   
@@ -283,6 +373,29 @@ CV_EXPORTS void* fastMalloc(size_t bufSize);
 */
 CV_EXPORTS void fastFree(void* ptr);
 
+/*!
+  The statistics of a single size class (bin) of the fastMalloc small-block pool
+*/
+struct CV_EXPORTS MallocBinStats
+{
+    MallocBinStats();
+
+    int objSize; //!< the size of the objects in the bin
+    int64 mallocCalls; //!< the number of cv::fastMalloc() calls served by the bin
+    int64 freeCalls; //!< the number of cv::fastFree() calls
+    int64 cacheHits; //!< the number of allocations served from the per-thread caches
+    int64 remoteFrees; //!< the number of objects released to the blocks owned by other threads
+    int blocks; //!< the number of 16K blocks currently used by the bin
+};
+
+/*!
+  Retrieves the per-bin statistics of the fastMalloc small-block pool
+
+  The pool is used when OpenCV is built with ENABLE_FAST_MALLOC_POOL=ON. Otherwise
+  cv::fastMalloc() is a thin wrapper over malloc(), and the function clears the vector and returns false.
+*/
+CV_EXPORTS bool getMallocStats(vector<MallocBinStats>& stats);
+
 template<typename _Tp> static inline _Tp* allocate(size_t n)
 {
     return new _Tp[n];
@@ -1349,6 +1462,86 @@ public:
                           uchar*& datastart, uchar*& data, size_t* step) = 0;
     virtual void deallocate(int* refcount, uchar* datastart, uchar* data) = 0;
 };
+
+/*!
+   The recycling array allocator
+
+   Keeps the released buffers in per-size-class free lists and reuses them for the subsequent
+   allocations, so a pipeline that processes frames of the same size stops allocating memory
+   after the first few frames. The buffer sizes are rounded up to the size classes spaced
+   by 1/8 of a power of two. The released buffers are cached until the total size of the cached
+   buffers reaches maxCachedBytes or the number of cached buffers of the same size class reaches
+   maxBuffersPerClass; beyond these limits the buffers are freed.
+
+   The allocator can be assigned to Mat::allocator of a particular matrix or installed as
+   the process-wide or thread default with cv::setDefaultAllocator() and cv::setThreadDefaultAllocator().
+   It is thread-safe and must outlive all the matrices allocated with it.
+*/
+class CV_EXPORTS RecyclingMatAllocator : public MatAllocator
+{
+public:
+    struct CV_EXPORTS Stats
+    {
+        Stats();
+
+        int64 hits; //!< the number of allocations served from the cache
+        int64 misses; //!< the number of allocations that needed a new buffer
+        int64 evictions; //!< the number of released buffers freed because of the limits
+        size_t cachedBytes; //!< the total size of the cached buffers
+        int cachedBuffers; //!< the number of the cached buffers
+    };
+
+    RecyclingMatAllocator(size_t maxCachedBytes=256<<20, int maxBuffersPerClass=16);
+    virtual ~RecyclingMatAllocator();
+
+    virtual void allocate(int dims, const int* sizes, int type, int*& refcount,
+                          uchar*& datastart, uchar*& data, size_t* step);
+    virtual void deallocate(int* refcount, uchar* datastart, uchar* data);
+
+    //! changes the limits; the cached buffers exceeding the new limits are freed
+    void setLimits(size_t maxCachedBytes, int maxBuffersPerClass);
+    //! frees all the cached buffers
+    void trim();
+    //! returns the counters
+    Stats getStats() const;
+    //! resets the hit, miss and eviction counters
+    void resetStats();
+
+protected:
+    struct Impl;
+    Impl* impl;
+
+private:
+    RecyclingMatAllocator(const RecyclingMatAllocator&);
+    RecyclingMatAllocator& operator = (const RecyclingMatAllocator&);
+};
+
+/*!
+  Sets the allocator used by Mat::create() for the matrices that do not have their own allocator.
+
+  The allocator is stored in Mat::allocator of the newly allocated matrices.
+  Passing 0 restores the default behavior (the data is allocated with cv::fastMalloc()).
+*/
+CV_EXPORTS void setDefaultAllocator(MatAllocator* allocator);
+
+/*!
+  Sets the default allocator of the calling thread, which overrides the process-wide one.
+  Passing 0 removes the override.
+*/
+CV_EXPORTS void setThreadDefaultAllocator(MatAllocator* allocator);
+
+//! returns the default allocator of the calling thread or 0 if cv::fastMalloc() is used
+CV_EXPORTS MatAllocator* getDefaultAllocator();
+
+/*!
+  The callback that releases the external data owned by Mat.
+
+  It is passed to the Mat constructors that take ownership of a user buffer (memory-mapped frames,
+  shared memory, network buffers etc.) and is called exactly once, when the last matrix header
+  referencing the buffer is released, with the data pointer and the user data given to the constructor.
+  It may be called from any thread.
+*/
+typedef void (*MatDeallocator)(void* data, void* userdata);
     
 /*!
    The n-dimensional matrix class.
@@ -1585,6 +1778,15 @@ public:
     Mat(int _rows, int _cols, int _type, void* _data, size_t _step=AUTO_STEP);
     Mat(Size _size, int _type, void* _data, size_t _step=AUTO_STEP);
     Mat(int _ndims, const int* _sizes, int _type, void* _data, const size_t* _steps=0);
+    //! constructors for matrix headers that take ownership of user-allocated data:
+    //! the data is reference-counted like the data allocated by Mat, and deallocator(_data, _userdata)
+    //! is called when the last header referencing it is released
+    Mat(int _rows, int _cols, int _type, void* _data, MatDeallocator _deallocator,
+        void* _userdata, size_t _step=AUTO_STEP);
+    Mat(Size _size, int _type, void* _data, MatDeallocator _deallocator,
+        void* _userdata, size_t _step=AUTO_STEP);
+    Mat(int _ndims, const int* _sizes, int _type, void* _data, MatDeallocator _deallocator,
+        void* _userdata, const size_t* _steps=0);
     
     //! creates a matrix header for a part of the bigger matrix
     Mat(const Mat& m, const Range& rowRange, const Range& colRange=Range::all());
@@ -2314,6 +2516,59 @@ CV_EXPORTS_W void mulSpectrums(InputArray a, InputArray b, OutputArray c,
 //! computes the minimal vector size vecsize1 >= vecsize so that the dft() of the vector of length vecsize1 can be computed efficiently
 CV_EXPORTS_W int getOptimalDFTSize(int vecsize);
 
+struct DFTTables;
+
+/*!
+ Discrete Fourier Transform plan
+
+ Keeps the factorizations, twiddle factors and permutation tables of the transform
+ for the given array size, type and flags, so that many arrays of the same size can be
+ transformed without recomputing them. The rows and the columns of 2D arrays are
+ transformed in parallel, and a vector of arrays can be transformed in one call:
+
+ \code
+ DFTPlan plan(patches[0].size(), CV_32F, DFT_COMPLEX_OUTPUT);
+ vector<Mat> spectrums;
+ plan(patches, spectrums);
+ \endcode
+
+ The same plan can be used from several threads at once.
+*/
+class CV_EXPORTS DFTPlan
+{
+public:
+    //! the default constructor
+    DFTPlan();
+    //! the constructor that creates the plan for the arrays of the specified size and type
+    DFTPlan(Size size, int type, int flags=0);
+    DFTPlan(const DFTPlan& plan);
+    DFTPlan& operator = (const DFTPlan& plan);
+    ~DFTPlan();
+
+    //! creates the plan; the flags are the same as in cv::dft()
+    void create(Size size, int type, int flags=0);
+    //! returns true if the plan has not been created
+    bool empty() const;
+    //! returns the type of the transformed arrays
+    int dstType() const;
+
+    //! transforms src, which must have the size and the type that the plan was created for
+    void operator()(InputArray src, OutputArray dst, int nonzeroRows=0) const;
+    //! transforms each array of the batch; several arrays are processed in parallel
+    void operator()(const vector<Mat>& src, vector<Mat>& dst) const;
+
+    Size size; //!< the size of the transformed arrays
+    int type; //!< the type of the source arrays
+    int flags; //!< the transformation flags
+    
+protected:
+    const DFTTables* getTables(int len, int invItab) const;
+    void run(const Mat& src, Mat& dst, int nonzeroRows, bool parallel) const;
+    friend class DFTBatchInvoker;
+
+    Ptr<DFTTables> tabs[3];
+};
+
 /*!
  Various k-Means flags
 */
@@ -2321,12 +2576,14 @@ enum
 {
     KMEANS_RANDOM_CENTERS=0, // Chooses random centers for k-Means initialization
     KMEANS_PP_CENTERS=2,     // Uses k-Means++ algorithm for initialization
-    KMEANS_USE_INITIAL_LABELS=1 // Uses the user-provided labels for K-Means initialization
+    KMEANS_USE_INITIAL_LABELS=1, // Uses the user-provided labels for K-Means initialization
+    KMEANS_MINI_BATCH=4,     // Updates the centers from random batches of samples (mini-batch k-Means)
+    KMEANS_HAMERLY=8         // Skips the distance computations that can not change the labels
 };
 //! clusters the input data using k-Means algorithm
 CV_EXPORTS_W double kmeans( InputArray data, int K, CV_OUT InputOutputArray bestLabels,
                             TermCriteria criteria, int attempts,
-                            int flags, OutputArray centers=noArray() );
+                            int flags, OutputArray centers=noArray(), int batchSize=0 );
 
 //! returns the thread-local Random number generator
 CV_EXPORTS RNG& theRNG();
@@ -3699,6 +3956,12 @@ class CV_EXPORTS FileNode;
  The most top level structure is a mapping.
  Leaves of the file storage tree are integers, floating-point numbers and text strings. 
  
+ Besides XML and YAML, the same tree can be stored in the binary container format
+ (FileStorage::FORMAT_BINARY or the ".bin" extension). There the long numerical arrays
+ (e.g. the matrix data) are kept as raw aligned blocks, and when such a file is read, the file is
+ memory-mapped and FileNode >> Mat returns the matrix that references the mapped data instead
+ of a copy. The mapping stays alive while any of such matrices exists, even after the storage is released.
+ 
  For example, the following code:
  
  \code
@@ -3792,7 +4055,13 @@ public:
     {
         READ=0, //! read mode
         WRITE=1, //! write mode
-        APPEND=2 //! append mode
+        APPEND=2, //! append mode
+        
+        FORMAT_MASK=(7<<3), //! mask for the format flags
+        FORMAT_AUTO=0, //! choose the format by the file extension (or by the signature when reading)
+        FORMAT_XML=(1<<3), //! XML
+        FORMAT_YAML=(2<<3), //! YAML
+        FORMAT_BINARY=(3<<3) //! binary container; the large arrays can be read without copying
     };
     enum
     {
@@ -3984,6 +4253,79 @@ public:
     size_t remaining;
 };
 
+/*!
+ Sequential XML/YAML Reader
+ 
+ FileStorage parses the whole file into the tree of nodes when it is opened, which takes
+ several times more memory than the file itself. FileStreamReader walks the file node by node instead,
+ in the depth-first order, and keeps only the current node and the path to it in memory. The nodes
+ that are not needed are skipped without building them, long numerical sequences can be read
+ right into the user buffer, and any moderately sized subtree can be parsed into FileNode
+ to use the usual read() functions:
+ 
+ \code
+ FileStreamReader reader("dataset.yml");
+ while( reader.next() )
+ {
+    if( reader.level() != 1 || reader.type() == FileStreamReader::END )
+        continue;
+    if( reader.name() == "camera_matrix" )
+        read(reader.node(), cameraMatrix, Mat());
+    else if( reader.name() == "points" && reader.type() == FileNode::SEQ )
+    {
+        vector<Point2f> buf(1024);
+        size_t n;
+        while( (n = reader.readRaw("2f", (uchar*)&buf[0], buf.size())) > 0 )
+            points.insert(points.end(), buf.begin(), buf.begin() + n);
+    }
+    else
+        reader.skip();
+ }
+ \endcode
+ 
+ Binary file storages are memory-mapped by FileStorage and are not supported by this class.
+*/
+class CV_EXPORTS FileStreamReader
+{
+public:
+    //! the value of type() after the last element of a sequence or a mapping
+    enum { END=-1 };
+    //! the default constructor
+    FileStreamReader();
+    //! the constructor that opens the file
+    FileStreamReader(const string& filename);
+    //! the destructor. calls release()
+    virtual ~FileStreamReader();
+
+    //! opens XML or YAML file; the previous file is closed with release()
+    virtual bool open(const string& filename);
+    //! returns true if the object is associated with currently opened file
+    virtual bool isOpened() const;
+    //! closes the file and releases all the memory buffers
+    virtual void release();
+
+    //! moves to the next node (a scalar, the beginning or END of a collection); returns false at the end of file
+    bool next();
+    //! returns FileNode::NONE ... FileNode::MAP for the current node or END
+    int type() const;
+    //! returns the name of the current node (or of the collection at its END); empty for sequence elements
+    string name() const;
+    //! returns the type name specified in the file (e.g. "opencv-matrix"), if any
+    string typeName() const;
+    //! returns the depth of the current node; the top-level mapping has level 0
+    int level() const;
+    //! returns the current node. The collection is parsed as a whole, and the reader then continues after it.
+    //! The node is valid until the reader moves
+    FileNode node();
+    //! skips the current sequence or mapping without parsing it; the reader stops at its END. Does nothing for scalars
+    void skip();
+    //! reads up to maxCount elements of the specified format from the current sequence (or the one the reader is in).
+    //! Returns the number of elements read, which is less than maxCount if the sequence is over (the reader is then at its END)
+    size_t readRaw( const string& fmt, uchar* vec, size_t maxCount=(size_t)INT_MAX );
+
+    Ptr<CvFileStorage> fs; //!< the underlying C FileStorage structure
+};
+
 ////////////// convenient wrappers for operating old-style dynamic structures //////////////
 
 template<typename _Tp> class SeqIterator;
@@ -4118,6 +4460,67 @@ public:
 };
 
 
+/*!
+ Contiguous storage for a list of variable-length sequences
+
+ All the sequences are stored back-to-back in a single growing buffer:
+ appending an element costs amortized O(1) and there are no per-block
+ headers to walk, the i-th sequence is just the plain array ptr(i)[0..seqSize(i)),
+ and reset() drops all the sequences while keeping the memory for the next use.
+ It is a lightweight alternative to MemStorage + Seq<_Tp> for algorithms that produce
+ many small sequences, e.g. contours. Elements are always appended to the last
+ sequence, so the sequences are built one at a time.
+
+ \note As Seq<_Tp>, the class is targeted for simple data types.
+    Any append may reallocate the buffer and invalidate the pointers returned by ptr().
+*/
+template<typename _Tp> class CV_EXPORTS SeqArena
+{
+public:
+    //! the default constructor
+    SeqArena();
+    //! the constructor that preallocates space for the specified number of elements and sequences
+    SeqArena(size_t elemCapacity, size_t seqCapacity=0);
+    //! preallocates space for the specified number of elements and sequences
+    void reserve(size_t elemCapacity, size_t seqCapacity=0);
+    //! removes all the sequences; the allocated memory is retained
+    void reset();
+    //! starts a new empty sequence, which becomes the last one; returns its index
+    int openSeq();
+    //! appends the specified element to the last sequence
+    void push_back(const _Tp& elem);
+    //! appends zero or more elements to the last sequence
+    void push_back(const _Tp* elems, size_t count);
+    //! appends count uninitialized elements to the last sequence and returns pointer to the first of them
+    _Tp* grow(size_t count);
+    //! changes the number of elements in the last sequence
+    void resizeLast(size_t len);
+    //! removes the last sequence
+    void popSeq();
+    //! returns the number of sequences
+    size_t size() const;
+    //! returns true iff there are no sequences
+    bool empty() const;
+    //! returns the total number of elements in all the sequences
+    size_t total() const;
+    //! returns the number of elements in the i-th sequence
+    size_t seqSize(int i) const;
+    //! returns pointer to the first element of the i-th sequence
+    _Tp* ptr(int i);
+    //! returns read-only pointer to the first element of the i-th sequence
+    const _Tp* ptr(int i) const;
+    //! copies the i-th sequence to the specified vector
+    void copyTo(int i, vector<_Tp>& vec) const;
+    //! copies all the sequences to the specified vector of vectors
+    void copyTo(vector<vector<_Tp> >& vecs) const;
+
+    //! all the elements of all the sequences
+    vector<_Tp> elems;
+    //! starting positions of the sequences within elems
+    vector<size_t> ofs;
+};
+
+
 #if 0
 class CV_EXPORTS AlgorithmImpl;
 
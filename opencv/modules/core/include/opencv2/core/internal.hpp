@@ -113,12 +113,45 @@ CV_INLINE IppiSize ippiSize(int width, int height)
 #include "pmmintrin.h"
 #define CV_SSE3 1
 #endif
+#if defined __SSSE3__ || defined CV_CPU_COMPILE_SSSE3
+#include "tmmintrin.h"
+#define CV_SSSE3 1
+#endif
+#if defined __SSE4_1__ || defined CV_CPU_COMPILE_SSE4_1
+#include "smmintrin.h"
+#define CV_SSE4_1 1
+#endif
+#if defined __AVX__
+#include "immintrin.h"
+#define CV_AVX 1
+#endif
 #else
 #define CV_SSE 0
 #define CV_SSE2 0
 #define CV_SSE3 0
 #endif
 
+/* CV_SSSE3, CV_SSE4_1 and CV_AVX are only set in the kernels compiled for the newer
+   instruction sets (src/<name>.ssse3.cpp, <name>.sse4_1.cpp, <name>.avx.cpp).
+   Such a kernel must not use the non-static inline or template functions shared with
+   the rest of the library, since the linker may keep its copy for all the CPUs.
+   The kernels are called after the runtime check:
+
+   #ifdef HAVE_DISPATCH_AVX
+       if( checkHardwareSupport(CV_CPU_AVX) )
+           return opt_AVX::kernel(...);
+   #endif
+*/
+#ifndef CV_SSSE3
+#define CV_SSSE3 0
+#endif
+#ifndef CV_SSE4_1
+#define CV_SSE4_1 0
+#endif
+#ifndef CV_AVX
+#define CV_AVX 0
+#endif
+
 #if defined ANDROID && defined __ARM_NEON__
 #include "arm_neon.h"
 #define CV_NEON 1
@@ -154,6 +187,40 @@ CV_INLINE IppiSize ippiSize(int width, int height)
 
 #ifdef __cplusplus
 
+namespace cv
+{
+    /*!
+     The scope of a trace region, see cv::setTraceEnabled().
+
+     When the instrumentation is off, the constructor only checks the flag and the destructor does nothing.
+     The name must be a string literal (or any other string that is never freed).
+    */
+    class CV_EXPORTS TraceRegion
+    {
+    public:
+        TraceRegion(const char* name, size_t bytes=0);
+        ~TraceRegion() { if( name ) finish(); }
+        //! adds the amount of data processed in the region
+        void addBytes(size_t n) { bytes += n; }
+    protected:
+        void finish();
+        const char* name;
+        int64 startTime;
+        size_t bytes;
+    private:
+        TraceRegion(const TraceRegion&);
+        TraceRegion& operator = (const TraceRegion&);
+    };
+}
+
+#ifdef HAVE_TRACE
+#define CV_TRACE_REGION(name) cv::TraceRegion __cv_trace_region(name)
+#define CV_TRACE_BYTES(n) __cv_trace_region.addBytes(n)
+#else
+#define CV_TRACE_REGION(name)
+#define CV_TRACE_BYTES(n)
+#endif
+
 #ifdef HAVE_TBB
     namespace cv
     {
@@ -197,40 +264,156 @@ CV_INLINE IppiSize ippiSize(int width, int height)
             int _begin, _end, _grainsize;
         };
 
-
-#ifdef HAVE_THREADING_FRAMEWORK 
-#include "threading_framework.hpp"
-
-	template<typename Body> 
-	static void parallel_for( const BlockedRange& range, const Body& body )
-	{
-		tf::parallel_for<Body>(range, body);
-	}
-        typedef tf::ConcurrentVector<Rect> ConcurrentRectVector;
-#else
+        /*!
+         The base class for the loop bodies run by the built-in thread pool.
+         
+         The pool splits the range into chunks that are multiples of range.grainsize()
+         (except, possibly, the last one) and calls the body on them concurrently.
+         The body must not modify any shared state without synchronization.
+        */
+        class CV_EXPORTS ParallelLoopBody
+        {
+        public:
+            virtual ~ParallelLoopBody();
+            virtual void operator() (const BlockedRange& range) const = 0;
+        };
+        
+        /*!
+         Runs the loop body on the sub-ranges of range in the built-in thread pool.
+         
+         The calling thread takes part in the processing, so the function can be called
+         from inside another parallel loop. It returns when all the sub-ranges are processed;
+         an exception thrown by the body in any thread is re-thrown in the calling thread.
+        */
+        CV_EXPORTS void parallel_for_(const BlockedRange& range, const ParallelLoopBody& body);
+        
+        //! returns the number of grainsize-aligned stripes the range is split into by parallel_reduce
+        CV_EXPORTS int getNumStripes(const BlockedRange& range);
+        
+        //! returns i-th out of nstripes grainsize-aligned stripes of the range
+        static inline BlockedRange getStripe(const BlockedRange& range, int i, int nstripes)
+        {
+            int grain = std::max(range.grainsize(), 1);
+            int nblocks = (range.end() - range.begin() + grain - 1)/grain;
+            int b = range.begin() + (int)((int64)i*nblocks/nstripes)*grain;
+            int e = range.begin() + (int)((int64)(i+1)*nblocks/nstripes)*grain;
+            return BlockedRange(b, std::min(e, range.end()), grain);
+        }
+        
+        template<typename Body> class ParallelForBodyWrapper : public ParallelLoopBody
+        {
+        public:
+            ParallelForBodyWrapper(const Body& _body) : body(&_body) {}
+            void operator() (const BlockedRange& range) const { (*body)(range); }
+        protected:
+            const Body* body;
+        };
+        
         template<typename Body> static inline
         void parallel_for( const BlockedRange& range, const Body& body )
         {
-            body(range); 
+            parallel_for_(range, ParallelForBodyWrapper<Body>(body));
         }
-        typedef std::vector<Rect> ConcurrentRectVector;
-#endif
+        
+        template<typename Iterator, typename Body> class ParallelDoBodyWrapper : public ParallelLoopBody
+        {
+        public:
+            ParallelDoBodyWrapper(const std::vector<Iterator>& _items, const Body& _body)
+                : items(&_items), body(&_body) {}
+            void operator() (const BlockedRange& range) const
+            {
+                for( int i = range.begin(); i < range.end(); i++ )
+                    (*body)(*(*items)[i]);
+            }
+        protected:
+            const std::vector<Iterator>* items;
+            const Body* body;
+        };
         
         template<typename Iterator, typename Body> static inline
         void parallel_do( Iterator first, Iterator last, const Body& body )
         {
+            std::vector<Iterator> items;
             for( ; first != last; ++first )
-                body(*first);
+                items.push_back(first);
+            parallel_for_(BlockedRange(0, (int)items.size()), ParallelDoBodyWrapper<Iterator, Body>(items, body));
         }
         
         class Split {};
         
+        template<typename Body> class ParallelReduceBodyWrapper : public ParallelLoopBody
+        {
+        public:
+            ParallelReduceBodyWrapper(Body** _bodies, const BlockedRange& _range, int _nstripes)
+                : bodies(_bodies), range(_range), nstripes(_nstripes) {}
+            void operator() (const BlockedRange& r) const
+            {
+                for( int i = r.begin(); i < r.end(); i++ )
+                    (*bodies[i])(getStripe(range, i, nstripes));
+            }
+        protected:
+            Body** bodies;
+            BlockedRange range;
+            int nstripes;
+        };
+        
+        /*!
+         Parallel reduction.
+         
+         The range is split into getNumStripes(range) stripes. The first one is processed by body,
+         the others by its copies made with Body(body, Split()). The copies are then joined into body
+         in the order of the stripes, so for a fixed number of threads the result is reproducible.
+        */
         template<typename Body> static inline
         void parallel_reduce( const BlockedRange& range, Body& body )
         {
-            body(range);
+            int i, nstripes = getNumStripes(range);
+            if( nstripes <= 1 )
+            {
+                body(range);
+                return;
+            }
+            
+            std::vector<Body*> bodies(nstripes, (Body*)0);
+            bodies[0] = &body;
+            try
+            {
+                for( i = 1; i < nstripes; i++ )
+                    bodies[i] = new Body(body, Split());
+                parallel_for_(BlockedRange(0, nstripes), ParallelReduceBodyWrapper<Body>(&bodies[0], range, nstripes));
+            }
+            catch(...)
+            {
+                for( i = 1; i < nstripes; i++ )
+                    delete bodies[i];
+                throw;
+            }
+            for( i = 1; i < nstripes; i++ )
+            {
+                body.join(*bodies[i]);
+                delete bodies[i];
+            }
         }
         
+        /*!
+         Vector that can be appended from several threads of a parallel loop.
+         
+         Only push_back() is synchronized; the other methods must not be called
+         while the vector is being filled.
+        */
+        template<typename _Tp> class ConcurrentVector : public std::vector<_Tp>
+        {
+        public:
+            void push_back(const _Tp& elem)
+            {
+                AutoLock lock(mutex);
+                std::vector<_Tp>::push_back(elem);
+            }
+        protected:
+            Mutex mutex;
+        };
+        
+        typedef ConcurrentVector<Rect> ConcurrentRectVector;
     }
 #endif
 #endif
@@ -1113,6 +1113,10 @@ template<typename _Tp, int m, int n> _OutputArray::_OutputArray(Matx<_Tp, m, n>&
     
 //////////////////////////////////// Matrix Expressions /////////////////////////////////////////
 
+// the compiled form of a fused element-wise expression; defined in matop.cpp
+class CV_EXPORTS MatExprProgram;
+template<> CV_EXPORTS void Ptr<MatExprProgram>::delete_obj();
+
 class CV_EXPORTS MatOp
 {    
 public:
@@ -1194,12 +1198,17 @@ public:
     Size size() const;
     int type() const;
     
+    //! returns a human-readable description of how the expression will be evaluated
+    string explain() const;
+    
     const MatOp* op;
     int flags;
     
     Mat a, b, c;
     double alpha, beta;
     Scalar s;
+    //! the instruction list of a fused element-wise expression, null for the other kinds
+    Ptr<MatExprProgram> prog;
 };
     
 
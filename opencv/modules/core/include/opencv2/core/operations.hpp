@@ -3427,6 +3427,98 @@ template<typename _Tp> inline bool operator != (const SeqIterator<_Tp>& a,
 }
 
 
+template<typename _Tp> inline SeqArena<_Tp>::SeqArena() {}
+template<typename _Tp> inline SeqArena<_Tp>::SeqArena(size_t elemCapacity, size_t seqCapacity)
+{ reserve(elemCapacity, seqCapacity); }
+
+template<typename _Tp> inline void SeqArena<_Tp>::reserve(size_t elemCapacity, size_t seqCapacity)
+{
+    elems.reserve(elemCapacity);
+    ofs.reserve(seqCapacity);
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::reset()
+{
+    // vector::clear() keeps the capacity, so the next round does not allocate
+    elems.clear();
+    ofs.clear();
+}
+
+template<typename _Tp> inline int SeqArena<_Tp>::openSeq()
+{
+    ofs.push_back(elems.size());
+    return (int)ofs.size() - 1;
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::push_back(const _Tp& elem)
+{
+    CV_DbgAssert(!ofs.empty());
+    elems.push_back(elem);
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::push_back(const _Tp* _elems, size_t count)
+{
+    CV_DbgAssert(!ofs.empty());
+    elems.insert(elems.end(), _elems, _elems + count);
+}
+
+template<typename _Tp> inline _Tp* SeqArena<_Tp>::grow(size_t count)
+{
+    CV_DbgAssert(!ofs.empty());
+    size_t len = elems.size();
+    elems.resize(len + count);
+    return elems.empty() ? 0 : &elems[0] + len;
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::resizeLast(size_t len)
+{
+    CV_Assert(!ofs.empty());
+    elems.resize(ofs.back() + len);
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::popSeq()
+{
+    CV_Assert(!ofs.empty());
+    elems.resize(ofs.back());
+    ofs.pop_back();
+}
+
+template<typename _Tp> inline size_t SeqArena<_Tp>::size() const { return ofs.size(); }
+template<typename _Tp> inline bool SeqArena<_Tp>::empty() const { return ofs.empty(); }
+template<typename _Tp> inline size_t SeqArena<_Tp>::total() const { return elems.size(); }
+
+template<typename _Tp> inline size_t SeqArena<_Tp>::seqSize(int i) const
+{
+    CV_DbgAssert((size_t)i < ofs.size());
+    return ((size_t)i + 1 < ofs.size() ? ofs[i+1] : elems.size()) - ofs[i];
+}
+
+template<typename _Tp> inline _Tp* SeqArena<_Tp>::ptr(int i)
+{
+    CV_DbgAssert((size_t)i < ofs.size());
+    return elems.empty() ? 0 : &elems[0] + ofs[i];
+}
+
+template<typename _Tp> inline const _Tp* SeqArena<_Tp>::ptr(int i) const
+{
+    CV_DbgAssert((size_t)i < ofs.size());
+    return elems.empty() ? 0 : &elems[0] + ofs[i];
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::copyTo(int i, vector<_Tp>& vec) const
+{
+    const _Tp* p = ptr(i);
+    vec.assign(p, p + seqSize(i));
+}
+
+template<typename _Tp> inline void SeqArena<_Tp>::copyTo(vector<vector<_Tp> >& vecs) const
+{
+    vecs.resize(ofs.size());
+    for( size_t i = 0; i < ofs.size(); i++ )
+        copyTo((int)i, vecs[i]);
+}
+
+
 template<typename _ClsName> struct CV_EXPORTS RTTIImpl
 {
 public:
@@ -1728,6 +1728,14 @@ typedef struct CvFileStorage CvFileStorage;
 #define CV_STORAGE_WRITE_BINARY  CV_STORAGE_WRITE
 #define CV_STORAGE_APPEND        2
 
+/* Storage format (by default it is chosen by the file extension when writing
+   and by the file signature when reading): */
+#define CV_STORAGE_FORMAT_MASK   (7<<3)
+#define CV_STORAGE_FORMAT_AUTO   0
+#define CV_STORAGE_FORMAT_XML    8
+#define CV_STORAGE_FORMAT_YAML   16
+#define CV_STORAGE_FORMAT_BINARY 24
+
 /* List of attributes: */
 typedef struct CvAttrList
 {
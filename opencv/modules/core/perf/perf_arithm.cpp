@@ -0,0 +1,57 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+#define ARITHM_SIZES testing::Values(szVGA, sz720p, sz1080p)
+#define ARITHM_TYPES testing::Values(CV_8UC1, CV_8UC3, CV_16SC1, CV_32FC1)
+
+PERF_TEST_P(Size_MatType, add, testing::Combine(ARITHM_SIZES, ARITHM_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(sz, type), b(sz, type), c(sz, type);
+    randu(a, 0, 100);
+    randu(b, 0, 100);
+    declareBytes(a, b, c);
+
+    TEST_CYCLE() add(a, b, c);
+}
+
+PERF_TEST_P(Size_MatType, absdiff, testing::Combine(ARITHM_SIZES, ARITHM_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(sz, type), b(sz, type), c(sz, type);
+    randu(a, 0, 100);
+    randu(b, 0, 100);
+    declareBytes(a, b, c);
+
+    TEST_CYCLE() absdiff(a, b, c);
+}
+
+PERF_TEST_P(Size_MatType, multiply, testing::Combine(ARITHM_SIZES, ARITHM_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(sz, type), b(sz, type), c(sz, type);
+    randu(a, 0, 10);
+    randu(b, 0, 10);
+    declareBytes(a, b, c);
+
+    TEST_CYCLE() multiply(a, b, c, 0.5);
+}
+
+PERF_TEST_P(Size_MatType, addWeighted, testing::Combine(ARITHM_SIZES, ARITHM_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(sz, type), b(sz, type), c(sz, type);
+    randu(a, 0, 100);
+    randu(b, 0, 100);
+    declareBytes(a, b, c);
+
+    TEST_CYCLE() addWeighted(a, 0.3, b, 0.7, 1, c);
+}
@@ -0,0 +1,70 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+#define CONVERT_SIZES testing::Values(szVGA, sz1080p)
+
+PERF_TEST_P(Size_MatType, convertTo_32F, testing::Combine(CONVERT_SIZES, testing::Values(CV_8UC1, CV_8UC3, CV_16UC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, CV_MAKETYPE(CV_32F, CV_MAT_CN(type)));
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() src.convertTo(dst, CV_32F, 1./255, 0.5);
+}
+
+PERF_TEST_P(Size_MatType, convertTo_8U, testing::Combine(CONVERT_SIZES, testing::Values(CV_16SC1, CV_32FC1, CV_32FC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, CV_MAKETYPE(CV_8U, CV_MAT_CN(type)));
+    randu(src, -100, 400);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() src.convertTo(dst, CV_8U);
+}
+
+PERF_TEST_P(Size_MatType, split, testing::Combine(CONVERT_SIZES, testing::Values(CV_8UC3, CV_8UC4, CV_32FC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type);
+    vector<Mat> planes;
+    randu(src, 0, 256);
+    declareBytes(src, src);
+
+    TEST_CYCLE() split(src, planes);
+}
+
+PERF_TEST_P(Size_MatType, merge, testing::Combine(CONVERT_SIZES, testing::Values(CV_8UC3, CV_8UC4, CV_32FC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    vector<Mat> planes(CV_MAT_CN(type));
+    for( size_t i = 0; i < planes.size(); i++ )
+    {
+        planes[i].create(sz, CV_MAT_DEPTH(type));
+        randu(planes[i], 0, 256);
+    }
+    Mat dst(sz, type);
+    declareBytes(dst, dst);
+
+    TEST_CYCLE() merge(planes, dst);
+}
+
+PERF_TEST_P(Size_MatType, LUT, testing::Combine(CONVERT_SIZES, testing::Values(CV_8UC1, CV_8UC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), lut(1, 256, CV_8U), dst(sz, type);
+    randu(src, 0, 256);
+    randu(lut, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() LUT(src, lut, dst);
+}
@@ -0,0 +1,48 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+PERF_TEST_P(Size_MatType, dft, testing::Combine(testing::Values(Size(256, 256), Size(512, 512), Size(640, 480), Size(1024, 1024)),
+                                               testing::Values(CV_32FC1, CV_32FC2, CV_64FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 100);
+
+    TEST_CYCLE() dft(src, dst);
+}
+
+PERF_TEST_P(Size_MatType, dft_rows, testing::Combine(testing::Values(Size(512, 512), Size(1024, 256)),
+                                                    testing::Values(CV_32FC1, CV_32FC2)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 100);
+
+    TEST_CYCLE() dft(src, dst, DFT_ROWS);
+}
+
+typedef std::tr1::tuple<Size, int> Size_BatchSize_t;
+typedef PerfTestWithParam<Size_BatchSize_t> Size_BatchSize;
+
+// many small same-sized transforms, e.g. the image patches
+PERF_TEST_P(Size_BatchSize, dft_batch, testing::Combine(testing::Values(Size(32, 32), Size(64, 64)),
+                                                       testing::Values(64, 256)))
+{
+    Size sz = get<0>(GetParam());
+    int n = get<1>(GetParam());
+    vector<Mat> src(n), dst;
+    for( int i = 0; i < n; i++ )
+    {
+        src[i].create(sz, CV_32F);
+        randu(src[i], 0, 100);
+    }
+    DFTPlan plan(sz, CV_32F);
+
+    TEST_CYCLE() plan(src, dst);
+}
@@ -0,0 +1,43 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef std::tr1::tuple<int, int> Size_Type_t;
+typedef PerfTestWithParam<Size_Type_t> Gemm;
+
+PERF_TEST_P(Gemm, gemm, testing::Combine(testing::Values(64, 256, 512, 1024), testing::Values(CV_32F, CV_64F)))
+{
+    int n = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(n, n, type), b(n, n, type), c(n, n, type), d(n, n, type);
+    randu(a, -1, 1);
+    randu(b, -1, 1);
+    randu(c, -1, 1);
+
+    TEST_CYCLE() gemm(a, b, 1, c, 0.5, d);
+}
+
+PERF_TEST_P(Gemm, gemm_transposed, testing::Combine(testing::Values(256, 512), testing::Values(CV_32F, CV_64F)))
+{
+    int n = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(n, n, type), b(n, n, type), d(n, n, type);
+    randu(a, -1, 1);
+    randu(b, -1, 1);
+
+    TEST_CYCLE() gemm(a, b, 1, noArray(), 0, d, GEMM_2_T);
+}
+
+PERF_TEST_P(Gemm, gemm_1_T, testing::Combine(testing::Values(512, 1024), testing::Values(CV_32F, CV_64F)))
+{
+    int n = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(n, n, type), b(n, n, type), d(n, n, type);
+    randu(a, -1, 1);
+    randu(b, -1, 1);
+
+    TEST_CYCLE() gemm(a, b, 1, noArray(), 0, d, GEMM_1_T);
+}
@@ -0,0 +1,58 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+#define STAT_SIZES testing::Values(szVGA, sz1080p)
+#define STAT_TYPES testing::Values(CV_8UC1, CV_8UC3, CV_32FC1)
+
+PERF_TEST_P(Size_MatType, sum, testing::Combine(STAT_SIZES, STAT_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type);
+    Scalar s;
+    randu(src, 0, 256);
+    declareBytes(src);
+
+    TEST_CYCLE() s = sum(src);
+}
+
+PERF_TEST_P(Size_MatType, norm_L2, testing::Combine(STAT_SIZES, STAT_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type);
+    double n = 0;
+    randu(src, 0, 256);
+    declareBytes(src);
+
+    TEST_CYCLE() n = norm(src, NORM_L2);
+}
+
+PERF_TEST_P(Size_MatType, meanStdDev, testing::Combine(STAT_SIZES, STAT_TYPES))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type);
+    Scalar mean, stddev;
+    randu(src, 0, 256);
+    declareBytes(src);
+
+    TEST_CYCLE() meanStdDev(src, mean, stddev);
+}
+
+PERF_TEST_P(Size_MatType, minMaxLoc, testing::Combine(STAT_SIZES, testing::Values(CV_8UC1, CV_32FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type);
+    double minVal, maxVal;
+    Point minLoc, maxLoc;
+    randu(src, 0, 256);
+    declareBytes(src);
+
+    TEST_CYCLE() minMaxLoc(src, &minVal, &maxVal, &minLoc, &maxLoc);
+}
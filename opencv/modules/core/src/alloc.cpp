@@ -42,7 +42,13 @@
 
 #include "precomp.hpp"
 
+#ifndef CV_USE_SYSTEM_MALLOC
+#ifdef HAVE_FAST_MALLOC_POOL
+#define CV_USE_SYSTEM_MALLOC 0
+#else
 #define CV_USE_SYSTEM_MALLOC 1
+#endif
+#endif
 
 namespace cv
 {
@@ -53,6 +59,11 @@ static void* OutOfMemoryError(size_t size)
     return 0;
 }
 
+MallocBinStats::MallocBinStats()
+    : objSize(0), mallocCalls(0), freeCalls(0), cacheHits(0), remoteFrees(0), blocks(0)
+{
+}
+
 #if CV_USE_SYSTEM_MALLOC
 
 void deleteThreadAllocData() {}
@@ -78,8 +89,30 @@ void fastFree(void* ptr)
     }
 }
 
+bool getMallocStats(vector<MallocBinStats>& stats)
+{
+    stats.clear();
+    return false;
+}
+
 #else
 
+/*
+   The small-block pool.
+
+   Objects of up to MAX_BLOCK_SIZE bytes are carved out of 16K blocks, every block holds
+   objects of a single size class (bin) and is owned by a single thread. Each thread keeps
+   a small per-bin cache (magazine) of the recently freed objects, so most of fastMalloc/fastFree
+   calls are served without touching the blocks at all. When the cache overflows, the oldest
+   half of it is returned to the blocks: the objects of the blocks owned by the current thread
+   go to the private free list, the others are pushed to the owner's lock-free public list,
+   which the owner collects with a single atomic exchange. The only lock left is taken when
+   a thread needs a new block or returns an empty block to the pool.
+
+   When a thread exits, its blocks that still contain live objects are put into the per-bin
+   orphan lists, from which they are adopted by the other threads.
+*/
+
 #if 0
 #define SANITY_CHECK(block) \
     CV_Assert(((size_t)(block) & (MEM_BLOCK_SIZE-1)) == 0 && \
@@ -89,43 +122,24 @@ void fastFree(void* ptr)
 #define SANITY_CHECK(block)
 #endif
 
-#define STAT(stmt)
-
 #ifdef WIN32
-struct CriticalSection
-{
-    CriticalSection() { InitializeCriticalSection(&cs); }
-    ~CriticalSection() { DeleteCriticalSection(&cs); }
-    void lock() { EnterCriticalSection(&cs); }
-    void unlock() { LeaveCriticalSection(&cs); }
-    bool trylock() { return TryEnterCriticalSection(&cs) != 0; }
-
-    CRITICAL_SECTION cs;
-};
-
-void* SystemAlloc(size_t size)
+static void* SystemAlloc(size_t size)
 {
     void* ptr = malloc(size);
     return ptr ? ptr : OutOfMemoryError(size);
 }
 
-void SystemFree(void* ptr, size_t)
+static void SystemFree(void* ptr, size_t)
 {
     free(ptr);
 }
-#else
-struct CriticalSection
-{
-    CriticalSection() { pthread_mutex_init(&mutex, 0); }
-    ~CriticalSection() { pthread_mutex_destroy(&mutex); }
-    void lock() { pthread_mutex_lock(&mutex); }
-    void unlock() { pthread_mutex_unlock(&mutex); }
-    bool trylock() { return pthread_mutex_trylock(&mutex) == 0; }
-
-    pthread_mutex_t mutex;
-};
 
-void* SystemAlloc(size_t size)
+static inline void* atomicCompareExchange(void* volatile* ptr, void* newval, void* oldval)
+{
+    return InterlockedCompareExchangePointer((PVOID volatile*)ptr, newval, oldval);
+}
+#else
+static void* SystemAlloc(size_t size)
 {
     #ifndef MAP_ANONYMOUS
     #define MAP_ANONYMOUS MAP_ANON
@@ -135,28 +149,30 @@ void* SystemAlloc(size_t size)
     return ptr != MAP_FAILED ? ptr : OutOfMemoryError(size);
 }
 
-void SystemFree(void* ptr, size_t size)
+static void SystemFree(void* ptr, size_t size)
 {
     munmap(ptr, size);
 }
-#endif
 
-struct AutoLock
+static inline void* atomicCompareExchange(void* volatile* ptr, void* newval, void* oldval)
 {
-    AutoLock(CriticalSection& _cs) : cs(&_cs) { cs->lock(); }
-    ~AutoLock() { cs->unlock(); }
-    CriticalSection* cs;
-};
+    return __sync_val_compare_and_swap(ptr, oldval, newval);
+}
+#endif
 
 const size_t MEM_BLOCK_SIGNATURE = 0x01234567;
 const int MEM_BLOCK_SHIFT = 14;
 const size_t MEM_BLOCK_SIZE = 1 << MEM_BLOCK_SHIFT;
 const size_t HDR_SIZE = 128;
 const size_t MAX_BLOCK_SIZE = MEM_BLOCK_SIZE - HDR_SIZE;
-const int MAX_BIN = 28;
+const int MAX_BIN = 24;
+
+// the thread cache of each bin holds up to MEM_BLOCK_SIZE bytes, but at least MIN_CACHED objects
+const int MIN_CACHED = 2;
 
+// all the sizes are multiples of CV_MALLOC_ALIGN, so are the object addresses
 static const int binSizeTab[MAX_BIN+1] =
-{ 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 128, 160, 192, 256, 320, 384, 480, 544, 672, 768,
+{ 16, 32, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 480, 544, 672, 768,
 896, 1056, 1328, 1600, 2688, 4048, 5408, 8128, 16256 };
 
 struct MallocTables
@@ -169,9 +185,10 @@ struct MallocTables
             n = binSizeTab[i]>>3;
             for( ; j <= n; j++ )
                 binIdx[j] = (uchar)i;
+            maxCached[i] = std::max((int)(MEM_BLOCK_SIZE/binSizeTab[i]), MIN_CACHED);
         }
     }
-    int bin(size_t size)
+    int bin(size_t size) const
     {
         assert( size <= MAX_BLOCK_SIZE );
         return binIdx[(size + 7)>>3];
@@ -183,9 +200,15 @@ struct MallocTables
     }
 
     uchar binIdx[MAX_BLOCK_SIZE/8+1];
+    int maxCached[MAX_BIN+1];
 };
 
-MallocTables mallocTables;
+// constructed on the first use, since fastMalloc may be called from the static initializers
+static const MallocTables& getMallocTables()
+{
+    static MallocTables tables;
+    return tables;
+}
 
 struct Node
 {
@@ -210,20 +233,15 @@ struct Block
 
     ~Block() {}
 
-    void init(Block* _prev, Block* _next, int _objSize, ThreadData* _threadData)
+    void init(int _binIdx, ThreadData* _threadData)
     {
-        prev = _prev;
-        if(prev)
-            prev->next = this;
-        next = _next;
-        if(next)
-            next->prev = this;
-        objSize = _objSize;
-        binIdx = mallocTables.bin(objSize);
+        prev = next = 0;
+        objSize = binSizeTab[_binIdx];
+        binIdx = _binIdx;
         threadData = _threadData;
         privateFreeList = publicFreeList = 0;
         bumpPtr = data;
-        int nobjects = MAX_BLOCK_SIZE/objSize;
+        int nobjects = (int)(MAX_BLOCK_SIZE/objSize);
         endPtr = bumpPtr + nobjects*objSize;
         almostEmptyThreshold = (nobjects + 1)/2;
         allocated = 0;
@@ -231,20 +249,56 @@ struct Block
 
     bool isFilled() const { return allocated > almostEmptyThreshold; }
 
+    // called by the threads that do not own the block
+    void pushPublic(Node* node)
+    {
+        for(;;)
+        {
+            Node* head = publicFreeList;
+            node->next = head;
+            if( atomicCompareExchange((void* volatile*)&publicFreeList, node, head) == head )
+                break;
+        }
+    }
+
+    // called by the owner only. The whole list is taken at once, so the ABA problem can not occur
+    Node* takePublic()
+    {
+        for(;;)
+        {
+            Node* head = publicFreeList;
+            if( !head || atomicCompareExchange((void* volatile*)&publicFreeList, 0, head) == head )
+                return head;
+        }
+    }
+
+    // moves the objects freed by the other threads to the private free list
+    void collectPublic()
+    {
+        Node* node = takePublic();
+        if( !node )
+            return;
+        Node* last = node;
+        --allocated;
+        for( ; last->next != 0; last = last->next )
+            --allocated;
+        last->next = privateFreeList;
+        privateFreeList = node;
+    }
+
     size_t signature;
     Block* prev;
     Block* next;
     Node* privateFreeList;
-    Node* publicFreeList;
+    Node* volatile publicFreeList;
     uchar* bumpPtr;
     uchar* endPtr;
     uchar* data;
-    ThreadData* threadData;
+    ThreadData* volatile threadData;
     int objSize;
     int binIdx;
     int allocated;
     int almostEmptyThreshold;
-    CriticalSection cs;
 };
 
 struct BigBlock
@@ -270,15 +324,58 @@ struct BigBlock
     int nblocks;
 };
 
+enum { START=0, FREE=1, GC=2 };
+
+struct ThreadData
+{
+    ThreadData();
+    ~ThreadData();
+
+    void* alloc(int idx);
+    void release(Node* node);
+    void flushCache(int idx, int count);
+    void linkBlock(Block* block);
+    void moveBlockToFreeList(Block* block);
+
+    static ThreadData* get();
+
+    Block* bins[MAX_BIN+1][3];
+    Node* cache[MAX_BIN+1];
+    int cacheSize[MAX_BIN+1];
+
+    int64 mallocCalls[MAX_BIN+1];
+    int64 freeCalls[MAX_BIN+1];
+    int64 cacheHits[MAX_BIN+1];
+    int64 remoteFrees[MAX_BIN+1];
+
+    // the list of all the live ThreadData's, used to collect the statistics
+    ThreadData* prevData;
+    ThreadData* nextData;
+
+#ifdef WIN32
+    static DWORD tlsKey;
+#else
+    static pthread_key_t tlsKey;
+    static pthread_once_t tlsKeyOnce;
+    static void createKey();
+    static void deleteData(void* data);
+#endif
+};
+
 struct BlockPool
 {
-    BlockPool(int _bigBlockSize=1<<20) : pool(0), bigBlockSize(_bigBlockSize)
+    BlockPool(int _bigBlockSize=1<<20) : freeBlocks(0), pool(0), bigBlockSize(_bigBlockSize), threads(0)
     {
+        for( int i = 0; i <= MAX_BIN; i++ )
+        {
+            orphans[i] = 0;
+            stats[i].objSize = binSizeTab[i];
+        }
     }
 
     ~BlockPool()
     {
-        AutoLock lock(cs);
+        AutoLock lock(mutex);
         while( pool )
         {
             BigBlock* nextBlock = pool->next;
@@ -288,10 +385,19 @@ struct BlockPool
         }
     }
 
-    Block* alloc()
+    // returns a block abandoned by an exited thread (with adopted=true) or a fresh block
+    Block* alloc(int idx, bool& adopted)
     {
-        AutoLock lock(cs);
-        Block* block;
+        AutoLock lock(mutex);
+        Block* block = orphans[idx];
+        if( block )
+        {
+            orphans[idx] = block->next;
+            adopted = true;
+            return block;
+        }
+
+        adopted = false;
         if( !freeBlocks )
         {
             BigBlock* bblock = ::new(SystemAlloc(bigBlockSize)) BigBlock(bigBlockSize, pool);
@@ -303,139 +409,226 @@ struct BlockPool
         freeBlocks = freeBlocks->next;
         if( freeBlocks )
             freeBlocks->prev = 0;
-        STAT(stat.bruttoBytes += MEM_BLOCK_SIZE);
+        stats[idx].blocks++;
         return block;
     }
 
     void free(Block* block)
     {
-        AutoLock lock(cs);
+        AutoLock lock(mutex);
+        stats[block->binIdx].blocks--;
         block->prev = 0;
         block->next = freeBlocks;
         freeBlocks = block;
-        STAT(stat.bruttoBytes -= MEM_BLOCK_SIZE);
     }
 
-    CriticalSection cs;
-    Block* freeBlocks;
-    BigBlock* pool;
-    int bigBlockSize;
-    int blocksPerBigBlock;
-};
+    void addOrphan(Block* block)
+    {
+        AutoLock lock(mutex);
+        block->prev = 0;
+        block->next = orphans[block->binIdx];
+        orphans[block->binIdx] = block;
+    }
 
-BlockPool mallocPool;
+    void addThread(ThreadData* data)
+    {
+        AutoLock lock(mutex);
+        data->prevData = 0;
+        data->nextData = threads;
+        if( threads )
+            threads->prevData = data;
+        threads = data;
+    }
 
-enum { START=0, FREE=1, GC=2 };
+    // removes the thread from the list and keeps its counters
+    void removeThread(ThreadData* data)
+    {
+        AutoLock lock(mutex);
+        if( data->prevData )
+            data->prevData->nextData = data->nextData;
+        else
+            threads = data->nextData;
+        if( data->nextData )
+            data->nextData->prevData = data->prevData;
+        data->prevData = data->nextData = 0;
+        addCounters(stats, data);
+    }
 
-struct ThreadData
-{
-    ThreadData() { for(int i = 0; i <= MAX_BIN; i++) bins[i][START] = bins[i][FREE] = bins[i][GC] = 0; }
-    ~ThreadData()
+    void getStats(vector<MallocBinStats>& _stats)
     {
-        // mark all the thread blocks as abandoned or even release them
-        for( int i = 0; i <= MAX_BIN; i++ )
-        {
-            Block *bin = bins[i][START], *block = bin;
-            bins[i][START] = bins[i][FREE] = bins[i][GC] = 0;
-            if( block )
-            {
-                do
-                {
-                    Block* next = block->next;
-                    int allocated = block->allocated;
-                    {
-                    AutoLock lock(block->cs);
-                    block->next = block->prev = 0;
-                    block->threadData = 0;
-                    Node *node = block->publicFreeList;
-                    for( ; node != 0; node = node->next )
-                        allocated--;
-                    }
-                    if( allocated == 0 )
-                        mallocPool.free(block);
-                    block = next;
-                }
-                while( block != bin );
-            }
-        }
+        AutoLock lock(mutex);
+        _stats.assign(stats, stats + MAX_BIN + 1);
+        for( ThreadData* data = threads; data != 0; data = data->nextData )
+            addCounters(&_stats[0], data);
     }
 
-    void moveBlockToFreeList( Block* block )
+    static void addCounters(MallocBinStats* dst, const ThreadData* data)
     {
-        int i = block->binIdx;
-        Block*& freePtr = bins[i][FREE];
-        CV_DbgAssert( block->next->prev == block && block->prev->next == block );
-        if( block != freePtr )
+        for( int i = 0; i <= MAX_BIN; i++ )
         {
-            Block*& gcPtr = bins[i][GC];
-            if( gcPtr == block )
-                gcPtr = block->next;
-            if( block->next != block )
-            {
-                block->prev->next = block->next;
-                block->next->prev = block->prev;
-            }
-            block->next = freePtr->next;
-            block->prev = freePtr;
-            freePtr = block->next->prev = block->prev->next = block;
+            dst[i].mallocCalls += data->mallocCalls[i];
+            dst[i].freeCalls += data->freeCalls[i];
+            dst[i].cacheHits += data->cacheHits[i];
+            dst[i].remoteFrees += data->remoteFrees[i];
         }
     }
 
-    Block* bins[MAX_BIN+1][3];
+    Mutex mutex;
+    Block* freeBlocks;
+    BigBlock* pool;
+    int bigBlockSize;
+    Block* orphans[MAX_BIN+1];
+    ThreadData* threads;
+    // the block counters and the counters of the exited threads
+    MallocBinStats stats[MAX_BIN+1];
+};
 
-#ifdef WIN32
-#ifdef WINCE
-#	define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
-#endif
+// the pool is never destroyed, because fastFree may still be called from the static destructors
+static BlockPool& getBlockPool()
+{
+    static BlockPool* pool = new BlockPool;
+    return *pool;
+}
 
-    static DWORD tlsKey;
-    static ThreadData* get()
+ThreadData::ThreadData()
+{
+    for( int i = 0; i <= MAX_BIN; i++ )
+    {
+        bins[i][START] = bins[i][FREE] = bins[i][GC] = 0;
+        cache[i] = 0;
+        cacheSize[i] = 0;
+        mallocCalls[i] = freeCalls[i] = cacheHits[i] = remoteFrees[i] = 0;
+    }
+    getBlockPool().addThread(this);
+}
+
+ThreadData::~ThreadData()
+{
+    BlockPool& pool = getBlockPool();
+    for( int i = 0; i <= MAX_BIN; i++ )
+        flushCache(i, cacheSize[i]);
+
+    // release the empty blocks and leave the others to be adopted by the other threads
+    for( int i = 0; i <= MAX_BIN; i++ )
     {
-        ThreadData* data;
-        if( tlsKey == TLS_OUT_OF_INDEXES )
-            tlsKey = TlsAlloc();
-        data = (ThreadData*)TlsGetValue(tlsKey);
-        if( !data )
+        Block *bin = bins[i][START], *block = bin;
+        bins[i][START] = bins[i][FREE] = bins[i][GC] = 0;
+        if( !block )
+            continue;
+        do
         {
-            data = new ThreadData;
-            TlsSetValue(tlsKey, data);
+            Block* next = block->next;
+            block->threadData = 0;
+            block->collectPublic();
+            if( block->allocated == 0 )
+                pool.free(block);
+            else
+                pool.addOrphan(block);
+            block = next;
         }
-        return data;
+        while( block != bin );
     }
-#else
-    static void deleteData(void* data)
+    pool.removeThread(this);
+}
+
+void ThreadData::linkBlock( Block* block )
+{
+    Block*& startPtr = bins[block->binIdx][START];
+    if( startPtr )
+    {
+        block->next = startPtr;
+        block->prev = startPtr->prev;
+        block->next->prev = block->prev->next = block;
+    }
+    else
     {
-        delete (ThreadData*)data;
+        block->prev = block->next = block;
+        startPtr = bins[block->binIdx][FREE] = bins[block->binIdx][GC] = block;
     }
+}
 
-    static pthread_key_t tlsKey;
-    static ThreadData* get()
+void ThreadData::moveBlockToFreeList( Block* block )
+{
+    int i = block->binIdx;
+    Block*& freePtr = bins[i][FREE];
+    CV_DbgAssert( block->next->prev == block && block->prev->next == block );
+    if( block != freePtr )
     {
-        ThreadData* data;
-        if( !tlsKey )
-            pthread_key_create(&tlsKey, deleteData);
-        data = (ThreadData*)pthread_getspecific(tlsKey);
-        if( !data )
+        Block*& gcPtr = bins[i][GC];
+        if( gcPtr == block )
+            gcPtr = block->next;
+        if( block->next != block )
         {
-            data = new ThreadData;
-            pthread_setspecific(tlsKey, data);
+            block->prev->next = block->next;
+            block->next->prev = block->prev;
         }
-        return data;
+        block->next = freePtr->next;
+        block->prev = freePtr;
+        freePtr = block->next->prev = block->prev->next = block;
     }
-#endif
-};
+}
 
 #ifdef WIN32
+#ifdef WINCE
+#	define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+
 DWORD ThreadData::tlsKey = TLS_OUT_OF_INDEXES;
 
+ThreadData* ThreadData::get()
+{
+    if( tlsKey == TLS_OUT_OF_INDEXES )
+    {
+        DWORD key = TlsAlloc();
+        if( InterlockedCompareExchange((LONG volatile*)&tlsKey, (LONG)key,
+                                       (LONG)TLS_OUT_OF_INDEXES) != (LONG)TLS_OUT_OF_INDEXES )
+            TlsFree(key);
+    }
+    ThreadData* data = (ThreadData*)TlsGetValue(tlsKey);
+    if( !data )
+    {
+        data = new ThreadData;
+        TlsSetValue(tlsKey, data);
+    }
+    return data;
+}
+
 void deleteThreadAllocData()
 {
     if( ThreadData::tlsKey != TLS_OUT_OF_INDEXES )
+    {
         delete (ThreadData*)TlsGetValue( ThreadData::tlsKey );
+        TlsSetValue( ThreadData::tlsKey, 0 );
+    }
 }
 
 #else
-pthread_key_t ThreadData::tlsKey = 0;
+
+pthread_key_t ThreadData::tlsKey;
+pthread_once_t ThreadData::tlsKeyOnce = PTHREAD_ONCE_INIT;
+
+void ThreadData::createKey()
+{
+    pthread_key_create(&tlsKey, deleteData);
+}
+
+void ThreadData::deleteData(void* data)
+{
+    delete (ThreadData*)data;
+}
+
+ThreadData* ThreadData::get()
+{
+    pthread_once(&tlsKeyOnce, createKey);
+    ThreadData* data = (ThreadData*)pthread_getspecific(tlsKey);
+    if( !data )
+    {
+        data = new ThreadData;
+        pthread_setspecific(tlsKey, data);
+    }
+    return data;
+}
+
 #endif
 
 #if 0
@@ -466,30 +659,14 @@ static void checkList(ThreadData* tls, int idx)
 #define checkList(tls, idx)
 #endif
 
-void* fastMalloc( size_t size )
+// the slow path of fastMalloc: takes the object from the thread blocks
+void* ThreadData::alloc( int idx )
 {
-    if( size > MAX_BLOCK_SIZE )
-    {
-        size_t size1 = size + sizeof(uchar*)*2 + MEM_BLOCK_SIZE;
-        uchar* udata = (uchar*)SystemAlloc(size1);
-        uchar** adata = alignPtr((uchar**)udata + 2, MEM_BLOCK_SIZE);
-        adata[-1] = udata;
-        adata[-2] = (uchar*)size1;
-        return adata;
-    }
-
-    {
-    ThreadData* tls = ThreadData::get();
-    int idx = mallocTables.bin(size);
-    Block*& startPtr = tls->bins[idx][START];
-    Block*& gcPtr = tls->bins[idx][GC];
-    Block*& freePtr = tls->bins[idx][FREE], *block = freePtr;
-    checkList(tls, idx);
-    size = binSizeTab[idx];
-    STAT(
-        stat.nettoBytes += size;
-        stat.mallocCalls++;
-        );
+    Block*& startPtr = bins[idx][START];
+    Block*& gcPtr = bins[idx][GC];
+    Block*& freePtr = bins[idx][FREE], *block = freePtr;
+    checkList(this, idx);
+    int size = binSizeTab[idx];
     uchar* data = 0;
 
     for(;;)
@@ -519,19 +696,11 @@ void* fastMalloc( size_t size )
                     break;
                 block = block->next;
             }
-#if 0
-            avg_k += _k;
-            avg_nk++;
-            if( avg_nk == 1000 )
-            {
-                printf("avg search iters per 1e3 allocs = %g\n", (double)avg_k/avg_nk );
-                avg_k = avg_nk = 0;
-            }
-#endif
 
             freePtr = block;
             if( !data )
             {
+                // collect the objects released by the other threads
                 block = gcPtr; 
                 for( int k = 0; k < 2; k++ )
                 {
@@ -539,19 +708,12 @@ void* fastMalloc( size_t size )
                     CV_DbgAssert( block->next->prev == block && block->prev->next == block );
                     if( block->publicFreeList )
                     {
-                        {
-                        AutoLock lock(block->cs);
-                        block->privateFreeList = block->publicFreeList;
-                        block->publicFreeList = 0;
-                        }
-                        Node* node = block->privateFreeList;
-                        for(;node != 0; node = node->next)
-                            --block->allocated;
+                        block->collectPublic();
                         data = (uchar*)block->privateFreeList;
                         block->privateFreeList = block->privateFreeList->next;
                         gcPtr = block->next;
                         if( block->allocated+1 <= block->almostEmptyThreshold )
-                            tls->moveBlockToFreeList(block);
+                            moveBlockToFreeList(block);
                         break;
                     }
                     block = block->next;
@@ -563,17 +725,122 @@ void* fastMalloc( size_t size )
 
         if( data )
             break;
-        block = mallocPool.alloc();
-        block->init(startPtr ? startPtr->prev : block, startPtr ? startPtr : block, (int)size, tls);
-        if( !startPtr )
-            startPtr = gcPtr = freePtr = block;
-        checkList(tls, block->binIdx);
+
+        bool adopted = false;
+        block = getBlockPool().alloc(idx, adopted);
+        if( adopted )
+        {
+            block->threadData = this;
+            block->collectPublic();
+        }
+        else
+            block->init(idx, this);
+        linkBlock(block);
+        checkList(this, idx);
         SANITY_CHECK(block);
     }
 
     ++block->allocated;
     return data;
+}
+
+// returns the object to its block
+void ThreadData::release( Node* node )
+{
+    Block* block = (Block*)((size_t)node & ~(MEM_BLOCK_SIZE-1));
+    SANITY_CHECK(block);
+
+    if( block->threadData != this )
+    {
+        remoteFrees[block->binIdx]++;
+        block->pushPublic(node);
+        return;
+    }
+
+    bool prevFilled = block->isFilled();
+    --block->allocated;
+    if( !block->isFilled() && (block->allocated == 0 || prevFilled) )
+    {
+        if( block->allocated == 0 )
+        {
+            int idx = block->binIdx;
+            Block*& startPtr = bins[idx][START];
+            Block*& freePtr = bins[idx][FREE];
+            Block*& gcPtr = bins[idx][GC];
+
+            // the objects released by the other threads are still counted
+            // in block->allocated, so nobody else can touch the block now
+            if( block == block->next )
+            {
+                CV_DbgAssert( startPtr == block && freePtr == block && gcPtr == block );
+                startPtr = freePtr = gcPtr = 0;
+            }
+            else
+            {
+                if( freePtr == block )
+                    freePtr = block->next;
+                if( gcPtr == block )
+                    gcPtr = block->next;
+                if( startPtr == block )
+                    startPtr = block->next;
+                block->prev->next = block->next;
+                block->next->prev = block->prev;
+            }
+            getBlockPool().free(block);
+            checkList(this, idx);
+            return;
+        }
+
+        moveBlockToFreeList(block);
+    }
+    node->next = block->privateFreeList;
+    block->privateFreeList = node;
+}
+
+// returns the oldest "count" objects of the bin cache to their blocks
+void ThreadData::flushCache( int idx, int count )
+{
+    int keep = cacheSize[idx] - count;
+    Node** link = &cache[idx];
+    for( int i = 0; i < keep; i++ )
+        link = &(*link)->next;
+    Node* node = *link;
+    *link = 0;
+    cacheSize[idx] = keep;
+
+    while( node )
+    {
+        Node* next = node->next;
+        release(node);
+        node = next;
+    }
+}
+
+void* fastMalloc( size_t size )
+{
+    if( size > MAX_BLOCK_SIZE )
+    {
+        size_t size1 = size + sizeof(uchar*)*2 + MEM_BLOCK_SIZE;
+        uchar* udata = (uchar*)SystemAlloc(size1);
+        uchar** adata = alignPtr((uchar**)udata + 2, MEM_BLOCK_SIZE);
+        adata[-1] = udata;
+        adata[-2] = (uchar*)size1;
+        return adata;
+    }
+
+    ThreadData* tls = ThreadData::get();
+    int idx = getMallocTables().bin(size);
+    tls->mallocCalls[idx]++;
+
+    Node* node = tls->cache[idx];
+    if( node )
+    {
+        tls->cache[idx] = node->next;
+        tls->cacheSize[idx]--;
+        tls->cacheHits[idx]++;
+        return node;
     }
+    return tls->alloc(idx);
 }
 
 void fastFree( void* ptr )
@@ -589,89 +856,24 @@ void fastFree( void* ptr )
         return;
     }
 
-    {
     ThreadData* tls = ThreadData::get();
     Node* node = (Node*)ptr;
-    Block* block = (Block*)((size_t)ptr & -(int)MEM_BLOCK_SIZE);
+    Block* block = (Block*)((size_t)ptr & ~(MEM_BLOCK_SIZE-1));
     assert( block->signature == MEM_BLOCK_SIGNATURE );
+    int idx = block->binIdx;
+    tls->freeCalls[idx]++;
+
+    if( tls->cacheSize[idx] >= getMallocTables().maxCached[idx] )
+        tls->flushCache(idx, (tls->cacheSize[idx] + 1)/2);
+    node->next = tls->cache[idx];
+    tls->cache[idx] = node;
+    tls->cacheSize[idx]++;
+}
 
-    if( block->threadData == tls )
-    {
-        STAT(
-        stat.nettoBytes -= block->objSize;
-        stat.freeCalls++;
-        float ratio = (float)stat.nettoBytes/stat.bruttoBytes;
-        if( stat.minUsageRatio > ratio )
-            stat.minUsageRatio = ratio;
-        );
-
-        SANITY_CHECK(block);
-
-        bool prevFilled = block->isFilled();
-        --block->allocated;
-        if( !block->isFilled() && (block->allocated == 0 || prevFilled) )
-        {
-            if( block->allocated == 0 )
-            {
-                int idx = block->binIdx;
-                Block*& startPtr = tls->bins[idx][START];
-                Block*& freePtr = tls->bins[idx][FREE];
-                Block*& gcPtr = tls->bins[idx][GC];
-                
-                if( block == block->next )
-                {
-                    CV_DbgAssert( startPtr == block && freePtr == block && gcPtr == block );
-                    startPtr = freePtr = gcPtr = 0;
-                }
-                else
-                {
-                    if( freePtr == block )
-                        freePtr = block->next;
-                    if( gcPtr == block )
-                        gcPtr = block->next;
-                    if( startPtr == block )
-                        startPtr = block->next;
-                    block->prev->next = block->next;
-                    block->next->prev = block->prev;
-                }
-                mallocPool.free(block);
-                checkList(tls, idx);
-                return;
-            }
-
-            tls->moveBlockToFreeList(block);
-        }
-        node->next = block->privateFreeList;
-        block->privateFreeList = node;
-    }
-    else
-    {
-        AutoLock lock(block->cs);
-        SANITY_CHECK(block);
-
-        node->next = block->publicFreeList;
-        block->publicFreeList = node;
-        if( block->threadData == 0 )
-        {
-            // take ownership of the abandoned block.
-            // note that it can happen at the same time as
-            // ThreadData::deleteData() marks the blocks as abandoned,
-            // so this part of the algorithm needs to be checked for data races
-            int idx = block->binIdx;
-            block->threadData = tls;
-            Block*& startPtr = tls->bins[idx][START];
-
-            if( startPtr )
-            {
-                block->next = startPtr;
-                block->prev = startPtr->prev;
-                block->next->prev = block->prev->next = block;
-            }
-            else
-                startPtr = tls->bins[idx][FREE] = tls->bins[idx][GC] = block;
-        }
-    }
-    }
+bool getMallocStats(vector<MallocBinStats>& stats)
+{
+    getBlockPool().getStats(stats);
+    return true;
 }
 
 #endif
@@ -0,0 +1,145 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX versions of the element-wise binary operations on floating-point arrays
+   (see the runtime dispatch notes in opencv2/core/internal.hpp). */
+
+#include "precomp.hpp"
+
+#if CV_AVX
+
+namespace cv
+{
+namespace opt_AVX
+{
+
+static inline __m256 vload(const float* p) { return _mm256_loadu_ps(p); }
+static inline __m256d vload(const double* p) { return _mm256_loadu_pd(p); }
+static inline void vstore(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+static inline void vstore(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+
+struct VAdd
+{
+    __m256 operator()(__m256 a, __m256 b) const { return _mm256_add_ps(a, b); }
+    __m256d operator()(__m256d a, __m256d b) const { return _mm256_add_pd(a, b); }
+    float operator()(float a, float b) const { return a + b; }
+    double operator()(double a, double b) const { return a + b; }
+};
+
+struct VSub
+{
+    __m256 operator()(__m256 a, __m256 b) const { return _mm256_sub_ps(a, b); }
+    __m256d operator()(__m256d a, __m256d b) const { return _mm256_sub_pd(a, b); }
+    float operator()(float a, float b) const { return a - b; }
+    double operator()(double a, double b) const { return a - b; }
+};
+
+struct VMin
+{
+    __m256 operator()(__m256 a, __m256 b) const { return _mm256_min_ps(a, b); }
+    __m256d operator()(__m256d a, __m256d b) const { return _mm256_min_pd(a, b); }
+    float operator()(float a, float b) const { return b < a ? b : a; }
+    double operator()(double a, double b) const { return b < a ? b : a; }
+};
+
+struct VMax
+{
+    __m256 operator()(__m256 a, __m256 b) const { return _mm256_max_ps(a, b); }
+    __m256d operator()(__m256d a, __m256d b) const { return _mm256_max_pd(a, b); }
+    float operator()(float a, float b) const { return a < b ? b : a; }
+    double operator()(double a, double b) const { return a < b ? b : a; }
+};
+
+struct VAbsDiff
+{
+    __m256 operator()(__m256 a, __m256 b) const
+    { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), _mm256_sub_ps(a, b)); }
+    __m256d operator()(__m256d a, __m256d b) const
+    { return _mm256_andnot_pd(_mm256_set1_pd(-0.), _mm256_sub_pd(a, b)); }
+    float operator()(float a, float b) const { return (float)fabs(a - b); }
+    double operator()(double a, double b) const { return fabs(a - b); }
+};
+
+template<typename T, class Op> static void
+vBinOp( const T* src1, size_t step1, const T* src2, size_t step2,
+        T* dst, size_t step, int width, int height )
+{
+    const int VSZ = 32/sizeof(T);
+    Op op;
+
+    for( ; height--; src1 += step1/sizeof(src1[0]),
+                     src2 += step2/sizeof(src2[0]),
+                     dst += step/sizeof(dst[0]) )
+    {
+        int x = 0;
+        for( ; x <= width - VSZ*2; x += VSZ*2 )
+        {
+            vstore(dst + x, op(vload(src1 + x), vload(src2 + x)));
+            vstore(dst + x + VSZ, op(vload(src1 + x + VSZ), vload(src2 + x + VSZ)));
+        }
+        for( ; x <= width - VSZ; x += VSZ )
+            vstore(dst + x, op(vload(src1 + x), vload(src2 + x)));
+        for( ; x < width; x++ )
+            dst[x] = op(src1[x], src2[x]);
+    }
+}
+
+#define CV_DEF_AVX_BINOP(name, T, Op) \
+void name( const T* src1, size_t step1, const T* src2, size_t step2, \
+           T* dst, size_t step, int width, int height ) \
+{ vBinOp<T, Op>(src1, step1, src2, step2, dst, step, width, height); }
+
+CV_DEF_AVX_BINOP(add32f, float, VAdd)
+CV_DEF_AVX_BINOP(sub32f, float, VSub)
+CV_DEF_AVX_BINOP(min32f, float, VMin)
+CV_DEF_AVX_BINOP(max32f, float, VMax)
+CV_DEF_AVX_BINOP(absdiff32f, float, VAbsDiff)
+CV_DEF_AVX_BINOP(add64f, double, VAdd)
+CV_DEF_AVX_BINOP(sub64f, double, VSub)
+CV_DEF_AVX_BINOP(min64f, double, VMin)
+CV_DEF_AVX_BINOP(max64f, double, VMax)
+CV_DEF_AVX_BINOP(absdiff64f, double, VAbsDiff)
+
+}
+}
+
+#endif
@@ -452,6 +452,17 @@ struct _VNot8u { __m128i operator()(const __m128i& a, const __m128i&) const { re
 #define IF_SIMD(op) NOP
 #endif
 
+#ifdef HAVE_DISPATCH_AVX
+#define CALL_AVX_BINOP(func) \
+    if( checkHardwareSupport(CV_CPU_AVX) ) \
+    { \
+        opt_AVX::func(src1, step1, src2, step2, dst, step, sz.width, sz.height); \
+        return; \
+    }
+#else
+#define CALL_AVX_BINOP(func)
+#endif
+
 template<> inline uchar OpAdd<uchar>::operator ()(uchar a, uchar b) const
 { return CV_FAST_CAST_8U(a + b); }
 template<> inline uchar OpSub<uchar>::operator ()(uchar a, uchar b) const
@@ -562,6 +573,7 @@ static void add32f( const float* src1, size_t step1,
                     const float* src2, size_t step2,
                     float* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(add32f);
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAdd_32f_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpAdd<float>, IF_SIMD(_VAdd32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -571,6 +583,7 @@ static void add64f( const double* src1, size_t step1,
                     const double* src2, size_t step2,
                     double* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(add64f);
     vBinOp64f<OpAdd<double>, IF_SIMD(_VAdd64f)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -619,6 +632,7 @@ static void sub32f( const float* src1, size_t step1,
                    const float* src2, size_t step2,
                    float* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(sub32f);
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiSub_32f_C1R(src2, (int)step2, src1, (int)step1, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpSub<float>, IF_SIMD(_VSub32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -628,6 +642,7 @@ static void sub64f( const double* src1, size_t step1,
                     const double* src2, size_t step2,
                     double* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(sub64f);
     vBinOp64f<OpSub<double>, IF_SIMD(_VSub64f)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -713,6 +728,7 @@ static void max32f( const float* src1, size_t step1,
                     const float* src2, size_t step2,
                     float* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(max32f);
 #if (ARITHM_USE_IPP == 1)
   {
     float* s1 = (float*)src1;
@@ -739,6 +755,7 @@ static void max64f( const double* src1, size_t step1,
                     const double* src2, size_t step2,
                     double* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(max64f);
     vBinOp64f<OpMax<double>, IF_SIMD(_VMax64f)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -821,6 +838,7 @@ static void min32f( const float* src1, size_t step1,
                     const float* src2, size_t step2,
                     float* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(min32f);
 #if (ARITHM_USE_IPP == 1)
   {
     float* s1 = (float*)src1;
@@ -847,6 +865,7 @@ static void min64f( const double* src1, size_t step1,
                     const double* src2, size_t step2,
                     double* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(min64f);
     vBinOp64f<OpMin<double>, IF_SIMD(_VMin64f)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -893,6 +912,7 @@ static void absdiff32f( const float* src1, size_t step1,
                         const float* src2, size_t step2,
                         float* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(absdiff32f);
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAbsDiff_32f_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpAbsDiff<float>, IF_SIMD(_VAbsDiff32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -902,6 +922,7 @@ static void absdiff64f( const double* src1, size_t step1,
                         const double* src2, size_t step2,
                         double* dst, size_t step, Size sz, void* )
 {
+    CALL_AVX_BINOP(absdiff64f);
     vBinOp64f<OpAbsDiff<double>, IF_SIMD(_VAbsDiff64f)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -1943,6 +1964,23 @@ void cv::addWeighted( InputArray src1, double alpha, InputArray src2,
     arithm_op(src1, src2, dst, noArray(), dtype, addWeightedTab, true, scalars);
 }
 
+namespace cv
+{
+
+BinaryFunc getArithmFunc(int op, int depth)
+{
+    static BinaryFunc* tabs[] =
+    {
+        addTab, subTab, mulTab, divTab, recipTab,
+        absdiffTab, minTab, maxTab, addWeightedTab
+    };
+    CV_Assert( 0 <= op && op < (int)(sizeof(tabs)/sizeof(tabs[0])) &&
+               0 <= depth && depth <= CV_64F );
+    return tabs[op][depth];
+}
+
+}
+
 
 /****************************************************************************************\
 *                                          compare                                       *
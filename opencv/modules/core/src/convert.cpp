@@ -45,6 +45,124 @@
 namespace cv
 {
 
+/****************************************************************************************\
+*                              parallel element-wise processing                          *
+\****************************************************************************************/
+
+/*
+ The element-wise operations below (split, merge, mixChannels, LUT, convertTo ...) process the planes
+ of NAryMatIterator in stripes of about PARALLEL_STRIPE_SIZE elements, which are distributed among
+ the threads. Op::operator()(uchar** ptrs, int len) const processes len consecutive elements
+ starting from ptrs[k] in every array; it may modify the pointers.
+*/
+enum { PARALLEL_STRIPE_SIZE = 1 << 16 };
+
+template<class Op> class StripeInvoker
+{
+public:
+    StripeInvoker(const Op& _op, uchar** _planes, const size_t* _esz, int _narrays,
+                  size_t _nplanes, size_t _planeSize, int _stripesPerPlane, int _planesPerStripe)
+        : op(&_op), planes(_planes), esz(_esz), narrays(_narrays), nplanes(_nplanes),
+          planeSize(_planeSize), stripesPerPlane(_stripesPerPlane), planesPerStripe(_planesPerStripe) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        AutoBuffer<uchar*, 16> ptrs(narrays);
+        for( int s = range.begin(); s < range.end(); s++ )
+        {
+            size_t p0, p1, ofs = 0, len = planeSize;
+            if( stripesPerPlane > 1 )
+            {
+                p0 = s/stripesPerPlane;
+                p1 = p0 + 1;
+                ofs = (size_t)(s % stripesPerPlane)*PARALLEL_STRIPE_SIZE;
+                len = std::min(planeSize - ofs, (size_t)PARALLEL_STRIPE_SIZE);
+            }
+            else
+            {
+                p0 = (size_t)s*planesPerStripe;
+                p1 = std::min(p0 + planesPerStripe, nplanes);
+            }
+
+            for( size_t p = p0; p < p1; p++ )
+            {
+                for( int k = 0; k < narrays; k++ )
+                {
+                    uchar* ptr = planes[p*narrays + k];
+                    ptrs[k] = ptr ? ptr + ofs*esz[k] : 0;
+                }
+                (*op)(ptrs, (int)len);
+            }
+        }
+    }
+
+protected:
+    const Op* op;
+    uchar** planes;
+    const size_t* esz;
+    int narrays;
+    size_t nplanes, planeSize;
+    int stripesPerPlane, planesPerStripe;
+};
+
+template<class Op> static void
+parallelApply( const Mat** arrays, int narrays, const Op& op )
+{
+    AutoBuffer<uchar*, 16> ptrs(narrays);
+    AutoBuffer<const Mat*, 16> _rowptrs;
+    vector<Mat> rows;
+    int k;
+
+    // a vector<> output may be created transposed relative to the input (N x 1 vs 1 x N);
+    // such arrays are continuous, so they are processed as single rows of the same length
+    for( k = 1; k < narrays; k++ )
+        if( arrays[k]->size != arrays[0]->size )
+            break;
+    if( k < narrays )
+    {
+        rows.resize(narrays);
+        _rowptrs.allocate(narrays);
+        for( k = 0; k < narrays; k++ )
+        {
+            CV_Assert( arrays[k]->isContinuous() && arrays[k]->total() == arrays[0]->total() );
+            rows[k] = arrays[k]->reshape(0, 1);
+            _rowptrs[k] = &rows[k];
+        }
+        arrays = _rowptrs;
+    }
+
+    NAryMatIterator it(arrays, ptrs, narrays);
+    size_t i, nplanes = it.nplanes, planeSize = it.size;
+
+    if( nplanes == 0 || planeSize == 0 )
+        return;
+
+    // the small arrays are processed right away
+    if( nplanes*planeSize < (size_t)PARALLEL_STRIPE_SIZE*2 || getNumThreads() <= 1 )
+    {
+        for( i = 0; i < nplanes; i++, ++it )
+            op(ptrs, (int)planeSize);
+        return;
+    }
+
+    AutoBuffer<size_t, 16> esz(narrays);
+    AutoBuffer<uchar*> planes(nplanes*narrays);
+    for( k = 0; k < narrays; k++ )
+        esz[k] = arrays[k]->elemSize();
+    for( i = 0; i < nplanes; i++, ++it )
+        for( k = 0; k < narrays; k++ )
+            planes[i*narrays + k] = ptrs[k];
+
+    int stripesPerPlane = (int)((planeSize + PARALLEL_STRIPE_SIZE - 1)/PARALLEL_STRIPE_SIZE);
+    int planesPerStripe = stripesPerPlane > 1 ? 1 : (int)std::max(PARALLEL_STRIPE_SIZE/planeSize, (size_t)1);
+    size_t nstripes = stripesPerPlane > 1 ? nplanes*stripesPerPlane : (nplanes + planesPerStripe - 1)/planesPerStripe;
+    CV_Assert( nstripes <= (size_t)INT_MAX );
+
+    parallel_for(BlockedRange(0, (int)nstripes),
+                 StripeInvoker<Op>(op, planes, esz, narrays, nplanes, planeSize,
+                                   stripesPerPlane, planesPerStripe));
+}
+
 /****************************************************************************************\
 *                                       split & merge                                    *
 \****************************************************************************************/
@@ -151,6 +269,177 @@ merge_( const T** src, T* dst, int len, int cn )
     }
 }
 
+#if CV_SSE2
+
+/*
+ Interleaving and deinterleaving of 2-, 3- and 4-channel 8u and 16u data with SSE2.
+
+ unpackLayer() interleaves the halves of the register array pairwise: v[2j], v[2j+1] become
+ the low and the high halves of unpack(v[j], v[j+n/2]). Applied nlayers times to the registers
+ loaded from the interleaved data, it leaves the registers with the consecutive elements of
+ the channel 0, then of the channel 1 etc.; packLayer() is the inverse transformation.
+*/
+struct Unpack8u
+{
+    typedef uchar T;
+    enum { nlanes = 16, layers2 = 4, layers3 = 5, layers4 = 4 };
+    static __m128i lo(__m128i a, __m128i b) { return _mm_unpacklo_epi8(a, b); }
+    static __m128i hi(__m128i a, __m128i b) { return _mm_unpackhi_epi8(a, b); }
+    static __m128i even(__m128i a, __m128i b)
+    {
+        __m128i mask = _mm_set1_epi16(255);
+        return _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    }
+    static __m128i odd(__m128i a, __m128i b)
+    { return _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)); }
+};
+
+struct Unpack16u
+{
+    typedef ushort T;
+    enum { nlanes = 8, layers2 = 3, layers3 = 4, layers4 = 3 };
+    static __m128i lo(__m128i a, __m128i b) { return _mm_unpacklo_epi16(a, b); }
+    static __m128i hi(__m128i a, __m128i b) { return _mm_unpackhi_epi16(a, b); }
+    // the sign-extended 16-bit halves are packed by the signed saturation without changes
+    static __m128i even(__m128i a, __m128i b)
+    {
+        return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                               _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+    }
+    static __m128i odd(__m128i a, __m128i b)
+    { return _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)); }
+};
+
+template<class V, int n> static inline void unpackLayer(__m128i* v)
+{
+    __m128i t[n];
+    for( int j = 0; j < n/2; j++ )
+    {
+        t[j*2] = V::lo(v[j], v[j + n/2]);
+        t[j*2+1] = V::hi(v[j], v[j + n/2]);
+    }
+    for( int j = 0; j < n; j++ )
+        v[j] = t[j];
+}
+
+template<class V, int n> static inline void packLayer(__m128i* v)
+{
+    __m128i t[n];
+    for( int j = 0; j < n/2; j++ )
+    {
+        t[j] = V::even(v[j*2], v[j*2+1]);
+        t[j + n/2] = V::odd(v[j*2], v[j*2+1]);
+    }
+    for( int j = 0; j < n; j++ )
+        v[j] = t[j];
+}
+
+// n registers hold n*nlanes/cn pixels, n/cn registers per channel
+template<class V, int cn, int n, int nlayers> static int
+splitSimd_( const typename V::T* src, typename V::T** dst, int len )
+{
+    typedef typename V::T T;
+    const int npix = V::nlanes*n/cn, nregs = n/cn;
+    int i = 0;
+    for( ; i <= len - npix; i += npix )
+    {
+        const T* s = src + i*cn;
+        __m128i v[n];
+        for( int k = 0; k < n; k++ )
+            v[k] = _mm_loadu_si128((const __m128i*)(s + k*V::nlanes));
+        for( int l = 0; l < nlayers; l++ )
+            unpackLayer<V, n>(v);
+        for( int c = 0; c < cn; c++ )
+            for( int k = 0; k < nregs; k++ )
+                _mm_storeu_si128((__m128i*)(dst[c] + i + k*V::nlanes), v[c*nregs + k]);
+    }
+    return i;
+}
+
+template<class V, int cn, int n, int nlayers> static int
+mergeSimd_( const typename V::T** src, typename V::T* dst, int len )
+{
+    typedef typename V::T T;
+    const int npix = V::nlanes*n/cn, nregs = n/cn;
+    int i = 0;
+    for( ; i <= len - npix; i += npix )
+    {
+        T* d = dst + i*cn;
+        __m128i v[n];
+        for( int c = 0; c < cn; c++ )
+            for( int k = 0; k < nregs; k++ )
+                v[c*nregs + k] = _mm_loadu_si128((const __m128i*)(src[c] + i + k*V::nlanes));
+        for( int l = 0; l < nlayers; l++ )
+            packLayer<V, n>(v);
+        for( int k = 0; k < n; k++ )
+            _mm_storeu_si128((__m128i*)(d + k*V::nlanes), v[k]);
+    }
+    return i;
+}
+
+template<class V> static int splitSimd( const typename V::T* src, typename V::T** dst, int len, int cn )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    return cn == 2 ? splitSimd_<V, 2, 2, V::layers2>(src, dst, len) :
+           cn == 3 ? splitSimd_<V, 3, 6, V::layers3>(src, dst, len) :
+           cn == 4 ? splitSimd_<V, 4, 4, V::layers4>(src, dst, len) : 0;
+}
+
+template<class V> static int mergeSimd( const typename V::T** src, typename V::T* dst, int len, int cn )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    return cn == 2 ? mergeSimd_<V, 2, 2, V::layers2>(src, dst, len) :
+           cn == 3 ? mergeSimd_<V, 3, 6, V::layers3>(src, dst, len) :
+           cn == 4 ? mergeSimd_<V, 4, 4, V::layers4>(src, dst, len) : 0;
+}
+
+// the SIMD loop followed by the scalar code for the tail
+template<class V> static void
+splitOpt_( const typename V::T* src, typename V::T** dst, int len, int cn )
+{
+    typedef typename V::T T;
+    int i = splitSimd<V>(src, dst, len, cn);
+    if( i == 0 )
+        split_(src, dst, len, cn);
+    else if( i < len )
+    {
+        T* dst1[4];
+        for( int k = 0; k < cn; k++ )
+            dst1[k] = dst[k] + i;
+        split_(src + i*cn, dst1, len - i, cn);
+    }
+}
+
+template<class V> static void
+mergeOpt_( const typename V::T** src, typename V::T* dst, int len, int cn )
+{
+    typedef typename V::T T;
+    int i = mergeSimd<V>(src, dst, len, cn);
+    if( i == 0 )
+        merge_(src, dst, len, cn);
+    else if( i < len )
+    {
+        const T* src1[4];
+        for( int k = 0; k < cn; k++ )
+            src1[k] = src[k] + i;
+        merge_(src1, dst + i*cn, len - i, cn);
+    }
+}
+
+static void split8u(const uchar* src, uchar** dst, int len, int cn )
+{
+    splitOpt_<Unpack8u>(src, dst, len, cn);
+}
+
+static void split16u(const ushort* src, ushort** dst, int len, int cn )
+{
+    splitOpt_<Unpack16u>(src, dst, len, cn);
+}
+
+#else
+
 static void split8u(const uchar* src, uchar** dst, int len, int cn )
 {
     split_(src, dst, len, cn);
@@ -161,6 +450,8 @@ static void split16u(const ushort* src, ushort** dst, int len, int cn )
     split_(src, dst, len, cn);
 }
 
+#endif
+
 static void split32s(const int* src, int** dst, int len, int cn )
 {
     split_(src, dst, len, cn);
@@ -171,6 +462,20 @@ static void split64s(const int64* src, int64** dst, int len, int cn )
     split_(src, dst, len, cn);
 }
 
+#if CV_SSE2
+
+static void merge8u(const uchar** src, uchar* dst, int len, int cn )
+{
+    mergeOpt_<Unpack8u>(src, dst, len, cn);
+}
+
+static void merge16u(const ushort** src, ushort* dst, int len, int cn )
+{
+    mergeOpt_<Unpack16u>(src, dst, len, cn);
+}
+
+#else
+
 static void merge8u(const uchar** src, uchar* dst, int len, int cn )
 {
     merge_(src, dst, len, cn);
@@ -181,6 +486,8 @@ static void merge16u(const ushort** src, ushort* dst, int len, int cn )
     merge_(src, dst, len, cn);
 }
 
+#endif
+
 static void merge32s(const int** src, int* dst, int len, int cn )
 {
     merge_(src, dst, len, cn);
@@ -194,6 +501,42 @@ static void merge64s(const int64** src, int64* dst, int len, int cn )
 typedef void (*SplitFunc)(const uchar* src, uchar** dst, int len, int cn);
 typedef void (*MergeFunc)(const uchar** src, uchar* dst, int len, int cn);
 
+// ptrs[0] is the multi-channel array, ptrs[1..cn] are the single-channel ones
+struct SplitMergeOp
+{
+    SplitMergeOp(SplitFunc _split, MergeFunc _merge, int _cn, size_t _esz1)
+        : split(_split), merge(_merge), cn(_cn), esz1(_esz1)
+    {
+        // many channels are processed in blocks, so that the source block stays in cache
+        blocksize = cn <= 4 ? INT_MAX : (int)((BLOCK_SIZE + esz1*cn - 1)/(esz1*cn));
+    }
+
+    void operator()( uchar** ptrs, int len ) const
+    {
+        for( int j = 0; j < len; j += blocksize )
+        {
+            int bsz = std::min(len - j, blocksize);
+            if( split )
+                split(ptrs[0], &ptrs[1], bsz, cn);
+            else
+                merge((const uchar**)&ptrs[1], ptrs[0], bsz, cn);
+
+            if( j + blocksize < len )
+            {
+                ptrs[0] += bsz*esz1*cn;
+                for( int k = 0; k < cn; k++ )
+                    ptrs[k+1] += bsz*esz1;
+            }
+        }
+    }
+
+    SplitFunc split;
+    MergeFunc merge;
+    int cn;
+    size_t esz1;
+    int blocksize;
+};
+
 static SplitFunc splitTab[] =
 {
     (SplitFunc)split8u, (SplitFunc)split8u, (SplitFunc)split16u, (SplitFunc)split16u,
@@ -220,12 +563,7 @@ void cv::split(const Mat& src, Mat* mv)
     SplitFunc func = splitTab[depth];
     CV_Assert( func != 0 );
     
-    int esz = src.elemSize(), esz1 = src.elemSize1();
-    int blocksize0 = (BLOCK_SIZE + esz-1)/esz;
-    AutoBuffer<uchar> _buf((cn+1)*(sizeof(Mat*) + sizeof(uchar*)) + 16);
-    const Mat** arrays = (const Mat**)(uchar*)_buf;
-    uchar** ptrs = (uchar**)alignPtr(arrays + cn + 1, 16);
-    
+    AutoBuffer<const Mat*> arrays(cn+1);
     arrays[0] = &src;
     for( k = 0; k < cn; k++ )
     {
@@ -233,24 +571,7 @@ void cv::split(const Mat& src, Mat* mv)
         arrays[k+1] = &mv[k];
     }
     
-    NAryMatIterator it(arrays, ptrs, cn+1);
-    int total = (int)it.size, blocksize = cn <= 4 ? total : std::min(total, blocksize0);
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( int j = 0; j < total; j += blocksize )
-        {
-            int bsz = std::min(total - j, blocksize);
-            func( ptrs[0], &ptrs[1], bsz, cn );
-            
-            if( j + blocksize < total )
-            {
-                ptrs[0] += bsz*esz;
-                for( k = 0; k < cn; k++ )
-                    ptrs[k+1] += bsz*esz1;
-            }
-        }
-    }
+    parallelApply(arrays, cn+1, SplitMergeOp(func, 0, cn, src.elemSize1()));
 }
     
 void cv::split(const Mat& m, vector<Mat>& mv)
@@ -304,35 +625,15 @@ void cv::merge(const Mat* mv, size_t n, OutputArray _dst)
         return;
     }
         
-    size_t esz = dst.elemSize(), esz1 = dst.elemSize1();
-    int blocksize0 = (BLOCK_SIZE + esz-1)/esz;
-    AutoBuffer<uchar> _buf((cn+1)*(sizeof(Mat*) + sizeof(uchar*)) + 16);
-    const Mat** arrays = (const Mat**)(uchar*)_buf;
-    uchar** ptrs = (uchar**)alignPtr(arrays + cn + 1, 16);
+    MergeFunc func = mergeTab[depth];
+    CV_Assert( func != 0 );
     
+    AutoBuffer<const Mat*> arrays(cn+1);
     arrays[0] = &dst;
     for( k = 0; k < cn; k++ )
         arrays[k+1] = &mv[k];
     
-    NAryMatIterator it(arrays, ptrs, cn+1);
-    int total = (int)it.size, blocksize = cn <= 4 ? total : std::min(total, blocksize0);
-    MergeFunc func = mergeTab[depth];
-    
-    for( i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( int j = 0; j < total; j += blocksize )
-        {
-            int bsz = std::min(total - j, blocksize);
-            func( (const uchar**)&ptrs[1], ptrs[0], bsz, cn );
-            
-            if( j + blocksize < total )
-            {
-                ptrs[0] += bsz*esz;
-                for( int k = 0; k < cn; k++ )
-                    ptrs[k+1] += bsz*esz1;
-            }
-        }
-    }
+    parallelApply(arrays, cn+1, SplitMergeOp(0, func, cn, dst.elemSize1()));
 }
 
 void cv::merge(const vector<Mat>& mv, OutputArray _dst)
@@ -416,6 +717,52 @@ static MixChannelsFunc mixchTab[] =
     (MixChannelsFunc)mixChannels16u, (MixChannelsFunc)mixChannels32s, (MixChannelsFunc)mixChannels32s,
     (MixChannelsFunc)mixChannels64s, 0 
 };
+
+// tab[k*4], tab[k*4+1] are the index of the source array and the offset of the channel in the pixel,
+// tab[k*4+2], tab[k*4+3] are the same for the destination; the source index narrays means zeros
+struct MixChannelsOp
+{
+    MixChannelsOp(MixChannelsFunc _func, const int* _tab, const int* _sdelta, const int* _ddelta,
+                  int _npairs, int _narrays, size_t _esz1)
+        : func(_func), tab(_tab), sdelta(_sdelta), ddelta(_ddelta), npairs(_npairs),
+          narrays(_narrays), esz1(_esz1)
+    {
+        blocksize = (int)((BLOCK_SIZE + esz1-1)/esz1);
+    }
+
+    void operator()( uchar** ptrs, int len ) const
+    {
+        AutoBuffer<uchar*, 32> buf(npairs*2);
+        uchar** srcs = buf;
+        uchar** dsts = srcs + npairs;
+        int k;
+        for( k = 0; k < npairs; k++ )
+        {
+            srcs[k] = tab[k*4] < narrays ? ptrs[tab[k*4]] + tab[k*4+1] : 0;
+            dsts[k] = ptrs[tab[k*4+2]] + tab[k*4+3];
+        }
+
+        for( int j = 0; j < len; j += blocksize )
+        {
+            int bsz = std::min(len - j, blocksize);
+            func( (const uchar**)srcs, sdelta, dsts, ddelta, bsz, npairs );
+
+            if( j + blocksize < len )
+                for( k = 0; k < npairs; k++ )
+                {
+                    if( srcs[k] )
+                        srcs[k] += blocksize*sdelta[k]*esz1;
+                    dsts[k] += blocksize*ddelta[k]*esz1;
+                }
+        }
+    }
+
+    MixChannelsFunc func;
+    const int *tab, *sdelta, *ddelta;
+    int npairs, narrays;
+    size_t esz1;
+    int blocksize;
+};
     
 }
     
@@ -425,22 +772,18 @@ void cv::mixChannels( const Mat* src, size_t nsrcs, Mat* dst, size_t ndsts, cons
         return;
     CV_Assert( src && nsrcs > 0 && dst && ndsts > 0 && fromTo && npairs > 0 );
     
-    size_t i, j, k, esz1 = dst[0].elemSize1();
+    size_t i, j, esz1 = dst[0].elemSize1();
     int depth = dst[0].depth();
 
-    AutoBuffer<uchar> buf((nsrcs + ndsts + 1)*(sizeof(Mat*) + sizeof(uchar*)) + npairs*(sizeof(uchar*)*2 + sizeof(int)*6));
+    AutoBuffer<uchar> buf((nsrcs + ndsts)*sizeof(Mat*) + npairs*sizeof(int)*6);
     const Mat** arrays = (const Mat**)(uchar*)buf;
-    uchar** ptrs = (uchar**)(arrays + nsrcs + ndsts);
-    const uchar** srcs = (const uchar**)(ptrs + nsrcs + ndsts + 1);
-    uchar** dsts = (uchar**)(srcs + npairs);
-    int* tab = (int*)(dsts + npairs);
+    int* tab = (int*)(arrays + nsrcs + ndsts);
     int *sdelta = (int*)(tab + npairs*4), *ddelta = sdelta + npairs;
     
     for( i = 0; i < nsrcs; i++ )
         arrays[i] = &src[i];
     for( i = 0; i < ndsts; i++ )
         arrays[i + nsrcs] = &dst[i];
-    ptrs[nsrcs + ndsts] = 0;
     
     for( i = 0; i < npairs; i++ )
     {
@@ -468,31 +811,9 @@ void cv::mixChannels( const Mat* src, size_t nsrcs, Mat* dst, size_t ndsts, cons
         ddelta[i] = dst[j].channels();
     }
 
-    NAryMatIterator it(arrays, ptrs, nsrcs + ndsts);
-    int total = (int)it.size, blocksize = std::min(total, (int)((BLOCK_SIZE + esz1-1)/esz1));
-    MixChannelsFunc func = mixchTab[depth];
-    
-    for( i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( k = 0; k < npairs; k++ )
-        {
-            srcs[k] = ptrs[tab[k*4]] + tab[k*4+1];
-            dsts[k] = ptrs[tab[k*4+2]] + tab[k*4+3];
-        }
-        
-        for( int j = 0; j < total; j += blocksize )
-        {
-            int bsz = std::min(total - j, blocksize);
-            func( srcs, sdelta, dsts, ddelta, bsz, (int)npairs );
-            
-            if( j + blocksize < total )
-                for( k = 0; k < npairs; k++ )
-                {
-                    srcs[k] += blocksize*sdelta[k]*esz1;
-                    dsts[k] += blocksize*ddelta[k]*esz1;
-                }
-        }
-    }
+    parallelApply(arrays, (int)(nsrcs + ndsts),
+                  MixChannelsOp(mixchTab[depth], tab, sdelta, ddelta, (int)npairs,
+                                (int)(nsrcs + ndsts), esz1));
 }
 
 
@@ -529,6 +850,195 @@ void cv::insertChannel(InputArray _src, InputOutputArray _dst, int coi)
 namespace cv
 {
 
+/*
+ cvtSimd(), cvtScaleSimd() and cvtScaleAbsSimd() convert the beginning of the row and return
+ the number of the converted elements; the rest is converted by the generic code. With the
+ float intermediate values and the rounding of cvRound() the results are the same as of the
+ generic code.
+*/
+template<typename T, typename DT> static inline int
+cvtSimd( const T*, DT*, int ) { return 0; }
+
+template<typename T, typename DT> static inline int
+cvtScaleSimd( const T*, DT*, int, float, float ) { return 0; }
+
+template<typename T> static inline int
+cvtScaleAbsSimd( const T*, uchar*, int, float, float ) { return 0; }
+
+#if CV_SSE2
+
+// load 8 elements as floats
+static inline void load8f( const uchar* src, __m128& a, __m128& b )
+{
+    __m128i z = _mm_setzero_si128(), v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src), z);
+    a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, z));
+    b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, z));
+}
+
+static inline void load8f( const ushort* src, __m128& a, __m128& b )
+{
+    __m128i z = _mm_setzero_si128(), v = _mm_loadu_si128((const __m128i*)src);
+    a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, z));
+    b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, z));
+}
+
+static inline void load8f( const short* src, __m128& a, __m128& b )
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)src);
+    a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+static inline void load8f( const float* src, __m128& a, __m128& b )
+{
+    a = _mm_loadu_ps(src);
+    b = _mm_loadu_ps(src + 4);
+}
+
+// round and store 8 floats with saturation. _mm_cvtps_epi32() returns INT_MIN for NaNs and
+// the values out of the int range, as cvRound() does
+static inline void store8f( uchar* dst, __m128 a, __m128 b )
+{
+    __m128i v = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(v, v));
+}
+
+static inline __m128i saturate16u( __m128i v )
+{
+    __m128i z = _mm_setzero_si128(), vmax = _mm_set1_epi32(65535);
+    v = _mm_andnot_si128(_mm_cmpgt_epi32(z, v), v);
+    __m128i m = _mm_cmpgt_epi32(v, vmax);
+    v = _mm_or_si128(_mm_andnot_si128(m, v), _mm_and_si128(m, vmax));
+    // the sign-extended values are packed by _mm_packs_epi32() without changes
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+static inline void store8f( ushort* dst, __m128 a, __m128 b )
+{
+    _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(saturate16u(_mm_cvtps_epi32(a)),
+                                                    saturate16u(_mm_cvtps_epi32(b))));
+}
+
+static inline void store8f( short* dst, __m128 a, __m128 b )
+{
+    _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+}
+
+static inline void store8f( float* dst, __m128 a, __m128 b )
+{
+    _mm_storeu_ps(dst, a);
+    _mm_storeu_ps(dst + 4, b);
+}
+
+template<typename T, typename DT> static inline int
+cvtSimdf_( const T* src, DT* dst, int len )
+{
+    int x = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+        for( ; x <= len - 8; x += 8 )
+        {
+            __m128 a, b;
+            load8f(src + x, a, b);
+            store8f(dst + x, a, b);
+        }
+    return x;
+}
+
+template<typename T, typename DT> static inline int
+cvtScaleSimdf_( const T* src, DT* dst, int len, float scale, float shift )
+{
+    int x = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128 vscale = _mm_set1_ps(scale), vshift = _mm_set1_ps(shift);
+        for( ; x <= len - 8; x += 8 )
+        {
+            __m128 a, b;
+            load8f(src + x, a, b);
+            a = _mm_add_ps(_mm_mul_ps(a, vscale), vshift);
+            b = _mm_add_ps(_mm_mul_ps(b, vscale), vshift);
+            store8f(dst + x, a, b);
+        }
+    }
+    return x;
+}
+
+template<typename T> static inline int
+cvtScaleAbsSimdf_( const T* src, uchar* dst, int len, float scale, float shift )
+{
+    int x = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128 vscale = _mm_set1_ps(scale), vshift = _mm_set1_ps(shift), sign = _mm_set1_ps(-0.f);
+        for( ; x <= len - 8; x += 8 )
+        {
+            __m128 a, b;
+            load8f(src + x, a, b);
+            a = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(a, vscale), vshift));
+            b = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(b, vscale), vshift));
+            store8f(dst + x, a, b);
+        }
+    }
+    return x;
+}
+
+#define CV_DEF_CVT_SIMD(stype, dtype) \
+static inline int cvtSimd( const stype* src, dtype* dst, int len ) \
+{ return cvtSimdf_(src, dst, len); } \
+static inline int cvtScaleSimd( const stype* src, dtype* dst, int len, float scale, float shift ) \
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+
+CV_DEF_CVT_SIMD(uchar, float)
+CV_DEF_CVT_SIMD(ushort, float)
+CV_DEF_CVT_SIMD(short, float)
+CV_DEF_CVT_SIMD(float, uchar)
+CV_DEF_CVT_SIMD(float, ushort)
+CV_DEF_CVT_SIMD(float, short)
+
+static inline int cvtScaleSimd( const uchar* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleSimd( const uchar* src, short* dst, int len, float scale, float shift )
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleSimd( const short* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleSimd( const ushort* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleSimd( const float* src, float* dst, int len, float scale, float shift )
+{ return cvtScaleSimdf_(src, dst, len, scale, shift); }
+
+// the integer widening does not need floats
+static inline int cvtSimd( const uchar* src, short* dst, int len )
+{
+    int x = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128i z = _mm_setzero_si128();
+        for( ; x <= len - 16; x += 16 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_unpacklo_epi8(v, z));
+            _mm_storeu_si128((__m128i*)(dst + x + 8), _mm_unpackhi_epi8(v, z));
+        }
+    }
+    return x;
+}
+
+static inline int cvtSimd( const uchar* src, ushort* dst, int len )
+{
+    return cvtSimd(src, (short*)dst, len);
+}
+
+static inline int cvtScaleAbsSimd( const uchar* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleAbsSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleAbsSimd( const ushort* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleAbsSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleAbsSimd( const short* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleAbsSimdf_(src, dst, len, scale, shift); }
+static inline int cvtScaleAbsSimd( const float* src, uchar* dst, int len, float scale, float shift )
+{ return cvtScaleAbsSimdf_(src, dst, len, scale, shift); }
+
+#endif
+
 template<typename T, typename DT, typename WT> static void
 cvtScaleAbs_( const T* src, size_t sstep,
               DT* dst, size_t dstep, Size size,
@@ -539,7 +1049,7 @@ cvtScaleAbs_( const T* src, size_t sstep,
     
     for( ; size.height--; src += sstep, dst += dstep )
     {
-        int x = 0;
+        int x = cvtScaleAbsSimd(src, dst, size.width, scale, shift);
         for( ; x <= size.width - 4; x += 4 )
         {
             DT t0, t1;
@@ -566,7 +1076,7 @@ cvtScale_( const T* src, size_t sstep,
     
     for( ; size.height--; src += sstep, dst += dstep )
     {
-        int x = 0;
+        int x = cvtScaleSimd(src, dst, size.width, scale, shift);
         for( ; x <= size.width - 4; x += 4 )
         {
             DT t0, t1;
@@ -593,7 +1103,7 @@ cvt_( const T* src, size_t sstep,
     
     for( ; size.height--; src += sstep, dst += dstep )
     {
-        int x = 0;
+        int x = cvtSimd(src, dst, size.width);
         for( ; x <= size.width - 4; x += 4 )
         {
             DT t0, t1;
@@ -867,6 +1377,19 @@ BinaryFunc getConvertScaleFunc(int sdepth, int ddepth)
 {
     return cvtScaleTab[CV_MAT_DEPTH(ddepth)][CV_MAT_DEPTH(sdepth)];
 }    
+
+// converts the planes as the single rows of len*cn elements
+struct ConvertOp
+{
+    ConvertOp(BinaryFunc _func, int _cn, double* _scale) : func(_func), cn(_cn), scale(_scale) {}
+    void operator()( uchar** ptrs, int len ) const
+    {
+        func( ptrs[0], 0, 0, 0, ptrs[1], 0, Size(len*cn, 1), scale );
+    }
+    BinaryFunc func;
+    int cn;
+    double* scale;
+};
     
 }
     
@@ -880,21 +1403,8 @@ void cv::convertScaleAbs( InputArray _src, OutputArray _dst, double alpha, doubl
     BinaryFunc func = cvtScaleAbsTab[src.depth()];
     CV_Assert( func != 0 );
     
-    if( src.dims <= 2 )
-    {
-        Size sz = getContinuousSize(src, dst, cn);
-        func( src.data, src.step, 0, 0, dst.data, dst.step, sz, scale );
-    }
-    else
-    {
-        const Mat* arrays[] = {&src, &dst, 0};
-        uchar* ptrs[2];
-        NAryMatIterator it(arrays, ptrs);
-        Size sz((int)it.size*cn, 1);
-        
-        for( size_t i = 0; i < it.nplanes; i++, ++it )
-            func( ptrs[0], 0, 0, 0, ptrs[1], 0, sz, scale );
-    }
+    const Mat* arrays[] = {&src, &dst, 0};
+    parallelApply(arrays, 2, ConvertOp(func, cn, scale));
 }
 
 void cv::Mat::convertTo(OutputArray _dst, int _type, double alpha, double beta) const
@@ -921,24 +1431,12 @@ void cv::Mat::convertTo(OutputArray _dst, int _type, double alpha, double beta)
     CV_Assert( func != 0 );
     
     if( dims <= 2 )
-    {
         _dst.create( size(), _type );
-        Mat dst = _dst.getMat();
-        Size sz = getContinuousSize(src, dst, cn);
-        func( src.data, src.step, 0, 0, dst.data, dst.step, sz, scale );
-    }
     else
-    {
         _dst.create( dims, size, _type );
-        Mat dst = _dst.getMat();
-        const Mat* arrays[] = {&src, &dst, 0};
-        uchar* ptrs[2];
-        NAryMatIterator it(arrays, ptrs);
-        Size sz((int)(it.size*cn), 1);
-        
-        for( size_t i = 0; i < it.nplanes; i++, ++it )
-            func(ptrs[0], 0, 0, 0, ptrs[1], 0, sz, scale);
-    }
+    Mat dst = _dst.getMat();
+    const Mat* arrays[] = {&src, &dst, 0};
+    parallelApply(arrays, 2, ConvertOp(func, cn, scale));
 }
 
 /****************************************************************************************\
@@ -1007,6 +1505,19 @@ static LUTFunc lutTab[] =
     (LUTFunc)LUT8u_32s, (LUTFunc)LUT8u_32f, (LUTFunc)LUT8u_64f, 0
 };
 
+struct LUTOp
+{
+    LUTOp(LUTFunc _func, const uchar* _lut, int _cn, int _lutcn)
+        : func(_func), lut(_lut), cn(_cn), lutcn(_lutcn) {}
+    void operator()( uchar** ptrs, int len ) const
+    {
+        func(ptrs[0], lut, ptrs[1], len, cn, lutcn);
+    }
+    LUTFunc func;
+    const uchar* lut;
+    int cn, lutcn;
+};
+
 }
     
 void cv::LUT( InputArray _src, InputArray _lut, OutputArray _dst, int interpolation )
@@ -1026,12 +1537,7 @@ void cv::LUT( InputArray _src, InputArray _lut, OutputArray _dst, int interpolat
     CV_Assert( func != 0 );
     
     const Mat* arrays[] = {&src, &dst, 0};
-    uchar* ptrs[2];
-    NAryMatIterator it(arrays, ptrs);
-    int len = (int)it.size;
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        func(ptrs[0], lut.data, ptrs[1], len, cn, lutcn);
+    parallelApply(arrays, 2, LUTOp(func, lut.data, cn, lutcn));
 }
 
 
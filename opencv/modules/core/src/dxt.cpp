@@ -1449,10 +1449,345 @@ static void CCSIDFT_64f( const double* src, double* dst, int n, int nf, int* fac
     CCSIDFT( src, dst, n, nf, factors, itab, wave, tab_size, spec, buf, flags, scale);
 }
     
+
+struct DFTTables
+{
+    int len, depth, inv_itab;
+    int nf, factors[34];
+    Mat wave, itab;
+};
+
+/*
+   The factorization, twiddle factors and permutation tables for one transform length.
+   They depend only on the length, the depth and whether the permutation is inverted
+   for CCS->real transforms, so the recently used ones are kept in a small cache
+   shared by all the threads.
+*/
+static Ptr<DFTTables> getDFTTables( int len, int depth, int inv_itab )
+{
+    enum { MAX_CACHED_TABLES = 16 };
+    static Mutex mutex;
+    static vector<Ptr<DFTTables> > cache; // the most recently used tables come first
+
+    AutoLock lock(mutex);
+    for( size_t i = 0; i < cache.size(); i++ )
+    {
+        const DFTTables& t = *cache[i];
+        if( t.len == len && t.depth == depth && t.inv_itab == inv_itab )
+        {
+            Ptr<DFTTables> found = cache[i];
+            cache.erase(cache.begin() + i);
+            cache.insert(cache.begin(), found);
+            return found;
+        }
+    }
+
+    Ptr<DFTTables> t = new DFTTables;
+    int complex_elem_size = (int)(depth == CV_32F ? sizeof(Complexf) : sizeof(Complexd));
+    t->len = len;
+    t->depth = depth;
+    t->inv_itab = inv_itab;
+    t->nf = DFTFactorize( len, t->factors );
+    t->wave.create( 1, len*complex_elem_size, CV_8U );
+    t->itab.create( 1, len, CV_32S );
+    DFTInit( len, t->nf, t->factors, (int*)t->itab.data, complex_elem_size,
+             t->wave.data, inv_itab );
+
+    cache.insert(cache.begin(), t);
+    if( cache.size() > MAX_CACHED_TABLES )
+        cache.pop_back();
+    return t;
 }
-    
 
-void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
+// the scratch space needed by DFT() for the odd factors > 5
+static int getDFTScratchSize( const DFTTables* t, int complex_elem_size )
+{
+    if( !t )
+        return 0;
+    int i = t->nf > 1 && (t->factors[0] & 1) == 0;
+    return (t->factors[i] & 1) != 0 && t->factors[i] > 5 ? (t->factors[i]+1)*complex_elem_size : 0;
+}
+
+// the row-wise stage: each row is transformed independently
+class DFTRowsInvoker
+{
+public:
+    DFTRowsInvoker( const Mat& _src, const Mat& _dst, DFTFunc _func, int _len,
+                    const DFTTables* _tabs, const void* _spec, int _flags, double _scale,
+                    int _bufsize, bool _use_buf, int _dptr_offset, int _dst_full_len,
+                    int _complex_elem_size )
+        : src(_src), dst(_dst), func(_func), len(_len), tabs(_tabs), spec(_spec),
+          flags(_flags), scale(_scale), bufsize(_bufsize), use_buf(_use_buf),
+          dptr_offset(_dptr_offset), dst_full_len(_dst_full_len),
+          complex_elem_size(_complex_elem_size)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        AutoBuffer<uchar> _buf(bufsize + len*complex_elem_size + 32);
+        uchar* ptr = alignPtr((uchar*)_buf, 16);
+        uchar* tmp_buf = 0;
+        // RealDFT() temporarily modifies the factors, so each thread needs its own copy
+        int nf = tabs ? tabs->nf : 0, factors[34];
+        const int* itab = tabs ? (const int*)tabs->itab.data : 0;
+        const uchar* wave = tabs ? tabs->wave.data : 0;
+        for( int k = 0; k < nf; k++ )
+            factors[k] = tabs->factors[k];
+
+        if( use_buf )
+        {
+            tmp_buf = ptr;
+            ptr += len*complex_elem_size;
+        }
+
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            const uchar* sptr = src.data + i*src.step;
+            uchar* dptr0 = dst.data + i*dst.step;
+            uchar* dptr = tmp_buf ? tmp_buf : dptr0;
+
+            func( sptr, dptr, len, nf, factors, itab, wave, len, spec, ptr, flags, scale );
+            if( dptr != dptr0 )
+                memcpy( dptr0, dptr + dptr_offset, dst_full_len );
+        }
+    }
+
+private:
+    Mat src, dst;
+    DFTFunc func;
+    int len;
+    const DFTTables* tabs;
+    const void* spec;
+    int flags;
+    double scale;
+    int bufsize;
+    bool use_buf;
+    int dptr_offset, dst_full_len, complex_elem_size;
+};
+
+// the column-wise stage: the complex columns are processed in pairs, one pair per iteration
+class DFTColumnsInvoker
+{
+public:
+    DFTColumnsInvoker( const uchar* _sptr0, size_t _sstep, uchar* _dptr0, size_t _dstep,
+                       DFTFunc _func, int _len, int _count, const DFTTables* _tabs,
+                       const void* _spec, int _inv, double _scale, int _bufsize,
+                       bool _use_buf, int _complex_elem_size )
+        : sptr0(_sptr0), sstep(_sstep), dptr0(_dptr0), dstep(_dstep), func(_func),
+          len(_len), count(_count), tabs(_tabs), spec(_spec), inv(_inv), scale(_scale),
+          bufsize(_bufsize), use_buf(_use_buf), complex_elem_size(_complex_elem_size)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int esz = complex_elem_size;
+        AutoBuffer<uchar> _buf(bufsize + len*esz*3 + 32);
+        uchar* ptr = alignPtr((uchar*)_buf, 16);
+        uchar *buf0 = ptr, *buf1 = ptr + len*esz, *dbuf0 = buf0, *dbuf1 = buf1;
+        int nf = tabs ? tabs->nf : 0, factors[34];
+        const int* itab = tabs ? (const int*)tabs->itab.data : 0;
+        const uchar* wave = tabs ? tabs->wave.data : 0;
+        for( int k = 0; k < nf; k++ )
+            factors[k] = tabs->factors[k];
+
+        ptr += len*esz*2;
+        if( use_buf )
+        {
+            dbuf1 = ptr;
+            dbuf0 = buf1;
+            ptr += len*esz;
+        }
+
+        for( int i = range.begin()*2; i < std::min(range.end()*2, count); i += 2 )
+        {
+            const uchar* sptr = sptr0 + i*esz;
+            uchar* dptr = dptr0 + i*esz;
+
+            if( i+1 < count )
+            {
+                CopyFrom2Columns( sptr, sstep, buf0, buf1, len, esz );
+                func( buf1, dbuf1, len, nf, factors, itab, wave, len, spec, ptr, inv, scale );
+            }
+            else
+                CopyColumn( sptr, sstep, buf0, esz, len, esz );
+
+            func( buf0, dbuf0, len, nf, factors, itab, wave, len, spec, ptr, inv, scale );
+
+            if( i+1 < count )
+                CopyTo2Columns( dbuf0, dbuf1, dptr, dstep, len, esz );
+            else
+                CopyColumn( dbuf0, esz, dptr, dstep, len, esz );
+        }
+    }
+
+private:
+    const uchar* sptr0;
+    size_t sstep;
+    uchar* dptr0;
+    size_t dstep;
+    DFTFunc func;
+    int len, count;
+    const DFTTables* tabs;
+    const void* spec;
+    int inv;
+    double scale;
+    int bufsize;
+    bool use_buf;
+    int complex_elem_size;
+};
+
+// runs body on [0, count) in parallel if the job is big enough and parallel execution is allowed
+template<class Body> static void
+runDFTStage( int count, int len, bool parallel, const Body& body )
+{
+    if( parallel && count > 1 && (double)count*len >= 4096 )
+        parallel_for( BlockedRange(0, count), body );
+    else
+        body( BlockedRange(0, count) );
+}
+
+// the transforms of the same-sized arrays, one array per iteration
+class DFTBatchInvoker
+{
+public:
+    DFTBatchInvoker( const DFTPlan& _plan, const vector<Mat>& _src, vector<Mat>& _dst )
+        : plan(&_plan), src(&_src), dst(&_dst) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            Mat d = (*dst)[i];
+            plan->run( (*src)[i], d, 0, false );
+        }
+    }
+
+private:
+    const DFTPlan* plan;
+    const vector<Mat>* src;
+    vector<Mat>* dst;
+};
+
+}
+
+
+cv::DFTPlan::DFTPlan() : size(0, 0), type(-1), flags(0)
+{
+}
+
+cv::DFTPlan::DFTPlan( Size _size, int _type, int _flags ) : size(0, 0), type(-1), flags(0)
+{
+    create( _size, _type, _flags );
+}
+
+cv::DFTPlan::DFTPlan( const DFTPlan& plan )
+    : size(plan.size), type(plan.type), flags(plan.flags)
+{
+    for( int i = 0; i < 3; i++ )
+        tabs[i] = plan.tabs[i];
+}
+
+cv::DFTPlan& cv::DFTPlan::operator = ( const DFTPlan& plan )
+{
+    if( this != &plan )
+    {
+        size = plan.size;
+        type = plan.type;
+        flags = plan.flags;
+        for( int i = 0; i < 3; i++ )
+            tabs[i] = plan.tabs[i];
+    }
+    return *this;
+}
+
+cv::DFTPlan::~DFTPlan()
+{
+}
+
+void cv::DFTPlan::create( Size _size, int _type, int _flags )
+{
+    CV_Assert( (_type == CV_32FC1 || _type == CV_32FC2 || _type == CV_64FC1 || _type == CV_64FC2) &&
+               _size.width > 0 && _size.height > 0 );
+
+    size = _size;
+    type = _type;
+    flags = _flags;
+
+    bool inv = (flags & DFT_INVERSE) != 0;
+    int depth = CV_MAT_DEPTH(type);
+    int inv_itab = inv && (CV_MAT_CN(type) == 1 || (flags & DFT_REAL_OUTPUT) != 0);
+    bool rows_only = (flags & DFT_ROWS) != 0;
+
+    for( int i = 0; i < 3; i++ )
+        tabs[i].release();
+    // the rows, a single column and the columns of a 2D array; see run()
+    if( size.width > 1 || rows_only )
+        tabs[0] = getDFTTables( size.width, depth, inv_itab );
+    if( size.width == 1 && !rows_only )
+        tabs[1] = getDFTTables( size.height, depth, inv_itab );
+    if( !rows_only && size.height > 1 )
+        tabs[2] = getDFTTables( size.height, depth, 0 );
+}
+
+bool cv::DFTPlan::empty() const
+{
+    return type < 0;
+}
+
+int cv::DFTPlan::dstType() const
+{
+    bool inv = (flags & DFT_INVERSE) != 0;
+    int depth = CV_MAT_DEPTH(type), cn = CV_MAT_CN(type);
+    if( !inv && cn == 1 && (flags & DFT_COMPLEX_OUTPUT) )
+        return CV_MAKETYPE(depth, 2);
+    if( inv && cn == 2 && (flags & DFT_REAL_OUTPUT) )
+        return depth;
+    return type;
+}
+
+const cv::DFTTables* cv::DFTPlan::getTables( int len, int inv_itab ) const
+{
+    for( int i = 0; i < 3; i++ )
+        if( !tabs[i].empty() && tabs[i]->len == len && tabs[i]->inv_itab == inv_itab )
+            return tabs[i];
+    CV_Error( CV_StsInternal, "The DFT plan has no tables for the requested length" );
+    return 0;
+}
+
+void cv::DFTPlan::operator()( InputArray _src, OutputArray _dst, int nonzero_rows ) const
+{
+    CV_Assert( !empty() );
+    Mat src = _src.getMat();
+    CV_Assert( src.size() == size && src.type() == type );
+    _dst.create( size, dstType() );
+    Mat dst = _dst.getMat();
+    run( src, dst, nonzero_rows, true );
+}
+
+void cv::DFTPlan::operator()( const vector<Mat>& src, vector<Mat>& dst ) const
+{
+    CV_TRACE_REGION("cv::DFTPlan::batch");
+    CV_Assert( !empty() );
+    size_t i, n = src.size();
+    int dtype = dstType();
+
+    for( i = 0; i < n; i++ )
+        CV_Assert( src[i].size() == size && src[i].type() == type );
+    dst.resize(n);
+    for( i = 0; i < n; i++ )
+        dst[i].create( size, dtype );
+
+    // with many small arrays it is cheaper to transform whole arrays in parallel
+    if( (int)n >= getNumThreads() && n > 1 )
+        parallel_for( BlockedRange(0, (int)n), DFTBatchInvoker(*this, src, dst) );
+    else
+        for( i = 0; i < n; i++ )
+            run( src[i], dst[i], 0, true );
+}
+
+void cv::DFTPlan::run( const Mat& src0, Mat& dst, int nonzero_rows, bool parallel ) const
 {
     static DFTFunc dft_tbl[6] =
     {
@@ -1466,31 +1801,18 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
 
     AutoBuffer<uchar> buf;
     void *spec = 0;
-    
-    Mat src0 = _src0.getMat(), src = src0;
-    int prev_len = 0, stage = 0;
+
+    Mat src = src0;
+    int stage = 0;
     bool inv = (flags & DFT_INVERSE) != 0;
-    int nf = 0, real_transform = src.channels() == 1 || (inv && (flags & DFT_REAL_OUTPUT)!=0);
-    int type = src.type(), depth = src.depth();
+    int real_transform = src.channels() == 1 || (inv && (flags & DFT_REAL_OUTPUT)!=0);
+    int depth = src.depth();
     int elem_size = (int)src.elemSize1(), complex_elem_size = elem_size*2;
-    int factors[34];
-    bool inplace_transform = false;
     int ipp_norm_flag = 0;
 #ifdef HAVE_IPP
     void *spec_r = 0, *spec_c = 0;
 #endif
 
-    CV_Assert( type == CV_32FC1 || type == CV_32FC2 || type == CV_64FC1 || type == CV_64FC2 );
-
-    if( !inv && src.channels() == 1 && (flags & DFT_COMPLEX_OUTPUT) )
-        _dst.create( src.size(), CV_MAKETYPE(depth, 2) );
-    else if( inv && src.channels() == 2 && (flags & DFT_REAL_OUTPUT) )
-        _dst.create( src.size(), depth );
-    else
-        _dst.create( src.size(), type );
-    
-    Mat dst = _dst.getMat();
-
     if( !real_transform )
         elem_size = complex_elem_size;
 
@@ -1511,8 +1833,7 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
     for(;;)
     {
         double scale = 1;
-        uchar* wave = 0;
-        int* itab = 0;
+        const DFTTables* tabs = 0;
         uchar* ptr;
         int i, len, count, sz = 0;
         int use_buf = 0, odd_real = 0;
@@ -1533,7 +1854,6 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
         {
             len = dst.rows;
             count = !inv ? src0.cols : dst.cols;
-            sz = 2*len*complex_elem_size;
         }
 
         spec = 0;
@@ -1583,63 +1903,29 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
                 spec = spec_c;
             }
 
-            sz += ipp_sz;
+            sz = ipp_sz;
         }
         else
 #endif
         {
-            if( len != prev_len )
-                nf = DFTFactorize( len, factors );
-
-            inplace_transform = factors[0] == factors[nf-1];
-            sz += len*(complex_elem_size + sizeof(int));
-            i = nf > 1 && (factors[0] & 1) == 0;
-            if( (factors[i] & 1) != 0 && factors[i] > 5 )
-                sz += (factors[i]+1)*complex_elem_size;
+            tabs = getTables( len, stage == 0 && inv && real_transform );
+            bool inplace_transform = tabs->factors[0] == tabs->factors[tabs->nf-1];
+            sz = getDFTScratchSize( tabs, complex_elem_size );
 
             if( (stage == 0 && ((src.data == dst.data && !inplace_transform) || odd_real)) ||
                 (stage == 1 && !inplace_transform) )
-            {
                 use_buf = 1;
-                sz += len*complex_elem_size;
-            }
-        }
-
-        ptr = (uchar*)buf;
-        buf.allocate( sz + 32 );
-        if( ptr != (uchar*)buf )
-            prev_len = 0; // because we release the buffer,
-                          // force recalculation of
-                          // twiddle factors and permutation table
-        ptr = (uchar*)buf;
-        if( !spec )
-        {
-            wave = ptr;
-            ptr += len*complex_elem_size;
-            itab = (int*)ptr;
-            ptr = (uchar*)cvAlignPtr( ptr + len*sizeof(int), 16 );
-
-            if( len != prev_len || (!inplace_transform && inv && real_transform))
-                DFTInit( len, nf, factors, itab, complex_elem_size,
-                            wave, stage == 0 && inv && real_transform );
-            // otherwise reuse the tables calculated on the previous stage
         }
 
         if( stage == 0 )
         {
-            uchar* tmp_buf = 0;
             int dptr_offset = 0;
             int dst_full_len = len*elem_size;
             int _flags = inv + (src.channels() != dst.channels() ?
                          DFT_COMPLEX_INPUT_OR_OUTPUT : 0);
-            if( use_buf )
-            {
-                tmp_buf = ptr;
-                ptr += len*complex_elem_size;
-                if( odd_real && !inv && len > 1 &&
-                    !(_flags & DFT_COMPLEX_INPUT_OR_OUTPUT))
-                    dptr_offset = elem_size;
-            }
+            if( use_buf && odd_real && !inv && len > 1 &&
+                !(_flags & DFT_COMPLEX_INPUT_OR_OUTPUT))
+                dptr_offset = elem_size;
 
             if( !inv && (_flags & DFT_COMPLEX_INPUT_OR_OUTPUT) )
                 dst_full_len += (len & 1) ? elem_size : complex_elem_size;
@@ -1654,21 +1940,11 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
             if( nonzero_rows <= 0 || nonzero_rows > count )
                 nonzero_rows = count;
 
-            for( i = 0; i < nonzero_rows; i++ )
-            {
-                uchar* sptr = src.data + i*src.step;
-                uchar* dptr0 = dst.data + i*dst.step;
-                uchar* dptr = dptr0;
+            runDFTStage( nonzero_rows, len, parallel,
+                DFTRowsInvoker( src, dst, dft_func, len, tabs, spec, _flags, scale, sz,
+                                use_buf != 0, dptr_offset, dst_full_len, complex_elem_size ));
 
-                if( tmp_buf )
-                    dptr = tmp_buf;
-                
-                dft_func( sptr, dptr, len, nf, factors, itab, wave, len, spec, ptr, _flags, scale );
-                if( dptr != dptr0 )
-                    memcpy( dptr0, dptr + dptr_offset, dst_full_len );
-            }
-
-            for( ; i < count; i++ )
+            for( i = nonzero_rows; i < count; i++ )
             {
                 uchar* dptr0 = dst.data + i*dst.step;
                 memset( dptr0, 0, dst_full_len );
@@ -1682,20 +1958,13 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
         {
             int a = 0, b = count;
             uchar *buf0, *buf1, *dbuf0, *dbuf1;
-            uchar* sptr0 = src.data;
+            const uchar* sptr0 = src.data;
             uchar* dptr0 = dst.data;
-            buf0 = ptr;
-            ptr += len*complex_elem_size;
-            buf1 = ptr;
-            ptr += len*complex_elem_size;
-            dbuf0 = buf0, dbuf1 = buf1;
-            
-            if( use_buf )
-            {
-                dbuf1 = ptr;
-                dbuf0 = buf1;
-                ptr += len*complex_elem_size;
-            }
+            int nf = tabs ? tabs->nf : 0, factors[34];
+            const int* itab = tabs ? (const int*)tabs->itab.data : 0;
+            const uchar* wave = tabs ? tabs->wave.data : 0;
+            for( i = 0; i < nf; i++ )
+                factors[i] = tabs->factors[i];
 
             dft_func = dft_tbl[(depth == CV_64F)*3];
 
@@ -1707,6 +1976,21 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
             if( real_transform )
             {
                 int even;
+                buf.allocate( sz + len*complex_elem_size*3 + 32 );
+                ptr = alignPtr((uchar*)buf, 16);
+                buf0 = ptr;
+                ptr += len*complex_elem_size;
+                buf1 = ptr;
+                ptr += len*complex_elem_size;
+                dbuf0 = buf0, dbuf1 = buf1;
+
+                if( use_buf )
+                {
+                    dbuf1 = ptr;
+                    dbuf0 = buf1;
+                    ptr += len*complex_elem_size;
+                }
+
                 a = 1;
                 even = (count & 1) == 0;
                 b = (count+1)/2;
@@ -1792,27 +2076,10 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
                 }
             }
 
-            for( i = a; i < b; i += 2 )
-            {
-                if( i+1 < b )
-                {
-                    CopyFrom2Columns( sptr0, src.step, buf0, buf1, len, complex_elem_size );
-                    dft_func( buf1, dbuf1, len, nf, factors, itab,
-                              wave, len, spec, ptr, inv, scale );
-                }
-                else
-                    CopyColumn( sptr0, src.step, buf0, complex_elem_size, len, complex_elem_size );
-
-                dft_func( buf0, dbuf0, len, nf, factors, itab,
-                          wave, len, spec, ptr, inv, scale );
-
-                if( i+1 < b )
-                    CopyTo2Columns( dbuf0, dbuf1, dptr0, dst.step, len, complex_elem_size );
-                else
-                    CopyColumn( dbuf0, complex_elem_size, dptr0, dst.step, len, complex_elem_size );
-                sptr0 += 2*complex_elem_size;
-                dptr0 += 2*complex_elem_size;
-            }
+            // the remaining columns [a, b) are transformed in pairs
+            runDFTStage( (b - a + 1)/2, len*2, parallel,
+                DFTColumnsInvoker( sptr0, src.step, dptr0, dst.step, dft_func, len, b - a,
+                                   tabs, spec, inv, scale, sz, use_buf != 0, complex_elem_size ));
 
             if( stage != 0 )
                 break;
@@ -1840,6 +2107,15 @@ void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
 }
 
 
+void cv::dft( InputArray _src0, OutputArray _dst, int flags, int nonzero_rows )
+{
+    CV_TRACE_REGION("cv::dft");
+    Mat src = _src0.getMat();
+    DFTPlan plan( src.size(), src.type(), flags );
+    plan( src, _dst, nonzero_rows );
+}
+
+
 void cv::idft( InputArray src, OutputArray dst, int flags, int nonzero_rows )
 {
     dft( src, dst, flags | DFT_INVERSE, nonzero_rows );
@@ -0,0 +1,110 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX micro-kernels of the packed GEMM (see GEMMPacked in matmul.cpp).
+   The packed slivers are 64-byte aligned, so the B loads are aligned. */
+
+#include "precomp.hpp"
+
+#if CV_AVX
+
+namespace cv
+{
+namespace opt_AVX
+{
+
+// 6 x 16 block of sums in 12 registers
+void gemmKernel32f( int kc, const float* a, const float* b, float* ab )
+{
+    __m256 c00 = _mm256_setzero_ps(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00,
+           c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+
+    for( ; kc > 0; kc--, a += 6, b += 16 )
+    {
+        __m256 b0 = _mm256_load_ps(b), b1 = _mm256_load_ps(b + 8), t;
+#define CV_GEMM_ROW_32F(i) \
+        t = _mm256_broadcast_ss(a + i); \
+        c##i##0 = _mm256_add_ps(c##i##0, _mm256_mul_ps(t, b0)); \
+        c##i##1 = _mm256_add_ps(c##i##1, _mm256_mul_ps(t, b1))
+        CV_GEMM_ROW_32F(0); CV_GEMM_ROW_32F(1); CV_GEMM_ROW_32F(2);
+        CV_GEMM_ROW_32F(3); CV_GEMM_ROW_32F(4); CV_GEMM_ROW_32F(5);
+#undef CV_GEMM_ROW_32F
+    }
+
+    _mm256_storeu_ps(ab, c00); _mm256_storeu_ps(ab + 8, c01);
+    _mm256_storeu_ps(ab + 16, c10); _mm256_storeu_ps(ab + 24, c11);
+    _mm256_storeu_ps(ab + 32, c20); _mm256_storeu_ps(ab + 40, c21);
+    _mm256_storeu_ps(ab + 48, c30); _mm256_storeu_ps(ab + 56, c31);
+    _mm256_storeu_ps(ab + 64, c40); _mm256_storeu_ps(ab + 72, c41);
+    _mm256_storeu_ps(ab + 80, c50); _mm256_storeu_ps(ab + 88, c51);
+}
+
+// 6 x 8 block, the same register layout with 4 doubles per register
+void gemmKernel64f( int kc, const double* a, const double* b, double* ab )
+{
+    __m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00,
+            c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+
+    for( ; kc > 0; kc--, a += 6, b += 8 )
+    {
+        __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4), t;
+#define CV_GEMM_ROW_64F(i) \
+        t = _mm256_broadcast_sd(a + i); \
+        c##i##0 = _mm256_add_pd(c##i##0, _mm256_mul_pd(t, b0)); \
+        c##i##1 = _mm256_add_pd(c##i##1, _mm256_mul_pd(t, b1))
+        CV_GEMM_ROW_64F(0); CV_GEMM_ROW_64F(1); CV_GEMM_ROW_64F(2);
+        CV_GEMM_ROW_64F(3); CV_GEMM_ROW_64F(4); CV_GEMM_ROW_64F(5);
+#undef CV_GEMM_ROW_64F
+    }
+
+    _mm256_storeu_pd(ab, c00); _mm256_storeu_pd(ab + 4, c01);
+    _mm256_storeu_pd(ab + 8, c10); _mm256_storeu_pd(ab + 12, c11);
+    _mm256_storeu_pd(ab + 16, c20); _mm256_storeu_pd(ab + 20, c21);
+    _mm256_storeu_pd(ab + 24, c30); _mm256_storeu_pd(ab + 28, c31);
+    _mm256_storeu_pd(ab + 32, c40); _mm256_storeu_pd(ab + 36, c41);
+    _mm256_storeu_pd(ab + 40, c50); _mm256_storeu_pd(ab + 44, c51);
+}
+
+}
+}
+
+#endif
@@ -46,6 +46,10 @@
 #include "ippversion.h"
 #endif
 
+#ifdef HAVE_CBLAS
+#include <cblas.h>
+#endif
+
 namespace cv
 {
 
@@ -683,11 +687,330 @@ static void GEMMStore_64fc( const Complexd* c_data, size_t c_step,
     GEMMStore(c_data, c_step, d_buf, d_buf_step, d_data, d_step, d_size, alpha, beta, flags);
 }
 
+/****************************************************************************************\
+*                           Packed-panel GEMM for 32f and 64f                            *
+\****************************************************************************************/
+
+/*
+   The large real-valued products are computed the same way as in BLIS or OpenBLAS.
+   B is copied, kc rows at a time, into a panel of nr-column slivers and each
+   thread copies a block of mc rows of A into mr-row slivers. The micro-kernel then
+   multiplies one A sliver by one B sliver, keeping the mr x nr sums in registers,
+   and the result is scaled and stored into D. The row blocks of A are processed
+   in parallel; they share the B panel and write disjoint parts of D.
+*/
+
+template<typename T> struct GEMMPackedKernel
+{
+    typedef void (*Func)( int kc, const T* a, const T* b, T* ab );
+    GEMMPackedKernel( int _mr, int _nr, Func _func ) : mr(_mr), nr(_nr), func(_func) {}
+    int mr, nr;
+    Func func;
+};
+
+// ab[mr*nr] = sum_p a[p*mr + i]*b[p*nr + j]
+template<typename T, int MR, int NR> static void
+GEMMMicroKernel( int kc, const T* a, const T* b, T* ab )
+{
+    int i, j;
+    for( i = 0; i < MR*NR; i++ )
+        ab[i] = 0;
+    for( ; kc > 0; kc--, a += MR, b += NR )
+        for( i = 0; i < MR; i++ )
+        {
+            T ai = a[i];
+            for( j = 0; j < NR; j++ )
+                ab[i*NR + j] += ai*b[j];
+        }
+}
+
+#if CV_SSE2
+
+static void GEMMMicroKernel_32f_SSE2( int kc, const float* a, const float* b, float* ab )
+{
+    __m128 c00 = _mm_setzero_ps(), c01 = c00, c10 = c00, c11 = c00,
+           c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+    for( ; kc > 0; kc--, a += 4, b += 8 )
+    {
+        __m128 b0 = _mm_load_ps(b), b1 = _mm_load_ps(b + 4), t;
+        t = _mm_set1_ps(a[0]);
+        c00 = _mm_add_ps(c00, _mm_mul_ps(t, b0)); c01 = _mm_add_ps(c01, _mm_mul_ps(t, b1));
+        t = _mm_set1_ps(a[1]);
+        c10 = _mm_add_ps(c10, _mm_mul_ps(t, b0)); c11 = _mm_add_ps(c11, _mm_mul_ps(t, b1));
+        t = _mm_set1_ps(a[2]);
+        c20 = _mm_add_ps(c20, _mm_mul_ps(t, b0)); c21 = _mm_add_ps(c21, _mm_mul_ps(t, b1));
+        t = _mm_set1_ps(a[3]);
+        c30 = _mm_add_ps(c30, _mm_mul_ps(t, b0)); c31 = _mm_add_ps(c31, _mm_mul_ps(t, b1));
+    }
+    _mm_storeu_ps(ab, c00); _mm_storeu_ps(ab + 4, c01);
+    _mm_storeu_ps(ab + 8, c10); _mm_storeu_ps(ab + 12, c11);
+    _mm_storeu_ps(ab + 16, c20); _mm_storeu_ps(ab + 20, c21);
+    _mm_storeu_ps(ab + 24, c30); _mm_storeu_ps(ab + 28, c31);
+}
+
+static void GEMMMicroKernel_64f_SSE2( int kc, const double* a, const double* b, double* ab )
+{
+    __m128d c00 = _mm_setzero_pd(), c01 = c00, c10 = c00, c11 = c00,
+            c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+    for( ; kc > 0; kc--, a += 4, b += 4 )
+    {
+        __m128d b0 = _mm_load_pd(b), b1 = _mm_load_pd(b + 2), t;
+        t = _mm_set1_pd(a[0]);
+        c00 = _mm_add_pd(c00, _mm_mul_pd(t, b0)); c01 = _mm_add_pd(c01, _mm_mul_pd(t, b1));
+        t = _mm_set1_pd(a[1]);
+        c10 = _mm_add_pd(c10, _mm_mul_pd(t, b0)); c11 = _mm_add_pd(c11, _mm_mul_pd(t, b1));
+        t = _mm_set1_pd(a[2]);
+        c20 = _mm_add_pd(c20, _mm_mul_pd(t, b0)); c21 = _mm_add_pd(c21, _mm_mul_pd(t, b1));
+        t = _mm_set1_pd(a[3]);
+        c30 = _mm_add_pd(c30, _mm_mul_pd(t, b0)); c31 = _mm_add_pd(c31, _mm_mul_pd(t, b1));
+    }
+    _mm_storeu_pd(ab, c00); _mm_storeu_pd(ab + 2, c01);
+    _mm_storeu_pd(ab + 4, c10); _mm_storeu_pd(ab + 6, c11);
+    _mm_storeu_pd(ab + 8, c20); _mm_storeu_pd(ab + 10, c21);
+    _mm_storeu_pd(ab + 12, c30); _mm_storeu_pd(ab + 14, c31);
+}
+
+#endif
+
+static GEMMPackedKernel<float> getGEMMPackedKernel32f()
+{
+#ifdef HAVE_DISPATCH_AVX
+    if( checkHardwareSupport(CV_CPU_AVX) )
+        return GEMMPackedKernel<float>(6, 16, opt_AVX::gemmKernel32f);
+#endif
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+        return GEMMPackedKernel<float>(4, 8, GEMMMicroKernel_32f_SSE2);
+#endif
+    return GEMMPackedKernel<float>(4, 4, GEMMMicroKernel<float, 4, 4>);
+}
+
+static GEMMPackedKernel<double> getGEMMPackedKernel64f()
+{
+#ifdef HAVE_DISPATCH_AVX
+    if( checkHardwareSupport(CV_CPU_AVX) )
+        return GEMMPackedKernel<double>(6, 8, opt_AVX::gemmKernel64f);
+#endif
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+        return GEMMPackedKernel<double>(4, 4, GEMMMicroKernel_64f_SSE2);
+#endif
+    return GEMMPackedKernel<double>(4, 4, GEMMMicroKernel<double, 4, 4>);
+}
+
+// copies the mc x kc block of A, A(i,k) = a[i*step0 + k*step1], into mr-row slivers
+template<typename T> static void
+GEMMPackA( const T* a, size_t step0, size_t step1, int mc, int kc, int mr, T* dst )
+{
+    for( int i = 0; i < mc; i += mr )
+    {
+        int r, m = std::min(mr, mc - i);
+        for( int p = 0; p < kc; p++, dst += mr )
+        {
+            const T* src = a + i*step0 + p*step1;
+            for( r = 0; r < m; r++ )
+                dst[r] = src[r*step0];
+            for( ; r < mr; r++ )
+                dst[r] = 0;
+        }
+    }
+}
+
+// copies the kc x nc block of B, B(k,j) = b[k*step0 + j*step1], into nr-column slivers
+template<typename T> static void
+GEMMPackB( const T* b, size_t step0, size_t step1, int kc, int nc, int nr, T* dst )
+{
+    for( int j = 0; j < nc; j += nr )
+    {
+        int c, n = std::min(nr, nc - j);
+        for( int p = 0; p < kc; p++, dst += nr )
+        {
+            const T* src = b + p*step0 + j*step1;
+            if( step1 == 1 )
+                for( c = 0; c < n; c++ )
+                    dst[c] = src[c];
+            else
+                for( c = 0; c < n; c++ )
+                    dst[c] = src[c*step1];
+            for( ; c < nr; c++ )
+                dst[c] = 0;
+        }
+    }
+}
+
+template<typename T> class GEMMPackedInvoker
+{
+public:
+    GEMMPackedInvoker( const T* _a, size_t _astep0, size_t _astep1, const T* _bpack,
+                       const T* _c, size_t _cstep0, size_t _cstep1, T* _d, size_t _dstep,
+                       int _m, int _nc, int _kc, int _mc, T _alpha, T _beta, bool _first,
+                       GEMMPackedKernel<T> _kernel )
+        : a(_a), astep0(_astep0), astep1(_astep1), bpack(_bpack),
+          c(_c), cstep0(_cstep0), cstep1(_cstep1), d(_d), dstep(_dstep),
+          m(_m), nc(_nc), kc(_kc), mc(_mc), alpha(_alpha), beta(_beta), first(_first),
+          kernel(_kernel)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int mr = kernel.mr, nr = kernel.nr;
+        AutoBuffer<T> _buf(mc*kc + mr*nr + 64/sizeof(T));
+        T* apack = alignPtr((T*)_buf, 64);
+        T* ab = apack + mc*kc;
+
+        for( int ib = range.begin(); ib < range.end(); ib++ )
+        {
+            int i0 = ib*mc, mb = std::min(mc, m - i0);
+            GEMMPackA(a + i0*astep0, astep0, astep1, mb, kc, mr, apack);
+
+            for( int j = 0; j < nc; j += nr )
+                for( int i = 0; i < mb; i += mr )
+                {
+                    kernel.func(kc, apack + i*kc, bpack + j*kc, ab);
+                    store(ab, i0 + i, j, std::min(mr, mb - i), std::min(nr, nc - j));
+                }
+        }
+    }
+
+private:
+    // D = alpha*AB + beta*C after the first kc block, D += alpha*AB after the next ones
+    void store( const T* ab, int i0, int j0, int mb, int nb ) const
+    {
+        int nr = kernel.nr;
+        for( int i = 0; i < mb; i++, ab += nr )
+        {
+            T* drow = d + (i0 + i)*dstep + j0;
+            if( !first )
+                for( int j = 0; j < nb; j++ )
+                    drow[j] += alpha*ab[j];
+            else if( c )
+            {
+                const T* crow = c + (i0 + i)*cstep0 + j0*cstep1;
+                for( int j = 0; j < nb; j++ )
+                    drow[j] = alpha*ab[j] + beta*crow[j*cstep1];
+            }
+            else
+                for( int j = 0; j < nb; j++ )
+                    drow[j] = alpha*ab[j];
+        }
+    }
+
+    const T* a;
+    size_t astep0, astep1;
+    const T* bpack;
+    const T* c;
+    size_t cstep0, cstep1;
+    T* d;
+    size_t dstep;
+    int m, nc, kc, mc;
+    T alpha, beta;
+    bool first;
+    GEMMPackedKernel<T> kernel;
+};
+
+template<typename T> static void
+GEMMPacked( const Mat& A, const Mat& B, const Mat& C, Mat& D, int len,
+            double alpha, double beta, int flags, GEMMPackedKernel<T> kernel )
+{
+    const size_t esz = sizeof(T);
+    size_t astep0 = A.step/esz, astep1 = 1, bstep0 = B.step/esz, bstep1 = 1;
+    size_t cstep0 = 0, cstep1 = 0, dstep = D.step/esz;
+    const T* c = 0;
+    int m = D.rows, n = D.cols, mr = kernel.mr, nr = kernel.nr;
+
+    if( flags & GEMM_1_T )
+        std::swap(astep0, astep1);
+    if( flags & GEMM_2_T )
+        std::swap(bstep0, bstep1);
+    if( C.data && beta != 0 )
+    {
+        c = (const T*)C.data;
+        cstep0 = C.step/esz, cstep1 = 1;
+        if( flags & GEMM_3_T )
+            std::swap(cstep0, cstep1);
+    }
+
+    // kc x mc block of A should stay in L2, kc x nc panel of B in L3
+    int kc0 = std::min(len, 1024/(int)esz);
+    int nc0 = std::min(2048/nr*nr, (n + nr - 1)/nr*nr);
+    int mc = std::min(128/mr*mr, (m + mr - 1)/mr*mr);
+    int nthreads = getNumThreads();
+    if( (m + mc - 1)/mc < nthreads )
+        mc = std::max((m + nthreads - 1)/nthreads + mr - 1, mr)/mr*mr;
+    int nblocks = (m + mc - 1)/mc;
+
+    AutoBuffer<T> _bbuf(kc0*nc0 + 64/esz);
+    T* bpack = alignPtr((T*)_bbuf, 64);
+
+    for( int jc = 0; jc < n; jc += nc0 )
+    {
+        int nc = std::min(nc0, n - jc);
+        for( int pc = 0; pc < len; pc += kc0 )
+        {
+            int kc = std::min(kc0, len - pc);
+            GEMMPackB((const T*)B.data + pc*bstep0 + jc*bstep1, bstep0, bstep1, kc, nc, nr, bpack);
+            parallel_for(BlockedRange(0, nblocks),
+                GEMMPackedInvoker<T>((const T*)A.data + pc*astep1, astep0, astep1, bpack,
+                                     c ? c + jc*cstep1 : 0, cstep0, cstep1,
+                                     (T*)D.data + jc, dstep, m, nc, kc, mc,
+                                     (T)alpha, (T)beta, pc == 0, kernel));
+        }
+    }
+}
+
+#ifdef HAVE_CBLAS
+
+// D = alpha*op(A)*op(B) + beta*op(C) through the external BLAS
+static void
+GEMMCBLAS( const Mat& A, const Mat& B, const Mat& C, Mat& D, int len,
+           double alpha, double beta, int flags )
+{
+    int type = A.type(), esz = (int)A.elemSize();
+    CBLAS_TRANSPOSE transa = (flags & GEMM_1_T) ? CblasTrans : CblasNoTrans;
+    CBLAS_TRANSPOSE transb = (flags & GEMM_2_T) ? CblasTrans : CblasNoTrans;
+    int lda = (int)(A.step/esz), ldb = (int)(B.step/esz), ldd = (int)(D.step/esz);
+
+    if( C.data && beta != 0 )
+    {
+        if( flags & GEMM_3_T )
+            transpose(C, D);
+        else if( C.data != D.data )
+            C.copyTo(D);
+    }
+    else
+        beta = 0;
+
+    if( type == CV_32FC1 )
+        cblas_sgemm(CblasRowMajor, transa, transb, D.rows, D.cols, len, (float)alpha,
+                    (const float*)A.data, lda, (const float*)B.data, ldb,
+                    (float)beta, (float*)D.data, ldd);
+    else if( type == CV_64FC1 )
+        cblas_dgemm(CblasRowMajor, transa, transb, D.rows, D.cols, len, alpha,
+                    (const double*)A.data, lda, (const double*)B.data, ldb,
+                    beta, (double*)D.data, ldd);
+    else if( type == CV_32FC2 )
+    {
+        Complexf _alpha((float)alpha, 0.f), _beta((float)beta, 0.f);
+        cblas_cgemm(CblasRowMajor, transa, transb, D.rows, D.cols, len, &_alpha,
+                    A.data, lda, B.data, ldb, &_beta, D.data, ldd);
+    }
+    else
+    {
+        Complexd _alpha(alpha, 0.), _beta(beta, 0.);
+        cblas_zgemm(CblasRowMajor, transa, transb, D.rows, D.cols, len, &_alpha,
+                    A.data, lda, B.data, ldb, &_beta, D.data, ldd);
+    }
+}
+
+#endif
+
 }
 
 void cv::gemm( InputArray matA, InputArray matB, double alpha,
            InputArray matC, double beta, OutputArray matD, int flags )
 {
+    CV_TRACE_REGION("cv::gemm");
     const int block_lin_size = 128;
     const int block_size = block_lin_size * block_lin_size;
 
@@ -1046,69 +1369,20 @@ void cv::gemm( InputArray matA, InputArray matB, double alpha,
         flags |= GEMM_2_T;
     }
 
-    /*if( (d_size.width | d_size.height | len) >= 16 && icvBLAS_GEMM_32f_p != 0 )
-    {
-        blas_func = type == CV_32FC1 ? (icvBLAS_GEMM_32f_t)icvBLAS_GEMM_32f_p :
-                    type == CV_64FC1 ? (icvBLAS_GEMM_32f_t)icvBLAS_GEMM_64f_p :
-                    type == CV_32FC2 ? (icvBLAS_GEMM_32f_t)icvBLAS_GEMM_32fc_p :
-                    type == CV_64FC2 ? (icvBLAS_GEMM_32f_t)icvBLAS_GEMM_64fc_p : 0;
-    }
-
-    if( blas_func )
-    {
-        const char* transa = flags & GEMM_1_T ? "t" : "n";
-        const char* transb = flags & GEMM_2_T ? "t" : "n";
-        int lda, ldb, ldd;
+    // the packed kernels (or the external BLAS) pay off once the product is not tiny
+    bool large = d_size.width >= 8 && d_size.height >= 8 && len >= 8 &&
+        (double)d_size.width*d_size.height*len >= 48.*48*48;
 
-        if( C->data.ptr )
-        {
-            if( C->data.ptr != D->data.ptr )
-            {
-                if( !(flags & GEMM_3_T) )
-                    cvCopy( C, D );
-                else
-                    cvTranspose( C, D );
-            }
-        }
-
-        if( CV_MAT_DEPTH(type) == CV_32F )
-        {
-            Complex32f _alpha, _beta;
-
-            lda = A->step/sizeof(float);
-            ldb = b_step/sizeof(float);
-            ldd = D->step/sizeof(float);
-            _alpha.re = (float)alpha;
-            _alpha.im = 0;
-            _beta.re = C->data.ptr ? (float)beta : 0;
-            _beta.im = 0;
-            if( CV_MAT_CN(type) == 2 )
-                lda /= 2, ldb /= 2, ldd /= 2;
-
-            blas_func( transb, transa, &d_size.width, &d_size.height, &len,
-                   &_alpha, B->data.ptr, &ldb, A->data.ptr, &lda,
-                   &_beta, D->data.ptr, &ldd );
-        }
-        else
-        {
-            CvComplex64f _alpha, _beta;
-
-            lda = A->step/sizeof(double);
-            ldb = b_step/sizeof(double);
-            ldd = D->step/sizeof(double);
-            _alpha.re = alpha;
-            _alpha.im = 0;
-            _beta.re = C->data.ptr ? beta : 0;
-            _beta.im = 0;
-            if( CV_MAT_CN(type) == 2 )
-                lda /= 2, ldb /= 2, ldd /= 2;
-
-            blas_func( transb, transa, &d_size.width, &d_size.height, &len,
-                   &_alpha, B->data.ptr, &ldb, A->data.ptr, &lda,
-                   &_beta, D->data.ptr, &ldd );
-        }
-    }
-    else*/ if( ((d_size.height <= block_lin_size/2 || d_size.width <= block_lin_size/2) &&
+#ifdef HAVE_CBLAS
+    if( large )
+        GEMMCBLAS( A, B, C, *matD, len, alpha, beta, flags );
+    else
+#endif
+    if( large && type == CV_32FC1 )
+        GEMMPacked<float>( A, B, C, *matD, len, alpha, beta, flags, getGEMMPackedKernel32f() );
+    else if( large && type == CV_64FC1 )
+        GEMMPacked<double>( A, B, C, *matD, len, alpha, beta, flags, getGEMMPackedKernel64f() );
+    else if( ((d_size.height <= block_lin_size/2 || d_size.width <= block_lin_size/2) &&
         len <= 10000) || len <= 10 ||
         (d_size.width <= block_lin_size &&
         d_size.height <= block_lin_size && len <= block_lin_size) )
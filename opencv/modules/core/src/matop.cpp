@@ -203,6 +203,26 @@ public:
 };
 
 static MatOp_Initializer g_MatOp_Initializer;
+
+class MatOp_Fused : public MatOp
+{
+public:
+    MatOp_Fused() {}
+    virtual ~MatOp_Fused() {}
+    
+    bool elementWise(const MatExpr& /*expr*/) const { return true; }
+    void assign(const MatExpr& expr, Mat& m, int type=-1) const;
+    
+    void roi(const MatExpr& expr, const Range& rowRange, const Range& colRange, MatExpr& res) const;
+    void diag(const MatExpr& expr, int d, MatExpr& res) const;
+    
+    static void makeExpr(MatExpr& res, const Ptr<MatExprProgram>& prog);
+    static bool makeExpr(MatExpr& res, int op, const MatExpr& e1, const MatExpr& e2, double scale=1);
+    static bool makeExpr(MatExpr& res, int op, const MatExpr& e, const Scalar& s);
+    static bool augAssign(int op, const MatExpr& expr, Mat& m);
+};
+
+static MatOp_Fused g_MatOp_Fused;
     
 static inline bool isIdentity(const MatExpr& e) { return e.op == &g_MatOp_Identity; }
 static inline bool isAddEx(const MatExpr& e) { return e.op == &g_MatOp_AddEx; }
@@ -216,6 +236,7 @@ static inline bool isSolve(const MatExpr& e) { return e.op == &g_MatOp_Solve; }
 static inline bool isGEMM(const MatExpr& e) { return e.op == &g_MatOp_GEMM; }
 static inline bool isMatProd(const MatExpr& e) { return e.op == &g_MatOp_GEMM && (!e.c.data || e.beta == 0); }
 static inline bool isInitializer(const MatExpr& e) { return e.op == &g_MatOp_Initializer; }
+static inline bool isFused(const MatExpr& e) { return e.op == &g_MatOp_Fused; }
     
 /////////////////////////////////////////////////////////////////////////////////////////////////////
     
@@ -269,6 +290,8 @@ void MatOp::diag(const MatExpr& expr, int d, MatExpr& e) const
     
 void MatOp::augAssignAdd(const MatExpr& expr, Mat& m) const
 {
+    if( MatOp_Fused::augAssign(ARITHM_ADD, expr, m) )
+        return;
     Mat temp;
     expr.op->assign(expr, temp);
     m += temp;
@@ -277,6 +300,8 @@ void MatOp::augAssignAdd(const MatExpr& expr, Mat& m) const
     
 void MatOp::augAssignSubtract(const MatExpr& expr, Mat& m) const
 {
+    if( MatOp_Fused::augAssign(ARITHM_SUB, expr, m) )
+        return;
     Mat temp;
     expr.op->assign(expr, temp);
     m -= temp;
@@ -293,6 +318,8 @@ void MatOp::augAssignMultiply(const MatExpr& expr, Mat& m) const
     
 void MatOp::augAssignDivide(const MatExpr& expr, Mat& m) const
 {
+    if( MatOp_Fused::augAssign(ARITHM_DIV, expr, m) )
+        return;
     Mat temp;
     expr.op->assign(expr, temp);
     m /= temp;
@@ -327,6 +354,9 @@ void MatOp::add(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 {
     if( this == e2.op )
     {
+        if( MatOp_Fused::makeExpr(res, ARITHM_ADD, e1, e2) )
+            return;
+        
         double alpha = 1, beta = 1;
         Scalar s;
         Mat m1, m2;
@@ -356,6 +386,8 @@ void MatOp::add(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
     
 void MatOp::add(const MatExpr& expr1, const Scalar& s, MatExpr& res) const
 {
+    if( MatOp_Fused::makeExpr(res, ARITHM_ADD, expr1, s) )
+        return;
     Mat m1;
     expr1.op->assign(expr1, m1);
     MatOp_AddEx::makeExpr(res, m1, Mat(), 1, 0, s);
@@ -366,6 +398,9 @@ void MatOp::subtract(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 {
     if( this == e2.op )
     {
+        if( MatOp_Fused::makeExpr(res, ARITHM_SUB, e1, e2) )
+            return;
+        
         double alpha = 1, beta = -1;
         Scalar s;
         Mat m1, m2;
@@ -395,6 +430,8 @@ void MatOp::subtract(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
     
 void MatOp::subtract(const Scalar& s, const MatExpr& expr, MatExpr& res) const
 {
+    if( MatOp_Fused::makeExpr(res, ARITHM_SUB, expr, s) )
+        return;
     Mat m;
     expr.op->assign(expr, m);
     MatOp_AddEx::makeExpr(res, m, Mat(), -1, 0, s);
@@ -405,6 +442,9 @@ void MatOp::multiply(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double
 {
     if( this == e2.op )
     {
+        if( MatOp_Fused::makeExpr(res, ARITHM_MUL, e1, e2, scale) )
+            return;
+        
         Mat m1, m2;
         
         if( isReciprocal(e1) )
@@ -454,6 +494,8 @@ void MatOp::multiply(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double
     
 void MatOp::multiply(const MatExpr& expr, double s, MatExpr& res) const
 {
+    if( MatOp_Fused::makeExpr(res, ARITHM_MUL, expr, Scalar(s)) )
+        return;
     Mat m;
     expr.op->assign(expr, m);
     MatOp_AddEx::makeExpr(res, m, Mat(), s, 0); 
@@ -464,6 +506,9 @@ void MatOp::divide(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double sc
 {
     if( this == e2.op )
     {
+        if( MatOp_Fused::makeExpr(res, ARITHM_DIV, e1, e2, scale) )
+            return;
+        
         if( isReciprocal(e1) && isReciprocal(e2) )
             MatOp_Bin::makeExpr(res, '/', e2.a, e1.a, e1.alpha/e2.alpha);
         else
@@ -502,6 +547,8 @@ void MatOp::divide(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double sc
     
 void MatOp::divide(double s, const MatExpr& expr, MatExpr& res) const
 {
+    if( MatOp_Fused::makeExpr(res, ARITHM_RECIP, expr, Scalar(s)) )
+        return;
     Mat m;
     expr.op->assign(expr, m);
     MatOp_Bin::makeExpr(res, '/', m, Mat(), s);
@@ -510,6 +557,8 @@ void MatOp::divide(double s, const MatExpr& expr, MatExpr& res) const
     
 void MatOp::abs(const MatExpr& expr, MatExpr& res) const
 {
+    if( MatOp_Fused::makeExpr(res, ARITHM_ABSDIFF, expr, Scalar()) )
+        return;
     Mat m;
     expr.op->assign(expr, m);
     MatOp_Bin::makeExpr(res, 'a', m, Mat());
@@ -1572,6 +1621,420 @@ inline void MatOp_Initializer::makeExpr(MatExpr& res, int method, Size sz, int t
 }    
 
     
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ Fused element-wise expressions.
+
+ When two element-wise expressions are combined and one of them can not be folded into
+ MatOp_AddEx or MatOp_Bin, the old rules evaluate it into a temporary matrix. Instead, both
+ operands are compiled into a MatExprProgram: the list of nodes in the evaluation order, where
+ every node is an input array, a constant, or one of the arithm.cpp kernels applied to two
+ earlier nodes. MatOp_Fused::assign runs the whole list on one block of elements at a time,
+ so each input is read once and the intermediate results stay in a few block-sized buffers.
+
+ Only floating-point expressions, where all the arrays have the same size and type, are fused.
+ The kernels and their parameters are the same as in the step-by-step evaluation, so is
+ the result. Integer expressions saturate the intermediate results and keep the old path.
+*/
+
+class CV_EXPORTS MatExprProgram
+{
+public:
+    enum { ARG = -1, CONST = -2 };
+    
+    struct Node
+    {
+        int op;          // ARG, CONST or one of ARITHM_*
+        int src1, src2;  // the operand nodes; for ARG src1 is the index in args
+        double param[3]; // the scale or {alpha, beta, gamma}, passed to the kernel
+        Scalar s;        // the value of CONST
+    };
+    
+    int arg(const Mat& m);
+    int constant(const Scalar& s);
+    int node(int op, int src1, int src2, double p0=1, double p1=0, double p2=0);
+    int append(const MatExprProgram& prog);
+    int compile(const MatExpr& e);
+    
+    int type() const { return args[0].type(); }
+    int allocate(vector<int>& bufIdx) const;
+    void run(Mat& dst) const;
+    string str() const;
+    
+    vector<Mat> args;
+    vector<Node> nodes;
+};
+
+template<> void Ptr<MatExprProgram>::delete_obj()
+{
+    delete obj;
+}
+
+static bool isSameArray(const Mat& a, const Mat& b)
+{
+    if( a.data != b.data || a.size != b.size )
+        return false;
+    for( int i = 0; i < a.dims; i++ )
+        if( a.step[i] != b.step[i] )
+            return false;
+    return true;
+}
+
+int MatExprProgram::arg(const Mat& m)
+{
+    // the same array used twice, as in a.mul(a) + a, is read once
+    for( size_t i = 0; i < nodes.size(); i++ )
+        if( nodes[i].op == ARG && isSameArray(args[nodes[i].src1], m) )
+            return (int)i;
+    args.push_back(m);
+    return node(ARG, (int)args.size() - 1, -1);
+}
+
+int MatExprProgram::constant(const Scalar& s)
+{
+    int idx = node(CONST, -1, -1);
+    nodes[idx].s = s;
+    return idx;
+}
+
+int MatExprProgram::node(int op, int src1, int src2, double p0, double p1, double p2)
+{
+    Node n;
+    n.op = op;
+    n.src1 = src1;
+    n.src2 = src2;
+    n.param[0] = p0;
+    n.param[1] = p1;
+    n.param[2] = p2;
+    nodes.push_back(n);
+    return (int)nodes.size() - 1;
+}
+
+int MatExprProgram::append(const MatExprProgram& prog)
+{
+    vector<int> idx(prog.nodes.size());
+    for( size_t i = 0; i < prog.nodes.size(); i++ )
+    {
+        const Node& n = prog.nodes[i];
+        if( n.op == ARG )
+            idx[i] = arg(prog.args[n.src1]);
+        else if( n.op == CONST )
+            idx[i] = constant(n.s);
+        else
+            idx[i] = node(n.op, idx[n.src1], idx[n.src2], n.param[0], n.param[1], n.param[2]);
+    }
+    return idx.back();
+}
+
+// mirrors MatOp_AddEx::assign and MatOp_Bin::assign; returns the node holding the result
+int MatExprProgram::compile(const MatExpr& e)
+{
+    if( isFused(e) )
+        return append(*e.prog);
+    
+    int a = arg(e.a);
+    if( isIdentity(e) )
+        return a;
+    
+    if( isAddEx(e) )
+    {
+        bool realS = e.s.isReal();
+        if( e.b.data )
+        {
+            int b = arg(e.b), r;
+            if( e.s != Scalar() && realS )
+                return node(ARITHM_ADD_WEIGHTED, a, b, e.alpha, e.beta, e.s[0]);
+            if( e.alpha == 1 && e.beta == 1 )
+                r = node(ARITHM_ADD, a, b);
+            else if( e.alpha == 1 && e.beta == -1 )
+                r = node(ARITHM_SUB, a, b);
+            else if( e.alpha == -1 && e.beta == 1 )
+                r = node(ARITHM_SUB, b, a);
+            else
+                r = node(ARITHM_ADD_WEIGHTED, a, b, e.alpha, e.beta, 0);
+            return realS ? r : node(ARITHM_ADD, r, constant(e.s));
+        }
+        if( e.s == Scalar() )
+            return e.alpha == 1 ? a : node(ARITHM_ADD_WEIGHTED, a, a, e.alpha, 0, 0);
+        if( e.alpha == 1 )
+            return node(ARITHM_ADD, a, constant(e.s));
+        if( e.alpha == -1 )
+            return node(ARITHM_SUB, constant(e.s), a);
+        if( realS )
+            return node(ARITHM_ADD_WEIGHTED, a, a, e.alpha, 0, e.s[0]);
+        return node(ARITHM_ADD, node(ARITHM_ADD_WEIGHTED, a, a, e.alpha, 0, 0), constant(e.s));
+    }
+    
+    CV_Assert( e.op == &g_MatOp_Bin );
+    switch( e.flags )
+    {
+    case '*':
+        return node(ARITHM_MUL, a, arg(e.b), e.alpha);
+    case '/':
+        return e.b.data ? node(ARITHM_DIV, a, arg(e.b), e.alpha) : node(ARITHM_RECIP, a, a, e.alpha);
+    case 'm':
+    case 'M':
+        return node(e.flags == 'm' ? ARITHM_MIN : ARITHM_MAX, a,
+                    e.b.data ? arg(e.b) : constant(Scalar::all(e.s[0])));
+    case 'a':
+        return node(ARITHM_ABSDIFF, a, e.b.data ? arg(e.b) : constant(e.s));
+    default:
+        CV_Error(CV_StsError, "Unknown operation");
+    }
+    return -1;
+}
+
+// assigns the block buffers to the nodes; a buffer is reused as soon as the last node reading it is done.
+// the final node writes to the destination directly and does not get a buffer
+int MatExprProgram::allocate(vector<int>& bufIdx) const
+{
+    int i, nnodes = (int)nodes.size(), nbufs = 0;
+    vector<int> lastUse(nnodes, -1), pool;
+    bufIdx.assign(nnodes, -1);
+    
+    for( i = 0; i < nnodes; i++ )
+        if( nodes[i].op >= 0 )
+            lastUse[nodes[i].src1] = lastUse[nodes[i].src2] = i;
+    
+    for( i = 0; i < nnodes - 1; i++ )
+    {
+        const Node& n = nodes[i];
+        if( n.op == ARG )
+            continue;
+        if( n.op >= 0 )
+        {
+            if( nodes[n.src1].op >= 0 && lastUse[n.src1] == i )
+                pool.push_back(bufIdx[n.src1]);
+            if( n.src2 != n.src1 && nodes[n.src2].op >= 0 && lastUse[n.src2] == i )
+                pool.push_back(bufIdx[n.src2]);
+        }
+        if( n.op == CONST || pool.empty() )
+            bufIdx[i] = nbufs++;
+        else
+        {
+            bufIdx[i] = pool.back();
+            pool.pop_back();
+        }
+    }
+    return nbufs;
+}
+
+void MatExprProgram::run(Mat& dst) const
+{
+    int i, nargs = (int)args.size(), nnodes = (int)nodes.size();
+    CV_Assert( nnodes > 0 && nodes[nnodes-1].op >= 0 );
+    
+    int type = args[0].type(), depth = CV_MAT_DEPTH(type), cn = CV_MAT_CN(type);
+    size_t esz = CV_ELEM_SIZE(type);
+    dst.create(args[0].dims, args[0].size, type);
+    
+    vector<int> bufIdx;
+    int nbufs = allocate(bufIdx);
+    
+    vector<const Mat*> arrays(nargs + 2);
+    vector<uchar*> ptrs(nargs + 1);
+    for( i = 0; i < nargs; i++ )
+        arrays[i] = &args[i];
+    arrays[nargs] = &dst;
+    arrays[nargs+1] = 0;
+    
+    NAryMatIterator it(&arrays[0], &ptrs[0]);
+    // 4K per buffer keeps the intermediate results of a typical chain in L1
+    size_t total = it.size, blocksize = std::min(total, (size_t)(BLOCK_SIZE*4 + esz - 1)/esz);
+    size_t bufstep = alignSize(blocksize*esz, 16);
+    AutoBuffer<uchar> _buf(bufstep*nbufs + 16);
+    uchar* buf = alignPtr((uchar*)_buf, 16);
+    
+    vector<BinaryFunc> funcs(nnodes);
+    vector<const uchar*> vals(nnodes);
+    for( i = 0; i < nnodes; i++ )
+    {
+        const Node& n = nodes[i];
+        if( n.op >= 0 )
+            funcs[i] = getArithmFunc(n.op, depth);
+        else if( n.op == CONST )
+        {
+            vals[i] = buf + bufstep*bufIdx[i];
+            convertAndUnrollScalar(Mat(cn, 1, CV_64F, (void*)n.s.val), type, (uchar*)vals[i], blocksize);
+        }
+    }
+    
+    for( size_t p = 0; p < it.nplanes; p++, ++it )
+    {
+        for( size_t j = 0; j < total; j += blocksize )
+        {
+            int bsz = (int)std::min(total - j, blocksize);
+            Size bszn(bsz*cn, 1);
+            
+            for( i = 0; i < nnodes; i++ )
+            {
+                const Node& n = nodes[i];
+                if( n.op == ARG )
+                    vals[i] = ptrs[n.src1] + j*esz;
+                else if( n.op >= 0 )
+                {
+                    uchar* dptr = i < nnodes - 1 ? buf + bufstep*bufIdx[i] : ptrs[nargs] + j*esz;
+                    funcs[i]( vals[n.src1], 0, vals[n.src2], 0, dptr, 0, bszn, (void*)n.param );
+                    vals[i] = dptr;
+                }
+            }
+        }
+    }
+}
+
+string MatExprProgram::str() const
+{
+    static const char* names[] =
+    { "add", "sub", "mul", "div", "recip", "absdiff", "min", "max", "addWeighted" };
+    int i, nnodes = (int)nodes.size(), nkernels = 0;
+    vector<int> bufIdx;
+    int nbufs = allocate(bufIdx);
+    
+    for( i = 0; i < nnodes; i++ )
+        nkernels += nodes[i].op >= 0;
+    
+    string str = format("fused %s expression: %d input(s), %d kernel(s), %d block buffer(s), one pass\n",
+                        args[0].depth() == CV_32F ? "32F" : "64F", (int)args.size(), nkernels, nbufs);
+    for( i = 0; i < nnodes; i++ )
+    {
+        const Node& n = nodes[i];
+        string dst = i < nnodes - 1 ? format("v%d", i) : string("dst");
+        if( n.op == ARG )
+            str += format("  %s = input %d\n", dst.c_str(), n.src1);
+        else if( n.op == CONST )
+            str += format("  %s = const (%g, %g, %g, %g)\n", dst.c_str(), n.s[0], n.s[1], n.s[2], n.s[3]);
+        else if( n.op == ARITHM_ADD_WEIGHTED )
+            str += format("  %s = %s(v%d, v%d; %g, %g, %g)\n", dst.c_str(), names[n.op],
+                          n.src1, n.src2, n.param[0], n.param[1], n.param[2]);
+        else if( n.op == ARITHM_MUL || n.op == ARITHM_DIV || n.op == ARITHM_RECIP )
+            str += format("  %s = %s(v%d, v%d; %g)\n", dst.c_str(), names[n.op],
+                          n.src1, n.src2, n.param[0]);
+        else
+            str += format("  %s = %s(v%d, v%d)\n", dst.c_str(), names[n.op], n.src1, n.src2);
+    }
+    return str;
+}
+
+static bool isFusible(const MatExpr& e, const Mat& ref)
+{
+    int depth = ref.depth();
+    if( ref.empty() || (depth != CV_32F && depth != CV_64F) || ref.channels() > 4 )
+        return false;
+    if( !isIdentity(e) && !isFused(e) && !isAddEx(e) &&
+        !(e.op == &g_MatOp_Bin && e.flags != 0 && strchr("*/mMa", e.flags) != 0) )
+        return false;
+    return e.a.type() == ref.type() && e.a.size == ref.size &&
+        (!e.b.data || (e.b.type() == ref.type() && e.b.size == ref.size));
+}
+
+// the operands that MatOp::add/subtract and MatOp::multiply/divide take without evaluation
+static inline bool isAddOperand(const MatExpr& e)
+{ return isIdentity(e) || (isAddEx(e) && (!e.b.data || e.beta == 0)); }
+static inline bool isMulOperand(const MatExpr& e)
+{ return isIdentity(e) || isScaled(e) || isReciprocal(e); }
+
+void MatOp_Fused::assign(const MatExpr& e, Mat& m, int type) const
+{
+    if( type == -1 || type == e.prog->type() )
+        e.prog->run(m);
+    else
+    {
+        Mat temp;
+        e.prog->run(temp);
+        temp.convertTo(m, type);
+    }
+}
+
+void MatOp_Fused::roi(const MatExpr& e, const Range& rowRange, const Range& colRange, MatExpr& res) const
+{
+    Ptr<MatExprProgram> prog = new MatExprProgram(*e.prog);
+    for( size_t i = 0; i < prog->args.size(); i++ )
+        prog->args[i] = prog->args[i](rowRange, colRange);
+    makeExpr(res, prog);
+}
+
+void MatOp_Fused::diag(const MatExpr& e, int d, MatExpr& res) const
+{
+    Ptr<MatExprProgram> prog = new MatExprProgram(*e.prog);
+    for( size_t i = 0; i < prog->args.size(); i++ )
+        prog->args[i] = prog->args[i].diag(d);
+    makeExpr(res, prog);
+}
+
+inline void MatOp_Fused::makeExpr(MatExpr& res, const Ptr<MatExprProgram>& prog)
+{
+    res = MatExpr(&g_MatOp_Fused, 0, prog->args[0]);
+    res.prog = prog;
+}
+
+bool MatOp_Fused::makeExpr(MatExpr& res, int op, const MatExpr& e1, const MatExpr& e2, double scale)
+{
+    if( op == ARITHM_ADD || op == ARITHM_SUB ? isAddOperand(e1) && isAddOperand(e2) :
+                                               isMulOperand(e1) && isMulOperand(e2) )
+        return false;
+    if( !isFusible(e1, e1.a) || !isFusible(e2, e1.a) )
+        return false;
+    
+    Ptr<MatExprProgram> prog = new MatExprProgram;
+    int i1 = prog->compile(e1), i2 = prog->compile(e2);
+    prog->node(op, i1, i2, scale);
+    makeExpr(res, prog);
+    return true;
+}
+
+bool MatOp_Fused::makeExpr(MatExpr& res, int op, const MatExpr& e, const Scalar& s)
+{
+    if( isIdentity(e) || !isFusible(e, e.a) )
+        return false;
+    
+    Ptr<MatExprProgram> prog = new MatExprProgram;
+    int i = prog->compile(e);
+    MatExprProgram::Node& n = prog->nodes[i];
+    
+    if( op == ARITHM_ADD || op == ARITHM_ABSDIFF )
+        prog->node(op, i, prog->constant(s));
+    else if( op == ARITHM_SUB )
+        prog->node(op, prog->constant(s), i);
+    else if( op == ARITHM_RECIP )
+        prog->node(op, i, i, s[0]);
+    else if( n.op == ARITHM_MUL || n.op == ARITHM_DIV || n.op == ARITHM_RECIP )
+        n.param[0] *= s[0];
+    else if( n.op == ARITHM_ADD_WEIGHTED )
+        n.param[0] *= s[0], n.param[1] *= s[0], n.param[2] *= s[0];
+    else
+        prog->node(ARITHM_ADD_WEIGHTED, i, i, s[0], 0, 0);
+    makeExpr(res, prog);
+    return true;
+}
+
+bool MatOp_Fused::augAssign(int op, const MatExpr& expr, Mat& m)
+{
+    if( isIdentity(expr) || !isFusible(expr, m) )
+        return false;
+    
+    MatExprProgram prog;
+    int i1 = prog.arg(m), i2 = prog.compile(expr);
+    prog.node(op, i1, i2);
+    prog.run(m);
+    return true;
+}
+
+string MatExpr::explain() const
+{
+    if( isFused(*this) )
+        return prog->str();
+    
+    string kind = !op ? "empty expression" : isIdentity(*this) ? "matrix" :
+        isAddEx(*this) ? "scaled sum, one pass" :
+        op == &g_MatOp_Bin ? format("element-wise operation '%c', one pass", flags) :
+        isCmp(*this) ? "comparison" : isGEMM(*this) ? "matrix product" :
+        isT(*this) ? "transposition" : isInv(*this) ? "inversion" :
+        isSolve(*this) ? "linear system" : isInitializer(*this) ? "initializer" :
+        "user operation";
+    return "not fused: " + kind + "\n";
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 MatExpr Mat::t() const
@@ -0,0 +1,92 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+
+/* The distance kernel of kmeans: the distances from one sample to a block of centers
+   are computed per call, so the dispatch cost is paid once per block. */
+
+#include "precomp.hpp"
+
+#if CV_AVX
+
+namespace cv
+{
+namespace opt_AVX
+{
+
+void batchDistL2Sqr32f( const float* a, const float* b, size_t bstep, int n, int dims, float* dist )
+{
+    for( int k = 0; k < n; k++, b += bstep )
+    {
+        __m256 s0 = _mm256_setzero_ps(), s1 = s0;
+        int j = 0;
+        for( ; j <= dims - 16; j += 16 )
+        {
+            __m256 t0 = _mm256_sub_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j));
+            __m256 t1 = _mm256_sub_ps(_mm256_loadu_ps(a + j + 8), _mm256_loadu_ps(b + j + 8));
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(t0, t0));
+            s1 = _mm256_add_ps(s1, _mm256_mul_ps(t1, t1));
+        }
+        for( ; j <= dims - 8; j += 8 )
+        {
+            __m256 t0 = _mm256_sub_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j));
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(t0, t0));
+        }
+        s0 = _mm256_add_ps(s0, s1);
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        float d = _mm_cvtss_f32(s);
+
+        for( ; j < dims; j++ )
+        {
+            float t = a[j] - b[j];
+            d += t*t;
+        }
+        dist[k] = d;
+    }
+}
+
+}
+}
+
+#endif
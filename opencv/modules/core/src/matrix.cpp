@@ -178,6 +178,352 @@ static void finalizeHdr(Mat& m)
 }
     
     
+/****************************************************************************************\
+*                                  Recycling allocator                                   *
+\****************************************************************************************/
+
+RecyclingMatAllocator::Stats::Stats()
+    : hits(0), misses(0), evictions(0), cachedBytes(0), cachedBuffers(0)
+{
+}
+
+struct RecyclingMatAllocator::Impl
+{
+    typedef std::map<size_t, vector<uchar*> > FreeLists;
+
+    Impl(size_t _maxCachedBytes, int _maxBuffersPerClass)
+        : maxCachedBytes(_maxCachedBytes), maxBuffersPerClass(_maxBuffersPerClass) {}
+
+    // rounds the size up to a multiple of 1/8 of the highest power of two not exceeding it
+    static size_t sizeClass(size_t size)
+    {
+        size_t granularity = 64;
+        while( granularity*16 <= size )
+            granularity *= 2;
+        return (size + granularity - 1) & ~(granularity - 1);
+    }
+
+    // frees the cached buffers exceeding the limits, starting from the largest ones
+    void shrink(size_t maxBytes, int maxBuffers)
+    {
+        for( FreeLists::reverse_iterator it = freeLists.rbegin(); it != freeLists.rend(); ++it )
+        {
+            vector<uchar*>& buffers = it->second;
+            while( !buffers.empty() &&
+                   ((int)buffers.size() > maxBuffers || stats.cachedBytes > maxBytes) )
+            {
+                fastFree(buffers.back());
+                buffers.pop_back();
+                stats.cachedBytes -= it->first;
+                stats.cachedBuffers--;
+            }
+        }
+    }
+
+    Mutex mutex;
+    FreeLists freeLists;
+    size_t maxCachedBytes;
+    int maxBuffersPerClass;
+    Stats stats;
+};
+
+RecyclingMatAllocator::RecyclingMatAllocator(size_t maxCachedBytes, int maxBuffersPerClass)
+{
+    impl = new Impl(maxCachedBytes, maxBuffersPerClass);
+}
+
+RecyclingMatAllocator::~RecyclingMatAllocator()
+{
+    trim();
+    delete impl;
+}
+
+void RecyclingMatAllocator::allocate(int dims, const int* sizes, int type, int*& refcount,
+                                     uchar*& datastart, uchar*& data, size_t* step)
+{
+    size_t total = CV_ELEM_SIZE(type);
+    for( int i = dims-1; i >= 0; i-- )
+    {
+        step[i] = total;
+        total *= sizes[i];
+    }
+
+    size_t bufSize = Impl::sizeClass(total);
+    uchar* buf = 0;
+    {
+        AutoLock lock(impl->mutex);
+        Impl::FreeLists::iterator it = impl->freeLists.find(bufSize);
+        if( it != impl->freeLists.end() && !it->second.empty() )
+        {
+            buf = it->second.back();
+            it->second.pop_back();
+            impl->stats.cachedBytes -= bufSize;
+            impl->stats.cachedBuffers--;
+            impl->stats.hits++;
+        }
+        else
+            impl->stats.misses++;
+    }
+
+    if( !buf )
+        buf = (uchar*)fastMalloc(bufSize + sizeof(*refcount));
+    datastart = data = buf;
+    refcount = (int*)(buf + bufSize);
+    *refcount = 1;
+}
+
+void RecyclingMatAllocator::deallocate(int* refcount, uchar* datastart, uchar*)
+{
+    size_t bufSize = (uchar*)refcount - datastart;
+    {
+        AutoLock lock(impl->mutex);
+        if( impl->stats.cachedBytes + bufSize <= impl->maxCachedBytes && impl->maxBuffersPerClass > 0 )
+        {
+            vector<uchar*>& buffers = impl->freeLists[bufSize];
+            if( (int)buffers.size() < impl->maxBuffersPerClass )
+            {
+                buffers.push_back(datastart);
+                impl->stats.cachedBytes += bufSize;
+                impl->stats.cachedBuffers++;
+                return;
+            }
+        }
+        impl->stats.evictions++;
+    }
+    fastFree(datastart);
+}
+
+void RecyclingMatAllocator::setLimits(size_t maxCachedBytes, int maxBuffersPerClass)
+{
+    AutoLock lock(impl->mutex);
+    impl->maxCachedBytes = maxCachedBytes;
+    impl->maxBuffersPerClass = maxBuffersPerClass;
+    impl->shrink(maxCachedBytes, maxBuffersPerClass);
+}
+
+void RecyclingMatAllocator::trim()
+{
+    AutoLock lock(impl->mutex);
+    impl->shrink(0, 0);
+}
+
+RecyclingMatAllocator::Stats RecyclingMatAllocator::getStats() const
+{
+    AutoLock lock(impl->mutex);
+    return impl->stats;
+}
+
+void RecyclingMatAllocator::resetStats()
+{
+    AutoLock lock(impl->mutex);
+    impl->stats.hits = impl->stats.misses = impl->stats.evictions = 0;
+}
+
+static MatAllocator* volatile defaultAllocator = 0;
+// set once any thread has installed its own default allocator
+static volatile bool useThreadAllocators = false;
+
+#if defined WIN32 || defined _WIN32 || defined WINCE
+#ifdef WINCE
+#	define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+
+static DWORD allocatorTlsKey = TLS_OUT_OF_INDEXES;
+
+static MatAllocator* getThreadAllocator()
+{
+    return allocatorTlsKey != TLS_OUT_OF_INDEXES ? (MatAllocator*)TlsGetValue(allocatorTlsKey) : 0;
+}
+
+static void setThreadAllocator(MatAllocator* allocator)
+{
+    if( allocatorTlsKey == TLS_OUT_OF_INDEXES )
+    {
+        DWORD key = TlsAlloc();
+        if( InterlockedCompareExchange((LONG volatile*)&allocatorTlsKey, (LONG)key,
+                                       (LONG)TLS_OUT_OF_INDEXES) != (LONG)TLS_OUT_OF_INDEXES )
+            TlsFree(key);
+    }
+    TlsSetValue(allocatorTlsKey, allocator);
+}
+#else
+static pthread_key_t allocatorTlsKey;
+static pthread_once_t allocatorTlsKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createAllocatorTlsKey()
+{
+    pthread_key_create(&allocatorTlsKey, 0);
+}
+
+static MatAllocator* getThreadAllocator()
+{
+    pthread_once(&allocatorTlsKeyOnce, createAllocatorTlsKey);
+    return (MatAllocator*)pthread_getspecific(allocatorTlsKey);
+}
+
+static void setThreadAllocator(MatAllocator* allocator)
+{
+    pthread_once(&allocatorTlsKeyOnce, createAllocatorTlsKey);
+    pthread_setspecific(allocatorTlsKey, allocator);
+}
+#endif
+
+void setDefaultAllocator(MatAllocator* allocator)
+{
+    defaultAllocator = allocator;
+}
+
+void setThreadDefaultAllocator(MatAllocator* allocator)
+{
+    if( allocator )
+        useThreadAllocators = true;
+    setThreadAllocator(allocator);
+}
+
+MatAllocator* getDefaultAllocator()
+{
+    if( useThreadAllocators )
+    {
+        MatAllocator* allocator = getThreadAllocator();
+        if( allocator )
+            return allocator;
+    }
+    return defaultAllocator;
+}
+
+/****************************************************************************************\
+*                                  External data                                         *
+\****************************************************************************************/
+
+// The reference counter of the external data lives in a separately allocated block together
+// with the deallocator, so Mat::refcount points to the block and the allocator finds it there.
+struct ExternalDataBlock
+{
+    int refcount;
+    void* data;
+    MatDeallocator deallocator;
+    void* userdata;
+};
+
+static void fastFreeData(void* data, void*)
+{
+    fastFree(data);
+}
+
+class ExternalDataAllocator : public MatAllocator
+{
+public:
+    // used only when somebody calls create() on a header that was re-assigned this allocator
+    void allocate(int dims, const int* sizes, int type, int*& refcount,
+                  uchar*& datastart, uchar*& data, size_t* step)
+    {
+        size_t total = CV_ELEM_SIZE(type);
+        for( int i = dims-1; i >= 0; i-- )
+        {
+            step[i] = total;
+            total *= sizes[i];
+        }
+        ExternalDataBlock* block = new ExternalDataBlock;
+        block->data = datastart = data = (uchar*)fastMalloc(total);
+        block->deallocator = fastFreeData;
+        block->userdata = 0;
+        block->refcount = 1;
+        refcount = &block->refcount;
+    }
+
+    void deallocate(int* refcount, uchar*, uchar*)
+    {
+        ExternalDataBlock* block = (ExternalDataBlock*)refcount;
+        if( block->deallocator )
+            block->deallocator(block->data, block->userdata);
+        delete block;
+    }
+};
+
+static ExternalDataAllocator externalDataAllocator;
+
+// makes the header the first owner of the data; if the header could not be constructed,
+// the data is released right away, so that the caller does not have to handle that case
+static void attachExternalData(Mat& m, const Mat& hdr, void* data,
+                               MatDeallocator deallocator, void* userdata)
+{
+    ExternalDataBlock* block = 0;
+    try
+    {
+        block = new ExternalDataBlock;
+    }
+    catch(...)
+    {
+        if( deallocator )
+            deallocator(data, userdata);
+        throw;
+    }
+    block->refcount = 1;
+    block->data = data;
+    block->deallocator = deallocator;
+    block->userdata = userdata;
+    m = hdr;
+    m.refcount = &block->refcount;
+    m.allocator = &externalDataAllocator;
+}
+
+Mat::Mat(int _rows, int _cols, int _type, void* _data, MatDeallocator _deallocator,
+         void* _userdata, size_t _step)
+    : flags(0), dims(0), rows(0), cols(0), data(0), refcount(0),
+    datastart(0), dataend(0), datalimit(0), allocator(0), size(&rows)
+{
+    Mat hdr;
+    try
+    {
+        hdr = Mat(_rows, _cols, _type, _data, _step);
+    }
+    catch(...)
+    {
+        if( _deallocator )
+            _deallocator(_data, _userdata);
+        throw;
+    }
+    attachExternalData(*this, hdr, _data, _deallocator, _userdata);
+}
+
+Mat::Mat(Size _sz, int _type, void* _data, MatDeallocator _deallocator,
+         void* _userdata, size_t _step)
+    : flags(0), dims(0), rows(0), cols(0), data(0), refcount(0),
+    datastart(0), dataend(0), datalimit(0), allocator(0), size(&rows)
+{
+    Mat hdr;
+    try
+    {
+        hdr = Mat(_sz, _type, _data, _step);
+    }
+    catch(...)
+    {
+        if( _deallocator )
+            _deallocator(_data, _userdata);
+        throw;
+    }
+    attachExternalData(*this, hdr, _data, _deallocator, _userdata);
+}
+
+Mat::Mat(int _dims, const int* _sizes, int _type, void* _data, MatDeallocator _deallocator,
+         void* _userdata, const size_t* _steps)
+    : flags(0), dims(0), rows(0), cols(0), data(0), refcount(0),
+    datastart(0), dataend(0), datalimit(0), allocator(0), size(&rows)
+{
+    Mat hdr;
+    try
+    {
+        hdr = Mat(_dims, _sizes, _type, _data, _steps);
+    }
+    catch(...)
+    {
+        if( _deallocator )
+            _deallocator(_data, _userdata);
+        throw;
+    }
+    attachExternalData(*this, hdr, _data, _deallocator, _userdata);
+}
+
 void Mat::create(int d, const int* _sizes, int _type)
 {
     int i;
@@ -198,6 +544,11 @@ void Mat::create(int d, const int* _sizes, int _type)
     release();
     if( d == 0 )
         return;
+    // the new data of a header that owned an external buffer is allocated as usual
+    if( allocator == &externalDataAllocator )
+        allocator = 0;
+    if( !allocator )
+        allocator = getDefaultAllocator();
     flags = (_type & CV_MAT_TYPE_MASK) | MAGIC_VAL;
     setSize(*this, d, _sizes, 0, allocator == 0);
     
@@ -2191,6 +2542,268 @@ static inline float distance(const float* a, const float* b, int n)
     return d;
 }
 
+// computes the squared distances from a to the n vectors b, b + bstep, ..., b + bstep*(n-1)
+static void batchDistance(const float* a, const float* b, size_t bstep, int n, int dims, float* dist)
+{
+#ifdef HAVE_DISPATCH_AVX
+    if( checkHardwareSupport(CV_CPU_AVX) )
+    {
+        opt_AVX::batchDistL2Sqr32f(a, b, bstep, n, dims, dist);
+        return;
+    }
+#endif
+    for( int k = 0; k < n; k++ )
+        dist[k] = distance(a, b + bstep*k, dims);
+}
+
+enum { KMEANS_CENTER_BLOCK = 256 };
+
+// finds the nearest center to the sample (the first one of equally distant centers)
+// and, optionally, the squared distance to the second nearest one
+static int findNearestCenter(const float* sample, const Mat& centers, float* buf,
+                             double& dist1, double* dist2=0)
+{
+    int K = centers.rows, dims = centers.cols, k_best = 0;
+    size_t step = centers.step/sizeof(float);
+    double min1 = DBL_MAX, min2 = DBL_MAX;
+
+    for( int k0 = 0; k0 < K; k0 += KMEANS_CENTER_BLOCK )
+    {
+        int n = std::min(K - k0, (int)KMEANS_CENTER_BLOCK);
+        batchDistance(sample, centers.ptr<float>(k0), step, n, dims, buf);
+        for( int k = 0; k < n; k++ )
+        {
+            double d = buf[k];
+            if( min1 > d )
+            {
+                min2 = min1;
+                min1 = d;
+                k_best = k0 + k;
+            }
+            else if( min2 > d )
+                min2 = d;
+        }
+    }
+    dist1 = min1;
+    if( dist2 )
+        *dist2 = min2;
+    return k_best;
+}
+
+// labels the samples idx[i] (or just i) with their nearest centers
+class KMeansAssigner
+{
+public:
+    KMeansAssigner(const Mat& _data, const Mat& _centers, int* _labels, double* _dist, const int* _idx=0)
+        : data(&_data), centers(&_centers), labels(_labels), dist(_dist), idx(_idx) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        float buf[KMEANS_CENTER_BLOCK];
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            const float* sample = data->ptr<float>(idx ? idx[i] : i);
+            labels[i] = findNearestCenter(sample, *centers, buf, dist[i]);
+        }
+    }
+
+protected:
+    const Mat* data;
+    const Mat* centers;
+    int* labels;
+    double* dist;
+    const int* idx;
+};
+
+/*
+ The assignment step with Hamerly's bounds (G. Hamerly, Making k-means even faster, 2010).
+ upper[i] bounds the distance from the sample to its center from above, lower[i] bounds the distance
+ to any other center from below; both are updated with the center shifts after each iteration.
+ If upper[i] is not greater than lower[i] or the half distance from the sample's center to the nearest
+ other center, the label can not change and the distances are not computed.
+ Unlike Elkan's algorithm, it keeps two bounds per sample instead of K, so it fits large K.
+*/
+class KMeansHamerlyAssigner
+{
+public:
+    KMeansHamerlyAssigner(const Mat& _data, const Mat& _centers, int* _labels,
+                          double* _upper, double* _lower, const double* _halfSep,
+                          const double* _shift, int _maxShiftIdx, double _maxShift, double _maxShift2,
+                          bool _init)
+        : data(&_data), centers(&_centers), labels(_labels), upper(_upper), lower(_lower),
+          halfSep(_halfSep), shift(_shift), maxShiftIdx(_maxShiftIdx), maxShift(_maxShift),
+          maxShift2(_maxShift2), init(_init) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        float buf[KMEANS_CENTER_BLOCK];
+        int dims = centers->cols;
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            const float* sample = data->ptr<float>(i);
+            double d1, d2;
+            if( !init )
+            {
+                int a = labels[i];
+                upper[i] += shift[a];
+                lower[i] -= a == maxShiftIdx ? maxShift2 : maxShift;
+                double m = std::max(halfSep[a], lower[i]);
+                if( upper[i] <= m )
+                    continue;
+                float d;
+                batchDistance(sample, centers->ptr<float>(a), 0, 1, dims, &d);
+                upper[i] = std::sqrt((double)d);
+                if( upper[i] <= m )
+                    continue;
+            }
+            labels[i] = findNearestCenter(sample, *centers, buf, d1, &d2);
+            upper[i] = std::sqrt(d1);
+            lower[i] = std::sqrt(d2);
+        }
+    }
+
+protected:
+    const Mat* data;
+    const Mat* centers;
+    int* labels;
+    double* upper;
+    double* lower;
+    const double* halfSep;
+    const double* shift;
+    int maxShiftIdx;
+    double maxShift, maxShift2;
+    bool init;
+};
+
+// computes the half distance from every center to the nearest other center
+class KMeansSeparationComputer
+{
+public:
+    KMeansSeparationComputer(const Mat& _centers, double* _halfSep)
+        : centers(&_centers), halfSep(_halfSep) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        float buf[KMEANS_CENTER_BLOCK];
+        int K = centers->rows, dims = centers->cols;
+        size_t step = centers->step/sizeof(float);
+        for( int k = range.begin(); k < range.end(); k++ )
+        {
+            double m = DBL_MAX;
+            for( int k0 = 0; k0 < K; k0 += KMEANS_CENTER_BLOCK )
+            {
+                int n = std::min(K - k0, (int)KMEANS_CENTER_BLOCK);
+                batchDistance(centers->ptr<float>(k), centers->ptr<float>(k0), step, n, dims, buf);
+                for( int j = 0; j < n; j++ )
+                    if( k0 + j != k )
+                        m = std::min(m, (double)buf[j]);
+            }
+            halfSep[k] = std::sqrt(m)*0.5;
+        }
+    }
+
+protected:
+    const Mat* centers;
+    double* halfSep;
+};
+
+// sums the samples of each center; the samples are sorted by the labels,
+// the ones of center k are order[ofs[k]], ..., order[ofs[k+1]-1]
+class KMeansCenterAccumulator
+{
+public:
+    KMeansCenterAccumulator(const Mat& _data, Mat& _centers, const int* _order, const int* _ofs)
+        : data(&_data), centers(&_centers), order(_order), ofs(_ofs) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int dims = centers->cols;
+        for( int k = range.begin(); k < range.end(); k++ )
+        {
+            float* center = centers->ptr<float>(k);
+            int i, j;
+            for( j = 0; j < dims; j++ )
+                center[j] = 0.f;
+            for( i = ofs[k]; i < ofs[k+1]; i++ )
+            {
+                const float* sample = data->ptr<float>(order[i]);
+                for( j = 0; j <= dims - 4; j += 4 )
+                {
+                    float t0 = center[j] + sample[j];
+                    float t1 = center[j+1] + sample[j+1];
+
+                    center[j] = t0;
+                    center[j+1] = t1;
+
+                    t0 = center[j+2] + sample[j+2];
+                    t1 = center[j+3] + sample[j+3];
+
+                    center[j+2] = t0;
+                    center[j+3] = t1;
+                }
+                for( ; j < dims; j++ )
+                    center[j] += sample[j];
+            }
+        }
+    }
+
+protected:
+    const Mat* data;
+    Mat* centers;
+    const int* order;
+    const int* ofs;
+};
+
+// the squared distances from the samples to their centers
+class KMeansDistanceComputer
+{
+public:
+    KMeansDistanceComputer(const Mat& _data, const Mat& _centers, const int* _labels, double* _dist)
+        : data(&_data), centers(&_centers), labels(_labels), dist(_dist) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int dims = centers->cols;
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            // the same kernel as in the assignment, so the compactness does not depend on the mode
+            float d;
+            batchDistance(data->ptr<float>(i), centers->ptr<float>(labels[i]), 0, 1, dims, &d);
+            dist[i] = d;
+        }
+    }
+
+protected:
+    const Mat* data;
+    const Mat* centers;
+    const int* labels;
+    double* dist;
+};
+
+// computes the distances from the center to the samples and takes the minimum with the previous distances
+class KMeansPPDistanceComputer
+{
+public:
+    KMeansPPDistanceComputer(const Mat& _data, int _ci, const float* _dist, float* _tdist)
+        : data(&_data), ci(_ci), dist(_dist), tdist(_tdist) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int n = range.end() - range.begin();
+        size_t step = data->step/sizeof(float);
+        batchDistance(data->ptr<float>(ci), data->ptr<float>(range.begin()), step, n, data->cols, tdist + range.begin());
+        if( dist )
+            for( int i = range.begin(); i < range.end(); i++ )
+                tdist[i] = std::min(tdist[i], dist[i]);
+    }
+
+protected:
+    const Mat* data;
+    int ci;
+    const float* dist;
+    float* tdist;
+};
+
 /*
 k-means center initialization using the following algorithm:
 Arthur & Vassilvitskii (2007) k-means++: The Advantages of Careful Seeding
@@ -2199,8 +2812,6 @@ static void generateCentersPP(const Mat& _data, Mat& _out_centers,
                               int K, RNG& rng, int trials)
 {
     int i, j, k, dims = _data.cols, N = _data.rows;
-    const float* data = _data.ptr<float>(0);
-    int step = (int)(_data.step/sizeof(data[0]));
     vector<int> _centers(K);
     int* centers = &_centers[0];
     vector<float> _dist(N*3);
@@ -2209,11 +2820,9 @@ static void generateCentersPP(const Mat& _data, Mat& _out_centers,
 
     centers[0] = (unsigned)rng % N;
 
+    parallel_for(BlockedRange(0, N, 256), KMeansPPDistanceComputer(_data, centers[0], 0, dist));
     for( i = 0; i < N; i++ )
-    {
-        dist[i] = distance(data + step*i, data + step*centers[0], dims);
         sum0 += dist[i];
-    }
     
     for( k = 1; k < K; k++ )
     {
@@ -2227,11 +2836,9 @@ static void generateCentersPP(const Mat& _data, Mat& _out_centers,
                 if( (p -= dist[i]) <= 0 )
                     break;
             int ci = i;
+            parallel_for(BlockedRange(0, N, 256), KMeansPPDistanceComputer(_data, ci, dist, tdist2));
             for( i = 0; i < N; i++ )
-            {
-                tdist2[i] = std::min(distance(data + step*i, data + step*ci, dims), dist[i]);
                 s += tdist2[i];
-            }
             
             if( s < bestSum )
             {
@@ -2247,28 +2854,82 @@ static void generateCentersPP(const Mat& _data, Mat& _out_centers,
 
     for( k = 0; k < K; k++ )
     {
-        const float* src = data + step*centers[k];
+        const float* src = _data.ptr<float>(centers[k]);
         float* dst = _out_centers.ptr<float>(k);
         for( j = 0; j < dims; j++ )
             dst[j] = src[j];
     }
 }
 
+// computes the centers as the means of their samples; the empty clusters get random centers.
+// returns the maximum squared center shift and, if shift != 0, the shift of every center
+static double updateCenters(const Mat& data, const int* labels, Mat& centers, const Mat& old_centers,
+                            const vector<Vec2f>& box, RNG& rng, double* shift)
+{
+    int i, j, k, N = data.rows, K = centers.rows, dims = centers.cols;
+    vector<int> ofs(K + 1, 0), order(N);
+    double max_shift = 0;
+
+    // counting sort of the samples by the labels; the samples of every center stay in the original order
+    for( i = 0; i < N; i++ )
+        ofs[labels[i] + 1]++;
+    for( k = 0; k < K; k++ )
+        ofs[k + 1] += ofs[k];
+    vector<int> pos(ofs.begin(), ofs.end() - 1);
+    for( i = 0; i < N; i++ )
+        order[pos[labels[i]]++] = i;
+
+    parallel_for(BlockedRange(0, K, 4), KMeansCenterAccumulator(data, centers, &order[0], &ofs[0]));
+
+    for( k = 0; k < K; k++ )
+    {
+        float* center = centers.ptr<float>(k);
+        int count = ofs[k+1] - ofs[k];
+        if( count != 0 )
+        {
+            float scale = 1.f/count;
+            for( j = 0; j < dims; j++ )
+                center[j] *= scale;
+        }
+        else
+            generateRandomCenter(box, center, rng);
+
+        if( old_centers.data )
+        {
+            double dist = 0;
+            const float* old_center = old_centers.ptr<float>(k);
+            for( j = 0; j < dims; j++ )
+            {
+                double t = center[j] - old_center[j];
+                dist += t*t;
+            }
+            max_shift = std::max(max_shift, dist);
+            if( shift )
+                shift[k] = std::sqrt(dist);
+        }
+    }
+    return max_shift;
+}
+
 }
     
 double cv::kmeans( InputArray _data, int K,
                    InputOutputArray _bestLabels,
                    TermCriteria criteria, int attempts,
-                   int flags, OutputArray _centers )
+                   int flags, OutputArray _centers, int batchSize )
 {
     const int SPP_TRIALS = 3;
     Mat data = _data.getMat();
     int N = data.rows > 1 ? data.rows : data.cols;
     int dims = (data.rows > 1 ? data.cols : 1)*data.channels();
     int type = data.depth();
+    bool miniBatch = (flags & KMEANS_MINI_BATCH) != 0;
+    bool hamerly = (flags & KMEANS_HAMERLY) != 0 && !miniBatch;
 
     attempts = std::max(attempts, 1);
     CV_Assert( data.dims <= 2 && type == CV_32F && K > 0 );
+    // the samples are accessed by rows below
+    data = data.reshape(1, N);
 
     _bestLabels.create(N, 1, CV_32S, -1, true);
     
@@ -2293,9 +2954,11 @@ double cv::kmeans( InputArray _data, int K,
     int* labels = _labels.ptr<int>();
 
     Mat centers(K, dims, type), old_centers(K, dims, type);
-    vector<int> counters(K);
     vector<Vec2f> _box(dims);
     Vec2f* box = &_box[0];
+    vector<double> dists(N), shift(K), halfSep(K), upper, lower;
+    vector<int> counters, batchIdx, batchLabels;
+    vector<double> batchDists;
 
     double best_compactness = DBL_MAX, compactness = 0;
     RNG& rng = theRNG();
@@ -2307,8 +2970,10 @@ double cv::kmeans( InputArray _data, int K,
         criteria.epsilon = FLT_EPSILON;
     criteria.epsilon *= criteria.epsilon;
 
+    // a mini-batch iteration is cheap, so the number of them is not limited to 100
     if( criteria.type & TermCriteria::COUNT )
-        criteria.maxCount = std::min(std::max(criteria.maxCount, 2), 100);
+        criteria.maxCount = miniBatch ? std::max(criteria.maxCount, 2) :
+            std::min(std::max(criteria.maxCount, 2), 100);
     else
         criteria.maxCount = 100;
 
@@ -2318,6 +2983,20 @@ double cv::kmeans( InputArray _data, int K,
         criteria.maxCount = 2;
     }
 
+    if( miniBatch )
+    {
+        batchSize = std::min(batchSize > 0 ? batchSize : std::max(1024, K*2), N);
+        batchIdx.resize(batchSize);
+        batchLabels.resize(batchSize);
+        batchDists.resize(batchSize);
+        counters.resize(K);
+    }
+    if( hamerly )
+    {
+        upper.resize(N);
+        lower.resize(N);
+    }
+
     const float* sample = data.ptr<float>(0);
     for( j = 0; j < dims; j++ )
         box[j] = Vec2f(sample[j], sample[j]);
@@ -2336,109 +3015,140 @@ double cv::kmeans( InputArray _data, int K,
     for( a = 0; a < attempts; a++ )
     {
         double max_center_shift = DBL_MAX;
-        for( iter = 0; iter < criteria.maxCount && max_center_shift > criteria.epsilon; iter++ )
-        {
-            swap(centers, old_centers);
 
-            if( iter == 0 && (a > 0 || !(flags & KMEANS_USE_INITIAL_LABELS)) )
+        if( miniBatch )
+        {
+            // Sculley (2010) Web-Scale K-Means Clustering: every iteration assigns a random batch
+            // of samples and moves their centers towards them with the per-center learning rates
+            if( a == 0 && (flags & KMEANS_USE_INITIAL_LABELS) )
             {
-                if( flags & KMEANS_PP_CENTERS )
-                    generateCentersPP(data, centers, K, rng, SPP_TRIALS);
-                else
+                for( i = 0; i < N; i++ )
+                    CV_Assert( (unsigned)labels[i] < (unsigned)K );
+                updateCenters(data, labels, centers, Mat(), _box, rng, 0);
+            }
+            else if( flags & KMEANS_PP_CENTERS )
+            {
+                // the seeding is quadratic, so it is done on a random subset of the samples
+                int nsubset = std::min(N, std::max(batchSize, K*SPP_TRIALS));
+                Mat subset(nsubset, dims, type);
+                for( i = 0; i < nsubset; i++ )
                 {
-                    for( k = 0; k < K; k++ )
-                        generateRandomCenter(_box, centers.ptr<float>(k), rng);
+                    Mat dst = subset.row(i);
+                    data.row(nsubset < N ? (unsigned)rng % N : i).copyTo(dst);
                 }
+                generateCentersPP(subset, centers, K, rng, SPP_TRIALS);
             }
             else
             {
-                if( iter == 0 && a == 0 && (flags & KMEANS_USE_INITIAL_LABELS) )
-                {
-                    for( i = 0; i < N; i++ )
-                        CV_Assert( (unsigned)labels[i] < (unsigned)K );
-                }
-            
-                // compute centers
-                centers = Scalar(0);
                 for( k = 0; k < K; k++ )
-                    counters[k] = 0;
+                    generateRandomCenter(_box, centers.ptr<float>(k), rng);
+            }
 
-                for( i = 0; i < N; i++ )
+            std::fill(counters.begin(), counters.end(), 0);
+            for( iter = 0; iter < criteria.maxCount && max_center_shift > criteria.epsilon; iter++ )
+            {
+                for( i = 0; i < batchSize; i++ )
+                    batchIdx[i] = (unsigned)rng % N;
+                parallel_for(BlockedRange(0, batchSize, 16),
+                             KMeansAssigner(data, centers, &batchLabels[0], &batchDists[0], &batchIdx[0]));
+
+                centers.copyTo(old_centers);
+                for( i = 0; i < batchSize; i++ )
                 {
-                    sample = data.ptr<float>(i);
-                    k = labels[i];
+                    k = batchLabels[i];
+                    sample = data.ptr<float>(batchIdx[i]);
                     float* center = centers.ptr<float>(k);
-                    for( j = 0; j <= dims - 4; j += 4 )
-                    {
-                        float t0 = center[j] + sample[j];
-                        float t1 = center[j+1] + sample[j+1];
+                    float eta = 1.f/++counters[k];
+                    for( j = 0; j < dims; j++ )
+                        center[j] += (sample[j] - center[j])*eta;
+                }
 
-                        center[j] = t0;
-                        center[j+1] = t1;
+                max_center_shift = 0;
+                for( k = 0; k < K; k++ )
+                {
+                    double dist = norm(centers.row(k), old_centers.row(k), NORM_L2);
+                    max_center_shift = std::max(max_center_shift, dist*dist);
+                }
+            }
 
-                        t0 = center[j+2] + sample[j+2];
-                        t1 = center[j+3] + sample[j+3];
+            parallel_for(BlockedRange(0, N, 16), KMeansAssigner(data, centers, labels, &dists[0]));
+        }
+        else
+        {
+            for( iter = 0; iter < criteria.maxCount && max_center_shift > criteria.epsilon; iter++ )
+            {
+                bool initialAssignment = true;
+                swap(centers, old_centers);
 
-                        center[j+2] = t0;
-                        center[j+3] = t1;
+                if( iter == 0 && (a > 0 || !(flags & KMEANS_USE_INITIAL_LABELS)) )
+                {
+                    if( flags & KMEANS_PP_CENTERS )
+                        generateCentersPP(data, centers, K, rng, SPP_TRIALS);
+                    else
+                    {
+                        for( k = 0; k < K; k++ )
+                            generateRandomCenter(_box, centers.ptr<float>(k), rng);
                     }
-                    for( ; j < dims; j++ )
-                        center[j] += sample[j];
-                    counters[k]++;
                 }
-
-                if( iter > 0 )
-                    max_center_shift = 0;
-
-                for( k = 0; k < K; k++ )
+                else
                 {
-                    float* center = centers.ptr<float>(k);
-                    if( counters[k] != 0 )
+                    if( iter == 0 && a == 0 && (flags & KMEANS_USE_INITIAL_LABELS) )
                     {
-                        float scale = 1.f/counters[k];
-                        for( j = 0; j < dims; j++ )
-                            center[j] *= scale;
+                        for( i = 0; i < N; i++ )
+                            CV_Assert( (unsigned)labels[i] < (unsigned)K );
                     }
-                    else
-                        generateRandomCenter(_box, center, rng);
-                    
+
+                    double s = updateCenters(data, labels, centers, iter > 0 ? old_centers : Mat(),
+                                             _box, rng, &shift[0]);
                     if( iter > 0 )
                     {
-                        double dist = 0;
-                        const float* old_center = old_centers.ptr<float>(k);
-                        for( j = 0; j < dims; j++ )
-                        {
-                            double t = center[j] - old_center[j];
-                            dist += t*t;
-                        }
-                        max_center_shift = std::max(max_center_shift, dist);
+                        max_center_shift = s;
+                        initialAssignment = false;
                     }
                 }
-            }
 
-            // assign labels
-            compactness = 0;
-            for( i = 0; i < N; i++ )
-            {
-                sample = data.ptr<float>(i);
-                int k_best = 0;
-                double min_dist = DBL_MAX;
-
-                for( k = 0; k < K; k++ )
+                if( !hamerly )
                 {
-                    const float* center = centers.ptr<float>(k);
-                    double dist = distance(sample, center, dims);
-
-                    if( min_dist > dist )
+                    parallel_for(BlockedRange(0, N, 16), KMeansAssigner(data, centers, labels, &dists[0]));
+                    compactness = 0;
+                    for( i = 0; i < N; i++ )
+                        compactness += dists[i];
+                }
+                else
+                {
+                    int maxShiftIdx = -1;
+                    double maxShift = 0, maxShift2 = 0;
+                    if( !initialAssignment )
                     {
-                        min_dist = dist;
-                        k_best = k;
+                        for( k = 0; k < K; k++ )
+                        {
+                            if( shift[k] > maxShift )
+                            {
+                                maxShift2 = maxShift;
+                                maxShift = shift[k];
+                                maxShiftIdx = k;
+                            }
+                            else
+                                maxShift2 = std::max(maxShift2, shift[k]);
+                        }
+                        parallel_for(BlockedRange(0, K, 4), KMeansSeparationComputer(centers, &halfSep[0]));
                     }
+                    parallel_for(BlockedRange(0, N, 16),
+                                 KMeansHamerlyAssigner(data, centers, labels, &upper[0], &lower[0],
+                                                       &halfSep[0], &shift[0], maxShiftIdx,
+                                                       maxShift, maxShift2, initialAssignment));
                 }
-
-                compactness += min_dist;
-                labels[i] = k_best;
             }
+            
+            if( hamerly )
+                parallel_for(BlockedRange(0, N, 256), KMeansDistanceComputer(data, centers, labels, &dists[0]));
+        }
+
+        if( miniBatch || hamerly )
+        {
+            compactness = 0;
+            for( i = 0; i < N; i++ )
+                compactness += dists[i];
         }
 
         if( compactness < best_compactness )
@@ -0,0 +1,372 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+
+#if defined WIN32 || defined _WIN32 || defined WINCE
+#else
+#include <unistd.h>
+#if defined __MACH__ && defined __APPLE__
+#include <sys/sysctl.h>
+#endif
+#endif
+
+/*
+   The built-in thread pool used by cv::parallel_for, cv::parallel_do and cv::parallel_reduce
+   when OpenCV is built without TBB.
+
+   Every parallel_for_ call becomes a job: the range is cut into grainsize-aligned chunks and
+   the job is pushed onto the stack of active jobs. Idle workers pick the topmost job that still
+   has unclaimed chunks (so the nested loops are served first) and claim its chunks one by one
+   with an atomic counter; the thread that submitted the job claims chunks of its own job as well.
+   The submitter never waits for anything but the chunks already taken by the other threads,
+   so nested loops can not deadlock even when all the workers are busy.
+*/
+
+#if !defined HAVE_TBB && !(defined WIN32 || defined _WIN32 || defined WINCE)
+#define CV_USE_THREAD_POOL 1
+#else
+#define CV_USE_THREAD_POOL 0
+#endif
+
+namespace cv
+{
+
+static int numThreads = 0;
+
+int getNumberOfCPUs(void)
+{
+#if defined WIN32 || defined _WIN32 || defined WINCE
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo( &sysinfo );
+    return (int)sysinfo.dwNumberOfProcessors;
+#elif defined __MACH__ && defined __APPLE__
+    int numCPU = 0;
+    size_t len = sizeof(numCPU);
+    int mib[2] = { CTL_HW, HW_NCPU };
+    if( sysctl(mib, 2, &numCPU, &len, 0, 0) < 0 || numCPU < 1 )
+        numCPU = 1;
+    return numCPU;
+#elif defined _SC_NPROCESSORS_ONLN
+    return std::max((int)sysconf(_SC_NPROCESSORS_ONLN), 1);
+#else
+    return 1;
+#endif
+}
+
+#if CV_USE_THREAD_POOL
+
+enum { MAX_THREADS = 256, CHUNKS_PER_THREAD = 4 };
+
+struct ParallelJob
+{
+    ParallelJob(const BlockedRange& _range, const ParallelLoopBody& _body, int _nchunks)
+        : body(&_body), range(_range), nchunks(_nchunks), next(0), users(0), failed(false) {}
+
+    // processes the unclaimed chunks until there are no more of them
+    void execute()
+    {
+        for(;;)
+        {
+            int i = CV_XADD((int*)&next, 1);
+            if( i >= nchunks )
+                break;
+            (*body)(getStripe(range, i, nchunks));
+        }
+    }
+
+    bool hasWork() const { return next < nchunks; }
+
+    const ParallelLoopBody* body;
+    BlockedRange range;
+    int nchunks;
+    volatile int next;
+    int users;
+    bool failed;
+    Exception exc;
+};
+
+class ThreadPool
+{
+public:
+    ThreadPool() : stopping(false)
+    {
+        pthread_mutex_init(&mutex, 0);
+        pthread_cond_init(&workCond, 0);
+        pthread_cond_init(&doneCond, 0);
+        pthread_key_create(&threadIdxKey, 0);
+    }
+
+    ~ThreadPool()
+    {
+        stop();
+        pthread_key_delete(threadIdxKey);
+        pthread_cond_destroy(&doneCond);
+        pthread_cond_destroy(&workCond);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    static ThreadPool& instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    int threadIdx()
+    {
+        return (int)(size_t)pthread_getspecific(threadIdxKey);
+    }
+
+    void run(ParallelJob& job)
+    {
+        start(numThreads - 1);
+
+        pthread_mutex_lock(&mutex);
+        jobs.push_back(&job);
+        pthread_cond_broadcast(&workCond);
+        pthread_mutex_unlock(&mutex);
+
+        executeSafe(job);
+
+        pthread_mutex_lock(&mutex);
+        while( job.users > 0 )
+            pthread_cond_wait(&doneCond, &mutex);
+        std::vector<ParallelJob*>::iterator it = std::find(jobs.begin(), jobs.end(), &job);
+        CV_Assert( it != jobs.end() );
+        jobs.erase(it);
+        pthread_mutex_unlock(&mutex);
+
+        if( job.failed )
+            throw job.exc;
+    }
+
+    // stops the workers; it is restarted with the new number of threads by the next run()
+    void stop()
+    {
+        AutoLock lock(configMutex);
+        pthread_mutex_lock(&mutex);
+        stopping = true;
+        pthread_cond_broadcast(&workCond);
+        pthread_mutex_unlock(&mutex);
+
+        for( size_t i = 0; i < threads.size(); i++ )
+            pthread_join(threads[i], 0);
+        threads.clear();
+        stopping = false;
+    }
+
+protected:
+    struct WorkerParams
+    {
+        ThreadPool* pool;
+        int idx;
+    };
+
+    void start(int nworkers)
+    {
+        if( (int)threads.size() == nworkers )
+            return;
+        AutoLock lock(configMutex);
+        for( int i = (int)threads.size(); i < nworkers; i++ )
+        {
+            WorkerParams* params = new WorkerParams;
+            params->pool = this;
+            params->idx = i + 1;
+            pthread_t thread;
+            if( pthread_create(&thread, 0, workerProc, params) != 0 )
+            {
+                delete params;
+                break;
+            }
+            threads.push_back(thread);
+        }
+    }
+
+    static void* workerProc(void* arg)
+    {
+        WorkerParams* params = (WorkerParams*)arg;
+        ThreadPool* pool = params->pool;
+        pthread_setspecific(pool->threadIdxKey, (void*)(size_t)params->idx);
+        delete params;
+        pool->workerLoop();
+        return 0;
+    }
+
+    void workerLoop()
+    {
+        pthread_mutex_lock(&mutex);
+        for(;;)
+        {
+            ParallelJob* job = 0;
+            for( size_t i = jobs.size(); i > 0; i-- )
+                if( jobs[i-1]->hasWork() )
+                {
+                    job = jobs[i-1];
+                    break;
+                }
+
+            if( !job )
+            {
+                if( stopping )
+                    break;
+                pthread_cond_wait(&workCond, &mutex);
+                continue;
+            }
+
+            job->users++;
+            pthread_mutex_unlock(&mutex);
+            executeSafe(*job);
+            pthread_mutex_lock(&mutex);
+            if( --job->users == 0 )
+                pthread_cond_broadcast(&doneCond);
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    void executeSafe(ParallelJob& job)
+    {
+        try
+        {
+            job.execute();
+        }
+        catch(const Exception& e)
+        {
+            setError(job, e);
+        }
+        catch(const std::exception& e)
+        {
+            setError(job, Exception(CV_StsError, e.what(), "parallel_for_", __FILE__, __LINE__));
+        }
+        catch(...)
+        {
+            setError(job, Exception(CV_StsError, "Unknown exception", "parallel_for_", __FILE__, __LINE__));
+        }
+    }
+
+    void setError(ParallelJob& job, const Exception& e)
+    {
+        pthread_mutex_lock(&mutex);
+        if( !job.failed )
+        {
+            job.failed = true;
+            job.exc = e;
+        }
+        // the rest of the chunks is skipped
+        job.next = job.nchunks;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_mutex_t mutex;
+    pthread_cond_t workCond;
+    pthread_cond_t doneCond;
+    pthread_key_t threadIdxKey;
+    Mutex configMutex;
+    std::vector<pthread_t> threads;
+    std::vector<ParallelJob*> jobs;
+    bool stopping;
+};
+
+#endif
+
+int getNumThreads(void)
+{
+    if( numThreads <= 0 )
+        numThreads = getNumberOfCPUs();
+    return numThreads;
+}
+
+void setNumThreads( int nthreads )
+{
+    if( nthreads <= 0 )
+        nthreads = getNumberOfCPUs();
+#if CV_USE_THREAD_POOL
+    nthreads = std::min(nthreads, (int)MAX_THREADS);
+    if( nthreads != numThreads )
+        ThreadPool::instance().stop();
+#endif
+    numThreads = nthreads;
+}
+
+int getThreadNum(void)
+{
+#if CV_USE_THREAD_POOL
+    return ThreadPool::instance().threadIdx();
+#else
+    return 0;
+#endif
+}
+
+#ifndef HAVE_TBB
+
+ParallelLoopBody::~ParallelLoopBody() {}
+
+int getNumStripes(const BlockedRange& range)
+{
+    int grain = std::max(range.grainsize(), 1);
+    int nblocks = (range.end() - range.begin() + grain - 1)/grain;
+    return std::max(std::min(nblocks, getNumThreads()), 1);
+}
+
+void parallel_for_(const BlockedRange& range, const ParallelLoopBody& body)
+{
+    if( range.end() <= range.begin() )
+        return;
+#if CV_USE_THREAD_POOL
+    int nthreads = getNumThreads();
+    int grain = std::max(range.grainsize(), 1);
+    int nblocks = (range.end() - range.begin() + grain - 1)/grain;
+    int nchunks = std::min(nblocks, nthreads*CHUNKS_PER_THREAD);
+    if( nthreads > 1 && nchunks > 1 )
+    {
+        ParallelJob job(range, body, nchunks);
+        ThreadPool::instance().run(job);
+        return;
+    }
+#endif
+    body(range);
+}
+
+#endif
+
+}
+
+/* End of file. */
@@ -45,6 +45,18 @@
 #include <wchar.h>
 #include <zlib.h>
 
+#if defined WIN32 || defined _WIN32 || defined WINCE
+#include <windows.h>
+#undef small
+#undef min
+#undef max
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 /****************************************************************************************\
 *                            Common macros and type definitions                          *
 \****************************************************************************************/
@@ -205,10 +217,67 @@ typedef void (*CvWriteString)( struct CvFileStorage* fs, const char* key,
 typedef void (*CvWriteComment)( struct CvFileStorage* fs, const char* comment, int eol_comment );
 typedef void (*CvStartNextStream)( struct CvFileStorage* fs );
 
+/* The numbers passed to cvWriteRawData() in the binary mode. They are collected in buf
+   until they take more than CV_FS_BIN_MIN_RAW bytes, then they are streamed to the file
+   as a raw block starting at ofs */
+typedef struct CvFSRawRun
+{
+    int depth; /* -1 if there is no active run */
+    int count;
+    int64 ofs; /* -1 while the numbers are in buf */
+    uchar* buf;
+}
+CvFSRawRun;
+
+/* The memory-mapped (or, if it is not possible, read to the heap) binary storage file.
+   It is referenced by the storage itself and by the matrices read from it */
+typedef struct CvFSMapping
+{
+    int refcount;
+    int is_mapped;
+    uchar* data;
+    size_t size;
+}
+CvFSMapping;
+
+/* A collection the stream reader is in (or, as CvFSStream::head, the one it is at) */
+typedef struct CvFSStreamLevel
+{
+    int tag; /* CV_NODE_SEQ or CV_NODE_MAP, plus CV_NODE_FLOW for the YAML flow collections */
+    int indent; /* YAML: the indentation of the block elements or the minimal one of the flow elements */
+    int count; /* the number of elements passed */
+    const CvStringHashNode* key;
+    const CvStringHashNode* xml_tag; /* XML: the tag that closes the collection */
+}
+CvFSStreamLevel;
+
+/* The state of the sequential reader (cv::FileStreamReader). Only the current node is kept;
+   it and everything parsed for it are allocated in scratch that is cleared on every move */
+typedef struct CvFSStream
+{
+    CvSeq* levels;
+    CvMemStorage* scratch;
+    char* ptr;
+    int eof;
+    int started; /* XML: the header has been parsed */
+    int is_first; /* YAML: the first stream is being read */
+    int root_done; /* YAML: the root of the current stream has been passed */
+    int type; /* the current node type or cv::FileStreamReader::END */
+    int is_open; /* the current node is a collection that has not been entered */
+    const CvStringHashNode* key;
+    const CvStringHashNode* type_name;
+    CvFileNode node; /* the current scalar or the collection parsed by cv::FileStreamReader::node() */
+    CvFSStreamLevel head;
+    int has_pending;
+    CvFileNode pending; /* XML: the first number or string of the text sequence, parsed ahead */
+}
+CvFSStream;
+
 typedef struct CvFileStorage
 {
     int flags;
     int is_xml;
+    int is_binary;
     int write_mode;
     int is_first;
     CvMemStorage* memstorage;
@@ -233,6 +302,11 @@ typedef struct CvFileStorage
     const char* errmsg;
     char errmsgbuf[128];
 
+    CvFSRawRun raw;
+    int64 file_pos;
+    CvFSMapping* mapping;
+    CvFSStream* stream;
+
     CvStartWriteStruct start_write_struct;
     CvEndWriteStruct end_write_struct;
     CvWriteInt write_int;
@@ -244,6 +318,9 @@ typedef struct CvFileStorage
 }
 CvFileStorage;
 
+static void icvBinEndWrite( CvFileStorage* fs );
+static void icvReleaseMapping( CvFSMapping* mapping );
+
 static void icvPuts( CvFileStorage* fs, const char* str )
 {
     CV_Assert( fs->file || fs->gzfile );
@@ -293,6 +370,10 @@ static void icvRewind( CvFileStorage* fs )
 #define CV_YML_INDENT_FLOW  1
 #define CV_FS_MAX_LEN 4096
 
+/* internal cvOpenFileStorage() flag used by cv::FileStreamReader: the file is not parsed at once,
+   but is kept open and read node by node */
+#define CV_STORAGE_READ_STREAM 64
+
 #define CV_FILE_STORAGE ('Y' + ('A' << 8) + ('M' << 16) + ('L' << 24))
 #define CV_IS_FILE_STORAGE(fs) ((fs) != 0 && (fs)->flags == CV_FILE_STORAGE)
 
@@ -496,9 +577,14 @@ cvReleaseFileStorage( CvFileStorage** p_fs )
                 while( fs->write_stack->total > 0 )
                     cvEndWriteStruct(fs);
             }
-            icvFSFlush(fs);
-            if( fs->is_xml )
-                icvPuts( fs, "</opencv_storage>\n" );
+            if( fs->is_binary )
+                icvBinEndWrite(fs);
+            else
+            {
+                icvFSFlush(fs);
+                if( fs->is_xml )
+                    icvPuts( fs, "</opencv_storage>\n" );
+            }
         }
 
         //icvFSReleaseCollection( fs->roots ); // delete all the user types recursively
@@ -508,6 +594,13 @@ cvReleaseFileStorage( CvFileStorage** p_fs )
         cvReleaseMemStorage( &fs->strstorage );
 
         cvFree( &fs->buffer_start );
+        cvFree( &fs->raw.buf );
+        icvReleaseMapping( fs->mapping );
+        if( fs->stream )
+        {
+            cvReleaseMemStorage( &fs->stream->scratch );
+            cvFree( &fs->stream );
+        }
         cvReleaseMemStorage( &fs->memstorage );
 
         memset( fs, 0, sizeof(*fs) );
@@ -939,12 +1032,10 @@ icvYMLSkipSpaces( CvFileStorage* fs, char* ptr, int min_indent, int max_comment_
 
 
 static char*
-icvYMLParseKey( CvFileStorage* fs, char* ptr,
-                CvFileNode* map_node, CvFileNode** value_placeholder )
+icvYMLParseKeyName( CvFileStorage* fs, char* ptr, CvStringHashNode** key )
 {
     char c;
     char *endptr = ptr - 1, *saveptr;
-    CvStringHashNode* str_hash_node;
 
     if( *ptr == '-' )
         CV_PARSE_ERROR( "Key may not start with \'-\'" );
@@ -963,14 +1054,24 @@ icvYMLParseKey( CvFileStorage* fs, char* ptr,
     if( endptr == ptr )
         CV_PARSE_ERROR( "An empty key" );
 
-    str_hash_node = cvGetHashedKey( fs, ptr, (int)(endptr - ptr), 1 );
-    *value_placeholder = cvGetFileNode( fs, map_node, str_hash_node, 1 );
+    *key = cvGetHashedKey( fs, ptr, (int)(endptr - ptr), 1 );
     ptr = saveptr;
 
     return ptr;
 }
 
 
+static char*
+icvYMLParseKey( CvFileStorage* fs, char* ptr,
+                CvFileNode* map_node, CvFileNode** value_placeholder )
+{
+    CvStringHashNode* str_hash_node = 0;
+    ptr = icvYMLParseKeyName( fs, ptr, &str_hash_node );
+    *value_placeholder = cvGetFileNode( fs, map_node, str_hash_node, 1 );
+    return ptr;
+}
+
+
 static char*
 icvYMLParseValue( CvFileStorage* fs, char* ptr, CvFileNode* node,
                   int parent_flags, int min_indent )
@@ -1756,6 +1857,129 @@ icvXMLSkipSpaces( CvFileStorage* fs, char* ptr, int mode )
 }
 
 
+/* parses a number or a string; value_type == CV_NODE_STRING prohibits the numbers */
+static char*
+icvXMLParseLiteral( CvFileStorage* fs, char* ptr, CvFileNode* elem, int value_type )
+{
+    char c = *ptr, d = ptr[1];
+    char* endptr;
+
+    if( value_type != CV_NODE_STRING &&
+        (cv_isdigit(c) || ((c == '-' || c == '+') &&
+        (cv_isdigit(d) || d == '.')) || (c == '.' && cv_isalnum(d))) ) // a number
+    {
+        double fval;
+        int ival;
+        endptr = ptr + (c == '-' || c == '+');
+        while( cv_isdigit(*endptr) )
+            endptr++;
+        if( *endptr == '.' || *endptr == 'e' )
+        {
+            fval = icv_strtod( fs, ptr, &endptr );
+            /*if( endptr == ptr || cv_isalpha(*endptr) )
+                icvProcessSpecialDouble( fs, ptr, &fval, &endptr ));*/
+            elem->tag = CV_NODE_REAL;
+            elem->data.f = fval;
+        }
+        else
+        {
+            ival = (int)strtol( ptr, &endptr, 0 );
+            elem->tag = CV_NODE_INT;
+            elem->data.i = ival;
+        }
+
+        if( endptr == ptr )
+            CV_PARSE_ERROR( "Invalid numeric value (inconsistent explicit type specification?)" );
+
+        ptr = endptr;
+    }
+    else
+    {
+        // string
+        char buf[CV_FS_MAX_LEN+16];
+        int i = 0, len, is_quoted = 0;
+        elem->tag = CV_NODE_STRING;
+        if( c == '\"' )
+            is_quoted = 1;
+        else
+            --ptr;
+
+        for( ;; )
+        {
+            c = *++ptr;
+            if( !cv_isalnum(c) )
+            {
+                if( c == '\"' )
+                {
+                    if( !is_quoted )
+                        CV_PARSE_ERROR( "Literal \" is not allowed within a string. Use &quot;" );
+                    ++ptr;
+                    break;
+                }
+                else if( !cv_isprint(c) || c == '<' || (!is_quoted && cv_isspace(c)))
+                {
+                    if( is_quoted )
+                        CV_PARSE_ERROR( "Closing \" is expected" );
+                    break;
+                }
+                else if( c == '\'' || c == '>' )
+                {
+                    CV_PARSE_ERROR( "Literal \' or > are not allowed. Use &apos; or &gt;" );
+                }
+                else if( c == '&' )
+                {
+                    if( *++ptr == '#' )
+                    {
+                        int val, base = 10;
+                        ptr++;
+                        if( *ptr == 'x' )
+                        {
+                            base = 16;
+                            ptr++;
+                        }
+                        val = (int)strtol( ptr, &endptr, base );
+                        if( (unsigned)val > (unsigned)255 ||
+                            !endptr || *endptr != ';' )
+                            CV_PARSE_ERROR( "Invalid numeric value in the string" );
+                        c = (char)val;
+                    }
+                    else
+                    {
+                        endptr = ptr;
+                        do c = *++endptr;
+                        while( cv_isalnum(c) );
+                        if( c != ';' )
+                            CV_PARSE_ERROR( "Invalid character in the symbol entity name" );
+                        len = (int)(endptr - ptr);
+                        if( len == 2 && memcmp( ptr, "lt", len ) == 0 )
+                            c = '<';
+                        else if( len == 2 && memcmp( ptr, "gt", len ) == 0 )
+                            c = '>';
+                        else if( len == 3 && memcmp( ptr, "amp", len ) == 0 )
+                            c = '&';
+                        else if( len == 4 && memcmp( ptr, "apos", len ) == 0 )
+                            c = '\'';
+                        else if( len == 4 && memcmp( ptr, "quot", len ) == 0 )
+                            c = '\"';
+                        else
+                        {
+                            memcpy( buf + i, ptr-1, len + 2 );
+                            i += len + 2;
+                        }
+                    }
+                    ptr = endptr;
+                }
+            }
+            buf[i++] = c;
+            if( i >= CV_FS_MAX_LEN )
+                CV_PARSE_ERROR( "Too long string literal" );
+        }
+        elem->data.str = cvMemStorageAllocString( fs->memstorage, buf, i );
+    }
+
+    return ptr;
+}
+
 static char*
 icvXMLParseTag( CvFileStorage* fs, char* ptr, CvStringHashNode** _tag,
                 CvAttrList** _list, int* _tag_type );
@@ -1774,7 +1998,6 @@ icvXMLParseValue( CvFileStorage* fs, char* ptr, CvFileNode* node,
     for(;;)
     {
         char c = *ptr, d;
-        char* endptr;
 
         if( cv_isspace(c) || c == '\0' || (c == '<' && ptr[1] == '!' && ptr[2] == '-') )
         {
@@ -1863,118 +2086,7 @@ icvXMLParseValue( CvFileStorage* fs, char* ptr, CvFileNode* node,
                 elem->info = 0;
             }
 
-            if( value_type != CV_NODE_STRING &&
-                (cv_isdigit(c) || ((c == '-' || c == '+') &&
-                (cv_isdigit(d) || d == '.')) || (c == '.' && cv_isalnum(d))) ) // a number
-            {
-                double fval;
-                int ival;
-                endptr = ptr + (c == '-' || c == '+');
-                while( cv_isdigit(*endptr) )
-                    endptr++;
-                if( *endptr == '.' || *endptr == 'e' )
-                {
-                    fval = icv_strtod( fs, ptr, &endptr );
-                    /*if( endptr == ptr || cv_isalpha(*endptr) )
-                        icvProcessSpecialDouble( fs, ptr, &fval, &endptr ));*/
-                    elem->tag = CV_NODE_REAL;
-                    elem->data.f = fval;
-                }
-                else
-                {
-                    ival = (int)strtol( ptr, &endptr, 0 );
-                    elem->tag = CV_NODE_INT;
-                    elem->data.i = ival;
-                }
-
-                if( endptr == ptr )
-                    CV_PARSE_ERROR( "Invalid numeric value (inconsistent explicit type specification?)" );
-
-                ptr = endptr;
-            }
-            else
-            {
-                // string
-                char buf[CV_FS_MAX_LEN+16];
-                int i = 0, len, is_quoted = 0;
-                elem->tag = CV_NODE_STRING;
-                if( c == '\"' )
-                    is_quoted = 1;
-                else
-                    --ptr;
-
-                for( ;; )
-                {
-                    c = *++ptr;
-                    if( !cv_isalnum(c) )
-                    {
-                        if( c == '\"' )
-                        {
-                            if( !is_quoted )
-                                CV_PARSE_ERROR( "Literal \" is not allowed within a string. Use &quot;" );
-                            ++ptr;
-                            break;
-                        }
-                        else if( !cv_isprint(c) || c == '<' || (!is_quoted && cv_isspace(c)))
-                        {
-                            if( is_quoted )
-                                CV_PARSE_ERROR( "Closing \" is expected" );
-                            break;
-                        }
-                        else if( c == '\'' || c == '>' )
-                        {
-                            CV_PARSE_ERROR( "Literal \' or > are not allowed. Use &apos; or &gt;" );
-                        }
-                        else if( c == '&' )
-                        {
-                            if( *++ptr == '#' )
-                            {
-                                int val, base = 10;
-                                ptr++;
-                                if( *ptr == 'x' )
-                                {
-                                    base = 16;
-                                    ptr++;
-                                }
-                                val = (int)strtol( ptr, &endptr, base );
-                                if( (unsigned)val > (unsigned)255 ||
-                                    !endptr || *endptr != ';' )
-                                    CV_PARSE_ERROR( "Invalid numeric value in the string" );
-                                c = (char)val;
-                            }
-                            else
-                            {
-                                endptr = ptr;
-                                do c = *++endptr;
-                                while( cv_isalnum(c) );
-                                if( c != ';' )
-                                    CV_PARSE_ERROR( "Invalid character in the symbol entity name" );
-                                len = (int)(endptr - ptr);
-                                if( len == 2 && memcmp( ptr, "lt", len ) == 0 )
-                                    c = '<';
-                                else if( len == 2 && memcmp( ptr, "gt", len ) == 0 )
-                                    c = '>';
-                                else if( len == 3 && memcmp( ptr, "amp", len ) == 0 )
-                                    c = '&';
-                                else if( len == 4 && memcmp( ptr, "apos", len ) == 0 )
-                                    c = '\'';
-                                else if( len == 4 && memcmp( ptr, "quot", len ) == 0 )
-                                    c = '\"';
-                                else
-                                {
-                                    memcpy( buf + i, ptr-1, len + 2 );
-                                    i += len + 2;
-                                }
-                            }
-                            ptr = endptr;
-                        }
-                    }
-                    buf[i++] = c;
-                    if( i >= CV_FS_MAX_LEN )
-                        CV_PARSE_ERROR( "Too long string literal" );
-                }
-                elem->data.str = cvMemStorageAllocString( fs->memstorage, buf, i );
-            }
+            ptr = icvXMLParseLiteral( fs, ptr, elem, value_type );
 
             if( !CV_NODE_IS_COLLECTION(value_type) && value_type != CV_NODE_NONE )
                 break;
@@ -2548,41 +2660,1366 @@ icvXMLWriteComment( CvFileStorage* fs, const char* comment, int eol_comment )
         len = (int)strlen(ptr);
     }
     else
-    {
-        strcpy( ptr, "<!--" );
-        len = 4;
-    }
+    {
+        strcpy( ptr, "<!--" );
+        len = 4;
+    }
+
+    fs->buffer = ptr + len;
+    ptr = icvXMLFlush(fs);
+
+    if( multiline )
+    {
+        while( comment )
+        {
+            if( eol )
+            {
+                ptr = icvFSResizeWriteBuffer( fs, ptr, (int)(eol - comment) + 1 );
+                memcpy( ptr, comment, eol - comment + 1 );
+                ptr += eol - comment;
+                comment = eol + 1;
+                eol = strchr( comment, '\n' );
+            }
+            else
+            {
+                len = (int)strlen(comment);
+                ptr = icvFSResizeWriteBuffer( fs, ptr, len );
+                memcpy( ptr, comment, len );
+                ptr += len;
+                comment = 0;
+            }
+            fs->buffer = ptr;
+            ptr = icvXMLFlush( fs );
+        }
+        sprintf( ptr, "-->" );
+        fs->buffer = ptr + 3;
+        icvXMLFlush( fs );
+    }
+}
+
+
+/****************************************************************************************\
+*                                Binary Parser and Emitter                               *
+\****************************************************************************************/
+
+/*
+  The binary storage consists of:
+    1. the header (CvFSBinHeader);
+    2. the raw blocks: the long numerical sequences written with cvWriteRawData(),
+       each one aligned by CV_FS_BIN_ALIGN bytes, so that they can be used in place;
+    3. the node tree in the pre-order.
+
+  Each tree record starts with the tag byte, that is CV_NODE_INT, CV_NODE_REAL, CV_NODE_STR,
+  CV_NODE_SEQ or CV_NODE_MAP (optionally with CV_NODE_FLOW), CV_FS_BIN_RAW or CV_FS_BIN_END.
+  The elements of maps are followed by the key, then by the value:
+    int32 for integers, float64 for reals, (uint32 length, characters) for strings and keys,
+    (type name, the elements, CV_FS_BIN_END) for collections and
+    (uint8 depth, int32 count, int64 offset) for the raw blocks.
+  Every stream is stored as a top-level map. The numbers are stored in the native byte order.
+*/
+
+#define CV_FS_BIN_SIGNATURE  "%CVBIN1\n"
+#define CV_FS_BIN_BYTE_ORDER 0x01020304
+#define CV_FS_BIN_RAW        CV_NODE_TYPE_MASK
+#define CV_FS_BIN_END        0x80
+#define CV_FS_BIN_ALIGN      64
+#define CV_FS_BIN_MIN_RAW    (1 << 12)
+
+/* set in the flags of a sequence, which elements are kept in a raw block (see CvFileNodeRaw) */
+#define CV_NODE_SEQ_RAW      512
+
+typedef struct CvFSBinHeader
+{
+    char signature[8];
+    unsigned byte_order;
+    unsigned header_size;
+    int64 tree_ofs;
+    int64 tree_size;
+}
+CvFSBinHeader;
+
+/* The sequence header used by the binary parser. While CV_NODE_SEQ_RAW is set, the sequence
+   has no blocks, and its "total" elements of the specified depth are stored at data,
+   inside the mapped file. The elements are converted to the regular file nodes
+   on the first access that needs them (see icvFSMaterializeRawSeq) */
+typedef struct CvFileNodeRaw
+{
+    CV_SEQUENCE_FIELDS()
+    int depth;
+    const uchar* data;
+}
+CvFileNodeRaw;
+
+static cv::Mutex icvFSRawSeqMutex;
+
+static CvFSMapping*
+icvMapFile( const char* filename )
+{
+    CvFSMapping* m = (CvFSMapping*)cvAlloc( sizeof(*m) );
+    memset( m, 0, sizeof(*m) );
+    m->refcount = 1;
+
+#if defined WIN32 || defined _WIN32 || defined WINCE
+    HANDLE hfile = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, 0,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+    if( hfile != INVALID_HANDLE_VALUE )
+    {
+        LARGE_INTEGER size;
+        if( GetFileSizeEx( hfile, &size ) && size.QuadPart > 0 )
+        {
+            m->size = (size_t)size.QuadPart;
+            // copy-on-write, so that the matrices referencing the file can be modified
+            HANDLE hmap = CreateFileMappingA( hfile, 0, PAGE_WRITECOPY, 0, 0, 0 );
+            if( hmap )
+            {
+                m->data = (uchar*)MapViewOfFile( hmap, FILE_MAP_COPY, 0, 0, 0 );
+                m->is_mapped = m->data != 0;
+                CloseHandle( hmap );
+            }
+        }
+        CloseHandle( hfile );
+    }
+#else
+    int fd = open( filename, O_RDONLY );
+    if( fd >= 0 )
+    {
+        struct stat st;
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            m->size = (size_t)st.st_size;
+            // copy-on-write, so that the matrices referencing the file can be modified
+            void* addr = mmap( 0, m->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+            if( addr != MAP_FAILED )
+            {
+                m->data = (uchar*)addr;
+                m->is_mapped = 1;
+            }
+        }
+        close( fd );
+    }
+#endif
+
+    if( !m->data && m->size > 0 )
+    {
+        FILE* f = fopen( filename, "rb" );
+        if( f )
+        {
+            m->data = (uchar*)cvAlloc( m->size );
+            if( fread( m->data, 1, m->size, f ) != m->size )
+                cvFree( &m->data );
+            fclose( f );
+        }
+    }
+
+    if( !m->data )
+        cvFree( &m );
+    return m;
+}
+
+static void
+icvReleaseMapping( CvFSMapping* m )
+{
+    if( !m || CV_XADD(&m->refcount, -1) != 1 )
+        return;
+    if( m->is_mapped )
+    {
+#if defined WIN32 || defined _WIN32 || defined WINCE
+        UnmapViewOfFile( m->data );
+#else
+        munmap( m->data, m->size );
+#endif
+    }
+    else
+        cvFree( &m->data );
+    cvFree( &m );
+}
+
+static inline void
+icvRawToNode( int depth, const uchar* ptr, CvFileNode* node )
+{
+    node->info = 0;
+    node->tag = CV_NODE_INT;
+    switch( depth )
+    {
+    case CV_8U:
+        node->data.i = *ptr;
+        break;
+    case CV_8S:
+        node->data.i = *(const schar*)ptr;
+        break;
+    case CV_16U:
+        node->data.i = *(const ushort*)ptr;
+        break;
+    case CV_16S:
+        node->data.i = *(const short*)ptr;
+        break;
+    case CV_32S:
+        node->data.i = *(const int*)ptr;
+        break;
+    case CV_32F:
+        node->tag = CV_NODE_REAL;
+        node->data.f = *(const float*)ptr;
+        break;
+    default:
+        node->tag = CV_NODE_REAL;
+        node->data.f = *(const double*)ptr;
+    }
+}
+
+static void
+icvFSPushRawElems( CvSeq* seq, int depth, const uchar* data, int count )
+{
+    const int block_size = 256;
+    CvFileNode buf[block_size];
+    int i, j, esz = CV_ELEM_SIZE(depth);
+
+    for( i = 0; i < count; i += block_size )
+    {
+        int n = MIN( count - i, block_size );
+        for( j = 0; j < n; j++ )
+            icvRawToNode( depth, data + (size_t)(i + j)*esz, buf + j );
+        cvSeqPushMulti( seq, buf, n );
+    }
+}
+
+/* converts the raw sequence to the regular one; the raw header is kept, only its content changes */
+static void
+icvFSMaterializeRawSeq( const CvFileNode* node )
+{
+    if( !node || !CV_NODE_IS_SEQ(node->tag) || !(node->data.seq->flags & CV_NODE_SEQ_RAW) )
+        return;
+
+    cv::AutoLock lock(icvFSRawSeqMutex);
+    CvFileNodeRaw* raw = (CvFileNodeRaw*)node->data.seq;
+    if( !(raw->flags & CV_NODE_SEQ_RAW) )
+        return;
+
+    // build the nodes aside and then substitute the blocks,
+    // so that the concurrent readers never see a partially filled sequence
+    CvSeq* seq = cvCreateSeq( 0, sizeof(CvSeq), sizeof(CvFileNode), raw->storage );
+    cvSetSeqBlockSize( seq, 8 );
+    icvFSPushRawElems( seq, raw->depth, raw->data, raw->total );
+    raw->first = seq->first;
+    raw->block_max = seq->block_max;
+    raw->ptr = seq->ptr;
+    raw->delta_elems = seq->delta_elems;
+    raw->free_blocks = seq->free_blocks;
+    raw->flags &= ~CV_NODE_SEQ_RAW;
+}
+
+
+static void
+icvBinPut( CvFileStorage* fs, const void* data, size_t len )
+{
+    if( fs->buffer + len > fs->buffer_end )
+    {
+        size_t used = fs->buffer - fs->buffer_start;
+        size_t new_size = MAX( (size_t)(fs->buffer_end - fs->buffer_start)*2, used + len );
+        char* new_buf = (char*)cvAlloc( new_size );
+        memcpy( new_buf, fs->buffer_start, used );
+        cvFree( &fs->buffer_start );
+        fs->buffer_start = new_buf;
+        fs->buffer = new_buf + used;
+        fs->buffer_end = new_buf + new_size;
+    }
+    memcpy( fs->buffer, data, len );
+    fs->buffer += len;
+}
+
+static void
+icvBinPutString( CvFileStorage* fs, const char* str, size_t len )
+{
+    unsigned n = (unsigned)len;
+    if( (size_t)n != len )
+        CV_Error( CV_StsOutOfRange, "Too long string" );
+    icvBinPut( fs, &n, sizeof(n) );
+    icvBinPut( fs, str, len );
+}
+
+static void
+icvBinWriteFile( CvFileStorage* fs, const void* data, size_t len )
+{
+    if( len > 0 && fwrite( data, 1, len, fs->file ) != len )
+        CV_Error( CV_StsError, "Could not write to the binary file storage" );
+    fs->file_pos += len;
+}
+
+static void
+icvBinAlignFile( CvFileStorage* fs, int alignment )
+{
+    static const uchar zeros[CV_FS_BIN_ALIGN] = {0};
+    size_t pad = (size_t)((alignment - fs->file_pos % alignment) % alignment);
+    icvBinWriteFile( fs, zeros, pad );
+}
+
+static void
+icvBinWriteNumber( CvFileStorage* fs, int depth, const uchar* ptr )
+{
+    switch( depth )
+    {
+    case CV_8U:
+        fs->write_int( fs, 0, *ptr );
+        break;
+    case CV_8S:
+        fs->write_int( fs, 0, *(const schar*)ptr );
+        break;
+    case CV_16U:
+        fs->write_int( fs, 0, *(const ushort*)ptr );
+        break;
+    case CV_16S:
+        fs->write_int( fs, 0, *(const short*)ptr );
+        break;
+    case CV_32S:
+        fs->write_int( fs, 0, *(const int*)ptr );
+        break;
+    case CV_32F:
+        fs->write_real( fs, 0, *(const float*)ptr );
+        break;
+    case CV_64F:
+        fs->write_real( fs, 0, *(const double*)ptr );
+        break;
+    default: /* reference */
+        fs->write_int( fs, 0, (int)*(const size_t*)ptr );
+    }
+}
+
+/* completes the active run of numbers: the short runs are stored as the regular scalar nodes */
+static void
+icvBinFlushRaw( CvFileStorage* fs )
+{
+    int depth = fs->raw.depth, count = fs->raw.count;
+    int64 ofs = fs->raw.ofs;
+
+    if( depth < 0 )
+        return;
+
+    fs->raw.depth = -1;
+    fs->raw.count = 0;
+    fs->raw.ofs = -1;
+
+    if( ofs >= 0 )
+    {
+        uchar hdr[] = { CV_FS_BIN_RAW, (uchar)depth };
+        icvBinPut( fs, hdr, sizeof(hdr) );
+        icvBinPut( fs, &count, sizeof(count) );
+        icvBinPut( fs, &ofs, sizeof(ofs) );
+        fs->struct_flags &= ~CV_NODE_EMPTY;
+    }
+    else
+    {
+        int i, esz = CV_ELEM_SIZE(depth);
+        for( i = 0; i < count; i++ )
+            icvBinWriteNumber( fs, depth, fs->raw.buf + i*esz );
+    }
+}
+
+static void
+icvBinWriteRawData( CvFileStorage* fs, const uchar* data, int len,
+                    const int* fmt_pairs, int fmt_pair_count )
+{
+    int depth = fmt_pairs[1];
+    CvFSRawRun* run = &fs->raw;
+
+    if( fmt_pair_count == 1 && depth != CV_USRTYPE1 && CV_NODE_IS_SEQ(fs->struct_flags) &&
+        (run->depth == depth || (run->depth < 0 && CV_NODE_IS_EMPTY(fs->struct_flags))) )
+    {
+        int esz = CV_ELEM_SIZE(depth);
+        int64 count = (int64)fmt_pairs[0]*len;
+        size_t size = (size_t)count*esz;
+
+        if( run->count + count > INT_MAX )
+            CV_Error( CV_StsOutOfRange, "Too many elements in the sequence" );
+
+        if( run->ofs < 0 && (size_t)run->count*esz + size <= CV_FS_BIN_MIN_RAW )
+            memcpy( run->buf + (size_t)run->count*esz, data, size );
+        else
+        {
+            if( run->ofs < 0 )
+            {
+                icvBinAlignFile( fs, CV_FS_BIN_ALIGN );
+                run->ofs = fs->file_pos;
+                icvBinWriteFile( fs, run->buf, (size_t)run->count*esz );
+            }
+            icvBinWriteFile( fs, data, size );
+        }
+        run->depth = depth;
+        run->count += (int)count;
+        return;
+    }
+
+    // structures, references and the numbers mixed with other nodes are stored element by element
+    int k, offset = 0;
+    for( ; len--; )
+    {
+        for( k = 0; k < fmt_pair_count; k++ )
+        {
+            int i, count = fmt_pairs[k*2], elem_type = fmt_pairs[k*2+1];
+            int elem_size = CV_ELEM_SIZE(elem_type);
+
+            offset = cvAlign( offset, elem_size );
+            for( i = 0; i < count; i++, offset += elem_size )
+                icvBinWriteNumber( fs, elem_type, data + offset );
+        }
+    }
+}
+
+static void
+icvBinStartElem( CvFileStorage* fs, const char* key, int tag )
+{
+    icvBinFlushRaw( fs );
+
+    if( CV_NODE_IS_MAP(fs->struct_flags) ^ (key != 0) )
+        CV_Error( CV_StsBadArg, "An attempt to add element without a key to a map, "
+                                "or add element with key to sequence" );
+
+    uchar t = (uchar)tag;
+    icvBinPut( fs, &t, 1 );
+    if( key )
+    {
+        size_t keylen = strlen(key);
+        if( keylen == 0 )
+            CV_Error( CV_StsBadArg, "The key is an empty" );
+        icvBinPutString( fs, key, keylen );
+    }
+    fs->struct_flags &= ~CV_NODE_EMPTY;
+    fs->is_first = 0;
+}
+
+static void
+icvBinStartWriteStruct( CvFileStorage* fs, const char* key, int struct_flags,
+                        const char* type_name CV_DEFAULT(0))
+{
+    struct_flags &= CV_NODE_TYPE_MASK|CV_NODE_FLOW;
+    if( !CV_NODE_IS_COLLECTION(struct_flags))
+        CV_Error( CV_StsBadArg,
+        "Some collection type - CV_NODE_SEQ or CV_NODE_MAP, must be specified" );
+
+    icvBinStartElem( fs, key, struct_flags );
+    icvBinPutString( fs, type_name ? type_name : "", type_name ? strlen(type_name) : 0 );
+
+    int parent_flags = fs->struct_flags;
+    cvSeqPush( fs->write_stack, &parent_flags );
+    fs->struct_flags = struct_flags | CV_NODE_EMPTY;
+}
+
+static void
+icvBinEndWriteStruct( CvFileStorage* fs )
+{
+    uchar tag = CV_FS_BIN_END;
+
+    if( fs->write_stack->total == 0 )
+        CV_Error( CV_StsError, "EndWriteStruct w/o matching StartWriteStruct" );
+
+    icvBinFlushRaw( fs );
+    icvBinPut( fs, &tag, 1 );
+    cvSeqPop( fs->write_stack, &fs->struct_flags );
+}
+
+static void
+icvBinStartNextStream( CvFileStorage* fs )
+{
+    if( !fs->is_first )
+    {
+        while( fs->write_stack->total > 0 )
+            icvBinEndWriteStruct(fs);
+
+        // close the top-level map of the current stream and open the next one
+        uchar tags[] = { CV_FS_BIN_END, CV_NODE_MAP };
+        icvBinPut( fs, tags, sizeof(tags) );
+        icvBinPutString( fs, "", 0 );
+        fs->struct_flags = CV_NODE_MAP + CV_NODE_EMPTY;
+        fs->is_first = 1;
+    }
+}
+
+static void
+icvBinWriteInt( CvFileStorage* fs, const char* key, int value )
+{
+    icvBinStartElem( fs, key, CV_NODE_INT );
+    icvBinPut( fs, &value, sizeof(value) );
+}
+
+static void
+icvBinWriteReal( CvFileStorage* fs, const char* key, double value )
+{
+    icvBinStartElem( fs, key, CV_NODE_REAL );
+    icvBinPut( fs, &value, sizeof(value) );
+}
+
+static void
+icvBinWriteString( CvFileStorage* fs, const char* key, const char* str, int /*quote*/ )
+{
+    if( !str )
+        CV_Error( CV_StsNullPtr, "Null string pointer" );
+    icvBinStartElem( fs, key, CV_NODE_STR );
+    icvBinPutString( fs, str, strlen(str) );
+}
+
+static void
+icvBinWriteComment( CvFileStorage*, const char*, int )
+{
+    // the comments are not preserved in the binary format
+}
+
+static void
+icvBinStartWrite( CvFileStorage* fs )
+{
+    CvFSBinHeader header;
+    memset( &header, 0, sizeof(header) ); // it is filled by icvBinEndWrite
+    icvBinWriteFile( fs, &header, sizeof(header) );
+
+    fs->raw.buf = (uchar*)cvAlloc( CV_FS_BIN_MIN_RAW );
+    fs->raw.depth = -1;
+    fs->raw.ofs = -1;
+
+    uchar tag = CV_NODE_MAP;
+    icvBinPut( fs, &tag, 1 );
+    icvBinPutString( fs, "", 0 );
+    fs->struct_flags = CV_NODE_MAP + CV_NODE_EMPTY;
+}
+
+static void
+icvBinEndWrite( CvFileStorage* fs )
+{
+    CvFSBinHeader header;
+    uchar tag = CV_FS_BIN_END;
+
+    icvBinPut( fs, &tag, 1 );
+    icvBinAlignFile( fs, 8 );
+
+    memcpy( header.signature, CV_FS_BIN_SIGNATURE, sizeof(header.signature) );
+    header.byte_order = CV_FS_BIN_BYTE_ORDER;
+    header.header_size = (unsigned)sizeof(header);
+    header.tree_ofs = fs->file_pos;
+    header.tree_size = fs->buffer - fs->buffer_start;
+    icvBinWriteFile( fs, fs->buffer_start, (size_t)header.tree_size );
+
+    fseek( fs->file, 0, SEEK_SET );
+    if( fwrite( &header, 1, sizeof(header), fs->file ) != sizeof(header) )
+        CV_Error( CV_StsError, "Could not write to the binary file storage" );
+}
+
+
+static const uchar*
+icvBinGet( CvFileStorage* fs, const uchar* ptr, const uchar* end, void* dst, size_t len )
+{
+    if( (size_t)(end - ptr) < len )
+        CV_PARSE_ERROR( "The node tree is truncated" );
+    memcpy( dst, ptr, len );
+    return ptr + len;
+}
+
+static const uchar*
+icvBinGetString( CvFileStorage* fs, const uchar* ptr, const uchar* end,
+                 const char** str, int* len )
+{
+    unsigned n = 0;
+    ptr = icvBinGet( fs, ptr, end, &n, sizeof(n) );
+    if( (size_t)(end - ptr) < n || n > INT_MAX )
+        CV_PARSE_ERROR( "The node tree is truncated" );
+    *str = (const char*)ptr;
+    *len = (int)n;
+    return ptr + n;
+}
+
+static const uchar*
+icvBinParseValue( CvFileStorage* fs, const uchar* ptr, const uchar* end,
+                  int tag, CvFileNode* node )
+{
+    const char* str = 0;
+    int len = 0;
+
+    memset( node, 0, sizeof(*node) );
+
+    switch( CV_NODE_TYPE(tag) )
+    {
+    case CV_NODE_INT:
+        ptr = icvBinGet( fs, ptr, end, &node->data.i, sizeof(node->data.i) );
+        node->tag = CV_NODE_INT;
+        break;
+    case CV_NODE_REAL:
+        ptr = icvBinGet( fs, ptr, end, &node->data.f, sizeof(node->data.f) );
+        node->tag = CV_NODE_REAL;
+        break;
+    case CV_NODE_STR:
+        ptr = icvBinGetString( fs, ptr, end, &str, &len );
+        node->data.str = cvMemStorageAllocString( fs->memstorage, str, len );
+        node->tag = CV_NODE_STR;
+        break;
+    case CV_NODE_SEQ:
+    case CV_NODE_MAP:
+        {
+        int is_map = CV_NODE_IS_MAP(tag);
+
+        ptr = icvBinGetString( fs, ptr, end, &str, &len );
+        if( len > 0 )
+        {
+            char type_name[CV_FS_MAX_LEN];
+            if( len >= CV_FS_MAX_LEN )
+                CV_PARSE_ERROR( "Too long type name" );
+            memcpy( type_name, str, len );
+            type_name[len] = '\0';
+            node->info = cvFindType( type_name );
+        }
+
+        if( is_map )
+            icvFSCreateCollection( fs, CV_NODE_MAP + (node->info ? CV_NODE_USER : 0), node );
+        else
+        {
+            // a larger header, in case the sequence turns out to be a raw block
+            node->data.seq = cvCreateSeq( 0, sizeof(CvFileNodeRaw), sizeof(CvFileNode), fs->memstorage );
+            cvSetSeqBlockSize( node->data.seq, 8 );
+            node->tag = CV_NODE_SEQ + (node->info ? CV_NODE_USER : 0);
+        }
+
+        for(;;)
+        {
+            uchar elem_tag = 0;
+            CvFileNode* elem = 0;
+
+            ptr = icvBinGet( fs, ptr, end, &elem_tag, 1 );
+            if( elem_tag == CV_FS_BIN_END )
+                break;
+
+            if( elem_tag == CV_FS_BIN_RAW )
+            {
+                uchar depth = 0;
+                int count = 0;
+                int64 ofs = 0;
+
+                if( is_map )
+                    CV_PARSE_ERROR( "Raw data block inside a map" );
+                ptr = icvBinGet( fs, ptr, end, &depth, sizeof(depth) );
+                ptr = icvBinGet( fs, ptr, end, &count, sizeof(count) );
+                ptr = icvBinGet( fs, ptr, end, &ofs, sizeof(ofs) );
+                if( depth > CV_64F || count < 0 || ofs < 0 ||
+                    (uint64)ofs + (uint64)count*CV_ELEM_SIZE(depth) > (uint64)fs->mapping->size )
+                    CV_PARSE_ERROR( "Invalid raw data block" );
+
+                const uchar* data = fs->mapping->data + ofs;
+                CvFileNodeRaw* raw = (CvFileNodeRaw*)node->data.seq;
+                if( raw->total == 0 && ptr < end && *ptr == CV_FS_BIN_END )
+                {
+                    // the whole sequence is the raw block; keep it in the file
+                    raw->flags |= CV_NODE_SEQ_RAW;
+                    raw->depth = depth;
+                    raw->data = data;
+                    raw->total = count;
+                }
+                else
+                    icvFSPushRawElems( (CvSeq*)raw, depth, data, count );
+                continue;
+            }
+
+            if( is_map )
+            {
+                ptr = icvBinGetString( fs, ptr, end, &str, &len );
+                elem = cvGetFileNode( fs, node, cvGetHashedKey( fs, str, len, 1 ), 1 );
+            }
+            else
+                elem = (CvFileNode*)cvSeqPush( node->data.seq, 0 );
+
+            if( CV_NODE_TYPE(elem_tag) == CV_NODE_NONE || CV_NODE_TYPE(elem_tag) == CV_NODE_REF ||
+                (elem_tag & ~(CV_NODE_TYPE_MASK|CV_NODE_FLOW)) != 0 )
+                CV_PARSE_ERROR( "Unknown node type" );
+            ptr = icvBinParseValue( fs, ptr, end, elem_tag, elem );
+            if( is_map )
+                elem->tag |= CV_NODE_NAMED;
+        }
+
+        if( CV_NODE_IS_FLOW(tag) )
+            node->data.seq->flags |= CV_NODE_SEQ_SIMPLE;
+        }
+        break;
+    default:
+        CV_PARSE_ERROR( "Unknown node type" );
+    }
+
+    return ptr;
+}
+
+static void
+icvBinParse( CvFileStorage* fs )
+{
+    CvFSBinHeader header;
+    const uchar* base = fs->mapping->data;
+    size_t size = fs->mapping->size;
+
+    if( size < sizeof(header) )
+        CV_PARSE_ERROR( "Too short binary file storage" );
+    memcpy( &header, base, sizeof(header) );
+
+    if( header.byte_order != CV_FS_BIN_BYTE_ORDER )
+        CV_PARSE_ERROR( "The binary file storage has been written with a different byte order" );
+    if( header.header_size != sizeof(header) || header.tree_ofs < (int64)sizeof(header) ||
+        header.tree_size < 0 || (uint64)header.tree_ofs + (uint64)header.tree_size > (uint64)size )
+        CV_PARSE_ERROR( "Invalid header of the binary file storage (probably, the file was not closed)" );
+
+    const uchar* ptr = base + header.tree_ofs;
+    const uchar* end = ptr + header.tree_size;
+
+    while( ptr < end )
+    {
+        if( *ptr != CV_NODE_MAP )
+            CV_PARSE_ERROR( "Only maps are supported as the top-level nodes" );
+        CvFileNode* root_node = (CvFileNode*)cvSeqPush( fs->roots, 0 );
+        ptr = icvBinParseValue( fs, ptr + 1, end, CV_NODE_MAP, root_node );
+    }
+}
+
+
+/****************************************************************************************\
+*                                     Stream Reader                                      *
+\****************************************************************************************/
+
+/* cv::FileStreamReader walks XML or YAML file node by node, in the depth-first order, instead
+   of building the whole tree when the file is opened. The keys, tags and scalars are parsed by
+   the functions above, while the document structure is tracked with the explicit stack of the
+   collections the reader is in. When the reader reaches a collection, it stops at it (is_open);
+   the next step enters it, but it may also be skipped or parsed into CvFileNode tree instead.
+
+   Everything parsed for the current node goes to stream->scratch, which is substituted for
+   fs->memstorage by CvFSStreamScope and is cleared on every move, so the memory footprint
+   is the size of the current node plus the set of the distinct keys met so far. */
+
+#define CV_FS_STREAM_END (-1) /* cv::FileStreamReader::END */
+
+static void
+icvFSStreamInit( CvFileStorage* fs )
+{
+    CvFSStream* stream = (CvFSStream*)cvAlloc( sizeof(*stream) );
+    memset( stream, 0, sizeof(*stream) );
+    fs->stream = stream;
+
+    stream->levels = cvCreateSeq( 0, sizeof(CvSeq), sizeof(CvFSStreamLevel), fs->memstorage );
+    stream->scratch = cvCreateMemStorage( 1 << 16 );
+    stream->ptr = fs->buffer_start;
+    stream->is_first = 1;
+    fs->roots = 0;
+}
+
+
+static void
+icvFSStreamClear( CvFileStorage* fs )
+{
+    // the literal parsed ahead is still to be returned
+    if( !fs->stream->has_pending )
+    {
+        cvClearMemStorage( fs->stream->scratch );
+        fs->roots = 0;
+    }
+}
+
+
+struct CvFSStreamScope
+{
+    CvFSStreamScope( CvFileStorage* _fs, bool clear ) : fs(_fs), storage(_fs->memstorage)
+    {
+        if( clear )
+            icvFSStreamClear( fs );
+        fs->memstorage = fs->stream->scratch;
+    }
+    ~CvFSStreamScope() { fs->memstorage = storage; }
+
+    CvFileStorage* fs;
+    CvMemStorage* storage;
+};
+
+
+static inline void
+icvFSStreamSetScalar( CvFileStorage* fs )
+{
+    fs->stream->type = CV_NODE_TYPE(fs->stream->node.tag);
+    fs->stream->is_open = 0;
+}
+
+
+static inline void
+icvFSStreamSetCollection( CvFileStorage* fs, int tag )
+{
+    fs->stream->head.tag = tag;
+    fs->stream->type = CV_NODE_TYPE(tag);
+    fs->stream->is_open = 1;
+}
+
+
+static void
+icvFSStreamEnter( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    CvFSStreamLevel* level = (CvFSStreamLevel*)cvSeqPush( stream->levels, &stream->head );
+    level->count = 0;
+    level->key = stream->key;
+    stream->is_open = 0;
+}
+
+
+static void
+icvFSStreamLeave( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    CvFSStreamLevel level;
+
+    cvSeqPop( stream->levels, &level );
+    memset( &stream->node, 0, sizeof(stream->node) );
+    stream->type = CV_FS_STREAM_END;
+    stream->key = level.key;
+    stream->type_name = 0;
+    stream->is_open = 0;
+}
+
+
+static int
+icvFSStreamEof( CvFileStorage* fs, char* ptr )
+{
+    CvFSStream* stream = fs->stream;
+    memset( &stream->node, 0, sizeof(stream->node) );
+    stream->ptr = ptr;
+    stream->eof = 1;
+    stream->type = CV_NODE_NONE;
+    stream->key = stream->type_name = 0;
+    stream->is_open = 0;
+    return 0;
+}
+
+
+/* parses YAML value at ptr (see icvYMLParseValue()); a collection is not parsed,
+   but only becomes the current node */
+static char*
+icvYMLStreamValue( CvFileStorage* fs, char* ptr, int parent_flags, int min_indent )
+{
+    CvFSStream* stream = fs->stream;
+    int is_parent_flow = CV_NODE_IS_FLOW(parent_flags);
+    int value_type = CV_NODE_NONE;
+    char c = ptr[0], d = ptr[1];
+    char* endptr;
+
+    memset( &stream->node, 0, sizeof(stream->node) );
+    stream->type_name = 0;
+    stream->head.xml_tag = 0;
+
+    if( c == '!' ) // explicit type specification
+    {
+        int is_user = d == '!' || d == '^', len;
+
+        ptr += is_user;
+        endptr = ptr++;
+        do d = *++endptr;
+        while( cv_isprint(d) && d != ' ' );
+        len = (int)(endptr - ptr);
+        if( len == 0 )
+            CV_PARSE_ERROR( "Empty type name" );
+
+        if( is_user )
+        {
+            stream->type_name = cvGetHashedKey( fs, ptr, len, 1 );
+            stream->node.info = cvFindType( stream->type_name->str.ptr );
+        }
+        else if( len == 3 && memcmp( ptr, "str", 3 ) == 0 )
+            value_type = CV_NODE_STRING;
+        else if( len == 3 && memcmp( ptr, "int", 3 ) == 0 )
+            value_type = CV_NODE_INT;
+        else if( len == 5 && memcmp( ptr, "float", 5 ) == 0 )
+            value_type = CV_NODE_REAL;
+
+        ptr = icvYMLSkipSpaces( fs, endptr, min_indent, INT_MAX );
+        c = ptr[0];
+        d = ptr[1];
+    }
+
+    if( value_type == CV_NODE_INT || value_type == CV_NODE_REAL )
+    {
+        stream->node.tag = value_type;
+        if( value_type == CV_NODE_REAL )
+            stream->node.data.f = icv_strtod( fs, ptr, &endptr );
+        else
+            stream->node.data.i = (int)strtol( ptr, &endptr, 0 );
+        if( !endptr || endptr == ptr )
+            CV_PARSE_ERROR( "Invalid numeric value (inconsistent explicit type specification?)" );
+        ptr = endptr;
+    }
+    else if( value_type == CV_NODE_STRING && c != '\'' && c != '\"' )
+    {
+        // unquoted string, which may contain ':' because of the explicit type
+        char* str_end;
+        endptr = ptr - 1;
+        do c = *++endptr;
+        while( cv_isprint(c) && (!is_parent_flow || (c != ',' && c != '}' && c != ']')) );
+        if( endptr == ptr )
+            CV_PARSE_ERROR( "Invalid character" );
+
+        str_end = endptr;
+        do c = *--str_end;
+        while( str_end > ptr && c == ' ' );
+        str_end++;
+        stream->node.tag = CV_NODE_STRING;
+        stream->node.data.str = cvMemStorageAllocString( fs->memstorage, ptr, (int)(str_end - ptr) );
+        ptr = endptr;
+    }
+    else if( c == '[' || c == '{' )
+    {
+        stream->head.indent = min_indent + !is_parent_flow;
+        icvFSStreamSetCollection( fs, CV_NODE_FLOW + (c == '{' ? CV_NODE_MAP : CV_NODE_SEQ) );
+        return ptr + 1;
+    }
+    else if( !is_parent_flow && c == '-' && !cv_isdigit(d) && d != '.' )
+    {
+        stream->head.indent = (int)(ptr - fs->buffer_start);
+        icvFSStreamSetCollection( fs, CV_NODE_SEQ );
+        return ptr;
+    }
+    else
+    {
+        int is_map = 0;
+
+        if( !is_parent_flow && c != '\'' && c != '\"' && !cv_isdigit(c) &&
+            !((c == '-' || c == '+') && (cv_isdigit(d) || d == '.')) &&
+            !(c == '.' && cv_isalnum(d)) )
+        {
+            // a block mapping starts with "key:"
+            endptr = ptr - 1;
+            do c = *++endptr;
+            while( cv_isprint(c) && c != ':' );
+            is_map = c == ':';
+        }
+
+        if( is_map )
+        {
+            stream->head.indent = (int)(ptr - fs->buffer_start);
+            icvFSStreamSetCollection( fs, CV_NODE_MAP );
+            return ptr;
+        }
+        ptr = icvYMLParseValue( fs, ptr, &stream->node, parent_flags, min_indent );
+    }
+
+    icvFSStreamSetScalar( fs );
+    return ptr;
+}
+
+
+static void
+icvYMLStreamNext( CvFileStorage* fs, CvFSStreamLevel* level )
+{
+    CvFSStream* stream = fs->stream;
+    CvStringHashNode* key = 0;
+    char* ptr = stream->ptr;
+
+    if( CV_NODE_IS_FLOW(level->tag) )
+    {
+        char d = CV_NODE_IS_MAP(level->tag) ? '}' : ']';
+
+        ptr = icvYMLSkipSpaces( fs, ptr, level->indent, INT_MAX );
+        if( *ptr == '}' || *ptr == ']' )
+        {
+            if( *ptr != d )
+                CV_PARSE_ERROR( "The wrong closing bracket" );
+            stream->ptr = ptr + 1;
+            icvFSStreamLeave( fs );
+            return;
+        }
+
+        if( level->count != 0 )
+        {
+            if( *ptr != ',' )
+                CV_PARSE_ERROR( "Missing , between the elements" );
+            ptr = icvYMLSkipSpaces( fs, ptr + 1, level->indent, INT_MAX );
+        }
+
+        if( CV_NODE_IS_MAP(level->tag) )
+        {
+            ptr = icvYMLParseKeyName( fs, ptr, &key );
+            ptr = icvYMLSkipSpaces( fs, ptr, level->indent, INT_MAX );
+        }
+        else if( *ptr == ']' )
+        {
+            stream->ptr = ptr + 1;
+            icvFSStreamLeave( fs );
+            return;
+        }
+
+        stream->key = key;
+        ptr = icvYMLStreamValue( fs, ptr, level->tag, level->indent );
+    }
+    else
+    {
+        if( level->count != 0 )
+        {
+            ptr = icvYMLSkipSpaces( fs, ptr, 0, INT_MAX );
+            if( ptr - fs->buffer_start < level->indent || memcmp( ptr, "...", 3 ) == 0 )
+            {
+                stream->ptr = ptr;
+                icvFSStreamLeave( fs );
+                return;
+            }
+            if( ptr - fs->buffer_start != level->indent )
+                CV_PARSE_ERROR( "Incorrect indentation" );
+        }
+
+        if( CV_NODE_IS_MAP(level->tag) )
+            ptr = icvYMLParseKeyName( fs, ptr, &key );
+        else if( *ptr++ != '-' )
+            CV_PARSE_ERROR( "Block sequence elements must be preceded with \'-\'" );
+
+        ptr = icvYMLSkipSpaces( fs, ptr, level->indent + 1, INT_MAX );
+        stream->key = key;
+        ptr = icvYMLStreamValue( fs, ptr, level->tag, level->indent + 1 );
+    }
+
+    stream->ptr = ptr;
+    level->count++;
+}
+
+
+/* moves to the top-level collection of the next YAML stream (see icvYMLParse()) */
+static int
+icvYMLStreamRoot( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    char* ptr = stream->ptr;
+
+    for(;;)
+    {
+        if( stream->root_done )
+        {
+            ptr = icvYMLSkipSpaces( fs, ptr, 0, INT_MAX );
+            if( fs->dummy_eof )
+                break;
+            ptr += 3;
+            stream->is_first = 0;
+            stream->root_done = 0;
+        }
+
+        for(;;)
+        {
+            ptr = icvYMLSkipSpaces( fs, ptr, 0, INT_MAX );
+
+            if( *ptr == '%' )
+            {
+                if( memcmp( ptr, "%YAML:", 6 ) == 0 &&
+                    memcmp( ptr, "%YAML:1.", 8 ) != 0 )
+                    CV_PARSE_ERROR( "Unsupported YAML version (it must be 1.x)" );
+                *ptr = '\0';
+            }
+            else if( *ptr == '-' && memcmp( ptr, "---", 3 ) == 0 )
+            {
+                ptr += 3;
+                break;
+            }
+            else if( *ptr == '-' && stream->is_first )
+                break;
+            else if( cv_isalnum(*ptr) || *ptr == '_' )
+            {
+                if( !stream->is_first )
+                    CV_PARSE_ERROR( "The YAML streams must start with '---', except the first one" );
+                break;
+            }
+            else if( fs->dummy_eof )
+                break;
+            else
+                CV_PARSE_ERROR( "Invalid or unsupported syntax" );
+        }
+
+        ptr = icvYMLSkipSpaces( fs, ptr, 0, INT_MAX );
+        stream->root_done = 1;
+        if( memcmp( ptr, "...", 3 ) != 0 )
+        {
+            stream->key = 0;
+            stream->ptr = icvYMLStreamValue( fs, ptr, CV_NODE_NONE, 0 );
+            if( !stream->is_open )
+                CV_PARSE_ERROR( "Only collections as YAML streams are supported by this parser" );
+            return 1;
+        }
+    }
+
+    return icvFSStreamEof( fs, ptr );
+}
+
+
+static char*
+icvXMLStreamEndTag( CvFileStorage* fs, char* ptr, const CvStringHashNode* tag )
+{
+    CvStringHashNode* key = 0;
+    CvAttrList* list = 0;
+    int tag_type = 0;
+
+    ptr = icvXMLParseTag( fs, ptr, &key, &list, &tag_type );
+    if( tag_type != CV_XML_CLOSING_TAG || key != tag )
+        CV_PARSE_ERROR( "Mismatched closing tag" );
+    return ptr;
+}
+
+
+/* parses the content of XML element that starts at ptr (see icvXMLParseValue()).
+   If it contains other elements or several literals, it becomes the current collection */
+static char*
+icvXMLStreamValue( CvFileStorage* fs, char* ptr, const CvStringHashNode* tag, CvAttrList* list )
+{
+    CvFSStream* stream = fs->stream;
+    const char* type_name = list ? cvAttrValue( list, "type_id" ) : 0;
+    int value_type = CV_NODE_NONE;
+    char c;
+
+    memset( &stream->node, 0, sizeof(stream->node) );
+    stream->type_name = 0;
+    stream->head.xml_tag = tag;
+
+    if( type_name )
+    {
+        if( strcmp( type_name, "str" ) == 0 )
+            value_type = CV_NODE_STRING;
+        else if( strcmp( type_name, "map" ) == 0 )
+            value_type = CV_NODE_MAP;
+        else if( strcmp( type_name, "seq" ) == 0 )
+            value_type = CV_NODE_SEQ;
+        else
+        {
+            stream->type_name = cvGetHashedKey( fs, type_name, -1, 1 );
+            stream->node.info = cvFindType( type_name );
+        }
+    }
+
+    c = *ptr;
+    if( cv_isspace(c) || c == '\0' || (c == '<' && ptr[1] == '!' && ptr[2] == '-') )
+    {
+        ptr = icvXMLSkipSpaces( fs, ptr, 0 );
+        c = *ptr;
+    }
+
+    if( c == '<' && ptr[1] != '/' )
+    {
+        // the nested elements; the first of them tells if it is a sequence or a mapping
+        int is_noname = ptr[1] == '_' && !cv_isalnum(ptr[2]) && ptr[2] != '_' && ptr[2] != '-';
+        if( value_type == CV_NODE_STRING )
+            CV_PARSE_ERROR( "The actual type is different from the specified type" );
+        icvFSStreamSetCollection( fs, CV_NODE_IS_COLLECTION(value_type) ? value_type :
+                                  is_noname ? CV_NODE_SEQ : CV_NODE_MAP );
+        return ptr;
+    }
+
+    if( c == '<' || c == '\0' )
+    {
+        // no content; the closing tag is left to the collection, if it is one
+        if( CV_NODE_IS_COLLECTION(value_type) )
+        {
+            icvFSStreamSetCollection( fs, value_type );
+            return ptr;
+        }
+        if( value_type != CV_NODE_NONE )
+            CV_PARSE_ERROR( "The actual type is different from the specified type" );
+        ptr = icvXMLStreamEndTag( fs, ptr, tag );
+        icvFSStreamSetScalar( fs );
+        return ptr;
+    }
+
+    ptr = icvXMLParseLiteral( fs, ptr, &stream->node, value_type );
+    c = *ptr;
+    if( !cv_isspace(c) && c != '\0' && c != '<' )
+        CV_PARSE_ERROR( "There should be space between literals" );
+    if( cv_isspace(c) || c == '\0' || (c == '<' && ptr[1] == '!' && ptr[2] == '-') )
+        ptr = icvXMLSkipSpaces( fs, ptr, 0 );
+
+    if( value_type == CV_NODE_MAP )
+        CV_PARSE_ERROR( "The actual type is different from the specified type" );
+
+    if( value_type == CV_NODE_SEQ ||
+        (value_type != CV_NODE_STRING && (ptr[0] != '<' || ptr[1] != '/')) )
+    {
+        // a sequence of literals; its first element has been parsed already
+        stream->pending = stream->node;
+        stream->has_pending = 1;
+        stream->node.tag = CV_NODE_NONE;
+        icvFSStreamSetCollection( fs, CV_NODE_SEQ );
+        return ptr;
+    }
+
+    ptr = icvXMLStreamEndTag( fs, ptr, tag );
+    icvFSStreamSetScalar( fs );
+    return ptr;
+}
+
+
+static void
+icvXMLStreamNext( CvFileStorage* fs, CvFSStreamLevel* level )
+{
+    CvFSStream* stream = fs->stream;
+    char* ptr = stream->ptr;
+    char c;
+
+    if( stream->has_pending )
+    {
+        stream->node = stream->pending;
+        stream->has_pending = 0;
+        stream->key = stream->type_name = 0;
+        icvFSStreamSetScalar( fs );
+        level->count++;
+        return;
+    }
+
+    c = *ptr;
+    if( cv_isspace(c) || c == '\0' || (c == '<' && ptr[1] == '!' && ptr[2] == '-') )
+    {
+        ptr = icvXMLSkipSpaces( fs, ptr, 0 );
+        c = *ptr;
+    }
+
+    if( c == '\0' || (c == '<' && ptr[1] == '/') )
+    {
+        stream->ptr = icvXMLStreamEndTag( fs, ptr, level->xml_tag );
+        icvFSStreamLeave( fs );
+        return;
+    }
+
+    if( c == '<' )
+    {
+        CvStringHashNode* key = 0;
+        CvAttrList* list = 0;
+        int tag_type = 0, is_noname;
+
+        ptr = icvXMLParseTag( fs, ptr, &key, &list, &tag_type );
+        if( tag_type == CV_XML_DIRECTIVE_TAG )
+            CV_PARSE_ERROR( "Directive tags are not allowed here" );
+        if( tag_type == CV_XML_EMPTY_TAG )
+            CV_PARSE_ERROR( "Empty tags are not supported" );
+
+        is_noname = key->str.len == 1 && key->str.ptr[0] == '_';
+        if( is_noname ^ CV_NODE_IS_SEQ(level->tag) )
+            CV_PARSE_ERROR( is_noname ? "Map element should have a name" :
+                            "Sequence element should not have name (use <_></_>)" );
+        stream->key = is_noname ? 0 : key;
+        ptr = icvXMLStreamValue( fs, ptr, key, list );
+    }
+    else
+    {
+        if( !CV_NODE_IS_SEQ(level->tag) )
+            CV_PARSE_ERROR( "Map element should have a name" );
+
+        memset( &stream->node, 0, sizeof(stream->node) );
+        stream->key = stream->type_name = 0;
+        ptr = icvXMLParseLiteral( fs, ptr, &stream->node, CV_NODE_NONE );
+        c = *ptr;
+        if( !cv_isspace(c) && c != '\0' && c != '<' )
+            CV_PARSE_ERROR( "There should be space between literals" );
+        icvFSStreamSetScalar( fs );
+    }
+
+    stream->ptr = ptr;
+    level->count++;
+}
+
+
+/* moves to the next <opencv_storage> element (see icvXMLParse()) */
+static int
+icvXMLStreamRoot( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    CvStringHashNode* key = 0;
+    CvAttrList* list = 0;
+    int tag_type = 0;
+    char* ptr = stream->ptr;
+
+    if( !stream->started )
+    {
+        ptr = icvXMLSkipSpaces( fs, ptr, CV_XML_INSIDE_TAG );
+        if( memcmp( ptr, "<?xml", 5 ) != 0 )
+            CV_PARSE_ERROR( "Valid XML should start with \'<?xml ...?>\'" );
+        ptr = icvXMLParseTag( fs, ptr, &key, &list, &tag_type );
+        stream->started = 1;
+    }
+
+    ptr = icvXMLSkipSpaces( fs, ptr, 0 );
+    if( *ptr == '\0' )
+        return icvFSStreamEof( fs, ptr );
+
+    ptr = icvXMLParseTag( fs, ptr, &key, &list, &tag_type );
+    if( tag_type != CV_XML_OPENING_TAG ||
+        strcmp(key->str.ptr,"opencv_storage") != 0 )
+        CV_PARSE_ERROR( "<opencv_storage> tag is missing" );
+
+    stream->key = 0;
+    stream->ptr = icvXMLStreamValue( fs, ptr, key, list );
+    return 1;
+}
+
+
+/* makes one step in the depth-first order; returns 0 at the end of file */
+static int
+icvFSStreamStep( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    CvFSStreamLevel* level;
+
+    if( stream->eof )
+        return 0;
+    if( stream->is_open )
+        icvFSStreamEnter( fs );
+    if( stream->levels->total == 0 )
+        return fs->is_xml ? icvXMLStreamRoot( fs ) : icvYMLStreamRoot( fs );
+
+    level = (CvFSStreamLevel*)cvGetSeqElem( stream->levels, -1 );
+    if( fs->is_xml )
+        icvXMLStreamNext( fs, level );
+    else
+        icvYMLStreamNext( fs, level );
+    return 1;
+}
 
-    fs->buffer = ptr + len;
-    ptr = icvXMLFlush(fs);
 
-    if( multiline )
+static void
+icvFSStreamParseCollection( CvFileStorage* fs, CvFileNode* node )
+{
+    CvFSStream* stream = fs->stream;
+    int tag = stream->type, is_simple = 1;
+    CvTypeInfo* info = stream->node.info;
+
+    memset( node, 0, sizeof(*node) );
+    icvFSCreateCollection( fs, tag + (info ? CV_NODE_USER : 0), node );
+    node->info = info;
+    icvFSStreamEnter( fs );
+
+    for(;;)
     {
-        while( comment )
-        {
-            if( eol )
-            {
-                ptr = icvFSResizeWriteBuffer( fs, ptr, (int)(eol - comment) + 1 );
-                memcpy( ptr, comment, eol - comment + 1 );
-                ptr += eol - comment;
-                comment = eol + 1;
-                eol = strchr( comment, '\n' );
-            }
-            else
-            {
-                len = (int)strlen(comment);
-                ptr = icvFSResizeWriteBuffer( fs, ptr, len );
-                memcpy( ptr, comment, len );
-                ptr += len;
-                comment = 0;
-            }
-            fs->buffer = ptr;
-            ptr = icvXMLFlush( fs );
-        }
-        sprintf( ptr, "-->" );
-        fs->buffer = ptr + 3;
-        icvXMLFlush( fs );
+        CvFileNode* elem;
+
+        icvFSStreamStep( fs );
+        if( stream->type == CV_FS_STREAM_END )
+            break;
+
+        elem = CV_NODE_IS_MAP(tag) ? cvGetFileNode( fs, node, stream->key, 1 ) :
+                                     (CvFileNode*)cvSeqPush( node->data.seq, 0 );
+        if( stream->is_open )
+            icvFSStreamParseCollection( fs, elem );
+        else
+            *elem = stream->node;
+        if( CV_NODE_IS_MAP(tag) )
+            elem->tag |= CV_NODE_NAMED;
+        is_simple &= !CV_NODE_IS_COLLECTION(elem->tag);
     }
+
+    if( is_simple )
+        node->data.seq->flags |= CV_NODE_SEQ_SIMPLE;
+}
+
+
+/* parses the current collection, the reader stays at it */
+static void
+icvFSStreamParseNode( CvFileStorage* fs )
+{
+    CvFSStream* stream = fs->stream;
+    int type = stream->type;
+    const CvStringHashNode* key = stream->key;
+    const CvStringHashNode* type_name = stream->type_name;
+    CvFileNode* root;
+
+    // cvGetFileNode() refuses to work without roots
+    fs->roots = cvCreateSeq( 0, sizeof(CvSeq), sizeof(CvFileNode), fs->memstorage );
+    root = (CvFileNode*)cvSeqPush( fs->roots, 0 );
+    icvFSStreamParseCollection( fs, root );
+
+    stream->node = *root;
+    stream->type = type;
+    stream->key = key;
+    stream->type_name = type_name;
+    stream->is_open = 0;
 }
 
 
@@ -2632,9 +4069,29 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
     fs->flags = CV_FILE_STORAGE;
     fs->write_mode = (flags & 3) != 0;
 
+    if( fs->write_mode )
+    {
+        int fmt = flags & CV_STORAGE_FORMAT_MASK;
+        if( fmt == CV_STORAGE_FORMAT_AUTO )
+        {
+            dot_pos = fs->filename + fnamelen - (isGZ ? 7 : 4);
+            fmt = dot_pos <= fs->filename ? CV_STORAGE_FORMAT_YAML :
+                memcmp( dot_pos, ".xml", 4) == 0 || memcmp(dot_pos, ".XML", 4) == 0 ||
+                memcmp(dot_pos, ".Xml", 4) == 0 ? CV_STORAGE_FORMAT_XML :
+                memcmp( dot_pos, ".bin", 4) == 0 || memcmp(dot_pos, ".BIN", 4) == 0 ?
+                CV_STORAGE_FORMAT_BINARY : CV_STORAGE_FORMAT_YAML;
+        }
+        fs->is_xml = fmt == CV_STORAGE_FORMAT_XML;
+        fs->is_binary = fmt == CV_STORAGE_FORMAT_BINARY;
+        if( fs->is_binary && (isGZ || append) )
+            CV_Error( CV_StsNotImplemented,
+                "Appending data to binary file storage or compressing it is not implemented" );
+    }
+
     if( !isGZ )
     {
-        fs->file = fopen(fs->filename, !fs->write_mode ? "rt" : !append ? "wt" : "a+t" );
+        fs->file = fopen(fs->filename, !fs->write_mode ? "rt" : fs->is_binary ? "wb" :
+                         !append ? "wt" : "a+t" );
         if( !fs->file )
             goto _exit_;
     }
@@ -2657,10 +4114,6 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         // and factor=4 for YAML ( as we use 4 bytes for non ASCII characters (e.g. \xAB))
         int buf_size = CV_FS_MAX_LEN*(fs->is_xml ? 6 : 4) + 1024;
 
-        dot_pos = fs->filename + fnamelen - (isGZ ? 7 : 4);
-        fs->is_xml = dot_pos > fs->filename && (memcmp( dot_pos, ".xml", 4) == 0 ||
-                      memcmp(dot_pos, ".XML", 4) == 0 || memcmp(dot_pos, ".Xml", 4) == 0);
-
         if( append )
             fseek( fs->file, 0, SEEK_END );
 
@@ -2671,7 +4124,18 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         fs->struct_flags = CV_NODE_EMPTY;
         fs->buffer_start = fs->buffer = (char*)cvAlloc( buf_size + 1024 );
         fs->buffer_end = fs->buffer_start + buf_size;
-        if( fs->is_xml )
+        if( fs->is_binary )
+        {
+            icvBinStartWrite( fs );
+            fs->start_write_struct = icvBinStartWriteStruct;
+            fs->end_write_struct = icvBinEndWriteStruct;
+            fs->write_int = icvBinWriteInt;
+            fs->write_real = icvBinWriteReal;
+            fs->write_string = icvBinWriteString;
+            fs->write_comment = icvBinWriteComment;
+            fs->start_next_stream = icvBinStartNextStream;
+        }
+        else if( fs->is_xml )
         {
             int file_size = fs->file ? (int)ftell( fs->file ) : 0;
             fs->strstorage = cvCreateChildMemStorage( fs->memstorage );
@@ -2755,9 +4219,32 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
     {
         int buf_size = 1 << 20;
         const char* yaml_signature = "%YAML:";
-        char buf[16];
+        char buf[16] = "";
         icvGets( fs, buf, sizeof(buf)-2 );
-        fs->is_xml = strncmp( buf, yaml_signature, strlen(yaml_signature) ) != 0;
+        fs->is_binary = strcmp( buf, CV_FS_BIN_SIGNATURE ) == 0;
+        fs->is_xml = !fs->is_binary && strncmp( buf, yaml_signature, strlen(yaml_signature) ) != 0;
+
+        fs->str_hash = cvCreateMap( 0, sizeof(CvStringHash),
+                        sizeof(CvStringHashNode), fs->memstorage, 256 );
+
+        fs->roots = cvCreateSeq( 0, sizeof(CvSeq),
+                        sizeof(CvFileNode), fs->memstorage );
+
+        if( fs->is_binary )
+        {
+            // the binary storage is parsed right in the mapped file,
+            // which is then kept for the matrices that reference it
+            if( isGZ )
+                CV_Error( CV_StsNotImplemented, "Compressed binary file storages are not supported" );
+            if( flags & CV_STORAGE_READ_STREAM )
+                CV_Error( CV_StsNotImplemented,
+                    "Binary file storages are memory-mapped; use FileStorage to read them" );
+            icvClose( fs );
+            fs->mapping = icvMapFile( fs->filename );
+            if( fs->mapping )
+                icvBinParse( fs );
+            goto _exit_;
+        }
 
         if( !isGZ )
         {
@@ -2768,17 +4255,17 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         }
         icvRewind(fs);
 
-        fs->str_hash = cvCreateMap( 0, sizeof(CvStringHash),
-                        sizeof(CvStringHashNode), fs->memstorage, 256 );
-
-        fs->roots = cvCreateSeq( 0, sizeof(CvSeq),
-                        sizeof(CvFileNode), fs->memstorage );
-
         fs->buffer = fs->buffer_start = (char*)cvAlloc( buf_size + 256 );
         fs->buffer_end = fs->buffer_start + buf_size;
         fs->buffer[0] = '\n';
         fs->buffer[1] = '\0';
 
+        if( flags & CV_STORAGE_READ_STREAM )
+        {
+            icvFSStreamInit( fs );
+            goto _exit_;
+        }
+
         //mode = cvGetErrMode();
         //cvSetErrMode( CV_ErrModeSilent );
         if( fs->is_xml )
@@ -2794,11 +4281,11 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
 _exit_:
     if( fs )
     {
-        if( cvGetErrStatus() < 0 || (!fs->file && !fs->gzfile) )
+        if( cvGetErrStatus() < 0 || (!fs->file && !fs->gzfile && !fs->mapping) )
         {
             cvReleaseFileStorage( &fs );
         }
-        else if( !fs->write_mode )
+        else if( !fs->write_mode && !fs->stream )
         {
             icvClose(fs);
         }
@@ -3000,6 +4487,12 @@ cvWriteRawData( CvFileStorage* fs, const void* _data, int len, const char* dt )
         len = 1;
     }
 
+    if( fs->is_binary )
+    {
+        icvBinWriteRawData( fs, (const uchar*)data0, len, fmt_pairs, fmt_pair_count );
+        return;
+    }
+
     for(;len--;)
     {
         for( k = 0; k < fmt_pair_count; k++ )
@@ -3088,7 +4581,19 @@ cvStartReadRawData( const CvFileStorage* fs, const CvFileNode* src, CvSeqReader*
     }
     else if( node_type == CV_NODE_SEQ )
     {
-        cvStartReadSeq( src->data.seq, reader, 0 );
+        if( src->data.seq->flags & CV_NODE_SEQ_RAW )
+        {
+            // read the raw block directly; delta_index < 0 marks such a reader and keeps the depth
+            const CvFileNodeRaw* raw = (const CvFileNodeRaw*)src->data.seq;
+            memset( reader, 0, sizeof(*reader) );
+            reader->header_size = sizeof(*reader);
+            reader->seq = src->data.seq;
+            reader->ptr = reader->block_min = (schar*)raw->data;
+            reader->block_max = reader->ptr + (size_t)raw->total*CV_ELEM_SIZE(raw->depth);
+            reader->delta_index = -1 - raw->depth;
+        }
+        else
+            cvStartReadSeq( src->data.seq, reader, 0 );
     }
     else if( node_type == CV_NODE_NONE )
     {
@@ -3099,6 +4604,112 @@ cvStartReadRawData( const CvFileStorage* fs, const CvFileNode* src, CvSeqReader*
 }
 
 
+/* stores the numerical scalar node as an element of the specified depth
+   and returns the position after the element */
+static inline char*
+icvWriteNodeElem( const CvFileNode* node, int elem_type, char* data )
+{
+    if( CV_NODE_IS_INT(node->tag) )
+    {
+        int ival = node->data.i;
+
+        switch( elem_type )
+        {
+        case CV_8U:
+            *(uchar*)data = CV_CAST_8U(ival);
+            data++;
+            break;
+        case CV_8S:
+            *(char*)data = CV_CAST_8S(ival);
+            data++;
+            break;
+        case CV_16U:
+            *(ushort*)data = CV_CAST_16U(ival);
+            data += sizeof(ushort);
+            break;
+        case CV_16S:
+            *(short*)data = CV_CAST_16S(ival);
+            data += sizeof(short);
+            break;
+        case CV_32S:
+            *(int*)data = ival;
+            data += sizeof(int);
+            break;
+        case CV_32F:
+            *(float*)data = (float)ival;
+            data += sizeof(float);
+            break;
+        case CV_64F:
+            *(double*)data = (double)ival;
+            data += sizeof(double);
+            break;
+        case CV_USRTYPE1: /* reference */
+            *(size_t*)data = ival;
+            data += sizeof(size_t);
+            break;
+        default:
+            assert(0);
+            return data;
+        }
+    }
+    else if( CV_NODE_IS_REAL(node->tag) )
+    {
+        double fval = node->data.f;
+        int ival;
+
+        switch( elem_type )
+        {
+        case CV_8U:
+            ival = cvRound(fval);
+            *(uchar*)data = CV_CAST_8U(ival);
+            data++;
+            break;
+        case CV_8S:
+            ival = cvRound(fval);
+            *(char*)data = CV_CAST_8S(ival);
+            data++;
+            break;
+        case CV_16U:
+            ival = cvRound(fval);
+            *(ushort*)data = CV_CAST_16U(ival);
+            data += sizeof(ushort);
+            break;
+        case CV_16S:
+            ival = cvRound(fval);
+            *(short*)data = CV_CAST_16S(ival);
+            data += sizeof(short);
+            break;
+        case CV_32S:
+            ival = cvRound(fval);
+            *(int*)data = ival;
+            data += sizeof(int);
+            break;
+        case CV_32F:
+            *(float*)data = (float)fval;
+            data += sizeof(float);
+            break;
+        case CV_64F:
+            *(double*)data = fval;
+            data += sizeof(double);
+            break;
+        case CV_USRTYPE1: /* reference */
+            ival = cvRound(fval);
+            *(size_t*)data = ival;
+            data += sizeof(size_t);
+            break;
+        default:
+            assert(0);
+            return data;
+        }
+    }
+    else
+        CV_Error( CV_StsError,
+        "The sequence element is not a numerical scalar" );
+
+    return data;
+}
+
+
 CV_IMPL void
 cvReadRawDataSlice( const CvFileStorage* fs, CvSeqReader* reader,
                     int len, void* _data, const char* dt )
@@ -3106,6 +4717,8 @@ cvReadRawDataSlice( const CvFileStorage* fs, CvSeqReader* reader,
     char* data0 = (char*)_data;
     int fmt_pairs[CV_FS_MAX_FMT_PAIRS*2], k = 0, fmt_pair_count;
     int i = 0, offset = 0, count = 0;
+    int raw_depth = -1, raw_esz = 0;
+    CvFileNode raw_node;
 
     CV_CHECK_FILE_STORAGE( fs );
 
@@ -3117,6 +4730,24 @@ cvReadRawDataSlice( const CvFileStorage* fs, CvSeqReader* reader,
 
     fmt_pair_count = icvDecodeFormat( dt, fmt_pairs, CV_FS_MAX_FMT_PAIRS );
 
+    if( reader->seq && reader->delta_index < 0 )
+    {
+        raw_depth = -1 - reader->delta_index;
+        raw_esz = CV_ELEM_SIZE(raw_depth);
+        if( len < 0 || (size_t)(reader->block_max - reader->ptr) < (size_t)len*raw_esz )
+            CV_Error( CV_StsOutOfRange, "The slice is out of the sequence" );
+
+        if( fmt_pair_count == 1 && fmt_pairs[1] == raw_depth )
+        {
+            if( len % fmt_pairs[0] != 0 )
+                CV_Error( CV_StsBadSize,
+                "The sequence slice does not fit an integer number of records" );
+            memcpy( data0, reader->ptr, (size_t)len*raw_esz );
+            reader->ptr += (size_t)len*raw_esz;
+            return;
+        }
+    }
+
     for(;;)
     {
         for( k = 0; k < fmt_pair_count; k++ )
@@ -3132,104 +4763,18 @@ cvReadRawDataSlice( const CvFileStorage* fs, CvSeqReader* reader,
             for( i = 0; i < count; i++ )
             {
                 CvFileNode* node = (CvFileNode*)reader->ptr;
-                if( CV_NODE_IS_INT(node->tag) )
+                if( raw_depth >= 0 )
                 {
-                    int ival = node->data.i;
-
-                    switch( elem_type )
-                    {
-                    case CV_8U:
-                        *(uchar*)data = CV_CAST_8U(ival);
-                        data++;
-                        break;
-                    case CV_8S:
-                        *(char*)data = CV_CAST_8S(ival);
-                        data++;
-                        break;
-                    case CV_16U:
-                        *(ushort*)data = CV_CAST_16U(ival);
-                        data += sizeof(ushort);
-                        break;
-                    case CV_16S:
-                        *(short*)data = CV_CAST_16S(ival);
-                        data += sizeof(short);
-                        break;
-                    case CV_32S:
-                        *(int*)data = ival;
-                        data += sizeof(int);
-                        break;
-                    case CV_32F:
-                        *(float*)data = (float)ival;
-                        data += sizeof(float);
-                        break;
-                    case CV_64F:
-                        *(double*)data = (double)ival;
-                        data += sizeof(double);
-                        break;
-                    case CV_USRTYPE1: /* reference */
-                        *(size_t*)data = ival;
-                        data += sizeof(size_t);
-                        break;
-                    default:
-                        assert(0);
-                        return;
-                    }
+                    icvRawToNode( raw_depth, (const uchar*)reader->ptr, &raw_node );
+                    node = &raw_node;
                 }
-                else if( CV_NODE_IS_REAL(node->tag) )
-                {
-                    double fval = node->data.f;
-                    int ival;
 
-                    switch( elem_type )
-                    {
-                    case CV_8U:
-                        ival = cvRound(fval);
-                        *(uchar*)data = CV_CAST_8U(ival);
-                        data++;
-                        break;
-                    case CV_8S:
-                        ival = cvRound(fval);
-                        *(char*)data = CV_CAST_8S(ival);
-                        data++;
-                        break;
-                    case CV_16U:
-                        ival = cvRound(fval);
-                        *(ushort*)data = CV_CAST_16U(ival);
-                        data += sizeof(ushort);
-                        break;
-                    case CV_16S:
-                        ival = cvRound(fval);
-                        *(short*)data = CV_CAST_16S(ival);
-                        data += sizeof(short);
-                        break;
-                    case CV_32S:
-                        ival = cvRound(fval);
-                        *(int*)data = ival;
-                        data += sizeof(int);
-                        break;
-                    case CV_32F:
-                        *(float*)data = (float)fval;
-                        data += sizeof(float);
-                        break;
-                    case CV_64F:
-                        *(double*)data = fval;
-                        data += sizeof(double);
-                        break;
-                    case CV_USRTYPE1: /* reference */
-                        ival = cvRound(fval);
-                        *(size_t*)data = ival;
-                        data += sizeof(size_t);
-                        break;
-                    default:
-                        assert(0);
-                        return;
-                    }
-                }
-                else
-                    CV_Error( CV_StsError,
-                    "The sequence element is not a numerical scalar" );
+                data = icvWriteNodeElem( node, elem_type, data );
 
-                CV_NEXT_SEQ_ELEM( sizeof(CvFileNode), *reader );
+                if( raw_depth >= 0 )
+                    reader->ptr += raw_esz;
+                else
+                    CV_NEXT_SEQ_ELEM( sizeof(CvFileNode), *reader );
                 if( !--len )
                     goto end_loop;
             }
@@ -3274,6 +4819,14 @@ icvWriteCollection( CvFileStorage* fs, const CvFileNode* node )
     int is_map = CV_NODE_IS_MAP(node->tag);
     CvSeqReader reader;
 
+    if( !is_map && (node->data.seq->flags & CV_NODE_SEQ_RAW) )
+    {
+        const CvFileNodeRaw* raw = (const CvFileNodeRaw*)node->data.seq;
+        char dt[] = { icvTypeSymbol[raw->depth], '\0' };
+        cvWriteRawData( fs, raw->data, total, dt );
+        return;
+    }
+
     cvStartReadSeq( node->data.seq, &reader, 0 );
 
     for( i = 0; i < total; i++ )
@@ -3434,7 +4987,7 @@ icvReadMat( CvFileStorage* fs, CvFileNode* node )
     cols = cvReadIntByName( fs, node, "cols", -1 );
     dt = cvReadStringByName( fs, node, "dt", 0 );
 
-    if( rows < 0 || cols < 0 || dt < 0 )
+    if( rows < 0 || cols < 0 || !dt )
         CV_Error( CV_StsError, "Some of essential matrix attributes are absent" );
 
     elem_type = icvDecodeSimpleFormat( dt );
@@ -4500,7 +6053,7 @@ icvReadGraph( CvFileStorage* fs, CvFileNode* node )
     if( header_dt )
         header_size = icvCalcElemSize( header_dt, header_size );
 
-    if( vtx_dt > 0 )
+    if( vtx_dt )
     {
         src_vtx_size = icvCalcElemSize( vtx_dt, 0 );
         vtx_size = icvCalcElemSize( vtx_dt, vtx_size );
@@ -5163,6 +6716,7 @@ FileNode FileNode::operator[](const char* nodename) const
 
 FileNode FileNode::operator[](int i) const
 {
+    icvFSMaterializeRawSeq( node );
     return isSeq() ? FileNode(fs, (CvFileNode*)cvGetSeqElem(node->data.seq, i)) :
         i == 0 ? *this : FileNode();
 }
@@ -5198,6 +6752,7 @@ FileNodeIterator::FileNodeIterator(const CvFileStorage* _fs,
         container = _node;
         if( !(_node->tag & FileNode::USER) && (node_type == FileNode::SEQ || node_type == FileNode::MAP) )
         {
+            icvFSMaterializeRawSeq( _node );
             cvStartReadSeq( _node->data.seq, &reader );
             remaining = FileNode(_fs, _node).size();
         }
@@ -5308,6 +6863,145 @@ FileNodeIterator& FileNodeIterator::readRaw( const string& fmt, uchar* vec, size
     return *this;
 }
 
+FileStreamReader::FileStreamReader() {}
+
+FileStreamReader::FileStreamReader(const string& filename)
+{
+    open(filename);
+}
+
+FileStreamReader::~FileStreamReader()
+{
+    release();
+}
+
+bool FileStreamReader::open(const string& filename)
+{
+    release();
+    fs = Ptr<CvFileStorage>(cvOpenFileStorage( filename.c_str(), 0,
+                            CV_STORAGE_READ | CV_STORAGE_READ_STREAM ));
+    return isOpened();
+}
+
+bool FileStreamReader::isOpened() const
+{
+    return !fs.empty();
+}
+
+void FileStreamReader::release()
+{
+    fs.release();
+}
+
+bool FileStreamReader::next()
+{
+    CV_Assert( isOpened() );
+    CvFSStreamScope scope( fs, true );
+    return icvFSStreamStep( fs ) != 0;
+}
+
+int FileStreamReader::type() const
+{
+    return !fs.empty() ? fs->stream->type : FileNode::NONE;
+}
+
+string FileStreamReader::name() const
+{
+    const CvStringHashNode* key = !fs.empty() ? fs->stream->key : 0;
+    return key ? string(key->str.ptr, key->str.len) : string();
+}
+
+string FileStreamReader::typeName() const
+{
+    const CvStringHashNode* type_name = !fs.empty() ? fs->stream->type_name : 0;
+    return type_name ? string(type_name->str.ptr, type_name->str.len) : string();
+}
+
+int FileStreamReader::level() const
+{
+    return !fs.empty() ? fs->stream->levels->total : 0;
+}
+
+FileNode FileStreamReader::node()
+{
+    CV_Assert( isOpened() );
+    if( fs->stream->is_open )
+    {
+        CvFSStreamScope scope( fs, false );
+        icvFSStreamParseNode( fs );
+    }
+    return FileNode( fs, &fs->stream->node );
+}
+
+void FileStreamReader::skip()
+{
+    CV_Assert( isOpened() );
+    CvFSStream* stream = fs->stream;
+    if( !stream->is_open )
+        return;
+
+    CvFSStreamScope scope( fs, true );
+    icvFSStreamEnter( fs );
+
+    // stop at the END that brings the reader out of the skipped collection
+    int depth = stream->levels->total;
+    while( icvFSStreamStep( fs ) &&
+           (stream->type != END || stream->levels->total >= depth) )
+        icvFSStreamClear( fs );
+}
+
+size_t FileStreamReader::readRaw( const string& fmt, uchar* vec, size_t maxCount )
+{
+    CV_Assert( isOpened() );
+    CvFSStream* stream = fs->stream;
+    CvFSStreamScope scope( fs, false );
+    int fmt_pairs[CV_FS_MAX_FMT_PAIRS*2];
+    int fmt_pair_count = icvDecodeFormat( fmt.c_str(), fmt_pairs, CV_FS_MAX_FMT_PAIRS );
+    size_t count = 0, offset = 0;
+
+    // empty sequences are written to XML as untyped empty tags
+    if( stream->eof || stream->type == END || stream->type == FileNode::NONE )
+        return 0;
+
+    if( stream->is_open )
+    {
+        if( stream->type != FileNode::SEQ )
+            CV_Error( CV_StsBadArg, "The current node is not a sequence" );
+        icvFSStreamEnter( fs );
+    }
+
+    if( stream->levels->total == 0 ||
+        !CV_NODE_IS_SEQ(((CvFSStreamLevel*)cvGetSeqElem( stream->levels, -1 ))->tag) )
+        CV_Error( CV_StsBadArg, "The reader is not in a sequence" );
+
+    for( ; count < maxCount; count++ )
+    {
+        for( int k = 0; k < fmt_pair_count; k++ )
+        {
+            int elem_type = fmt_pairs[k*2+1];
+            offset = alignSize( offset, CV_ELEM_SIZE(elem_type) );
+
+            for( int i = 0; i < fmt_pairs[k*2]; i++ )
+            {
+                icvFSStreamClear( fs );
+                icvFSStreamStep( fs );
+                if( stream->type == END )
+                {
+                    if( k > 0 || i > 0 )
+                        CV_Error( CV_StsBadSize,
+                        "The sequence slice does not fit an integer number of records" );
+                    return count;
+                }
+                if( stream->is_open )
+                    CV_Error( CV_StsError, "The sequence element is not a numerical scalar" );
+                offset = icvWriteNodeElem( &stream->node, elem_type, (char*)vec + offset ) - (char*)vec;
+            }
+        }
+    }
+
+    return count;
+}
+
     
 void write( FileStorage& fs, const string& name, int value )
 { cvWriteInt( *fs, name.size() ? name.c_str() : 0, value ); }
@@ -5365,6 +7059,107 @@ WriteStructContext::WriteStructContext(FileStorage& _fs, const string& name,
     
 WriteStructContext::~WriteStructContext() { cvEndWriteStruct(**fs); }    
 
+
+/*
+ The allocator of the matrices that reference the mapped binary storage.
+ Each such matrix has its own reference counter, which holds a reference to the mapping.
+ If the matrix is later re-allocated with Mat::create(), it gets a regular heap buffer.
+*/
+class MappedStorageAllocator : public MatAllocator
+{
+public:
+    struct Ref
+    {
+        int refcount; // must be the first field, Mat::refcount points to it
+        CvFSMapping* mapping;
+    };
+
+    void allocate(int dims, const int* sizes, int type, int*& refcount,
+                  uchar*& datastart, uchar*& data, size_t* step)
+    {
+        size_t total = CV_ELEM_SIZE(type);
+        for( int i = dims-1; i >= 0; i-- )
+        {
+            step[i] = total;
+            total *= sizes[i];
+        }
+        Ref* ref = new Ref;
+        ref->refcount = 1;
+        ref->mapping = 0;
+        datastart = data = (uchar*)fastMalloc(total);
+        refcount = &ref->refcount;
+    }
+
+    void deallocate(int* refcount, uchar* datastart, uchar*)
+    {
+        Ref* ref = (Ref*)refcount;
+        if( ref->mapping )
+            icvReleaseMapping(ref->mapping);
+        else
+            fastFree(datastart);
+        delete ref;
+    }
+};
+
+static MappedStorageAllocator mappedStorageAllocator;
+
+// makes the matrix header for the matrix stored as the raw block in the mapped file
+static bool readMappedMat( const FileNode& node, Mat& mat )
+{
+    CvFileStorage* fs = (CvFileStorage*)node.fs;
+    const CvFileNode* n = node.node;
+
+    if( !fs || !fs->mapping || !CV_NODE_IS_MAP(n->tag) || !CV_NODE_IS_USER(n->tag) || !n->info )
+        return false;
+    bool isND = strcmp(n->info->type_name, CV_TYPE_NAME_MATND) == 0;
+    if( !isND && strcmp(n->info->type_name, CV_TYPE_NAME_MAT) != 0 )
+        return false;
+
+    const CvFileNode* data = cvGetFileNodeByName(fs, n, "data");
+    const char* dt = cvReadStringByName(fs, n, "dt", 0);
+    if( !data || !dt || !CV_NODE_IS_SEQ(data->tag) || !(data->data.seq->flags & CV_NODE_SEQ_RAW) )
+        return false;
+    const CvFileNodeRaw* raw = (const CvFileNodeRaw*)data->data.seq;
+    int type = icvDecodeSimpleFormat(dt);
+    if( CV_MAT_DEPTH(type) != raw->depth )
+        return false;
+
+    int dims = 2, sizes[CV_MAX_DIM];
+    if( isND )
+    {
+        const CvFileNode* sizesNode = cvGetFileNodeByName(fs, n, "sizes");
+        dims = !sizesNode ? 0 : CV_NODE_IS_SEQ(sizesNode->tag) ? sizesNode->data.seq->total :
+            CV_NODE_IS_INT(sizesNode->tag) ? 1 : 0;
+        if( dims <= 0 || dims > CV_MAX_DIM )
+            return false;
+        cvReadRawData(fs, sizesNode, sizes, "i");
+    }
+    else
+    {
+        sizes[0] = cvReadIntByName(fs, n, "rows", -1);
+        sizes[1] = cvReadIntByName(fs, n, "cols", -1);
+    }
+
+    int64 total = CV_MAT_CN(type);
+    for( int i = 0; i < dims; i++ )
+    {
+        if( sizes[i] < 0 )
+            return false;
+        total *= sizes[i];
+    }
+    if( total == 0 || total != raw->total )
+        return false;
+
+    Mat m(dims, sizes, type, (void*)raw->data);
+    MappedStorageAllocator::Ref* ref = new MappedStorageAllocator::Ref;
+    ref->refcount = 1;
+    ref->mapping = fs->mapping;
+    CV_XADD(&fs->mapping->refcount, 1);
+    m.refcount = &ref->refcount;
+    m.allocator = &mappedStorageAllocator;
+    mat = m;
+    return true;
+}
     
 void read( const FileNode& node, Mat& mat, const Mat& default_mat )
 {
@@ -5373,6 +7168,8 @@ void read( const FileNode& node, Mat& mat, const Mat& default_mat )
         default_mat.copyTo(mat);
         return;
     }
+    if( readMappedMat(node, mat) )
+        return;
     void* obj = cvRead((CvFileStorage*)node.fs, (CvFileNode*)*node);
     if(CV_IS_MAT_HDR_Z(obj))
     {
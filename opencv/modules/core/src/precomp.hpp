@@ -179,8 +179,36 @@ BinaryFunc getConvertFunc(int sdepth, int ddepth);
 BinaryFunc getConvertScaleFunc(int sdepth, int ddepth);
 BinaryFunc getCopyMaskFunc(size_t esz);
 
+// the element-wise kernels of arithm.cpp, looked up by the fused MatExpr evaluator (matop.cpp).
+// MUL, DIV and RECIP take the scale as double*, ADD_WEIGHTED takes double[3] = {alpha, beta, gamma}
+enum { ARITHM_ADD=0, ARITHM_SUB=1, ARITHM_MUL=2, ARITHM_DIV=3, ARITHM_RECIP=4,
+       ARITHM_ABSDIFF=5, ARITHM_MIN=6, ARITHM_MAX=7, ARITHM_ADD_WEIGHTED=8 };
+BinaryFunc getArithmFunc(int op, int depth);
+
 enum { BLOCK_SIZE = 1024 };
 
+#ifdef HAVE_DISPATCH_AVX
+// the element-wise operations on 32f and 64f arrays built for AVX (arithm.avx.cpp)
+namespace opt_AVX
+{
+void add32f( const float* src1, size_t step1, const float* src2, size_t step2, float* dst, size_t step, int width, int height );
+void sub32f( const float* src1, size_t step1, const float* src2, size_t step2, float* dst, size_t step, int width, int height );
+void min32f( const float* src1, size_t step1, const float* src2, size_t step2, float* dst, size_t step, int width, int height );
+void max32f( const float* src1, size_t step1, const float* src2, size_t step2, float* dst, size_t step, int width, int height );
+void absdiff32f( const float* src1, size_t step1, const float* src2, size_t step2, float* dst, size_t step, int width, int height );
+void add64f( const double* src1, size_t step1, const double* src2, size_t step2, double* dst, size_t step, int width, int height );
+void sub64f( const double* src1, size_t step1, const double* src2, size_t step2, double* dst, size_t step, int width, int height );
+void min64f( const double* src1, size_t step1, const double* src2, size_t step2, double* dst, size_t step, int width, int height );
+void max64f( const double* src1, size_t step1, const double* src2, size_t step2, double* dst, size_t step, int width, int height );
+void absdiff64f( const double* src1, size_t step1, const double* src2, size_t step2, double* dst, size_t step, int width, int height );
+// the packed GEMM micro-kernels, 6x16 for 32f and 6x8 for 64f (matmul.avx.cpp)
+void gemmKernel32f( int kc, const float* a, const float* b, float* ab );
+void gemmKernel64f( int kc, const double* a, const double* b, double* ab );
+// the squared L2 distances from a vector to n vectors, used by kmeans (matrix.avx.cpp)
+void batchDistL2Sqr32f( const float* a, const float* b, size_t bstep, int n, int dims, float* dist );
+}
+#endif
+
 #ifdef HAVE_IPP
 static inline IppiSize ippiSize(int width, int height) { IppiSize sz = { width, height}; return sz; }
 static inline IppiSize ippiSize(Size _sz)              { IppiSize sz = { _sz.width, _sz.height}; return sz; }
@@ -55,6 +55,119 @@ template<typename T> static inline Scalar rawToScalar(const T& v)
     return s;
 }    
 
+/****************************************************************************************\
+*                                  parallel reduction                                    *
+\****************************************************************************************/
+
+/*
+ The driver of the reductions below. The elements are split into chunks of REDUCE_CHUNK_SIZE
+ elements (or of the whole planes of NAryMatIterator that take about as much), which do not
+ depend on the number of threads. The chunks are reduced concurrently, each into its own partial
+ result of op.width doubles, and the partial results are combined in the chunk order,
+ so the result is the same in every run and with any number of threads.
+
+ Op must have the following members:
+    int width;                      // the number of doubles in the result
+    void init(double* r) const;     // sets the result of the empty set
+    void combine(double* r, const double* r2) const;    // r = r (+) r2, r2 follows r
+    void operator()(uchar** ptrs, int len, size_t startIdx, double* r) const;
+                                    // r = r (+) the next len elements, starting from startIdx-th
+*/
+enum { REDUCE_CHUNK_SIZE = 1 << 16 };
+
+template<class Op> class ReduceChunkInvoker
+{
+public:
+    ReduceChunkInvoker(const Op& _op, uchar** _planes, const size_t* _esz, int _narrays,
+                       size_t _nplanes, size_t _planeSize, int _chunksPerPlane, int _planesPerChunk,
+                       double* _partial)
+        : op(&_op), planes(_planes), esz(_esz), narrays(_narrays), nplanes(_nplanes),
+          planeSize(_planeSize), chunksPerPlane(_chunksPerPlane), planesPerChunk(_planesPerChunk),
+          partial(_partial) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        uchar* ptrs[4];
+        for( int c = range.begin(); c < range.end(); c++ )
+        {
+            size_t p0, p1, ofs = 0, len = planeSize;
+            if( chunksPerPlane > 1 )
+            {
+                p0 = c/chunksPerPlane;
+                p1 = p0 + 1;
+                ofs = (size_t)(c % chunksPerPlane)*REDUCE_CHUNK_SIZE;
+                len = std::min(planeSize - ofs, (size_t)REDUCE_CHUNK_SIZE);
+            }
+            else
+            {
+                p0 = (size_t)c*planesPerChunk;
+                p1 = std::min(p0 + planesPerChunk, nplanes);
+            }
+
+            double* r = partial + (size_t)c*op->width;
+            op->init(r);
+            for( size_t p = p0; p < p1; p++ )
+            {
+                for( int k = 0; k < narrays; k++ )
+                {
+                    uchar* ptr = planes[p*narrays + k];
+                    ptrs[k] = ptr ? ptr + ofs*esz[k] : 0;
+                }
+                (*op)(ptrs, (int)len, p*planeSize + ofs, r);
+            }
+        }
+    }
+
+protected:
+    const Op* op;
+    uchar** planes;
+    const size_t* esz;
+    int narrays;
+    size_t nplanes, planeSize;
+    int chunksPerPlane, planesPerChunk;
+    double* partial;
+};
+
+template<class Op> static void reduce(const Mat** arrays, const Op& op, double* result)
+{
+    uchar* ptrs[4];
+    NAryMatIterator it(arrays, ptrs);
+    int k, narrays = it.narrays;
+    size_t i, nplanes = it.nplanes, planeSize = it.size;
+
+    CV_DbgAssert( narrays <= 4 );
+    op.init(result);
+    if( nplanes == 0 || planeSize == 0 )
+        return;
+
+    size_t esz[4];
+    AutoBuffer<uchar*> planes(nplanes*narrays);
+    for( k = 0; k < narrays; k++ )
+        esz[k] = arrays[k]->elemSize();
+    for( i = 0; i < nplanes; i++, ++it )
+        for( k = 0; k < narrays; k++ )
+            planes[i*narrays + k] = ptrs[k];
+
+    int chunksPerPlane = (int)((planeSize + REDUCE_CHUNK_SIZE - 1)/REDUCE_CHUNK_SIZE);
+    int planesPerChunk = chunksPerPlane > 1 ? 1 : (int)std::max(REDUCE_CHUNK_SIZE/planeSize, (size_t)1);
+    size_t nchunks = chunksPerPlane > 1 ? nplanes*chunksPerPlane : (nplanes + planesPerChunk - 1)/planesPerChunk;
+    CV_Assert( nchunks <= (size_t)INT_MAX );
+
+    if( nchunks == 1 )
+    {
+        ReduceChunkInvoker<Op>(op, planes, esz, narrays, nplanes, planeSize,
+                               chunksPerPlane, planesPerChunk, result)(BlockedRange(0, 1));
+        return;
+    }
+
+    AutoBuffer<double> partial(nchunks*op.width);
+    parallel_for(BlockedRange(0, (int)nchunks),
+                 ReduceChunkInvoker<Op>(op, planes, esz, narrays, nplanes, planeSize,
+                                        chunksPerPlane, planesPerChunk, partial));
+    for( i = 0; i < nchunks; i++ )
+        op.combine(result, partial + i*op.width);
+}
+
 /****************************************************************************************\
 *                                        sum                                             *
 \****************************************************************************************/
@@ -170,26 +283,166 @@ static int sum_(const T* src0, const uchar* mask, ST* dst, int len, int cn )
 }
 
     
+/*
+ The SIMD prefixes of the unmasked single-channel sums: they process as many elements as fit
+ into the vectors, add the result to dst and return the number of processed elements;
+ the rest is left to sum_(). The generic version processes nothing.
+*/
+template<typename T, typename ST> static inline int sumSimd(const T*, int, ST*)
+{ return 0; }
+
+#if CV_SSE2
+static inline int sumSimd(const uchar* src, int len, int* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128i z = _mm_setzero_si128(), s = z;
+        for( ; i <= len - 16; i += 16 )
+            s = _mm_add_epi32(s, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(src + i)), z));
+        dst[0] += _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(s, s));
+    }
+    return i;
+}
+
+static inline int sumSimd(const schar* src, int len, int* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        // the values are shifted by 128 to be summed as unsigned
+        __m128i z = _mm_setzero_si128(), delta = _mm_set1_epi8((char)0x80), s = z;
+        for( ; i <= len - 16; i += 16 )
+            s = _mm_add_epi32(s, _mm_sad_epu8(_mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), delta), z));
+        dst[0] += _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(s, s)) - i*128;
+    }
+    return i;
+}
+
+static inline int hsum32s(__m128i s)
+{
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+    return _mm_cvtsi128_si32(s);
+}
+
+static inline double hsum64f(__m128d s)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+static inline int sumSimd(const ushort* src, int len, int* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128i z = _mm_setzero_si128(), s0 = z, s1 = z;
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            s0 = _mm_add_epi32(s0, _mm_unpacklo_epi16(v, z));
+            s1 = _mm_add_epi32(s1, _mm_unpackhi_epi16(v, z));
+        }
+        dst[0] += hsum32s(_mm_add_epi32(s0, s1));
+    }
+    return i;
+}
+
+static inline int sumSimd(const short* src, int len, int* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128i s0 = _mm_setzero_si128(), s1 = s0;
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            s0 = _mm_add_epi32(s0, _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+            s1 = _mm_add_epi32(s1, _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        }
+        dst[0] += hsum32s(_mm_add_epi32(s0, s1));
+    }
+    return i;
+}
+
+static inline int sumSimd(const int* src, int len, double* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128d s0 = _mm_setzero_pd(), s1 = s0;
+        for( ; i <= len - 4; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            s0 = _mm_add_pd(s0, _mm_cvtepi32_pd(v));
+            s1 = _mm_add_pd(s1, _mm_cvtepi32_pd(_mm_srli_si128(v, 8)));
+        }
+        dst[0] += hsum64f(_mm_add_pd(s0, s1));
+    }
+    return i;
+}
+
+static inline int sumSimd(const float* src, int len, double* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128d s0 = _mm_setzero_pd(), s1 = s0;
+        for( ; i <= len - 4; i += 4 )
+        {
+            __m128 v = _mm_loadu_ps(src + i);
+            s0 = _mm_add_pd(s0, _mm_cvtps_pd(v));
+            s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+        dst[0] += hsum64f(_mm_add_pd(s0, s1));
+    }
+    return i;
+}
+
+static inline int sumSimd(const double* src, int len, double* dst)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128d s0 = _mm_setzero_pd(), s1 = s0;
+        for( ; i <= len - 4; i += 4 )
+        {
+            s0 = _mm_add_pd(s0, _mm_loadu_pd(src + i));
+            s1 = _mm_add_pd(s1, _mm_loadu_pd(src + i + 2));
+        }
+        dst[0] += hsum64f(_mm_add_pd(s0, s1));
+    }
+    return i;
+}
+#endif
+
+template<typename T, typename ST>
+static int sumOpt_(const T* src, const uchar* mask, ST* dst, int len, int cn )
+{
+    int i = !mask && cn == 1 ? sumSimd(src, len, dst) : 0;
+    return sum_(src + i, mask, dst, len - i, cn) + i;
+}
+
 static int sum8u( const uchar* src, const uchar* mask, int* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum8s( const schar* src, const uchar* mask, int* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum16u( const ushort* src, const uchar* mask, int* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum16s( const short* src, const uchar* mask, int* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum32s( const int* src, const uchar* mask, double* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum32f( const float* src, const uchar* mask, double* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 static int sum64f( const double* src, const uchar* mask, double* dst, int len, int cn )
-{ return sum_(src, mask, dst, len, cn); }
+{ return sumOpt_(src, mask, dst, len, cn); }
 
 typedef int (*SumFunc)(const uchar*, const uchar* mask, uchar*, int, int);
 
@@ -211,20 +464,127 @@ static int countNonZero_(const T* src, int len )
     return nz;
 }
 
+#if CV_SSE2
+/*
+ Counts the zero bytes of the masks produced by getZeroMask(i) for i = 0, 16, ..., len - 16.
+ The counters of the bytes are flushed every 255 vectors so they do not overflow.
+*/
+template<class ZeroMask> static inline int countZeros_sse2(const ZeroMask& getZeroMask, int len, int& zeros)
+{
+    __m128i z = _mm_setzero_si128(), total = z;
+    int i = 0;
+    while( i <= len - 16 )
+    {
+        __m128i c = z;
+        int end = std::min(len - 15, i + 255*16);
+        for( ; i < end; i += 16 )
+            c = _mm_sub_epi8(c, getZeroMask(i));
+        total = _mm_add_epi32(total, _mm_sad_epu8(c, z));
+    }
+    zeros += _mm_cvtsi128_si32(total) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total));
+    return i;
+}
+
+struct ZeroMask8u
+{
+    ZeroMask8u(const uchar* _src) : src(_src) {}
+    __m128i operator()(int i) const
+    { return _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(src + i)), _mm_setzero_si128()); }
+    const uchar* src;
+};
+
+struct ZeroMask16u
+{
+    ZeroMask16u(const ushort* _src) : src(_src) {}
+    __m128i operator()(int i) const
+    {
+        __m128i z = _mm_setzero_si128();
+        __m128i m0 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(src + i)), z);
+        __m128i m1 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(src + i + 8)), z);
+        return _mm_packs_epi16(m0, m1);
+    }
+    const ushort* src;
+};
+
+struct ZeroMask32s
+{
+    ZeroMask32s(const int* _src) : src(_src) {}
+    __m128i operator()(int i) const
+    {
+        __m128i z = _mm_setzero_si128();
+        __m128i m0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i)), z);
+        __m128i m1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), z);
+        __m128i m2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)), z);
+        __m128i m3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(src + i + 12)), z);
+        return _mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3));
+    }
+    const int* src;
+};
+
+// the float comparison, so that -0.f is counted as zero, as in countNonZero_()
+struct ZeroMask32f
+{
+    ZeroMask32f(const float* _src) : src(_src) {}
+    __m128i operator()(int i) const
+    {
+        __m128 z = _mm_setzero_ps();
+        __m128i m0 = _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(src + i), z));
+        __m128i m1 = _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(src + i + 4), z));
+        __m128i m2 = _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(src + i + 8), z));
+        __m128i m3 = _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(src + i + 12), z));
+        return _mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3));
+    }
+    const float* src;
+};
+
+struct ZeroMask64f
+{
+    ZeroMask64f(const double* _src) : src(_src) {}
+    __m128i operator()(int i) const
+    {
+        __m128d z = _mm_setzero_pd();
+        __m128i m[4];
+        for( int k = 0; k < 4; k++ )
+        {
+            // the 64-bit masks are packed to 32 bits first
+            __m128i a = _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(src + i + k*4), z));
+            __m128i b = _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(src + i + k*4 + 2), z));
+            m[k] = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+        return _mm_packs_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3]));
+    }
+    const double* src;
+};
+#endif
+
+template<typename T, class ZeroMask> static inline int countNonZeroOpt_(const T* src, int len)
+{
+    int i = 0, zeros = 0;
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+        i = countZeros_sse2(ZeroMask(src), len, zeros);
+#endif
+    return i - zeros + countNonZero_(src + i, len - i);
+}
+
+#if !CV_SSE2
+typedef int ZeroMask8u, ZeroMask16u, ZeroMask32s, ZeroMask32f, ZeroMask64f;
+#endif
+
 static int countNonZero8u( const uchar* src, int len )
-{ return countNonZero_(src, len); }
+{ return countNonZeroOpt_<uchar, ZeroMask8u>(src, len); }
 
 static int countNonZero16u( const ushort* src, int len )
-{ return countNonZero_(src, len); }
+{ return countNonZeroOpt_<ushort, ZeroMask16u>(src, len); }
 
 static int countNonZero32s( const int* src, int len )
-{ return countNonZero_(src, len); }
+{ return countNonZeroOpt_<int, ZeroMask32s>(src, len); }
 
 static int countNonZero32f( const float* src, int len )
-{ return countNonZero_(src, len); }
+{ return countNonZeroOpt_<float, ZeroMask32f>(src, len); }
 
 static int countNonZero64f( const double* src, int len )
-{ return countNonZero_(src, len); }
+{ return countNonZeroOpt_<double, ZeroMask64f>(src, len); }
 
 typedef int (*CountNonZeroFunc)(const uchar*, int);
     
@@ -390,77 +750,162 @@ static SumSqrFunc sumSqrTab[] =
     (SumSqrFunc)sqsum32s, (SumSqrFunc)sqsum32f, (SumSqrFunc)sqsum64f, 0
 };
 
-}
-    
-cv::Scalar cv::sum( InputArray _src )
+// the channel sums followed by the number of summed elements
+class SumOp
 {
-    Mat src = _src.getMat();
-    int k, cn = src.channels(), depth = src.depth();
-    SumFunc func = sumTab[depth];
-    
-    CV_Assert( cn <= 4 && func != 0 );
-    
-    const Mat* arrays[] = {&src, 0};
-    uchar* ptrs[1];
-    NAryMatIterator it(arrays, ptrs);
-    Scalar s;
-    int total = (int)it.size, blockSize = total, intSumBlockSize = 0;
-    int j, count = 0;
-    AutoBuffer<int> _buf;
-    int* buf = (int*)&s[0];
-    size_t esz = 0;
-    bool blockSum = depth < CV_32S;
-    
-    if( blockSum )
+public:
+    SumOp(int depth, int _cn, size_t _esz)
+        : width(_cn + 1), func(sumTab[depth]), cn(_cn), esz(_esz)
     {
-        intSumBlockSize = depth <= CV_8S ? (1 << 23) : (1 << 15);
-        blockSize = std::min(blockSize, intSumBlockSize);
-        _buf.allocate(cn);
-        buf = _buf;
-    
-        for( k = 0; k < cn; k++ )
-            buf[k] = 0;
-        esz = src.elemSize();
+        // the 8-bit and 16-bit elements are summed to int, so they are added by blocks
+        blockSize = depth <= CV_8S ? (1 << 23) : depth <= CV_16S ? (1 << 15) : 0;
     }
-        
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
+
+    void init(double* r) const
+    {
+        for( int k = 0; k < width; k++ )
+            r[k] = 0;
+    }
+
+    void combine(double* r, const double* r2) const
+    {
+        for( int k = 0; k < width; k++ )
+            r[k] += r2[k];
+    }
+
+    void operator()(uchar** ptrs, int len, size_t, double* r) const
     {
-        for( j = 0; j < total; j += blockSize )
+        const uchar *src = ptrs[0], *mask = ptrs[1];
+        if( !blockSize )
         {
-            int bsz = std::min(total - j, blockSize);
-            func( ptrs[0], 0, (uchar*)buf, bsz, cn );
-            count += bsz;
-            if( blockSum && (count + blockSize >= intSumBlockSize || (i+1 >= it.nplanes && j+bsz >= total)) )
-            {
+            r[cn] += func(src, mask, (uchar*)r, len, cn);
+            return;
+        }
+
+        int buf[4];
+        for( int j = 0; j < len; j += blockSize )
+        {
+            int k, bsz = std::min(len - j, blockSize);
+            for( k = 0; k < cn; k++ )
+                buf[k] = 0;
+            r[cn] += func(src, mask, (uchar*)buf, bsz, cn);
+            for( k = 0; k < cn; k++ )
+                r[k] += buf[k];
+            src += bsz*esz;
+            if( mask )
+                mask += bsz;
+        }
+    }
+
+    int width;
+
+protected:
+    SumFunc func;
+    int cn, blockSize;
+    size_t esz;
+};
+
+// the channel sums, the sums of squares and the number of summed elements
+class SumSqrOp
+{
+public:
+    SumSqrOp(int _depth, int _cn, size_t _esz)
+        : width(_cn*2 + 1), func(sumSqrTab[_depth]), depth(_depth), cn(_cn), esz(_esz) {}
+
+    void init(double* r) const
+    {
+        for( int k = 0; k < width; k++ )
+            r[k] = 0;
+    }
+
+    void combine(double* r, const double* r2) const
+    {
+        for( int k = 0; k < width; k++ )
+            r[k] += r2[k];
+    }
+
+    void operator()(uchar** ptrs, int len, size_t, double* r) const
+    {
+        const uchar *src = ptrs[0], *mask = ptrs[1];
+        if( depth > CV_16S )
+        {
+            r[cn*2] += func(src, mask, (uchar*)r, (uchar*)(r + cn), len, cn);
+            return;
+        }
+
+        // the sums of 8-bit and 16-bit elements and the squares of 8-bit ones are int
+        const int blockSize = 1 << 15;
+        bool sqrInt = depth <= CV_8S;
+        AutoBuffer<int> _buf(cn*2);
+        int *sbuf = _buf, *sqbuf = sbuf + cn;
+        for( int j = 0; j < len; j += blockSize )
+        {
+            int k, bsz = std::min(len - j, blockSize);
+            for( k = 0; k < cn*2; k++ )
+                sbuf[k] = 0;
+            r[cn*2] += func(src, mask, (uchar*)sbuf, sqrInt ? (uchar*)sqbuf : (uchar*)(r + cn), bsz, cn);
+            for( k = 0; k < cn; k++ )
+                r[k] += sbuf[k];
+            if( sqrInt )
                 for( k = 0; k < cn; k++ )
-                {
-                    s[k] += buf[k];
-                    buf[k] = 0;
-                }
-                count = 0;
-            }
-            ptrs[0] += bsz*esz;
+                    r[cn + k] += sqbuf[k];
+            src += bsz*esz;
+            if( mask )
+                mask += bsz;
         }
     }
+
+    int width;
+
+protected:
+    SumSqrFunc func;
+    int depth, cn;
+    size_t esz;
+};
+
+class CountNonZeroOp
+{
+public:
+    CountNonZeroOp(int depth) : width(1), func(countNonZeroTab[depth]) {}
+    void init(double* r) const { r[0] = 0; }
+    void combine(double* r, const double* r2) const { r[0] += r2[0]; }
+    void operator()(uchar** ptrs, int len, size_t, double* r) const { r[0] += func(ptrs[0], len); }
+
+    int width;
+
+protected:
+    CountNonZeroFunc func;
+};
+
+}
+    
+cv::Scalar cv::sum( InputArray _src )
+{
+    Mat src = _src.getMat(), mask;
+    int k, cn = src.channels(), depth = src.depth();
+    
+    CV_Assert( cn <= 4 && sumTab[depth] != 0 );
+    
+    const Mat* arrays[] = {&src, &mask, 0};
+    double r[5];
+    reduce(arrays, SumOp(depth, cn, src.elemSize()), r);
+    
+    Scalar s;
+    for( k = 0; k < cn; k++ )
+        s[k] = r[k];
     return s;
 }
 
 int cv::countNonZero( InputArray _src )
 {
     Mat src = _src.getMat();
-    CountNonZeroFunc func = countNonZeroTab[src.depth()];
     
-    CV_Assert( src.channels() == 1 && func != 0 );
+    CV_Assert( src.channels() == 1 && countNonZeroTab[src.depth()] != 0 );
     
     const Mat* arrays[] = {&src, 0};
-    uchar* ptrs[1];
-    NAryMatIterator it(arrays, ptrs);
-    int total = (int)it.size, nz = 0;
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        nz += func( ptrs[0], total );
-    
-    return nz;
+    double nz;
+    reduce(arrays, CountNonZeroOp(src.depth()), &nz);
+    return (int)nz;
 }    
     
 cv::Scalar cv::mean( InputArray _src, InputArray _mask )
@@ -469,56 +914,18 @@ cv::Scalar cv::mean( InputArray _src, InputArray _mask )
     CV_Assert( mask.empty() || mask.type() == CV_8U );
     
     int k, cn = src.channels(), depth = src.depth();
-    SumFunc func = sumTab[depth];
     
-    CV_Assert( cn <= 4 && func != 0 );
+    CV_Assert( cn <= 4 && sumTab[depth] != 0 );
     
     const Mat* arrays[] = {&src, &mask, 0};
-    uchar* ptrs[2];
-    NAryMatIterator it(arrays, ptrs);
-    Scalar s;
-    int total = (int)it.size, blockSize = total, intSumBlockSize = 0;
-    int j, count = 0;
-    AutoBuffer<int> _buf;
-    int* buf = (int*)&s[0];
-    bool blockSum = depth <= CV_16S;
-    size_t esz = 0, nz0 = 0;
-    
-    if( blockSum )
-    {
-        intSumBlockSize = depth <= CV_8S ? (1 << 23) : (1 << 15);
-        blockSize = std::min(blockSize, intSumBlockSize);
-        _buf.allocate(cn);
-        buf = _buf;
-        
-        for( k = 0; k < cn; k++ )
-            buf[k] = 0;
-        esz = src.elemSize();
-    }
+    double r[5];
+    reduce(arrays, SumOp(depth, cn, src.elemSize()), r);
     
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( j = 0; j < total; j += blockSize )
-        {
-            int bsz = std::min(total - j, blockSize);
-            int nz = func( ptrs[0], ptrs[1], (uchar*)buf, bsz, cn );
-            count += nz;
-            nz0 += nz;
-            if( blockSum && (count + blockSize >= intSumBlockSize || (i+1 >= it.nplanes && j+bsz >= total)) )
-            {
-                for( k = 0; k < cn; k++ )
-                {
-                    s[k] += buf[k];
-                    buf[k] = 0;
-                }
-                count = 0;
-            }
-            ptrs[0] += bsz*esz;
-            if( ptrs[1] )
-                ptrs[1] += bsz;
-        }
-    }
-    return s*(nz0 ? 1./nz0 : 0);
+    Scalar s;
+    double scale = r[cn] ? 1./r[cn] : 0;
+    for( k = 0; k < cn; k++ )
+        s[k] = r[k]*scale;
+    return s;
 }    
 
     
@@ -527,67 +934,15 @@ void cv::meanStdDev( InputArray _src, OutputArray _mean, OutputArray _sdv, Input
     Mat src = _src.getMat(), mask = _mask.getMat();
     CV_Assert( mask.empty() || mask.type() == CV_8U );
     
-    int k, cn = src.channels(), depth = src.depth();
-    SumSqrFunc func = sumSqrTab[depth];
+    int j, k, cn = src.channels(), depth = src.depth();
     
-    CV_Assert( func != 0 );
+    CV_Assert( sumSqrTab[depth] != 0 );
     
     const Mat* arrays[] = {&src, &mask, 0};
-    uchar* ptrs[2];
-    NAryMatIterator it(arrays, ptrs);
-    int total = (int)it.size, blockSize = total, intSumBlockSize = 0;
-    int j, count = 0, nz0 = 0;
-    AutoBuffer<double> _buf(cn*4);
-    double *s = (double*)_buf, *sq = s + cn;
-    int *sbuf = (int*)s, *sqbuf = (int*)sq;
-    bool blockSum = depth <= CV_16S, blockSqSum = depth <= CV_8S;
-    size_t esz = 0;
-    
-    for( k = 0; k < cn; k++ )
-        s[k] = sq[k] = 0;
-    
-    if( blockSum )
-    {
-        intSumBlockSize = 1 << 15;
-        blockSize = std::min(blockSize, intSumBlockSize);
-        sbuf = (int*)(sq + cn);
-        if( blockSqSum )
-            sqbuf = sbuf + cn;
-        for( k = 0; k < cn; k++ )
-            sbuf[k] = sqbuf[k] = 0;
-        esz = src.elemSize();
-    }
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( j = 0; j < total; j += blockSize )
-        {
-            int bsz = std::min(total - j, blockSize);
-            int nz = func( ptrs[0], ptrs[1], (uchar*)sbuf, (uchar*)sqbuf, bsz, cn );
-            count += nz;
-            nz0 += nz;
-            if( blockSum && (count + blockSize >= intSumBlockSize || (i+1 >= it.nplanes && j+bsz >= total)) )
-            {
-                for( k = 0; k < cn; k++ )
-                {
-                    s[k] += sbuf[k];
-                    sbuf[k] = 0;
-                }
-                if( blockSqSum )
-                {
-                    for( k = 0; k < cn; k++ )
-                    {
-                        sq[k] += sqbuf[k];
-                        sqbuf[k] = 0;
-                    }
-                }
-                count = 0;
-            }
-            ptrs[0] += bsz*esz;
-            if( ptrs[1] )
-                ptrs[1] += bsz;
-        }
-    }
+    AutoBuffer<double> _buf(cn*2 + 1);
+    double *s = (double*)_buf, *sq = s + cn, nz0;
+    reduce(arrays, SumSqrOp(depth, cn, src.elemSize()), s);
+    nz0 = s[cn*2];
     
     double scale = nz0 ? 1./nz0 : 0.;
     for( int k = 0; k < cn; k++ )
@@ -672,21 +1027,235 @@ minMaxIdx_( const T* src, const uchar* mask, WT* _minVal, WT* _maxVal,
     *_maxVal = maxVal;
 }
 
-static void minMaxIdx_8u(const uchar* src, const uchar* mask, int* minval, int* maxval,
-                         size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
-
-static void minMaxIdx_8s(const schar* src, const uchar* mask, int* minval, int* maxval,
-                         size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+/*
+ The SIMD prefixes of the unmasked minMaxIdx: they find the minimum and the maximum of
+ the first elements and return the number of the processed elements. The vectors start from
+ the largest and the smallest values, so that NaNs, which are skipped by minMaxIdx_(), are ignored.
+*/
+template<typename T, typename WT> static inline int minMaxSimd(const T*, int, WT&, WT&)
+{ return 0; }
 
-static void minMaxIdx_16u(const ushort* src, const uchar* mask, int* minval, int* maxval,
-                          size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+#if CV_SSE2
+static inline int minMaxSimd(const uchar* src, int len, int& minVal, int& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 16 )
+    {
+        __m128i vmin = _mm_set1_epi8((char)255), vmax = _mm_setzero_si128();
+        for( ; i <= len - 16; i += 16 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            vmin = _mm_min_epu8(vmin, v);
+            vmax = _mm_max_epu8(vmax, v);
+        }
+        uchar CV_DECL_ALIGNED(16) buf[32];
+        _mm_store_si128((__m128i*)buf, vmin);
+        _mm_store_si128((__m128i*)(buf + 16), vmax);
+        minVal = buf[0]; maxVal = buf[16];
+        for( int k = 1; k < 16; k++ )
+        {
+            minVal = std::min(minVal, (int)buf[k]);
+            maxVal = std::max(maxVal, (int)buf[k + 16]);
+        }
+    }
+    return i;
+}
 
-static void minMaxIdx_16s(const short* src, const uchar* mask, int* minval, int* maxval,
-                          size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+static inline int minMaxSimd(const schar* src, int len, int& minVal, int& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 16 )
+    {
+        // there is no signed 8-bit min/max in SSE2, so the values are shifted to unsigned
+        __m128i delta = _mm_set1_epi8((char)0x80), vmin = _mm_set1_epi8((char)255), vmax = _mm_setzero_si128();
+        for( ; i <= len - 16; i += 16 )
+        {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), delta);
+            vmin = _mm_min_epu8(vmin, v);
+            vmax = _mm_max_epu8(vmax, v);
+        }
+        uchar CV_DECL_ALIGNED(16) buf[32];
+        _mm_store_si128((__m128i*)buf, vmin);
+        _mm_store_si128((__m128i*)(buf + 16), vmax);
+        minVal = 255; maxVal = 0;
+        for( int k = 0; k < 16; k++ )
+        {
+            minVal = std::min(minVal, (int)buf[k]);
+            maxVal = std::max(maxVal, (int)buf[k + 16]);
+        }
+        minVal -= 128; maxVal -= 128;
+    }
+    return i;
+}
+
+static inline int minMaxSimd(const short* src, int len, int& minVal, int& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 8 )
+    {
+        __m128i vmin = _mm_set1_epi16(SHRT_MAX), vmax = _mm_set1_epi16(SHRT_MIN);
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+        }
+        short CV_DECL_ALIGNED(16) buf[16];
+        _mm_store_si128((__m128i*)buf, vmin);
+        _mm_store_si128((__m128i*)(buf + 8), vmax);
+        minVal = buf[0]; maxVal = buf[8];
+        for( int k = 1; k < 8; k++ )
+        {
+            minVal = std::min(minVal, (int)buf[k]);
+            maxVal = std::max(maxVal, (int)buf[k + 8]);
+        }
+    }
+    return i;
+}
+
+static inline int minMaxSimd(const ushort* src, int len, int& minVal, int& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 8 )
+    {
+        __m128i delta = _mm_set1_epi16((short)0x8000);
+        __m128i vmin = _mm_set1_epi16(SHRT_MAX), vmax = _mm_set1_epi16(SHRT_MIN);
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), delta);
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+        }
+        short CV_DECL_ALIGNED(16) buf[16];
+        _mm_store_si128((__m128i*)buf, vmin);
+        _mm_store_si128((__m128i*)(buf + 8), vmax);
+        minVal = buf[0]; maxVal = buf[8];
+        for( int k = 1; k < 8; k++ )
+        {
+            minVal = std::min(minVal, (int)buf[k]);
+            maxVal = std::max(maxVal, (int)buf[k + 8]);
+        }
+        minVal += 32768; maxVal += 32768;
+    }
+    return i;
+}
+
+static inline int minMaxSimd(const float* src, int len, float& minVal, float& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 4 )
+    {
+        // min/max return the second operand if the first one is NaN
+        __m128 vmin = _mm_set1_ps(FLT_MAX), vmax = _mm_set1_ps(-FLT_MAX);
+        for( ; i <= len - 4; i += 4 )
+        {
+            __m128 v = _mm_loadu_ps(src + i);
+            vmin = _mm_min_ps(v, vmin);
+            vmax = _mm_max_ps(v, vmax);
+        }
+        float CV_DECL_ALIGNED(16) buf[8];
+        _mm_store_ps(buf, vmin);
+        _mm_store_ps(buf + 4, vmax);
+        minVal = buf[0]; maxVal = buf[4];
+        for( int k = 1; k < 4; k++ )
+        {
+            minVal = std::min(minVal, buf[k]);
+            maxVal = std::max(maxVal, buf[k + 4]);
+        }
+    }
+    return i;
+}
+
+static inline int minMaxSimd(const double* src, int len, double& minVal, double& maxVal)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) && len >= 2 )
+    {
+        __m128d vmin = _mm_set1_pd(DBL_MAX), vmax = _mm_set1_pd(-DBL_MAX);
+        for( ; i <= len - 2; i += 2 )
+        {
+            __m128d v = _mm_loadu_pd(src + i);
+            vmin = _mm_min_pd(v, vmin);
+            vmax = _mm_max_pd(v, vmax);
+        }
+        double CV_DECL_ALIGNED(16) buf[4];
+        _mm_store_pd(buf, vmin);
+        _mm_store_pd(buf + 2, vmax);
+        minVal = std::min(buf[0], buf[1]);
+        maxVal = std::max(buf[2], buf[3]);
+    }
+    return i;
+}
+
+static inline int findFirstSimd(const float* src, int len, float val)
+{
+    int i = 0;
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128 v0 = _mm_set1_ps(val);
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m128 m = _mm_or_ps(_mm_cmpeq_ps(_mm_loadu_ps(src + i), v0),
+                                 _mm_cmpeq_ps(_mm_loadu_ps(src + i + 4), v0));
+            if( _mm_movemask_ps(m) )
+                break;
+        }
+    }
+    return i;
+}
+#endif
+
+template<typename T, typename WT> static inline int findFirstSimd(const T*, int, WT)
+{ return 0; }
+
+template<typename T, typename WT> static void
+minMaxIdxOpt_( const T* src, const uchar* mask, WT* _minVal, WT* _maxVal,
+               size_t* _minIdx, size_t* _maxIdx, int len, size_t startIdx )
+{
+    int i = 0, j;
+    WT minVal, maxVal;
+    if( !mask && (i = minMaxSimd(src, len, minVal, maxVal)) > 0 )
+    {
+        // the positions of the extremums are looked for only if they are the new ones
+        if( minVal < *_minVal )
+        {
+            for( j = findFirstSimd(src, i, minVal); j < i && src[j] != minVal; j++ )
+                ;
+            if( j < i )
+            {
+                *_minVal = src[j];
+                *_minIdx = startIdx + j;
+            }
+        }
+        if( maxVal > *_maxVal )
+        {
+            for( j = findFirstSimd(src, i, maxVal); j < i && src[j] != maxVal; j++ )
+                ;
+            if( j < i )
+            {
+                *_maxVal = src[j];
+                *_maxIdx = startIdx + j;
+            }
+        }
+    }
+    minMaxIdx_(src + i, mask, _minVal, _maxVal, _minIdx, _maxIdx, len - i, startIdx + i);
+}
+
+static void minMaxIdx_8u(const uchar* src, const uchar* mask, int* minval, int* maxval,
+                         size_t* minidx, size_t* maxidx, int len, size_t startidx )
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+
+static void minMaxIdx_8s(const schar* src, const uchar* mask, int* minval, int* maxval,
+                         size_t* minidx, size_t* maxidx, int len, size_t startidx )
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+
+static void minMaxIdx_16u(const ushort* src, const uchar* mask, int* minval, int* maxval,
+                          size_t* minidx, size_t* maxidx, int len, size_t startidx )
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+
+static void minMaxIdx_16s(const short* src, const uchar* mask, int* minval, int* maxval,
+                          size_t* minidx, size_t* maxidx, int len, size_t startidx )
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
 
 static void minMaxIdx_32s(const int* src, const uchar* mask, int* minval, int* maxval,
                           size_t* minidx, size_t* maxidx, int len, size_t startidx )
@@ -694,12 +1263,12 @@ static void minMaxIdx_32s(const int* src, const uchar* mask, int* minval, int* m
 
 static void minMaxIdx_32f(const float* src, const uchar* mask, float* minval, float* maxval,
                           size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
 
 static void minMaxIdx_64f(const double* src, const uchar* mask, double* minval, double* maxval,
                           size_t* minidx, size_t* maxidx, int len, size_t startidx )
-{ minMaxIdx_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }    
-    
+{ minMaxIdxOpt_(src, mask, minval, maxval, minidx, maxidx, len, startidx ); }
+
 typedef void (*MinMaxIdxFunc)(const uchar*, const uchar*, int*, int*, size_t*, size_t*, int, size_t);
 
 static MinMaxIdxFunc minmaxTab[] =
@@ -709,6 +1278,60 @@ static MinMaxIdxFunc minmaxTab[] =
     (MinMaxIdxFunc)minMaxIdx_64f, 0
 };
     
+// the minimum, the maximum and their 1-based indices (0 if there are no elements)
+class MinMaxIdxOp
+{
+public:
+    MinMaxIdxOp(int _depth) : width(4), func(minmaxTab[_depth]), depth(_depth) {}
+
+    void init(double* r) const
+    {
+        r[0] = depth <= CV_32S ? (double)INT_MAX : depth == CV_32F ? (double)FLT_MAX : DBL_MAX;
+        r[1] = depth <= CV_32S ? (double)INT_MIN : depth == CV_32F ? (double)-FLT_MAX : -DBL_MAX;
+        r[2] = r[3] = 0;
+    }
+
+    // r2 follows r, so the first of the equal extremums is kept, as in minMaxIdx_()
+    void combine(double* r, const double* r2) const
+    {
+        if( r2[0] < r[0] )
+            r[0] = r2[0], r[2] = r2[2];
+        if( r2[1] > r[1] )
+            r[1] = r2[1], r[3] = r2[3];
+    }
+
+    void operator()(uchar** ptrs, int len, size_t startIdx, double* r) const
+    {
+        size_t minidx = (size_t)r[2], maxidx = (size_t)r[3];
+        if( depth <= CV_32S )
+        {
+            int minval = (int)r[0], maxval = (int)r[1];
+            func(ptrs[0], ptrs[1], &minval, &maxval, &minidx, &maxidx, len, startIdx + 1);
+            r[0] = minval, r[1] = maxval;
+        }
+        else if( depth == CV_32F )
+        {
+            float minval = (float)r[0], maxval = (float)r[1];
+            func(ptrs[0], ptrs[1], (int*)&minval, (int*)&maxval, &minidx, &maxidx, len, startIdx + 1);
+            r[0] = minval, r[1] = maxval;
+        }
+        else
+        {
+            double minval = r[0], maxval = r[1];
+            func(ptrs[0], ptrs[1], (int*)&minval, (int*)&maxval, &minidx, &maxidx, len, startIdx + 1);
+            r[0] = minval, r[1] = maxval;
+        }
+        r[2] = (double)minidx;
+        r[3] = (double)maxidx;
+    }
+
+    int width;
+
+protected:
+    MinMaxIdxFunc func;
+    int depth;
+};
+
 static void ofs2idx(const Mat& a, size_t ofs, int* idx)
 {
     int i, d = a.dims;
@@ -739,35 +1362,16 @@ void cv::minMaxIdx(InputArray _src, double* minVal,
     int depth = src.depth();
     
     CV_Assert( src.channels() == 1 && (mask.empty() || mask.type() == CV_8U) );
-    MinMaxIdxFunc func = minmaxTab[depth];
-    CV_Assert( func != 0 );
+    CV_Assert( minmaxTab[depth] != 0 );
     
     const Mat* arrays[] = {&src, &mask, 0};
-    uchar* ptrs[2];
-    NAryMatIterator it(arrays, ptrs);
-    
-    size_t minidx = 0, maxidx = 0;
-    int iminval = INT_MAX, imaxval = INT_MIN;
-    float fminval = FLT_MAX, fmaxval = -FLT_MAX;
-    double dminval = DBL_MAX, dmaxval = -DBL_MAX;
-    size_t startidx = 1;
-    int *minval = &iminval, *maxval = &imaxval;
-    int planeSize = (int)it.size;
-    
-    if( depth == CV_32F )
-        minval = (int*)&fminval, maxval = (int*)&fmaxval;
-    else if( depth == CV_64F )
-        minval = (int*)&dminval, maxval = (int*)&dmaxval;
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it, startidx += planeSize )
-        func( ptrs[0], ptrs[1], minval, maxval, &minidx, &maxidx, planeSize, startidx );
+    double r[4];
+    reduce(arrays, MinMaxIdxOp(depth), r);
     
+    size_t minidx = (size_t)r[2], maxidx = (size_t)r[3];
+    double dminval = r[0], dmaxval = r[1];
     if( minidx == 0 )
         dminval = dmaxval = 0;
-    else if( depth == CV_32F )
-        dminval = fminval, dmaxval = fmaxval;
-    else if( depth <= CV_32S )
-        dminval = iminval, dmaxval = imaxval;
     
     if( minVal )
         *minVal = dminval;
@@ -951,12 +1555,347 @@ normDiffL2_(const T* src1, const T* src2, const uchar* mask, ST* _result, int le
 }    
 
 
+/*
+ The SIMD prefixes of the unmasked norms and norms of the differences (when src2 != 0).
+ They accumulate the norm of the first elements into result and return the number of
+ processed elements. The absolute values (of the differences) are loaded as unsigned integers
+ of the same width for the integer types, so 8s and 16s share the kernels with 8u and 16u.
+*/
+template<typename T, typename ST> static inline int normInfSimd(const T*, const T*, int, ST&)
+{ return 0; }
+template<typename T, typename ST> static inline int normL1Simd(const T*, const T*, int, ST&)
+{ return 0; }
+template<typename T, typename ST> static inline int normL2Simd(const T*, const T*, int, ST&)
+{ return 0; }
+
+#if CV_SSE2
+struct AbsLoad8u
+{
+    AbsLoad8u(const uchar* _a) : a(_a) {}
+    __m128i operator()(int i) const { return _mm_loadu_si128((const __m128i*)(a + i)); }
+    const uchar* a;
+};
+
+struct AbsDiffLoad8u
+{
+    AbsDiffLoad8u(const uchar* _a, const uchar* _b) : a(_a), b(_b) {}
+    __m128i operator()(int i) const
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i)), y = _mm_loadu_si128((const __m128i*)(b + i));
+        return _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+    }
+    const uchar *a, *b;
+};
+
+struct AbsLoad8s
+{
+    AbsLoad8s(const schar* _a) : a(_a) {}
+    __m128i operator()(int i) const
+    {
+        // |-128| is 128 as unsigned
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i)), s = _mm_cmpgt_epi8(_mm_setzero_si128(), v);
+        return _mm_sub_epi8(_mm_xor_si128(v, s), s);
+    }
+    const schar* a;
+};
+
+struct AbsDiffLoad8s
+{
+    AbsDiffLoad8s(const schar* _a, const schar* _b) : a(_a), b(_b) {}
+    __m128i operator()(int i) const
+    {
+        __m128i delta = _mm_set1_epi8((char)0x80);
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)), delta);
+        __m128i y = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(b + i)), delta);
+        return _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+    }
+    const schar *a, *b;
+};
+
+struct AbsLoad16u
+{
+    AbsLoad16u(const ushort* _a) : a(_a) {}
+    __m128i operator()(int i) const { return _mm_loadu_si128((const __m128i*)(a + i)); }
+    const ushort* a;
+};
+
+struct AbsDiffLoad16u
+{
+    AbsDiffLoad16u(const ushort* _a, const ushort* _b) : a(_a), b(_b) {}
+    __m128i operator()(int i) const
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i)), y = _mm_loadu_si128((const __m128i*)(b + i));
+        return _mm_or_si128(_mm_subs_epu16(x, y), _mm_subs_epu16(y, x));
+    }
+    const ushort *a, *b;
+};
+
+struct AbsLoad16s
+{
+    AbsLoad16s(const short* _a) : a(_a) {}
+    __m128i operator()(int i) const
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i)), s = _mm_srai_epi16(v, 15);
+        return _mm_sub_epi16(_mm_xor_si128(v, s), s);
+    }
+    const short* a;
+};
+
+struct AbsDiffLoad16s
+{
+    AbsDiffLoad16s(const short* _a, const short* _b) : a(_a), b(_b) {}
+    __m128i operator()(int i) const
+    {
+        // the difference of max and min fits into 16 bits as unsigned
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i)), y = _mm_loadu_si128((const __m128i*)(b + i));
+        return _mm_sub_epi16(_mm_max_epi16(x, y), _mm_min_epi16(x, y));
+    }
+    const short *a, *b;
+};
+
+struct AbsLoad32f
+{
+    AbsLoad32f(const float* _a) : a(_a) {}
+    __m128 operator()(int i) const
+    { return _mm_and_ps(_mm_loadu_ps(a + i), _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))); }
+    const float* a;
+};
+
+struct AbsDiffLoad32f
+{
+    AbsDiffLoad32f(const float* _a, const float* _b) : a(_a), b(_b) {}
+    __m128 operator()(int i) const
+    {
+        return _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)),
+                          _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+    }
+    const float *a, *b;
+};
+
+struct AbsLoad64f
+{
+    AbsLoad64f(const double* _a) : a(_a) {}
+    __m128d operator()(int i) const
+    { return _mm_and_pd(_mm_loadu_pd(a + i), _mm_castsi128_pd(_mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1))); }
+    const double* a;
+};
+
+struct AbsDiffLoad64f
+{
+    AbsDiffLoad64f(const double* _a, const double* _b) : a(_a), b(_b) {}
+    __m128d operator()(int i) const
+    {
+        return _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)),
+                          _mm_castsi128_pd(_mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1)));
+    }
+    const double *a, *b;
+};
+
+template<class Load> static int normInf8_sse2(const Load& load, int len, int& result)
+{
+    int i = 0;
+    __m128i m = _mm_setzero_si128();
+    for( ; i <= len - 16; i += 16 )
+        m = _mm_max_epu8(m, load(i));
+    uchar CV_DECL_ALIGNED(16) buf[16];
+    _mm_store_si128((__m128i*)buf, m);
+    for( int k = 0; k < 16; k++ )
+        result = std::max(result, (int)buf[k]);
+    return i;
+}
+
+template<class Load> static int normL18_sse2(const Load& load, int len, int& result)
+{
+    int i = 0;
+    __m128i z = _mm_setzero_si128(), s = z;
+    for( ; i <= len - 16; i += 16 )
+        s = _mm_add_epi32(s, _mm_sad_epu8(load(i), z));
+    result += _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(s, s));
+    return i;
+}
+
+template<class Load> static int normL28_sse2(const Load& load, int len, int& result)
+{
+    int i = 0;
+    __m128i z = _mm_setzero_si128(), s = z;
+    for( ; i <= len - 16; i += 16 )
+    {
+        __m128i v = load(i), v0 = _mm_unpacklo_epi8(v, z), v1 = _mm_unpackhi_epi8(v, z);
+        s = _mm_add_epi32(s, _mm_add_epi32(_mm_madd_epi16(v0, v0), _mm_madd_epi16(v1, v1)));
+    }
+    result += hsum32s(s);
+    return i;
+}
+
+template<class Load> static int normInf16_sse2(const Load& load, int len, int& result)
+{
+    int i = 0;
+    __m128i delta = _mm_set1_epi16((short)0x8000), m = delta;
+    for( ; i <= len - 8; i += 8 )
+        m = _mm_max_epi16(m, _mm_xor_si128(load(i), delta));
+    ushort CV_DECL_ALIGNED(16) buf[8];
+    _mm_store_si128((__m128i*)buf, _mm_xor_si128(m, delta));
+    for( int k = 0; k < 8; k++ )
+        result = std::max(result, (int)buf[k]);
+    return i;
+}
+
+template<class Load> static int normL116_sse2(const Load& load, int len, int& result)
+{
+    int i = 0;
+    __m128i z = _mm_setzero_si128(), s = z;
+    for( ; i <= len - 8; i += 8 )
+    {
+        __m128i v = load(i);
+        s = _mm_add_epi32(s, _mm_add_epi32(_mm_unpacklo_epi16(v, z), _mm_unpackhi_epi16(v, z)));
+    }
+    result += hsum32s(s);
+    return i;
+}
+
+template<class Load> static int normL216_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    // the squares take up to 32 bits unsigned, so they are summed in 64-bit lanes
+    __m128i z = _mm_setzero_si128(), s = z;
+    for( ; i <= len - 8; i += 8 )
+    {
+        __m128i v = load(i), lo = _mm_mullo_epi16(v, v), hi = _mm_mulhi_epu16(v, v);
+        __m128i p0 = _mm_unpacklo_epi16(lo, hi), p1 = _mm_unpackhi_epi16(lo, hi);
+        s = _mm_add_epi64(s, _mm_add_epi64(_mm_unpacklo_epi32(p0, z), _mm_unpackhi_epi32(p0, z)));
+        s = _mm_add_epi64(s, _mm_add_epi64(_mm_unpacklo_epi32(p1, z), _mm_unpackhi_epi32(p1, z)));
+    }
+    int64 CV_DECL_ALIGNED(16) buf[2];
+    _mm_store_si128((__m128i*)buf, s);
+    result += (double)(buf[0] + buf[1]);
+    return i;
+}
+
+template<class Load> static int normInf32f_sse2(const Load& load, int len, float& result)
+{
+    int i = 0;
+    __m128 m = _mm_setzero_ps();
+    for( ; i <= len - 4; i += 4 )
+        m = _mm_max_ps(load(i), m);
+    float CV_DECL_ALIGNED(16) buf[4];
+    _mm_store_ps(buf, m);
+    for( int k = 0; k < 4; k++ )
+        result = std::max(result, buf[k]);
+    return i;
+}
+
+template<class Load> static int normL132f_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0;
+    for( ; i <= len - 4; i += 4 )
+    {
+        __m128 v = load(i);
+        s0 = _mm_add_pd(s0, _mm_cvtps_pd(v));
+        s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    result += hsum64f(_mm_add_pd(s0, s1));
+    return i;
+}
+
+template<class Load> static int normL232f_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0;
+    for( ; i <= len - 4; i += 4 )
+    {
+        __m128 v = load(i);
+        __m128d v0 = _mm_cvtps_pd(v), v1 = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        s0 = _mm_add_pd(s0, _mm_mul_pd(v0, v0));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(v1, v1));
+    }
+    result += hsum64f(_mm_add_pd(s0, s1));
+    return i;
+}
+
+template<class Load> static int normInf64f_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    __m128d m = _mm_setzero_pd();
+    for( ; i <= len - 2; i += 2 )
+        m = _mm_max_pd(load(i), m);
+    double CV_DECL_ALIGNED(16) buf[2];
+    _mm_store_pd(buf, m);
+    result = std::max(result, std::max(buf[0], buf[1]));
+    return i;
+}
+
+template<class Load> static int normL164f_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0;
+    for( ; i <= len - 4; i += 4 )
+    {
+        s0 = _mm_add_pd(s0, load(i));
+        s1 = _mm_add_pd(s1, load(i + 2));
+    }
+    result += hsum64f(_mm_add_pd(s0, s1));
+    return i;
+}
+
+template<class Load> static int normL264f_sse2(const Load& load, int len, double& result)
+{
+    int i = 0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0;
+    for( ; i <= len - 4; i += 4 )
+    {
+        __m128d v0 = load(i), v1 = load(i + 2);
+        s0 = _mm_add_pd(s0, _mm_mul_pd(v0, v0));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(v1, v1));
+    }
+    result += hsum64f(_mm_add_pd(s0, s1));
+    return i;
+}
+
+#define CV_DEF_NORM_SIMD(L, type, ntype, kernel, Load) \
+static inline int norm##L##Simd(const type* src1, const type* src2, int len, ntype& result) \
+{ \
+    if( !checkHardwareSupport(CV_CPU_SSE2) ) \
+        return 0; \
+    return src2 ? kernel(AbsDiff##Load(src1, src2), len, result) : kernel(Abs##Load(src1), len, result); \
+}
+
+CV_DEF_NORM_SIMD(Inf, uchar, int, normInf8_sse2, Load8u)
+CV_DEF_NORM_SIMD(L1, uchar, int, normL18_sse2, Load8u)
+CV_DEF_NORM_SIMD(L2, uchar, int, normL28_sse2, Load8u)
+CV_DEF_NORM_SIMD(Inf, schar, int, normInf8_sse2, Load8s)
+CV_DEF_NORM_SIMD(L1, schar, int, normL18_sse2, Load8s)
+CV_DEF_NORM_SIMD(L2, schar, int, normL28_sse2, Load8s)
+CV_DEF_NORM_SIMD(Inf, ushort, int, normInf16_sse2, Load16u)
+CV_DEF_NORM_SIMD(L1, ushort, int, normL116_sse2, Load16u)
+CV_DEF_NORM_SIMD(L2, ushort, double, normL216_sse2, Load16u)
+CV_DEF_NORM_SIMD(Inf, short, int, normInf16_sse2, Load16s)
+CV_DEF_NORM_SIMD(L1, short, int, normL116_sse2, Load16s)
+CV_DEF_NORM_SIMD(L2, short, double, normL216_sse2, Load16s)
+CV_DEF_NORM_SIMD(Inf, float, float, normInf32f_sse2, Load32f)
+CV_DEF_NORM_SIMD(L1, float, double, normL132f_sse2, Load32f)
+CV_DEF_NORM_SIMD(L2, float, double, normL232f_sse2, Load32f)
+CV_DEF_NORM_SIMD(Inf, double, double, normInf64f_sse2, Load64f)
+CV_DEF_NORM_SIMD(L1, double, double, normL164f_sse2, Load64f)
+CV_DEF_NORM_SIMD(L2, double, double, normL264f_sse2, Load64f)
+#endif
+
 #define CV_DEF_NORM_FUNC(L, suffix, type, ntype) \
 static int norm##L##_##suffix(const type* src, const uchar* mask, ntype* r, int len, int cn) \
-{ return norm##L##_(src, mask, r, len, cn); } \
+{ \
+    if( mask ) \
+        return norm##L##_(src, mask, r, len, cn); \
+    int i = norm##L##Simd(src, (const type*)0, len*cn, *r); \
+    return norm##L##_(src + i, mask, r, len*cn - i, 1); \
+} \
 static int normDiff##L##_##suffix(const type* src1, const type* src2, \
                                const uchar* mask, ntype* r, int len, int cn) \
-{ return normDiff##L##_(src1, src2, mask, r, (int)len, cn); }
+{ \
+    if( mask ) \
+        return normDiff##L##_(src1, src2, mask, r, len, cn); \
+    int i = norm##L##Simd(src1, src2, len*cn, *r); \
+    return normDiff##L##_(src1 + i, src2 + i, mask, r, len*cn - i, 1); \
+}
     
 #define CV_DEF_NORM_ALL(suffix, type, inftype, l1type, l2type) \
 CV_DEF_NORM_FUNC(Inf, suffix, type, inftype) \
@@ -1013,106 +1952,100 @@ static NormDiffFunc normDiffTab[3][8] =
     }
 };
 
-}
-    
-double cv::norm( InputArray _src, int normType, InputArray _mask )
+/*
+ The norm of an array or of the difference of two arrays. The integer sums are computed by
+ blocks that can not overflow; the sums of differences are unsigned, as they may not fit into int.
+*/
+class NormOp
 {
-    Mat src = _src.getMat(), mask = _mask.getMat();
-    int depth = src.depth(), cn = src.channels();
-    
-    normType &= 7;
-    CV_Assert( normType == NORM_INF || normType == NORM_L1 || normType == NORM_L2 );
-    
-    if( depth == CV_32F && src.isContinuous() && mask.empty() )
+public:
+    NormOp(int _normType, int _depth, int _cn, size_t _esz, bool _diff)
+        : width(1), func(normTab[_normType >> 1][_depth]), diffFunc(normDiffTab[_normType >> 1][_depth]),
+          normType(_normType), depth(_depth), cn(_cn), esz(_esz), diff(_diff)
     {
-        size_t len = src.total()*cn;
-        if( len == (size_t)(int)len )
-        {
-            const float* data = src.ptr<float>();
-            
-            if( normType == NORM_L2 )
-            {
-                double result = 0;
-                normL2_32f(data, 0, &result, (int)len, 1);
-                return std::sqrt(result);
-            }
-            if( normType == NORM_L1 )
-            {
-                double result = 0;
-                normL1_32f(data, 0, &result, (int)len, 1);
-                return result;
-            }
-            {
-                float result = 0;
-                normInf_32f(data, 0, &result, (int)len, 1);
-                return result;
-            }
-        }
-    }
-    
-    CV_Assert( mask.empty() || mask.type() == CV_8U );
-    
-    NormFunc func = normTab[normType >> 1][depth];
-    CV_Assert( func != 0 );
-    
-    const Mat* arrays[] = {&src, &mask, 0};
-    uchar* ptrs[2];
-    union
-    {
-        double d;
-        int i;
-        float f;
+        blockSize = 0;
+        if( normType == NORM_L1 && depth <= CV_16S )
+            blockSize = (depth <= CV_8S ? (1 << 23) : (1 << 15))/cn;
+        else if( normType == NORM_L2 && depth <= CV_8S )
+            blockSize = (1 << 15)/cn;
     }
-    result;
-    result.d = 0;
-    NAryMatIterator it(arrays, ptrs);
-    int j, total = (int)it.size, blockSize = total, intSumBlockSize = 0, count = 0;
-    bool blockSum = (normType == NORM_L1 && depth <= CV_16S) ||
-                    (normType == NORM_L2 && depth <= CV_8S);
-    int isum = 0;
-    int *ibuf = &result.i;
-    size_t esz = 0;
-    
-    if( blockSum )
+
+    void init(double* r) const { r[0] = 0; }
+
+    void combine(double* r, const double* r2) const
     {
-        intSumBlockSize = (normType == NORM_L1 && depth <= CV_8S ? (1 << 23) : (1 << 15))/cn;
-        blockSize = std::min(blockSize, intSumBlockSize);
-        ibuf = &isum;
-        esz = src.elemSize();
+        r[0] = normType == NORM_INF ? std::max(r[0], r2[0]) : r[0] + r2[0];
     }
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
+
+    void operator()(uchar** ptrs, int len, size_t, double* r) const
     {
-        for( j = 0; j < total; j += blockSize )
+        const uchar *src1 = ptrs[0], *src2 = diff ? ptrs[1] : 0, *mask = ptrs[diff ? 2 : 1];
+        if( normType == NORM_INF && depth <= CV_32S )
+        {
+            unsigned result = diff ? (unsigned)r[0] : (unsigned)(int)r[0];
+            call(src1, src2, mask, (uchar*)&result, len);
+            r[0] = diff ? (double)result : (double)(int)result;
+        }
+        else if( normType == NORM_INF && depth == CV_32F )
         {
-            int bsz = std::min(total - j, blockSize);
-            func( ptrs[0], ptrs[1], (uchar*)ibuf, bsz, cn );
-            count += bsz;
-            if( blockSum && (count + blockSize >= intSumBlockSize || (i+1 >= it.nplanes && j+bsz >= total)) )
+            float result = (float)r[0];
+            call(src1, src2, mask, (uchar*)&result, len);
+            r[0] = result;
+        }
+        else if( !blockSize )
+            call(src1, src2, mask, (uchar*)r, len);
+        else
+        {
+            for( int j = 0; j < len; j += blockSize )
             {
-                result.d += isum;
-                isum = 0;
-                count = 0;
+                int bsz = std::min(len - j, blockSize);
+                unsigned isum = 0;
+                call(src1, src2, mask, (uchar*)&isum, bsz);
+                r[0] += isum;
+                src1 += bsz*esz;
+                if( src2 )
+                    src2 += bsz*esz;
+                if( mask )
+                    mask += bsz;
             }
-            ptrs[0] += bsz*esz;
-            if( ptrs[1] )
-                ptrs[1] += bsz;
         }
     }
-    
-    if( normType == NORM_INF )
+
+    int width;
+
+protected:
+    void call(const uchar* src1, const uchar* src2, const uchar* mask, uchar* result, int len) const
     {
-        if( depth == CV_64F )
-            ;
-        else if( depth == CV_32F )
-            result.d = result.f;
+        if( diff )
+            diffFunc(src1, src2, mask, result, len, cn);
         else
-            result.d = result.i;
+            func(src1, mask, result, len, cn);
     }
-    else if( normType == NORM_L2 )
-        result.d = std::sqrt(result.d);
+
+    NormFunc func;
+    NormDiffFunc diffFunc;
+    int normType, depth, cn, blockSize;
+    size_t esz;
+    bool diff;
+};
+
+}
+    
+double cv::norm( InputArray _src, int normType, InputArray _mask )
+{
+    Mat src = _src.getMat(), mask = _mask.getMat();
+    int depth = src.depth(), cn = src.channels();
+    
+    normType &= 7;
+    CV_Assert( normType == NORM_INF || normType == NORM_L1 || normType == NORM_L2 );
+    CV_Assert( mask.empty() || mask.type() == CV_8U );
+    CV_Assert( normTab[normType >> 1][depth] != 0 );
     
-    return result.d;
+    const Mat* arrays[] = {&src, &mask, 0};
+    double result;
+    reduce(arrays, NormOp(normType, depth, cn, src.elemSize(), false), &result);
+    
+    return normType == NORM_L2 ? std::sqrt(result) : result;
 }
 
     
@@ -1128,100 +2061,14 @@ double cv::norm( InputArray _src1, InputArray _src2, int normType, InputArray _m
     
     normType &= 7;
     CV_Assert( normType == NORM_INF || normType == NORM_L1 || normType == NORM_L2 );
-    
-    if( src1.depth() == CV_32F && src1.isContinuous() && src2.isContinuous() && mask.empty() )
-    {
-        size_t len = src1.total()*src1.channels();
-        if( len == (size_t)(int)len )
-        {
-            const float* data1 = src1.ptr<float>();
-            const float* data2 = src2.ptr<float>();
-            
-            if( normType == NORM_L2 )
-            {
-                double result = 0;
-                normDiffL2_32f(data1, data2, 0, &result, (int)len, 1);
-                return std::sqrt(result);
-            }
-            if( normType == NORM_L1 )
-            {
-                double result = 0;
-                normDiffL1_32f(data1, data2, 0, &result, (int)len, 1);
-                return result;
-            }
-            {
-                float result = 0;
-                normDiffInf_32f(data1, data2, 0, &result, (int)len, 1);
-                return result;
-            }
-        }
-    }
-    
     CV_Assert( mask.empty() || mask.type() == CV_8U );
-    
-    NormDiffFunc func = normDiffTab[normType >> 1][depth];
-    CV_Assert( func != 0 );
+    CV_Assert( normDiffTab[normType >> 1][depth] != 0 );
     
     const Mat* arrays[] = {&src1, &src2, &mask, 0};
-    uchar* ptrs[3];
-    union
-    {
-        double d;
-        float f;
-        int i;
-        unsigned u;
-    }
-    result;
-    result.d = 0;
-    NAryMatIterator it(arrays, ptrs);
-    int j, total = (int)it.size, blockSize = total, intSumBlockSize = 0, count = 0;
-    bool blockSum = (normType == NORM_L1 && depth <= CV_16S) ||
-    (normType == NORM_L2 && depth <= CV_8S);
-    unsigned isum = 0;
-    unsigned *ibuf = &result.u;
-    size_t esz = 0;
-    
-    if( blockSum )
-    {
-        intSumBlockSize = normType == NORM_L1 && depth <= CV_8S ? (1 << 23) : (1 << 15);
-        blockSize = std::min(blockSize, intSumBlockSize);
-        ibuf = &isum;
-        esz = src1.elemSize();
-    }
-    
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-    {
-        for( j = 0; j < total; j += blockSize )
-        {
-            int bsz = std::min(total - j, blockSize);
-            func( ptrs[0], ptrs[1], ptrs[2], (uchar*)ibuf, bsz, cn );
-            count += bsz;
-            if( blockSum && (count + blockSize >= intSumBlockSize || (i+1 >= it.nplanes && j+bsz >= total)) )
-            {
-                result.d += isum;
-                isum = 0;
-                count = 0;
-            }
-            ptrs[0] += bsz*esz;
-            ptrs[1] += bsz*esz;
-            if( ptrs[2] )
-                ptrs[2] += bsz;
-        }
-    }
-    
-    if( normType == NORM_INF )
-    {
-        if( depth == CV_64F )
-            ;
-        else if( depth == CV_32F )
-            result.d = result.f;
-        else
-            result.d = result.u;
-    }
-    else if( normType == NORM_L2 )
-        result.d = std::sqrt(result.d);
+    double result;
+    reduce(arrays, NormOp(normType, depth, cn, src1.elemSize(), true), &result);
     
-    return result.d;
+    return normType == NORM_L2 ? std::sqrt(result) : result;
 }
 
 
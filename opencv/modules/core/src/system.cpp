@@ -79,10 +79,6 @@
 
 #endif
 
-#ifdef _OPENMP
-#include "omp.h"
-#endif
-
 #include <stdarg.h>
 
 namespace cv
@@ -111,6 +107,21 @@ void Exception::formatMessage()
         msg = format("%s:%d: error: (%d) %s\n", file.c_str(), line, code, err.c_str());
 }
     
+// returns the XCR0 register, i.e. the set of the register states saved by the OS on context switch
+static int64 getXCR0()
+{
+#if defined _MSC_VER && (defined _M_IX86 || defined _M_X64) && _MSC_FULL_VER >= 160040219
+    return (int64)_xgetbv(0);
+#elif defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+    unsigned lo = 0, hi = 0;
+    // xgetbv; written as bytes for the assemblers that do not know the instruction
+    asm volatile ( ".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0) );
+    return ((int64)hi << 32) | lo;
+#else
+    return 0;
+#endif
+}
+
 struct HWFeatures
 {
     enum { MAX_FEATURE = CV_HARDWARE_MAX_FEATURE };
@@ -163,7 +174,9 @@ struct HWFeatures
             f.have[CV_CPU_SSE4_1] = (cpuid_data[2] & (1<<19)) != 0;
             f.have[CV_CPU_SSE4_2] = (cpuid_data[2] & (1<<20)) != 0;
             f.have[CV_CPU_POPCNT] = (cpuid_data[2] & (1<<23)) != 0;
-            f.have[CV_CPU_AVX]    = (cpuid_data[2] & (1<<28)) != 0;
+            // AVX also needs the OS support of the YMM registers (OSXSAVE and XCR0 bits 1-2)
+            f.have[CV_CPU_AVX]    = (cpuid_data[2] & (1<<28)) != 0 &&
+                                    (cpuid_data[2] & (1<<27)) != 0 && (getXCR0() & 6) == 6;
         }
 
         return f;
@@ -318,54 +331,6 @@ int64 getCPUTickCount(void)
 #endif
 
 
-static int numThreads = 0;
-static int numProcs   = 0;
-
-int getNumThreads(void)
-{
-    if( !numProcs )
-        setNumThreads(0);
-    return numThreads;
-}
-
-void setNumThreads( int
-#ifdef _OPENMP
-                             threads
-#endif
-                  )
-{
-    if( !numProcs )
-    {
-#ifdef _OPENMP
-        numProcs = omp_get_num_procs();
-#else
-        numProcs = 1;
-#endif
-    }
-
-#ifdef _OPENMP
-    if( threads <= 0 )
-        threads = numProcs;
-    else
-        threads = MIN( threads, numProcs );
-
-    numThreads = threads;
-#else
-    numThreads = 1;
-#endif
-}
-
-
-int getThreadNum(void)
-{
-#ifdef _OPENMP
-    return omp_get_thread_num();
-#else
-    return 0;
-#endif
-}
-
-
 string format( const char* fmt, ... )
 {
     char buf[1 << 16];
@@ -444,6 +409,69 @@ redirectError( CvErrorCallback errCallback, void* userdata, void** prevUserdata)
     return prevCallback;
 }
 
+#if defined WIN32 || defined _WIN32 || defined WINCE
+
+struct Mutex::Impl
+{
+    Impl() { InitializeCriticalSection(&cs); refcount = 1; }
+    ~Impl() { DeleteCriticalSection(&cs); }
+
+    void lock() { EnterCriticalSection(&cs); }
+    bool trylock() { return TryEnterCriticalSection(&cs) != 0; }
+    void unlock() { LeaveCriticalSection(&cs); }
+
+    CRITICAL_SECTION cs;
+    int refcount;
+};
+
+#else
+
+struct Mutex::Impl
+{
+    Impl() { pthread_mutex_init(&mt, 0); refcount = 1; }
+    ~Impl() { pthread_mutex_destroy(&mt); }
+
+    void lock() { pthread_mutex_lock(&mt); }
+    bool trylock() { return pthread_mutex_trylock(&mt) == 0; }
+    void unlock() { pthread_mutex_unlock(&mt); }
+
+    pthread_mutex_t mt;
+    int refcount;
+};
+
+#endif
+
+Mutex::Mutex()
+{
+    impl = new Mutex::Impl;
+}
+
+Mutex::~Mutex()
+{
+    if( CV_XADD(&impl->refcount, -1) == 1 )
+        delete impl;
+    impl = 0;
+}
+
+Mutex::Mutex(const Mutex& m)
+{
+    impl = m.impl;
+    CV_XADD(&impl->refcount, 1);
+}
+
+Mutex& Mutex::operator = (const Mutex& m)
+{
+    CV_XADD(&m.impl->refcount, 1);
+    if( CV_XADD(&impl->refcount, -1) == 1 )
+        delete impl;
+    impl = m.impl;
+    return *this;
+}
+
+void Mutex::lock() { impl->lock(); }
+void Mutex::unlock() { impl->unlock(); }
+bool Mutex::trylock() { return impl->trylock(); }
+
 }
 
 /*CV_IMPL int
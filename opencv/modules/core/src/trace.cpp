@@ -0,0 +1,341 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+
+#include "precomp.hpp"
+#include <map>
+
+/*
+   The instrumentation of the main functions (see cv::setTraceEnabled).
+
+   Every thread that enters a trace region gets its own ThreadTrace: a ring buffer of the last
+   TRACE_BUFFER_SIZE calls and the per-region statistics, keyed by the address of the region name.
+   Only the owner thread writes into it, so its mutex is never contended except when the trace is
+   being retrieved. The buffers of the finished threads are kept until clearTrace().
+*/
+
+namespace cv
+{
+
+enum { TRACE_BUFFER_SIZE = 1 << 16 };
+
+struct TraceEvent
+{
+    const char* name;
+    int64 startTime;
+    int64 duration;
+    size_t bytes;
+};
+
+struct TraceRegionStat
+{
+    TraceRegionStat() : calls(0), totalTime(0), maxTime(0), bytes(0) {}
+    int64 calls;
+    int64 totalTime;
+    int64 maxTime;
+    double bytes;
+};
+
+struct ThreadTrace
+{
+    ThreadTrace(int _threadId) : events(TRACE_BUFFER_SIZE), head(0), count(0), threadId(_threadId), finished(false) {}
+
+    void add(const char* name, int64 startTime, int64 duration, size_t bytes)
+    {
+        AutoLock lock(mutex);
+        TraceEvent& e = events[head];
+        e.name = name;
+        e.startTime = startTime;
+        e.duration = duration;
+        e.bytes = bytes;
+        head = (head + 1) % TRACE_BUFFER_SIZE;
+        count = std::min(count + 1, (size_t)TRACE_BUFFER_SIZE);
+
+        TraceRegionStat& s = stats[name];
+        s.calls++;
+        s.totalTime += duration;
+        s.maxTime = std::max(s.maxTime, duration);
+        s.bytes += (double)bytes;
+    }
+
+    void clear()
+    {
+        AutoLock lock(mutex);
+        head = count = 0;
+        stats.clear();
+    }
+
+    vector<TraceEvent> events;
+    size_t head, count;
+    std::map<const char*, TraceRegionStat> stats;
+    Mutex mutex;
+    int threadId;
+    bool finished;
+};
+
+static bool initTraceFlag()
+{
+    const char* s = getenv("OPENCV_TRACE");
+    return s && atoi(s) != 0;
+}
+
+static volatile bool traceEnabled = initTraceFlag();
+// never destroyed, since the pool threads may still finish their regions during the process exit
+static Mutex& traceMutex = *new Mutex;
+static vector<ThreadTrace*>& traceThreads = *new vector<ThreadTrace*>;
+static int traceThreadCount = 0;
+
+static ThreadTrace* createThreadTrace()
+{
+    AutoLock lock(traceMutex);
+    ThreadTrace* t = new ThreadTrace(traceThreadCount++);
+    traceThreads.push_back(t);
+    return t;
+}
+
+#if defined WIN32 || defined _WIN32 || defined WINCE
+#ifdef WINCE
+#	define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+static DWORD traceTlsKey = TLS_OUT_OF_INDEXES;
+
+static ThreadTrace* getThreadTrace()
+{
+    if( traceTlsKey == TLS_OUT_OF_INDEXES )
+    {
+        DWORD key = TlsAlloc();
+        if( InterlockedCompareExchange((LONG volatile*)&traceTlsKey, (LONG)key,
+                                       (LONG)TLS_OUT_OF_INDEXES) != (LONG)TLS_OUT_OF_INDEXES )
+            TlsFree(key);
+    }
+    ThreadTrace* t = (ThreadTrace*)TlsGetValue(traceTlsKey);
+    if( !t )
+    {
+        t = createThreadTrace();
+        TlsSetValue(traceTlsKey, t);
+    }
+    return t;
+}
+#else
+static pthread_key_t traceTlsKey;
+static pthread_once_t traceTlsKeyOnce = PTHREAD_ONCE_INIT;
+
+static void releaseThreadTrace(void* data)
+{
+    AutoLock lock(traceMutex);
+    ((ThreadTrace*)data)->finished = true;
+}
+
+static void createTraceTlsKey()
+{
+    pthread_key_create(&traceTlsKey, releaseThreadTrace);
+}
+
+static ThreadTrace* getThreadTrace()
+{
+    pthread_once(&traceTlsKeyOnce, createTraceTlsKey);
+    ThreadTrace* t = (ThreadTrace*)pthread_getspecific(traceTlsKey);
+    if( !t )
+    {
+        t = createThreadTrace();
+        pthread_setspecific(traceTlsKey, t);
+    }
+    return t;
+}
+#endif
+
+TraceRegion::TraceRegion(const char* _name, size_t _bytes) : name(0), startTime(0), bytes(_bytes)
+{
+    if( traceEnabled )
+    {
+        name = _name;
+        startTime = getTickCount();
+    }
+}
+
+void TraceRegion::finish()
+{
+    int64 duration = getTickCount() - startTime;
+    getThreadTrace()->add(name, startTime, duration, bytes);
+}
+
+TraceStat::TraceStat() : calls(0), totalTime(0), maxTime(0), bytes(0) {}
+
+void setTraceEnabled(bool enabled)
+{
+    traceEnabled = enabled;
+}
+
+bool isTraceEnabled()
+{
+    return traceEnabled;
+}
+
+static bool cmpTraceStat(const TraceStat& a, const TraceStat& b)
+{
+    return a.totalTime > b.totalTime || (a.totalTime == b.totalTime && a.name < b.name);
+}
+
+void getTraceStats(vector<TraceStat>& stats)
+{
+    // the same name may come with different addresses from different modules, so merge by the contents
+    std::map<string, TraceStat> merged;
+    double scale = 1000./getTickFrequency();
+    {
+    AutoLock lock(traceMutex);
+    for( size_t i = 0; i < traceThreads.size(); i++ )
+    {
+        ThreadTrace* t = traceThreads[i];
+        AutoLock tlock(t->mutex);
+        std::map<const char*, TraceRegionStat>::const_iterator it = t->stats.begin();
+        for( ; it != t->stats.end(); ++it )
+        {
+            TraceStat& s = merged[string(it->first)];
+            s.calls += it->second.calls;
+            s.totalTime += it->second.totalTime*scale;
+            s.maxTime = std::max(s.maxTime, it->second.maxTime*scale);
+            s.bytes += it->second.bytes;
+        }
+    }
+    }
+
+    stats.clear();
+    for( std::map<string, TraceStat>::iterator it = merged.begin(); it != merged.end(); ++it )
+    {
+        stats.push_back(it->second);
+        stats.back().name = it->first;
+    }
+    std::sort(stats.begin(), stats.end(), cmpTraceStat);
+}
+
+static void writeJSONName(FILE* f, const char* name)
+{
+    fputc('\"', f);
+    for( ; *name; name++ )
+    {
+        if( *name == '\"' || *name == '\\' )
+            fputc('\\', f);
+        fputc(*name, f);
+    }
+    fputc('\"', f);
+}
+
+void writeTrace(const string& filename)
+{
+    vector<TraceStat> stats;
+    getTraceStats(stats);
+
+    FILE* f = fopen(filename.c_str(), "wt");
+    if( !f )
+        CV_Error_(CV_StsError, ("Can not open %s for writing", filename.c_str()));
+
+    double scale = 1e6/getTickFrequency();
+    bool first = true;
+    fprintf(f, "{\n\"traceEvents\": [");
+    {
+    AutoLock lock(traceMutex);
+    int64 startTime = 0;
+    for( size_t i = 0; i < traceThreads.size(); i++ )
+    {
+        ThreadTrace* t = traceThreads[i];
+        AutoLock tlock(t->mutex);
+        if( t->count > 0 )
+        {
+            int64 t0 = t->events[(t->head + TRACE_BUFFER_SIZE - t->count) % TRACE_BUFFER_SIZE].startTime;
+            startTime = startTime == 0 ? t0 : std::min(startTime, t0);
+        }
+    }
+
+    for( size_t i = 0; i < traceThreads.size(); i++ )
+    {
+        ThreadTrace* t = traceThreads[i];
+        AutoLock tlock(t->mutex);
+        if( t->count == 0 )
+            continue;
+        fprintf(f, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"name\": \"thread %d\"}}", first ? "" : ",", t->threadId, t->threadId);
+        first = false;
+        for( size_t j = 0; j < t->count; j++ )
+        {
+            const TraceEvent& e = t->events[(t->head + TRACE_BUFFER_SIZE - t->count + j) % TRACE_BUFFER_SIZE];
+            fprintf(f, ",\n{\"name\": ");
+            writeJSONName(f, e.name);
+            fprintf(f, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+                    t->threadId, (e.startTime - startTime)*scale, e.duration*scale);
+            if( e.bytes > 0 )
+                fprintf(f, ", \"args\": {\"bytes\": %.0f}", (double)e.bytes);
+            fprintf(f, "}");
+        }
+    }
+    }
+    fprintf(f, "\n],\n\"displayTimeUnit\": \"ms\",\n\"stats\": [");
+    for( size_t i = 0; i < stats.size(); i++ )
+    {
+        const TraceStat& s = stats[i];
+        fprintf(f, "%s\n{\"name\": ", i == 0 ? "" : ",");
+        writeJSONName(f, s.name.c_str());
+        fprintf(f, ", \"calls\": %.0f, \"total_ms\": %.6g, \"max_ms\": %.6g, \"bytes\": %.0f}",
+                (double)s.calls, s.totalTime, s.maxTime, s.bytes);
+    }
+    fprintf(f, "\n]\n}\n");
+    fclose(f);
+}
+
+void clearTrace()
+{
+    AutoLock lock(traceMutex);
+    size_t i, j = 0;
+    for( i = 0; i < traceThreads.size(); i++ )
+    {
+        ThreadTrace* t = traceThreads[i];
+        if( t->finished )
+            delete t;
+        else
+        {
+            t->clear();
+            traceThreads[j++] = t;
+        }
+    }
+    traceThreads.resize(j);
+}
+
+}
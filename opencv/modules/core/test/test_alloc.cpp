@@ -0,0 +1,181 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "test_precomp.hpp"
+#include "opencv2/core/internal.hpp"
+
+using namespace cv;
+using namespace std;
+
+class Core_FastMallocTest : public cvtest::BaseTest
+{
+public:
+    Core_FastMallocTest() {}
+protected:
+    void run(int);
+};
+
+static size_t testBufSize(int i)
+{
+    // mostly small objects of various bins, sometimes the big ones
+    static const int sizes[] = { 1, 8, 16, 17, 100, 255, 1000, 3000, 16000, 16257, 100000 };
+    return sizes[(unsigned)(i*2654435761U) % (sizeof(sizes)/sizeof(sizes[0]))] + (i % 3);
+}
+
+struct AllocBody
+{
+    AllocBody(vector<uchar*>& _ptrs, bool* _failed) : ptrs(&_ptrs), failed(_failed) {}
+    void operator()(const BlockedRange& r) const
+    {
+        for( int i = r.begin(); i < r.end(); i++ )
+        {
+            size_t sz = testBufSize(i);
+            uchar* tmp = (uchar*)fastMalloc(sz);
+            uchar* p = (uchar*)fastMalloc(sz);
+            if( ((size_t)tmp | (size_t)p) & (CV_MALLOC_ALIGN-1) )
+                *failed = true;
+            memset(tmp, 0, sz);
+            memset(p, i & 255, sz);
+            fastFree(tmp);
+            (*ptrs)[i] = p;
+        }
+    }
+    vector<uchar*>* ptrs;
+    bool* failed;
+};
+
+struct FreeBody
+{
+    FreeBody(vector<uchar*>& _ptrs, bool* _failed) : ptrs(&_ptrs), failed(_failed) {}
+    void operator()(const BlockedRange& r) const
+    {
+        for( int k = r.begin(); k < r.end(); k++ )
+        {
+            // free the buffers in the reverse order, so that most of them are released by other threads
+            int i = (int)ptrs->size() - 1 - k;
+            uchar* p = (*ptrs)[i];
+            size_t sz = testBufSize(i);
+            for( size_t j = 0; j < sz; j++ )
+                if( p[j] != (uchar)(i & 255) )
+                {
+                    *failed = true;
+                    break;
+                }
+            fastFree(p);
+            (*ptrs)[i] = 0;
+        }
+    }
+    vector<uchar*>* ptrs;
+    bool* failed;
+};
+
+void Core_FastMallocTest::run(int)
+{
+    int nthreads0 = getNumThreads();
+    const int N = 20000;
+    vector<MallocBinStats> stats0, stats;
+    bool haveStats = getMallocStats(stats0);
+
+    for( int iter = 0; iter < 3; iter++ )
+    {
+        vector<uchar*> ptrs(N);
+        bool failed = false;
+
+        setNumThreads(4);
+        parallel_for(BlockedRange(0, N, 64), AllocBody(ptrs, &failed));
+        if( failed )
+        {
+            ts->printf(cvtest::TS::LOG, "fastMalloc returned a misaligned buffer\n");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            break;
+        }
+
+        // the workers that allocated the buffers exit here, leaving their blocks to the other threads
+        setNumThreads(iter + 1);
+        parallel_for(BlockedRange(0, N, 64), FreeBody(ptrs, &failed));
+        if( failed )
+        {
+            ts->printf(cvtest::TS::LOG, "the content of a fastMalloc'ed buffer is corrupted\n");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            break;
+        }
+    }
+    setNumThreads(nthreads0);
+
+    if( getMallocStats(stats) != haveStats )
+    {
+        ts->printf(cvtest::TS::LOG, "getMallocStats() result is inconsistent\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+        return;
+    }
+    if( !haveStats )
+        return;
+
+    int64 mallocCalls = 0, freeCalls = 0;
+    for( size_t i = 0; i < stats.size(); i++ )
+    {
+        const MallocBinStats& s = stats[i];
+        if( stats.size() != stats0.size() || s.objSize != stats0[i].objSize ||
+            (i > 0 && s.objSize <= stats[i-1].objSize) || s.objSize % CV_MALLOC_ALIGN != 0 ||
+            s.mallocCalls < stats0[i].mallocCalls || s.freeCalls < stats0[i].freeCalls ||
+            s.cacheHits > s.mallocCalls || s.blocks < 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "invalid statistics of the bin #%d\n", (int)i);
+            ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+            return;
+        }
+        mallocCalls += s.mallocCalls - stats0[i].mallocCalls;
+        freeCalls += s.freeCalls - stats0[i].freeCalls;
+    }
+
+    int nsmall = 0;
+    for( int i = 0; i < N; i++ )
+        nsmall += testBufSize(i) <= (size_t)stats.back().objSize;
+    if( mallocCalls < nsmall*2*3 || freeCalls < nsmall*2*3 )
+    {
+        ts->printf(cvtest::TS::LOG, "the pool has served %d allocations and %d deallocations, expected at least %d\n",
+                   (int)mallocCalls, (int)freeCalls, nsmall*2*3);
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+    }
+}
+
+TEST(Core_FastMalloc, accuracy) { Core_FastMallocTest test; test.safe_run(); }
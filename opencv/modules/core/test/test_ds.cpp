@@ -2120,10 +2120,83 @@ void Core_GraphScanTest::run( int )
 }
 
 
+// random appends/removals on SeqArena, checked against vector<vector<int> >
+class Core_SeqArenaTest : public cvtest::BaseTest
+{
+public:
+    Core_SeqArenaTest() {}
+protected:
+    void run(int)
+    {
+        RNG& rng = ts->get_rng();
+        SeqArena<int> arena;
+        vector<vector<int> > ref, out;
+
+        for( int iter = 0; iter < 3000; iter++ )
+        {
+            int op = rng.uniform(0, 10);
+            if( iter % 1000 == 999 )
+            {
+                arena.reset();
+                ref.clear();
+            }
+            else if( op == 0 || ref.empty() )
+            {
+                CV_Assert( arena.openSeq() == (int)ref.size() );
+                ref.push_back(vector<int>());
+            }
+            else if( op == 1 )
+            {
+                arena.popSeq();
+                ref.pop_back();
+            }
+            else if( op == 2 )
+            {
+                size_t len = rng.uniform(0, (int)ref.back().size() + 5);
+                size_t len0 = ref.back().size();
+                arena.resizeLast(len);
+                ref.back().resize(len);
+                for( size_t i = len0; i < len; i++ )
+                    arena.ptr((int)ref.size()-1)[i] = ref.back()[i] = (int)rng;
+            }
+            else if( op <= 5 )
+            {
+                int buf[20], n = rng.uniform(0, 20);
+                for( int i = 0; i < n; i++ )
+                    buf[i] = (int)rng;
+                if( op == 3 )
+                    arena.push_back(buf, n);
+                else
+                    std::copy(buf, buf + n, arena.grow(n));
+                ref.back().insert(ref.back().end(), buf, buf + n);
+            }
+            else
+            {
+                int val = (int)rng;
+                arena.push_back(val);
+                ref.back().push_back(val);
+            }
+
+            size_t total = 0;
+            for( size_t i = 0; i < ref.size(); i++ )
+                total += ref[i].size();
+            arena.copyTo(out);
+            if( arena.size() != ref.size() || arena.total() != total || out != ref )
+            {
+                ts->printf(cvtest::TS::LOG, "The arena content differs from the reference at iteration %d\n", iter);
+                ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+                return;
+            }
+        }
+    }
+};
+
+
 TEST(Core_DS_Seq, basic_operations) { Core_SeqBaseTest test; test.safe_run(); }
 TEST(Core_DS_Seq, sort_invert) { Core_SeqSortInvTest test; test.safe_run(); }
 TEST(Core_DS_Set, basic_operations) { Core_SetTest test; test.safe_run(); }
 TEST(Core_DS_Graph, basic_operations) { Core_GraphTest test; test.safe_run(); }
 TEST(Core_DS_Graph, scan) { Core_GraphScanTest test; test.safe_run(); }
+TEST(Core_DS_SeqArena, basic_operations) { Core_SeqArenaTest test; test.safe_run(); }
 
 
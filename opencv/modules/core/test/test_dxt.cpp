@@ -823,8 +823,75 @@ void CxCore_MulSpectrumsTest::prepare_to_validation( int /*test_case_idx*/ )
     }
 }
 
+
+////////////////////// DFTPlan ////////////////////////
+
+// the plan and the batched transforms must give exactly the same result as cv::dft()
+class Core_DFTPlanTest : public cvtest::BaseTest
+{
+public:
+    Core_DFTPlanTest() {}
+protected:
+    void run(int);
+};
+
+
+void Core_DFTPlanTest::run(int)
+{
+    const int ntests = 40;
+    RNG& rng = ts->get_rng();
+    int nthreads0 = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int depth = rng.uniform(0, 2) ? CV_32F : CV_64F, cn = rng.uniform(1, 3);
+        Size sz(getOptimalDFTSize(rng.uniform(1, 200)), rng.uniform(0, 4) ? rng.uniform(1, 150) : 1);
+        int flags = rng.uniform(0, 2) ? DFT_INVERSE : 0;
+        if( rng.uniform(0, 3) == 0 )
+            flags |= DFT_ROWS;
+        if( rng.uniform(0, 2) )
+            flags |= DFT_SCALE;
+        if( cn == 2 && (flags & DFT_INVERSE) && rng.uniform(0, 2) )
+            flags |= DFT_REAL_OUTPUT;
+
+        int type = CV_MAKETYPE(depth, cn), nbatch = rng.uniform(1, 6);
+        vector<Mat> src(nbatch), dst0(nbatch), dst1, dst2(nbatch);
+        for( int i = 0; i < nbatch; i++ )
+        {
+            src[i].create(sz, type);
+            rng.fill(src[i], RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+        }
+
+        setNumThreads(1);
+        for( int i = 0; i < nbatch; i++ )
+            dft(src[i], dst0[i], flags);
+
+        setNumThreads(rng.uniform(2, 5));
+        DFTPlan plan(sz, type, flags);
+        plan(src, dst1);
+        for( int i = 0; i < nbatch; i++ )
+            plan(src[i], dst2[i]);
+        setNumThreads(nthreads0);
+
+        for( int i = 0; i < nbatch; i++ )
+        {
+            if( dst1[i].type() != dst0[i].type() || norm(dst0[i], dst1[i], NORM_INF) != 0 ||
+                norm(dst0[i], dst2[i], NORM_INF) != 0 )
+            {
+                ts->printf(cvtest::TS::LOG, "DFTPlan result differs from dft(): "
+                           "type=%d, size=%dx%d, flags=%d, array %d of %d\n",
+                           type, sz.width, sz.height, flags, i, nbatch);
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                return;
+            }
+        }
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
 TEST(Core_DCT, accuracy) { CxCore_DCTTest test; test.safe_run(); }
 TEST(Core_DFT, accuracy) { CxCore_DFTTest test; test.safe_run(); }
 TEST(Core_MulSpectrums, accuracy) { CxCore_MulSpectrumsTest test; test.safe_run(); }
+TEST(Core_DFTPlan, accuracy) { Core_DFTPlanTest test; test.safe_run(); }
 
 
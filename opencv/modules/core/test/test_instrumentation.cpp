@@ -0,0 +1,158 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+
+#include "test_precomp.hpp"
+#include "opencv2/core/internal.hpp"
+
+using namespace cv;
+using namespace std;
+
+class Core_InstrumentationTest : public cvtest::BaseTest
+{
+public:
+    Core_InstrumentationTest() {}
+protected:
+    void run(int);
+};
+
+static const char* traceOuterName = "Core_InstrumentationTest::outer";
+static const char* traceInnerName = "Core_InstrumentationTest::inner";
+
+class TraceLoopBody
+{
+public:
+    void operator()(const BlockedRange& range) const
+    {
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            TraceRegion region(traceInnerName, 10);
+            region.addBytes(5);
+        }
+    }
+};
+
+static const TraceStat* findStat(const vector<TraceStat>& stats, const char* name)
+{
+    for( size_t i = 0; i < stats.size(); i++ )
+        if( stats[i].name == name )
+            return &stats[i];
+    return 0;
+}
+
+void Core_InstrumentationTest::run(int)
+{
+    const int N = 1000;
+    bool wasEnabled = isTraceEnabled();
+    vector<TraceStat> stats;
+
+    setTraceEnabled(false);
+    clearTrace();
+    {
+        TraceRegion region(traceOuterName);
+        parallel_for(BlockedRange(0, N), TraceLoopBody());
+    }
+    getTraceStats(stats);
+    if( findStat(stats, traceOuterName) || findStat(stats, traceInnerName) )
+    {
+        ts->printf(cvtest::TS::LOG, "The regions are recorded when the instrumentation is off\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+        setTraceEnabled(wasEnabled);
+        return;
+    }
+
+    setTraceEnabled(true);
+    for( int iter = 0; iter < 2; iter++ )
+    {
+        TraceRegion region(traceOuterName);
+        parallel_for(BlockedRange(0, N), TraceLoopBody());
+    }
+    setTraceEnabled(wasEnabled);
+
+    getTraceStats(stats);
+    const TraceStat* outer = findStat(stats, traceOuterName);
+    const TraceStat* inner = findStat(stats, traceInnerName);
+    if( !outer || !inner || outer->calls != 2 || inner->calls != 2*N || inner->bytes != 2*N*15. ||
+        outer->maxTime > outer->totalTime || inner->maxTime > inner->totalTime )
+    {
+        ts->printf(cvtest::TS::LOG, "Invalid trace statistics\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+        return;
+    }
+
+    string filename = tempfile(".json");
+    writeTrace(filename);
+    FILE* f = fopen(filename.c_str(), "rt");
+    string contents;
+    if( f )
+    {
+        char buf[1 << 12];
+        size_t n;
+        while( (n = fread(buf, 1, sizeof(buf), f)) > 0 )
+            contents.append(buf, n);
+        fclose(f);
+    }
+    remove(filename.c_str());
+
+    size_t pos = 0;
+    int nevents = 0;
+    while( (pos = contents.find("\"name\": \"Core_InstrumentationTest::inner\", \"ph\": \"X\"", pos)) != string::npos )
+        nevents++, pos++;
+    if( contents.find("\"traceEvents\"") == string::npos || nevents != 2*N )
+    {
+        ts->printf(cvtest::TS::LOG, "Invalid trace file: %d events of the inner region found\n", nevents);
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+        return;
+    }
+
+    clearTrace();
+    getTraceStats(stats);
+    if( findStat(stats, traceOuterName) )
+    {
+        ts->printf(cvtest::TS::LOG, "clearTrace() does not reset the statistics\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+        return;
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
+TEST(Core_Instrumentation, accuracy) { Core_InstrumentationTest test; test.safe_run(); }
@@ -91,7 +91,7 @@ protected:
             {-1000000, 1000000}, {-10, 10}, {-10, 10}};
         RNG& rng = ts->get_rng();
         RNG rng0;
-        test_case_count = 2;
+        test_case_count = 3;
         int progress = 0;
         MemStorage storage(cvCreateMemStorage(0));
         
@@ -102,7 +102,7 @@ protected:
             
             cvClearMemStorage(storage);
             
-            string filename = tempfile(idx % 2 ? ".yml" : ".xml");
+            string filename = tempfile(idx % 3 == 0 ? ".xml" : idx % 3 == 1 ? ".yml" : ".bin");
             
             FileStorage fs(filename.c_str(), FileStorage::WRITE);
             
@@ -376,3 +376,218 @@ protected:
 };
 
 TEST(Core_InputOutput, write_read_consistency) { Core_IOTest test; test.safe_run(); }
+
+
+class Core_BinaryStorageTest : public cvtest::BaseTest
+{
+public:
+    Core_BinaryStorageTest() {}
+protected:
+    void run(int)
+    {
+        RNG& rng = ts->get_rng();
+        // the storage format is given by the flag here, the reader detects it by the signature
+        string filename = tempfile(".yml");
+
+        Mat big(317, 289, CV_32FC3), big0;
+        rng.fill(big, RNG::UNIFORM, Scalar::all(-100), Scalar::all(100));
+        Mat roi = big(Rect(3, 5, 200, 101));
+        int sz[] = { 5, 40, 33 };
+        Mat nd(3, sz, CV_16S);
+        rng.fill(nd, RNG::UNIFORM, Scalar::all(-1000), Scalar::all(1000));
+        Mat small = Mat::eye(3, 3, CV_64F);
+        vector<int> ivec(3000);
+        for( size_t i = 0; i < ivec.size(); i++ )
+            ivec[i] = (int)(i*i) - 1000;
+        big.copyTo(big0);
+
+        {
+        FileStorage fs(filename, FileStorage::WRITE + FileStorage::FORMAT_BINARY);
+        fs << "big" << big << "roi" << roi << "nd" << nd << "small" << small;
+        fs << "ivec" << "[:" << ivec << "]";
+        fs << "name" << "binary";
+        }
+
+        Mat big1, big2, roi1, nd1, small1;
+        {
+        FileStorage fs(filename, FileStorage::READ);
+        CV_Assert( fs.isOpened() );
+        fs["big"] >> big1;
+        fs["big"] >> big2;
+        fs["roi"] >> roi1;
+        fs["nd"] >> nd1;
+        fs["small"] >> small1;
+
+        vector<int> ivec1;
+        fs["ivec"] >> ivec1;
+        FileNode ivecNode = fs["ivec"];
+        vector<double> dvec(10);
+        CvSeqReader reader;
+        cvStartReadRawData(*fs, *ivecNode, &reader);
+        cvSetSeqReaderPos(&reader, 0);
+        cvReadRawDataSlice(*fs, &reader, 10, &dvec[0], "d");
+
+        if( ivec1 != ivec || ivecNode.size() != ivec.size() || (int)ivecNode[2999] != ivec[2999] ||
+            dvec[9] != ivec[9] || (string)fs["name"] != "binary" )
+        {
+            ts->printf( cvtest::TS::LOG, "the sequences or the scalars are not read correctly\n" );
+            ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+            return;
+        }
+        }
+
+        // the large matrices reference the mapped file and stay valid after the storage is closed
+        if( big1.data != big2.data || ((size_t)big1.data & 63) != 0 ||
+            norm(big1, big0, NORM_INF) != 0 || norm(roi1, roi, NORM_INF) != 0 ||
+            norm(nd1, nd, NORM_INF) != 0 || norm(small1, small, NORM_INF) != 0 ||
+            nd1.dims != 3 || nd1.size[2] != sz[2] )
+        {
+            ts->printf( cvtest::TS::LOG, "the matrices are not read correctly\n" );
+            ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+            return;
+        }
+
+        // modifying the matrix does not change the file
+        big1.setTo(Scalar::all(0));
+        if( norm(big2, Mat::zeros(big.size(), big.type()), NORM_INF) != 0 )
+        {
+            ts->printf( cvtest::TS::LOG, "the matrices read from the same node do not share the data\n" );
+            ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+            return;
+        }
+        big1.release();
+        big2.release();
+        roi1.release();
+
+        FileStorage fs(filename, FileStorage::READ);
+        CvMat* m = (CvMat*)fs["big"].readObj();
+        if( !CV_IS_MAT(m) || norm(Mat(m), big0, NORM_INF) != 0 )
+        {
+            ts->printf( cvtest::TS::LOG, "the binary file has been modified\n" );
+            ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+        }
+        cvReleaseMat(&m);
+        fs.release();
+        nd1.release();
+        remove(filename.c_str());
+    }
+};
+
+TEST(Core_InputOutput, binary_storage) { Core_BinaryStorageTest test; test.safe_run(); }
+
+class Core_StreamReaderTest : public cvtest::BaseTest
+{
+public:
+    Core_StreamReaderTest() {}
+protected:
+    // checks that the reader, which is at the node, walks through it the same way as FileNodeIterator
+    bool compare(FileStreamReader& reader, const FileNode& node, int level)
+    {
+        int type = node.type();
+        if( reader.type() != type || reader.level() != level || reader.name() != node.name() )
+            return false;
+
+        if( type == FileNode::SEQ || type == FileNode::MAP )
+        {
+            // FileNodeIterator treats the registered objects as scalars
+            CvFileNode plain = **node;
+            plain.tag &= ~FileNode::USER;
+            FileNode plainNode(node.fs, &plain);
+            for( FileNodeIterator it = plainNode.begin(); it != plainNode.end(); ++it )
+            {
+                if( !reader.next() || !compare(reader, *it, level + 1) )
+                    return false;
+            }
+            return reader.next() && reader.type() == FileStreamReader::END &&
+                reader.level() == level && reader.name() == node.name();
+        }
+        return (type != FileNode::INT || (int)reader.node() == (int)node) &&
+            (type != FileNode::REAL || (double)reader.node() == (double)node) &&
+            (type != FileNode::STR || (string)reader.node() == (string)node);
+    }
+
+    void run(int)
+    {
+        const char* exts[] = { ".yml", ".xml", ".yml.gz" };
+        RNG& rng = ts->get_rng();
+        Mat m(10, 7, CV_64FC2);
+        rng.fill(m, RNG::UNIFORM, Scalar::all(-10), Scalar::all(10));
+        vector<Point3f> pts(2500);
+        for( size_t i = 0; i < pts.size(); i++ )
+            pts[i] = Point3f((float)i, (float)rng.uniform(-1., 1.), (float)i*0.5f);
+
+        for( int idx = 0; idx < 3; idx++ )
+        {
+            string filename = tempfile(exts[idx]);
+            bool gz = idx == 2;
+            {
+            FileStorage fs(filename, FileStorage::WRITE);
+            fs << "name" << "stream test" << "count" << (int)pts.size() << "scale" << 0.25;
+            fs << "skipped" << "{" << "m" << m << "list" << "[" << 1 << "x: y" << "{:" << "a" << 1 << "}" << "]" << "}";
+            fs << "camera" << m;
+            fs << "points" << "[:";
+            fs.writeRaw("3f", (const uchar*)&pts[0], pts.size()*sizeof(pts[0]));
+            fs << "]" << "empty" << "[" << "]" << "tail" << -7;
+            }
+            if( !gz )
+            {
+                FileStorage fs(filename, FileStorage::APPEND);
+                fs << "second" << "[" << "{" << "k" << 1 << "}" << "{" << "k" << 2 << "}" << "]";
+            }
+
+            {
+            FileStorage fs(filename, FileStorage::READ);
+            FileStreamReader reader(filename);
+            CV_Assert( fs.isOpened() && reader.isOpened() );
+            // YAML appends a new document, XML reopens the single root
+            int i = 0;
+            for( ; !fs.root(i).empty(); i++ )
+                if( !reader.next() || !compare(reader, fs.root(i), 0) )
+                    break;
+            if( !fs.root(i).empty() || reader.next() )
+            {
+                ts->printf( cvtest::TS::LOG, "the nodes of %s are read differently\n", exts[idx] );
+                ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+                return;
+            }
+            }
+
+            FileStreamReader reader(filename);
+            Mat camera;
+            vector<Point3f> pts1;
+            int tail = 0, nempty = -1;
+            while( reader.next() )
+            {
+                if( reader.level() != 1 || reader.type() == FileStreamReader::END )
+                    continue;
+                if( reader.name() == "camera" )
+                    read(reader.node(), camera, Mat());
+                else if( reader.name() == "points" )
+                {
+                    Point3f buf[64];
+                    size_t n;
+                    while( (n = reader.readRaw("3f", (uchar*)buf, 64)) > 0 )
+                        pts1.insert(pts1.end(), buf, buf + n);
+                }
+                else if( reader.name() == "empty" )
+                    nempty = (int)reader.readRaw("i", (uchar*)&tail, 1);
+                else if( reader.name() == "tail" )
+                    tail = (int)reader.node();
+                else
+                    reader.skip();
+            }
+
+            if( norm(camera, m, NORM_INF) != 0 || pts1.size() != pts.size() ||
+                norm(Mat(pts1), Mat(pts), NORM_INF) != 0 || tail != -7 || nempty != 0 )
+            {
+                ts->printf( cvtest::TS::LOG, "the selected nodes of %s are not read correctly\n", exts[idx] );
+                ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+                return;
+            }
+            reader.release();
+            remove(filename.c_str());
+        }
+    }
+};
+
+TEST(Core_InputOutput, stream_reader) { Core_StreamReaderTest test; test.safe_run(); }
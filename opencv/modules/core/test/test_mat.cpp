@@ -817,8 +817,188 @@ void Core_ArrayOpTest::run( int /* start_from */)
     ts->set_failed_test_info(errcount == 0 ? cvtest::TS::OK : cvtest::TS::FAIL_INVALID_OUTPUT);
 }
 
+class Core_RecyclingAllocatorTest : public cvtest::BaseTest
+{
+public:
+    Core_RecyclingAllocatorTest() {}
+protected:
+    void run(int);
+    bool check(bool cond, const char* msg);
+};
+
+bool Core_RecyclingAllocatorTest::check(bool cond, const char* msg)
+{
+    if( !cond )
+    {
+        ts->printf(cvtest::TS::LOG, "%s\n", msg);
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+    }
+    return cond;
+}
+
+void Core_RecyclingAllocatorTest::run(int)
+{
+    RecyclingMatAllocator a(64 << 20, 4);
+
+    // per-matrix allocator
+    {
+        Mat m;
+        m.allocator = &a;
+        m.create(480, 640, CV_8UC3);
+        uchar* data = m.data;
+        m.release();
+        m.create(479, 641, CV_8UC3);
+        RecyclingMatAllocator::Stats s = a.getStats();
+        if( !check(s.misses == 1 && s.hits == 1 && m.data == data && m.isContinuous() &&
+                   m.step == (size_t)641*3, "the released buffer has not been reused") )
+            return;
+        m = Scalar(1, 2, 3);
+        if( !check(m.at<Vec3b>(478, 640) == Vec3b(1, 2, 3), "the recycled buffer is not writable") )
+            return;
+    }
+
+    // process-wide default: after the first frame nothing is allocated
+    a.resetStats();
+    setDefaultAllocator(&a);
+    RNG& rng = ts->get_rng();
+    double sum0 = 0;
+    for( int frame = 0; frame < 10; frame++ )
+    {
+        Mat src(240, 320, CV_8UC3), f, g;
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        src.convertTo(f, CV_32F, 1./255);
+        g = f*2 + f;
+        sum0 += sum(g)[0];
+        if( frame == 0 )
+            a.resetStats();
+    }
+    setDefaultAllocator(0);
+    RecyclingMatAllocator::Stats s = a.getStats();
+    if( !check(s.misses == 0 && s.hits > 0 && s.evictions == 0,
+               "the steady-state loop has allocated new buffers") )
+        return;
+    if( !check(getDefaultAllocator() == 0, "the default allocator has not been reset") )
+        return;
+
+    // the thread default overrides the process-wide one
+    RecyclingMatAllocator b;
+    setDefaultAllocator(&a);
+    setThreadDefaultAllocator(&b);
+    {
+        Mat m(10, 10, CV_32F);
+        if( !check(getDefaultAllocator() == &b && m.allocator == &b, "the thread default allocator is not used") )
+            return;
+    }
+    setThreadDefaultAllocator(0);
+    if( !check(getDefaultAllocator() == &a, "the thread default allocator has not been reset") )
+        return;
+    setDefaultAllocator(0);
+    {
+        Mat m(10, 10, CV_32F);
+        if( !check(m.allocator == 0, "the matrix is not allocated with fastMalloc") )
+            return;
+    }
+
+    // the limits
+    s = a.getStats();
+    if( !check(s.cachedBuffers > 0 && s.cachedBytes > 0, "there are no cached buffers") )
+        return;
+    a.setLimits(0, 4);
+    s = a.getStats();
+    if( !check(s.cachedBuffers == 0 && s.cachedBytes == 0, "setLimits() has not released the buffers") )
+        return;
+    {
+        Mat m;
+        m.allocator = &a;
+        m.create(100, 100, CV_8U);
+    }
+    s = a.getStats();
+    check(s.evictions >= 1 && s.cachedBuffers == 0, "the buffer has been cached beyond the limit");
+}
+
+class Core_ExternalDataTest : public cvtest::BaseTest
+{
+public:
+    Core_ExternalDataTest() {}
+protected:
+    void run(int);
+};
+
+struct ExternalBuffer
+{
+    ExternalBuffer(size_t size) : buf(size), released(0) {}
+    static void release(void* data, void* userdata)
+    {
+        ExternalBuffer* b = (ExternalBuffer*)userdata;
+        if( data == &b->buf[0] )
+            b->released++;
+    }
+    vector<uchar> buf;
+    int released;
+};
+
+void Core_ExternalDataTest::run(int)
+{
+    const size_t step = 640*3 + 64;
+    ExternalBuffer b(480*step);
+    int errcount = 0;
+
+    {
+        Mat m(480, 640, CV_8UC3, &b.buf[0], ExternalBuffer::release, &b, step);
+        Mat roi = m(Rect(10, 20, 30, 40)), m2, row;
+        m2 = m;
+        m.release();
+        row = roi.row(5).reshape(1);
+        if( roi.refcount != m2.refcount || !m2.refcount || *m2.refcount != 3 || b.released != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "the headers do not share the reference counter of the external data\n");
+            errcount++;
+        }
+        m2.release();
+        roi.release();
+        row.setTo(Scalar(7));
+        if( b.buf[25*step + 10*3] != 7 || b.released != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "the external data has been released too early\n");
+            errcount++;
+        }
+        // re-allocation of the last header releases the external buffer and allocates the new one
+        row.create(10, 10, CV_32F);
+        if( b.released != 1 || row.allocator != getDefaultAllocator() )
+        {
+            ts->printf(cvtest::TS::LOG, "the external data has not been released on re-allocation\n");
+            errcount++;
+        }
+    }
+    if( b.released != 1 )
+    {
+        ts->printf(cvtest::TS::LOG, "the deallocator is called %d times instead of 1\n", b.released);
+        errcount++;
+    }
+
+    // n-dimensional arrays
+    b.released = 0;
+    {
+        int sz[] = { 4, 5, 6 };
+        Mat m(3, sz, CV_32S, &b.buf[0], ExternalBuffer::release, &b);
+        m = Scalar(3);
+        if( sum(m)[0] != 4*5*6*3 || ((int*)&b.buf[0])[4*5*6-1] != 3 || b.released != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "the n-dimensional header over the external data is broken\n");
+            errcount++;
+        }
+    }
+    if( b.released != 1 )
+    {
+        ts->printf(cvtest::TS::LOG, "the deallocator of the n-dimensional array is called %d times\n", b.released);
+        errcount++;
+    }
+
+    ts->set_failed_test_info(errcount == 0 ? cvtest::TS::OK : cvtest::TS::FAIL_INVALID_OUTPUT);
+}
+
 TEST(Core_PCA, accuracy) { Core_PCATest test; test.safe_run(); }
 TEST(Core_Reduce, accuracy) { Core_ReduceTest test; test.safe_run(); }
 TEST(Core_Array, basic_operations) { Core_ArrayOpTest test; test.safe_run(); }
-
-
+TEST(Core_RecyclingAllocator, accuracy) { Core_RecyclingAllocatorTest test; test.safe_run(); }
+TEST(Core_Mat, external_data) { Core_ExternalDataTest test; test.safe_run(); }
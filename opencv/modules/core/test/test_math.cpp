@@ -706,6 +706,72 @@ void Core_GEMMTest::prepare_to_validation( int )
 }
 
 
+// the products that are big enough for the packed kernels, on submatrices and with
+// different numbers of threads
+class Core_GEMMLargeTest : public cvtest::BaseTest
+{
+public:
+    Core_GEMMLargeTest() {}
+protected:
+    void run(int);
+};
+
+
+void Core_GEMMLargeTest::run(int)
+{
+    const int ntests = 30;
+    RNG& rng = ts->get_rng();
+    int nthreads0 = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = rng.uniform(0, 2) ? CV_32F : CV_64F;
+        int flags = rng.uniform(0, 8);
+        int m = rng.uniform(40, 260), n = rng.uniform(40, 260), len = rng.uniform(40, 700);
+        double alpha = rng.uniform(-2., 2.), beta = rng.uniform(0, 2) ? rng.uniform(-2., 2.) : 0.;
+        Size asize = flags & GEMM_1_T ? Size(m, len) : Size(len, m);
+        Size bsize = flags & GEMM_2_T ? Size(len, n) : Size(n, len);
+        Size csize = flags & GEMM_3_T ? Size(m, n) : Size(n, m);
+        Mat abig(asize.height + 3, asize.width + 5, type), bbig(bsize.height + 1, bsize.width + 7, type);
+        Mat A = abig(Rect(Point(2, 1), asize)), B = bbig(Rect(Point(3, 0), bsize)), C;
+
+        rng.fill(abig, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+        rng.fill(bbig, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+        if( beta != 0 )
+        {
+            C.create(csize, type);
+            rng.fill(C, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+        }
+
+        Mat dst0, dst1, ref;
+        setNumThreads(1);
+        gemm(A, B, alpha, C, beta, dst0, flags);
+        setNumThreads(rng.uniform(2, 5));
+        gemm(A, B, alpha, C, beta, dst1, flags);
+        setNumThreads(nthreads0);
+
+        if( norm(dst0, dst1, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The parallel product differs from the serial one: "
+                       "type=%d, flags=%d, m=%d, n=%d, len=%d\n", type, flags, m, n, len);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+
+        cvtest::gemm(A, B, alpha, C, beta, ref, flags);
+        double err = norm(dst0, ref, NORM_INF)/std::max(norm(ref, NORM_INF), 1.);
+        if( err > (type == CV_32F ? FLT_EPSILON*64 : DBL_EPSILON*256) )
+        {
+            ts->printf(cvtest::TS::LOG, "Bad accuracy: type=%d, flags=%d, m=%d, n=%d, len=%d, "
+                       "err=%g\n", type, flags, m, n, len, err);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
+
 ///////////////// multransposed /////////////////////
 
 class Core_MulTransposedTest : public Core_MatrixTest
@@ -2357,6 +2423,7 @@ TEST(Core_CrossProduct, accuracy) { Core_CrossProductTest test; test.safe_run();
 TEST(Core_Determinant, accuracy) { Core_DetTest test; test.safe_run(); }
 TEST(Core_DotProduct, accuracy) { Core_DotProductTest test; test.safe_run(); }
 TEST(Core_GEMM, accuracy) { Core_GEMMTest test; test.safe_run(); }
+TEST(Core_GEMMLarge, accuracy) { Core_GEMMLargeTest test; test.safe_run(); }
 TEST(Core_Invert, accuracy) { Core_InvertTest test; test.safe_run(); }
 TEST(Core_Mahalanobis, accuracy) { Core_MahalanobisTest test; test.safe_run(); }
 TEST(Core_MulTransposed, accuracy) { Core_MulTransposedTest test; test.safe_run(); }
@@ -73,6 +73,7 @@ protected:
     bool TestMatND();
     bool TestSparseMat();
     bool operations1();
+    bool TestFusedExpr();
 
     void checkDiff(const Mat& m1, const Mat& m2, const string& s) { if (norm(m1, m2, NORM_INF) != 0) throw test_excep(s); }
     void checkDiffF(const Mat& m1, const Mat& m2, const string& s) { if (norm(m1, m2, NORM_INF) > 1e-5) throw test_excep(s); }
@@ -803,6 +804,71 @@ bool CV_OperationsTest::operations1()
     return true;
 }
 
+bool CV_OperationsTest::TestFusedExpr()
+{
+    try
+    {
+        RNG& rng = ts->get_rng();
+        for( int iter = 0; iter < 2; iter++ )
+        {
+            int type = iter == 0 ? CV_32FC1 : CV_64FC3;
+            Mat a(37, 129, type), b(a.size(), type), c(a.size(), type), d(a.size(), type);
+            rng.fill(a, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+            rng.fill(b, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+            rng.fill(c, RNG::UNIFORM, Scalar::all(1), Scalar::all(2));
+            rng.fill(d, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+            Mat t1, t2, t3;
+
+            MatExpr e = a*0.5 + b.mul(c) - d;
+            if( e.explain().find("fused") != 0 ) throw test_excep("a*0.5 + b.mul(c) - d is not fused");
+            multiply(b, c, t1);
+            addWeighted(a, 0.5, t1, 1, 0, t2);
+            subtract(t2, d, t3);
+            CHECK_DIFF_FLT(Mat(e), t3);
+            CHECK_DIFF_FLT(Mat(e(Range(3, 20), Range(10, 100))), t3(Range(3, 20), Range(10, 100)));
+
+            multiply(a, a, t1);
+            divide(t1, c, t2, 2);
+            add(t2, Scalar(1, 2, 3), t2);
+            t3 = abs(t2);
+            CHECK_DIFF_FLT(Mat(abs(a.mul(a) / c * 2 + Scalar(1, 2, 3))), t3);
+
+            max(a, b, t1);
+            divide(3, c, t2);
+            subtract(t1, t2, t3);
+            CHECK_DIFF_FLT(Mat(max(a, b) - 3/c), t3);
+
+            Mat m = d.clone();
+            m += a.mul(b) - c;
+            multiply(a, b, t1);
+            subtract(t1, c, t2);
+            add(d, t2, t3);
+            CHECK_DIFF_FLT(m, t3);
+
+            // the input is overwritten by the result
+            m = a.clone();
+            m = m.mul(b) + m.mul(c);
+            multiply(a, b, t1);
+            multiply(a, c, t2);
+            add(t1, t2, t3);
+            CHECK_DIFF_FLT(m, t3);
+        }
+
+        // integer expressions saturate at every step and are not fused
+        Mat_<uchar> u(3, 3, (uchar)200);
+        MatExpr ue = u.mul(u) - u;
+        if( ue.explain().find("fused") == 0 ) throw test_excep("an integer expression is fused");
+        CHECK_DIFF(Mat(ue), Mat(Mat_<uchar>(3, 3, (uchar)55)));
+    }
+    catch(const test_excep& e)
+    {
+        ts->printf(cvtest::TS::LOG, "%s\n", e.s.c_str());
+        ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+        return false;
+    }
+    return true;
+}
+
 void CV_OperationsTest::run( int /* start_from */)
 {
     if (!TestMat())
@@ -823,6 +889,9 @@ void CV_OperationsTest::run( int /* start_from */)
     if (!operations1())
         return;
 
+    if (!TestFusedExpr())
+        return;
+
     ts->set_failed_test_info(cvtest::TS::OK);
 }
 
@@ -0,0 +1,441 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "test_precomp.hpp"
+#include "opencv2/core/internal.hpp"
+
+using namespace cv;
+using namespace std;
+
+class Core_ParallelTest : public cvtest::BaseTest
+{
+public:
+    Core_ParallelTest() {}
+protected:
+    void run(int);
+    bool checkFor(int nthreads, const BlockedRange& range);
+    bool checkReduce(int nthreads, const BlockedRange& range);
+    bool checkNested(int nthreads);
+    bool checkException(int nthreads);
+};
+
+struct MarkBody
+{
+    MarkBody(vector<int>& _marks, int _grain, int _begin, bool* _misaligned)
+        : marks(&_marks), grain(_grain), begin(_begin), misaligned(_misaligned) {}
+    void operator()(const BlockedRange& r) const
+    {
+        if( (r.begin() - begin) % grain != 0 )
+            *misaligned = true;
+        for( int i = r.begin(); i < r.end(); i++ )
+            CV_XADD(&(*marks)[i], 1);
+    }
+    vector<int>* marks;
+    int grain, begin;
+    bool* misaligned;
+};
+
+struct SumBody
+{
+    SumBody(const vector<double>& _data) : data(&_data), sum(0) {}
+    SumBody(const SumBody& b, Split) : data(b.data), sum(0) {}
+    void operator()(const BlockedRange& r)
+    {
+        for( int i = r.begin(); i < r.end(); i++ )
+            sum += (*data)[i];
+    }
+    void join(SumBody& b) { sum += b.sum; }
+    const vector<double>* data;
+    double sum;
+};
+
+struct NestedBody
+{
+    NestedBody(Mat& _m) : m(&_m) {}
+    void operator()(const BlockedRange& r) const
+    {
+        for( int i = r.begin(); i < r.end(); i++ )
+        {
+            vector<int> marks(m->cols, 0);
+            bool misaligned = false;
+            parallel_for(BlockedRange(0, m->cols), MarkBody(marks, 1, 0, &misaligned));
+            for( int j = 0; j < m->cols; j++ )
+                m->at<int>(i, j) = marks[j];
+        }
+    }
+    Mat* m;
+};
+
+struct ThrowBody
+{
+    void operator()(const BlockedRange& r) const
+    {
+        for( int i = r.begin(); i < r.end(); i++ )
+            if( i == 77 )
+                CV_Error(CV_StsBadArg, "test exception");
+    }
+};
+
+bool Core_ParallelTest::checkFor(int nthreads, const BlockedRange& range)
+{
+    vector<int> marks(range.end(), 0);
+    bool misaligned = false;
+    parallel_for(range, MarkBody(marks, range.grainsize(), range.begin(), &misaligned));
+    for( int i = 0; i < range.end(); i++ )
+        if( marks[i] != (i >= range.begin()) )
+        {
+            ts->printf(cvtest::TS::LOG, "parallel_for: element %d is processed %d times (%d threads, grain=%d)\n",
+                       i, marks[i], nthreads, range.grainsize());
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return false;
+        }
+    if( misaligned )
+    {
+        ts->printf(cvtest::TS::LOG, "parallel_for: sub-range is not aligned by the grain size %d\n", range.grainsize());
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return false;
+    }
+    return true;
+}
+
+bool Core_ParallelTest::checkReduce(int nthreads, const BlockedRange& range)
+{
+    RNG& rng = ts->get_rng();
+    vector<double> data(range.end());
+    for( size_t i = 0; i < data.size(); i++ )
+        data[i] = rng.uniform(-1., 1.);
+
+    SumBody b0(data);
+    b0(range);
+    double sum1 = 0;
+    for( int k = 0; k < 3; k++ )
+    {
+        SumBody b(data);
+        parallel_reduce(range, b);
+        if( fabs(b.sum - b0.sum) > 1e-9*range.end() || (k > 0 && b.sum != sum1) )
+        {
+            ts->printf(cvtest::TS::LOG, "parallel_reduce: sum=%g, expected %g (%d threads, iteration %d)\n",
+                       b.sum, b0.sum, nthreads, k);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return false;
+        }
+        sum1 = b.sum;
+    }
+    return true;
+}
+
+bool Core_ParallelTest::checkNested(int nthreads)
+{
+    Mat m(37, 1013, CV_32S, Scalar::all(0));
+    parallel_for(BlockedRange(0, m.rows), NestedBody(m));
+    if( countNonZero(m != 1) != 0 )
+    {
+        ts->printf(cvtest::TS::LOG, "nested parallel_for failed (%d threads)\n", nthreads);
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return false;
+    }
+    return true;
+}
+
+bool Core_ParallelTest::checkException(int nthreads)
+{
+    bool caught = false;
+    try
+    {
+        parallel_for(BlockedRange(0, 1000), ThrowBody());
+    }
+    catch(const cv::Exception& e)
+    {
+        caught = e.code == CV_StsBadArg;
+    }
+    if( !caught )
+    {
+        ts->printf(cvtest::TS::LOG, "the exception thrown in parallel_for has not been propagated (%d threads)\n", nthreads);
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return false;
+    }
+    return true;
+}
+
+void Core_ParallelTest::run(int)
+{
+    int nthreads0 = getNumThreads();
+    int threads[] = { 1, 2, 3, 8 };
+
+    for( size_t t = 0; t < sizeof(threads)/sizeof(threads[0]); t++ )
+    {
+        int nthreads = threads[t];
+        setNumThreads(nthreads);
+        if( getNumThreads() != nthreads )
+        {
+            ts->printf(cvtest::TS::LOG, "getNumThreads() returned %d instead of %d\n", getNumThreads(), nthreads);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            break;
+        }
+
+        if( !checkFor(nthreads, BlockedRange(0, 10000)) ||
+            !checkFor(nthreads, BlockedRange(5, 1001, 7)) ||
+            !checkFor(nthreads, BlockedRange(3, 4)) ||
+            !checkReduce(nthreads, BlockedRange(0, 100000, 100)) ||
+            !checkReduce(nthreads, BlockedRange(10, 17)) ||
+            !checkNested(nthreads) ||
+            !checkException(nthreads) )
+            break;
+    }
+
+    setNumThreads(nthreads0);
+}
+
+TEST(Core_Parallel, accuracy) { Core_ParallelTest test; test.safe_run(); }
+
+// the reductions of core (sum, norm, minMaxIdx ...) split large arrays into chunks that
+// do not depend on the number of threads, so the results must be the same bit-to-bit.
+class Core_ParallelReduceTest : public cvtest::BaseTest
+{
+public:
+    Core_ParallelReduceTest() {}
+protected:
+    void run(int);
+    void compute(const Mat& a, const Mat& b, vector<double>& r);
+};
+
+void Core_ParallelReduceTest::compute(const Mat& a, const Mat& b, vector<double>& r)
+{
+    r.clear();
+    Scalar s = sum(a), mu, sd;
+    meanStdDev(a, mu, sd);
+    for( int c = 0; c < 4; c++ )
+    {
+        r.push_back(s[c]);
+        r.push_back(mu[c]);
+        r.push_back(sd[c]);
+    }
+    r.push_back(norm(a, NORM_INF));
+    r.push_back(norm(a, NORM_L1));
+    r.push_back(norm(a, NORM_L2));
+    r.push_back(norm(a, b, NORM_INF));
+    r.push_back(norm(a, b, NORM_L1));
+    r.push_back(norm(a, b, NORM_L2));
+    if( a.channels() == 1 )
+    {
+        double minVal = 0, maxVal = 0;
+        int minIdx[2] = {-1, -1}, maxIdx[2] = {-1, -1};
+        minMaxIdx(a, &minVal, &maxVal, minIdx, maxIdx);
+        r.push_back(minVal);
+        r.push_back(maxVal);
+        r.push_back(minIdx[0]*a.cols + minIdx[1]);
+        r.push_back(maxIdx[0]*a.cols + maxIdx[1]);
+        r.push_back(countNonZero(a));
+    }
+}
+
+void Core_ParallelReduceTest::run(int)
+{
+    int nthreads0 = getNumThreads();
+    RNG& rng = ts->get_rng();
+    int types[] = { CV_8UC1, CV_8SC3, CV_16UC1, CV_16SC2, CV_32SC1, CV_32FC1, CV_32FC4, CV_64FC1 };
+
+    for( int iter = 0; iter < 16; iter++ )
+    {
+        int type = types[iter % (int)(sizeof(types)/sizeof(types[0]))];
+        Size sz(rng.uniform(1, 1200), rng.uniform(1, 600));
+        Mat a0(sz.height + 2, sz.width + 3, type), b(sz, type);
+        cvtest::randUni(rng, a0, Scalar::all(-100), Scalar::all(100));
+        cvtest::randUni(rng, b, Scalar::all(-100), Scalar::all(100));
+        // a non-continuous array, so that the chunks are made of rows
+        Mat a = a0(Rect(1, 1, sz.width, sz.height));
+        if( CV_MAT_DEPTH(type) <= CV_8S )
+            a.row(rng.uniform(0, a.rows)).setTo(Scalar::all(0));
+
+        vector<double> r0, r;
+        setNumThreads(1);
+        compute(a, b, r0);
+
+        // the reference values that do not depend on the order of summation
+        Mat a64, b64;
+        a.convertTo(a64, CV_64F);
+        b.convertTo(b64, CV_64F);
+        double s = 0, l1 = 0;
+        for( int i = 0; i < a64.rows; i++ )
+            for( int j = 0; j < a64.cols*a64.channels(); j++ )
+            {
+                double v = a64.ptr<double>(i)[j];
+                s += v;
+                l1 += fabs(v - b64.ptr<double>(i)[j]);
+            }
+        double s0 = r0[0] + r0[3] + r0[6] + r0[9];
+        if( fabs(s - s0) > 1e-6*l1 + 1e-6 || fabs(l1 - r0[16]) > 1e-6*l1 + 1e-6 )
+        {
+            ts->printf(cvtest::TS::LOG, "sum=%g (expected %g), L1 diff norm=%g (expected %g), type=%d, size=%dx%d\n",
+                       s0, s, r0[16], l1, type, sz.width, sz.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            break;
+        }
+
+        for( int nthreads = 2; nthreads <= 5; nthreads += 3 )
+        {
+            setNumThreads(nthreads);
+            compute(a, b, r);
+            for( size_t k = 0; k < r.size(); k++ )
+                if( r[k] != r0[k] )
+                {
+                    ts->printf(cvtest::TS::LOG, "result #%d is %.17g with %d threads and %.17g with 1 thread, type=%d, size=%dx%d\n",
+                               (int)k, r[k], nthreads, r0[k], type, sz.width, sz.height);
+                    ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                    setNumThreads(nthreads0);
+                    return;
+                }
+        }
+    }
+
+    setNumThreads(nthreads0);
+}
+
+TEST(Core_Parallel, reduce) { Core_ParallelReduceTest test; test.safe_run(); }
+
+// the element-wise operations of core (convertTo, split, merge, mixChannels, LUT) process large
+// arrays in stripes concurrently; the results must not depend on the number of threads
+class Core_ParallelConvertTest : public cvtest::BaseTest
+{
+public:
+    Core_ParallelConvertTest() {}
+protected:
+    void run(int);
+    void compute(const Mat& src, vector<Mat>& r);
+};
+
+void Core_ParallelConvertTest::compute(const Mat& src, vector<Mat>& r)
+{
+    int cn = src.channels();
+    Mat t, lut(1, 256, CV_MAKETYPE(CV_32F, cn));
+    r.clear();
+    src.convertTo(t, CV_32F, 0.37, -5);
+    r.push_back(t.clone());
+    t.convertTo(t, src.depth(), 1.9, 3);
+    r.push_back(t.clone());
+    convertScaleAbs(src, t, -0.5, 7);
+    r.push_back(t.clone());
+
+    vector<Mat> planes;
+    split(src, planes);
+    for( int c = 0; c < cn; c++ )
+        r.push_back(planes[c].clone());
+    merge(planes, t);
+    r.push_back(t.clone());
+
+    // the reversed order of channels, the first channel is set to 0
+    vector<int> fromTo;
+    for( int c = 0; c < cn; c++ )
+    {
+        fromTo.push_back(c == 0 ? -1 : c);
+        fromTo.push_back(cn - 1 - c);
+    }
+    t.create(src.size(), src.type());
+    mixChannels(&src, 1, &t, 1, &fromTo[0], cn);
+    r.push_back(t.clone());
+
+    if( src.depth() == CV_8U )
+    {
+        for( int i = 0; i < 256*cn; i++ )
+            lut.ptr<float>()[i] = (float)(i*7 % 1001);
+        LUT(src, lut, t);
+        r.push_back(t.clone());
+    }
+}
+
+void Core_ParallelConvertTest::run(int)
+{
+    int nthreads0 = getNumThreads();
+    RNG& rng = ts->get_rng();
+    int types[] = { CV_8UC1, CV_8UC3, CV_8UC4, CV_16UC2, CV_16SC3, CV_32FC1, CV_8UC(5), CV_64FC3 };
+
+    for( int iter = 0; iter < 16; iter++ )
+    {
+        int type = types[iter % (int)(sizeof(types)/sizeof(types[0]))];
+        Size sz(rng.uniform(1, 1000), rng.uniform(1, 500));
+        if( iter % 4 == 0 )
+            sz = Size(rng.uniform(100000, 300000), 1);
+        Mat src0(sz.height + 1, sz.width + 5, type);
+        cvtest::randUni(rng, src0, Scalar::all(-300), Scalar::all(300));
+        Mat src = iter % 2 ? src0(Rect(2, 1, sz.width, sz.height)) : src0;
+
+        vector<Mat> r0, r;
+        setNumThreads(1);
+        compute(src, r0);
+
+        // merge(split(src)) must restore src
+        if( cvtest::norm(r0[3 + src.channels()], src, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "merge(split(src)) != src, type=%d, size=%dx%d\n",
+                       type, sz.width, sz.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            break;
+        }
+
+        setNumThreads(3);
+        compute(src, r);
+        for( size_t k = 0; k < r.size(); k++ )
+            if( cvtest::norm(r[k], r0[k], NORM_INF) != 0 )
+            {
+                ts->printf(cvtest::TS::LOG, "result #%d differs with 3 threads, type=%d, size=%dx%d\n",
+                           (int)k, type, sz.width, sz.height);
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                setNumThreads(nthreads0);
+                return;
+            }
+    }
+
+    setNumThreads(nthreads0);
+
+    // the output vector is 1 x N while the input column is N x 1
+    Mat col(300000, 1, CV_32SC2);
+    rng.fill(col, RNG::UNIFORM, -1000, 1000);
+    vector<Point2f> v;
+    col.convertTo(v, CV_32F, 0.5);
+    if( v.size() != (size_t)col.rows || v[col.rows-1].x != col.at<Point>(col.rows-1).x*0.5f )
+    {
+        ts->printf(cvtest::TS::LOG, "convertTo to a vector failed\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+    }
+}
+
+TEST(Core_Parallel, convert) { Core_ParallelConvertTest test; test.safe_run(); }
@@ -0,0 +1,41 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef PerfTestWithParam<string> Image;
+
+PERF_TEST_P(Image, FAST, testing::Values(string("shared/lena.jpg"), string("shared/fruits.jpg")))
+{
+    Mat img = imread(getDataPath(GetParam()), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load " << GetParam();
+    vector<KeyPoint> keypoints;
+    declareBytes(img);
+
+    TEST_CYCLE() FAST(img, keypoints, 20, true);
+}
+
+PERF_TEST_P(Image, SURF_detect, testing::Values(string("shared/lena.jpg"), string("shared/fruits.jpg")))
+{
+    Mat img = imread(getDataPath(GetParam()), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load " << GetParam();
+    SurfFeatureDetector detector(400);
+    vector<KeyPoint> keypoints;
+
+    TEST_CYCLE() detector.detect(img, keypoints);
+}
+
+PERF_TEST_P(Image, SURF_extract, testing::Values(string("shared/lena.jpg"), string("shared/fruits.jpg")))
+{
+    Mat img = imread(getDataPath(GetParam()), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load " << GetParam();
+    SurfFeatureDetector detector(400);
+    SurfDescriptorExtractor extractor;
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    detector.detect(img, keypoints);
+
+    TEST_CYCLE() extractor.compute(img, keypoints, descriptors);
+}
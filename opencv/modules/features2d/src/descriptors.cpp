@@ -57,6 +57,8 @@ DescriptorExtractor::~DescriptorExtractor()
 
 void DescriptorExtractor::compute( const Mat& image, vector<KeyPoint>& keypoints, Mat& descriptors ) const
 {    
+    CV_TRACE_REGION("cv::DescriptorExtractor::compute");
+    CV_TRACE_BYTES(image.total()*image.elemSize());
     if( image.empty() || keypoints.empty() )
     {
         descriptors.release();
@@ -54,6 +54,8 @@ FeatureDetector::~FeatureDetector()
 
 void FeatureDetector::detect( const Mat& image, vector<KeyPoint>& keypoints, const Mat& mask ) const
 {
+    CV_TRACE_REGION("cv::FeatureDetector::detect");
+    CV_TRACE_BYTES(image.total()*image.elemSize());
     keypoints.clear();
 
     if( image.empty() )
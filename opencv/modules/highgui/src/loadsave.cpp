@@ -258,6 +258,7 @@ imread_( const string& filename, int flags, int hdrtype, Mat* mat=0 )
 
 Mat imread( const string& filename, int flags )
 {
+    CV_TRACE_REGION("cv::imread");
     Mat img;
     imread_( filename, flags, LOAD_MAT, &img );
     return img;
@@ -298,7 +299,9 @@ static bool imwrite_( const string& filename, const Mat& image,
 bool imwrite( const string& filename, InputArray _img,
               const vector<int>& params )
 {
+    CV_TRACE_REGION("cv::imwrite");
     Mat img = _img.getMat();
+    CV_TRACE_BYTES(img.total()*img.elemSize());
     return imwrite_(filename, img, params, false);
 }
 
@@ -391,7 +394,9 @@ imdecode_( const Mat& buf, int flags, int hdrtype, Mat* mat=0 )
 
 Mat imdecode( InputArray _buf, int flags )
 {
+    CV_TRACE_REGION("cv::imdecode");
     Mat buf = _buf.getMat(), img;
+    CV_TRACE_BYTES(buf.total()*buf.elemSize());
     imdecode_( buf, flags, LOAD_MAT, &img );
     return img;
 }
@@ -399,7 +404,9 @@ Mat imdecode( InputArray _buf, int flags )
 bool imencode( const string& ext, InputArray _image,
                vector<uchar>& buf, const vector<int>& params )
 {
+    CV_TRACE_REGION("cv::imencode");
     Mat temp, image = _image.getMat();
+    CV_TRACE_BYTES(image.total()*image.elemSize());
     const Mat* pimage = &image;
 
     int channels = image.channels();
@@ -116,6 +116,8 @@ public:
                             int dstcount, int width) = 0;
     //! resets the internal buffers, if any
     virtual void reset();
+    //! returns a copy of the filter that can be used concurrently with this one, or an empty pointer if the filter can not be copied
+    virtual Ptr<BaseColumnFilter> clone() const;
     int ksize, anchor;
 };
 
@@ -142,6 +144,8 @@ public:
                             int dstcount, int width, int cn) = 0;
     //! resets the internal buffers, if any
     virtual void reset();
+    //! returns a copy of the filter that can be used concurrently with this one, or an empty pointer if the filter can not be copied
+    virtual Ptr<BaseFilter> clone() const;
     Size ksize;
     Point anchor;
 };
@@ -282,6 +286,20 @@ public:
     Ptr<BaseColumnFilter> columnFilter;
 };
 
+/*!
+  Sets the number of horizontal stripes that FilterEngine::apply splits the image into.
+
+  The stripes are processed in parallel, each by a copy of the engine that also reads the rows
+  of the neighbour stripes needed by the kernel, so the result is the same as with the serial processing.
+  nstripes=1 makes FilterEngine::apply serial; nstripes<=0 (the default) chooses the number of stripes
+  from the image size and the number of threads. The filters that can not be copied (see BaseColumnFilter::clone()),
+  the in-place operations and the box filters with floating-point sums are always processed serially.
+*/
+CV_EXPORTS void setNumFilterStripes(int nstripes);
+
+//! returns the number of stripes set by cv::setNumFilterStripes()
+CV_EXPORTS int getNumFilterStripes();
+
 //! type of the kernel
 enum { KERNEL_GENERAL=0, KERNEL_SYMMETRICAL=1, KERNEL_ASYMMETRICAL=2,
        KERNEL_SMOOTH=4, KERNEL_INTEGER=8 };
@@ -389,10 +407,14 @@ CV_EXPORTS_W void GaussianBlur( InputArray src,
                                                OutputArray dst, Size ksize,
                                                double sigma1, double sigma2=0,
                                                int borderType=BORDER_DEFAULT );
+//! type of the bilateral filter algorithm
+enum { BILATERAL_EXACT=0, BILATERAL_GRID=1 };
+
 //! smooths the image using bilateral filter
 CV_EXPORTS_W void bilateralFilter( InputArray src, OutputArray dst, int d,
                                    double sigmaColor, double sigmaSpace,
-                                   int borderType=BORDER_DEFAULT );
+                                   int borderType=BORDER_DEFAULT,
+                                   int flags=BILATERAL_EXACT, double quality=1 );
 //! smooths the image using the box filter. Each pixel is processed in O(1) time
 CV_EXPORTS_W void boxFilter( InputArray src, OutputArray dst, int ddepth,
                              Size ksize, Point anchor=Point(-1,-1),
@@ -517,6 +539,11 @@ CV_EXPORTS_W void resize( InputArray src, OutputArray dst,
                           Size dsize, double fx=0, double fy=0,
                           int interpolation=INTER_LINEAR );
 
+//! converts the color space, resizes and scales the image into 32-bit floating-point (interleaved or planar) tensor in one pass
+CV_EXPORTS_W void preprocessImage( InputArray src, OutputArray dst, Size dsize,
+                                   int code=-1, int interpolation=INTER_LINEAR,
+                                   double alpha=1, double beta=0, bool planar=false );
+
 //! warps the image using affine transformation
 CV_EXPORTS_W void warpAffine( InputArray src, OutputArray dst,
                               InputArray M, Size dsize,
@@ -548,7 +575,57 @@ CV_EXPORTS_W void remap( InputArray src, OutputArray dst,
 CV_EXPORTS_W void convertMaps( InputArray map1, InputArray map2,
                                OutputArray dstmap1, OutputArray dstmap2,
                                int dstmap1type, bool nninterpolation=false );
-                             
+
+/*!
+ The geometrical transformation compiled into the fixed-point maps
+
+ The maps are computed once, in the format of convertMaps(..., CV_16SC2, ...):
+ the integer source coordinates of each destination pixel and the index of its
+ interpolation weights, i.e. the fractional parts of the coordinates packed
+ into INTER_BITS*2 bits. Applying the warp to an image then costs only the
+ interpolation, which is done in parallel for the horizontal bands of the result.
+ This is useful when many frames are warped the same way:
+
+ \code
+ WarpPlan undistort;
+ initUndistortRectifyMap(K, distCoeffs, Mat(), K, frameSize, CV_32FC1, mapx, mapy);
+ undistort.createMaps(mapx, mapy, INTER_LINEAR);
+ for(;;)
+ {
+    cap >> frame;
+    undistort(frame, result);
+    ...
+ }
+ \endcode
+
+ The result is the same as of warpAffine(), warpPerspective() or remap() with the same parameters.
+*/
+class CV_EXPORTS WarpPlan
+{
+public:
+    //! the default constructor
+    WarpPlan();
+    //! the constructor that calls create()
+    WarpPlan(InputArray M, Size dsize, int flags=INTER_LINEAR);
+
+    //! compiles warpAffine() with 2x3 matrix M or warpPerspective() with 3x3 matrix M
+    void create(InputArray M, Size dsize, int flags=INTER_LINEAR);
+    //! compiles remap() with the maps in any of the formats it accepts
+    void createMaps(InputArray map1, InputArray map2, int interpolation);
+    //! returns true if the warp has not been compiled
+    bool empty() const;
+    //! returns the size of the destination image
+    Size size() const;
+
+    //! warps the image; dst can not be the same as src
+    void operator()(InputArray src, OutputArray dst, int borderMode=BORDER_CONSTANT,
+                    const Scalar& borderValue=Scalar()) const;
+
+    Mat xy; //!< the integer source coordinates, CV_16SC2
+    Mat fxy; //!< the indices of the interpolation weights, CV_16UC1; may be empty for INTER_NEAREST
+    int interpolation; //!< the interpolation method
+};
+
 //! returns 2x3 affine transformation matrix for the planar rotation.
 CV_EXPORTS_W Mat getRotationMatrix2D( Point2f center, double angle, double scale );
 //! returns 3x3 perspective transformation for the corresponding 4 point pairs.
@@ -228,8 +228,45 @@ enum
 
     CV_YUV420i2RGB  = 90,
     CV_YUV420i2BGR  = 91,
-    
-    CV_COLORCVT_MAX  =100
+
+    // YUV 4:2:0 family to RGB: the semi-planar NV21 (V,U interleaved, same as YUV420i) and NV12 (U,V),
+    // the planar YV12 (the V plane goes first) and I420 (IYUV, the U plane goes first)
+    CV_YUV2RGB_NV21  = CV_YUV420i2RGB,
+    CV_YUV2BGR_NV21  = CV_YUV420i2BGR,
+    CV_YUV2RGB_NV12  = 92,
+    CV_YUV2BGR_NV12  = 93,
+
+    CV_YUV2RGBA_NV12 = 94,
+    CV_YUV2BGRA_NV12 = 95,
+    CV_YUV2RGBA_NV21 = 96,
+    CV_YUV2BGRA_NV21 = 97,
+
+    CV_YUV2RGB_YV12  = 98,
+    CV_YUV2BGR_YV12  = 99,
+    CV_YUV2RGB_IYUV  = 100,
+    CV_YUV2BGR_IYUV  = 101,
+    CV_YUV2RGB_I420  = CV_YUV2RGB_IYUV,
+    CV_YUV2BGR_I420  = CV_YUV2BGR_IYUV,
+    CV_YUV420sp2RGB  = CV_YUV2RGB_NV21,
+    CV_YUV420sp2BGR  = CV_YUV2BGR_NV21,
+    CV_YUV420p2RGB   = CV_YUV2RGB_YV12,
+    CV_YUV420p2BGR   = CV_YUV2BGR_YV12,
+
+    CV_YUV2RGBA_YV12 = 102,
+    CV_YUV2BGRA_YV12 = 103,
+    CV_YUV2RGBA_IYUV = 104,
+    CV_YUV2BGRA_IYUV = 105,
+    CV_YUV2RGBA_I420 = CV_YUV2RGBA_IYUV,
+    CV_YUV2BGRA_I420 = CV_YUV2BGRA_IYUV,
+
+    CV_YUV2GRAY_420  = 106,
+    CV_YUV2GRAY_NV21 = CV_YUV2GRAY_420,
+    CV_YUV2GRAY_NV12 = CV_YUV2GRAY_420,
+    CV_YUV2GRAY_YV12 = CV_YUV2GRAY_420,
+    CV_YUV2GRAY_IYUV = CV_YUV2GRAY_420,
+    CV_YUV2GRAY_I420 = CV_YUV2GRAY_420,
+
+    CV_COLORCVT_MAX  = 107
 };
 
 
@@ -0,0 +1,50 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef std::tr1::tuple<Size, int> Size_CvtMode_t;
+typedef PerfTestWithParam<Size_CvtMode_t> CvtColor;
+
+PERF_TEST_P(CvtColor, 8u, testing::Combine(testing::Values(szVGA, sz1080p),
+                                           testing::Values((int)CV_BGR2GRAY, (int)CV_BGR2RGB, (int)CV_BGR2HSV,
+                                                           (int)CV_BGR2Lab, (int)CV_BGR2YCrCb, (int)CV_GRAY2BGR)))
+{
+    Size sz = get<0>(GetParam());
+    int code = get<1>(GetParam());
+    Mat src(sz, code == CV_GRAY2BGR ? CV_8UC1 : CV_8UC3), dst;
+    randu(src, 0, 256);
+    cvtColor(src, dst, code);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() cvtColor(src, dst, code);
+}
+
+PERF_TEST_P(CvtColor, yuv420, testing::Combine(testing::Values(szVGA, sz1080p),
+                                               testing::Values((int)CV_YUV420i2BGR, (int)CV_YUV420i2RGB, (int)CV_YUV2BGR_NV12,
+                                                               (int)CV_YUV2BGRA_NV12, (int)CV_YUV2BGR_I420)))
+{
+    Size sz = get<0>(GetParam());
+    int code = get<1>(GetParam());
+    Mat src(sz.height*3/2, sz.width, CV_8UC1), dst;
+    randu(src, 0, 256);
+    cvtColor(src, dst, code);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() cvtColor(src, dst, code);
+}
+
+PERF_TEST_P(CvtColor, bayer, testing::Combine(testing::Values(szVGA, sz1080p),
+                                              testing::Values((int)CV_BayerBG2BGR, (int)CV_BayerGR2BGR, (int)CV_BayerBG2BGR_VNG)))
+{
+    Size sz = get<0>(GetParam());
+    int code = get<1>(GetParam());
+    Mat src(sz, CV_8UC1), dst;
+    randu(src, 0, 256);
+    cvtColor(src, dst, code);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() cvtColor(src, dst, code);
+}
@@ -0,0 +1,147 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+#define FILTER_SIZES testing::Values(szVGA, sz1080p)
+
+PERF_TEST_P(Size_MatType, GaussianBlur_5x5, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_8UC3, CV_32FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() GaussianBlur(src, dst, Size(5, 5), 0);
+}
+
+typedef std::tr1::tuple<Size, int> Size_Stripes_t;
+typedef PerfTestWithParam<Size_Stripes_t> Size_Stripes;
+
+// 1 - serial FilterEngine::apply, 0 - the automatic number of stripes
+PERF_TEST_P(Size_Stripes, GaussianBlur_7x7_stripes, testing::Combine(testing::Values(sz1080p, Size(3840, 2160)), testing::Values(1, 0)))
+{
+    Size sz = get<0>(GetParam());
+    int nstripes = get<1>(GetParam()), nstripes0 = getNumFilterStripes();
+    Mat src(sz, CV_8UC3), dst(sz, CV_8UC3);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    setNumFilterStripes(nstripes);
+    TEST_CYCLE() GaussianBlur(src, dst, Size(7, 7), 0);
+    setNumFilterStripes(nstripes0);
+}
+
+PERF_TEST_P(Size_MatType, Sobel_3x3, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_32FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, CV_MAKETYPE(CV_32F, CV_MAT_CN(type)));
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() Sobel(src, dst, CV_32F, 1, 0);
+}
+
+PERF_TEST_P(Size_MatType, blur_7x7, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_8UC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() blur(src, dst, Size(7, 7));
+}
+
+PERF_TEST_P(Size_MatType, erode_3x3, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_8UC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() erode(src, dst, Mat());
+}
+
+PERF_TEST_P(Size_MatType, filter2D_5x5, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_32FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type), kernel(5, 5, CV_32F);
+    randu(src, 0, 256);
+    randu(kernel, -1, 1);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() filter2D(src, dst, -1, kernel);
+}
+
+PERF_TEST_P(Size_MatType, medianBlur_5, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1, CV_8UC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() medianBlur(src, dst, 5);
+}
+
+typedef std::tr1::tuple<Size, int, int> Size_MatType_KSize_t;
+typedef PerfTestWithParam<Size_MatType_KSize_t> Size_MatType_KSize;
+
+PERF_TEST_P(Size_MatType_KSize, medianBlur_large, testing::Combine(testing::Values(szVGA, sz1080p),
+                                                                   testing::Values(CV_8UC1, CV_16UC1),
+                                                                   testing::Values(7, 15)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), ksize = get<2>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 4096);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() medianBlur(src, dst, ksize);
+}
+
+PERF_TEST_P(Size_MatType, medianBlur_7, testing::Combine(testing::Values(szVGA, sz1080p), testing::Values(CV_16SC1, CV_32FC1)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, -1000, 1000);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() medianBlur(src, dst, 7);
+}
+
+typedef std::tr1::tuple<Size, int, int> Size_MatType_Flags_t;
+typedef PerfTestWithParam<Size_MatType_Flags_t> Size_MatType_Flags;
+
+PERF_TEST_P(Size_MatType_Flags, bilateralFilter, testing::Combine(testing::Values(sz720p, sz1080p),
+                                                                testing::Values(CV_8UC1, CV_8UC3),
+                                                                testing::Values((int)BILATERAL_EXACT, (int)BILATERAL_GRID)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), mode = get<2>(GetParam());
+    Mat src(sz, type), dst(sz, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() bilateralFilter(src, dst, 9, 30, 3, BORDER_DEFAULT, mode);
+}
+
+PERF_TEST_P(Size_MatType, Canny, testing::Combine(FILTER_SIZES, testing::Values(CV_8UC1)))
+{
+    Size sz = get<0>(GetParam());
+    Mat img = imread(getDataPath("shared/lena.jpg"), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load shared/lena.jpg";
+    Mat src, dst;
+    resize(img, src, sz);
+    declareBytes(src, src);
+
+    TEST_CYCLE() Canny(src, dst, 50, 150);
+}
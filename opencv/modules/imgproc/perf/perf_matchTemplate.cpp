@@ -0,0 +1,22 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef std::tr1::tuple<Size, Size, int> ImageSize_TemplSize_Method_t;
+typedef PerfTestWithParam<ImageSize_TemplSize_Method_t> MatchTemplate;
+
+PERF_TEST_P(MatchTemplate, 8u, testing::Combine(testing::Values(szVGA),
+                                                testing::Values(Size(16, 16), Size(64, 64)),
+                                                testing::Values((int)CV_TM_SQDIFF, (int)CV_TM_CCORR_NORMED, (int)CV_TM_CCOEFF_NORMED)))
+{
+    Size imgSz = get<0>(GetParam()), templSz = get<1>(GetParam());
+    int method = get<2>(GetParam());
+    Mat img(imgSz, CV_8UC1), templ(templSz, CV_8UC1), result;
+    randu(img, 0, 256);
+    randu(templ, 0, 256);
+
+    TEST_CYCLE() matchTemplate(img, templ, result, method);
+}
@@ -0,0 +1,76 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+using std::tr1::make_tuple;
+
+typedef std::tr1::tuple<Size, int, int> Size_MatType_Interp_t;
+typedef PerfTestWithParam<Size_MatType_Interp_t> Resize;
+
+PERF_TEST_P(Resize, downscale_2x, testing::Combine(testing::Values(sz720p, sz1080p),
+                                                   testing::Values(CV_8UC1, CV_8UC3, CV_32FC1),
+                                                   testing::Values((int)INTER_NEAREST, (int)INTER_LINEAR, (int)INTER_AREA)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), interp = get<2>(GetParam());
+    Mat src(sz, type), dst(sz.height/2, sz.width/2, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() resize(src, dst, dst.size(), 0, 0, interp);
+}
+
+PERF_TEST_P(Resize, downscale_odd, testing::Combine(testing::Values(sz1080p),
+                                                    testing::Values(CV_8UC1, CV_8UC3),
+                                                    testing::Values((int)INTER_LINEAR, (int)INTER_CUBIC, (int)INTER_AREA)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), interp = get<2>(GetParam());
+    Mat src(sz, type), dst(300, 300, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() resize(src, dst, dst.size(), 0, 0, interp);
+}
+
+PERF_TEST_P(Resize, upscale, testing::Combine(testing::Values(szQVGA, szVGA),
+                                              testing::Values(CV_8UC1, CV_8UC3),
+                                              testing::Values((int)INTER_NEAREST, (int)INTER_LINEAR, (int)INTER_CUBIC)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), interp = get<2>(GetParam());
+    Mat src(sz, type), dst(sz.height*2, sz.width*2, type);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() resize(src, dst, dst.size(), 0, 0, interp);
+}
+
+typedef std::tr1::tuple<Size, int> Size_Interp_t;
+typedef PerfTestWithParam<Size_Interp_t> PreprocessImage;
+
+PERF_TEST_P(PreprocessImage, bgr2rgb_planar, testing::Combine(testing::Values(sz720p, sz1080p),
+                                                            testing::Values((int)INTER_NEAREST, (int)INTER_LINEAR)))
+{
+    Size sz = get<0>(GetParam());
+    int interp = get<1>(GetParam());
+    Mat src(sz, CV_8UC3), dst(224*3, 224, CV_32F);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() preprocessImage(src, dst, Size(224, 224), CV_BGR2RGB, interp, 1./255, 0, true);
+}
+
+PERF_TEST_P(PreprocessImage, bgr2gray, testing::Combine(testing::Values(sz720p, sz1080p),
+                                                      testing::Values((int)INTER_LINEAR)))
+{
+    Size sz = get<0>(GetParam());
+    int interp = get<1>(GetParam());
+    Mat src(sz, CV_8UC3), dst(sz.height/2, sz.width/2, CV_32F);
+    randu(src, 0, 256);
+    declareBytes(src, dst);
+
+    TEST_CYCLE() preprocessImage(src, dst, dst.size(), CV_BGR2GRAY, interp, 1./255, -0.5);
+}
@@ -54,37 +54,29 @@ typedef struct _CvPtInfo
 _CvPtInfo;
 
 
-/* curvature: 0 - 1-curvature, 1 - k-cosine curvature. */
-CvSeq* icvApproximateChainTC89( CvChain* chain, int header_size,
-                                CvMemStorage* storage, int method )
+static const CvPoint icvCodeDeltas[8] =
+    { {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+/* Approximates the closed curve given by the chain codes, starting at origin.
+   curvature: 0 - 1-curvature, 1 - k-cosine curvature.
+   dst should have space for max(count,1) points; the number of written points is returned */
+int cv::approxChainTC89( const schar* codes, int count, Point origin, int method, Point* dst )
 {
     static const int abs_diff[] = { 1, 2, 3, 4, 3, 2, 1, 0, 1, 2, 3, 4, 3, 2, 1 };
 
-    cv::AutoBuffer<_CvPtInfo> buf(chain->total + 8);
+    cv::AutoBuffer<_CvPtInfo> buf(count + 8);
 
     _CvPtInfo       temp;
     _CvPtInfo       *array = buf, *first = 0, *current = 0, *prev_current = 0;
-    int             i, j, i1, i2, s, len;
-    int             count = chain->total;
+    int             i, j, i1, i2, s, len, ndst = 0;
+    CvPoint         pt = origin;
 
-    CvChainPtReader reader;
-    CvSeqWriter     writer;
-    CvPoint         pt = chain->origin;
-    
-    CV_Assert( CV_IS_SEQ_CHAIN_CONTOUR( chain ));
-    CV_Assert( header_size >= (int)sizeof(CvContour) );
-    
-    cvStartWriteSeq( (chain->flags & ~CV_SEQ_ELTYPE_MASK) | CV_SEQ_ELTYPE_POINT,
-                     header_size, sizeof( CvPoint ), storage, &writer );
-    
-    if( chain->total == 0 )
-    {        
-        CV_WRITE_SEQ_ELEM( pt, writer );
-        return cvEndWriteSeq( &writer );
+    if( count == 0 )
+    {
+        dst[0] = pt;
+        return 1;
     }
 
-    cvStartReadChainPoints( chain, &reader );
-
     temp.next = 0;
     current = &temp;
 
@@ -94,20 +86,16 @@ CvSeq* icvApproximateChainTC89( CvChain* chain, int header_size,
        that have zero 1-curvature */
     for( i = 0; i < count; i++ )
     {
-        int prev_code = *reader.prev_elem;
-
-        reader.prev_elem = reader.ptr;
-        CV_READ_CHAIN_POINT( pt, reader );
+        int code = codes[i];
+        int prev_code = codes[i > 0 ? i - 1 : count - 1];
 
         /* calc 1-curvature */
-        s = abs_diff[reader.code - prev_code + 7];
+        s = abs_diff[code - prev_code + 7];
 
         if( method <= CV_CHAIN_APPROX_SIMPLE )
         {
             if( method == CV_CHAIN_APPROX_NONE || s != 0 )
-            {
-                CV_WRITE_SEQ_ELEM( pt, writer );
-            }
+                dst[ndst++] = pt;
         }
         else
         {
@@ -116,12 +104,13 @@ CvSeq* icvApproximateChainTC89( CvChain* chain, int header_size,
             array[i].s = s;
             array[i].pt = pt;
         }
-    }
 
-    //assert( pt.x == chain->origin.x && pt.y == chain->origin.y );
+        pt.x += icvCodeDeltas[code].x;
+        pt.y += icvCodeDeltas[code].y;
+    }
 
     if( method <= CV_CHAIN_APPROX_SIMPLE )
-        return cvEndWriteSeq( &writer );
+        return ndst;
 
     current->next = 0;
 
@@ -365,12 +354,33 @@ copy_vect:
 
     do
     {
-        CV_WRITE_SEQ_ELEM( current->pt, writer );
+        dst[ndst++] = current->pt;
         current = current->next;
     }
     while( current != 0 );
 
-    return cvEndWriteSeq( &writer );
+    return ndst;
+}
+
+
+CvSeq* icvApproximateChainTC89( CvChain* chain, int header_size,
+                                CvMemStorage* storage, int method )
+{
+    CV_Assert( CV_IS_SEQ_CHAIN_CONTOUR( chain ));
+    CV_Assert( header_size >= (int)sizeof(CvContour) );
+
+    int count = chain->total;
+    cv::AutoBuffer<schar> codes(count + 1);
+    cv::AutoBuffer<cv::Point> pts(count + 1);
+
+    if( count > 0 )
+        cvCvtSeqToArray( (CvSeq*)chain, codes );
+    int npts = cv::approxChainTC89( codes, count, chain->origin, method, pts );
+
+    CvSeq* contour = cvCreateSeq( (chain->flags & ~CV_SEQ_ELTYPE_MASK) | CV_SEQ_ELTYPE_POINT,
+                                  header_size, sizeof( CvPoint ), storage );
+    cvSeqPushMulti( contour, (cv::Point*)pts, npts );
+    return contour;
 }
 
 
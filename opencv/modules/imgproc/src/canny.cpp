@@ -339,7 +339,9 @@ void cv::Canny( InputArray image, OutputArray _edges,
                 double threshold1, double threshold2,
                 int apertureSize, bool L2gradient )
 {
+    CV_TRACE_REGION("cv::Canny");
     Mat src = image.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     _edges.create(src.size(), CV_8U);
     CvMat c_src = src, c_dst = _edges.getMat();
     cvCanny( &c_src, &c_dst, threshold1, threshold2,
@@ -155,6 +155,56 @@ template<> struct ColorChannel<float>
     
 ///////////////////////////// Top-level template function ////////////////////////////////
 
+/*
+   The pixel-wise conversions are run in stripes of about CVT_COLOR_STRIPE_SIZE pixels.
+   A stripe is a group of the whole rows or, for the very wide (or continuous, treated as a single row)
+   images, a part of one row. The small images are converted right away.
+*/
+enum { CVT_COLOR_STRIPE_SIZE = 1 << 16 };
+
+template<class Cvt> class CvtColorLoop_Invoker
+{
+    typedef typename Cvt::channel_type _Tp;
+public:
+    CvtColorLoop_Invoker(const Mat& _src, Mat& _dst, const Cvt& _cvt, Size _sz,
+                         int _stripesPerRow, int _rowsPerStripe)
+        : src(&_src), dst(&_dst), cvt(&_cvt), sz(_sz),
+          stripesPerRow(_stripesPerRow), rowsPerStripe(_rowsPerStripe) {}
+
+    void operator()(const BlockedRange& range) const
+    {
+        size_t sesz = src->elemSize(), desz = dst->elemSize();
+        for( int s = range.begin(); s < range.end(); s++ )
+        {
+            int y0, y1, x0 = 0, x1 = sz.width;
+            if( stripesPerRow > 1 )
+            {
+                y0 = s / stripesPerRow;
+                y1 = y0 + 1;
+                x0 = (s % stripesPerRow)*CVT_COLOR_STRIPE_SIZE;
+                x1 = std::min(x0 + (int)CVT_COLOR_STRIPE_SIZE, sz.width);
+            }
+            else
+            {
+                y0 = s*rowsPerStripe;
+                y1 = std::min(y0 + rowsPerStripe, sz.height);
+            }
+
+            const uchar* sptr = src->data + src->step*y0 + sesz*x0;
+            uchar* dptr = dst->data + dst->step*y0 + desz*x0;
+            for( ; y0 < y1; y0++, sptr += src->step, dptr += dst->step )
+                (*cvt)((const _Tp*)sptr, (_Tp*)dptr, x1 - x0);
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    const Cvt* cvt;
+    Size sz;
+    int stripesPerRow, rowsPerStripe;
+};
+
 template<class Cvt> void CvtColorLoop(const Mat& srcmat, Mat& dstmat, const Cvt& cvt)
 {
     typedef typename Cvt::channel_type _Tp;
@@ -167,7 +217,17 @@ template<class Cvt> void CvtColorLoop(const Mat& srcmat, Mat& dstmat, const Cvt&
     {
         sz.width *= sz.height;
         sz.height = 1;
-    }    
+    }
+
+    if( (size_t)sz.width*sz.height >= (size_t)CVT_COLOR_STRIPE_SIZE*2 && getNumThreads() > 1 )
+    {
+        int stripesPerRow = (sz.width + CVT_COLOR_STRIPE_SIZE - 1)/CVT_COLOR_STRIPE_SIZE;
+        int rowsPerStripe = stripesPerRow > 1 ? 1 : CVT_COLOR_STRIPE_SIZE/sz.width;
+        int nstripes = stripesPerRow > 1 ? sz.height*stripesPerRow : (sz.height + rowsPerStripe - 1)/rowsPerStripe;
+        parallel_for(BlockedRange(0, nstripes),
+                     CvtColorLoop_Invoker<Cvt>(srcmat, dstmat, cvt, sz, stripesPerRow, rowsPerStripe));
+        return;
+    }
     
     for( ; sz.height--; src += srcstep, dst += dststep )
         cvt((const _Tp*)src, (_Tp*)dst, sz.width);
@@ -176,6 +236,18 @@ template<class Cvt> void CvtColorLoop(const Mat& srcmat, Mat& dstmat, const Cvt&
     
 ////////////////// Various 3/4-channel to 3/4-channel RGB transformations /////////////////
     
+// processes the beginning of the row with the best available SIMD code, returns the number of pixels done
+template<typename _Tp> static inline int RGB2RGB_opt(const _Tp*, _Tp*, int, int, int, int) { return 0; }
+
+static inline int RGB2RGB_opt(const uchar* src, uchar* dst, int n, int scn, int dcn, int bidx)
+{
+#ifdef HAVE_DISPATCH_SSSE3
+    if( checkHardwareSupport(CV_CPU_SSSE3) )
+        return opt_SSSE3::cvtBGR2BGR8u(src, dst, n, scn, dcn, bidx);
+#endif
+    return 0;
+}
+
 template<typename _Tp> struct RGB2RGB
 {
     typedef _Tp channel_type;
@@ -184,6 +256,8 @@ template<typename _Tp> struct RGB2RGB
     void operator()(const _Tp* src, _Tp* dst, int n) const
     {
         int scn = srccn, dcn = dstcn, bidx = blueIdx;
+        int n0 = RGB2RGB_opt(src, dst, n, scn, dcn, bidx);
+        src += n0*scn; dst += n0*dcn; n -= n0;
         if( dcn == 3 )
         {
             n *= 3;
@@ -781,6 +855,79 @@ template<typename _Tp> struct XYZ2RGB_i
 
 ////////////////////////////////////// RGB <-> HSV ///////////////////////////////////////
 
+enum { HSV_SHIFT = 12 };
+static int HSV_sdiv_table[256];
+static int HSV_hdiv_table180[256];
+static int HSV_hdiv_table256[256];
+
+static void initHSVTabs()
+{
+    static volatile bool initialized = false;
+    if( !initialized )
+    {
+        HSV_sdiv_table[0] = HSV_hdiv_table180[0] = HSV_hdiv_table256[0] = 0;
+        for( int i = 1; i < 256; i++ )
+        {
+            HSV_sdiv_table[i] = saturate_cast<int>((255 << HSV_SHIFT)/(1.*i));
+            HSV_hdiv_table180[i] = saturate_cast<int>((180 << HSV_SHIFT)/(6.*i));
+            HSV_hdiv_table256[i] = saturate_cast<int>((256 << HSV_SHIFT)/(6.*i));
+        }
+        initialized = true;
+    }
+}
+
+#if CV_SSE2
+
+/*
+   h, s and v of 8 pixels (the 16-bit b, g and r on input, the 16-bit h, s and v on output).
+   The products by the division tables are computed in floating-point: the table value
+   is recomputed as cvRound(scale/x), divided by 2^HSV_SHIFT and the product is rounded
+   with floor(p + 0.5). It has been checked for all the possible arguments that this gives
+   exactly the same results as the integer code.
+*/
+static inline void RGB2HSV_8u_SSE2( __m128i b, __m128i g, __m128i r, __m128 hscale,
+                                    __m128i hr, __m128i& h, __m128i& s, __m128i& v )
+{
+    const __m128i z = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+    const __m128 sscale = _mm_set1_ps((float)(255 << HSV_SHIFT));
+    const __m128 ishift = _mm_set1_ps(1.f/(1 << HSV_SHIFT)), half = _mm_set1_ps(0.5f);
+    const __m128 hofs = _mm_set1_ps(512.5f), six = _mm_set1_ps(6.f);
+
+    v = _mm_max_epi16(_mm_max_epi16(b, g), r);
+    __m128i vmin = _mm_min_epi16(_mm_min_epi16(b, g), r);
+    __m128i diff = _mm_sub_epi16(v, vmin);
+    __m128i vr = _mm_cmpeq_epi16(v, r), vg = _mm_cmpeq_epi16(v, g);
+    __m128i d2 = _mm_add_epi16(diff, diff);
+    __m128i hg = _mm_add_epi16(_mm_sub_epi16(b, r), d2);
+    __m128i hb = _mm_add_epi16(_mm_sub_epi16(r, g), _mm_add_epi16(d2, d2));
+    __m128i hn = _mm_or_si128(_mm_and_si128(vr, _mm_sub_epi16(g, b)),
+                              _mm_andnot_si128(vr, _mm_or_si128(_mm_and_si128(vg, hg),
+                                                                _mm_andnot_si128(vg, hb))));
+
+    // the zero v and diff only occur together with the zero numerators; avoid the division by 0
+    __m128i vd = _mm_max_epi16(v, one), dd = _mm_max_epi16(diff, one);
+    __m128i res[2][2];
+
+    for( int k = 0; k < 2; k++ )
+    {
+        __m128 fv = _mm_cvtepi32_ps(k == 0 ? _mm_unpacklo_epi16(vd, z) : _mm_unpackhi_epi16(vd, z));
+        __m128 fd = _mm_cvtepi32_ps(k == 0 ? _mm_unpacklo_epi16(dd, z) : _mm_unpackhi_epi16(dd, z));
+        __m128 fdiff = _mm_cvtepi32_ps(k == 0 ? _mm_unpacklo_epi16(diff, z) : _mm_unpackhi_epi16(diff, z));
+        __m128i ihn = k == 0 ? _mm_unpacklo_epi16(hn, hn) : _mm_unpackhi_epi16(hn, hn);
+        __m128 fhn = _mm_cvtepi32_ps(_mm_srai_epi32(ihn, 16));
+
+        __m128 ts = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_div_ps(sscale, fv))), ishift);
+        __m128 th = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_div_ps(hscale, _mm_mul_ps(fd, six)))), ishift);
+        res[0][k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fdiff, ts), half));
+        res[1][k] = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fhn, th), hofs)), _mm_set1_epi32(512));
+    }
+
+    s = _mm_packs_epi32(res[0][0], res[0][1]);
+    h = _mm_packs_epi32(res[1][0], res[1][1]);
+    h = _mm_add_epi16(h, _mm_and_si128(_mm_cmplt_epi16(h, z), hr));
+}
+
+#endif
 
 struct RGB2HSV_b
 {
@@ -790,35 +937,66 @@ struct RGB2HSV_b
     : srccn(_srccn), blueIdx(_blueIdx), hrange(_hrange)
     {
         CV_Assert( hrange == 180 || hrange == 256 );
+        initHSVTabs();
     }
     
     void operator()(const uchar* src, uchar* dst, int n) const
     {
-        int i, bidx = blueIdx, scn = srccn;
-        const int hsv_shift = 12;
-        
-        static int sdiv_table[256];
-        static int hdiv_table180[256];
-        static int hdiv_table256[256];
-        static volatile bool initialized = false;
-        
+        int i = 0, bidx = blueIdx, scn = srccn;
+        const int hsv_shift = HSV_SHIFT;
         int hr = hrange;
-        const int* hdiv_table = hr == 180 ? hdiv_table180 : hdiv_table256;
-        n *= 3;
-        
-        if( !initialized )
+        const int* sdiv_table = HSV_sdiv_table;
+        const int* hdiv_table = hr == 180 ? HSV_hdiv_table180 : HSV_hdiv_table256;
+
+#if CV_SSE2
+        if( checkHardwareSupport(CV_CPU_SSE2) )
         {
-            sdiv_table[0] = hdiv_table180[0] = hdiv_table256[0] = 0;
-            for( i = 1; i < 256; i++ )
+            // the pixels are processed in blocks, which are copied to the planar buffers and back
+            enum { BLOCK_SIZE = 64 };
+            uchar CV_DECL_ALIGNED(16) buf[BLOCK_SIZE*3];
+            __m128 hscale = _mm_set1_ps((float)(hr << hsv_shift));
+            __m128i hrv = _mm_set1_epi16((short)hr), z = _mm_setzero_si128();
+
+            for( ; i <= n - 16; )
             {
-                sdiv_table[i] = saturate_cast<int>((255 << hsv_shift)/(1.*i));
-                hdiv_table180[i] = saturate_cast<int>((180 << hsv_shift)/(6.*i));
-                hdiv_table256[i] = saturate_cast<int>((256 << hsv_shift)/(6.*i));
+                int j, bsz = std::min((int)BLOCK_SIZE, n - i) & -16;
+                const uchar* s = src + i*scn;
+                for( j = 0; j < bsz; j++, s += scn )
+                {
+                    buf[j] = s[bidx];
+                    buf[j + BLOCK_SIZE] = s[1];
+                    buf[j + BLOCK_SIZE*2] = s[bidx^2];
+                }
+
+                for( j = 0; j < bsz; j += 16 )
+                {
+                    __m128i b = _mm_load_si128((const __m128i*)(buf + j));
+                    __m128i g = _mm_load_si128((const __m128i*)(buf + j + BLOCK_SIZE));
+                    __m128i r = _mm_load_si128((const __m128i*)(buf + j + BLOCK_SIZE*2));
+                    __m128i h0, s0, v0, h1, s1, v1;
+                    RGB2HSV_8u_SSE2(_mm_unpacklo_epi8(b, z), _mm_unpacklo_epi8(g, z),
+                                    _mm_unpacklo_epi8(r, z), hscale, hrv, h0, s0, v0);
+                    RGB2HSV_8u_SSE2(_mm_unpackhi_epi8(b, z), _mm_unpackhi_epi8(g, z),
+                                    _mm_unpackhi_epi8(r, z), hscale, hrv, h1, s1, v1);
+                    _mm_store_si128((__m128i*)(buf + j), _mm_packus_epi16(h0, h1));
+                    _mm_store_si128((__m128i*)(buf + j + BLOCK_SIZE), _mm_packus_epi16(s0, s1));
+                    _mm_store_si128((__m128i*)(buf + j + BLOCK_SIZE*2), _mm_packus_epi16(v0, v1));
+                }
+
+                uchar* d = dst + i*3;
+                for( j = 0; j < bsz; j++, d += 3 )
+                {
+                    d[0] = buf[j];
+                    d[1] = buf[j + BLOCK_SIZE];
+                    d[2] = buf[j + BLOCK_SIZE*2];
+                }
+                i += bsz;
             }
-            initialized = true;
         }
-        
-        for( i = 0; i < n; i += 3, src += scn )
+#endif
+
+        src += i*scn;
+        for( i *= 3, n *= 3; i < n; i += 3, src += scn )
         {
             int b = src[bidx], g = src[1], r = src[bidx^2];
             int h, s, v = b;
@@ -1884,8 +2062,29 @@ public:
 typedef SIMDBayerStubInterpolator_<uchar> SIMDBayerInterpolator_8u;
 #endif
     
+/*
+   The demosaicing functions are run in parallel over the bands of the destination rows.
+   Each row depends only on the 3 source rows around it and on the parity of its index,
+   which determines the colors of the row pixels; the first and the last rows are replicated
+   from their neighbours after all the bands are done.
+*/
 template<typename T, class SIMDInterpolator>
-static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
+class Bayer2Gray_Invoker
+{
+public:
+    Bayer2Gray_Invoker( const Mat& _srcmat, Mat& _dstmat, int _code )
+        : srcmat(&_srcmat), dstmat(&_dstmat), code(_code) {}
+
+    void operator()( const BlockedRange& range ) const;
+
+private:
+    const Mat* srcmat;
+    Mat* dstmat;
+    int code;
+};
+
+template<typename T, class SIMDInterpolator>
+void Bayer2Gray_Invoker<T, SIMDInterpolator>::operator()( const BlockedRange& range ) const
 {
     SIMDInterpolator vecOp;
     const int R2Y = 4899;
@@ -1893,11 +2092,11 @@ static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
     const int B2Y = 1868;
     const int SHIFT = 14;
     
-    const T* bayer0 = (const T*)srcmat.data;
-    int bayer_step = (int)(srcmat.step/sizeof(T));
-    T* dst0 = (T*)dstmat.data;
-    int dst_step = (int)(dstmat.step/sizeof(T));
-    Size size = srcmat.size();
+    int bayer_step = (int)(srcmat->step/sizeof(T));
+    int dst_step = (int)(dstmat->step/sizeof(T));
+    const T* bayer0 = (const T*)srcmat->data + bayer_step*range.begin();
+    T* dst0 = (T*)dstmat->data + dst_step*range.begin();
+    Size size = srcmat->size();
     int bcoeff = B2Y, rcoeff = R2Y;
     int start_with_green = code == CV_BayerGB2GRAY || code == CV_BayerGR2GRAY;
     bool brow = true;
@@ -1907,9 +2106,16 @@ static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
         brow = false;
         std::swap(bcoeff, rcoeff);
     }
+
+    if( range.begin() % 2 != 0 )
+    {
+        brow = !brow;
+        std::swap(bcoeff, rcoeff);
+        start_with_green = !start_with_green;
+    }
     
     dst0 += dst_step + 1;
-    size.height -= 2;
+    size.height = range.end() - range.begin();
     size.width -= 2;
     
     for( ; size.height-- > 0; bayer0 += bayer_step, dst0 += dst_step )
@@ -1970,9 +2176,23 @@ static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
         std::swap(bcoeff, rcoeff);
         start_with_green = !start_with_green;
     }
-    
-    size = dstmat.size();
-    dst0 = (T*)dstmat.data;
+}
+
+// about 64K pixels per band
+static BlockedRange getBayerRange( Size size, int minRows )
+{
+    int rows = std::max(size.height - 2, 0);
+    return BlockedRange(0, rows, std::max((1 << 16)/std::max(size.width, 1), minRows));
+}
+
+template<typename T, class SIMDInterpolator>
+static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
+{
+    parallel_for(getBayerRange(srcmat.size(), 1), Bayer2Gray_Invoker<T, SIMDInterpolator>(srcmat, dstmat, code));
+
+    Size size = dstmat.size();
+    T* dst0 = (T*)dstmat.data;
+    int dst_step = (int)(dstmat.step/sizeof(T));
     if( size.height > 2 )
         for( int i = 0; i < size.width; i++ )
         {
@@ -1986,20 +2206,41 @@ static void Bayer2Gray_( const Mat& srcmat, Mat& dstmat, int code )
         }
 }
 
-template<typename T, class SIMDInterpolator>    
-static void Bayer2RGB_( const Mat& srcmat, Mat& dstmat, int code )
+template<typename T, class SIMDInterpolator>
+class Bayer2RGB_Invoker
+{
+public:
+    Bayer2RGB_Invoker( const Mat& _srcmat, Mat& _dstmat, int _code )
+        : srcmat(&_srcmat), dstmat(&_dstmat), code(_code) {}
+
+    void operator()( const BlockedRange& range ) const;
+
+private:
+    const Mat* srcmat;
+    Mat* dstmat;
+    int code;
+};
+
+template<typename T, class SIMDInterpolator>
+void Bayer2RGB_Invoker<T, SIMDInterpolator>::operator()( const BlockedRange& range ) const
 {
     SIMDInterpolator vecOp;
-    const T* bayer0 = (const T*)srcmat.data;
-    int bayer_step = (int)(srcmat.step/sizeof(T));
-    T* dst0 = (T*)dstmat.data;
-    int dst_step = (int)(dstmat.step/sizeof(T));
-    Size size = srcmat.size();
+    int bayer_step = (int)(srcmat->step/sizeof(T));
+    int dst_step = (int)(dstmat->step/sizeof(T));
+    const T* bayer0 = (const T*)srcmat->data + bayer_step*range.begin();
+    T* dst0 = (T*)dstmat->data + dst_step*range.begin();
+    Size size = srcmat->size();
     int blue = code == CV_BayerBG2BGR || code == CV_BayerGB2BGR ? -1 : 1;
     int start_with_green = code == CV_BayerGB2BGR || code == CV_BayerGR2BGR;
+
+    if( range.begin() % 2 != 0 )
+    {
+        blue = -blue;
+        start_with_green = !start_with_green;
+    }
     
     dst0 += dst_step + 3 + 1;
-    size.height -= 2;
+    size.height = range.end() - range.begin();
     size.width -= 2;
         
     for( ; size.height-- > 0; bayer0 += bayer_step, dst0 += dst_step )
@@ -2093,9 +2334,16 @@ static void Bayer2RGB_( const Mat& srcmat, Mat& dstmat, int code )
         blue = -blue;
         start_with_green = !start_with_green;
     }
-    
-    size = dstmat.size();
-    dst0 = (T*)dstmat.data;
+}
+
+template<typename T, class SIMDInterpolator>
+static void Bayer2RGB_( const Mat& srcmat, Mat& dstmat, int code )
+{
+    parallel_for(getBayerRange(srcmat.size(), 1), Bayer2RGB_Invoker<T, SIMDInterpolator>(srcmat, dstmat, code));
+
+    Size size = dstmat.size();
+    T* dst0 = (T*)dstmat.data;
+    int dst_step = (int)(dstmat.step/sizeof(T));
     if( size.height > 2 )
         for( int i = 0; i < size.width*3; i++ )
         {
@@ -2112,22 +2360,37 @@ static void Bayer2RGB_( const Mat& srcmat, Mat& dstmat, int code )
     
 /////////////////// Demosaicing using Variable Number of Gradients ///////////////////////
     
-static void Bayer2RGB_VNG_8u( const Mat& srcmat, Mat& dstmat, int code )
+// the range is the interval of the destination rows in [2, height-4)
+class Bayer2RGB_VNG_8u_Invoker
 {
-    const uchar* bayer = srcmat.data;
-    int bstep = (int)srcmat.step;
-    uchar* dst = dstmat.data;
-    int dststep = (int)dstmat.step;
-    Size size = srcmat.size();
+public:
+    Bayer2RGB_VNG_8u_Invoker( const Mat& _srcmat, Mat& _dstmat, int _code )
+        : srcmat(&_srcmat), dstmat(&_dstmat), code(_code) {}
+
+    void operator()( const BlockedRange& range ) const;
+
+private:
+    const Mat* srcmat;
+    Mat* dstmat;
+    int code;
+};
+
+void Bayer2RGB_VNG_8u_Invoker::operator()( const BlockedRange& range ) const
+{
+    const uchar* bayer = srcmat->data;
+    int bstep = (int)srcmat->step;
+    uchar* dst = dstmat->data;
+    int dststep = (int)dstmat->step;
+    Size size = srcmat->size();
     
     int blueIdx = code == CV_BayerBG2BGR_VNG || code == CV_BayerGB2BGR_VNG ? 0 : 2;
     bool greenCell0 = code != CV_BayerBG2BGR_VNG && code != CV_BayerRG2BGR_VNG;
-    
-    // for too small images use the simple interpolation algorithm
-    if( MIN(size.width, size.height) < 8 )
+
+    // the colors of the pixels alternate from row to row
+    if( (range.begin() - 2) % 2 != 0 )
     {
-        Bayer2RGB_<uchar, SIMDBayerInterpolator_8u>( srcmat, dstmat, code );
-        return;
+        greenCell0 = !greenCell0;
+        blueIdx ^= 2;
     }
     
     const int brows = 3, bcn = 7;
@@ -2143,12 +2406,12 @@ static void Bayer2RGB_VNG_8u( const Mat& srcmat, Mat& dstmat, int code )
     #define _mm_absdiff_epu16(a,b) _mm_adds_epu16(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a))
 #endif
     
-    for( int y = 2; y < size.height - 4; y++ )
+    for( int y = range.begin(); y < range.end(); y++ )
     {
         uchar* dstrow = dst + dststep*y + 6;
         const uchar* srow;
         
-        for( int dy = (y == 2 ? -1 : 1); dy <= 1; dy++ )
+        for( int dy = (y == range.begin() ? -1 : 1); dy <= 1; dy++ )
         {
             ushort* brow = buf + ((y + dy - 1)%brows)*bufstep + 1;
             srow = bayer + (y+dy)*bstep + 1;
@@ -2638,6 +2901,26 @@ static void Bayer2RGB_VNG_8u( const Mat& srcmat, Mat& dstmat, int code )
         blueIdx ^= 2;
     }
     
+}
+
+static void Bayer2RGB_VNG_8u( const Mat& srcmat, Mat& dstmat, int code )
+{
+    uchar* dst = dstmat.data;
+    int dststep = (int)dstmat.step;
+    Size size = srcmat.size();
+    int i;
+    
+    // for too small images use the simple interpolation algorithm
+    if( MIN(size.width, size.height) < 8 )
+    {
+        Bayer2RGB_<uchar, SIMDBayerInterpolator_8u>( srcmat, dstmat, code );
+        return;
+    }
+
+    // a band also computes the gradients of the 2 rows above it, so the bands are not made too thin
+    parallel_for(BlockedRange(2, size.height - 4, std::max((1 << 16)/size.width, 16)),
+                 Bayer2RGB_VNG_8u_Invoker(srcmat, dstmat, code));
+    
     for( i = 0; i < size.width*3; i++ )
     {
         dst[i] = dst[i + dststep] = dst[i + dststep*2];
@@ -2648,126 +2931,278 @@ static void Bayer2RGB_VNG_8u( const Mat& srcmat, Mat& dstmat, int code )
     }
 }
 
-///////////////////////////////////// YUV420i -> RGB /////////////////////////////////////
+///////////////////////////////////// YUV420 -> RGB /////////////////////////////////////
+
+/*
+   The 4:2:0 formats store the full-resolution Y plane followed by the chroma planes
+   subsampled by 2 in both directions: either one plane of the interleaved U,V (NV12) or V,U
+   (NV21, also known as YUV420i or YUV420sp) pairs, or the separate U and V planes (I420 or IYUV)
+   or V and U planes (YV12). Each pair of the destination rows shares one row of chroma.
+
+   The fixed-point ITU-R BT.601 coefficients (the "studio" range of Y and of the chroma):
+   B = 1.164(Y - 16)                  + 2.018(U - 128)
+   G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128)
+   R = 1.164(Y - 16) + 1.596(V - 128)
+*/
 
-template<int R>
-struct YUV420i2BGR888Invoker
+enum
 {
-    Mat* dst;
-    const uchar* my1, *muv;
-    int width;
+    ITUR_BT_601_CY = 298, ITUR_BT_601_CVR = 409, ITUR_BT_601_CVG = -208,
+    ITUR_BT_601_CUG = -100, ITUR_BT_601_CUB = 516, ITUR_BT_601_SHIFT = 8
+};
 
-    YUV420i2BGR888Invoker(Mat& _dst, int _width, const uchar* _y1, const uchar* _uv)
-        : dst(&_dst), my1(_y1), muv(_uv), width(_width) {}
+#if CV_SSE2
 
-    void operator()(const BlockedRange& range) const
-    {
-        //B = 1.164(Y - 16)                  + 2.018(U - 128)
-        //G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128)
-        //R = 1.164(Y - 16) + 1.596(V - 128)
+// the 32-bit products of the 16-bit a and the constant c (that may not fit into 16 bits)
+static inline void mul16x16to32( __m128i a, __m128i c, __m128i& lo, __m128i& hi )
+{
+    __m128i l = _mm_mullo_epi16(a, c), h = _mm_mulhi_epi16(a, c);
+    lo = _mm_unpacklo_epi16(l, h);
+    hi = _mm_unpackhi_epi16(l, h);
+}
+
+// saturate_cast<uchar>((y + c) >> ITUR_BT_601_SHIFT) of 16 pixels, each c is shared by 2 of them
+static inline __m128i yuv2rgbChannel_SSE2( const __m128i* y, __m128i c0, __m128i c1 )
+{
+    __m128i c00 = _mm_unpacklo_epi32(c0, c0), c01 = _mm_unpackhi_epi32(c0, c0);
+    __m128i c10 = _mm_unpacklo_epi32(c1, c1), c11 = _mm_unpackhi_epi32(c1, c1);
+    __m128i r0 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y[0], c00), ITUR_BT_601_SHIFT),
+                                 _mm_srai_epi32(_mm_add_epi32(y[1], c01), ITUR_BT_601_SHIFT));
+    __m128i r1 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y[2], c10), ITUR_BT_601_SHIFT),
+                                 _mm_srai_epi32(_mm_add_epi32(y[3], c11), ITUR_BT_601_SHIFT));
+    return _mm_packus_epi16(r0, r1);
+}
+
+static inline void yuv2rgbLuma_SSE2( const uchar* ptr, __m128i* y )
+{
+    const __m128i z = _mm_setzero_si128(), d16 = _mm_set1_epi16(16), cy = _mm_set1_epi16(ITUR_BT_601_CY);
+    __m128i t = _mm_loadu_si128((const __m128i*)ptr);
+    mul16x16to32(_mm_sub_epi16(_mm_unpacklo_epi8(t, z), d16), cy, y[0], y[1]);
+    mul16x16to32(_mm_sub_epi16(_mm_unpackhi_epi8(t, z), d16), cy, y[2], y[3]);
+}
 
-        const uchar* y1 = my1 + range.begin() * width, *uv = muv + range.begin() * width / 2;
+// writes 16 pixels; the 3-channel ones are written as the overlapping 4-byte words,
+// so one more byte after the last pixel is overwritten
+template<int dcn> static inline void
+yuv2rgbStore_SSE2( uchar* dst, __m128i b, __m128i g, __m128i r )
+{
+    __m128i a = _mm_set1_epi8((char)0xff);
+    __m128i bg0 = _mm_unpacklo_epi8(b, g), bg1 = _mm_unpackhi_epi8(b, g);
+    __m128i ra0 = _mm_unpacklo_epi8(r, a), ra1 = _mm_unpackhi_epi8(r, a);
+    __m128i p[4] =
+    {
+        _mm_unpacklo_epi16(bg0, ra0), _mm_unpackhi_epi16(bg0, ra0),
+        _mm_unpacklo_epi16(bg1, ra1), _mm_unpackhi_epi16(bg1, ra1)
+    };
 
-        for (int j = range.begin(); j < range.end(); j+=2, y1+=width*2, uv+=width)
+    if( dcn == 4 )
+    {
+        for( int k = 0; k < 4; k++ )
+            _mm_storeu_si128((__m128i*)(dst + k*16), p[k]);
+    }
+    else
+    {
+        for( int k = 0; k < 4; k++, dst += 12 )
         {
-            uchar* row1 = dst->ptr<uchar>(j);
-            uchar* row2 = dst->ptr<uchar>(j+1);
-            const uchar* y2 = y1 + width;
+            __m128i t = p[k];
+            *(int*)dst = _mm_cvtsi128_si32(t);
+            *(int*)(dst + 3) = _mm_cvtsi128_si32(_mm_srli_si128(t, 4));
+            *(int*)(dst + 6) = _mm_cvtsi128_si32(_mm_srli_si128(t, 8));
+            *(int*)(dst + 9) = _mm_cvtsi128_si32(_mm_srli_si128(t, 12));
+        }
+    }
+}
+
+#endif
 
-            for(int i = 0; i < width; i+=2,row1+=6,row2+=6)
+// converts a pair of the rows; u and v are the (already de-interleaved) chroma rows of width/2 elements
+template<int bIdx, int dcn> static void
+YUV420RowPair2RGB( const uchar* y1, const uchar* y2, const uchar* u, const uchar* v,
+                   uchar* row1, uchar* row2, int width )
+{
+    int i = 0;
+
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        const __m128i z = _mm_setzero_si128(), d128 = _mm_set1_epi16(128);
+        const __m128i half = _mm_set1_epi32(1 << (ITUR_BT_601_SHIFT - 1));
+        const __m128i cvr = _mm_set1_epi16(ITUR_BT_601_CVR), cub = _mm_set1_epi16(ITUR_BT_601_CUB);
+        const __m128i cg = _mm_setr_epi16(ITUR_BT_601_CUG, ITUR_BT_601_CVG, ITUR_BT_601_CUG, ITUR_BT_601_CVG,
+                                          ITUR_BT_601_CUG, ITUR_BT_601_CVG, ITUR_BT_601_CUG, ITUR_BT_601_CVG);
+        // the 3-channel store needs one extra byte after the last pixel
+        int limit = width - 16 - (dcn == 3 ? 2 : 0);
+
+        for( ; i <= limit; i += 16, row1 += dcn*16, row2 += dcn*16 )
+        {
+            __m128i uu = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u + i/2)), z), d128);
+            __m128i vv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(v + i/2)), z), d128);
+            __m128i ruv[2], guv[2], buv[2];
+
+            mul16x16to32(vv, cvr, ruv[0], ruv[1]);
+            mul16x16to32(uu, cub, buv[0], buv[1]);
+            guv[0] = _mm_madd_epi16(_mm_unpacklo_epi16(uu, vv), cg);
+            guv[1] = _mm_madd_epi16(_mm_unpackhi_epi16(uu, vv), cg);
+            for( int k = 0; k < 2; k++ )
             {
-                int cr = uv[i] - 128;
-                int cb = uv[i+1] - 128;
-
-                int ruv = 409 * cr + 128;
-                int guv = 128 - 100 * cb - 208 * cr;
-                int buv = 516 * cb + 128;
-
-                int y00 = (y1[i] - 16) * 298;
-                row1[0+R] = saturate_cast<uchar>((y00 + buv) >> 8);
-                row1[1] = saturate_cast<uchar>((y00 + guv) >> 8);
-                row1[2-R] = saturate_cast<uchar>((y00 + ruv) >> 8);
-
-                int y01 = (y1[i+1] - 16) * 298;
-                row1[3+R] = saturate_cast<uchar>((y01 + buv) >> 8);
-                row1[4] = saturate_cast<uchar>((y01 + guv) >> 8);
-                row1[5-R] = saturate_cast<uchar>((y01 + ruv) >> 8);
-
-                int y10 = (y2[i] - 16) * 298;
-                row2[0+R] = saturate_cast<uchar>((y10 + buv) >> 8);
-                row2[1] = saturate_cast<uchar>((y10 + guv) >> 8);
-                row2[2-R] = saturate_cast<uchar>((y10 + ruv) >> 8);
-
-                int y11 = (y2[i+1] - 16) * 298;
-                row2[3+R] = saturate_cast<uchar>((y11 + buv) >> 8);
-                row2[4] = saturate_cast<uchar>((y11 + guv) >> 8);
-                row2[5-R] = saturate_cast<uchar>((y11 + ruv) >> 8);
+                ruv[k] = _mm_add_epi32(ruv[k], half);
+                guv[k] = _mm_add_epi32(guv[k], half);
+                buv[k] = _mm_add_epi32(buv[k], half);
             }
+
+            __m128i yy[4];
+            yuv2rgbLuma_SSE2(y1 + i, yy);
+            __m128i b = yuv2rgbChannel_SSE2(yy, buv[0], buv[1]);
+            __m128i g = yuv2rgbChannel_SSE2(yy, guv[0], guv[1]);
+            __m128i r = yuv2rgbChannel_SSE2(yy, ruv[0], ruv[1]);
+            yuv2rgbStore_SSE2<dcn>(row1, bIdx == 0 ? b : r, g, bIdx == 0 ? r : b);
+
+            yuv2rgbLuma_SSE2(y2 + i, yy);
+            b = yuv2rgbChannel_SSE2(yy, buv[0], buv[1]);
+            g = yuv2rgbChannel_SSE2(yy, guv[0], guv[1]);
+            r = yuv2rgbChannel_SSE2(yy, ruv[0], ruv[1]);
+            yuv2rgbStore_SSE2<dcn>(row2, bIdx == 0 ? b : r, g, bIdx == 0 ? r : b);
         }
     }
-};
+#endif
 
-template<int R>
-struct YUV420i2BGRA8888Invoker
-{
-    Mat* dst;
-    const uchar* my1, *muv;
-    int width;
+    for( ; i < width; i += 2, row1 += dcn*2, row2 += dcn*2 )
+    {
+        int cu = u[i/2] - 128;
+        int cv = v[i/2] - 128;
 
-    YUV420i2BGRA8888Invoker(Mat& _dst, int _width, const uchar* _y1, const uchar* _uv)
-        : dst(&_dst), my1(_y1), muv(_uv), width(_width) {}
+        int ruv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVR * cv;
+        int guv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVG * cv + ITUR_BT_601_CUG * cu;
+        int buv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CUB * cu;
 
-    void operator()(const BlockedRange& range) const
-    {
-        //B = 1.164(Y - 16)                  + 2.018(U - 128)
-        //G = 1.164(Y - 16) - 0.813(V - 128) - 0.391(U - 128)
-        //R = 1.164(Y - 16) + 1.596(V - 128)
+        int y00 = (y1[i] - 16) * ITUR_BT_601_CY;
+        row1[2-bIdx] = saturate_cast<uchar>((y00 + ruv) >> ITUR_BT_601_SHIFT);
+        row1[1]      = saturate_cast<uchar>((y00 + guv) >> ITUR_BT_601_SHIFT);
+        row1[bIdx]   = saturate_cast<uchar>((y00 + buv) >> ITUR_BT_601_SHIFT);
+        if( dcn == 4 ) row1[3] = (uchar)0xff;
 
-        const uchar* y1 = my1 + range.begin() * width, *uv = muv + range.begin() * width / 2;
+        int y01 = (y1[i+1] - 16) * ITUR_BT_601_CY;
+        row1[dcn+2-bIdx] = saturate_cast<uchar>((y01 + ruv) >> ITUR_BT_601_SHIFT);
+        row1[dcn+1]      = saturate_cast<uchar>((y01 + guv) >> ITUR_BT_601_SHIFT);
+        row1[dcn+bIdx]   = saturate_cast<uchar>((y01 + buv) >> ITUR_BT_601_SHIFT);
+        if( dcn == 4 ) row1[7] = (uchar)0xff;
 
-        for (int j = range.begin(); j < range.end(); j+=2, y1+=width*2, uv+=width)
+        int y10 = (y2[i] - 16) * ITUR_BT_601_CY;
+        row2[2-bIdx] = saturate_cast<uchar>((y10 + ruv) >> ITUR_BT_601_SHIFT);
+        row2[1]      = saturate_cast<uchar>((y10 + guv) >> ITUR_BT_601_SHIFT);
+        row2[bIdx]   = saturate_cast<uchar>((y10 + buv) >> ITUR_BT_601_SHIFT);
+        if( dcn == 4 ) row2[3] = (uchar)0xff;
+
+        int y11 = (y2[i+1] - 16) * ITUR_BT_601_CY;
+        row2[dcn+2-bIdx] = saturate_cast<uchar>((y11 + ruv) >> ITUR_BT_601_SHIFT);
+        row2[dcn+1]      = saturate_cast<uchar>((y11 + guv) >> ITUR_BT_601_SHIFT);
+        row2[dcn+bIdx]   = saturate_cast<uchar>((y11 + buv) >> ITUR_BT_601_SHIFT);
+        if( dcn == 4 ) row2[7] = (uchar)0xff;
+    }
+}
+
+typedef void (*YUV420RowPair2RGBFunc)( const uchar* y1, const uchar* y2, const uchar* u, const uchar* v,
+                                       uchar* row1, uchar* row2, int width );
+
+// the range is in the pairs of the destination rows
+class YUV420p2RGBInvoker
+{
+public:
+    YUV420p2RGBInvoker( Mat& _dst, const uchar* _y, const uchar* _u, const uchar* _v,
+                        int _uvstep, int _uvrowstep, YUV420RowPair2RGBFunc _func )
+        : dst(&_dst), y(_y), u(_u), v(_v), uvstep(_uvstep), uvrowstep(_uvrowstep), func(_func) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int width = dst->cols, cwidth = width/2;
+        AutoBuffer<uchar> _buf(uvstep > 1 ? cwidth*2 + 32 : 1);
+        uchar* ubuf = alignPtr((uchar*)_buf, 16);
+        uchar* vbuf = ubuf + cwidth;
+
+        for( int j = range.begin(); j < range.end(); j++ )
         {
-            uchar* row1 = dst->ptr<uchar>(j);
-            uchar* row2 = dst->ptr<uchar>(j+1);
-            const uchar* y2 = y1 + width;
+            const uchar* y1 = y + (size_t)width*j*2;
+            const uchar* urow = u + (size_t)uvrowstep*j;
+            const uchar* vrow = v + (size_t)uvrowstep*j;
 
-            for(int i = 0; i < width; i+=2,row1+=8,row2+=8)
+            // the semi-planar chroma row is split into the planar U and V rows first
+            if( uvstep > 1 )
             {
-                int cr = uv[i] - 128;
-                int cb = uv[i+1] - 128;
-
-                int ruv = 409 * cr + 128;
-                int guv = 128 - 100 * cb - 208 * cr;
-                int buv = 516 * cb + 128;
-
-                int y00 = (y1[i] - 16) * 298;
-                row1[0+R] = saturate_cast<uchar>((y00 + buv) >> 8);
-                row1[1] = saturate_cast<uchar>((y00 + guv) >> 8);
-                row1[2-R] = saturate_cast<uchar>((y00 + ruv) >> 8);
-                row1[3] = (uchar)0xff;
-
-                int y01 = (y1[i+1] - 16) * 298;
-                row1[4+R] = saturate_cast<uchar>((y01 + buv) >> 8);
-                row1[5] = saturate_cast<uchar>((y01 + guv) >> 8);
-                row1[6-R] = saturate_cast<uchar>((y01 + ruv) >> 8);
-                row1[7] = (uchar)0xff;
-
-                int y10 = (y2[i] - 16) * 298;
-                row2[0+R] = saturate_cast<uchar>((y10 + buv) >> 8);
-                row2[1] = saturate_cast<uchar>((y10 + guv) >> 8);
-                row2[2-R] = saturate_cast<uchar>((y10 + ruv) >> 8);
-                row2[3] = (uchar)0xff;
-
-                int y11 = (y2[i+1] - 16) * 298;
-                row2[4+R] = saturate_cast<uchar>((y11 + buv) >> 8);
-                row2[5] = saturate_cast<uchar>((y11 + guv) >> 8);
-                row2[6-R] = saturate_cast<uchar>((y11 + ruv) >> 8);
-                row2[7] = (uchar)0xff;
+                int i = 0;
+#if CV_SSE2
+                if( checkHardwareSupport(CV_CPU_SSE2) )
+                {
+                    const uchar* uv = std::min(urow, vrow);
+                    __m128i mask = _mm_set1_epi16(0xff);
+                    uchar* d0 = urow < vrow ? ubuf : vbuf;
+                    uchar* d1 = urow < vrow ? vbuf : ubuf;
+                    for( ; i <= cwidth - 16; i += 16 )
+                    {
+                        __m128i t0 = _mm_loadu_si128((const __m128i*)(uv + i*2));
+                        __m128i t1 = _mm_loadu_si128((const __m128i*)(uv + i*2 + 16));
+                        _mm_storeu_si128((__m128i*)(d0 + i),
+                            _mm_packus_epi16(_mm_and_si128(t0, mask), _mm_and_si128(t1, mask)));
+                        _mm_storeu_si128((__m128i*)(d1 + i),
+                            _mm_packus_epi16(_mm_srli_epi16(t0, 8), _mm_srli_epi16(t1, 8)));
+                    }
+                }
+#endif
+                for( ; i < cwidth; i++ )
+                {
+                    ubuf[i] = urow[i*2];
+                    vbuf[i] = vrow[i*2];
+                }
+                urow = ubuf;
+                vrow = vbuf;
             }
+
+            func(y1, y1 + width, urow, vrow, dst->ptr(j*2), dst->ptr(j*2+1), width);
         }
     }
+
+private:
+    Mat* dst;
+    const uchar *y, *u, *v;
+    int uvstep, uvrowstep;
+    YUV420RowPair2RGBFunc func;
 };
 
+static void cvtYUV420p2RGB( const Mat& src, Mat& dst, int dcn, int bIdx, bool semiPlanar, int uIdx )
+{
+    static YUV420RowPair2RGBFunc tab[][2] =
+    {
+        { YUV420RowPair2RGB<0, 3>, YUV420RowPair2RGB<0, 4> },
+        { YUV420RowPair2RGB<2, 3>, YUV420RowPair2RGB<2, 4> }
+    };
+    int width = dst.cols, height = dst.rows;
+    const uchar* y = src.data;
+    const uchar *u, *v;
+    int uvstep, uvrowstep;
+
+    if( semiPlanar )
+    {
+        u = y + width*height + uIdx;
+        v = y + width*height + (uIdx ^ 1);
+        uvstep = 2;
+        uvrowstep = width;
+    }
+    else
+    {
+        u = y + width*height + (width/2)*(height/2)*uIdx;
+        v = y + width*height + (width/2)*(height/2)*(uIdx ^ 1);
+        uvstep = 1;
+        uvrowstep = width/2;
+    }
+
+    YUV420p2RGBInvoker body(dst, y, u, v, uvstep, uvrowstep, tab[bIdx > 0][dcn == 4]);
+    // about 64K pixels per band
+    int pairs = height/2, grain = std::max((1 << 15)/std::max(width, 1), 1);
+    if( pairs <= grain || getNumThreads() <= 1 )
+        body(BlockedRange(0, pairs));
+    else
+        parallel_for(BlockedRange(0, pairs, grain), body);
+}
+
 }//namespace cv
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -2776,7 +3211,9 @@ struct YUV420i2BGRA8888Invoker
 
 void cv::cvtColor( InputArray _src, OutputArray _dst, int code, int dcn )
 {
+    CV_TRACE_REGION("cv::cvtColor");
     Mat src = _src.getMat(), dst;
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     Size sz = src.size();
     int scn = src.channels(), depth = src.depth(), bidx;
     
@@ -3112,38 +3549,53 @@ void cv::cvtColor( InputArray _src, OutputArray _dst, int code, int dcn )
                 Bayer2RGB_VNG_8u(src, dst, code);
             }
             break;
-        case CV_YUV420i2BGR: case CV_YUV420i2RGB:
+        case CV_YUV2BGR_NV21: case CV_YUV2RGB_NV21: case CV_YUV2BGR_NV12: case CV_YUV2RGB_NV12:
+        case CV_YUV2BGRA_NV21: case CV_YUV2RGBA_NV21: case CV_YUV2BGRA_NV12: case CV_YUV2RGBA_NV12:
+        case CV_YUV2BGR_YV12: case CV_YUV2RGB_YV12: case CV_YUV2BGR_IYUV: case CV_YUV2RGB_IYUV:
+        case CV_YUV2BGRA_YV12: case CV_YUV2RGBA_YV12: case CV_YUV2BGRA_IYUV: case CV_YUV2RGBA_IYUV:
             {
-                if(dcn <= 0) dcn = 3;
+                bool alpha = code == CV_YUV2BGRA_NV21 || code == CV_YUV2RGBA_NV21 ||
+                    code == CV_YUV2BGRA_NV12 || code == CV_YUV2RGBA_NV12 ||
+                    code == CV_YUV2BGRA_YV12 || code == CV_YUV2RGBA_YV12 ||
+                    code == CV_YUV2BGRA_IYUV || code == CV_YUV2RGBA_IYUV;
+                bool rgb = code == CV_YUV2RGB_NV21 || code == CV_YUV2RGB_NV12 ||
+                    code == CV_YUV2RGBA_NV21 || code == CV_YUV2RGBA_NV12 ||
+                    code == CV_YUV2RGB_YV12 || code == CV_YUV2RGB_IYUV ||
+                    code == CV_YUV2RGBA_YV12 || code == CV_YUV2RGBA_IYUV;
+                bool semiPlanar = code < CV_YUV2RGB_YV12;
+                int uIdx = code == CV_YUV2BGR_NV21 || code == CV_YUV2RGB_NV21 ||
+                    code == CV_YUV2BGRA_NV21 || code == CV_YUV2RGBA_NV21 ||
+                    code == CV_YUV2BGR_YV12 || code == CV_YUV2RGB_YV12 ||
+                    code == CV_YUV2BGRA_YV12 || code == CV_YUV2RGBA_YV12;
+
+                // the original YUV420i codes let the caller choose between 3 and 4 channels
+                if( alpha )
+                    dcn = 4;
+                else if( dcn <= 0 )
+                    dcn = 3;
                 CV_Assert( dcn == 3 || dcn == 4 );
-                CV_Assert( sz.width % 2 == 0 && sz.height % 3 == 0 && depth == CV_8U && src.isContinuous() );
+                CV_Assert( scn == 1 && sz.width % 2 == 0 && sz.height % 3 == 0 && depth == CV_8U && src.isContinuous() );
 
                 Size dstSz(sz.width, sz.height * 2 / 3);
                 _dst.create( dstSz, CV_MAKETYPE(depth, dcn));
                 dst = _dst.getMat();
 
-                const uchar* y = src.ptr();
-                const uchar* uv = y + dstSz.area();
-
 #ifdef HAVE_TEGRA_OPTIMIZATION
-                if (!tegra::YUV420i2BGR(y, uv, dst, CV_YUV420i2RGB == code))
+                if( (code == CV_YUV2BGR_NV21 || code == CV_YUV2RGB_NV21) &&
+                    tegra::YUV420i2BGR(src.data, src.data + dstSz.area(), dst, rgb) )
+                    break;
 #endif
-                {
-                    if (CV_YUV420i2RGB == code)
-                    {
-                        if (dcn == 3)
-                            parallel_for(BlockedRange(0, dstSz.height, 2), YUV420i2BGR888Invoker<2>(dst, dstSz.width, y, uv));
-                        else
-                            parallel_for(BlockedRange(0, dstSz.height, 2), YUV420i2BGRA8888Invoker<2>(dst, dstSz.width, y, uv));
-                    }
-                    else
-                    {
-                        if (dcn == 3)
-                            parallel_for(BlockedRange(0, dstSz.height, 2), YUV420i2BGR888Invoker<0>(dst, dstSz.width, y, uv));
-                        else
-                            parallel_for(BlockedRange(0, dstSz.height, 2), YUV420i2BGRA8888Invoker<0>(dst, dstSz.width, y, uv));
-                    }
-                }
+                cvtYUV420p2RGB(src, dst, dcn, rgb ? 2 : 0, semiPlanar, uIdx);
+            }
+            break;
+        case CV_YUV2GRAY_420:
+            {
+                if( dcn <= 0 ) dcn = 1;
+                CV_Assert( dcn == 1 );
+                CV_Assert( scn == 1 && sz.width % 2 == 0 && sz.height % 3 == 0 && depth == CV_8U );
+
+                // the luma plane is the gray image
+                src.rowRange(0, sz.height * 2 / 3).copyTo(_dst);
             }
             break;
         default:
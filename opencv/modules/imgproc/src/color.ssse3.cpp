@@ -0,0 +1,126 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2010, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* SSSE3 version of the 8-bit RGB2RGB conversions (channel swap, adding or removing alpha),
+   built on the byte shuffle instruction. */
+
+#include "precomp.hpp"
+
+#if CV_SSSE3
+
+namespace cv
+{
+namespace opt_SSSE3
+{
+
+int cvtBGR2BGR8u( const uchar* src, uchar* dst, int n, int scn, int dcn, int bidx )
+{
+    uchar CV_DECL_ALIGNED(16) tab[16];
+    int i = 0, p;
+
+    if( dcn == 3 )
+    {
+        // 3->3: 5 pixels per iteration, the 16th byte is copied as is, so in-place processing works;
+        // 4->3: 4 pixels per iteration, the last 4 bytes are overwritten by the next iteration
+        int npix = scn == 3 ? 5 : 4;
+        memset(tab, 0x80, sizeof(tab));
+        for( p = 0; p < npix; p++ )
+        {
+            tab[p*3] = (uchar)(p*scn + bidx);
+            tab[p*3+1] = (uchar)(p*scn + 1);
+            tab[p*3+2] = (uchar)(p*scn + (bidx^2));
+        }
+        if( scn == 3 )
+            tab[15] = 15;
+        __m128i mask = _mm_load_si128((const __m128i*)tab);
+
+        for( ; i <= n - 6; i += npix )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i*scn));
+            _mm_storeu_si128((__m128i*)(dst + i*3), _mm_shuffle_epi8(v, mask));
+        }
+    }
+    else if( scn == 3 )
+    {
+        // 3->4: 4 pixels per iteration, the alpha channel is set to 255
+        for( p = 0; p < 4; p++ )
+        {
+            tab[p*4 + bidx] = (uchar)(p*3);
+            tab[p*4 + 1] = (uchar)(p*3 + 1);
+            tab[p*4 + (bidx^2)] = (uchar)(p*3 + 2);
+            tab[p*4 + 3] = 0x80;
+        }
+        __m128i mask = _mm_load_si128((const __m128i*)tab);
+        __m128i alpha = _mm_set1_epi32(0xff000000);
+
+        for( ; i <= n - 6; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i*3));
+            v = _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha);
+            _mm_storeu_si128((__m128i*)(dst + i*4), v);
+        }
+    }
+    else
+    {
+        // 4->4: swap the 1st and the 3rd channels
+        __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for( ; i <= n - 8; i += 8 )
+        {
+            __m128i v0 = _mm_loadu_si128((const __m128i*)(src + i*4));
+            __m128i v1 = _mm_loadu_si128((const __m128i*)(src + i*4 + 16));
+            _mm_storeu_si128((__m128i*)(dst + i*4), _mm_shuffle_epi8(v0, mask));
+            _mm_storeu_si128((__m128i*)(dst + i*4 + 16), _mm_shuffle_epi8(v1, mask));
+        }
+        for( ; i <= n - 4; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i*4));
+            _mm_storeu_si128((__m128i*)(dst + i*4), _mm_shuffle_epi8(v, mask));
+        }
+    }
+
+    return i;
+}
+
+}
+}
+
+#endif
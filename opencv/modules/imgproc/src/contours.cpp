@@ -1469,15 +1469,127 @@ cvFindContours( void*  img,  CvMemStorage*  storage,
     return count;
 }
 
-void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
-                   OutputArray _hierarchy, int mode, int method, Point offset )
+namespace cv
+{
+
+// The contour record of the scanner below; the same as _CvContourInfo,
+// except that contours are referred to by their indices and -1 stands for the frame.
+struct ContourInfo
+{
+    int next;       // next contour marked with the same nbd value
+    int parent;
+    int isHole;
+    Rect rect;      // bounding rectangle, as accumulated during the border following
+    Point origin;
+};
+
+/*
+   The border following of icvFetchContour/icvFetchContourEx, which appends the points
+   (CV_CHAIN_APPROX_NONE/SIMPLE) or the chain codes (CV_CHAIN_CODE) to plain arrays
+   instead of a CvSeq. The rectangle is computed only if rect != 0.
+*/
+static void
+fetchContour( schar* ptr, int step, Point pt, Point offset, int isHole, int method,
+              int nbd, SeqArena<Point>& points, vector<schar>& codes, Rect* _rect )
+{
+    int deltas[16];
+    schar *i0 = ptr, *i1, *i3, *i4;
+    int prev_s = -1, s, s_end;
+    Rect rect(pt.x, pt.y, pt.x, pt.y);
+
+    CV_INIT_3X3_DELTAS( deltas, step, 1 );
+    memcpy( deltas + 8, deltas, 8 * sizeof( deltas[0] ));
+
+    s_end = s = isHole ? 0 : 4;
+
+    do
+    {
+        s = (s - 1) & 7;
+        i1 = i0 + deltas[s];
+        if( *i1 != 0 )
+            break;
+    }
+    while( s != s_end );
+
+    if( s == s_end )            /* single pixel domain */
+    {
+        *i0 = (schar) (nbd | 0x80);
+        if( method != CV_CHAIN_CODE )
+            points.push_back( pt + offset );
+    }
+    else
+    {
+        i3 = i0;
+        prev_s = s ^ 4;
+
+        /* follow border */
+        for( ;; )
+        {
+            s_end = s;
+
+            for( ;; )
+            {
+                i4 = i3 + deltas[++s];
+                if( *i4 != 0 )
+                    break;
+            }
+            s &= 7;
+
+            /* check "right" bound */
+            if( (unsigned) (s - 1) < (unsigned) s_end )
+            {
+                *i3 = (schar) (nbd | 0x80);
+            }
+            else if( *i3 == 1 )
+            {
+                *i3 = (schar) nbd;
+            }
+
+            if( method == CV_CHAIN_CODE )
+                codes.push_back( (schar)s );
+            else if( s != prev_s || method == CV_CHAIN_APPROX_NONE )
+                points.push_back( pt + offset );
+
+            if( s != prev_s && _rect )
+            {
+                /* update bounds */
+                if( pt.x < rect.x )
+                    rect.x = pt.x;
+                else if( pt.x > rect.width )
+                    rect.width = pt.x;
+
+                if( pt.y < rect.y )
+                    rect.y = pt.y;
+                else if( pt.y > rect.height )
+                    rect.height = pt.y;
+            }
+
+            prev_s = s;
+            pt.x += icvCodeDeltas[s].x;
+            pt.y += icvCodeDeltas[s].y;
+
+            if( i4 == i0 && i3 == i1 )  break;
+
+            i3 = i4;
+            s = (s + 4) & 7;
+        }                       /* end of border following loop */
+    }
+
+    if( _rect )
+    {
+        rect.width -= rect.x - 1;
+        rect.height -= rect.y - 1;
+        *_rect = rect;
+    }
+}
+
+// CV_CHAIN_CODE and CV_LINK_RUNS still go through cvFindContours
+static void findContoursSeq( Mat& image, OutputArrayOfArrays _contours,
+                             OutputArray _hierarchy, int mode, int method, Point offset )
 {
-    Mat image = _image.getMat();
     MemStorage storage(cvCreateMemStorage());
     CvMat _cimage = image;
     CvSeq* _ccontours = 0;
-    if( _hierarchy.needed() )
-        _hierarchy.clear();
     cvFindContours(&_cimage, storage, &_ccontours, sizeof(CvContour), mode, method, offset);
     if( !_ccontours )
     {
@@ -1502,7 +1614,7 @@ void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
     {
         _hierarchy.create(1, total, CV_32SC4, -1, true);
         Vec4i* hierarchy = _hierarchy.getMat().ptr<Vec4i>();
-        
+
         it = all_contours.begin();
         for( i = 0; i < total; i++, ++it )
         {
@@ -1516,6 +1628,236 @@ void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
     }
 }
 
+}
+
+/*
+   The C++ version of the contour retrieval. It runs the same scanner as cvFindNextContour,
+   but the contours are collected in a SeqArena and their tree is kept as index links,
+   so neither CvMemStorage nor CvSeq is involved. The output (order of the contours and
+   the hierarchy) is identical to what cvFindContours + cvTreeToNodeSeq produce.
+*/
+void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
+                   OutputArray _hierarchy, int mode, int method, Point offset )
+{
+    Mat image = _image.getMat();
+    if( _hierarchy.needed() )
+        _hierarchy.clear();
+
+    if( method == CV_CHAIN_CODE || method == CV_LINK_RUNS )
+    {
+        findContoursSeq(image, _contours, _hierarchy, mode, method, offset);
+        return;
+    }
+
+    if( image.empty() || (image.type() != CV_8UC1 && image.type() != CV_8SC1) )
+        CV_Error( CV_StsUnsupportedFormat, "[Start]FindContours support only 8uC1 images" );
+    if( method < 0 || method > CV_CHAIN_APPROX_TC89_KCOS )
+        CV_Error( CV_StsOutOfRange, "" );
+
+    int x, y, i, width = image.cols, height = image.rows, step = (int)image.step;
+    schar* img0 = (schar*)image.data;
+
+    /* make zero borders */
+    memset( img0, 0, width );
+    memset( img0 + step * (height - 1), 0, width );
+
+    for( y = 1; y < height - 1; y++ )
+        img0[y*step] = img0[y*step + width - 1] = 0;
+
+    /* converts all pixels to 0 or 1 */
+    threshold( image, image, 0, 1, THRESH_BINARY );
+
+    bool approx = method > CV_CHAIN_APPROX_SIMPLE;
+    int traceMethod = approx ? CV_CHAIN_CODE : method;
+    int cinfoTable[126];
+    int nbd = 2;
+    SeqArena<Point> points;
+    vector<schar> codes;
+    vector<ContourInfo> cinfo;
+    Point lnbd(0, 1);
+
+    for( i = 0; i < 126; i++ )
+        cinfoTable[i] = -1;
+
+    for( y = 1; y < height - 1; y++ )
+    {
+        schar* img = img0 + y*step;
+        int prev = 0;
+
+        lnbd.x = 0;
+        lnbd.y = y;
+
+        for( x = 1; x < width - 1; x++ )
+        {
+            int p = img[x];
+            int isHole = 0;
+            bool found = true;
+
+            if( p == prev )
+                continue;
+
+            if( !(prev == 0 && p == 1) )    /* if not external contour */
+            {
+                /* check hole */
+                if( p != 0 || prev < 1 )
+                    found = false;
+                else
+                {
+                    if( prev & -2 )
+                        lnbd.x = x - 1;
+                    isHole = 1;
+                }
+            }
+
+            if( found && mode == 0 && (isHole || img0[lnbd.y * step + lnbd.x] > 0) )
+                found = false;
+
+            if( !found )
+            {
+                prev = p;
+                /* update lnbd */
+                if( prev & -2 )
+                    lnbd.x = x;
+                continue;
+            }
+
+            ContourInfo ci;
+            ci.next = -1;
+            ci.parent = -1;
+            ci.isHole = isHole;
+            ci.origin = Point(x - isHole, y);
+
+            /* find contour parent */
+            if( !(mode <= 1 || (!isHole && mode == 2) || lnbd.x <= 0) )
+            {
+                int lval = img0[lnbd.y * step + lnbd.x] & 0x7f;
+                int par = -1;
+
+                CV_Assert( lval >= 2 );
+
+                /* find the first bounding contour */
+                for( int cur = cinfoTable[lval - 2]; cur >= 0; cur = cinfo[cur].next )
+                {
+                    const Rect& r = cinfo[cur].rect;
+                    if( (unsigned) (lnbd.x - r.x) < (unsigned) r.width &&
+                        (unsigned) (lnbd.y - r.y) < (unsigned) r.height )
+                    {
+                        if( par >= 0 && icvTraceContour( img0 + cinfo[par].origin.y * step +
+                                                         cinfo[par].origin.x, step, img + lnbd.x,
+                                                         cinfo[par].isHole ) > 0 )
+                            break;
+                        par = cur;
+                    }
+                }
+
+                CV_Assert( par >= 0 );
+
+                /* a hole inside a hole or an external contour inside an external one
+                   belongs to the parent of that contour (maybe the frame) */
+                ci.parent = cinfo[par].isHole == isHole ? cinfo[par].parent : par;
+            }
+
+            lnbd.x = x - isHole;
+
+            points.openSeq();
+            codes.clear();
+            fetchContour( img + x - isHole, step, ci.origin, offset, isHole, traceMethod,
+                          nbd, points, codes, mode > 1 ? &ci.rect : 0 );
+
+            if( approx )
+            {
+                int count = (int)codes.size();
+                Point* dst = points.grow( std::max(count, 1) );
+                points.resizeLast( approxChainTC89( count > 0 ? &codes[0] : 0, count,
+                                                    ci.origin + offset, method, dst ));
+            }
+
+            if( mode > 1 )
+            {
+                ci.next = cinfoTable[nbd - 2];
+                cinfoTable[nbd - 2] = (int)cinfo.size();
+
+                /* change nbd */
+                nbd = (nbd + 1) & 127;
+                nbd += nbd == 0 ? 3 : 0;
+            }
+            cinfo.push_back(ci);
+
+            /* the border following might have marked the current pixel */
+            prev = img[x];
+        }
+    }
+
+    int total = (int)cinfo.size();
+    if( total == 0 )
+    {
+        _contours.clear();
+        return;
+    }
+
+    /* cvInsertNodeIntoTree puts every new contour in front of its siblings, and the output
+       is the pre-order traversal of the tree; the same links are built here on indices.
+       vnext[total] is the first child of the frame. */
+    AutoBuffer<int> _links(total*5 + 1);
+    int *hnext = _links, *hprev = hnext + total, *order = hprev + total;
+    int *pos = order + total, *vnext = pos + total;
+
+    for( i = 0; i <= total; i++ )
+        vnext[i] = -1;
+
+    for( i = 0; i < total; i++ )
+    {
+        int parent = cinfo[i].parent >= 0 ? cinfo[i].parent : total;
+        hnext[i] = vnext[parent];
+        hprev[i] = -1;
+        if( vnext[parent] >= 0 )
+            hprev[vnext[parent]] = i;
+        vnext[parent] = i;
+    }
+
+    int n = 0;
+    for( i = vnext[total]; i >= 0; )
+    {
+        pos[i] = n;
+        order[n++] = i;
+        if( vnext[i] >= 0 )
+            i = vnext[i];
+        else
+        {
+            while( i >= 0 && hnext[i] < 0 )
+                i = cinfo[i].parent;
+            if( i >= 0 )
+                i = hnext[i];
+        }
+    }
+    CV_Assert( n == total );
+
+    _contours.create(total, 1, 0, -1, true);
+    for( i = 0; i < total; i++ )
+    {
+        int k = order[i], len = (int)points.seqSize(k);
+        _contours.create(len, 1, CV_32SC2, i, true);
+        Mat ci = _contours.getMat(i);
+        CV_Assert( ci.isContinuous() );
+        memcpy( ci.data, points.ptr(k), len*sizeof(Point) );
+    }
+
+    if( _hierarchy.needed() )
+    {
+        _hierarchy.create(1, total, CV_32SC4, -1, true);
+        Vec4i* hierarchy = _hierarchy.getMat().ptr<Vec4i>();
+
+        for( i = 0; i < total; i++ )
+        {
+            int k = order[i], parent = cinfo[k].parent;
+            hierarchy[i] = Vec4i(hnext[k] >= 0 ? pos[hnext[k]] : -1,
+                                 hprev[k] >= 0 ? pos[hprev[k]] : -1,
+                                 vnext[k] >= 0 ? pos[vnext[k]] : -1,
+                                 parent >= 0 ? pos[parent] : -1);
+        }
+    }
+}
+
 void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
                        int mode, int method, Point offset)
 {
@@ -1709,27 +2051,6 @@ double cv::matchShapes( InputArray _contour1,
 }
 
 
-void cv::convexHull( InputArray _points, OutputArray _hull, bool clockwise, bool returnPoints )
-{
-    Mat points = _points.getMat();
-    int nelems = points.checkVector(2), depth = points.depth();
-    CV_Assert(nelems >= 0 && (depth == CV_32F || depth == CV_32S));
-    
-    if( nelems == 0 )
-    {
-        _hull.release();
-        return;
-    }
-    
-    returnPoints = !_hull.fixedType() ? returnPoints : _hull.type() != CV_32S;
-    Mat hull(nelems, 1, returnPoints ? CV_MAKETYPE(depth, 2) : CV_32S);
-    CvMat _cpoints = points, _chull = hull;
-    cvConvexHull2(&_cpoints, &_chull, clockwise ? CV_CLOCKWISE : CV_COUNTER_CLOCKWISE, returnPoints);
-    _hull.create(_chull.rows, 1, hull.type(), -1, true);
-    Mat dhull = _hull.getMat(), shull(dhull.size(), dhull.type(), hull.data);
-    shull.copyTo(dhull);
-}
-
 bool cv::isContourConvex( InputArray _contour )
 {
     Mat contour = _contour.getMat();
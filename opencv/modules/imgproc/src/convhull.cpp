@@ -195,26 +195,137 @@ typedef int (*sklansky_func)( CvPoint** points, int start, int end,
 static CV_IMPLEMENT_QSORT( icvSortPointsByPointers_32s, CvPoint*, cmp_pts )
 static CV_IMPLEMENT_QSORT( icvSortPointsByPointers_32f, CvPoint2D32f*, cmp_pts )
 
-static void
-icvCalcAndWritePtIndices( CvPoint** pointer, int* stack, int start, int end,
-                          CvSeq* ptseq, CvSeqWriter* writer )
+/*
+   Sklansky's algorithm over the points sorted by x. The hull is gathered as indices
+   of the input points, so neither the C++ interface nor cvConvexHull2 needs a sequence
+   for the intermediate results.
+*/
+void cv::convexHull( InputArray _points, OutputArray _hull, bool clockwise, bool returnPoints )
 {
-    int i, incr = start < end ? 1 : -1;
-    int idx, first_idx = ptseq->first->start_index;
+    Mat points = _points.getMat();
+    int i, total = points.checkVector(2), depth = points.depth(), nout = 0;
+    int miny_ind = 0, maxy_ind = 0;
+    CV_Assert(total >= 0 && (depth == CV_32F || depth == CV_32S));
 
-    for( i = start; i != end; i += incr )
+    if( total == 0 )
+    {
+        _hull.release();
+        return;
+    }
+
+    returnPoints = !_hull.fixedType() ? returnPoints : _hull.type() != CV_32S;
+
+    bool is_float = depth == CV_32F;
+    AutoBuffer<CvPoint*> _pointer(total);
+    AutoBuffer<int> _stack(total + 2), _hullbuf(total);
+    CvPoint** pointer = _pointer;
+    CvPoint2D32f** pointerf = (CvPoint2D32f**)pointer;
+    CvPoint* data0 = (CvPoint*)points.data;
+    int* stack = _stack;
+    int* hullbuf = _hullbuf;
+    sklansky_func sklansky = !is_float ? (sklansky_func)icvSklansky_32s :
+                                         (sklansky_func)icvSklansky_32f;
+
+    for( i = 0; i < total; i++ )
+        pointer[i] = &data0[i];
+
+    // sort the point set by x-coordinate, find min and max y
+    if( !is_float )
+    {
+        icvSortPointsByPointers_32s( pointer, total, 0 );
+        for( i = 1; i < total; i++ )
+        {
+            int y = pointer[i]->y;
+            if( pointer[miny_ind]->y > y )
+                miny_ind = i;
+            if( pointer[maxy_ind]->y < y )
+                maxy_ind = i;
+        }
+    }
+    else
     {
-        CvPoint* ptr = (CvPoint*)pointer[stack[i]];
-        CvSeqBlock* block = ptseq->first;
-        while( (unsigned)(idx = (int)(ptr - (CvPoint*)block->data)) >= (unsigned)block->count )
+        icvSortPointsByPointers_32f( pointerf, total, 0 );
+        for( i = 1; i < total; i++ )
+        {
+            float y = pointerf[i]->y;
+            if( pointerf[miny_ind]->y > y )
+                miny_ind = i;
+            if( pointerf[maxy_ind]->y < y )
+                maxy_ind = i;
+        }
+    }
+
+    if( pointer[0]->x == pointer[total-1]->x &&
+        pointer[0]->y == pointer[total-1]->y )
+    {
+        hullbuf[nout++] = 0;
+    }
+    else
+    {
+        /*upper half */
+        int *tl_stack = stack;
+        int tl_count = sklansky( pointer, 0, maxy_ind, tl_stack, -1, 1 );
+        int *tr_stack = tl_stack + tl_count;
+        int tr_count = sklansky( pointer, total - 1, maxy_ind, tr_stack, -1, -1 );
+
+        /* gather upper part of convex hull to output */
+        if( !clockwise )
         {
-            block = block->next;
-            if( block == ptseq->first )
-                CV_Error( CV_StsError, "Internal error" );
+            std::swap( tl_stack, tr_stack );
+            std::swap( tl_count, tr_count );
         }
-        idx += block->start_index - first_idx;
-        CV_WRITE_SEQ_ELEM( idx, *writer );
+
+        for( i = 0; i < tl_count - 1; i++ )
+            hullbuf[nout++] = (int)(pointer[tl_stack[i]] - data0);
+        for( i = tr_count - 1; i > 0; i-- )
+            hullbuf[nout++] = (int)(pointer[tr_stack[i]] - data0);
+        int stop_idx = tr_count > 2 ? tr_stack[1] : tl_count > 2 ? tl_stack[tl_count - 2] : -1;
+
+        /* lower half */
+        int *bl_stack = stack;
+        int bl_count = sklansky( pointer, 0, miny_ind, bl_stack, 1, -1 );
+        int *br_stack = stack + bl_count;
+        int br_count = sklansky( pointer, total - 1, miny_ind, br_stack, 1, 1 );
+
+        if( clockwise )
+        {
+            std::swap( bl_stack, br_stack );
+            std::swap( bl_count, br_count );
+        }
+
+        if( stop_idx >= 0 )
+        {
+            int check_idx = bl_count > 2 ? bl_stack[1] :
+                            bl_count + br_count > 2 ? br_stack[2-bl_count] : -1;
+            if( check_idx == stop_idx || (check_idx >= 0 &&
+                pointer[check_idx]->x == pointer[stop_idx]->x &&
+                pointer[check_idx]->y == pointer[stop_idx]->y) )
+            {
+                /* if all the points lie on the same line, then
+                   the bottom part of the convex hull is the mirrored top part
+                   (except the exteme points).*/
+                bl_count = MIN( bl_count, 2 );
+                br_count = MIN( br_count, 2 );
+            }
+        }
+
+        for( i = 0; i < bl_count - 1; i++ )
+            hullbuf[nout++] = (int)(pointer[bl_stack[i]] - data0);
+        for( i = br_count - 1; i > 0; i-- )
+            hullbuf[nout++] = (int)(pointer[br_stack[i]] - data0);
     }
+
+    _hull.create(nout, 1, returnPoints ? CV_MAKETYPE(depth, 2) : CV_32S, -1, true);
+    Mat hull = _hull.getMat();
+    size_t step = !hull.isContinuous() ? hull.step[0] : hull.elemSize();
+    uchar* dst = hull.data;
+
+    if( returnPoints )
+        for( i = 0; i < nout; i++, dst += step )
+            *(CvPoint*)dst = data0[hullbuf[i]];
+    else
+        for( i = 0; i < nout; i++, dst += step )
+            *(int*)dst = hullbuf[i];
 }
 
 
@@ -223,29 +334,21 @@ cvConvexHull2( const CvArr* array, void* hull_storage,
                int orientation, int return_points )
 {
     union { CvContour* c; CvSeq* s; } hull;
-    cv::AutoBuffer<CvPoint*> _pointer;
-    CvPoint** pointer;
-    CvPoint2D32f** pointerf = 0;
-    cv::AutoBuffer<int> _stack;
-    int* stack;
+    cv::AutoBuffer<CvPoint> _ptbuf;
+    const CvPoint* data;
+    std::vector<int> hullidx;
 
     hull.s = 0;
 
     CvMat* mat = 0;
-    CvSeqReader reader;
     CvSeqWriter writer;
     CvContour contour_header;
     union { CvContour c; CvSeq s; } hull_header;
     CvSeqBlock block, hullblock;
     CvSeq* ptseq = 0;
     CvSeq* hullseq = 0;
-    int is_float;
-    int* t_stack;
-    int t_count;
-    int i, miny_ind = 0, maxy_ind = 0, total;
+    int i, total, nidx;
     int hulltype;
-    int stop_idx;
-    sklansky_func sklansky;
 
     if( CV_IS_SEQ( array ))
     {
@@ -313,164 +416,42 @@ cvConvexHull2( const CvArr* array, void* hull_storage,
         return hull.s;
     }
 
-    cvStartAppendToSeq( hullseq, &writer );
-
-    is_float = CV_SEQ_ELTYPE(ptseq) == CV_32FC2;
-    hulltype = CV_SEQ_ELTYPE(hullseq);
-    sklansky = !is_float ? (sklansky_func)icvSklansky_32s :
-                           (sklansky_func)icvSklansky_32f;
-
-    _pointer.allocate( ptseq->total );
-    _stack.allocate( ptseq->total + 2);
-    pointer = _pointer;
-    pointerf = (CvPoint2D32f**)pointer;
-    stack = _stack;
-
-    cvStartReadSeq( ptseq, &reader );
-
-    for( i = 0; i < total; i++ )
-    {
-        pointer[i] = (CvPoint*)reader.ptr;
-        CV_NEXT_SEQ_ELEM( ptseq->elem_size, reader );
-    }
-
-    // sort the point set by x-coordinate, find min and max y
-    if( !is_float )
-    {
-        icvSortPointsByPointers_32s( pointer, total, 0 );
-        for( i = 1; i < total; i++ )
-        {
-            int y = pointer[i]->y;
-            if( pointer[miny_ind]->y > y )
-                miny_ind = i;
-            if( pointer[maxy_ind]->y < y )
-                maxy_ind = i;
-        }
-    }
+    // cv::convexHull needs the points in a single array
+    if( ptseq->first->next == ptseq->first )
+        data = (const CvPoint*)ptseq->first->data;
     else
     {
-        icvSortPointsByPointers_32f( pointerf, total, 0 );
-        for( i = 1; i < total; i++ )
-        {
-            float y = pointerf[i]->y;
-            if( pointerf[miny_ind]->y > y )
-                miny_ind = i;
-            if( pointerf[maxy_ind]->y < y )
-                maxy_ind = i;
-        }
+        _ptbuf.allocate( total );
+        data = _ptbuf;
+        cvCvtSeqToArray( ptseq, _ptbuf );
     }
 
-    if( pointer[0]->x == pointer[total-1]->x &&
-        pointer[0]->y == pointer[total-1]->y )
-    {
-        if( hulltype == CV_SEQ_ELTYPE_PPOINT )
-        {
-            CV_WRITE_SEQ_ELEM( pointer[0], writer );
-        }
-        else if( hulltype == CV_SEQ_ELTYPE_INDEX )
-        {
-            int index = 0;
-            CV_WRITE_SEQ_ELEM( index, writer );
-        }
-        else
-        {
-            CvPoint pt = pointer[0][0];
-            CV_WRITE_SEQ_ELEM( pt, writer );
-        }
-        goto finish_hull;
-    }
-
-    /*upper half */
-    {
-        int *tl_stack = stack;
-        int tl_count = sklansky( pointer, 0, maxy_ind, tl_stack, -1, 1 );
-        int *tr_stack = tl_stack + tl_count;
-        int tr_count = sklansky( pointer, ptseq->total - 1, maxy_ind, tr_stack, -1, -1 );
-
-        /* gather upper part of convex hull to output */
-        if( orientation == CV_COUNTER_CLOCKWISE )
-        {
-            CV_SWAP( tl_stack, tr_stack, t_stack );
-            CV_SWAP( tl_count, tr_count, t_count );
-        }
-
-        if( hulltype == CV_SEQ_ELTYPE_PPOINT )
-        {
-            for( i = 0; i < tl_count - 1; i++ )
-                CV_WRITE_SEQ_ELEM( pointer[tl_stack[i]], writer );
-
-            for( i = tr_count - 1; i > 0; i-- )
-                CV_WRITE_SEQ_ELEM( pointer[tr_stack[i]], writer );
-        }
-        else if( hulltype == CV_SEQ_ELTYPE_INDEX )
-        {
-            icvCalcAndWritePtIndices( pointer, tl_stack, 0, tl_count-1, ptseq, &writer );
-            icvCalcAndWritePtIndices( pointer, tr_stack, tr_count-1, 0, ptseq, &writer );
-        }
-        else
-        {
-            for( i = 0; i < tl_count - 1; i++ )
-                CV_WRITE_SEQ_ELEM( pointer[tl_stack[i]][0], writer );
+    cv::convexHull( cv::Mat( total, 1, CV_SEQ_ELTYPE(ptseq), (void*)data ), hullidx,
+                    orientation != CV_COUNTER_CLOCKWISE, false );
+    nidx = (int)hullidx.size();
+    hulltype = CV_SEQ_ELTYPE(hullseq);
 
-            for( i = tr_count - 1; i > 0; i-- )
-                CV_WRITE_SEQ_ELEM( pointer[tr_stack[i]][0], writer );
-        }
-        stop_idx = tr_count > 2 ? tr_stack[1] : tl_count > 2 ? tl_stack[tl_count - 2] : -1;
-    }
+    cvStartAppendToSeq( hullseq, &writer );
 
-    /* lower half */
+    for( i = 0; i < nidx; i++ )
     {
-        int *bl_stack = stack;
-        int bl_count = sklansky( pointer, 0, miny_ind, bl_stack, 1, -1 );
-        int *br_stack = stack + bl_count;
-        int br_count = sklansky( pointer, ptseq->total - 1, miny_ind, br_stack, 1, 1 );
-
-        if( orientation != CV_COUNTER_CLOCKWISE )
-        {
-            CV_SWAP( bl_stack, br_stack, t_stack );
-            CV_SWAP( bl_count, br_count, t_count );
-        }
-
-        if( stop_idx >= 0 )
-        {
-            int check_idx = bl_count > 2 ? bl_stack[1] :
-                            bl_count + br_count > 2 ? br_stack[2-bl_count] : -1;
-            if( check_idx == stop_idx || (check_idx >= 0 &&
-                pointer[check_idx]->x == pointer[stop_idx]->x &&
-                pointer[check_idx]->y == pointer[stop_idx]->y) )
-            {
-                /* if all the points lie on the same line, then
-                   the bottom part of the convex hull is the mirrored top part
-                   (except the exteme points).*/
-                bl_count = MIN( bl_count, 2 );
-                br_count = MIN( br_count, 2 );
-            }
-        }
-
+        int index = hullidx[i];
         if( hulltype == CV_SEQ_ELTYPE_PPOINT )
         {
-            for( i = 0; i < bl_count - 1; i++ )
-                CV_WRITE_SEQ_ELEM( pointer[bl_stack[i]], writer );
-
-            for( i = br_count - 1; i > 0; i-- )
-                CV_WRITE_SEQ_ELEM( pointer[br_stack[i]], writer );
+            CvPoint* pt = (CvPoint*)cvGetSeqElem( ptseq, index );
+            CV_WRITE_SEQ_ELEM( pt, writer );
         }
         else if( hulltype == CV_SEQ_ELTYPE_INDEX )
         {
-            icvCalcAndWritePtIndices( pointer, bl_stack, 0, bl_count-1, ptseq, &writer );
-            icvCalcAndWritePtIndices( pointer, br_stack, br_count-1, 0, ptseq, &writer );
+            CV_WRITE_SEQ_ELEM( index, writer );
         }
         else
         {
-            for( i = 0; i < bl_count - 1; i++ )
-                CV_WRITE_SEQ_ELEM( pointer[bl_stack[i]][0], writer );
-
-            for( i = br_count - 1; i > 0; i-- )
-                CV_WRITE_SEQ_ELEM( pointer[br_stack[i]][0], writer );
+            CvPoint pt = data[index];
+            CV_WRITE_SEQ_ELEM( pt, writer );
         }
     }
 
-finish_hull:
     cvEndWriteSeq( &writer );
 
     if( mat )
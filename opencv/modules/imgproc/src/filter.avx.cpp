@@ -0,0 +1,168 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX versions of the floating-point row and column filters used by FilterEngine.
+   The operations are done in the same order as in the SSE code (filter.cpp),
+   so the results are bit-exact. */
+
+#include "precomp.hpp"
+
+#if CV_AVX
+
+namespace cv
+{
+namespace opt_AVX
+{
+
+int rowFilter32f( const float* _src, const float* kx, int ksize, float* dst, int width, int cn )
+{
+    int i = 0, k;
+
+    for( ; i <= width - 16; i += 16 )
+    {
+        const float* src = _src + i;
+        __m256 f, s0 = _mm256_setzero_ps(), s1 = s0;
+        for( k = 0; k < ksize; k++, src += cn )
+        {
+            f = _mm256_set1_ps(kx[k]);
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(src), f));
+            s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(src + 8), f));
+        }
+        _mm256_storeu_ps(dst + i, s0);
+        _mm256_storeu_ps(dst + i + 8, s1);
+    }
+
+    for( ; i <= width - 8; i += 8 )
+    {
+        const float* src = _src + i;
+        __m256 s0 = _mm256_setzero_ps();
+        for( k = 0; k < ksize; k++, src += cn )
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(src), _mm256_set1_ps(kx[k])));
+        _mm256_storeu_ps(dst + i, s0);
+    }
+
+    return i;
+}
+
+int symmColumnFilter32f( const float** src, const float* ky, int ksize2,
+                         float* dst, int width, float delta, bool symmetrical )
+{
+    int i = 0, k;
+    const float *S, *S2;
+    __m256 d8 = _mm256_set1_ps(delta);
+
+    if( symmetrical )
+    {
+        for( ; i <= width - 16; i += 16 )
+        {
+            __m256 f = _mm256_set1_ps(ky[0]);
+            S = src[0] + i;
+            __m256 s0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(S), f), d8);
+            __m256 s1 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(S + 8), f), d8);
+
+            for( k = 1; k <= ksize2; k++ )
+            {
+                S = src[k] + i;
+                S2 = src[-k] + i;
+                f = _mm256_set1_ps(ky[k]);
+                __m256 x0 = _mm256_add_ps(_mm256_loadu_ps(S), _mm256_loadu_ps(S2));
+                __m256 x1 = _mm256_add_ps(_mm256_loadu_ps(S + 8), _mm256_loadu_ps(S2 + 8));
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(x0, f));
+                s1 = _mm256_add_ps(s1, _mm256_mul_ps(x1, f));
+            }
+
+            _mm256_storeu_ps(dst + i, s0);
+            _mm256_storeu_ps(dst + i + 8, s1);
+        }
+
+        for( ; i <= width - 8; i += 8 )
+        {
+            __m256 s0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src[0] + i),
+                                                    _mm256_set1_ps(ky[0])), d8);
+            for( k = 1; k <= ksize2; k++ )
+            {
+                __m256 x0 = _mm256_add_ps(_mm256_loadu_ps(src[k] + i), _mm256_loadu_ps(src[-k] + i));
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(x0, _mm256_set1_ps(ky[k])));
+            }
+            _mm256_storeu_ps(dst + i, s0);
+        }
+    }
+    else
+    {
+        for( ; i <= width - 16; i += 16 )
+        {
+            __m256 s0 = d8, s1 = d8;
+
+            for( k = 1; k <= ksize2; k++ )
+            {
+                S = src[k] + i;
+                S2 = src[-k] + i;
+                __m256 f = _mm256_set1_ps(ky[k]);
+                __m256 x0 = _mm256_sub_ps(_mm256_loadu_ps(S), _mm256_loadu_ps(S2));
+                __m256 x1 = _mm256_sub_ps(_mm256_loadu_ps(S + 8), _mm256_loadu_ps(S2 + 8));
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(x0, f));
+                s1 = _mm256_add_ps(s1, _mm256_mul_ps(x1, f));
+            }
+
+            _mm256_storeu_ps(dst + i, s0);
+            _mm256_storeu_ps(dst + i + 8, s1);
+        }
+
+        for( ; i <= width - 8; i += 8 )
+        {
+            __m256 s0 = d8;
+            for( k = 1; k <= ksize2; k++ )
+            {
+                __m256 x0 = _mm256_sub_ps(_mm256_loadu_ps(src[k] + i), _mm256_loadu_ps(src[-k] + i));
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(x0, _mm256_set1_ps(ky[k])));
+            }
+            _mm256_storeu_ps(dst + i, s0);
+        }
+    }
+
+    return i;
+}
+
+}
+}
+
+#endif
@@ -99,10 +99,12 @@ BaseRowFilter::~BaseRowFilter() {}
 BaseColumnFilter::BaseColumnFilter() { ksize = anchor = -1; }
 BaseColumnFilter::~BaseColumnFilter() {}
 void BaseColumnFilter::reset() {}
+Ptr<BaseColumnFilter> BaseColumnFilter::clone() const { return Ptr<BaseColumnFilter>(); }
 
 BaseFilter::BaseFilter() { ksize = Size(-1,-1); anchor = Point(-1,-1); }
 BaseFilter::~BaseFilter() {}
 void BaseFilter::reset() {}
+Ptr<BaseFilter> BaseFilter::clone() const { return Ptr<BaseFilter>(); }
 
 FilterEngine::FilterEngine()
 {
@@ -429,19 +431,104 @@ int FilterEngine::proceed( const uchar* src, int srcstep, int count,
 }
 
 
+static int numFilterStripes = 0;
+
+void setNumFilterStripes(int nstripes)
+{
+    numFilterStripes = std::max(nstripes, 0);
+}
+
+int getNumFilterStripes()
+{
+    return numFilterStripes;
+}
+
+/*
+   Processes a horizontal stripe of the ROI with a copy of the engine. The copy is started
+   on the stripe within the whole source image, so it takes the rows above and below the stripe
+   from the image and interpolates only the rows outside of the image, just like the serial code.
+   The row filters are stateless and are shared by the copies.
+*/
+class FilterStripeBody
+{
+public:
+    FilterStripeBody(const FilterEngine& _engine, const Mat& _src, Mat& _dst, Size _wholeSize,
+                     Rect _roi, Point _ofs, Point _dstOfs, int _nstripes)
+        : engine(&_engine), src(&_src), dst(&_dst), wholeSize(_wholeSize),
+        roi(_roi), ofs(_ofs), dstOfs(_dstOfs), nstripes(_nstripes) {}
+
+    void operator()(const BlockedRange& range) const
+    {
+        for( int i = range.begin(); i < range.end(); i++ )
+        {
+            int y0 = (int)((int64)roi.height*i/nstripes);
+            int y1 = (int)((int64)roi.height*(i+1)/nstripes);
+            if( y0 >= y1 )
+                continue;
+
+            FilterEngine e(*engine);
+            if( e.isSeparable() )
+                e.columnFilter = engine->columnFilter->clone();
+            else
+                e.filter2D = engine->filter2D->clone();
+            int y = e.start(wholeSize, Rect(roi.x, roi.y + y0, roi.width, y1 - y0)) - ofs.y;
+            e.proceed( src->data + y*src->step, (int)src->step, e.endY - e.startY,
+                       dst->data + (dstOfs.y + y0)*dst->step + dstOfs.x*dst->elemSize(), (int)dst->step );
+        }
+    }
+
+protected:
+    const FilterEngine* engine;
+    const Mat* src;
+    Mat* dst;
+    Size wholeSize;
+    Rect roi;
+    Point ofs, dstOfs;
+    int nstripes;
+};
+
 void FilterEngine::apply(const Mat& src, Mat& dst,
     const Rect& _srcRoi, Point dstOfs, bool isolated)
 {
+    CV_TRACE_REGION("cv::FilterEngine::apply");
     CV_Assert( src.type() == srcType && dst.type() == dstType );
     
     Rect srcRoi = _srcRoi;
     if( srcRoi == Rect(0,0,-1,-1) )
         srcRoi = Rect(0,0,src.cols,src.rows);
 
+    CV_TRACE_BYTES(srcRoi.area()*src.elemSize());
     CV_Assert( dstOfs.x >= 0 && dstOfs.y >= 0 &&
         dstOfs.x + srcRoi.width <= dst.cols &&
         dstOfs.y + srcRoi.height <= dst.rows );
 
+    int nstripes = numFilterStripes;
+    if( nstripes == 0 )
+    {
+        // a stripe should be large enough to amortize the rows filtered twice at its borders
+        const int MIN_STRIPE_AREA = 1 << 15;
+        nstripes = std::min(getNumThreads(), srcRoi.area()/MIN_STRIPE_AREA);
+        nstripes = std::min(nstripes, srcRoi.height/std::max(ksize.height*2, 8));
+    }
+    nstripes = std::min(nstripes, srcRoi.height);
+
+    // the stripes may not write the rows that the neighbour stripes still have to read
+    if( nstripes > 1 && dst.dataend > src.datastart && src.dataend > dst.datastart )
+        nstripes = 1;
+    if( nstripes > 1 && (isSeparable() ? columnFilter->clone().empty() : filter2D->clone().empty()) )
+        nstripes = 1;
+
+    if( nstripes > 1 )
+    {
+        Point ofs;
+        Size wholeSize(src.cols, src.rows);
+        if( !isolated )
+            src.locateROI( wholeSize, ofs );
+        parallel_for(BlockedRange(0, nstripes),
+                     FilterStripeBody(*this, src, dst, wholeSize, srcRoi + ofs, ofs, dstOfs, nstripes));
+        return;
+    }
+
     int y = start(src, srcRoi, isolated);
     proceed( src.data + y*src.step, (int)src.step, endY - startY,
              dst.data + dstOfs.y*dst.step + dstOfs.x*dst.elemSize(), (int)dst.step );
@@ -1254,6 +1341,11 @@ struct RowVec_32f
         const float* _kx = (const float*)kernel.data;
         width *= cn;
 
+    #ifdef HAVE_DISPATCH_AVX
+        if( checkHardwareSupport(CV_CPU_AVX) )
+            return opt_AVX::rowFilter32f((const float*)_src, _kx, _ksize, dst, width, cn);
+    #endif
+
         for( ; i <= width - 8; i += 8 )
         {
             const float* src = (const float*)_src + i;
@@ -1496,6 +1588,12 @@ struct SymmColumnVec_32f
         float* dst = (float*)_dst;
         __m128 d4 = _mm_set1_ps(delta);
 
+    #ifdef HAVE_DISPATCH_AVX
+        // the remaining 4 columns, if any, are processed by the SSE code below
+        if( checkHardwareSupport(CV_CPU_AVX) )
+            i = opt_AVX::symmColumnFilter32f(src, ky, ksize2, dst, width, delta, symmetrical);
+    #endif
+
         if( symmetrical )
         {
             for( ; i <= width - 16; i += 16 )
@@ -2210,6 +2308,8 @@ template<class CastOp, class VecOp> struct ColumnFilter : public BaseColumnFilte
                    (kernel.rows == 1 || kernel.cols == 1));
     }
 
+    Ptr<BaseColumnFilter> clone() const { return new ColumnFilter(*this); }
+
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
     {
         const ST* ky = (const ST*)kernel.data;
@@ -2272,6 +2372,8 @@ template<class CastOp, class VecOp> struct SymmColumnFilter : public ColumnFilte
         CV_Assert( (symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL)) != 0 );
     }
 
+    Ptr<BaseColumnFilter> clone() const { return new SymmColumnFilter(*this); }
+
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
     {
         int ksize2 = this->ksize/2;
@@ -2378,6 +2480,8 @@ struct SymmColumnSmallFilter : public SymmColumnFilter<CastOp, VecOp>
         CV_Assert( this->ksize == 3 );
     }
 
+    Ptr<BaseColumnFilter> clone() const { return new SymmColumnSmallFilter(*this); }
+
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
     {
         int ksize2 = this->ksize/2;
@@ -2819,6 +2923,8 @@ template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFi
         ptrs.resize( coords.size() );
     }
 
+    Ptr<BaseFilter> clone() const { return new Filter2D(*this); }
+
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width, int cn)
     {
         KT _delta = delta;
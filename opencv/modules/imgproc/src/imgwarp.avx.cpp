@@ -0,0 +1,115 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX versions of the map conversion done by remap for the floating-point maps:
+   the coordinates are scaled by INTER_TAB_SIZE, rounded, and split into
+   the integer part (XY) and the interpolation table index (A). */
+
+#include "precomp.hpp"
+
+#if CV_AVX
+
+namespace cv
+{
+namespace opt_AVX
+{
+
+int remapConvertMaps32f( const float* sX, const float* sY, short* XY, ushort* A, int width )
+{
+    int x = 0;
+    __m256 scale = _mm256_set1_ps((float)INTER_TAB_SIZE);
+    __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
+
+    for( ; x <= width - 8; x += 8 )
+    {
+        __m256i ix = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(sX + x), scale));
+        __m256i iy = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(sY + x), scale));
+        __m128i ix0 = _mm256_castsi256_si128(ix), ix1 = _mm256_extractf128_si256(ix, 1);
+        __m128i iy0 = _mm256_castsi256_si128(iy), iy1 = _mm256_extractf128_si256(iy, 1);
+
+        __m128i mx = _mm_packs_epi32(_mm_and_si128(ix0, mask), _mm_and_si128(ix1, mask));
+        __m128i my = _mm_packs_epi32(_mm_and_si128(iy0, mask), _mm_and_si128(iy1, mask));
+        _mm_storeu_si128((__m128i*)(A + x), _mm_or_si128(mx, _mm_slli_epi16(my, INTER_BITS)));
+
+        ix0 = _mm_packs_epi32(_mm_srai_epi32(ix0, INTER_BITS), _mm_srai_epi32(ix1, INTER_BITS));
+        iy0 = _mm_packs_epi32(_mm_srai_epi32(iy0, INTER_BITS), _mm_srai_epi32(iy1, INTER_BITS));
+        _mm_storeu_si128((__m128i*)(XY + x*2), _mm_unpacklo_epi16(ix0, iy0));
+        _mm_storeu_si128((__m128i*)(XY + x*2 + 8), _mm_unpackhi_epi16(ix0, iy0));
+    }
+
+    return x;
+}
+
+int remapConvertMaps32fc2( const float* sXY, short* XY, ushort* A, int width )
+{
+    int x = 0;
+    __m256 scale = _mm256_set1_ps((float)INTER_TAB_SIZE);
+    __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
+    // (fx, fy) pairs -> fx + fy*INTER_TAB_SIZE
+    __m128i tabstep = _mm_set1_epi32((INTER_TAB_SIZE << 16) | 1);
+
+    for( ; x <= width - 8; x += 8 )
+    {
+        __m256i i0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(sXY + x*2), scale));
+        __m256i i1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(sXY + x*2 + 8), scale));
+        __m128i v0 = _mm256_castsi256_si128(i0), v1 = _mm256_extractf128_si256(i0, 1);
+        __m128i v2 = _mm256_castsi256_si128(i1), v3 = _mm256_extractf128_si256(i1, 1);
+
+        __m128i f0 = _mm_packs_epi32(_mm_and_si128(v0, mask), _mm_and_si128(v1, mask));
+        __m128i f1 = _mm_packs_epi32(_mm_and_si128(v2, mask), _mm_and_si128(v3, mask));
+        f0 = _mm_madd_epi16(f0, tabstep);
+        f1 = _mm_madd_epi16(f1, tabstep);
+        _mm_storeu_si128((__m128i*)(A + x), _mm_packs_epi32(f0, f1));
+
+        v0 = _mm_packs_epi32(_mm_srai_epi32(v0, INTER_BITS), _mm_srai_epi32(v1, INTER_BITS));
+        v2 = _mm_packs_epi32(_mm_srai_epi32(v2, INTER_BITS), _mm_srai_epi32(v3, INTER_BITS));
+        _mm_storeu_si128((__m128i*)(XY + x*2), v0);
+        _mm_storeu_si128((__m128i*)(XY + x*2 + 8), v2);
+    }
+
+    return x;
+}
+
+}
+}
+
+#endif
@@ -240,10 +240,12 @@ template<typename ST, typename DT, int bits> struct FixedPtCast
 *                                         Resize                                         *
 \****************************************************************************************/
 
+/* ssize is the size of the whole source image. src and dst may contain only a horizontal band of it
+   (and of the whole destination image): sy0 and dy0 are the indices of their first rows */
 static void
-resizeNN( const Mat& src, Mat& dst, double fx, double fy )
+resizeNN( const Mat& src, Mat& dst, double fx, double fy, Size ssize, int sy0=0, int dy0=0 )
 {
-    Size ssize = src.size(), dsize = dst.size();
+    Size dsize = dst.size();
     AutoBuffer<int> _x_ofs(dsize.width);
     int* x_ofs = _x_ofs;
     int pix_size = (int)src.elemSize();
@@ -260,7 +262,7 @@ resizeNN( const Mat& src, Mat& dst, double fx, double fy )
     for( y = 0; y < dsize.height; y++ )
     {
         uchar* D = dst.data + dst.step*y;
-        int sy = std::min(cvFloor(y*ify), ssize.height-1);
+        int sy = std::min(cvFloor((y + dy0)*ify), ssize.height-1) - sy0;
         const uchar* S = src.data + src.step*sy;
 
         switch( pix_size )
@@ -340,6 +342,17 @@ struct HResizeNoVec
         const uchar*, int, int, int, int, int) const { return 0; }
 };
 
+struct HResizeCubicNoVec
+{
+    int operator()(const uchar*, uchar*, const int*, const uchar*, int dx, int, int) const { return dx; }
+};
+
+struct ResizeAreaFastNoVec
+{
+    ResizeAreaFastNoVec(int, int, int, int) {}
+    int operator()(const void*, void*, int) const { return 0; }
+};
+
 #if CV_SSE2
 
 struct VResizeLinearVec_32s8u
@@ -788,6 +801,295 @@ typedef HResizeNoVec HResizeLinearVec_16s32f;
 typedef HResizeNoVec HResizeLinearVec_32f;
 typedef HResizeNoVec HResizeLinearVec_64f;
 
+template<int shiftval> struct VResizeLanczos4Vec_32f16
+{
+    int operator()(const uchar** _src, uchar* _dst, const uchar* _beta, int width ) const
+    {
+        if( !checkHardwareSupport(CV_CPU_SSE2) )
+            return 0;
+
+        const float** src = (const float**)_src;
+        const float* beta = (const float*)_beta;
+        ushort* dst = (ushort*)_dst;
+        int x = 0, k;
+        __m128 b[8];
+        __m128i preshift = _mm_set1_epi32(shiftval);
+        __m128i postshift = _mm_set1_epi16((short)shiftval);
+
+        for( k = 0; k < 8; k++ )
+            b[k] = _mm_set1_ps(beta[k]);
+
+        for( ; x <= width - 8; x += 8 )
+        {
+            __m128 s0 = _mm_mul_ps(_mm_loadu_ps(src[0] + x), b[0]);
+            __m128 s1 = _mm_mul_ps(_mm_loadu_ps(src[0] + x + 4), b[0]);
+            __m128i t0, t1;
+
+            for( k = 1; k < 8; k++ )
+            {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(src[k] + x), b[k]));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(src[k] + x + 4), b[k]));
+            }
+
+            t0 = _mm_add_epi32(_mm_cvtps_epi32(s0), preshift);
+            t1 = _mm_add_epi32(_mm_cvtps_epi32(s1), preshift);
+            t0 = _mm_add_epi16(_mm_packs_epi32(t0, t1), postshift);
+            _mm_storeu_si128( (__m128i*)(dst + x), t0);
+        }
+
+        return x;
+    }
+};
+
+typedef VResizeLanczos4Vec_32f16<SHRT_MIN> VResizeLanczos4Vec_32f16u;
+typedef VResizeLanczos4Vec_32f16<0> VResizeLanczos4Vec_32f16s;
+
+struct VResizeLanczos4Vec_32f
+{
+    int operator()(const uchar** _src, uchar* _dst, const uchar* _beta, int width ) const
+    {
+        if( !checkHardwareSupport(CV_CPU_SSE) )
+            return 0;
+
+        const float** src = (const float**)_src;
+        const float* beta = (const float*)_beta;
+        float* dst = (float*)_dst;
+        int x = 0, k;
+        __m128 b[8];
+
+        for( k = 0; k < 8; k++ )
+            b[k] = _mm_set1_ps(beta[k]);
+
+        // the taps are added in the same order as in VResizeLanczos4,
+        // so the result does not depend on the alignment of the tail
+        for( ; x <= width - 8; x += 8 )
+        {
+            __m128 s0 = _mm_mul_ps(_mm_loadu_ps(src[0] + x), b[0]);
+            __m128 s1 = _mm_mul_ps(_mm_loadu_ps(src[0] + x + 4), b[0]);
+
+            for( k = 1; k < 8; k++ )
+            {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(src[k] + x), b[k]));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(src[k] + x + 4), b[k]));
+            }
+
+            _mm_storeu_ps( dst + x, s0);
+            _mm_storeu_ps( dst + x + 4, s1);
+        }
+
+        return x;
+    }
+};
+
+struct VResizeLanczos4Vec_32s8u
+{
+    int operator()(const uchar** _src, uchar* dst, const uchar* _beta, int width ) const
+    {
+        if( !checkHardwareSupport(CV_CPU_SSE2) )
+            return 0;
+
+        const int** src = (const int**)_src;
+        const short* beta = (const short*)_beta;
+        int x = 0, k;
+        float scale = 1.f/(INTER_RESIZE_COEF_SCALE*INTER_RESIZE_COEF_SCALE);
+        __m128 b[8];
+
+        for( k = 0; k < 8; k++ )
+            b[k] = _mm_set1_ps(beta[k]*scale);
+
+        for( ; x <= width - 8; x += 8 )
+        {
+            __m128 s0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src[0] + x))), b[0]);
+            __m128 s1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src[0] + x + 4))), b[0]);
+            __m128i x0, x1;
+
+            for( k = 1; k < 8; k++ )
+            {
+                x0 = _mm_loadu_si128((const __m128i*)(src[k] + x));
+                x1 = _mm_loadu_si128((const __m128i*)(src[k] + x + 4));
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_cvtepi32_ps(x0), b[k]));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_cvtepi32_ps(x1), b[k]));
+            }
+
+            x0 = _mm_packs_epi32(_mm_cvtps_epi32(s0), _mm_cvtps_epi32(s1));
+            _mm_storel_epi64( (__m128i*)(dst + x), _mm_packus_epi16(x0, x0));
+        }
+
+        return x;
+    }
+};
+
+/*
+   The inner part [xmin, xmax) of the horizontal bicubic pass for 8-bit images, where all the 4 taps
+   are inside the row. The pixels are multiplied by the fixed-point coefficients with _mm_madd_epi16,
+   so the integer sums are exactly the same as in HResizeCubic.
+*/
+struct HResizeCubicVec_8u32s
+{
+    int operator()(const uchar* S, uchar* _D, const int* xofs, const uchar* _alpha,
+                   int dx, int xmax, int cn) const
+    {
+        if( (cn != 1 && cn != 4) || !checkHardwareSupport(CV_CPU_SSE2) )
+            return dx;
+
+        int* D = (int*)_D;
+        const short* alpha = (const short*)_alpha;
+        __m128i z = _mm_setzero_si128();
+
+        if( cn == 1 )
+        {
+            for( ; dx <= xmax - 4; dx += 4, alpha += 16 )
+            {
+                __m128i p0 = _mm_cvtsi32_si128(*(const int*)(S + xofs[dx] - 1));
+                __m128i p1 = _mm_cvtsi32_si128(*(const int*)(S + xofs[dx+1] - 1));
+                __m128i p2 = _mm_cvtsi32_si128(*(const int*)(S + xofs[dx+2] - 1));
+                __m128i p3 = _mm_cvtsi32_si128(*(const int*)(S + xofs[dx+3] - 1));
+                p0 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(p0, p1), z);
+                p2 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(p2, p3), z);
+                p0 = _mm_madd_epi16(p0, _mm_loadu_si128((const __m128i*)alpha));
+                p2 = _mm_madd_epi16(p2, _mm_loadu_si128((const __m128i*)(alpha + 8)));
+
+                // p0 = (t01, t23) for dx and dx+1, p2 - for dx+2 and dx+3
+                __m128 e = _mm_shuffle_ps(_mm_castsi128_ps(p0), _mm_castsi128_ps(p2), _MM_SHUFFLE(2,0,2,0));
+                __m128 o = _mm_shuffle_ps(_mm_castsi128_ps(p0), _mm_castsi128_ps(p2), _MM_SHUFFLE(3,1,3,1));
+                _mm_storeu_si128((__m128i*)(D + dx), _mm_add_epi32(_mm_castps_si128(e), _mm_castps_si128(o)));
+            }
+        }
+        else
+        {
+            // all 4 channels of a pixel share the coefficients; a pair of taps is interleaved
+            // channel by channel, so that _mm_madd_epi16 adds up the two taps of each channel
+            for( ; dx <= xmax - 4; dx += 4, alpha += 16 )
+            {
+                __m128i p = _mm_loadu_si128((const __m128i*)(S + xofs[dx] - 4));
+                __m128i p01 = _mm_unpacklo_epi8(p, z), p23 = _mm_unpackhi_epi8(p, z);
+                __m128i a01 = _mm_set1_epi32(*(const int*)alpha);
+                __m128i a23 = _mm_set1_epi32(*(const int*)(alpha + 2));
+                p01 = _mm_madd_epi16(_mm_unpacklo_epi16(p01, _mm_srli_si128(p01, 8)), a01);
+                p23 = _mm_madd_epi16(_mm_unpacklo_epi16(p23, _mm_srli_si128(p23, 8)), a23);
+                _mm_storeu_si128((__m128i*)(D + dx), _mm_add_epi32(p01, p23));
+            }
+        }
+
+        return dx;
+    }
+};
+
+/*
+   2x2 decimation for INTER_AREA. The 8-bit sums are rounded to the nearest even integer
+   (sum + 1 + ((sum >> 2) & 1)) >> 2, which is what saturate_cast<uchar>(sum*0.25f) gives.
+*/
+struct ResizeAreaFastVec_8u
+{
+    ResizeAreaFastVec_8u(int scale_x, int scale_y, int _cn, int _step) : cn(_cn), step(_step)
+    {
+        fast = scale_x == 2 && scale_y == 2 && (cn == 1 || cn == 4) &&
+            checkHardwareSupport(CV_CPU_SSE2);
+    }
+
+    int operator()(const uchar* S0, uchar* D, int w) const
+    {
+        if( !fast )
+            return 0;
+
+        const uchar* S1 = S0 + step;
+        int dx = 0;
+        __m128i z = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+
+        if( cn == 1 )
+        {
+            __m128i lomask = _mm_set1_epi16(255);
+            for( ; dx <= w - 16; dx += 16 )
+            {
+                __m128i r0 = _mm_loadu_si128((const __m128i*)(S0 + dx*2));
+                __m128i r1 = _mm_loadu_si128((const __m128i*)(S1 + dx*2));
+                __m128i r2 = _mm_loadu_si128((const __m128i*)(S0 + dx*2 + 16));
+                __m128i r3 = _mm_loadu_si128((const __m128i*)(S1 + dx*2 + 16));
+                __m128i s0 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(r0, lomask), _mm_srli_epi16(r0, 8)),
+                                           _mm_add_epi16(_mm_and_si128(r1, lomask), _mm_srli_epi16(r1, 8)));
+                __m128i s1 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(r2, lomask), _mm_srli_epi16(r2, 8)),
+                                           _mm_add_epi16(_mm_and_si128(r3, lomask), _mm_srli_epi16(r3, 8)));
+                s0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s0, one), _mm_and_si128(_mm_srli_epi16(s0, 2), one)), 2);
+                s1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s1, one), _mm_and_si128(_mm_srli_epi16(s1, 2), one)), 2);
+                _mm_storeu_si128((__m128i*)(D + dx), _mm_packus_epi16(s0, s1));
+            }
+        }
+        else
+        {
+            for( ; dx <= w - 16; dx += 16 )
+            {
+                __m128i r0 = _mm_loadu_si128((const __m128i*)(S0 + dx*2));
+                __m128i r1 = _mm_loadu_si128((const __m128i*)(S1 + dx*2));
+                __m128i r2 = _mm_loadu_si128((const __m128i*)(S0 + dx*2 + 16));
+                __m128i r3 = _mm_loadu_si128((const __m128i*)(S1 + dx*2 + 16));
+                __m128i a0 = _mm_add_epi16(_mm_unpacklo_epi8(r0, z), _mm_unpacklo_epi8(r1, z));
+                __m128i a1 = _mm_add_epi16(_mm_unpackhi_epi8(r0, z), _mm_unpackhi_epi8(r1, z));
+                __m128i a2 = _mm_add_epi16(_mm_unpacklo_epi8(r2, z), _mm_unpacklo_epi8(r3, z));
+                __m128i a3 = _mm_add_epi16(_mm_unpackhi_epi8(r2, z), _mm_unpackhi_epi8(r3, z));
+                __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi64(a0, a1), _mm_unpackhi_epi64(a0, a1));
+                __m128i s1 = _mm_add_epi16(_mm_unpacklo_epi64(a2, a3), _mm_unpackhi_epi64(a2, a3));
+                s0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s0, one), _mm_and_si128(_mm_srli_epi16(s0, 2), one)), 2);
+                s1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(s1, one), _mm_and_si128(_mm_srli_epi16(s1, 2), one)), 2);
+                _mm_storeu_si128((__m128i*)(D + dx), _mm_packus_epi16(s0, s1));
+            }
+        }
+
+        return dx;
+    }
+
+    int cn, step;
+    bool fast;
+};
+
+struct ResizeAreaFastVec_32f
+{
+    ResizeAreaFastVec_32f(int scale_x, int scale_y, int _cn, int _step) : cn(_cn), step(_step)
+    {
+        fast = scale_x == 2 && scale_y == 2 && (cn == 1 || cn == 4) &&
+            checkHardwareSupport(CV_CPU_SSE);
+    }
+
+    int operator()(const float* S0, float* D, int w) const
+    {
+        if( !fast )
+            return 0;
+
+        const float* S1 = (const float*)((const uchar*)S0 + step);
+        int dx = 0;
+        __m128 z = _mm_setzero_ps(), q = _mm_set1_ps(0.25f);
+
+        // (((S00 + S01) + S10) + S11) is the order of the additions in resizeAreaFast_
+        if( cn == 1 )
+        {
+            for( ; dx <= w - 4; dx += 4 )
+            {
+                __m128 r0 = _mm_loadu_ps(S0 + dx*2), r1 = _mm_loadu_ps(S0 + dx*2 + 4);
+                __m128 r2 = _mm_loadu_ps(S1 + dx*2), r3 = _mm_loadu_ps(S1 + dx*2 + 4);
+                __m128 s = _mm_add_ps(_mm_shuffle_ps(r0, r1, _MM_SHUFFLE(2,0,2,0)),
+                                      _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(3,1,3,1)));
+                s = _mm_add_ps(s, _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(2,0,2,0)));
+                s = _mm_add_ps(s, _mm_shuffle_ps(r2, r3, _MM_SHUFFLE(3,1,3,1)));
+                _mm_storeu_ps(D + dx, _mm_mul_ps(_mm_add_ps(z, s), q));
+            }
+        }
+        else
+        {
+            for( ; dx <= w - 4; dx += 4 )
+            {
+                __m128 s = _mm_add_ps(_mm_loadu_ps(S0 + dx*2), _mm_loadu_ps(S0 + dx*2 + 4));
+                s = _mm_add_ps(s, _mm_loadu_ps(S1 + dx*2));
+                s = _mm_add_ps(s, _mm_loadu_ps(S1 + dx*2 + 4));
+                _mm_storeu_ps(D + dx, _mm_mul_ps(_mm_add_ps(z, s), q));
+            }
+        }
+
+        return dx;
+    }
+
+    int cn, step;
+    bool fast;
+};
+
 #else
 
 typedef HResizeNoVec HResizeLinearVec_8u32s;
@@ -804,7 +1106,16 @@ typedef VResizeNoVec VResizeCubicVec_32s8u;
 typedef VResizeNoVec VResizeCubicVec_32f16u;
 typedef VResizeNoVec VResizeCubicVec_32f16s;
 typedef VResizeNoVec VResizeCubicVec_32f;
-    
+
+typedef VResizeNoVec VResizeLanczos4Vec_32s8u;
+typedef VResizeNoVec VResizeLanczos4Vec_32f16u;
+typedef VResizeNoVec VResizeLanczos4Vec_32f16s;
+typedef VResizeNoVec VResizeLanczos4Vec_32f;
+
+typedef HResizeCubicNoVec HResizeCubicVec_8u32s;
+typedef ResizeAreaFastNoVec ResizeAreaFastVec_8u;
+typedef ResizeAreaFastNoVec ResizeAreaFastVec_32f;
+
 #endif
 
 
@@ -894,7 +1205,7 @@ struct VResizeLinear
 };
 
 
-template<typename T, typename WT, typename AT>
+template<typename T, typename WT, typename AT, class VecOp>
 struct HResizeCubic
 {
     typedef T value_type;
@@ -905,6 +1216,7 @@ struct HResizeCubic
                     const int* xofs, const AT* alpha,
                     int swidth, int dwidth, int cn, int xmin, int xmax ) const
     {
+        VecOp vecOp;
         for( int k = 0; k < count; k++ )
         {
             const T *S = src[k];
@@ -932,7 +1244,9 @@ struct HResizeCubic
                 }
                 if( limit == dwidth )
                     break;
-                for( ; dx < xmax; dx++, alpha += 4 )
+                int dx1 = vecOp((const uchar*)S, (uchar*)D, xofs, (const uchar*)alpha, dx, xmax, cn);
+                alpha += (dx1 - dx)*4;
+                for( dx = dx1; dx < xmax; dx++, alpha += 4 )
                 {
                     int sx = xofs[dx];
                     D[dx] = S[sx-cn]*alpha[0] + S[sx]*alpha[1] +
@@ -1134,7 +1448,7 @@ static void resizeGeneric_( const Mat& src, Mat& dst,
 }
 
 
-template<typename T, typename WT>
+template<typename T, typename WT, class VecOp>
 static void resizeAreaFast_( const Mat& src, Mat& dst, const int* ofs, const int* xofs,
                              int scale_x, int scale_y )
 {
@@ -1146,6 +1460,7 @@ static void resizeAreaFast_( const Mat& src, Mat& dst, const int* ofs, const int
     int dwidth1 = (ssize.width/scale_x)*cn; 
     dsize.width *= cn;
     ssize.width *= cn;
+    VecOp vecOp(scale_x, scale_y, cn, (int)src.step);
 
     for( dy = 0; dy < dsize.height; dy++ )
     {
@@ -1158,7 +1473,8 @@ static void resizeAreaFast_( const Mat& src, Mat& dst, const int* ofs, const int
             continue;
         }
         
-        for( dx = 0; dx < w; dx++ )
+        dx = vecOp((const T*)(src.data + src.step*sy0), D, w);
+        for( ; dx < w; dx++ )
         {
             const T* S = (const T*)(src.data + src.step*sy0) + xofs[dx];
             WT sum = 0;
@@ -1202,181 +1518,529 @@ struct DecimateAlpha
     float alpha;
 };
 
-template<typename T, typename WT>
-static void resizeArea_( const Mat& src, Mat& dst, const DecimateAlpha* xofs, int xofs_count )
+/* computes the weights of the source pixels (si) in the destination pixels (di) of the area
+   decimation along one axis; the entries are sorted by di. Returns the number of entries
+   (at most ssize*2) */
+static int computeResizeAreaTab( int ssize, int dsize, int cn, double scale,
+                                 double alphaScale, DecimateAlpha* tab )
 {
-    Size ssize = src.size(), dsize = dst.size();
-    int cn = src.channels();
-    dsize.width *= cn;
-    AutoBuffer<WT> _buffer(dsize.width*2);
-    WT *buf = _buffer, *sum = buf + dsize.width;
-    int k, sy, dx, cur_dy = 0;
-    WT scale_y = (WT)ssize.height/dsize.height;
+    int k = 0;
+    for( int dx = 0; dx < dsize; dx++ )
+    {
+        double fsx1 = dx*scale, fsx2 = fsx1 + scale;
+        int sx1 = cvCeil(fsx1), sx2 = cvFloor(fsx2);
+        sx1 = std::min(sx1, ssize-1);
+        sx2 = std::min(sx2, ssize-1);
 
-    CV_Assert( cn <= 4 );
-    for( dx = 0; dx < dsize.width; dx++ )
-        buf[dx] = sum[dx] = 0;
+        if( sx1 > fsx1 )
+        {
+            assert( k < ssize*2 );
+            tab[k].di = dx*cn;
+            tab[k].si = (sx1-1)*cn;
+            tab[k++].alpha = (float)((sx1 - fsx1)*alphaScale);
+        }
 
-    for( sy = 0; sy < ssize.height; sy++ )
-    {
-        const T* S = (const T*)(src.data + src.step*sy);
-        if( cn == 1 )
-            for( k = 0; k < xofs_count; k++ )
-            {
-                int dxn = xofs[k].di;
-                WT alpha = xofs[k].alpha;
-                buf[dxn] += S[xofs[k].si]*alpha;
-            }
-        else if( cn == 2 )
-            for( k = 0; k < xofs_count; k++ )
-            {
-                int sxn = xofs[k].si;
-                int dxn = xofs[k].di;
-                WT alpha = xofs[k].alpha;
-                WT t0 = buf[dxn] + S[sxn]*alpha;
-                WT t1 = buf[dxn+1] + S[sxn+1]*alpha;
-                buf[dxn] = t0; buf[dxn+1] = t1;
-            }
-        else if( cn == 3 )
-            for( k = 0; k < xofs_count; k++ )
-            {
-                int sxn = xofs[k].si;
-                int dxn = xofs[k].di;
-                WT alpha = xofs[k].alpha;
-                WT t0 = buf[dxn] + S[sxn]*alpha;
-                WT t1 = buf[dxn+1] + S[sxn+1]*alpha;
-                WT t2 = buf[dxn+2] + S[sxn+2]*alpha;
-                buf[dxn] = t0; buf[dxn+1] = t1; buf[dxn+2] = t2;
-            }
-        else
-            for( k = 0; k < xofs_count; k++ )
-            {
-                int sxn = xofs[k].si;
-                int dxn = xofs[k].di;
-                WT alpha = xofs[k].alpha;
-                WT t0 = buf[dxn] + S[sxn]*alpha;
-                WT t1 = buf[dxn+1] + S[sxn+1]*alpha;
-                buf[dxn] = t0; buf[dxn+1] = t1;
-                t0 = buf[dxn+2] + S[sxn+2]*alpha;
-                t1 = buf[dxn+3] + S[sxn+3]*alpha;
-                buf[dxn+2] = t0; buf[dxn+3] = t1;
-            }
-
-        if( (cur_dy + 1)*scale_y <= sy + 1 || sy == ssize.height - 1 )
-        {
-            WT beta = std::max(sy + 1 - (cur_dy+1)*scale_y, (WT)0);
-            WT beta1 = 1 - beta;
-            T* D = (T*)(dst.data + dst.step*cur_dy);
-            if( fabs(beta) < 1e-3 )
-                for( dx = 0; dx < dsize.width; dx++ )
-                {
-                    D[dx] = saturate_cast<T>(sum[dx] + buf[dx]);
-                    sum[dx] = buf[dx] = 0;
-                }
-            else
-                for( dx = 0; dx < dsize.width; dx++ )
-                {
-                    D[dx] = saturate_cast<T>(sum[dx] + buf[dx]*beta1);
-                    sum[dx] = buf[dx]*beta;
-                    buf[dx] = 0;
-                }
-            cur_dy++;
+        for( int sx = sx1; sx < sx2; sx++ )
+        {
+            assert( k < ssize*2 );
+            tab[k].di = dx*cn;
+            tab[k].si = sx*cn;
+            tab[k++].alpha = (float)alphaScale;
         }
-        else
+
+        if( fsx2 - sx2 > 1e-3 )
         {
-            for( dx = 0; dx <= dsize.width - 2; dx += 2 )
-            {
-                WT t0 = sum[dx] + buf[dx];
-                WT t1 = sum[dx+1] + buf[dx+1];
-                sum[dx] = t0; sum[dx+1] = t1;
-                buf[dx] = buf[dx+1] = 0;
-            }
-            for( ; dx < dsize.width; dx++ )
-            {
-                sum[dx] += buf[dx];
-                buf[dx] = 0;
-            }
+            assert( k < ssize*2 );
+            tab[k].di = dx*cn;
+            tab[k].si = sx2*cn;
+            tab[k++].alpha = (float)((fsx2 - sx2)*alphaScale);
         }
     }
+    return k;
 }
 
+/* the number of destination rows processed by one parallel_for iteration:
+   about 64K of the source or the destination pixels, whichever is more */
+static int getResizeBandHeight( Size ssize, Size dsize, int minRows )
+{
+    double rowPixels = std::max((double)ssize.width*ssize.height/dsize.height, (double)dsize.width);
+    int bandHeight = std::max(cvFloor((1 << 16)/rowPixels), minRows);
+    return std::max(std::min(bandHeight, dsize.height), 1);
+}
 
-typedef void (*ResizeFunc)( const Mat& src, Mat& dst,
-                            const int* xofs, const void* alpha,
-                            const int* yofs, const void* beta,
-                            int xmin, int xmax, int ksize );
+/* The row operations of ResizeAreaInvoker: D = S*beta (init) or D += S*beta, A = S_0 + ... + S_{n-1}
+   and the saturating store of the sums. The generic versions do nothing, the SSE2 overloads return
+   the number of the processed elements; the rest is done by the caller */
+template<typename ST, typename WT> static inline int
+resizeAreaMulAdd_( const ST*, WT*, int, WT, bool ) { return 0; }
 
-typedef void (*ResizeAreaFastFunc)( const Mat& src, Mat& dst,
-                                    const int* ofs, const int *xofs,
-                                    int scale_x, int scale_y );
+template<typename T, typename IT> static inline int
+resizeAreaSumRows_( const T**, int, IT*, int ) { return 0; }
 
-typedef void (*ResizeAreaFunc)( const Mat& src, Mat& dst,
-                                const DecimateAlpha* xofs, int xofs_count );
+template<typename WT, typename T> static inline int
+resizeAreaStore_( const WT*, T*, int ) { return 0; }
+
+#if CV_SSE2
 
+static inline __m128 resizeAreaMulAdd4( __m128i s, float* D, __m128 b, bool init )
+{
+    __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(s), b);
+    return init ? f : _mm_add_ps(_mm_loadu_ps(D), f);
 }
-    
-//////////////////////////////////////////////////////////////////////////////////////////
 
-void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
-                 double inv_scale_x, double inv_scale_y, int interpolation )
+static inline int resizeAreaMulAdd_( const uchar* S, float* D, int n, float beta, bool init )
 {
-    static ResizeFunc linear_tab[] =
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128i z = _mm_setzero_si128();
+    __m128 b = _mm_set1_ps(beta);
+    for( ; x <= n - 16; x += 16 )
     {
-        resizeGeneric_<
-            HResizeLinear<uchar, int, short,
-                INTER_RESIZE_COEF_SCALE,
-                HResizeLinearVec_8u32s>,
-            VResizeLinear<uchar, int, short,
-                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-                VResizeLinearVec_32s8u> >,
-        0,
-        resizeGeneric_<
-            HResizeLinear<ushort, float, float, 1,
-                HResizeLinearVec_16u32f>,
-            VResizeLinear<ushort, float, float, Cast<float, ushort>,
-                VResizeLinearVec_32f16u> >,
-        resizeGeneric_<
-            HResizeLinear<short, float, float, 1,
-                HResizeLinearVec_16s32f>,
-            VResizeLinear<short, float, float, Cast<float, short>,
-                VResizeLinearVec_32f16s> >,
-		0,
-        resizeGeneric_<
-            HResizeLinear<float, float, float, 1,
-                HResizeLinearVec_32f>,
-            VResizeLinear<float, float, float, Cast<float, float>,
-                VResizeLinearVec_32f> >,
-        resizeGeneric_<
-            HResizeLinear<double, double, float, 1,
-                HResizeNoVec>,
-            VResizeLinear<double, double, float, Cast<double, double>,
-                VResizeNoVec> >,
-        0
-    };
+        __m128i r = _mm_loadu_si128((const __m128i*)(S + x));
+        __m128i lo = _mm_unpacklo_epi8(r, z), hi = _mm_unpackhi_epi8(r, z);
+        __m128 f0 = resizeAreaMulAdd4(_mm_unpacklo_epi16(lo, z), D + x, b, init);
+        __m128 f1 = resizeAreaMulAdd4(_mm_unpackhi_epi16(lo, z), D + x + 4, b, init);
+        __m128 f2 = resizeAreaMulAdd4(_mm_unpacklo_epi16(hi, z), D + x + 8, b, init);
+        __m128 f3 = resizeAreaMulAdd4(_mm_unpackhi_epi16(hi, z), D + x + 12, b, init);
+        _mm_storeu_ps(D + x, f0);
+        _mm_storeu_ps(D + x + 4, f1);
+        _mm_storeu_ps(D + x + 8, f2);
+        _mm_storeu_ps(D + x + 12, f3);
+    }
+    return x;
+}
 
-    static ResizeFunc cubic_tab[] =
+static inline int resizeAreaMulAdd_( const ushort* S, float* D, int n, float beta, bool init )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128i z = _mm_setzero_si128();
+    __m128 b = _mm_set1_ps(beta);
+    for( ; x <= n - 8; x += 8 )
     {
-        resizeGeneric_<
-            HResizeCubic<uchar, int, short>,
-            VResizeCubic<uchar, int, short,
-                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-                VResizeCubicVec_32s8u> >,
-        0,
-        resizeGeneric_<
-            HResizeCubic<ushort, float, float>,
-            VResizeCubic<ushort, float, float, Cast<float, ushort>,
-            VResizeCubicVec_32f16u> >,
-        resizeGeneric_<
-            HResizeCubic<short, float, float>,
-            VResizeCubic<short, float, float, Cast<float, short>,
-            VResizeCubicVec_32f16s> >,
-		0,
-        resizeGeneric_<
-            HResizeCubic<float, float, float>,
-            VResizeCubic<float, float, float, Cast<float, float>,
+        __m128i r = _mm_loadu_si128((const __m128i*)(S + x));
+        __m128 f0 = resizeAreaMulAdd4(_mm_unpacklo_epi16(r, z), D + x, b, init);
+        __m128 f1 = resizeAreaMulAdd4(_mm_unpackhi_epi16(r, z), D + x + 4, b, init);
+        _mm_storeu_ps(D + x, f0);
+        _mm_storeu_ps(D + x + 4, f1);
+    }
+    return x;
+}
+
+static inline int resizeAreaMulAdd_( const short* S, float* D, int n, float beta, bool init )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128 b = _mm_set1_ps(beta);
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)(S + x));
+        __m128 f0 = resizeAreaMulAdd4(_mm_srai_epi32(_mm_unpacklo_epi16(r, r), 16), D + x, b, init);
+        __m128 f1 = resizeAreaMulAdd4(_mm_srai_epi32(_mm_unpackhi_epi16(r, r), 16), D + x + 4, b, init);
+        _mm_storeu_ps(D + x, f0);
+        _mm_storeu_ps(D + x + 4, f1);
+    }
+    return x;
+}
+
+static inline int resizeAreaMulAdd_( const int* S, float* D, int n, float beta, bool init )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128 b = _mm_set1_ps(beta);
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128 f0 = resizeAreaMulAdd4(_mm_loadu_si128((const __m128i*)(S + x)), D + x, b, init);
+        __m128 f1 = resizeAreaMulAdd4(_mm_loadu_si128((const __m128i*)(S + x + 4)), D + x + 4, b, init);
+        _mm_storeu_ps(D + x, f0);
+        _mm_storeu_ps(D + x + 4, f1);
+    }
+    return x;
+}
+
+static inline int resizeAreaMulAdd_( const float* S, float* D, int n, float beta, bool init )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE) )
+        return 0;
+    int x = 0;
+    __m128 b = _mm_set1_ps(beta);
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128 f0 = _mm_mul_ps(_mm_loadu_ps(S + x), b);
+        __m128 f1 = _mm_mul_ps(_mm_loadu_ps(S + x + 4), b);
+        if( !init )
+        {
+            f0 = _mm_add_ps(_mm_loadu_ps(D + x), f0);
+            f1 = _mm_add_ps(_mm_loadu_ps(D + x + 4), f1);
+        }
+        _mm_storeu_ps(D + x, f0);
+        _mm_storeu_ps(D + x + 4, f1);
+    }
+    return x;
+}
+
+// the sums of the 8-bit rows are kept in 16 bits, so at most 257 rows may be added up at once
+static inline int resizeAreaSumRows_( const uchar** S, int nrows, ushort* A, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128i z = _mm_setzero_si128();
+    for( ; x <= n - 16; x += 16 )
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)(S[0] + x));
+        __m128i lo = _mm_unpacklo_epi8(r, z), hi = _mm_unpackhi_epi8(r, z);
+        for( int k = 1; k < nrows; k++ )
+        {
+            r = _mm_loadu_si128((const __m128i*)(S[k] + x));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(r, z));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(r, z));
+        }
+        _mm_storeu_si128((__m128i*)(A + x), lo);
+        _mm_storeu_si128((__m128i*)(A + x + 8), hi);
+    }
+    return x;
+}
+
+static inline int resizeAreaSumRows_( const ushort** S, int nrows, int* A, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128i z = _mm_setzero_si128();
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)(S[0] + x));
+        __m128i lo = _mm_unpacklo_epi16(r, z), hi = _mm_unpackhi_epi16(r, z);
+        for( int k = 1; k < nrows; k++ )
+        {
+            r = _mm_loadu_si128((const __m128i*)(S[k] + x));
+            lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(r, z));
+            hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(r, z));
+        }
+        _mm_storeu_si128((__m128i*)(A + x), lo);
+        _mm_storeu_si128((__m128i*)(A + x + 4), hi);
+    }
+    return x;
+}
+
+static inline int resizeAreaSumRows_( const short** S, int nrows, int* A, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128i r = _mm_loadu_si128((const __m128i*)(S[0] + x));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(r, r), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(r, r), 16);
+        for( int k = 1; k < nrows; k++ )
+        {
+            r = _mm_loadu_si128((const __m128i*)(S[k] + x));
+            lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(r, r), 16));
+            hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(r, r), 16));
+        }
+        _mm_storeu_si128((__m128i*)(A + x), lo);
+        _mm_storeu_si128((__m128i*)(A + x + 4), hi);
+    }
+    return x;
+}
+
+static inline int resizeAreaSumRows_( const float** S, int nrows, float* A, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE) )
+        return 0;
+    int x = 0;
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128 s0 = _mm_loadu_ps(S[0] + x), s1 = _mm_loadu_ps(S[0] + x + 4);
+        for( int k = 1; k < nrows; k++ )
+        {
+            s0 = _mm_add_ps(s0, _mm_loadu_ps(S[k] + x));
+            s1 = _mm_add_ps(s1, _mm_loadu_ps(S[k] + x + 4));
+        }
+        _mm_storeu_ps(A + x, s0);
+        _mm_storeu_ps(A + x + 4, s1);
+    }
+    return x;
+}
+
+static inline int resizeAreaStore_( const float* S, uchar* D, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    for( ; x <= n - 16; x += 16 )
+    {
+        __m128i t0 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(S + x)),
+                                     _mm_cvtps_epi32(_mm_loadu_ps(S + x + 4)));
+        __m128i t1 = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(S + x + 8)),
+                                     _mm_cvtps_epi32(_mm_loadu_ps(S + x + 12)));
+        _mm_storeu_si128((__m128i*)(D + x), _mm_packus_epi16(t0, t1));
+    }
+    return x;
+}
+
+static inline int resizeAreaStore_( const float* S, ushort* D, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    __m128i shift32 = _mm_set1_epi32(SHRT_MIN), shift16 = _mm_set1_epi16(SHRT_MIN);
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128i t0 = _mm_add_epi32(_mm_cvtps_epi32(_mm_loadu_ps(S + x)), shift32);
+        __m128i t1 = _mm_add_epi32(_mm_cvtps_epi32(_mm_loadu_ps(S + x + 4)), shift32);
+        _mm_storeu_si128((__m128i*)(D + x), _mm_add_epi16(_mm_packs_epi32(t0, t1), shift16));
+    }
+    return x;
+}
+
+static inline int resizeAreaStore_( const float* S, short* D, int n )
+{
+    if( !checkHardwareSupport(CV_CPU_SSE2) )
+        return 0;
+    int x = 0;
+    for( ; x <= n - 8; x += 8 )
+    {
+        __m128i t0 = _mm_cvtps_epi32(_mm_loadu_ps(S + x));
+        __m128i t1 = _mm_cvtps_epi32(_mm_loadu_ps(S + x + 4));
+        _mm_storeu_si128((__m128i*)(D + x), _mm_packs_epi32(t0, t1));
+    }
+    return x;
+}
+
+#endif
+
+/*
+   INTER_AREA decimation by a non-integer factor. Every destination row is built independently:
+   first the source rows it covers are added up with their vertical weights over the whole row
+   width, then the horizontal weights are applied once per destination row. The fully covered
+   rows (weight 1) are summed up in the registers, in the integer (IT) arithmetic, and only
+   the sum is converted to WT; for the integer images this is exact. This keeps the vertical
+   pass, which dominates for the large decimations, close to the memory speed.
+*/
+template<typename T, typename WT, typename IT>
+class ResizeAreaInvoker
+{
+public:
+    enum { MAX_SUM_ROWS = 256 };
+
+    ResizeAreaInvoker( const Mat& _src, Mat& _dst, const DecimateAlpha* _xtab, int _xtab_size,
+                       const DecimateAlpha* _ytab, const int* _tabofs, int _bandHeight )
+        : src(&_src), dst(&_dst), xtab(_xtab), xtab_size(_xtab_size), ytab(_ytab),
+          tabofs(_tabofs), bandHeight(_bandHeight)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        Size ssize = src->size(), dsize = dst->size();
+        int cn = src->channels();
+        int swidth = ssize.width*cn, dwidth = dsize.width*cn;
+        AutoBuffer<WT> _buf(swidth + dwidth);
+        AutoBuffer<IT> _acc(swidth);
+        WT *vbuf = _buf, *sum = vbuf + swidth;
+        IT* acc = _acc;
+        const T* rows[MAX_SUM_ROWS];
+        int x, k;
+
+        for( int b = range.begin(); b < range.end(); b++ )
+        {
+            int dy0 = b*bandHeight, dy1 = std::min(dy0 + bandHeight, dsize.height);
+            for( int dy = dy0; dy < dy1; dy++ )
+            {
+                int k1 = tabofs[dy+1];
+                if( tabofs[dy] == k1 )
+                    for( x = 0; x < swidth; x++ )
+                        vbuf[x] = 0;
+
+                for( k = tabofs[dy]; k < k1; )
+                {
+                    bool init = k == tabofs[dy];
+                    int n = 0;
+                    while( k + n < k1 && n < MAX_SUM_ROWS && ytab[k + n].alpha == 1.f )
+                    {
+                        rows[n] = (const T*)(src->data + src->step*ytab[k + n].si);
+                        n++;
+                    }
+
+                    if( n > 1 )
+                    {
+                        x = resizeAreaSumRows_(rows, n, acc, swidth);
+                        for( ; x < swidth; x++ )
+                        {
+                            IT t = rows[0][x];
+                            for( int i = 1; i < n; i++ )
+                                t += rows[i][x];
+                            acc[x] = t;
+                        }
+
+                        x = resizeAreaMulAdd_((const IT*)acc, vbuf, swidth, (WT)1, init);
+                        if( init )
+                            for( ; x < swidth; x++ )
+                                vbuf[x] = (WT)acc[x];
+                        else
+                            for( ; x < swidth; x++ )
+                                vbuf[x] += acc[x];
+                        k += n;
+                        continue;
+                    }
+
+                    const T* S = (const T*)(src->data + src->step*ytab[k].si);
+                    WT beta = ytab[k].alpha;
+                    x = resizeAreaMulAdd_(S, vbuf, swidth, beta, init);
+                    if( init )
+                        for( ; x < swidth; x++ )
+                            vbuf[x] = S[x]*beta;
+                    else
+                        for( ; x < swidth; x++ )
+                            vbuf[x] += S[x]*beta;
+                    k++;
+                }
+
+                for( x = 0; x < dwidth; x++ )
+                    sum[x] = 0;
+
+                if( cn == 1 )
+                    for( k = 0; k < xtab_size; k++ )
+                        sum[xtab[k].di] += vbuf[xtab[k].si]*xtab[k].alpha;
+                else if( cn == 2 )
+                    for( k = 0; k < xtab_size; k++ )
+                    {
+                        int sxn = xtab[k].si, dxn = xtab[k].di;
+                        WT alpha = xtab[k].alpha;
+                        WT t0 = sum[dxn] + vbuf[sxn]*alpha;
+                        WT t1 = sum[dxn+1] + vbuf[sxn+1]*alpha;
+                        sum[dxn] = t0; sum[dxn+1] = t1;
+                    }
+                else if( cn == 3 )
+                    for( k = 0; k < xtab_size; k++ )
+                    {
+                        int sxn = xtab[k].si, dxn = xtab[k].di;
+                        WT alpha = xtab[k].alpha;
+                        WT t0 = sum[dxn] + vbuf[sxn]*alpha;
+                        WT t1 = sum[dxn+1] + vbuf[sxn+1]*alpha;
+                        WT t2 = sum[dxn+2] + vbuf[sxn+2]*alpha;
+                        sum[dxn] = t0; sum[dxn+1] = t1; sum[dxn+2] = t2;
+                    }
+                else
+                    for( k = 0; k < xtab_size; k++ )
+                    {
+                        int sxn = xtab[k].si, dxn = xtab[k].di;
+                        WT alpha = xtab[k].alpha;
+                        WT t0 = sum[dxn] + vbuf[sxn]*alpha;
+                        WT t1 = sum[dxn+1] + vbuf[sxn+1]*alpha;
+                        sum[dxn] = t0; sum[dxn+1] = t1;
+                        t0 = sum[dxn+2] + vbuf[sxn+2]*alpha;
+                        t1 = sum[dxn+3] + vbuf[sxn+3]*alpha;
+                        sum[dxn+2] = t0; sum[dxn+3] = t1;
+                    }
+
+                T* D = (T*)(dst->data + dst->step*dy);
+                x = resizeAreaStore_(sum, D, dwidth);
+                for( ; x < dwidth; x++ )
+                    D[x] = saturate_cast<T>(sum[x]);
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    const DecimateAlpha* xtab;
+    int xtab_size;
+    const DecimateAlpha* ytab;
+    const int* tabofs;
+    int bandHeight;
+};
+
+template<typename T, typename WT, typename IT>
+static void resizeArea_( const Mat& src, Mat& dst, const DecimateAlpha* xtab, int xtab_size,
+                         const DecimateAlpha* ytab, const int* tabofs )
+{
+    int bandHeight = getResizeBandHeight(src.size(), dst.size(), 1);
+    parallel_for(BlockedRange(0, (dst.rows + bandHeight - 1)/bandHeight),
+                 ResizeAreaInvoker<T, WT, IT>(src, dst, xtab, xtab_size, ytab, tabofs, bandHeight));
+}
+
+
+typedef void (*ResizeFunc)( const Mat& src, Mat& dst,
+                            const int* xofs, const void* alpha,
+                            const int* yofs, const void* beta,
+                            int xmin, int xmax, int ksize );
+
+typedef void (*ResizeAreaFastFunc)( const Mat& src, Mat& dst,
+                                    const int* ofs, const int *xofs,
+                                    int scale_x, int scale_y );
+
+typedef void (*ResizeAreaFunc)( const Mat& src, Mat& dst,
+                                const DecimateAlpha* xtab, int xtab_size,
+                                const DecimateAlpha* ytab, const int* tabofs );
+
+static ResizeFunc getResizeFunc( int interpolation, int depth, int& ksize )
+{
+    static ResizeFunc linear_tab[] =
+    {
+        resizeGeneric_<
+            HResizeLinear<uchar, int, short,
+                INTER_RESIZE_COEF_SCALE,
+                HResizeLinearVec_8u32s>,
+            VResizeLinear<uchar, int, short,
+                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
+                VResizeLinearVec_32s8u> >,
+        0,
+        resizeGeneric_<
+            HResizeLinear<ushort, float, float, 1,
+                HResizeLinearVec_16u32f>,
+            VResizeLinear<ushort, float, float, Cast<float, ushort>,
+                VResizeLinearVec_32f16u> >,
+        resizeGeneric_<
+            HResizeLinear<short, float, float, 1,
+                HResizeLinearVec_16s32f>,
+            VResizeLinear<short, float, float, Cast<float, short>,
+                VResizeLinearVec_32f16s> >,
+		0,
+        resizeGeneric_<
+            HResizeLinear<float, float, float, 1,
+                HResizeLinearVec_32f>,
+            VResizeLinear<float, float, float, Cast<float, float>,
+                VResizeLinearVec_32f> >,
+        resizeGeneric_<
+            HResizeLinear<double, double, float, 1,
+                HResizeNoVec>,
+            VResizeLinear<double, double, float, Cast<double, double>,
+                VResizeNoVec> >,
+        0
+    };
+
+    static ResizeFunc cubic_tab[] =
+    {
+        resizeGeneric_<
+            HResizeCubic<uchar, int, short, HResizeCubicVec_8u32s>,
+            VResizeCubic<uchar, int, short,
+                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
+                VResizeCubicVec_32s8u> >,
+        0,
+        resizeGeneric_<
+            HResizeCubic<ushort, float, float, HResizeCubicNoVec>,
+            VResizeCubic<ushort, float, float, Cast<float, ushort>,
+            VResizeCubicVec_32f16u> >,
+        resizeGeneric_<
+            HResizeCubic<short, float, float, HResizeCubicNoVec>,
+            VResizeCubic<short, float, float, Cast<float, short>,
+            VResizeCubicVec_32f16s> >,
+		0,
+        resizeGeneric_<
+            HResizeCubic<float, float, float, HResizeCubicNoVec>,
+            VResizeCubic<float, float, float, Cast<float, float>,
             VResizeCubicVec_32f> >,
         resizeGeneric_<
-            HResizeCubic<double, double, float>,
+            HResizeCubic<double, double, float, HResizeCubicNoVec>,
             VResizeCubic<double, double, float, Cast<double, double>,
             VResizeNoVec> >,
         0
@@ -1387,42 +2051,277 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
         resizeGeneric_<HResizeLanczos4<uchar, int, short>,
             VResizeLanczos4<uchar, int, short,
             FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-            VResizeNoVec> >,
+            VResizeLanczos4Vec_32s8u> >,
         0,
         resizeGeneric_<HResizeLanczos4<ushort, float, float>,
             VResizeLanczos4<ushort, float, float, Cast<float, ushort>,
-            VResizeNoVec> >,
+            VResizeLanczos4Vec_32f16u> >,
        	resizeGeneric_<HResizeLanczos4<short, float, float>,
             VResizeLanczos4<short, float, float, Cast<float, short>,
-            VResizeNoVec> >,
+            VResizeLanczos4Vec_32f16s> >,
 		0,
         resizeGeneric_<HResizeLanczos4<float, float, float>,
             VResizeLanczos4<float, float, float, Cast<float, float>,
-            VResizeNoVec> >,
+            VResizeLanczos4Vec_32f> >,
         resizeGeneric_<HResizeLanczos4<double, double, float>,
             VResizeLanczos4<double, double, float, Cast<double, double>,
             VResizeNoVec> >,
         0
     };
 
+    if( interpolation == INTER_CUBIC )
+    {
+        ksize = 4;
+        return cubic_tab[depth];
+    }
+    if( interpolation == INTER_LANCZOS4 )
+    {
+        ksize = 8;
+        return lanczos4_tab[depth];
+    }
+    if( interpolation != INTER_LINEAR && interpolation != INTER_AREA )
+        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
+    ksize = 2;
+    return linear_tab[depth];
+}
+
+/* computes the tables used by resizeGeneric_: xofs and alpha for every destination column,
+   yofs and beta for every destination row, and the range [xmin, xmax) of the columns
+   that do not need the border processing */
+static void computeResizeTabs( Size ssize, Size dsize, double inv_scale_x, double inv_scale_y,
+                               int cn, int interpolation, int ksize, bool fixpt,
+                               int* xofs, float* alpha, int* yofs, float* beta,
+                               int& xmin, int& xmax )
+{
+    double scale_x = 1./inv_scale_x, scale_y = 1./inv_scale_y;
+    bool area_mode = interpolation == INTER_AREA;
+    short* ialpha = (short*)alpha;
+    short* ibeta = (short*)beta;
+    float fx, fy, cbuf[MAX_ESIZE];
+    int k, sx, sy, dx, dy, ksize2 = ksize/2;
+
+    xmin = 0;
+    xmax = dsize.width;
+
+    for( dx = 0; dx < dsize.width; dx++ )
+    {
+        if( !area_mode )
+        {
+            fx = (float)((dx+0.5)*scale_x - 0.5);
+            sx = cvFloor(fx);
+            fx -= sx;
+        }
+        else
+        {
+            sx = cvFloor(dx*scale_x);
+            fx = (float)((dx+1) - (sx+1)*inv_scale_x);
+            fx = fx <= 0 ? 0.f : fx - cvFloor(fx);
+        }
+
+        if( sx < ksize2-1 )
+        {
+            xmin = dx+1;
+            if( sx < 0 )
+                fx = 0, sx = 0;
+        }
+
+        if( sx + ksize2 >= ssize.width )
+        {
+            xmax = std::min( xmax, dx );
+            if( sx >= ssize.width-1 )
+                fx = 0, sx = ssize.width-1;
+        }
+
+        for( k = 0, sx *= cn; k < cn; k++ )
+            xofs[dx*cn + k] = sx + k;
+
+        if( interpolation == INTER_CUBIC )
+            interpolateCubic( fx, cbuf );
+        else if( interpolation == INTER_LANCZOS4 )
+            interpolateLanczos4( fx, cbuf );
+        else
+        {
+            cbuf[0] = 1.f - fx;
+            cbuf[1] = fx;
+        }
+        if( fixpt )
+        {
+            for( k = 0; k < ksize; k++ )
+                ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+            for( ; k < cn*ksize; k++ )
+                ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
+        }
+        else
+        {
+            for( k = 0; k < ksize; k++ )
+                alpha[dx*cn*ksize + k] = cbuf[k];
+            for( ; k < cn*ksize; k++ )
+                alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
+        }
+    }
+
+    for( dy = 0; dy < dsize.height; dy++ )
+    {
+        if( !area_mode )
+        {
+            fy = (float)((dy+0.5)*scale_y - 0.5);
+            sy = cvFloor(fy);
+            fy -= sy;
+        }
+        else
+        {
+            sy = cvFloor(dy*scale_y);
+            fy = (float)((dy+1) - (sy+1)*inv_scale_y);
+            fy = fy <= 0 ? 0.f : fy - cvFloor(fy);
+        }
+
+        yofs[dy] = sy;
+        if( interpolation == INTER_CUBIC )
+            interpolateCubic( fy, cbuf );
+        else if( interpolation == INTER_LANCZOS4 )
+            interpolateLanczos4( fy, cbuf );
+        else
+        {
+            cbuf[0] = 1.f - fy;
+            cbuf[1] = fy;
+        }
+
+        if( fixpt )
+        {
+            for( k = 0; k < ksize; k++ )
+                ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+        }
+        else
+        {
+            for( k = 0; k < ksize; k++ )
+                beta[dy*ksize + k] = cbuf[k];
+        }
+    }
+}
+
+
+/*
+   Resizes a band of the destination rows with the separable filter (func) or, when func is 0,
+   with the nearest-neighbor interpolation. The band is given the source rows it needs, the row
+   offsets are made relative to them; the clipping at the band edges then picks the same rows
+   as for the whole image, so the result does not depend on the partitioning.
+*/
+class ResizeInvoker
+{
+public:
+    ResizeInvoker( const Mat& _src, Mat& _dst, ResizeFunc _func, int _ksize,
+                   const int* _xofs, const void* _alpha, const int* _yofs, const void* _beta,
+                   int _xmin, int _xmax, double _inv_scale_x, double _inv_scale_y, int _bandHeight )
+        : src(&_src), dst(&_dst), func(_func), ksize(_ksize), xofs(_xofs), alpha(_alpha),
+          yofs(_yofs), beta(_beta), xmin(_xmin), xmax(_xmax), inv_scale_x(_inv_scale_x),
+          inv_scale_y(_inv_scale_y), bandHeight(_bandHeight)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int sheight = src->rows;
+        int bstep = (int)(ksize*(src->depth() == CV_8U ? sizeof(short) : sizeof(float)));
+        AutoBuffer<int> _ybuf(bandHeight);
+        int* ybuf = _ybuf;
+
+        for( int b = range.begin(); b < range.end(); b++ )
+        {
+            int dy0 = b*bandHeight, dy1 = std::min(dy0 + bandHeight, dst->rows);
+            Mat dband = dst->rowRange(dy0, dy1);
+
+            if( !func )
+            {
+                resizeNN(*src, dband, inv_scale_x, inv_scale_y, src->size(), 0, dy0);
+                continue;
+            }
+
+            int sy0 = std::max(yofs[dy0] - ksize/2 + 1, 0);
+            int sy1 = std::min(yofs[dy1-1] + ksize/2, sheight-1) + 1;
+            for( int dy = dy0; dy < dy1; dy++ )
+                ybuf[dy - dy0] = yofs[dy] - sy0;
+            func(src->rowRange(sy0, sy1), dband, xofs, alpha, ybuf,
+                 (const uchar*)beta + dy0*bstep, xmin, xmax, ksize);
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    ResizeFunc func;
+    int ksize;
+    const int* xofs;
+    const void* alpha;
+    const int* yofs;
+    const void* beta;
+    int xmin, xmax;
+    double inv_scale_x, inv_scale_y;
+    int bandHeight;
+};
+
+// INTER_AREA decimation by integer factors; a band of the destination rows
+// is built from the scale_y times taller band of the source rows
+class ResizeAreaFastInvoker
+{
+public:
+    ResizeAreaFastInvoker( const Mat& _src, Mat& _dst, ResizeAreaFastFunc _func,
+                           const int* _ofs, const int* _xofs, int _scale_x, int _scale_y,
+                           int _bandHeight )
+        : src(&_src), dst(&_dst), func(_func), ofs(_ofs), xofs(_xofs),
+          scale_x(_scale_x), scale_y(_scale_y), bandHeight(_bandHeight)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int sheight = src->rows;
+        for( int b = range.begin(); b < range.end(); b++ )
+        {
+            int dy0 = b*bandHeight, dy1 = std::min(dy0 + bandHeight, dst->rows);
+            Mat dband = dst->rowRange(dy0, dy1);
+            func(src->rowRange(std::min(dy0*scale_y, sheight), std::min(dy1*scale_y, sheight)),
+                 dband, ofs, xofs, scale_x, scale_y);
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    ResizeAreaFastFunc func;
+    const int* ofs;
+    const int* xofs;
+    int scale_x, scale_y;
+    int bandHeight;
+};
+
+}
+    
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
+                 double inv_scale_x, double inv_scale_y, int interpolation )
+{
+    CV_TRACE_REGION("cv::resize");
     static ResizeAreaFastFunc areafast_tab[] =
     {
-        resizeAreaFast_<uchar, int>, 0,
-		resizeAreaFast_<ushort, float>,
-		resizeAreaFast_<short, float>,
+        resizeAreaFast_<uchar, int, ResizeAreaFastVec_8u>, 0,
+		resizeAreaFast_<ushort, float, ResizeAreaFastNoVec>,
+		resizeAreaFast_<short, float, ResizeAreaFastNoVec>,
         0,
-        resizeAreaFast_<float, float>,
-        resizeAreaFast_<double, double>,
+        resizeAreaFast_<float, float, ResizeAreaFastVec_32f>,
+        resizeAreaFast_<double, double, ResizeAreaFastNoVec>,
         0
     };
 
     static ResizeAreaFunc area_tab[] =
     {
-        resizeArea_<uchar, float>, 0, resizeArea_<ushort, float>, resizeArea_<short, float>,
-        0, resizeArea_<float, float>, resizeArea_<double, double>, 0
+        resizeArea_<uchar, float, ushort>, 0, resizeArea_<ushort, float, int>,
+        resizeArea_<short, float, int>, 0, resizeArea_<float, float, float>,
+        resizeArea_<double, double, double>, 0
     };
 
     Mat src = _src.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     Size ssize = src.size();
     
     CV_Assert( ssize.area() > 0 );
@@ -1446,7 +2345,10 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
 
     if( interpolation == INTER_NEAREST )
     {
-        resizeNN( src, dst, inv_scale_x, inv_scale_y );
+        int bandHeight = getResizeBandHeight(ssize, dsize, 1);
+        parallel_for(BlockedRange(0, (dsize.height + bandHeight - 1)/bandHeight),
+                     ResizeInvoker(src, dst, 0, 0, 0, 0, 0, 0, 0, 0,
+                                   inv_scale_x, inv_scale_y, bandHeight));
         return;
     }
 
@@ -1479,177 +2381,302 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
                     xofs[dx*cn + k] = sx + k;
             }
 
-            func( src, dst, ofs, xofs, iscale_x, iscale_y );
+            int bandHeight = getResizeBandHeight(ssize, dsize, 1);
+            parallel_for(BlockedRange(0, (dsize.height + bandHeight - 1)/bandHeight),
+                         ResizeAreaFastInvoker(src, dst, func, ofs, xofs,
+                                               iscale_x, iscale_y, bandHeight));
             return;
         }
 
         ResizeAreaFunc func = area_tab[depth];
         CV_Assert( func != 0 && cn <= 4 );
 
-        AutoBuffer<DecimateAlpha> _xofs(ssize.width*2);
-        DecimateAlpha* xofs = _xofs;
-        double scale = 1.f/(scale_x*scale_y);
-
-        for( dx = 0, k = 0; dx < dsize.width; dx++ )
-        {
-            double fsx1 = dx*scale_x, fsx2 = fsx1 + scale_x;
-            int sx1 = cvCeil(fsx1), sx2 = cvFloor(fsx2);
-            sx1 = std::min(sx1, ssize.width-1);
-            sx2 = std::min(sx2, ssize.width-1);
-
-            if( sx1 > fsx1 )
-            {
-                assert( k < ssize.width*2 );
-                xofs[k].di = dx*cn;
-                xofs[k].si = (sx1-1)*cn;
-                xofs[k++].alpha = (float)((sx1 - fsx1)*scale);
-            }
+        AutoBuffer<DecimateAlpha> _xtab((ssize.width + ssize.height)*2);
+        DecimateAlpha* xtab = _xtab;
+        DecimateAlpha* ytab = xtab + ssize.width*2;
+        AutoBuffer<int> _tabofs(dsize.height + 1);
+        int* tabofs = _tabofs;
 
-            for( sx = sx1; sx < sx2; sx++ )
-            {
-                assert( k < ssize.width*2 );
-                xofs[k].di = dx*cn;
-                xofs[k].si = sx*cn;
-                xofs[k++].alpha = (float)scale;
-            }
+        int xtab_size = computeResizeAreaTab(ssize.width, dsize.width, cn, scale_x,
+                                             1.f/(scale_x*scale_y), xtab);
+        int ytab_size = computeResizeAreaTab(ssize.height, dsize.height, 1, scale_y, 1., ytab);
 
-            if( fsx2 - sx2 > 1e-3 )
-            {
-                assert( k < ssize.width*2 );
-                xofs[k].di = dx*cn;
-                xofs[k].si = sx2*cn;
-                xofs[k++].alpha = (float)((fsx2 - sx2)*scale);
-            }
+        // the rows of the k-th destination row are ytab[tabofs[k]] ... ytab[tabofs[k+1]-1]
+        for( dy = 0, k = 0; dy <= dsize.height; dy++ )
+        {
+            while( k < ytab_size && ytab[k].di < dy )
+                k++;
+            tabofs[dy] = k;
         }
 
-        func( src, dst, xofs, k );
+        func( src, dst, xtab, xtab_size, ytab, tabofs );
         return;
     }
 
     int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
-    bool area_mode = interpolation == INTER_AREA;
     bool fixpt = depth == CV_8U;
-    float fx, fy;
-    ResizeFunc func=0;
-    int ksize=0, ksize2;
-    if( interpolation == INTER_CUBIC )
-        ksize = 4, func = cubic_tab[depth];
-    else if( interpolation == INTER_LANCZOS4 )
-        ksize = 8, func = lanczos4_tab[depth];
-    else if( interpolation == INTER_LINEAR || interpolation == INTER_AREA )
-        ksize = 2, func = linear_tab[depth];
-    else
-        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
-    ksize2 = ksize/2;
-
+    int ksize = 0;
+    ResizeFunc func = getResizeFunc(interpolation, depth, ksize);
     CV_Assert( func != 0 );
 
     AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
     int* xofs = (int*)(uchar*)_buffer;
     int* yofs = xofs + width;
     float* alpha = (float*)(yofs + dsize.height);
-    short* ialpha = (short*)alpha;
     float* beta = alpha + width*ksize;
-    short* ibeta = ialpha + width*ksize;
-    float cbuf[MAX_ESIZE];
 
-    for( dx = 0; dx < dsize.width; dx++ )
+    computeResizeTabs( ssize, dsize, inv_scale_x, inv_scale_y, cn, interpolation, ksize,
+                       fixpt, xofs, alpha, yofs, beta, xmin, xmax );
+
+    int bandHeight = getResizeBandHeight(ssize, dsize, ksize*4);
+    parallel_for(BlockedRange(0, (dsize.height + bandHeight - 1)/bandHeight),
+                 ResizeInvoker(src, dst, func, ksize, xofs, alpha, yofs, beta, xmin, xmax,
+                               inv_scale_x, inv_scale_y, bandHeight));
+}
+
+/****************************************************************************************\
+*                   Fused color conversion + resize + normalization                      *
+\****************************************************************************************/
+
+namespace cv
+{
+
+// the conversions that look at the neighbouring rows (Bayer demosaicing) or
+// take the chroma planes from below the luma plane (YUV420) can not be done band-wise
+static bool isRowLocalColorConversion( int code )
+{
+    return code < 0 ||
+        !((CV_BayerBG2BGR <= code && code <= CV_BayerGR2BGR) ||
+          (CV_BayerBG2BGR_VNG <= code && code <= CV_BayerGR2BGR_VNG) ||
+          (CV_BayerBG2GRAY <= code && code <= CV_BayerGR2GRAY) ||
+          (CV_YUV2RGB_NV21 <= code && code <= CV_YUV2GRAY_420));
+}
+
+// writes the converted block of destination rows into the interleaved or the planar output
+static void storePreprocessed( const Mat& rsz, Mat& dst, Mat& fbuf, int dy0, int dheight,
+                               double alpha, double beta, bool planar )
+{
+    int dy1 = dy0 + rsz.rows, cn = rsz.channels();
+    if( !planar || cn == 1 )
     {
-        if( !area_mode )
-        {
-            fx = (float)((dx+0.5)*scale_x - 0.5);
-            sx = cvFloor(fx);
-            fx -= sx;
-        }
-        else
-        {
-            sx = cvFloor(dx*scale_x);
-            fx = (float)((dx+1) - (sx+1)*inv_scale_x);
-            fx = fx <= 0 ? 0.f : fx - cvFloor(fx);
-        }
+        Mat dstBand = dst.rowRange(dy0, dy1);
+        rsz.convertTo(dstBand, CV_32F, alpha, beta);
+        return;
+    }
 
-        if( sx < ksize2-1 )
-        {
-            xmin = dx+1;
-            if( sx < 0 )
-                fx = 0, sx = 0;
-        }
+    if( fbuf.rows < rsz.rows )
+        fbuf.create(rsz.rows, rsz.cols, CV_32FC(cn));
+    Mat f = fbuf.rowRange(0, rsz.rows);
+    rsz.convertTo(f, CV_32F, alpha, beta);
 
-        if( sx + ksize2 >= ssize.width )
-        {
-            xmax = std::min( xmax, dx );
-            if( sx >= ssize.width-1 )
-                fx = 0, sx = ssize.width-1;
-        }
+    Mat planes[CV_CN_MAX];
+    for( int c = 0; c < cn; c++ )
+        planes[c] = dst.rowRange(c*dheight + dy0, c*dheight + dy1);
+    split(f, planes);
+}
 
-        for( k = 0, sx *= cn; k < cn; k++ )
-            xofs[dx*cn + k] = sx + k;
+class PreprocessInvoker
+{
+public:
+    PreprocessInvoker( const Mat& _src, Mat& _dst, Size _dsize, int _code, int _ctype,
+                       int _interpolation, double _inv_scale_x, double _inv_scale_y,
+                       ResizeFunc _func, int _ksize, const int* _xofs, const void* _rx,
+                       const int* _yofs, const void* _ry, int _xmin, int _xmax,
+                       int _bandHeight, double _alpha, double _beta, bool _planar )
+    {
+        src = _src; dst = _dst; dsize = _dsize;
+        code = _code; ctype = _ctype; interpolation = _interpolation;
+        inv_scale_x = _inv_scale_x; inv_scale_y = _inv_scale_y;
+        func = _func; ksize = _ksize;
+        xofs = _xofs; rx = _rx; yofs = _yofs; ry = _ry; xmin = _xmin; xmax = _xmax;
+        bandHeight = _bandHeight; alpha = _alpha; beta = _beta; planar = _planar;
+    }
 
-        if( interpolation == INTER_CUBIC )
-            interpolateCubic( fx, cbuf );
-        else if( interpolation == INTER_LANCZOS4 )
-            interpolateLanczos4( fx, cbuf );
-        else
-        {
-            cbuf[0] = 1.f - fx;
-            cbuf[1] = fx;
-        }
-        if( fixpt )
+    // the range of source rows [sy0, sy1) that the destination rows [dy0, dy1) are built from
+    void getSourceRows( int dy0, int dy1, int& sy0, int& sy1 ) const
+    {
+        int sheight = src.rows;
+        if( dsize == src.size() )
+            sy0 = dy0, sy1 = dy1;
+        else if( interpolation == INTER_NEAREST )
         {
-            for( k = 0; k < ksize; k++ )
-                ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
-            for( ; k < cn*ksize; k++ )
-                ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
+            double ify = 1./inv_scale_y;
+            sy0 = std::min(cvFloor(dy0*ify), sheight-1);
+            sy1 = std::min(cvFloor((dy1-1)*ify), sheight-1) + 1;
         }
         else
         {
-            for( k = 0; k < ksize; k++ )
-                alpha[dx*cn*ksize + k] = cbuf[k];
-            for( ; k < cn*ksize; k++ )
-                alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
+            sy0 = std::max(yofs[dy0] - ksize/2 + 1, 0);
+            sy1 = std::min(yofs[dy1-1] + ksize/2, sheight-1) + 1;
         }
     }
 
-    for( dy = 0; dy < dsize.height; dy++ )
+    void operator()( const BlockedRange& range ) const
     {
-        if( !area_mode )
-        {
-            fy = (float)((dy+0.5)*scale_y - 0.5);
-            sy = cvFloor(fy);
-            fy -= sy;
-        }
-        else
-        {
-            sy = cvFloor(dy*scale_y);
-            fy = (float)((dy+1) - (sy+1)*inv_scale_y);
-            fy = fy <= 0 ? 0.f : fy - cvFloor(fy);
-        }
+        int b, sy0, sy1, maxRows = 0;
+        bool doResize = dsize != src.size();
+        int bufstep = (int)(ksize*(func && CV_MAT_DEPTH(ctype) == CV_8U ? sizeof(short) : sizeof(float)));
 
-        yofs[dy] = sy;
-        if( interpolation == INTER_CUBIC )
-            interpolateCubic( fy, cbuf );
-        else if( interpolation == INTER_LANCZOS4 )
-            interpolateLanczos4( fy, cbuf );
-        else
+        for( b = range.begin(); b < range.end(); b++ )
         {
-            cbuf[0] = 1.f - fy;
-            cbuf[1] = fy;
+            int dy0 = b*bandHeight, dy1 = std::min(dy0 + bandHeight, dsize.height);
+            getSourceRows(dy0, dy1, sy0, sy1);
+            maxRows = std::max(maxRows, sy1 - sy0);
         }
 
-        if( fixpt )
+        Mat cbuf, rbuf, fbuf;
+        if( code >= 0 )
+            cbuf.create(maxRows, src.cols, ctype);
+        if( doResize )
+            rbuf.create(bandHeight, dsize.width, ctype);
+        AutoBuffer<int> _ybuf(bandHeight);
+        int* ybuf = _ybuf;
+
+        for( b = range.begin(); b < range.end(); b++ )
         {
-            for( k = 0; k < ksize; k++ )
-                ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+            int dy0 = b*bandHeight, dy1 = std::min(dy0 + bandHeight, dsize.height);
+            getSourceRows(dy0, dy1, sy0, sy1);
+
+            Mat cvt = src.rowRange(sy0, sy1);
+            if( code >= 0 )
+            {
+                Mat cband = cbuf.rowRange(0, sy1 - sy0);
+                cvtColor(cvt, cband, code);
+                cvt = cband;
+            }
+
+            Mat rsz = cvt;
+            if( doResize )
+            {
+                rsz = rbuf.rowRange(0, dy1 - dy0);
+                if( interpolation == INTER_NEAREST )
+                    resizeNN(cvt, rsz, inv_scale_x, inv_scale_y, src.size(), sy0, dy0);
+                else
+                {
+                    // the row offsets are made relative to the band; the clipping at
+                    // the band edges then picks the same rows as for the whole image
+                    for( int dy = dy0; dy < dy1; dy++ )
+                        ybuf[dy - dy0] = yofs[dy] - sy0;
+                    func(cvt, rsz, xofs, rx, ybuf, (const uchar*)ry + dy0*bufstep,
+                         xmin, xmax, ksize);
+                }
+            }
+
+            Mat d = dst;
+            storePreprocessed(rsz, d, fbuf, dy0, dsize.height, alpha, beta, planar);
         }
+    }
+
+private:
+    Mat src;
+    Mat dst;
+    Size dsize;
+    int code, ctype, interpolation;
+    double inv_scale_x, inv_scale_y;
+    ResizeFunc func;
+    int ksize;
+    const int* xofs;
+    const void* rx;
+    const int* yofs;
+    const void* ry;
+    int xmin, xmax;
+    int bandHeight;
+    double alpha, beta;
+    bool planar;
+};
+
+}
+
+void cv::preprocessImage( InputArray _src, OutputArray _dst, Size dsize, int code,
+                          int interpolation, double alpha, double beta, bool planar )
+{
+    CV_TRACE_REGION("cv::preprocessImage");
+    Mat src = _src.getMat();
+    Size ssize = src.size();
+    CV_Assert( ssize.area() > 0 );
+    CV_TRACE_BYTES(src.total()*src.elemSize());
+
+    if( dsize == Size() )
+        dsize = ssize;
+    CV_Assert( dsize.width > 0 && dsize.height > 0 );
+
+    double inv_scale_x = (double)dsize.width/ssize.width;
+    double inv_scale_y = (double)dsize.height/ssize.height;
+    bool doResize = dsize != ssize;
+    bool areaDownscale = interpolation == INTER_AREA && inv_scale_x <= 1 && inv_scale_y <= 1;
+
+    if( !isRowLocalColorConversion(code) || (doResize && areaDownscale) )
+    {
+        // fall back to the sequence of the separate operations
+        Mat cvt, rsz, f;
+        if( code >= 0 )
+            cvtColor(src, cvt, code);
         else
+            cvt = src;
+        rsz = cvt;
+        if( doResize )
+            resize(cvt, rsz, dsize, 0, 0, interpolation);
+        int cn = rsz.channels();
+        if( !planar )
         {
-            for( k = 0; k < ksize; k++ )
-                beta[dy*ksize + k] = cbuf[k];
+            rsz.convertTo(_dst, CV_32F, alpha, beta);
+            return;
         }
+        _dst.create(dsize.height*cn, dsize.width, CV_32F);
+        Mat dst = _dst.getMat();
+        storePreprocessed(rsz, dst, f, 0, dsize.height, alpha, beta, planar);
+        return;
+    }
+
+    // find out the type of the color conversion output
+    int ctype = src.type();
+    if( code >= 0 )
+    {
+        Mat probe;
+        cvtColor(src.rowRange(0, 1), probe, code);
+        ctype = probe.type();
+    }
+    int cn = CV_MAT_CN(ctype);
+
+    if( planar )
+        _dst.create(dsize.height*cn, dsize.width, CV_32F);
+    else
+        _dst.create(dsize, CV_32FC(cn));
+    Mat dst = _dst.getMat();
+
+    ResizeFunc func = 0;
+    int ksize = 2, xmin = 0, xmax = dsize.width, width = dsize.width*cn;
+    AutoBuffer<uchar> _buffer;
+    int *xofs = 0, *yofs = 0;
+    float *rx = 0, *ry = 0;
+
+    if( doResize && interpolation != INTER_NEAREST )
+    {
+        int depth = CV_MAT_DEPTH(ctype);
+        func = getResizeFunc(interpolation, depth, ksize);
+        CV_Assert( func != 0 );
+        _buffer.allocate((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
+        xofs = (int*)(uchar*)_buffer;
+        yofs = xofs + width;
+        rx = (float*)(yofs + dsize.height);
+        ry = rx + width*ksize;
+        computeResizeTabs(ssize, dsize, inv_scale_x, inv_scale_y, cn, interpolation, ksize,
+                          depth == CV_8U, xofs, rx, yofs, ry, xmin, xmax);
     }
 
-    func( src, dst, xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs,
-          fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize );
+    // each band converts about 128K of source pixels, so that the intermediate rows
+    // stay in L2 cache between the color conversion, the resize and the normalization
+    size_t rowBytes = std::max((size_t)ssize.width*CV_ELEM_SIZE(ctype),
+                               (size_t)dsize.width*cn*sizeof(float));
+    int srcRows = std::max((int)((1 << 17)/rowBytes), ksize);
+    int bandHeight = std::max(cvRound((double)srcRows*dsize.height/ssize.height), 1);
+    bandHeight = std::min(bandHeight, dsize.height);
+    int nbands = (dsize.height + bandHeight - 1)/bandHeight;
+
+    parallel_for(BlockedRange(0, nbands),
+                 PreprocessInvoker(src, dst, dsize, code, ctype, interpolation,
+                                   inv_scale_x, inv_scale_y, func, ksize, xofs, rx,
+                                   yofs, ry, xmin, xmax, bandHeight, alpha, beta, planar));
 }
 
 
@@ -1969,9 +2996,277 @@ struct RemapVec_8u
     }
 };
 
+// load 2 or 4 consecutive elements converted to float
+static inline __m128 remapLoad2( const float* p )
+{ return _mm_castpd_ps(_mm_load_sd((const double*)p)); }
+static inline __m128 remapLoad2( const ushort* p )
+{ return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_cvtsi32_si128(*(const int*)p), _mm_setzero_si128())); }
+static inline __m128 remapLoad2( const short* p )
+{
+    __m128i v = _mm_cvtsi32_si128(*(const int*)p);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+static inline __m128 remapLoad4( const float* p )
+{ return _mm_loadu_ps(p); }
+static inline __m128 remapLoad4( const ushort* p )
+{ return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128())); }
+static inline __m128 remapLoad4( const short* p )
+{
+    __m128i v = _mm_loadl_epi64((const __m128i*)p);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+// store 4 values rounded and saturated the same way as saturate_cast<> does
+static inline void remapStore4( float* p, __m128 v )
+{ _mm_storeu_ps(p, v); }
+static inline void remapStore4( ushort* p, __m128 v )
+{
+    __m128i iv = _mm_sub_epi32(_mm_cvtps_epi32(v), _mm_set1_epi32(32768));
+    iv = _mm_add_epi16(_mm_packs_epi32(iv, iv), _mm_set1_epi16(-32768));
+    _mm_storel_epi64((__m128i*)p, iv);
+}
+static inline void remapStore4( short* p, __m128 v )
+{
+    __m128i iv = _mm_cvtps_epi32(v);
+    _mm_storel_epi64((__m128i*)p, _mm_packs_epi32(iv, iv));
+}
+
+/*
+   Bilinear interpolation of 16-bit and 32-bit floating-point images.
+   The products are summed up in the same order as in remapBilinear(),
+   so the results are bit-exact with the scalar code.
+*/
+template<typename T> struct RemapVec_32f
+{
+    int operator()( const Mat& _src, void* _dst, const short* XY,
+                    const ushort* FXY, const void* _wtab, int width ) const
+    {
+        int cn = _src.channels();
+
+        if( (cn != 1 && cn != 4) || !checkHardwareSupport(CV_CPU_SSE2) )
+            return 0;
+
+        const T* S0 = (const T*)_src.data;
+        size_t sstep = _src.step/sizeof(S0[0]);
+        const float* wtab = (const float*)_wtab;
+        T* D = (T*)_dst;
+        int x = 0;
+
+        if( cn == 1 )
+        {
+            for( ; x <= width - 4; x += 4 )
+            {
+                const T* S = S0 + XY[x*2+1]*sstep + XY[x*2];
+                __m128 v0 = _mm_mul_ps(_mm_movelh_ps(remapLoad2(S), remapLoad2(S + sstep)),
+                                       _mm_loadu_ps(wtab + FXY[x]*4));
+                S = S0 + XY[x*2+3]*sstep + XY[x*2+2];
+                __m128 v1 = _mm_mul_ps(_mm_movelh_ps(remapLoad2(S), remapLoad2(S + sstep)),
+                                       _mm_loadu_ps(wtab + FXY[x+1]*4));
+                S = S0 + XY[x*2+5]*sstep + XY[x*2+4];
+                __m128 v2 = _mm_mul_ps(_mm_movelh_ps(remapLoad2(S), remapLoad2(S + sstep)),
+                                       _mm_loadu_ps(wtab + FXY[x+2]*4));
+                S = S0 + XY[x*2+7]*sstep + XY[x*2+6];
+                __m128 v3 = _mm_mul_ps(_mm_movelh_ps(remapLoad2(S), remapLoad2(S + sstep)),
+                                       _mm_loadu_ps(wtab + FXY[x+3]*4));
+
+                // after the transposition v0 contains the first products of the 4 pixels, v1 - the second ones etc.
+                _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+                remapStore4(D + x, _mm_add_ps(_mm_add_ps(_mm_add_ps(v0, v1), v2), v3));
+            }
+        }
+        else
+        {
+            for( ; x < width; x++, D += 4 )
+            {
+                const T* S = S0 + XY[x*2+1]*sstep + XY[x*2]*4;
+                const float* w = wtab + FXY[x]*4;
+                __m128 s = _mm_mul_ps(remapLoad4(S), _mm_set1_ps(w[0]));
+                s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + 4), _mm_set1_ps(w[1])));
+                s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + sstep), _mm_set1_ps(w[2])));
+                s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + sstep + 4), _mm_set1_ps(w[3])));
+                remapStore4(D, s);
+            }
+        }
+
+        return x;
+    }
+};
+
+/*
+   Unlike the bilinear vector operations, the bicubic ones are called for every pixel
+   that the scalar code is about to process; they take the pixels (the groups of 4 pixels
+   of 1-channel images) while their 4x4 neighborhoods are inside the image.
+*/
+struct RemapBicubicVec_8u
+{
+    RemapBicubicVec_8u() { useSIMD = checkHardwareSupport(CV_CPU_SSE2); }
+
+    int operator()( const Mat& _src, void* _dst, const short* XY,
+                    const ushort* FXY, const void* _wtab, int width ) const
+    {
+        int cn = _src.channels();
+        if( !useSIMD || (cn != 1 && cn != 4) )
+            return 0;
+
+        const uchar* S0 = _src.data;
+        size_t sstep = _src.step;
+        unsigned width1 = std::max(_src.cols-3, 0), height1 = std::max(_src.rows-3, 0);
+        const short* wtab = (const short*)_wtab;
+        uchar* D = (uchar*)_dst;
+        __m128i z = _mm_setzero_si128(), delta = _mm_set1_epi32(INTER_REMAP_COEF_SCALE/2);
+        int x = 0, k;
+
+        if( cn == 4 )
+        {
+            for( ; x < width; x++ )
+            {
+                int sx = XY[x*2]-1, sy = XY[x*2+1]-1;
+                if( (unsigned)sx >= width1 || (unsigned)sy >= height1 )
+                    break;
+
+                const uchar* S = S0 + sy*sstep + sx*4;
+                const short* w = wtab + FXY[x]*16;
+                __m128i sum = z;
+                for( k = 0; k < 4; k++, S += sstep, w += 4 )
+                {
+                    // interleave the channels of the pixels 0 and 1, 2 and 3 to multiply them by the weight pairs
+                    __m128i v0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)S), z);
+                    __m128i v1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(S + 8)), z);
+                    v0 = _mm_unpacklo_epi16(v0, _mm_srli_si128(v0, 8));
+                    v1 = _mm_unpacklo_epi16(v1, _mm_srli_si128(v1, 8));
+                    __m128i w01 = _mm_set1_epi32((int)(((unsigned)(ushort)w[1] << 16) | (ushort)w[0]));
+                    __m128i w23 = _mm_set1_epi32((int)(((unsigned)(ushort)w[3] << 16) | (ushort)w[2]));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(v0, w01));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(v1, w23));
+                }
+                sum = _mm_srai_epi32(_mm_add_epi32(sum, delta), INTER_REMAP_COEF_BITS);
+                sum = _mm_packus_epi16(_mm_packs_epi32(sum, sum), z);
+                *(int*)(D + x*4) = _mm_cvtsi128_si32(sum);
+            }
+            return x;
+        }
+
+        for( ; x <= width - 4; x += 4 )
+        {
+            __m128i s[4];
+            for( k = 0; k < 4; k++ )
+                if( (unsigned)(XY[(x+k)*2]-1) >= width1 || (unsigned)(XY[(x+k)*2+1]-1) >= height1 )
+                    break;
+            if( k < 4 )
+                break;
+
+            for( k = 0; k < 4; k++ )
+            {
+                const uchar* S = S0 + (XY[(x+k)*2+1]-1)*sstep + XY[(x+k)*2]-1;
+                const short* w = wtab + FXY[x+k]*16;
+                __m128i r01 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const int*)S),
+                                                 _mm_cvtsi32_si128(*(const int*)(S + sstep)));
+                __m128i r23 = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const int*)(S + sstep*2)),
+                                                 _mm_cvtsi32_si128(*(const int*)(S + sstep*3)));
+                r01 = _mm_madd_epi16(_mm_unpacklo_epi8(r01, z), _mm_loadu_si128((const __m128i*)w));
+                r23 = _mm_madd_epi16(_mm_unpacklo_epi8(r23, z), _mm_loadu_si128((const __m128i*)(w + 8)));
+                s[k] = _mm_add_epi32(r01, r23);
+            }
+
+            __m128i t0 = _mm_add_epi32(_mm_unpacklo_epi32(s[0], s[1]), _mm_unpackhi_epi32(s[0], s[1]));
+            __m128i t1 = _mm_add_epi32(_mm_unpacklo_epi32(s[2], s[3]), _mm_unpackhi_epi32(s[2], s[3]));
+            t0 = _mm_add_epi32(_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1));
+            t0 = _mm_srai_epi32(_mm_add_epi32(t0, delta), INTER_REMAP_COEF_BITS);
+            t0 = _mm_packus_epi16(_mm_packs_epi32(t0, t0), z);
+            *(int*)(D + x) = _mm_cvtsi128_si32(t0);
+        }
+
+        return x;
+    }
+
+    bool useSIMD;
+};
+
+template<typename T> struct RemapBicubicVec_32f
+{
+    RemapBicubicVec_32f() { useSIMD = checkHardwareSupport(CV_CPU_SSE2); }
+
+    int operator()( const Mat& _src, void* _dst, const short* XY,
+                    const ushort* FXY, const void* _wtab, int width ) const
+    {
+        int cn = _src.channels();
+        if( !useSIMD || (cn != 1 && cn != 4) )
+            return 0;
+
+        const T* S0 = (const T*)_src.data;
+        size_t sstep = _src.step/sizeof(S0[0]);
+        unsigned width1 = std::max(_src.cols-3, 0), height1 = std::max(_src.rows-3, 0);
+        const float* wtab = (const float*)_wtab;
+        T* D = (T*)_dst;
+        int x = 0, k;
+
+        if( cn == 4 )
+        {
+            for( ; x < width; x++ )
+            {
+                int sx = XY[x*2]-1, sy = XY[x*2+1]-1;
+                if( (unsigned)sx >= width1 || (unsigned)sy >= height1 )
+                    break;
+
+                const T* S = S0 + sy*sstep + sx*4;
+                const float* w = wtab + FXY[x]*16;
+                __m128 sum = _mm_setzero_ps();
+                for( k = 0; k < 4; k++, S += sstep, w += 4 )
+                {
+                    __m128 s = _mm_mul_ps(remapLoad4(S), _mm_set1_ps(w[0]));
+                    s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + 4), _mm_set1_ps(w[1])));
+                    s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + 8), _mm_set1_ps(w[2])));
+                    s = _mm_add_ps(s, _mm_mul_ps(remapLoad4(S + 12), _mm_set1_ps(w[3])));
+                    sum = k == 0 ? s : _mm_add_ps(sum, s);
+                }
+                remapStore4(D + x*4, sum);
+            }
+            return x;
+        }
+
+        for( ; x <= width - 4; x += 4 )
+        {
+            const T* S[4];
+            const float* w[4];
+            for( k = 0; k < 4; k++ )
+            {
+                int sx = XY[(x+k)*2]-1, sy = XY[(x+k)*2+1]-1;
+                if( (unsigned)sx >= width1 || (unsigned)sy >= height1 )
+                    break;
+                S[k] = S0 + sy*sstep + sx;
+                w[k] = wtab + FXY[x+k]*16;
+            }
+            if( k < 4 )
+                break;
+
+            // the row sums are accumulated in the order of remapBicubic()
+            __m128 sum = _mm_setzero_ps();
+            for( int r = 0; r < 4; r++ )
+            {
+                __m128 v0 = _mm_mul_ps(remapLoad4(S[0] + sstep*r), _mm_loadu_ps(w[0] + r*4));
+                __m128 v1 = _mm_mul_ps(remapLoad4(S[1] + sstep*r), _mm_loadu_ps(w[1] + r*4));
+                __m128 v2 = _mm_mul_ps(remapLoad4(S[2] + sstep*r), _mm_loadu_ps(w[2] + r*4));
+                __m128 v3 = _mm_mul_ps(remapLoad4(S[3] + sstep*r), _mm_loadu_ps(w[3] + r*4));
+                _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+                v0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(v0, v1), v2), v3);
+                sum = r == 0 ? v0 : _mm_add_ps(sum, v0);
+            }
+            remapStore4(D + x, sum);
+        }
+
+        return x;
+    }
+
+    bool useSIMD;
+};
+
 #else
 
 typedef RemapNoVec RemapVec_8u;
+typedef RemapNoVec RemapBicubicVec_8u;
+template<typename T> struct RemapVec_32f : public RemapNoVec {};
+template<typename T> struct RemapBicubicVec_32f : public RemapNoVec {};
 
 #endif
 
@@ -2176,7 +3471,7 @@ static void remapBilinear( const Mat& _src, Mat& _dst, const Mat& _xy,
 }
 
 
-template<class CastOp, typename AT, int ONE>
+template<class CastOp, class VecOp, typename AT, int ONE>
 static void remapBicubic( const Mat& _src, Mat& _dst, const Mat& _xy,
                           const Mat& _fxy, const void* _wtab,
                           int borderType, const Scalar& _borderValue )
@@ -2194,6 +3489,7 @@ static void remapBicubic( const Mat& _src, Mat& _dst, const Mat& _xy,
         saturate_cast<T>(_borderValue[3]));
     int dx, dy;
     CastOp castOp;
+    VecOp vecOp;
     int borderType1 = borderType != BORDER_TRANSPARENT ? borderType : BORDER_REFLECT_101;
 
     unsigned width1 = std::max(ssize.width-3, 0), height1 = std::max(ssize.height-3, 0);
@@ -2212,6 +3508,15 @@ static void remapBicubic( const Mat& _src, Mat& _dst, const Mat& _xy,
 
         for( dx = 0; dx < dsize.width; dx++, D += cn )
         {
+            int len = vecOp( _src, D, XY + dx*2, FXY + dx, wtab, dsize.width - dx );
+            if( len > 0 )
+            {
+                D += len*cn;
+                dx += len;
+                if( dx >= dsize.width )
+                    break;
+            }
+
             int sx = XY[dx*2]-1, sy = XY[dx*2+1]-1;
             const AT* w = wtab + FXY[dx]*16;
             int i, k;
@@ -2399,11 +3704,13 @@ typedef void (*RemapFunc)(const Mat& _src, Mat& _dst, const Mat& _xy,
                           const Mat& _fxy, const void* _wtab,
                           int borderType, const Scalar& _borderValue);
 
-}
-    
-void cv::remap( InputArray _src, OutputArray _dst,
-                InputArray _map1, InputArray _map2,
-                int interpolation, int borderType, const Scalar& borderValue )
+/*
+   Selects the kernel for the image depth and the interpolation method.
+   INTER_AREA is replaced with INTER_LINEAR. For the interpolating kernels
+   the table of the interpolation weights is initialized and returned in ctab.
+*/
+static void getRemapFuncs( int depth, int& interpolation, RemapNNFunc& nnfunc,
+                           RemapFunc& ifunc, const void*& ctab )
 {
     static RemapNNFunc nn_tab[] =
     {
@@ -2414,19 +3721,20 @@ void cv::remap( InputArray _src, OutputArray _dst,
     static RemapFunc linear_tab[] =
     {
         remapBilinear<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, RemapVec_8u, short>, 0,
-        remapBilinear<Cast<float, ushort>, RemapNoVec, float>,
-        remapBilinear<Cast<float, short>, RemapNoVec, float>, 0,
-        remapBilinear<Cast<float, float>, RemapNoVec, float>,
+        remapBilinear<Cast<float, ushort>, RemapVec_32f<ushort>, float>,
+        remapBilinear<Cast<float, short>, RemapVec_32f<short>, float>, 0,
+        remapBilinear<Cast<float, float>, RemapVec_32f<float>, float>,
         remapBilinear<Cast<double, double>, RemapNoVec, float>, 0
     };
 
     static RemapFunc cubic_tab[] =
     {
-        remapBicubic<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE>, 0,
-        remapBicubic<Cast<float, ushort>, float, 1>,
-        remapBicubic<Cast<float, short>, float, 1>, 0,
-        remapBicubic<Cast<float, float>, float, 1>,
-        remapBicubic<Cast<double, double>, float, 1>, 0
+        remapBicubic<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, RemapBicubicVec_8u,
+                     short, INTER_REMAP_COEF_SCALE>, 0,
+        remapBicubic<Cast<float, ushort>, RemapBicubicVec_32f<ushort>, float, 1>,
+        remapBicubic<Cast<float, short>, RemapBicubicVec_32f<short>, float, 1>, 0,
+        remapBicubic<Cast<float, float>, RemapBicubicVec_32f<float>, float, 1>,
+        remapBicubic<Cast<double, double>, RemapNoVec, float, 1>, 0
     };
 
     static RemapFunc lanczos4_tab[] =
@@ -2438,133 +3746,201 @@ void cv::remap( InputArray _src, OutputArray _dst,
         remapLanczos4<Cast<double, double>, float, 1>, 0
     };
 
-    Mat src = _src.getMat(), map1 = _map1.getMat(), map2 = _map2.getMat();
-    
-    CV_Assert( (!map2.data || map2.size() == map1.size()));
-    
-    _dst.create( map1.size(), src.type() );
-    Mat dst = _dst.getMat();
-    CV_Assert(dst.data != src.data);
-
-    int depth = src.depth(), map_depth = map1.depth();
-    RemapNNFunc nnfunc = 0;
-    RemapFunc ifunc = 0;
-    const void* ctab = 0;
-    bool fixpt = depth == CV_8U;
-    bool planar_input = false;
+    nnfunc = 0;
+    ifunc = 0;
+    ctab = 0;
 
     if( interpolation == INTER_NEAREST )
     {
-        nnfunc = nn_tab[depth];
-        CV_Assert( nnfunc != 0 );
-
-        if( map1.type() == CV_16SC2 && !map2.data ) // the data is already in the right format
-        {
-            nnfunc( src, dst, map1, borderType, borderValue );
-            return;
-        }
-    }
-    else
-    {
-        if( interpolation == INTER_AREA )
-            interpolation = INTER_LINEAR;
-
-        if( interpolation == INTER_LINEAR )
-            ifunc = linear_tab[depth];
-        else if( interpolation == INTER_CUBIC )
-            ifunc = cubic_tab[depth];
-        else if( interpolation == INTER_LANCZOS4 )
-            ifunc = lanczos4_tab[depth];
-        else
-            CV_Error( CV_StsBadArg, "Unknown interpolation method" );
-        CV_Assert( ifunc != 0 );
-        ctab = initInterTab2D( interpolation, fixpt );
-    }
-
-    const Mat *m1 = &map1, *m2 = &map2;
-
-    if( (map1.type() == CV_16SC2 && (map2.type() == CV_16UC1 || map2.type() == CV_16SC1)) ||
-        (map2.type() == CV_16SC2 && (map1.type() == CV_16UC1 || map1.type() == CV_16SC1)) )
-    {
-        if( map1.type() != CV_16SC2 )
-            std::swap(m1, m2);
-        if( ifunc )
-        {
-            ifunc( src, dst, *m1, *m2, ctab, borderType, borderValue );
-            return;
-        }
-    }
-    else
-    {
-        CV_Assert( (map1.type() == CV_32FC2 && !map2.data) ||
-            (map1.type() == CV_32FC1 && map2.type() == CV_32FC1) );
-        planar_input = map1.channels() == 1;
+        nnfunc = nn_tab[depth];
+        CV_Assert( nnfunc != 0 );
+        return;
     }
 
-    int x, y, x1, y1;
-    const int buf_size = 1 << 14;
-    int brows0 = std::min(128, dst.rows);
-    int bcols0 = std::min(buf_size/brows0, dst.cols);
-    brows0 = std::min(buf_size/bcols0, dst.rows);
-#if CV_SSE2
-    bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
+    if( interpolation == INTER_AREA )
+        interpolation = INTER_LINEAR;
+
+    if( interpolation == INTER_LINEAR )
+        ifunc = linear_tab[depth];
+    else if( interpolation == INTER_CUBIC )
+        ifunc = cubic_tab[depth];
+    else if( interpolation == INTER_LANCZOS4 )
+        ifunc = lanczos4_tab[depth];
+    else
+        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
+    CV_Assert( ifunc != 0 );
+    ctab = initInterTab2D( interpolation, depth == CV_8U );
+}
 
-    Mat _bufxy(brows0, bcols0, CV_16SC2), _bufa;
-    if( !nnfunc )
-        _bufa.create(brows0, bcols0, CV_16UC1);
+// the destination is split into the bands of about 64K pixels that are processed in parallel
+static int getWarpBandHeight( Size dsize )
+{
+    return std::max(std::min((1 << 16)/std::max(dsize.width, 1), dsize.height), 1);
+}
 
-    for( y = 0; y < dst.rows; y += brows0 )
+/*
+   Remaps a band of the destination rows. The fixed-point maps are passed to the kernel
+   as they are, the floating-point ones are converted block by block into the buffers of the band.
+*/
+class RemapInvoker
+{
+public:
+    RemapInvoker( const Mat& _src, Mat& _dst, const Mat& _m1, const Mat& _m2,
+                  RemapNNFunc _nnfunc, RemapFunc _ifunc, const void* _ctab,
+                  int _borderType, const Scalar& _borderValue, int _bandHeight )
+        : src(&_src), dst(&_dst), m1(&_m1), m2(&_m2), nnfunc(_nnfunc), ifunc(_ifunc),
+        ctab(_ctab), borderType(_borderType), borderValue(_borderValue), bandHeight(_bandHeight) {}
+
+    void operator()( const BlockedRange& range ) const
     {
-        for( x = 0; x < dst.cols; x += bcols0 )
-        {
-            int brows = std::min(brows0, dst.rows - y);
-            int bcols = std::min(bcols0, dst.cols - x);
-            Mat dpart(dst, Rect(x, y, bcols, brows));
-            Mat bufxy(_bufxy, Rect(0, 0, bcols, brows));
+        int y0 = range.begin()*bandHeight, y1 = std::min(range.end()*bandHeight, dst->rows);
+        const Mat &map1 = *m1, &map2 = *m2;
+        int map_depth = map1.depth();
+        bool planar_input = map1.channels() == 1;
 
+        if( map1.type() == CV_16SC2 && (ifunc || !map2.data) )
+        {
+            Mat dpart = dst->rowRange(y0, y1);
             if( nnfunc )
+                nnfunc( *src, dpart, map1.rowRange(y0, y1), borderType, borderValue );
+            else
+                ifunc( *src, dpart, map1.rowRange(y0, y1), map2.rowRange(y0, y1),
+                       ctab, borderType, borderValue );
+            return;
+        }
+
+        int x, y, x1, y2;
+        const int buf_size = 1 << 14;
+        int brows0 = std::min(128, y1 - y0);
+        int bcols0 = std::min(buf_size/brows0, dst->cols);
+        brows0 = std::min(buf_size/bcols0, y1 - y0);
+    #if CV_SSE2
+        bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+    #endif
+    #ifdef HAVE_DISPATCH_AVX
+        bool useAVX = checkHardwareSupport(CV_CPU_AVX);
+    #endif
+
+        Mat _bufxy(brows0, bcols0, CV_16SC2), _bufa;
+        if( !nnfunc )
+            _bufa.create(brows0, bcols0, CV_16UC1);
+
+        for( y = y0; y < y1; y += brows0 )
+        {
+            for( x = 0; x < dst->cols; x += bcols0 )
             {
-                if( map_depth != CV_32F )
+                int brows = std::min(brows0, y1 - y);
+                int bcols = std::min(bcols0, dst->cols - x);
+                Mat dpart(*dst, Rect(x, y, bcols, brows));
+                Mat bufxy(_bufxy, Rect(0, 0, bcols, brows));
+
+                if( nnfunc )
                 {
-                    for( y1 = 0; y1 < brows; y1++ )
+                    if( map_depth != CV_32F )
                     {
-                        short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                        const short* sXY = (const short*)(m1->data + m1->step*(y+y1)) + x*2;
-                        const ushort* sA = (const ushort*)(m2->data + m2->step*(y+y1)) + x;
+                        for( y2 = 0; y2 < brows; y2++ )
+                        {
+                            short* XY = (short*)(bufxy.data + bufxy.step*y2);
+                            const short* sXY = (const short*)(map1.data + map1.step*(y+y2)) + x*2;
+                            const ushort* sA = (const ushort*)(map2.data + map2.step*(y+y2)) + x;
 
-                        for( x1 = 0; x1 < bcols; x1++ )
+                            for( x1 = 0; x1 < bcols; x1++ )
+                            {
+                                int a = sA[x1] & (INTER_TAB_SIZE2-1);
+                                XY[x1*2] = sXY[x1*2] + NNDeltaTab_i[a][0];
+                                XY[x1*2+1] = sXY[x1*2+1] + NNDeltaTab_i[a][1];
+                            }
+                        }
+                    }
+                    else if( !planar_input )
+                        map1(Rect(x, y, bcols, brows)).convertTo(bufxy, bufxy.depth());
+                    else
+                    {
+                        for( y2 = 0; y2 < brows; y2++ )
                         {
-                            int a = sA[x1] & (INTER_TAB_SIZE2-1);
-                            XY[x1*2] = sXY[x1*2] + NNDeltaTab_i[a][0];
-                            XY[x1*2+1] = sXY[x1*2+1] + NNDeltaTab_i[a][1];
+                            short* XY = (short*)(bufxy.data + bufxy.step*y2);
+                            const float* sX = (const float*)(map1.data + map1.step*(y+y2)) + x;
+                            const float* sY = (const float*)(map2.data + map2.step*(y+y2)) + x;
+                            x1 = 0;
+
+                        #if CV_SSE2
+                            if( useSIMD )
+                            {
+                                for( ; x1 <= bcols - 8; x1 += 8 )
+                                {
+                                    __m128 fx0 = _mm_loadu_ps(sX + x1);
+                                    __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
+                                    __m128 fy0 = _mm_loadu_ps(sY + x1);
+                                    __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
+                                    __m128i ix0 = _mm_cvtps_epi32(fx0);
+                                    __m128i ix1 = _mm_cvtps_epi32(fx1);
+                                    __m128i iy0 = _mm_cvtps_epi32(fy0);
+                                    __m128i iy1 = _mm_cvtps_epi32(fy1);
+                                    ix0 = _mm_packs_epi32(ix0, ix1);
+                                    iy0 = _mm_packs_epi32(iy0, iy1);
+                                    ix1 = _mm_unpacklo_epi16(ix0, iy0);
+                                    iy1 = _mm_unpackhi_epi16(ix0, iy0);
+                                    _mm_storeu_si128((__m128i*)(XY + x1*2), ix1);
+                                    _mm_storeu_si128((__m128i*)(XY + x1*2 + 8), iy1);
+                                }
+                            }
+                        #endif
+
+                            for( ; x1 < bcols; x1++ )
+                            {
+                                XY[x1*2] = saturate_cast<short>(sX[x1]);
+                                XY[x1*2+1] = saturate_cast<short>(sY[x1]);
+                            }
                         }
                     }
+                    nnfunc( *src, dpart, bufxy, borderType, borderValue );
+                    continue;
                 }
-                else if( !planar_input )
-                    map1(Rect(0,0,bcols,brows)).convertTo(bufxy, bufxy.depth());
-                else
+
+                Mat bufa(_bufa, Rect(0, 0, bcols, brows));
+                for( y2 = 0; y2 < brows; y2++ )
                 {
-                    for( y1 = 0; y1 < brows; y1++ )
+                    short* XY = (short*)(bufxy.data + bufxy.step*y2);
+                    ushort* A = (ushort*)(bufa.data + bufa.step*y2);
+
+                    if( planar_input )
                     {
-                        short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                        const float* sX = (const float*)(map1.data + map1.step*(y+y1)) + x;
-                        const float* sY = (const float*)(map2.data + map2.step*(y+y1)) + x;
-                        x1 = 0;
+                        const float* sX = (const float*)(map1.data + map1.step*(y+y2)) + x;
+                        const float* sY = (const float*)(map2.data + map2.step*(y+y2)) + x;
 
+                        x1 = 0;
+                    #ifdef HAVE_DISPATCH_AVX
+                        if( useAVX )
+                            x1 = opt_AVX::remapConvertMaps32f(sX, sY, XY, A, bcols);
+                    #endif
                     #if CV_SSE2
                         if( useSIMD )
                         {
+                            __m128 scale = _mm_set1_ps((float)INTER_TAB_SIZE);
+                            __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
                             for( ; x1 <= bcols - 8; x1 += 8 )
                             {
                                 __m128 fx0 = _mm_loadu_ps(sX + x1);
                                 __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
                                 __m128 fy0 = _mm_loadu_ps(sY + x1);
                                 __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
-                                __m128i ix0 = _mm_cvtps_epi32(fx0);
-                                __m128i ix1 = _mm_cvtps_epi32(fx1);
-                                __m128i iy0 = _mm_cvtps_epi32(fy0);
-                                __m128i iy1 = _mm_cvtps_epi32(fy1);
+                                __m128i ix0 = _mm_cvtps_epi32(_mm_mul_ps(fx0, scale));
+                                __m128i ix1 = _mm_cvtps_epi32(_mm_mul_ps(fx1, scale));
+                                __m128i iy0 = _mm_cvtps_epi32(_mm_mul_ps(fy0, scale));
+                                __m128i iy1 = _mm_cvtps_epi32(_mm_mul_ps(fy1, scale));
+                                __m128i mx0 = _mm_and_si128(ix0, mask);
+                                __m128i mx1 = _mm_and_si128(ix1, mask);
+                                __m128i my0 = _mm_and_si128(iy0, mask);
+                                __m128i my1 = _mm_and_si128(iy1, mask);
+                                mx0 = _mm_packs_epi32(mx0, mx1);
+                                my0 = _mm_packs_epi32(my0, my1);
+                                my0 = _mm_slli_epi16(my0, INTER_BITS);
+                                mx0 = _mm_or_si128(mx0, my0);
+                                _mm_storeu_si128((__m128i*)(A + x1), mx0);
+                                ix0 = _mm_srai_epi32(ix0, INTER_BITS);
+                                ix1 = _mm_srai_epi32(ix1, INTER_BITS);
+                                iy0 = _mm_srai_epi32(iy0, INTER_BITS);
+                                iy1 = _mm_srai_epi32(iy1, INTER_BITS);
                                 ix0 = _mm_packs_epi32(ix0, ix1);
                                 iy0 = _mm_packs_epi32(iy0, iy1);
                                 ix1 = _mm_unpacklo_epi16(ix0, iy0);
@@ -2577,93 +3953,91 @@ void cv::remap( InputArray _src, OutputArray _dst,
 
                         for( ; x1 < bcols; x1++ )
                         {
-                            XY[x1*2] = saturate_cast<short>(sX[x1]);
-                            XY[x1*2+1] = saturate_cast<short>(sY[x1]);
+                            int sx = cvRound(sX[x1]*INTER_TAB_SIZE);
+                            int sy = cvRound(sY[x1]*INTER_TAB_SIZE);
+                            int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
+                            XY[x1*2] = (short)(sx >> INTER_BITS);
+                            XY[x1*2+1] = (short)(sy >> INTER_BITS);
+                            A[x1] = (ushort)v;
                         }
                     }
-                }
-                nnfunc( src, dpart, bufxy, borderType, borderValue );
-                continue;
-            }
-
-            Mat bufa(_bufa, Rect(0,0,bcols, brows));
-            for( y1 = 0; y1 < brows; y1++ )
-            {
-                short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                ushort* A = (ushort*)(bufa.data + bufa.step*y1);
-
-                if( planar_input )
-                {
-                    const float* sX = (const float*)(map1.data + map1.step*(y+y1)) + x;
-                    const float* sY = (const float*)(map2.data + map2.step*(y+y1)) + x;
-
-                    x1 = 0;
-                #if CV_SSE2
-                    if( useSIMD )
+                    else
                     {
-                        __m128 scale = _mm_set1_ps((float)INTER_TAB_SIZE);
-                        __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
-                        for( ; x1 <= bcols - 8; x1 += 8 )
+                        const float* sXY = (const float*)(map1.data + map1.step*(y+y2)) + x*2;
+
+                        x1 = 0;
+                    #ifdef HAVE_DISPATCH_AVX
+                        if( useAVX )
+                            x1 = opt_AVX::remapConvertMaps32fc2(sXY, XY, A, bcols);
+                    #endif
+                        for( ; x1 < bcols; x1++ )
                         {
-                            __m128 fx0 = _mm_loadu_ps(sX + x1);
-                            __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
-                            __m128 fy0 = _mm_loadu_ps(sY + x1);
-                            __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
-                            __m128i ix0 = _mm_cvtps_epi32(_mm_mul_ps(fx0, scale));
-                            __m128i ix1 = _mm_cvtps_epi32(_mm_mul_ps(fx1, scale));
-                            __m128i iy0 = _mm_cvtps_epi32(_mm_mul_ps(fy0, scale));
-                            __m128i iy1 = _mm_cvtps_epi32(_mm_mul_ps(fy1, scale));
-                            __m128i mx0 = _mm_and_si128(ix0, mask);
-                            __m128i mx1 = _mm_and_si128(ix1, mask);
-                            __m128i my0 = _mm_and_si128(iy0, mask);
-                            __m128i my1 = _mm_and_si128(iy1, mask);
-                            mx0 = _mm_packs_epi32(mx0, mx1);
-                            my0 = _mm_packs_epi32(my0, my1);
-                            my0 = _mm_slli_epi16(my0, INTER_BITS);
-                            mx0 = _mm_or_si128(mx0, my0);
-                            _mm_storeu_si128((__m128i*)(A + x1), mx0);
-                            ix0 = _mm_srai_epi32(ix0, INTER_BITS);
-                            ix1 = _mm_srai_epi32(ix1, INTER_BITS);
-                            iy0 = _mm_srai_epi32(iy0, INTER_BITS);
-                            iy1 = _mm_srai_epi32(iy1, INTER_BITS);
-                            ix0 = _mm_packs_epi32(ix0, ix1);
-                            iy0 = _mm_packs_epi32(iy0, iy1);
-                            ix1 = _mm_unpacklo_epi16(ix0, iy0);
-                            iy1 = _mm_unpackhi_epi16(ix0, iy0);
-                            _mm_storeu_si128((__m128i*)(XY + x1*2), ix1);
-                            _mm_storeu_si128((__m128i*)(XY + x1*2 + 8), iy1);
+                            int sx = cvRound(sXY[x1*2]*INTER_TAB_SIZE);
+                            int sy = cvRound(sXY[x1*2+1]*INTER_TAB_SIZE);
+                            int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
+                            XY[x1*2] = (short)(sx >> INTER_BITS);
+                            XY[x1*2+1] = (short)(sy >> INTER_BITS);
+                            A[x1] = (ushort)v;
                         }
                     }
-                #endif
-
-                    for( ; x1 < bcols; x1++ )
-                    {
-                        int sx = cvRound(sX[x1]*INTER_TAB_SIZE);
-                        int sy = cvRound(sY[x1]*INTER_TAB_SIZE);
-                        int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
-                        XY[x1*2] = (short)(sx >> INTER_BITS);
-                        XY[x1*2+1] = (short)(sy >> INTER_BITS);
-                        A[x1] = (ushort)v;
-                    }
-                }
-                else
-                {
-                    const float* sXY = (const float*)(map1.data + map1.step*(y+y1)) + x*2;
-
-                    for( x1 = 0; x1 < bcols; x1++ )
-                    {
-                        int sx = cvRound(sXY[x1*2]*INTER_TAB_SIZE);
-                        int sy = cvRound(sXY[x1*2+1]*INTER_TAB_SIZE);
-                        int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
-                        XY[x1*2] = (short)(sx >> INTER_BITS);
-                        XY[x1*2+1] = (short)(sy >> INTER_BITS);
-                        A[x1] = (ushort)v;
-                    }
                 }
+                ifunc( *src, dpart, bufxy, bufa, ctab, borderType, borderValue );
             }
-            ifunc(src, dpart, bufxy, bufa, ctab, borderType, borderValue);
         }
     }
+
+protected:
+    const Mat* src;
+    Mat* dst;
+    const Mat *m1, *m2;
+    RemapNNFunc nnfunc;
+    RemapFunc ifunc;
+    const void* ctab;
+    int borderType;
+    Scalar borderValue;
+    int bandHeight;
+};
+
+}
+    
+void cv::remap( InputArray _src, OutputArray _dst,
+                InputArray _map1, InputArray _map2,
+                int interpolation, int borderType, const Scalar& borderValue )
+{
+    CV_TRACE_REGION("cv::remap");
+    Mat src = _src.getMat(), map1 = _map1.getMat(), map2 = _map2.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
+    
+    CV_Assert( (!map2.data || map2.size() == map1.size()));
+    
+    _dst.create( map1.size(), src.type() );
+    Mat dst = _dst.getMat();
+    CV_Assert(dst.data != src.data);
+
+    RemapNNFunc nnfunc;
+    RemapFunc ifunc;
+    const void* ctab;
+    getRemapFuncs( src.depth(), interpolation, nnfunc, ifunc, ctab );
+
+    const Mat *m1 = &map1, *m2 = &map2;
+
+    if( (map1.type() == CV_16SC2 && (map2.type() == CV_16UC1 || map2.type() == CV_16SC1)) ||
+        (map2.type() == CV_16SC2 && (map1.type() == CV_16UC1 || map1.type() == CV_16SC1)) )
+    {
+        if( map1.type() != CV_16SC2 )
+            std::swap(m1, m2);
+    }
+    else
+    {
+        CV_Assert( (map1.type() == CV_32FC2 && !map2.data) ||
+            (map1.type() == CV_32FC1 && map2.type() == CV_32FC1) ||
+            (nnfunc && map1.type() == CV_16SC2 && !map2.data) );
+    }
+
+    int bandHeight = getWarpBandHeight(dst.size());
+    parallel_for(BlockedRange(0, (dst.rows + bandHeight - 1)/bandHeight),
+                 RemapInvoker(src, dst, *m1, *m2, nnfunc, ifunc, ctab,
+                              borderType, borderValue, bandHeight));
 }
 
 
@@ -2806,23 +4180,16 @@ void cv::convertMaps( InputArray _map1, InputArray _map2,
 }
 
 
-void cv::warpAffine( InputArray _src, OutputArray _dst,
-                     InputArray _M0, Size dsize,
-                     int flags, int borderType, const Scalar& borderValue )
+namespace cv
 {
-    Mat src = _src.getMat(), M0 = _M0.getMat();
-    _dst.create( dsize.area() == 0 ? src.size() : dsize, src.type() );
-    Mat dst = _dst.getMat();
-    CV_Assert( dst.data != src.data && src.cols > 0 && src.rows > 0 );
 
-    const int BLOCK_SZ = 64;
-    short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
-    double M[6];
-    Mat matM(2, 3, CV_64F, M);
-    int interpolation = flags & INTER_MAX;
-    if( interpolation == INTER_AREA )
-        interpolation = INTER_LINEAR;
+static const int AB_BITS = MAX(10, (int)INTER_BITS);
+static const int AB_SCALE = 1 << AB_BITS;
 
+// converts the warpAffine matrix to double and inverts it unless WARP_INVERSE_MAP is set
+static void getAffineWarpMatrix( const Mat& M0, int flags, double* M )
+{
+    Mat matM(2, 3, CV_64F, M);
     CV_Assert( (M0.type() == CV_32F || M0.type() == CV_64F) && M0.rows == 2 && M0.cols == 3 );
     M0.convertTo(matM, matM.type());
 
@@ -2837,201 +4204,372 @@ void cv::warpAffine( InputArray _src, OutputArray _dst,
         double b2 = -M[3]*M[2] - M[4]*M[5];
         M[2] = b1; M[5] = b2;
     }
+}
 
-    int x, y, x1, y1, width = dst.cols, height = dst.rows;
-    AutoBuffer<int> _abdelta(width*2);
-    int* adelta = &_abdelta[0], *bdelta = adelta + width;
-    const int AB_BITS = MAX(10, (int)INTER_BITS);
-    const int AB_SCALE = 1 << AB_BITS;
-    int round_delta = interpolation == INTER_NEAREST ? AB_SCALE/2 : AB_SCALE/INTER_TAB_SIZE/2;
-#if CV_SSE2
-    bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
+static void getPerspectiveWarpMatrix( const Mat& M0, int flags, double* M )
+{
+    Mat matM(3, 3, CV_64F, M);
+    CV_Assert( (M0.type() == CV_32F || M0.type() == CV_64F) && M0.rows == 3 && M0.cols == 3 );
+    M0.convertTo(matM, matM.type());
+
+    if( !(flags & WARP_INVERSE_MAP) )
+         invert(matM, matM);
+}
 
-    for( x = 0; x < width; x++ )
+// the fixed-point increments of the source coordinates along the destination row
+static void initAffineDeltas( const double* M, int width, int* adelta, int* bdelta )
+{
+    for( int x = 0; x < width; x++ )
     {
         adelta[x] = saturate_cast<int>(M[0]*x*AB_SCALE);
         bdelta[x] = saturate_cast<int>(M[3]*x*AB_SCALE);
     }
+}
+
+/*
+   Computes the source coordinates of bw consecutive pixels in the row y of the warpAffine
+   output in the format of remap() maps: the integer coordinates and, unless the interpolation
+   is INTER_NEAREST, the indices of the interpolation weights. adelta and bdelta point to
+   the increments of the first of the pixels.
+*/
+static void warpAffineRow( const double* M, const int* adelta, const int* bdelta, int y, int bw,
+                           int interpolation, short* xy, short* alpha )
+{
+    int round_delta = interpolation == INTER_NEAREST ? AB_SCALE/2 : AB_SCALE/INTER_TAB_SIZE/2;
+    int X0 = saturate_cast<int>((M[1]*y + M[2])*AB_SCALE) + round_delta;
+    int Y0 = saturate_cast<int>((M[4]*y + M[5])*AB_SCALE) + round_delta;
+    int x1 = 0;
+
+#ifdef HAVE_DISPATCH_SSE4_1
+    if( checkHardwareSupport(CV_CPU_SSE4_1) )
+        x1 = opt_SSE4_1::warpAffineCoords(adelta, bdelta, X0, Y0, AB_BITS,
+                                          interpolation == INTER_NEAREST, xy, alpha, bw);
+#endif
 
-    int bh0 = std::min(BLOCK_SZ/2, height);
-    int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, width);
-    bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, height);
+    if( interpolation == INTER_NEAREST )
+    {
+        for( ; x1 < bw; x1++ )
+        {
+            int X = (X0 + adelta[x1]) >> AB_BITS;
+            int Y = (Y0 + bdelta[x1]) >> AB_BITS;
+            xy[x1*2] = saturate_cast<short>(X);
+            xy[x1*2+1] = saturate_cast<short>(Y);
+        }
+        return;
+    }
 
-    for( y = 0; y < height; y += bh0 )
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
     {
-        for( x = 0; x < width; x += bw0 )
+        __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
+        __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
+        for( ; x1 <= bw - 8; x1 += 8 )
+        {
+            __m128i tx0, tx1, ty0, ty1;
+            tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x1)), XX);
+            ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x1)), YY);
+            tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x1 + 4)), XX);
+            ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x1 + 4)), YY);
+
+            tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
+            ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
+            tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
+            ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
+
+            __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
+                                          _mm_and_si128(tx1, fxy_mask));
+            __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
+                                          _mm_and_si128(ty1, fxy_mask));
+            tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
+                                  _mm_srai_epi32(tx1, INTER_BITS));
+            ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
+                                  _mm_srai_epi32(ty1, INTER_BITS));
+            fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
+
+            _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
+            _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
+            _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
+        }
+    }
+#endif
+    for( ; x1 < bw; x1++ )
+    {
+        int X = (X0 + adelta[x1]) >> (AB_BITS - INTER_BITS);
+        int Y = (Y0 + bdelta[x1]) >> (AB_BITS - INTER_BITS);
+        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                            (X & (INTER_TAB_SIZE-1)));
+    }
+}
+
+// the same as warpAffineRow() for the pixels (x, y) ... (x + bw - 1, y) of the warpPerspective output
+static void warpPerspectiveRow( const double* M, int x, int y, int bw,
+                                int interpolation, short* xy, short* alpha )
+{
+    double X0 = M[1]*y + M[2];
+    double Y0 = M[4]*y + M[5];
+    double W0 = M[7]*y + M[8];
+    int x1;
+
+    if( interpolation == INTER_NEAREST )
+        for( x1 = 0; x1 < bw; x1++ )
+        {
+            double W = W0 + M[6]*(x + x1);
+            W = W ? 1./W : 0;
+            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*(x + x1))*W));
+            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*(x + x1))*W));
+            int X = saturate_cast<int>(fX);
+            int Y = saturate_cast<int>(fY);
+
+            xy[x1*2] = saturate_cast<short>(X);
+            xy[x1*2+1] = saturate_cast<short>(Y);
+        }
+    else
+        for( x1 = 0; x1 < bw; x1++ )
         {
-            int bw = std::min( bw0, width - x);
-            int bh = std::min( bh0, height - y);
+            double W = W0 + M[6]*(x + x1);
+            W = W ? INTER_TAB_SIZE/W : 0;
+            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*(x + x1))*W));
+            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*(x + x1))*W));
+            int X = saturate_cast<int>(fX);
+            int Y = saturate_cast<int>(fY);
+
+            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                                (X & (INTER_TAB_SIZE-1)));
+        }
+}
+
+/*
+   Warps a band of the destination rows. The maps are computed for small blocks
+   that stay in L1 cache while the block is remapped.
+*/
+class WarpInvoker
+{
+public:
+    WarpInvoker( const Mat& _src, Mat& _dst, const double* _M, bool _perspective,
+                 const int* _adelta, const int* _bdelta, int _interpolation,
+                 RemapNNFunc _nnfunc, RemapFunc _ifunc, const void* _ctab,
+                 int _borderType, const Scalar& _borderValue, int _bandHeight )
+        : src(&_src), dst(&_dst), perspective(_perspective), adelta(_adelta), bdelta(_bdelta),
+        interpolation(_interpolation), nnfunc(_nnfunc), ifunc(_ifunc), ctab(_ctab),
+        borderType(_borderType), borderValue(_borderValue), bandHeight(_bandHeight)
+    {
+        std::copy(_M, _M + (perspective ? 9 : 6), M);
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        const int BLOCK_SZ = 64;
+        short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
+        int y0 = range.begin()*bandHeight, y1 = std::min(range.end()*bandHeight, dst->rows);
+        int x, y, y2, width = dst->cols;
 
-            Mat _XY(bh, bw, CV_16SC2, XY), matA;
-            Mat dpart(dst, Rect(x, y, bw, bh));
+        int bh0 = std::min(BLOCK_SZ/2, y1 - y0);
+        int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, width);
+        bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, y1 - y0);
 
-            for( y1 = 0; y1 < bh; y1++ )
+        for( y = y0; y < y1; y += bh0 )
+        {
+            for( x = 0; x < width; x += bw0 )
             {
-                short* xy = XY + y1*bw*2;
-                int X0 = saturate_cast<int>((M[1]*(y + y1) + M[2])*AB_SCALE) + round_delta;
-                int Y0 = saturate_cast<int>((M[4]*(y + y1) + M[5])*AB_SCALE) + round_delta;
+                int bw = std::min( bw0, width - x);
+                int bh = std::min( bh0, y1 - y);
 
-                if( interpolation == INTER_NEAREST )
-                    for( x1 = 0; x1 < bw; x1++ )
-                    {
-                        int X = (X0 + adelta[x+x1]) >> AB_BITS;
-                        int Y = (Y0 + bdelta[x+x1]) >> AB_BITS;
-                        xy[x1*2] = saturate_cast<short>(X);
-                        xy[x1*2+1] = saturate_cast<short>(Y);
-                    }
-                else
+                Mat _XY(bh, bw, CV_16SC2, XY), matA(bh, bw, CV_16U, A);
+                Mat dpart(*dst, Rect(x, y, bw, bh));
+
+                for( y2 = 0; y2 < bh; y2++ )
                 {
-                    short* alpha = A + y1*bw;
-                    x1 = 0;
-                #if CV_SSE2
-                    if( useSIMD )
-                    {
-                        __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
-                        __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
-                        for( ; x1 <= bw - 8; x1 += 8 )
-                        {
-                            __m128i tx0, tx1, ty0, ty1;
-                            tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1)), XX);
-                            ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1)), YY);
-                            tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1 + 4)), XX);
-                            ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1 + 4)), YY);
-
-                            tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
-                            ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
-                            tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
-                            ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
-
-                            __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
-                                                          _mm_and_si128(tx1, fxy_mask));
-                            __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
-                                                          _mm_and_si128(ty1, fxy_mask));
-                            tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
-                                                          _mm_srai_epi32(tx1, INTER_BITS));
-                            ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
-                                                  _mm_srai_epi32(ty1, INTER_BITS));
-                            fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
-
-                            _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
-                            _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
-                            _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
-                        }
-                    }
-                #endif
-                    for( ; x1 < bw; x1++ )
-                    {
-                        int X = (X0 + adelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                        int Y = (Y0 + bdelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                (X & (INTER_TAB_SIZE-1)));
-                    }
+                    if( perspective )
+                        warpPerspectiveRow( M, x, y + y2, bw, interpolation,
+                                            XY + y2*bw*2, A + y2*bw );
+                    else
+                        warpAffineRow( M, adelta + x, bdelta + x, y + y2, bw, interpolation,
+                                       XY + y2*bw*2, A + y2*bw );
                 }
-            }
 
-            if( interpolation == INTER_NEAREST )
-                remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
-            else
-            {
-                Mat matA(bh, bw, CV_16U, A);
-                remap( src, dpart, _XY, matA, interpolation, borderType, borderValue );
+                if( nnfunc )
+                    nnfunc( *src, dpart, _XY, borderType, borderValue );
+                else
+                    ifunc( *src, dpart, _XY, matA, ctab, borderType, borderValue );
             }
         }
     }
+
+protected:
+    const Mat* src;
+    Mat* dst;
+    double M[9];
+    bool perspective;
+    const int *adelta, *bdelta;
+    int interpolation;
+    RemapNNFunc nnfunc;
+    RemapFunc ifunc;
+    const void* ctab;
+    int borderType;
+    Scalar borderValue;
+    int bandHeight;
+};
+
+// WarpPlan accepts the interpolation methods that remap() supports
+static int checkWarpInterpolation( int interpolation )
+{
+    if( interpolation == INTER_AREA )
+        interpolation = INTER_LINEAR;
+    if( interpolation != INTER_NEAREST && interpolation != INTER_LINEAR &&
+        interpolation != INTER_CUBIC && interpolation != INTER_LANCZOS4 )
+        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
+    return interpolation;
+}
+
+}
+
+void cv::warpAffine( InputArray _src, OutputArray _dst,
+                     InputArray _M0, Size dsize,
+                     int flags, int borderType, const Scalar& borderValue )
+{
+    CV_TRACE_REGION("cv::warpAffine");
+    Mat src = _src.getMat(), M0 = _M0.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
+    _dst.create( dsize.area() == 0 ? src.size() : dsize, src.type() );
+    Mat dst = _dst.getMat();
+    CV_Assert( dst.data != src.data && src.cols > 0 && src.rows > 0 );
+
+    double M[6];
+    getAffineWarpMatrix( M0, flags, M );
+
+    int interpolation = flags & INTER_MAX;
+    RemapNNFunc nnfunc;
+    RemapFunc ifunc;
+    const void* ctab;
+    getRemapFuncs( src.depth(), interpolation, nnfunc, ifunc, ctab );
+
+    AutoBuffer<int> _abdelta(dst.cols*2);
+    int* adelta = &_abdelta[0], *bdelta = adelta + dst.cols;
+    initAffineDeltas( M, dst.cols, adelta, bdelta );
+
+    int bandHeight = getWarpBandHeight(dst.size());
+    parallel_for(BlockedRange(0, (dst.rows + bandHeight - 1)/bandHeight),
+                 WarpInvoker(src, dst, M, false, adelta, bdelta, interpolation,
+                             nnfunc, ifunc, ctab, borderType, borderValue, bandHeight));
 }
 
 
 void cv::warpPerspective( InputArray _src, OutputArray _dst, InputArray _M0,
                           Size dsize, int flags, int borderType, const Scalar& borderValue )
 {
+    CV_TRACE_REGION("cv::warpPerspective");
     Mat src = _src.getMat(), M0 = _M0.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     _dst.create( dsize.area() == 0 ? src.size() : dsize, src.type() );
     Mat dst = _dst.getMat();
     
     CV_Assert( dst.data != src.data && src.cols > 0 && src.rows > 0 );
 
-    const int BLOCK_SZ = 32;
-    short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
     double M[9];
-    Mat matM(3, 3, CV_64F, M);
+    getPerspectiveWarpMatrix( M0, flags, M );
+
     int interpolation = flags & INTER_MAX;
-    if( interpolation == INTER_AREA )
-        interpolation = INTER_LINEAR;
+    RemapNNFunc nnfunc;
+    RemapFunc ifunc;
+    const void* ctab;
+    getRemapFuncs( src.depth(), interpolation, nnfunc, ifunc, ctab );
+
+    int bandHeight = getWarpBandHeight(dst.size());
+    parallel_for(BlockedRange(0, (dst.rows + bandHeight - 1)/bandHeight),
+                 WarpInvoker(src, dst, M, true, 0, 0, interpolation,
+                             nnfunc, ifunc, ctab, borderType, borderValue, bandHeight));
+}
 
-    CV_Assert( (M0.type() == CV_32F || M0.type() == CV_64F) && M0.rows == 3 && M0.cols == 3 );
-    M0.convertTo(matM, matM.type());
 
-    if( !(flags & WARP_INVERSE_MAP) )
-         invert(matM, matM);
+cv::WarpPlan::WarpPlan() : interpolation(INTER_LINEAR)
+{
+}
 
-    int x, y, x1, y1, width = dst.cols, height = dst.rows;
+cv::WarpPlan::WarpPlan( InputArray M, Size dsize, int flags ) : interpolation(INTER_LINEAR)
+{
+    create(M, dsize, flags);
+}
 
-    int bh0 = std::min(BLOCK_SZ/2, height);
-    int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, width);
-    bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, height);
+void cv::WarpPlan::create( InputArray _M0, Size dsize, int flags )
+{
+    Mat M0 = _M0.getMat();
+    CV_Assert( dsize.width > 0 && dsize.height > 0 && (M0.rows == 2 || M0.rows == 3) );
 
-    for( y = 0; y < height; y += bh0 )
-    {
-        for( x = 0; x < width; x += bw0 )
-        {
-            int bw = std::min( bw0, width - x);
-            int bh = std::min( bh0, height - y);
+    bool perspective = M0.rows == 3;
+    double M[9];
+    if( perspective )
+        getPerspectiveWarpMatrix( M0, flags, M );
+    else
+        getAffineWarpMatrix( M0, flags, M );
 
-            Mat _XY(bh, bw, CV_16SC2, XY), matA;
-            Mat dpart(dst, Rect(x, y, bw, bh));
+    interpolation = checkWarpInterpolation(flags & INTER_MAX);
+    xy.create(dsize, CV_16SC2);
+    if( interpolation == INTER_NEAREST )
+        fxy.release();
+    else
+        fxy.create(dsize, CV_16UC1);
 
-            for( y1 = 0; y1 < bh; y1++ )
-            {
-                short* xy = XY + y1*bw*2;
-                double X0 = M[0]*x + M[1]*(y + y1) + M[2];
-                double Y0 = M[3]*x + M[4]*(y + y1) + M[5];
-                double W0 = M[6]*x + M[7]*(y + y1) + M[8];
+    AutoBuffer<int> _abdelta(dsize.width*2);
+    int* adelta = &_abdelta[0], *bdelta = adelta + dsize.width;
+    if( !perspective )
+        initAffineDeltas( M, dsize.width, adelta, bdelta );
 
-                if( interpolation == INTER_NEAREST )
-                    for( x1 = 0; x1 < bw; x1++ )
-                    {
-                        double W = W0 + M[6]*x1;
-                        W = W ? 1./W : 0;
-                        double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                        double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                        int X = saturate_cast<int>(fX);
-                        int Y = saturate_cast<int>(fY);
-                        
-                        xy[x1*2] = saturate_cast<short>(X);
-                        xy[x1*2+1] = saturate_cast<short>(Y);
-                    }
-                else
-                {
-                    short* alpha = A + y1*bw;
-                    for( x1 = 0; x1 < bw; x1++ )
-                    {
-                        double W = W0 + M[6]*x1;
-                        W = W ? INTER_TAB_SIZE/W : 0;
-                        double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                        double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                        int X = saturate_cast<int>(fX);
-                        int Y = saturate_cast<int>(fY);
-                        
-                        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                (X & (INTER_TAB_SIZE-1)));
-                    }
-                }
-            }
+    for( int y = 0; y < dsize.height; y++ )
+    {
+        short* dxy = xy.ptr<short>(y);
+        short* alpha = fxy.data ? fxy.ptr<short>(y) : 0;
+        if( perspective )
+            warpPerspectiveRow( M, 0, y, dsize.width, interpolation, dxy, alpha );
+        else
+            warpAffineRow( M, adelta, bdelta, y, dsize.width, interpolation, dxy, alpha );
+    }
+}
 
-            if( interpolation == INTER_NEAREST )
-                remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
-            else
-            {
-                Mat matA(bh, bw, CV_16U, A);
-                remap( src, dpart, _XY, matA, interpolation, borderType, borderValue );
-            }
-        }
+void cv::WarpPlan::createMaps( InputArray _map1, InputArray _map2, int _interpolation )
+{
+    Mat map1 = _map1.getMat(), map2 = _map2.getMat();
+    interpolation = checkWarpInterpolation(_interpolation);
+
+    if( map2.type() == CV_16SC2 )
+        std::swap(map1, map2);
+
+    if( map1.type() != CV_16SC2 )
+    {
+        convertMaps( map1, map2, xy, fxy, CV_16SC2, interpolation == INTER_NEAREST );
+        return;
     }
+
+    // the maps are in the fixed-point format already
+    CV_Assert( map2.data ? map2.size() == map1.size() &&
+               (map2.type() == CV_16UC1 || map2.type() == CV_16SC1) :
+               interpolation == INTER_NEAREST );
+    map1.copyTo(xy);
+    if( map2.data )
+        Mat(map2.size(), CV_16UC1, map2.data, map2.step).copyTo(fxy);
+    else
+        fxy.release();
+}
+
+bool cv::WarpPlan::empty() const
+{
+    return xy.empty();
+}
+
+cv::Size cv::WarpPlan::size() const
+{
+    return xy.size();
+}
+
+void cv::WarpPlan::operator()( InputArray src, OutputArray dst,
+                               int borderMode, const Scalar& borderValue ) const
+{
+    CV_TRACE_REGION("cv::WarpPlan::operator()");
+    CV_Assert( !empty() );
+    remap( src, dst, xy, fxy, interpolation, borderMode, borderValue );
 }
 
 
@@ -0,0 +1,112 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* SSE4.1 version of the warpAffine coordinate computation. Unlike the SSE2 code in imgwarp.cpp
+   it also handles INTER_NEAREST. The results are the same as in the scalar code. */
+
+#include "precomp.hpp"
+
+#if CV_SSE4_1
+
+namespace cv
+{
+namespace opt_SSE4_1
+{
+
+int warpAffineCoords( const int* adelta, const int* bdelta, int X0, int Y0, int abBits,
+                      bool nearest, short* xy, short* alpha, int width )
+{
+    int x = 0;
+    __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
+
+    if( nearest )
+    {
+        __m128i shift = _mm_cvtsi32_si128(abBits);
+        for( ; x <= width - 8; x += 8 )
+        {
+            __m128i tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x)), XX);
+            __m128i ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x)), YY);
+            __m128i tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + 4)), XX);
+            __m128i ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + 4)), YY);
+
+            tx0 = _mm_packs_epi32(_mm_sra_epi32(tx0, shift), _mm_sra_epi32(tx1, shift));
+            ty0 = _mm_packs_epi32(_mm_sra_epi32(ty0, shift), _mm_sra_epi32(ty1, shift));
+            _mm_storeu_si128((__m128i*)(xy + x*2), _mm_unpacklo_epi16(tx0, ty0));
+            _mm_storeu_si128((__m128i*)(xy + x*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
+        }
+        return x;
+    }
+
+    __m128i shift = _mm_cvtsi32_si128(abBits - INTER_BITS);
+    __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
+    for( ; x <= width - 8; x += 8 )
+    {
+        __m128i tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x)), XX);
+        __m128i ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x)), YY);
+        __m128i tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + 4)), XX);
+        __m128i ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + 4)), YY);
+
+        tx0 = _mm_sra_epi32(tx0, shift);
+        ty0 = _mm_sra_epi32(ty0, shift);
+        tx1 = _mm_sra_epi32(tx1, shift);
+        ty1 = _mm_sra_epi32(ty1, shift);
+
+        // the fractional parts are in [0, INTER_TAB_SIZE), so the unsigned packing is exact
+        __m128i fx = _mm_packus_epi32(_mm_and_si128(tx0, fxy_mask), _mm_and_si128(tx1, fxy_mask));
+        __m128i fy = _mm_packus_epi32(_mm_and_si128(ty0, fxy_mask), _mm_and_si128(ty1, fxy_mask));
+        fx = _mm_or_si128(fx, _mm_slli_epi16(fy, INTER_BITS));
+
+        tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS), _mm_srai_epi32(tx1, INTER_BITS));
+        ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS), _mm_srai_epi32(ty1, INTER_BITS));
+
+        _mm_storeu_si128((__m128i*)(xy + x*2), _mm_unpacklo_epi16(tx0, ty0));
+        _mm_storeu_si128((__m128i*)(xy + x*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
+        _mm_storeu_si128((__m128i*)(alpha + x), fx);
+    }
+
+    return x;
+}
+
+}
+}
+
+#endif
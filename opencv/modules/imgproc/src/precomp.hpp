@@ -95,6 +95,42 @@ static inline Point normalizeAnchor( Point anchor, Size ksize )
 }
 
 void preprocess2DKernel( const Mat& kernel, vector<Point>& coords, vector<uchar>& coeffs );
+
+// Teh-Chin approximation of a closed chain-coded curve (approx.cpp). dst must have
+// space for max(count,1) points, the number of the written points is returned.
+int approxChainTC89( const schar* codes, int count, Point origin, int method, Point* dst );
+
+// The kernels built for the newer instruction sets; each of them processes a part of the row
+// and returns the number of processed elements, the rest is done by the generic code.
+#ifdef HAVE_DISPATCH_SSSE3
+namespace opt_SSSE3
+{
+// RGB2RGB<uchar>: the channel swap and the alpha channel addition/removal (color.ssse3.cpp)
+int cvtBGR2BGR8u( const uchar* src, uchar* dst, int n, int scn, int dcn, int blueIdx );
+}
+#endif
+
+#ifdef HAVE_DISPATCH_SSE4_1
+namespace opt_SSE4_1
+{
+// the coordinates of a warpAffine row in the remap format (imgwarp.sse4_1.cpp)
+int warpAffineCoords( const int* adelta, const int* bdelta, int X0, int Y0, int abBits,
+                      bool nearest, short* xy, short* alpha, int width );
+}
+#endif
+
+#ifdef HAVE_DISPATCH_AVX
+namespace opt_AVX
+{
+// RowVec_32f and SymmColumnVec_32f (filter.avx.cpp)
+int rowFilter32f( const float* src, const float* kx, int ksize, float* dst, int width, int cn );
+int symmColumnFilter32f( const float** src, const float* ky, int ksize2,
+                         float* dst, int width, float delta, bool symmetrical );
+// the conversion of the floating-point maps into the fixed-point ones in remap (imgwarp.avx.cpp)
+int remapConvertMaps32f( const float* sX, const float* sY, short* XY, ushort* A, int width );
+int remapConvertMaps32fc2( const float* sXY, short* XY, ushort* A, int width );
+}
+#endif
 void crossCorr( const Mat& src, const Mat& templ, Mat& dst,
                 Size corrsize, int ctype,
                 Point anchor=Point(0,0), double delta=0,
@@ -108,6 +108,15 @@ template<typename ST, typename T> struct ColumnSum : public BaseColumnFilter
     }
 
     void reset() { sumCount = 0; }
+
+    Ptr<BaseColumnFilter> clone() const
+    {
+        // a running floating-point sum depends on the row it has started from,
+        // so such a filter can not process the stripes of an image independently
+        if( DataType<ST>::depth >= CV_32F )
+            return Ptr<BaseColumnFilter>();
+        return new ColumnSum(*this);
+    }
     
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
     {
@@ -516,7 +525,7 @@ static inline void histogram_muladd( int a, const HT x[16],
 }
 
 static void
-medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
+medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize, int y0, int y1 )
 {
 /**
  * HOP is short for Histogram OPeration. This macro makes an operation \a op on
@@ -554,21 +563,19 @@ medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
         memset( h_coarse, 0, 16*n*cn*sizeof(h_coarse[0]) );
         memset( h_fine, 0, 16*16*n*cn*sizeof(h_fine[0]) );
 
-        // First row initialization
+        // First row initialization: the column histograms get the rows y0-r-1 ... y0+r-1,
+        // so that the first iteration below shifts them to the window of the row y0
         for( c = 0; c < cn; c++ )
         {
-            for( j = 0; j < n; j++ )
-                COP( c, j, src[cn*j+c], += r+2 );
-
-            for( i = 1; i < r; i++ )
+            for( i = y0-r-1; i < y0+r; i++ )
             {
-                const uchar* p = src + sstep*std::min(i, m-1);
+                const uchar* p = src + sstep*std::min(std::max(i, 0), m-1);
                 for ( j = 0; j < n; j++ )
                     COP( c, j, p[cn*j+c], ++ );
             }
         }
 
-        for( i = 0; i < m; i++ )
+        for( i = y0; i < y1; i++ )
         {
             const uchar* p0 = src + sstep * std::max( 0, i-r-1 );
             const uchar* p1 = src + sstep * std::min( m-1, i+r );
@@ -723,12 +730,242 @@ medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
 }
 
 
+#if CV_SSE2
+static inline void histogram256_add_simd( const HT x[256], HT y[256] )
+{
+    const __m128i* rx = (const __m128i*)x;
+    __m128i* ry = (__m128i*)y;
+    for( int i = 0; i < 32; i += 2 )
+    {
+        __m128i r0 = _mm_add_epi16(_mm_load_si128(ry+i),_mm_load_si128(rx+i));
+        __m128i r1 = _mm_add_epi16(_mm_load_si128(ry+i+1),_mm_load_si128(rx+i+1));
+        _mm_store_si128(ry+i, r0);
+        _mm_store_si128(ry+i+1, r1);
+    }
+}
+
+static inline void histogram256_sub_simd( const HT x[256], HT y[256] )
+{
+    const __m128i* rx = (const __m128i*)x;
+    __m128i* ry = (__m128i*)y;
+    for( int i = 0; i < 32; i += 2 )
+    {
+        __m128i r0 = _mm_sub_epi16(_mm_load_si128(ry+i),_mm_load_si128(rx+i));
+        __m128i r1 = _mm_sub_epi16(_mm_load_si128(ry+i+1),_mm_load_si128(rx+i+1));
+        _mm_store_si128(ry+i, r0);
+        _mm_store_si128(ry+i+1, r1);
+    }
+}
+#endif
+
+static inline void histogram256_add( const HT x[256], HT y[256], bool useSIMD )
+{
+#if MEDIAN_HAVE_SIMD
+    if( useSIMD )
+    {
+        histogram256_add_simd( x, y );
+        return;
+    }
+#endif
+    for( int i = 0; i < 256; ++i )
+        y[i] = (HT)(y[i] + x[i]);
+}
+
+static inline void histogram256_sub( const HT x[256], HT y[256], bool useSIMD )
+{
+#if MEDIAN_HAVE_SIMD
+    if( useSIMD )
+    {
+        histogram256_sub_simd( x, y );
+        return;
+    }
+#endif
+    for( int i = 0; i < 256; ++i )
+        y[i] = (HT)(y[i] - x[i]);
+}
+
+/**
+ * Finds the bin, at which the running sum of the histogram bins, started with sum,
+ * exceeds t. On return sum is the running sum of the preceding bins. As the total
+ * number of the counted pixels is below 65536, the partial sums of any bins fit
+ * into 16 bits, so the bins can be skipped by the blocks of 16 without overflow.
+ */
+static inline int histogram256_find( const HT h[256], int& sum, int t, bool useSIMD )
+{
+    int k = 0;
+#if MEDIAN_HAVE_SIMD
+    if( useSIMD )
+    {
+        for( ; k < 256; k += 16 )
+        {
+            __m128i v = _mm_add_epi16(_mm_load_si128((const __m128i*)(h + k)),
+                                      _mm_load_si128((const __m128i*)(h + k + 8)));
+            v = _mm_add_epi16(v, _mm_srli_si128(v, 8));
+            v = _mm_add_epi16(v, _mm_srli_si128(v, 4));
+            v = _mm_add_epi16(v, _mm_srli_si128(v, 2));
+            int s = _mm_cvtsi128_si32(v) & 0xffff;
+            if( sum + s > t )
+                break;
+            sum += s;
+        }
+    }
+#endif
+    for( ; k < 256; k++ )
+    {
+        if( sum + h[k] > t )
+            break;
+        sum += h[k];
+    }
+    return k;
+}
+
+/**
+ * The same constant-time algorithm for 16-bit images. The coarse level is indexed
+ * by the 8 MSBs of the value and the fine level by the 8 LSBs, so a fine column
+ * histogram takes 128K. The stripes are made narrow to keep the memory
+ * footprint moderate, and between the stripes only the bins counted by the
+ * last window are cleared, not the whole histograms. Signed values are mapped
+ * to the unsigned range by flipping the sign bit, which preserves their order.
+ */
+template<typename T> static void
+medianBlur_16u_O1( const Mat& _src, Mat& _dst, int ksize, int y0, int y1 )
+{
+#define COP(c,j,x,op) \
+    h_coarse[ 256*(n*c+j) + ((x)>>8) ] op, \
+    h_fine[ 256*((size_t)n*(256*c+((x)>>8))+j) + ((x) & 255) ] op
+
+    const int flip = DataType<T>::depth == CV_16S ? 0x8000 : 0;
+    int cn = _dst.channels(), m = _dst.rows, r = (ksize-1)/2;
+    size_t sstep = _src.step/sizeof(T), dstep = _dst.step/sizeof(T);
+    int STRIPE_SIZE = std::min( _dst.cols, 32 );
+    int nmax = STRIPE_SIZE + 2*r;
+
+    vector<HT> _h_coarse(256 * nmax * cn + 16);
+    vector<HT> _h_fine((size_t)256 * 256 * nmax * cn + 16);
+    vector<HT> _H_coarse(256 * cn + 16);
+    vector<HT> _H_fine(256 * 256 * cn + 16);
+    vector<int> _luc(256 * cn);
+    HT* h_coarse = alignPtr(&_h_coarse[0], 16);
+    HT* h_fine = alignPtr(&_h_fine[0], 16);
+    HT* H_coarse = alignPtr(&_H_coarse[0], 16);
+    HT* H_fine = alignPtr(&_H_fine[0], 16);
+    int* luc = &_luc[0];
+#if MEDIAN_HAVE_SIMD
+    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+#else
+    bool useSIMD = false;
+#endif
+
+    for( int x = 0; x < _dst.cols; x += STRIPE_SIZE )
+    {
+        int i, j, k, c, n = std::min(_dst.cols - x, STRIPE_SIZE) + r*2;
+        const T* src = (const T*)_src.data + x*cn;
+        T* dst = (T*)_dst.data + (x - r)*cn;
+
+        for( c = 0; c < cn; c++ )
+        {
+            for( i = y0-r-1; i < y0+r; i++ )
+            {
+                const T* p = src + sstep*std::min(std::max(i, 0), m-1);
+                for( j = 0; j < n; j++ )
+                {
+                    int v = (ushort)p[cn*j+c] ^ flip;
+                    COP( c, j, v, ++ );
+                }
+            }
+        }
+
+        for( i = y0; i < y1; i++ )
+        {
+            const T* p0 = src + sstep * std::max( 0, i-r-1 );
+            const T* p1 = src + sstep * std::min( m-1, i+r );
+
+            for( c = 0; c < cn; c++ )
+            {
+                HT* Hc = H_coarse + 256*c;
+                HT* Hf = H_fine + 256*256*c;
+                int* lucc = luc + 256*c;
+
+                for( j = 0; j < n; j++ )
+                {
+                    int v0 = (ushort)p0[j*cn + c] ^ flip;
+                    int v1 = (ushort)p1[j*cn + c] ^ flip;
+                    COP( c, j, v0, -- );
+                    COP( c, j, v1, ++ );
+                }
+
+                memset( Hc, 0, 256*sizeof(Hc[0]) );
+                memset( lucc, 0, 256*sizeof(lucc[0]) );
+                for( j = 0; j < 2*r; ++j )
+                    histogram256_add( &h_coarse[256*(n*c+j)], Hc, useSIMD );
+
+                for( j = r; j < n-r; j++ )
+                {
+                    int t = 2*r*r + 2*r, b, sum = 0;
+                    HT* segment;
+
+                    histogram256_add( &h_coarse[256*(n*c + std::min(j+r,n-1))], Hc, useSIMD );
+
+                    // Find median at coarse level
+                    k = histogram256_find( Hc, sum, t, useSIMD );
+                    assert( k < 256 );
+
+                    // Update corresponding histogram segment
+                    segment = Hf + 256*k;
+                    const HT* hf = h_fine + 256*(size_t)n*(256*c+k);
+                    if( lucc[k] <= j-r )
+                    {
+                        memset( segment, 0, 256*sizeof(HT) );
+                        for( lucc[k] = j-r; lucc[k] < std::min(j+r+1,n); ++lucc[k] )
+                            histogram256_add( hf + 256*lucc[k], segment, useSIMD );
+
+                        for( ; lucc[k] < j+r+1; ++lucc[k] )
+                            histogram256_add( hf + 256*(n-1), segment, useSIMD );
+                    }
+                    else
+                    {
+                        for( ; lucc[k] < j+r+1; ++lucc[k] )
+                        {
+                            histogram256_sub( hf + 256*std::max(lucc[k]-2*r-1,0), segment, useSIMD );
+                            histogram256_add( hf + 256*std::min(lucc[k],n-1), segment, useSIMD );
+                        }
+                    }
+
+                    histogram256_sub( &h_coarse[256*(n*c+std::max(j-r,0))], Hc, useSIMD );
+
+                    // Find median in segment
+                    b = histogram256_find( segment, sum, t, useSIMD );
+                    assert( b < 256 );
+                    dst[dstep*i+cn*j+c] = (T)((k*256 + b) ^ flip);
+                }
+            }
+        }
+
+        // reset the bins of the rows y1-r-1 ... y1+r-1, that are still counted in the column histograms
+        for( c = 0; c < cn; c++ )
+        {
+            for( i = y1-r-1; i < y1+r; i++ )
+            {
+                const T* p = src + sstep*std::min(std::max(i, 0), m-1);
+                for( j = 0; j < n; j++ )
+                {
+                    int v = (ushort)p[cn*j+c] ^ flip;
+                    COP( c, j, v, = 0 );
+                }
+            }
+        }
+    }
+
+#undef COP
+}
+
+
 #if _MSC_VER >= 1200
 #pragma warning( default: 4244 )
 #endif
 
 static void
-medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
+medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m, int y0, int y1 )
 {
     #define N  16
     int     zone0[4][N];
@@ -740,7 +977,6 @@ medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
     uchar*  dst = _dst.data;
     int     src_step = (int)_src.step, dst_step = (int)_dst.step;
     int     cn = _src.channels();
-    const uchar*  src_max = src + size.height*src_step;
 
     #define UPDATE_ACC01( pix, cn, op ) \
     {                                   \
@@ -752,46 +988,22 @@ medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
     //CV_Assert( size.height >= nx && size.width >= nx );
     for( x = 0; x < size.width; x++, src += cn, dst += cn )
     {
-        uchar* dst_cur = dst;
-        const uchar* src_top = src;
-        const uchar* src_bottom = src;
+        uchar* dst_cur = dst + dst_step*y0;
         int k, c;
-        int src_step1 = src_step, dst_step1 = dst_step;
-
-        if( x % 2 != 0 )
-        {
-            src_bottom = src_top += src_step*(size.height-1);
-            dst_cur += dst_step*(size.height-1);
-            src_step1 = -src_step1;
-            dst_step1 = -dst_step1;
-        }
 
-        // init accumulator
+        // init accumulator with the rows y0-m/2 ... y0+m/2
         memset( zone0, 0, sizeof(zone0[0])*cn );
         memset( zone1, 0, sizeof(zone1[0])*cn );
 
-        for( y = 0; y <= m/2; y++ )
+        for( y = y0 - m/2; y <= y0 + m/2; y++ )
         {
+            const uchar* src_bottom = src + src_step*std::min(std::max(y, 0), size.height-1);
             for( c = 0; c < cn; c++ )
-            {
-                if( y > 0 )
-                {
-                    for( k = 0; k < m*cn; k += cn )
-                        UPDATE_ACC01( src_bottom[k+c], c, ++ );
-                }
-                else
-                {
-                    for( k = 0; k < m*cn; k += cn )
-                        UPDATE_ACC01( src_bottom[k+c], c, += m/2+1 );
-                }
-            }
-
-            if( (src_step1 > 0 && y < size.height-1) ||
-                (src_step1 < 0 && size.height-y-1 > 0) )
-                src_bottom += src_step1;
+                for( k = 0; k < m*cn; k += cn )
+                    UPDATE_ACC01( src_bottom[k+c], c, ++ );
         }
 
-        for( y = 0; y < size.height; y++, dst_cur += dst_step1 )
+        for( y = y0; y < y1; y++, dst_cur += dst_step )
         {
             // find median
             for( c = 0; c < cn; c++ )
@@ -813,9 +1025,12 @@ medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
                 dst_cur[c] = (uchar)k;
             }
 
-            if( y+1 == size.height )
+            if( y+1 == y1 )
                 break;
 
+            const uchar* src_top = src + src_step*std::max(y - m/2, 0);
+            const uchar* src_bottom = src + src_step*std::min(y + m/2 + 1, size.height-1);
+
             if( cn == 1 )
             {
                 for( k = 0; k < m; k++ )
@@ -857,13 +1072,6 @@ medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
                     UPDATE_ACC01( src_bottom[k+3], 3, ++ );
                 }
             }
-
-            if( (src_step1 > 0 && src_bottom + src_step1 < src_max) ||
-                (src_step1 < 0 && src_bottom + src_step1 >= src) )
-                src_bottom += src_step1;
-
-            if( y >= m/2 )
-                src_top += src_step1;
         }
     }
 #undef N
@@ -1007,7 +1215,7 @@ typedef MinMax32f MinMaxVec32f;
 
 template<class Op, class VecOp>
 static void
-medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
+medianBlur_SortNet( const Mat& _src, Mat& _dst, int m, int y0, int y1 )
 {
     typedef typename Op::value_type T;
     typedef typename Op::arg_type WT;
@@ -1031,8 +1239,11 @@ medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
             int sdelta = size.height == 1 ? cn : sstep;
             int sdelta0 = size.height == 1 ? 0 : sstep - cn;
             int ddelta = size.height == 1 ? cn : dstep;
+            int ibegin = size.height == 1 ? 0 : y0, iend = size.height == 1 ? len : y1;
+            src += (sdelta0 + cn)*ibegin;
+            dst += ddelta*ibegin;
 
-            for( i = 0; i < len; i++, src += sdelta0, dst += ddelta )
+            for( i = ibegin; i < iend; i++, src += sdelta0, dst += ddelta )
                 for( j = 0; j < cn; j++, src++ )
                 {
                     WT p0 = src[i > 0 ? -sdelta : 0];
@@ -1046,7 +1257,7 @@ medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
         }
         
         size.width *= cn;
-        for( i = 0; i < size.height; i++, dst += dstep )
+        for( i = y0, dst += dstep*y0; i < y1; i++, dst += dstep )
         {
             const T* row0 = src + std::max(i - 1, 0)*sstep;
             const T* row1 = src + i*sstep;
@@ -1100,8 +1311,11 @@ medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
             int sdelta = size.height == 1 ? cn : sstep;
             int sdelta0 = size.height == 1 ? 0 : sstep - cn;
             int ddelta = size.height == 1 ? cn : dstep;
+            int ibegin = size.height == 1 ? 0 : y0, iend = size.height == 1 ? len : y1;
+            src += (sdelta0 + cn)*ibegin;
+            dst += ddelta*ibegin;
 
-            for( i = 0; i < len; i++, src += sdelta0, dst += ddelta )
+            for( i = ibegin; i < iend; i++, src += sdelta0, dst += ddelta )
                 for( j = 0; j < cn; j++, src++ )
                 {
                     int i1 = i > 0 ? -sdelta : 0;
@@ -1118,7 +1332,7 @@ medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
         }
 
         size.width *= cn;
-        for( i = 0; i < size.height; i++, dst += dstep )
+        for( i = y0, dst += dstep*y0; i < y1; i++, dst += dstep )
         {
             const T* row[5];
             row[0] = src + std::max(i - 2, 0)*sstep;
@@ -1217,11 +1431,151 @@ medianBlur_SortNet( const Mat& _src, Mat& _dst, int m )
     }
 }
 
+
+/**
+ * Forgetful selection: the buffer is filled with the first m*m/2+2 elements of the
+ * window. Then, at each step, the minimum and the maximum of the buffer, which can
+ * not be the median anymore, are dropped and the next element of the window is
+ * taken in. When all the elements are taken, 3 of them are left, and the median
+ * is the middle one. Only min/max operations are used, so the same code
+ * processes a single pixel with Op or VecOp::SIZE neighbour pixels with VecOp.
+ */
+template<class Op, typename T, typename WT> static inline WT
+forgetfulMedian( Op& op, WT* buf, const T** ptrs, int j, int n )
+{
+    int e, k, lo = 0, hi = n/2 + 1;
+
+    for( e = 0; e <= hi; e++ )
+        buf[e] = op.load(ptrs[e] + j);
+
+    for( ; e < n; e++ )
+    {
+        for( k = lo; k < hi; k++ )
+            op(buf[k], buf[k+1]);
+        for( k = hi-1; k > lo; k-- )
+            op(buf[k-1], buf[k]);
+        lo++;
+        buf[hi] = op.load(ptrs[e] + j);
+    }
+
+    op(buf[lo], buf[lo+1]); op(buf[lo+1], buf[lo+2]); op(buf[lo], buf[lo+1]);
+    return buf[lo+1];
+}
+
+// median filter for 7x7 and 9x9 windows, where the fixed sorting networks would be too large.
+// _src is expected to be extended by m/2 columns on the left and on the right
+template<class Op, class VecOp>
+static void
+medianBlur_Forgetful( const Mat& _src, Mat& _dst, int m, int y0, int y1 )
+{
+    typedef typename Op::value_type T;
+    typedef typename Op::arg_type WT;
+    typedef typename VecOp::arg_type VT;
+
+    int i, j, k, cn = _dst.channels(), n = m*m, r = m/2;
+    int width = _dst.cols*cn, height = _dst.rows;
+    size_t sstep = _src.step/sizeof(T);
+    Op op;
+    VecOp vop;
+    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+    AutoBuffer<const T*> _ptrs(n);
+    AutoBuffer<WT> _buf(n/2 + 2);
+    AutoBuffer<VT> _vbuf(n/2 + 2);
+    const T** ptrs = _ptrs;
+    WT* buf = _buf;
+    VT* vbuf = _vbuf;
+
+    for( i = y0; i < y1; i++ )
+    {
+        T* dst = (T*)(_dst.data + _dst.step*i);
+        for( k = 0; k < n; k++ )
+        {
+            int y = std::min(std::max(i + k/m - r, 0), height-1);
+            ptrs[k] = (const T*)_src.data + sstep*y + (k % m)*cn;
+        }
+
+        j = 0;
+        if( useSIMD )
+        {
+            for( ; j <= width - VecOp::SIZE; j += VecOp::SIZE )
+                vop.store(dst + j, forgetfulMedian(vop, vbuf, ptrs, j, n));
+        }
+
+        for( ; j < width; j++ )
+            dst[j] = (T)forgetfulMedian(op, buf, ptrs, j, n);
+    }
+}
+
+// median filter for the windows larger than 9x9, where the forgetful selection, that takes
+// O(m^4) operations per pixel, becomes slower than the generic selection algorithm
+template<typename T>
+static void
+medianBlur_Select( const Mat& _src, Mat& _dst, int m, int y0, int y1 )
+{
+    int i, j, k, cn = _dst.channels(), n = m*m, r = m/2;
+    int width = _dst.cols*cn, height = _dst.rows;
+    size_t sstep = _src.step/sizeof(T);
+    AutoBuffer<const T*> _ptrs(n);
+    AutoBuffer<T> _buf(n);
+    const T** ptrs = _ptrs;
+    T* buf = _buf;
+
+    for( i = y0; i < y1; i++ )
+    {
+        T* dst = (T*)(_dst.data + _dst.step*i);
+        for( k = 0; k < n; k++ )
+        {
+            int y = std::min(std::max(i + k/m - r, 0), height-1);
+            ptrs[k] = (const T*)_src.data + sstep*y + (k % m)*cn;
+        }
+
+        for( j = 0; j < width; j++ )
+        {
+            for( k = 0; k < n; k++ )
+                buf[k] = ptrs[k][j];
+            std::nth_element(buf, buf + n/2, buf + n);
+            dst[j] = buf[n/2];
+        }
+    }
+}
+
+typedef void (*MedianBlurFunc)( const Mat& src, Mat& dst, int ksize, int y0, int y1 );
+
+class MedianBlurInvoker
+{
+public:
+    MedianBlurInvoker( const Mat& _src, Mat& _dst, int _ksize, MedianBlurFunc _func, int _nbands )
+    {
+        src = _src;
+        dst = _dst;
+        ksize = _ksize;
+        func = _func;
+        nbands = _nbands;
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int y0 = (int)((int64)range.begin()*dst.rows/nbands);
+        int y1 = (int)((int64)range.end()*dst.rows/nbands);
+        Mat d = dst;
+        func( src, d, ksize, y0, y1 );
+    }
+
+private:
+    Mat src;
+    Mat dst;
+    int ksize;
+    MedianBlurFunc func;
+    int nbands;
+};
+
 }
     
 void cv::medianBlur( InputArray _src0, OutputArray _dst, int ksize )
 {
+    CV_TRACE_REGION("cv::medianBlur");
     Mat src0 = _src0.getMat();
+    CV_TRACE_BYTES(src0.total()*src0.elemSize());
     _dst.create( src0.size(), src0.type() );
     Mat dst = _dst.getMat();
     
@@ -1234,10 +1588,10 @@ void cv::medianBlur( InputArray _src0, OutputArray _dst, int ksize )
     CV_Assert( ksize % 2 == 1 );
     
     Size size = src0.size();
-    int cn = src0.channels();
+    int cn = src0.channels(), depth = src0.depth();
     bool useSortNet = ksize == 3 || (ksize == 5
 #if !CV_SSE2
-            && src0.depth() > CV_8U
+            && depth > CV_8U
 #endif
         );
     
@@ -1252,28 +1606,51 @@ void cv::medianBlur( InputArray _src0, OutputArray _dst, int ksize )
     else
         cv::copyMakeBorder( src0, src, 0, 0, ksize/2, ksize/2, BORDER_REPLICATE );
 
+    MedianBlurFunc func = 0;
     if( useSortNet )
     {
-        if( src.depth() == CV_8U )
-            medianBlur_SortNet<MinMax8u, MinMaxVec8u>( src, dst, ksize );
-        else if( src.depth() == CV_16U )
-            medianBlur_SortNet<MinMax16u, MinMaxVec16u>( src, dst, ksize );
-        else if( src.depth() == CV_16S )
-            medianBlur_SortNet<MinMax16s, MinMaxVec16s>( src, dst, ksize );
-        else if( src.depth() == CV_32F )
-            medianBlur_SortNet<MinMax32f, MinMaxVec32f>( src, dst, ksize );
+        if( depth == CV_8U )
+            func = medianBlur_SortNet<MinMax8u, MinMaxVec8u>;
+        else if( depth == CV_16U )
+            func = medianBlur_SortNet<MinMax16u, MinMaxVec16u>;
+        else if( depth == CV_16S )
+            func = medianBlur_SortNet<MinMax16s, MinMaxVec16s>;
+        else if( depth == CV_32F )
+            func = medianBlur_SortNet<MinMax32f, MinMaxVec32f>;
         else
             CV_Error(CV_StsUnsupportedFormat, "");
-        return;
     }
+    else if( depth == CV_8U )
+    {
+        CV_Assert( cn == 1 || cn == 3 || cn == 4 );
 
-    CV_Assert( src.depth() == CV_8U && (cn == 1 || cn == 3 || cn == 4) );
+        double img_size_mp = (double)(size.width*size.height)/(1 << 20);
+        if( ksize <= 3 + (img_size_mp < 1 ? 12 : img_size_mp < 4 ? 6 : 2)*(MEDIAN_HAVE_SIMD && checkHardwareSupport(CV_CPU_SSE2) ? 1 : 3))
+            func = medianBlur_8u_Om;
+        else
+            func = medianBlur_8u_O1;
+    }
+    else if( depth == CV_16U )
+        func = medianBlur_16u_O1<ushort>;
+    else if( depth == CV_16S )
+        func = medianBlur_16u_O1<short>;
+    else if( depth == CV_32F )
+    {
+        if( ksize <= 9 )
+            func = medianBlur_Forgetful<MinMax32f, MinMaxVec32f>;
+        else
+            func = medianBlur_Select<float>;
+    }
+    else
+        CV_Error(CV_StsUnsupportedFormat, "");
 
-    double img_size_mp = (double)(size.width*size.height)/(1 << 20);
-    if( ksize <= 3 + (img_size_mp < 1 ? 12 : img_size_mp < 4 ? 6 : 2)*(MEDIAN_HAVE_SIMD && checkHardwareSupport(CV_CPU_SSE2) ? 1 : 3))
-        medianBlur_8u_Om( src, dst, ksize );
+    // the bands of rows are filtered independently; each of them reads ksize/2 rows
+    // of the neighbour bands (or the replicated border rows) around itself
+    int nbands = std::min(getNumThreads(), size.height/std::max(ksize*4, 32));
+    if( nbands <= 1 )
+        func( src, dst, ksize, 0, size.height );
     else
-        medianBlur_8u_O1( src, dst, ksize );
+        parallel_for( BlockedRange(0, nbands), MedianBlurInvoker(src, dst, ksize, func, nbands) );
 }
 
 /****************************************************************************************\
@@ -1283,13 +1660,86 @@ void cv::medianBlur( InputArray _src0, OutputArray _dst, int ksize )
 namespace cv
 {
 
+class BilateralFilter_8u_Invoker
+{
+public:
+    BilateralFilter_8u_Invoker( const Mat& _temp, Mat& _dest, int _radius, int _maxk,
+                                const int* _space_ofs, const float* _space_weight,
+                                const float* _color_weight ) :
+        temp(&_temp), dest(&_dest), radius(_radius), maxk(_maxk),
+        space_ofs(_space_ofs), space_weight(_space_weight), color_weight(_color_weight)
+    {
+    }
+
+    void operator()( const BlockedRange& range ) const
+    {
+        int i, j, k, cn = dest->channels();
+        Size size = dest->size();
+
+        for( i = range.begin(); i < range.end(); i++ )
+        {
+            const uchar* sptr = temp->data + (i+radius)*temp->step + radius*cn;
+            uchar* dptr = dest->data + i*dest->step;
+
+            if( cn == 1 )
+            {
+                for( j = 0; j < size.width; j++ )
+                {
+                    float sum = 0, wsum = 0;
+                    int val0 = sptr[j];
+                    for( k = 0; k < maxk; k++ )
+                    {
+                        int val = sptr[j + space_ofs[k]];
+                        float w = space_weight[k]*color_weight[std::abs(val - val0)];
+                        sum += val*w;
+                        wsum += w;
+                    }
+                    // overflow is not possible here => there is no need to use CV_CAST_8U
+                    dptr[j] = (uchar)cvRound(sum/wsum);
+                }
+            }
+            else
+            {
+                assert( cn == 3 );
+                for( j = 0; j < size.width*3; j += 3 )
+                {
+                    float sum_b = 0, sum_g = 0, sum_r = 0, wsum = 0;
+                    int b0 = sptr[j], g0 = sptr[j+1], r0 = sptr[j+2];
+                    for( k = 0; k < maxk; k++ )
+                    {
+                        const uchar* sptr_k = sptr + j + space_ofs[k];
+                        int b = sptr_k[0], g = sptr_k[1], r = sptr_k[2];
+                        float w = space_weight[k]*color_weight[std::abs(b - b0) +
+                            std::abs(g - g0) + std::abs(r - r0)];
+                        sum_b += b*w; sum_g += g*w; sum_r += r*w;
+                        wsum += w;
+                    }
+                    wsum = 1.f/wsum;
+                    b0 = cvRound(sum_b*wsum);
+                    g0 = cvRound(sum_g*wsum);
+                    r0 = cvRound(sum_r*wsum);
+                    dptr[j] = (uchar)b0; dptr[j+1] = (uchar)g0; dptr[j+2] = (uchar)r0;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat* temp;
+    Mat* dest;
+    int radius, maxk;
+    const int* space_ofs;
+    const float* space_weight;
+    const float* color_weight;
+};
+
 static void
 bilateralFilter_8u( const Mat& src, Mat& dst, int d,
                     double sigma_color, double sigma_space,
                     int borderType )
 {
     int cn = src.channels();
-    int i, j, k, maxk, radius;
+    int i, j, maxk, radius;
     Size size = src.size();
 
     CV_Assert( (src.type() == CV_8UC1 || src.type() == CV_8UC3) &&
@@ -1336,54 +1786,90 @@ bilateralFilter_8u( const Mat& src, Mat& dst, int d,
             space_ofs[maxk++] = (int)(i*temp.step + j*cn);
         }
 
-    for( i = 0; i < size.height; i++ )
+    BilateralFilter_8u_Invoker body(temp, dst, radius, maxk, space_ofs, space_weight, color_weight);
+    parallel_for(BlockedRange(0, size.height), body);
+}
+
+
+class BilateralFilter_32f_Invoker
+{
+public:
+    BilateralFilter_32f_Invoker( const Mat& _temp, Mat& _dest, int _radius, int _maxk,
+                                 const int* _space_ofs, const float* _space_weight,
+                                 const float* _expLUT, float _scale_index ) :
+        temp(&_temp), dest(&_dest), radius(_radius), maxk(_maxk),
+        space_ofs(_space_ofs), space_weight(_space_weight), expLUT(_expLUT),
+        scale_index(_scale_index)
     {
-        const uchar* sptr = temp.data + (i+radius)*temp.step + radius*cn;
-        uchar* dptr = dst.data + i*dst.step;
+    }
 
-        if( cn == 1 )
+    void operator()( const BlockedRange& range ) const
+    {
+        int i, j, k, cn = dest->channels();
+        Size size = dest->size();
+
+        for( i = range.begin(); i < range.end(); i++ )
         {
-            for( j = 0; j < size.width; j++ )
+            const float* sptr = (const float*)(temp->data + (i+radius)*temp->step) + radius*cn;
+            float* dptr = (float*)(dest->data + i*dest->step);
+
+            if( cn == 1 )
             {
-                float sum = 0, wsum = 0;
-                int val0 = sptr[j];
-                for( k = 0; k < maxk; k++ )
+                for( j = 0; j < size.width; j++ )
                 {
-                    int val = sptr[j + space_ofs[k]];
-                    float w = space_weight[k]*color_weight[std::abs(val - val0)];
-                    sum += val*w;
-                    wsum += w;
+                    float sum = 0, wsum = 0;
+                    float val0 = sptr[j];
+                    for( k = 0; k < maxk; k++ )
+                    {
+                        float val = sptr[j + space_ofs[k]];
+                        float alpha = (float)(std::abs(val - val0)*scale_index);
+                        int idx = cvFloor(alpha);
+                        alpha -= idx;
+                        float w = space_weight[k]*(expLUT[idx] + alpha*(expLUT[idx+1] - expLUT[idx]));
+                        sum += val*w;
+                        wsum += w;
+                    }
+                    dptr[j] = (float)(sum/wsum);
                 }
-                // overflow is not possible here => there is no need to use CV_CAST_8U
-                dptr[j] = (uchar)cvRound(sum/wsum);
             }
-        }
-        else
-        {
-            assert( cn == 3 );
-            for( j = 0; j < size.width*3; j += 3 )
+            else
             {
-                float sum_b = 0, sum_g = 0, sum_r = 0, wsum = 0;
-                int b0 = sptr[j], g0 = sptr[j+1], r0 = sptr[j+2];
-                for( k = 0; k < maxk; k++ )
+                assert( cn == 3 );
+                for( j = 0; j < size.width*3; j += 3 )
                 {
-                    const uchar* sptr_k = sptr + j + space_ofs[k];
-                    int b = sptr_k[0], g = sptr_k[1], r = sptr_k[2];
-                    float w = space_weight[k]*color_weight[std::abs(b - b0) +
-                        std::abs(g - g0) + std::abs(r - r0)];
-                    sum_b += b*w; sum_g += g*w; sum_r += r*w;
-                    wsum += w;
+                    float sum_b = 0, sum_g = 0, sum_r = 0, wsum = 0;
+                    float b0 = sptr[j], g0 = sptr[j+1], r0 = sptr[j+2];
+                    for( k = 0; k < maxk; k++ )
+                    {
+                        const float* sptr_k = sptr + j + space_ofs[k];
+                        float b = sptr_k[0], g = sptr_k[1], r = sptr_k[2];
+                        float alpha = (float)((std::abs(b - b0) +
+                            std::abs(g - g0) + std::abs(r - r0))*scale_index);
+                        int idx = cvFloor(alpha);
+                        alpha -= idx;
+                        float w = space_weight[k]*(expLUT[idx] + alpha*(expLUT[idx+1] - expLUT[idx]));
+                        sum_b += b*w; sum_g += g*w; sum_r += r*w;
+                        wsum += w;
+                    }
+                    wsum = 1.f/wsum;
+                    b0 = sum_b*wsum;
+                    g0 = sum_g*wsum;
+                    r0 = sum_r*wsum;
+                    dptr[j] = b0; dptr[j+1] = g0; dptr[j+2] = r0;
                 }
-                wsum = 1.f/wsum;
-                b0 = cvRound(sum_b*wsum);
-                g0 = cvRound(sum_g*wsum);
-                r0 = cvRound(sum_r*wsum);
-                dptr[j] = (uchar)b0; dptr[j+1] = (uchar)g0; dptr[j+2] = (uchar)r0;
             }
         }
     }
-}
 
+private:
+    const Mat* temp;
+    Mat* dest;
+    int radius, maxk;
+    const int* space_ofs;
+    const float* space_weight;
+    const float* expLUT;
+    float scale_index;
+};
 
 static void
 bilateralFilter_32f( const Mat& src, Mat& dst, int d,
@@ -1391,7 +1877,7 @@ bilateralFilter_32f( const Mat& src, Mat& dst, int d,
                      int borderType )
 {
     int cn = src.channels();
-    int i, j, k, maxk, radius;
+    int i, j, maxk, radius;
     double minValSrc=-1, maxValSrc=1;
     const int kExpNumBinsPerChannel = 1 << 12;
     int kExpNumBins = 0;
@@ -1463,69 +1949,268 @@ bilateralFilter_32f( const Mat& src, Mat& dst, int d,
             space_ofs[maxk++] = (int)(i*(temp.step/sizeof(float)) + j*cn);
         }
 
-    for( i = 0; i < size.height; i++ )
+    BilateralFilter_32f_Invoker body(temp, dst, radius, maxk, space_ofs, space_weight, expLUT, scale_index);
+    parallel_for(BlockedRange(0, size.height), body);
+}
+
+
+/*
+   Approximation of the bilateral filter by the bilateral grid, see
+   J. Chen, S. Paris, F. Durand, "Real-time Edge-Aware Image Processing with the Bilateral Grid", 2007.
+   The pixels are accumulated into a coarse 3D grid (x, y, intensity) with the cell size
+   sigma_space/quality by sigma_color/quality, the grid is blurred with Gaussian and the
+   result is read back by the trilinear interpolation. For 3-channel images the intensity
+   axis is the sum of the channels, so that along the gray axis the color distance is
+   the same L1 distance that is used by the exact filter.
+*/
+class BilateralGrid
+{
+public:
+    BilateralGrid( const Mat& _src, double sigma_color, double sigma_space, double quality )
     {
-	    const float* sptr = (const float*)(temp.data + (i+radius)*temp.step) + radius*cn;
-        float* dptr = (float*)(dst.data + i*dst.step);
+        src = _src;
+        cn = src.channels();
+        nc = cn + 1;
+
+        double minVal = 0, maxVal = 255;
+        if( src.depth() != CV_8U )
+            minMaxLoc( src.reshape(1), &minVal, &maxVal );
+        gmin = (float)(minVal*cn);
+
+        // the grid cells smaller than a pixel do not improve the quality
+        double ss = std::max(sigma_space/quality, 1.), sr = sigma_color/quality;
+        scale_s = (float)(1./ss);
+        scale_r = (float)(1./sr);
+        sigma_gs = sigma_space/ss;
+        sigma_gr = sigma_color/sr;
+
+        gsize[0] = cvFloor((src.rows - 1)*scale_s) + 2;
+        gsize[1] = cvFloor((src.cols - 1)*scale_s) + 2;
+        gsize[2] = cvFloor((maxVal - minVal)*cn*scale_r) + 2;
+        CV_Assert( (double)gsize[0]*gsize[1]*gsize[2]*nc < INT_MAX );
+        grid.create(gsize[0], gsize[1]*gsize[2]*nc, CV_32F);
+        grid = Scalar::all(0);
+    }
+
+    template<typename T> void splat( int gy0, int gy1 );
+    void blur( int axis, int i0, int i1 );
+    template<typename T> void slice( Mat& dst, int y0, int y1 ) const;
+
+    Mat src;
+    Mat grid;
+    int cn, nc;
+    int gsize[3];
+    float gmin, scale_s, scale_r;
+    double sigma_gs, sigma_gr;
+};
+
+
+// accumulates the pixels that fall into the grid rows [gy0, gy1); the grid rows are
+// updated only by the pixels mapped to them, so the disjoint ranges can be processed in parallel
+template<typename T> void BilateralGrid::splat( int gy0, int gy1 )
+{
+    int y0 = std::max(cvFloor((gy0 - 0.5f)/scale_s), 0);
+    int y1 = std::min(cvCeil((gy1 + 0.5f)/scale_s) + 1, src.rows);
+    int rowstep = gsize[2]*nc;
 
-        if( cn == 1 )
+    for( int y = y0; y < y1; y++ )
+    {
+        int gy = cvRound(y*scale_s);
+        if( gy < gy0 || gy >= gy1 )
+            continue;
+        const T* sptr = (const T*)(src.data + src.step*y);
+        float* grow = (float*)(grid.data + grid.step*gy);
+
+        for( int x = 0; x < src.cols; x++, sptr += cn )
+        {
+            float g = 0;
+            for( int c = 0; c < cn; c++ )
+                g += (float)sptr[c];
+            int gx = cvRound(x*scale_s), gz = cvRound((g - gmin)*scale_r);
+            float* cell = grow + gx*rowstep + gz*nc;
+            for( int c = 0; c < cn; c++ )
+                cell[c] += (float)sptr[c];
+            cell[cn] += 1.f;
+        }
+    }
+}
+
+
+// blurs the grid along the axis (0 - y, 1 - x, 2 - intensity). The lines along y are
+// enumerated by x and the lines along x and intensity - by y; [i0, i1) is the range of it
+void BilateralGrid::blur( int axis, int i0, int i1 )
+{
+    double sigma = axis == 2 ? sigma_gr : sigma_gs;
+    int i, j, k, l, c, len = gsize[axis], radius = std::max(cvCeil(sigma*2), 1);
+    Mat kernel = getGaussianKernel(radius*2 + 1, sigma, CV_32F);
+    const float* kx = (const float*)kernel.data + radius;
+    size_t gstep = grid.step/sizeof(float), rowstep = (size_t)gsize[2]*nc;
+    size_t cstep = axis == 0 ? gstep : axis == 1 ? rowstep : nc;
+    size_t lstep = axis == 2 ? rowstep : nc;
+    size_t istep = axis == 0 ? rowstep : gstep;
+    int nlines = gsize[axis == 2 ? 1 : 2];
+    AutoBuffer<float> _buf(len*nc);
+    float* buf = _buf;
+
+    for( i = i0; i < i1; i++ )
+        for( l = 0; l < nlines; l++ )
         {
-            for( j = 0; j < size.width; j++ )
+            float* line = (float*)grid.data + i*istep + l*lstep;
+            for( j = 0; j < len; j++ )
+                for( c = 0; c < nc; c++ )
+                    buf[j*nc + c] = line[j*cstep + c];
+
+            // the cells outside of the grid are empty
+            for( j = 0; j < len; j++ )
             {
-                float sum = 0, wsum = 0;
-                float val0 = sptr[j];
-                for( k = 0; k < maxk; k++ )
+                int k0 = std::max(-radius, -j), k1 = std::min(radius, len - 1 - j);
+                for( c = 0; c < nc; c++ )
                 {
-                    float val = sptr[j + space_ofs[k]];
-					float alpha = (float)(std::abs(val - val0)*scale_index);
-                    int idx = cvFloor(alpha);
-                    alpha -= idx;
-                    float w = space_weight[k]*(expLUT[idx] + alpha*(expLUT[idx+1] - expLUT[idx]));
-	                sum += val*w;
-                    wsum += w;
+                    float s = 0;
+                    for( k = k0; k <= k1; k++ )
+                        s += kx[k]*buf[(j + k)*nc + c];
+                    line[j*cstep + c] = s;
                 }
-                dptr[j] = (float)(sum/wsum);
             }
         }
-        else
+}
+
+
+template<typename T> void BilateralGrid::slice( Mat& dst, int y0, int y1 ) const
+{
+    int rowstep = gsize[2]*nc;
+    size_t gstep = grid.step/sizeof(float);
+
+    for( int y = y0; y < y1; y++ )
+    {
+        const T* sptr = (const T*)(src.data + src.step*y);
+        T* dptr = (T*)(dst.data + dst.step*y);
+        float fy = y*scale_s;
+        int iy = std::min(cvFloor(fy), gsize[0] - 2);
+        fy -= iy;
+
+        for( int x = 0; x < src.cols; x++, sptr += cn, dptr += cn )
         {
-            assert( cn == 3 );
-            for( j = 0; j < size.width*3; j += 3 )
+            float g = 0, fx = x*scale_s, fz, sum[4] = {0, 0, 0, 0};
+            int c, ix, iz;
+            for( c = 0; c < cn; c++ )
+                g += (float)sptr[c];
+            ix = std::min(cvFloor(fx), gsize[1] - 2);
+            fz = (g - gmin)*scale_r;
+            iz = std::min(std::max(cvFloor(fz), 0), gsize[2] - 2);
+            fx -= ix;
+            fz -= iz;
+
+            const float* cell = (const float*)grid.data + iy*gstep + ix*rowstep + iz*nc;
+            float w[8] =
             {
-                float sum_b = 0, sum_g = 0, sum_r = 0, wsum = 0;
-                float b0 = sptr[j], g0 = sptr[j+1], r0 = sptr[j+2];
-                for( k = 0; k < maxk; k++ )
-                {
-                    const float* sptr_k = sptr + j + space_ofs[k];
-                    float b = sptr_k[0], g = sptr_k[1], r = sptr_k[2];
-					float alpha = (float)((std::abs(b - b0) +
-                        std::abs(g - g0) + std::abs(r - r0))*scale_index);
-                    int idx = cvFloor(alpha);
-                    alpha -= idx;
-                    float w = space_weight[k]*(expLUT[idx] + alpha*(expLUT[idx+1] - expLUT[idx]));
-                    sum_b += b*w; sum_g += g*w; sum_r += r*w;
-                    wsum += w;
-                }
-                wsum = 1.f/wsum;
-                b0 = sum_b*wsum;
-                g0 = sum_g*wsum;
-                r0 = sum_r*wsum;
-                dptr[j] = b0; dptr[j+1] = g0; dptr[j+2] = r0;
+                (1-fy)*(1-fx)*(1-fz), (1-fy)*(1-fx)*fz, (1-fy)*fx*(1-fz), (1-fy)*fx*fz,
+                fy*(1-fx)*(1-fz), fy*(1-fx)*fz, fy*fx*(1-fz), fy*fx*fz
+            };
+            const float* cells[8] =
+            {
+                cell, cell + nc, cell + rowstep, cell + rowstep + nc,
+                cell + gstep, cell + gstep + nc, cell + gstep + rowstep, cell + gstep + rowstep + nc
+            };
+
+            for( int k = 0; k < 8; k++ )
+                for( c = 0; c < nc; c++ )
+                    sum[c] += w[k]*cells[k][c];
+
+            if( sum[cn] > FLT_EPSILON )
+            {
+                float scale = 1.f/sum[cn];
+                for( c = 0; c < cn; c++ )
+                    dptr[c] = saturate_cast<T>(sum[c]*scale);
             }
+            else
+                for( c = 0; c < cn; c++ )
+                    dptr[c] = sptr[c];
         }
     }
 }
 
+
+class BilateralGridInvoker
+{
+public:
+    enum { SPLAT=0, BLUR_Y=1, BLUR_X=2, BLUR_R=3, SLICE=4 };
+
+    BilateralGridInvoker( BilateralGrid& _grid, Mat& _dst, int _stage ) :
+        grid(&_grid), dst(&_dst), stage(_stage) {}
+
+    void operator()( const BlockedRange& range ) const
+    {
+        bool is8u = grid->src.depth() == CV_8U;
+        if( stage == SPLAT )
+        {
+            if( is8u )
+                grid->splat<uchar>(range.begin(), range.end());
+            else
+                grid->splat<float>(range.begin(), range.end());
+        }
+        else if( stage == SLICE )
+        {
+            if( is8u )
+                grid->slice<uchar>(*dst, range.begin(), range.end());
+            else
+                grid->slice<float>(*dst, range.begin(), range.end());
+        }
+        else
+            grid->blur(stage - BLUR_Y, range.begin(), range.end());
+    }
+
+private:
+    BilateralGrid* grid;
+    Mat* dst;
+    int stage;
+};
+
+
+static void
+bilateralFilter_grid( const Mat& src, Mat& dst, double sigma_color, double sigma_space, double quality )
+{
+    CV_Assert( (src.type() == CV_8UC1 || src.type() == CV_8UC3 ||
+                src.type() == CV_32FC1 || src.type() == CV_32FC3) &&
+               src.type() == dst.type() && src.size() == dst.size() );
+    CV_Assert( quality > 0 );
+
+    if( sigma_color <= 0 )
+        sigma_color = 1;
+    if( sigma_space <= 0 )
+        sigma_space = 1;
+
+    BilateralGrid g( src, sigma_color, sigma_space, quality );
+    typedef BilateralGridInvoker I;
+
+    parallel_for(BlockedRange(0, g.gsize[0]), I(g, dst, I::SPLAT));
+    // the lines along y are enumerated by x, the lines along x and intensity - by y
+    parallel_for(BlockedRange(0, g.gsize[1]), I(g, dst, I::BLUR_Y));
+    parallel_for(BlockedRange(0, g.gsize[0]), I(g, dst, I::BLUR_X));
+    parallel_for(BlockedRange(0, g.gsize[0]), I(g, dst, I::BLUR_R));
+    parallel_for(BlockedRange(0, src.rows), I(g, dst, I::SLICE));
+}
+
 }
 
 void cv::bilateralFilter( InputArray _src, OutputArray _dst, int d,
                       double sigmaColor, double sigmaSpace,
-                      int borderType )
+                      int borderType, int flags, double quality )
 {
+    CV_TRACE_REGION("cv::bilateralFilter");
     Mat src = _src.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     _dst.create( src.size(), src.type() );
     Mat dst = _dst.getMat();
     
+    if( flags == BILATERAL_GRID )
+    {
+        // the grid is filled completely before the output is written, so in-place is fine here
+        bilateralFilter_grid( src, dst, sigmaColor, sigmaSpace, quality );
+        return;
+    }
+    CV_Assert( flags == BILATERAL_EXACT );
+
     if( src.depth() == CV_8U )
         bilateralFilter_8u( src, dst, d, sigmaColor, sigmaSpace, borderType );
     else if( src.depth() == CV_32F )
@@ -103,6 +103,9 @@ void crossCorr( const Mat& img, const Mat& templ, Mat& corr,
         bufSize = std::max( bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
 
     buf.resize(bufSize);
+
+    // all the transforms below have the same size, so the tables are computed once
+    DFTPlan fwdPlan(dftsize, maxDepth), invPlan(dftsize, maxDepth, DFT_INVERSE + DFT_SCALE);
     
     // compute DFT of each template plane
     for( k = 0; k < tcn; k++ )
@@ -127,7 +130,7 @@ void crossCorr( const Mat& img, const Mat& templ, Mat& corr,
             Mat part(dst, Range(0, templ.rows), Range(templ.cols, dst.cols));
             part = Scalar::all(0);
         }
-        dft(dst, dst, 0, templ.rows);
+        fwdPlan(dst, dst, templ.rows);
     }
 
     int tileCountX = (corr.cols + blocksize.width - 1)/blocksize.width;
@@ -182,11 +185,11 @@ void crossCorr( const Mat& img, const Mat& templ, Mat& corr,
                 copyMakeBorder(dst1, dst, y1-y0, dst.rows-dst1.rows-(y1-y0),
                                x1-x0, dst.cols-dst1.cols-(x1-x0), borderType);
 
-            dft( dftImg, dftImg, 0, dsz.height );
+            fwdPlan( dftImg, dftImg, dsz.height );
             Mat dftTempl1(dftTempl, Rect(0, tcn > 1 ? k*dftsize.height : 0,
                                          dftsize.width, dftsize.height));
             mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
-            dft( dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height );
+            invPlan( dftImg, dftImg, bsz.height );
 
             src = dftImg(Rect(0, 0, bsz.width, bsz.height));
 
@@ -234,6 +237,7 @@ cv::crossCorr( const Mat& img, const Mat& templ, Mat& corr,
 
 void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result, int method )
 {
+    CV_TRACE_REGION("cv::matchTemplate");
     CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
     
     int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
@@ -500,7 +500,9 @@ getThreshVal_Otsu_8u( const Mat& _src )
     
 double cv::threshold( InputArray _src, OutputArray _dst, double thresh, double maxval, int type )
 {
+    CV_TRACE_REGION("cv::threshold");
     Mat src = _src.getMat();
+    CV_TRACE_BYTES(src.total()*src.elemSize());
     bool use_otsu = (type & THRESH_OTSU) != 0;
     type &= THRESH_MASK;
 
@@ -1658,6 +1658,169 @@ void CV_ColorBayerTest::prepare_to_validation( int /*test_case_idx*/ )
         CV_Error(CV_StsUnsupportedFormat, "");
 }
 
+
+//////////////////////////////// YUV420 -> RGB ////////////////////////////////////////
+
+class CV_ColorYUV420Test : public cvtest::BaseTest
+{
+public:
+    CV_ColorYUV420Test() {}
+protected:
+    void run(int);
+};
+
+
+void CV_ColorYUV420Test::run(int)
+{
+    RNG& rng = ts->get_rng();
+    const int ntests = 30;
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int width = rng.uniform(1, 200)*2, height = rng.uniform(1, 150)*2;
+        int cw = width/2, ch = height/2;
+        Mat Y(height, width, CV_8U), U(ch, cw, CV_8U), V(ch, cw, CV_8U);
+        rng.fill(Y, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        rng.fill(U, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        rng.fill(V, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+        // the same picture in the 4 layouts: NV12, NV21, I420, YV12
+        Mat src[4];
+        for( int k = 0; k < 4; k++ )
+        {
+            src[k].create(height*3/2, width, CV_8U);
+            Mat luma = src[k].rowRange(0, height);
+            Y.copyTo(luma);
+            uchar* chroma = src[k].ptr(height);
+            for( int i = 0; i < ch; i++ )
+                for( int j = 0; j < cw; j++ )
+                {
+                    uchar u = U.at<uchar>(i, j), v = V.at<uchar>(i, j);
+                    if( k < 2 )
+                    {
+                        chroma[i*width + j*2] = k == 0 ? u : v;
+                        chroma[i*width + j*2 + 1] = k == 0 ? v : u;
+                    }
+                    else
+                    {
+                        chroma[i*cw + j + (k == 2 ? 0 : ch*cw)] = u;
+                        chroma[i*cw + j + (k == 2 ? ch*cw : 0)] = v;
+                    }
+                }
+        }
+
+        // the reference uses the same fixed-point BT.601 coefficients
+        Mat ref(height, width, CV_8UC3);
+        for( int i = 0; i < height; i++ )
+            for( int j = 0; j < width; j++ )
+            {
+                int y = (Y.at<uchar>(i, j) - 16)*298;
+                int u = U.at<uchar>(i/2, j/2) - 128, v = V.at<uchar>(i/2, j/2) - 128;
+                Vec3b& p = ref.at<Vec3b>(i, j);
+                p[0] = saturate_cast<uchar>((y + 516*u + 128) >> 8);
+                p[1] = saturate_cast<uchar>((y - 100*u - 208*v + 128) >> 8);
+                p[2] = saturate_cast<uchar>((y + 409*v + 128) >> 8);
+            }
+
+        Mat refRGB, refBGRA, refRGBA;
+        cvtColor(ref, refRGB, CV_BGR2RGB);
+        cvtColor(ref, refBGRA, CV_BGR2BGRA);
+        cvtColor(ref, refRGBA, CV_BGR2RGBA);
+
+        static const int codes[][4] =
+        {
+            { CV_YUV2BGR_NV12, CV_YUV2RGB_NV12, CV_YUV2BGRA_NV12, CV_YUV2RGBA_NV12 },
+            { CV_YUV2BGR_NV21, CV_YUV2RGB_NV21, CV_YUV2BGRA_NV21, CV_YUV2RGBA_NV21 },
+            { CV_YUV2BGR_IYUV, CV_YUV2RGB_IYUV, CV_YUV2BGRA_IYUV, CV_YUV2RGBA_IYUV },
+            { CV_YUV2BGR_YV12, CV_YUV2RGB_YV12, CV_YUV2BGRA_YV12, CV_YUV2RGBA_YV12 }
+        };
+        const Mat* refs[] = { &ref, &refRGB, &refBGRA, &refRGBA };
+
+        for( int k = 0; k < 4; k++ )
+        {
+            for( int c = 0; c < 4; c++ )
+            {
+                Mat dst;
+                cvtColor(src[k], dst, codes[k][c]);
+                if( dst.size() != ref.size() || dst.type() != refs[c]->type() || norm(dst, *refs[c], NORM_INF) != 0 )
+                {
+                    ts->printf(cvtest::TS::LOG, "The YUV420 conversion %d of %dx%d image is incorrect\n",
+                               codes[k][c], width, height);
+                    ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                    return;
+                }
+            }
+
+            Mat gray;
+            cvtColor(src[k], gray, CV_YUV2GRAY_420);
+            if( gray.size() != Y.size() || norm(gray, Y, NORM_INF) != 0 )
+            {
+                ts->printf(cvtest::TS::LOG, "YUV420 -> GRAY is incorrect\n");
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                return;
+            }
+        }
+
+        // the legacy YUV420i code with the explicit number of the destination channels
+        Mat dst4;
+        cvtColor(src[1], dst4, CV_YUV420i2BGR, 4);
+        if( norm(dst4, refBGRA, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "YUV420i -> BGRA is incorrect\n");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+
+
+//////////////////////////// thread-invariance of the conversions ////////////////////////////
+
+class CV_ColorParallelTest : public cvtest::BaseTest
+{
+public:
+    CV_ColorParallelTest() {}
+protected:
+    void run(int);
+};
+
+
+void CV_ColorParallelTest::run(int)
+{
+    static const int codes[][2] =
+    {
+        { CV_BGR2GRAY, CV_8UC3 }, { CV_BGR2HSV, CV_8UC3 }, { CV_RGB2HSV_FULL, CV_8UC4 },
+        { CV_BGR2Lab, CV_8UC3 }, { CV_BGR2Luv, CV_32FC3 }, { CV_HLS2BGR, CV_8UC3 },
+        { CV_BayerBG2BGR, CV_8UC1 }, { CV_BayerGR2BGR, CV_16UC1 }, { CV_BayerGB2GRAY, CV_8UC1 },
+        { CV_BayerRG2BGR_VNG, CV_8UC1 }, { CV_BayerGB2BGR_VNG, CV_8UC1 }, { CV_YUV2BGR_NV12, CV_8UC1 }
+    };
+    RNG& rng = ts->get_rng();
+    int nthreads = getNumThreads();
+
+    for( size_t i = 0; i < sizeof(codes)/sizeof(codes[0]); i++ )
+    {
+        int code = codes[i][0], type = codes[i][1];
+        // the sizes are big enough for several bands; the odd band boundaries are likely
+        Size sz(rng.uniform(200, 700)*2, rng.uniform(150, 300)*3);
+        Mat src(sz, type), src1, dst1, dst2;
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(CV_MAT_DEPTH(type) == CV_32F ? 1 : 255));
+        // a submatrix to avoid the continuous case
+        src1 = code == CV_YUV2BGR_NV12 ? src : src(Rect(1, 1, sz.width - 3, sz.height - 1));
+
+        cvtColor(src1, dst1, code);
+        setNumThreads(1);
+        cvtColor(src1, dst2, code);
+        setNumThreads(nthreads);
+
+        if( norm(dst1, dst2, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The result of the conversion %d depends on the number of threads\n", code);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 TEST(Imgproc_ColorGray, accuracy) { CV_ColorGrayTest test; test.safe_run(); }
@@ -1669,3 +1832,5 @@ TEST(Imgproc_ColorLab, accuracy) { CV_ColorLabTest test; test.safe_run(); }
 TEST(Imgproc_ColorLuv, accuracy) { CV_ColorLuvTest test; test.safe_run(); }
 TEST(Imgproc_ColorRGB, accuracy) { CV_ColorRGBTest test; test.safe_run(); }
 TEST(Imgproc_ColorBayer, accuracy) { CV_ColorBayerTest test; test.safe_run(); }
+TEST(Imgproc_ColorYUV420, accuracy) { CV_ColorYUV420Test test; test.safe_run(); }
+TEST(Imgproc_ColorParallel, accuracy) { CV_ColorParallelTest test; test.safe_run(); }
@@ -390,4 +390,166 @@ _exit_:
 
 TEST(Imgproc_FindContours, accuracy) { CV_FindContourTest test; test.safe_run(); }
 
+
+// checks that cv::findContours and cv::convexHull, which do not use CvSeq,
+// give the same results as the C functions
+class CV_FindContourCppTest : public cvtest::BaseTest
+{
+public:
+    CV_FindContourCppTest() {}
+protected:
+    void run(int);
+    bool checkContours(const Mat& img, int mode, int method, Point offset);
+    bool checkHull(const vector<Point>& contour);
+};
+
+
+bool CV_FindContourCppTest::checkContours(const Mat& img, int mode, int method, Point offset)
+{
+    Mat img1 = img.clone(), img2 = img.clone();
+    vector<vector<Point> > contours;
+    vector<Vec4i> hierarchy;
+    findContours(img1, contours, hierarchy, mode, method, offset);
+
+    MemStorage storage(cvCreateMemStorage());
+    CvMat _img2 = img2;
+    CvSeq* first = 0;
+    cvFindContours(&_img2, storage, &first, sizeof(CvContour), mode, method, offset);
+
+    if( cvtest::norm(img1, img2, NORM_INF) != 0 )
+    {
+        ts->printf(cvtest::TS::LOG, "The images marked by findContours and cvFindContours differ\n");
+        return false;
+    }
+
+    vector<CvSeq*> ref;
+    if( first )
+    {
+        Seq<CvSeq*> all(cvTreeToNodeSeq(first, sizeof(CvSeq), storage));
+        ref = all;
+    }
+
+    if( contours.size() != ref.size() || hierarchy.size() != ref.size() )
+    {
+        ts->printf(cvtest::TS::LOG, "%d contour(s) found, %d expected\n",
+                   (int)contours.size(), (int)ref.size());
+        return false;
+    }
+
+    for( size_t i = 0; i < ref.size(); i++ )
+        ((CvContour*)ref[i])->color = (int)i;
+
+    for( size_t i = 0; i < ref.size(); i++ )
+    {
+        CvSeq* c = ref[i];
+        vector<Point> refpts;
+        Seq<Point>(c).copyTo(refpts);
+        Vec4i refh(c->h_next ? ((CvContour*)c->h_next)->color : -1,
+                   c->h_prev ? ((CvContour*)c->h_prev)->color : -1,
+                   c->v_next ? ((CvContour*)c->v_next)->color : -1,
+                   c->v_prev ? ((CvContour*)c->v_prev)->color : -1);
+        if( refpts != contours[i] || refh != hierarchy[i] )
+        {
+            ts->printf(cvtest::TS::LOG, "Contour #%d (%d points) differs from the reference (%d points)\n",
+                       (int)i, (int)contours[i].size(), (int)refpts.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool CV_FindContourCppTest::checkHull(const vector<Point>& contour)
+{
+    for( int k = 0; k < 2; k++ )
+    {
+        vector<Point> hull, refhull;
+        vector<int> hullidx, refidx;
+        bool clockwise = k == 0;
+        convexHull(contour, hull, clockwise);
+        convexHull(contour, hullidx, clockwise);
+
+        CvMat _contour = Mat(contour);
+        refhull.resize(contour.size());
+        refidx.resize(contour.size());
+        CvMat _refhull = Mat(refhull), _refidx = Mat(refidx);
+        cvConvexHull2(&_contour, &_refhull, clockwise ? CV_CLOCKWISE : CV_COUNTER_CLOCKWISE, 1);
+        cvConvexHull2(&_contour, &_refidx, clockwise ? CV_CLOCKWISE : CV_COUNTER_CLOCKWISE, 0);
+        refhull.resize(_refhull.rows);
+        refidx.resize(_refidx.rows);
+
+        if( hull != refhull || hullidx != refidx )
+        {
+            ts->printf(cvtest::TS::LOG, "convexHull differs from cvConvexHull2 (clockwise=%d)\n", (int)clockwise);
+            return false;
+        }
+
+        for( size_t i = 0; i < hullidx.size(); i++ )
+            if( (unsigned)hullidx[i] >= contour.size() || contour[hullidx[i]] != hull[i] )
+            {
+                ts->printf(cvtest::TS::LOG, "The hull index #%d does not match the hull point\n", (int)i);
+                return false;
+            }
+
+        if( hull.size() >= 3 )
+        {
+            double area = contourArea(hull, true);
+            if( !isContourConvex(hull) || (area > 0) != !clockwise )
+            {
+                ts->printf(cvtest::TS::LOG, "The hull is not convex or has a wrong orientation\n");
+                return false;
+            }
+            for( size_t i = 0; i < contour.size(); i++ )
+                if( pointPolygonTest(hull, contour[i], false) < 0 )
+                {
+                    ts->printf(cvtest::TS::LOG, "The point #%d lies outside of the hull\n", (int)i);
+                    return false;
+                }
+        }
+    }
+    return true;
+}
+
+
+void CV_FindContourCppTest::run(int)
+{
+    RNG& rng = ts->get_rng();
+    const int methods[] = { CV_CHAIN_APPROX_NONE, CV_CHAIN_APPROX_SIMPLE,
+                            CV_CHAIN_APPROX_TC89_L1, CV_CHAIN_APPROX_TC89_KCOS };
+
+    for( int iter = 0; iter < 100; iter++ )
+    {
+        Size sz(rng.uniform(3, 300), rng.uniform(3, 300));
+        IplImage* img = cvCreateImage(sz, 8, 1);
+        cvTsGenerateBlobImage(img, 1, 50, rng.uniform(1, 200), 0, 2, rng);
+        Mat src = cvarrToMat(img, true);
+        cvReleaseImage(&img);
+
+        // let the image border touch some of the blobs
+        if( iter % 3 == 0 )
+            rectangle(src, Point(0, 0), Point(sz.width/3, sz.height - 1), Scalar(1), CV_FILLED);
+
+        int mode = iter % 4, method = methods[(iter / 4) % 4];
+        Point offset = iter % 5 == 0 ? Point(rng.uniform(-10, 10), rng.uniform(-10, 10)) : Point();
+
+        if( !checkContours(src, mode, method, offset) )
+        {
+            ts->printf(cvtest::TS::LOG, "mode=%d, method=%d, size=%dx%d\n", mode, method, sz.width, sz.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+            return;
+        }
+
+        vector<vector<Point> > contours;
+        findContours(src, contours, CV_RETR_LIST, CV_CHAIN_APPROX_NONE);
+        for( size_t i = 0; i < contours.size(); i += 3 )
+            if( !checkHull(contours[i]) )
+            {
+                ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+                return;
+            }
+    }
+}
+
+TEST(Imgproc_FindContours, cpp) { CV_FindContourCppTest test; test.safe_run(); }
+
 /* End of file. */
@@ -1758,6 +1758,257 @@ void CV_IntegralTest::prepare_to_validation( int /*test_case_idx*/ )
 }
 
 
+//////////////////////////// median of 16-bit and floating-point images /////////////////////////////
+
+class CV_MedianBlurDepthsTest : public cvtest::BaseTest
+{
+public:
+    CV_MedianBlurDepthsTest() {}
+protected:
+    void run(int);
+};
+
+
+template<typename T> static void
+test_medianFilterReplicate( const Mat& src, Mat& dst, int m )
+{
+    int cn = src.channels(), r = m/2;
+    Mat ext;
+    copyMakeBorder(src, ext, r, r, r, r, BORDER_REPLICATE);
+    dst.create(src.size(), src.type());
+    vector<T> buf(m*m);
+
+    for( int i = 0; i < src.rows; i++ )
+        for( int j = 0; j < src.cols; j++ )
+            for( int c = 0; c < cn; c++ )
+            {
+                for( int k = 0; k < m*m; k++ )
+                    buf[k] = ext.ptr<T>(i + k/m)[(j + k%m)*cn + c];
+                std::nth_element(buf.begin(), buf.begin() + m*m/2, buf.end());
+                dst.ptr<T>(i)[j*cn + c] = buf[m*m/2];
+            }
+}
+
+
+void CV_MedianBlurDepthsTest::run(int)
+{
+    const int ntests = 60;
+    const int depths[] = { CV_8U, CV_16U, CV_16S, CV_32F };
+    RNG& rng = ts->get_rng();
+    int nthreads0 = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int depth = depths[rng.uniform(0, 4)];
+        int cn = depth == CV_8U ? (rng.uniform(0, 2) ? 3 : 1) : rng.uniform(1, 4);
+        int ksize = rng.uniform(1, 8)*2 + 1;
+        Size sz(rng.uniform(1, 150), rng.uniform(1, 150));
+        Mat src(sz, CV_MAKETYPE(depth, cn)), dst, ref;
+
+        if( depth == CV_32F )
+            rng.fill(src, RNG::UNIFORM, Scalar::all(-1000), Scalar::all(1000));
+        else if( rng.uniform(0, 2) )
+            rng.fill(src, RNG::UNIFORM, Scalar::all(-40000), Scalar::all(70000));
+        else
+            // a narrow range, so that the equal values are frequent
+            rng.fill(src, RNG::UNIFORM, Scalar::all(100), Scalar::all(110));
+
+        setNumThreads(rng.uniform(1, 5));
+        medianBlur(src, dst, ksize);
+        setNumThreads(nthreads0);
+
+        if( depth == CV_8U )
+            test_medianFilterReplicate<uchar>(src, ref, ksize);
+        else if( depth == CV_16U )
+            test_medianFilterReplicate<ushort>(src, ref, ksize);
+        else if( depth == CV_16S )
+            test_medianFilterReplicate<short>(src, ref, ksize);
+        else
+            test_medianFilterReplicate<float>(src, ref, ksize);
+
+        double err = norm(dst, ref, NORM_INF);
+        if( err != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "Invalid median: depth=%d, cn=%d, size=%dx%d, ksize=%d, err=%g\n",
+                       depth, cn, sz.width, sz.height, ksize, err);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+
+
+//////////////////////////// striped FilterEngine::apply /////////////////////////////
+
+class CV_FilterStripesTest : public cvtest::BaseTest
+{
+public:
+    CV_FilterStripesTest() {}
+protected:
+    void run(int);
+    void filter(int op, const Mat& src, Mat& dst, const Mat& kernel, int borderType);
+};
+
+
+void CV_FilterStripesTest::filter(int op, const Mat& src, Mat& dst, const Mat& kernel, int borderType)
+{
+    switch( op )
+    {
+    case 0:
+        GaussianBlur(src, dst, kernel.size(), 0, 0, borderType);
+        break;
+    case 1:
+        Sobel(src, dst, src.depth() == CV_8U ? CV_16S : src.depth(), 1, 1, kernel.cols, 1, 0, borderType);
+        break;
+    case 2:
+        blur(src, dst, kernel.size(), Point(-1,-1), borderType);
+        break;
+    case 3:
+        filter2D(src, dst, -1, kernel, Point(-1,-1), 0, borderType);
+        break;
+    case 4:
+        erode(src, dst, kernel > 0, Point(-1,-1), 1, borderType);
+        break;
+    default:
+        dilate(src, dst, kernel > 0, Point(-1,-1), 2, borderType);
+    }
+}
+
+
+void CV_FilterStripesTest::run(int)
+{
+    const int ntests = 100;
+    const int types[] = { CV_8UC1, CV_8UC3, CV_16SC1, CV_32FC1, CV_32FC3 };
+    const int borderTypes[] = { BORDER_REPLICATE, BORDER_REFLECT_101, BORDER_CONSTANT };
+    RNG& rng = ts->get_rng();
+    int stripes0 = getNumFilterStripes();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = types[rng.uniform(0, 5)];
+        int op = rng.uniform(0, 6);
+        int borderType = borderTypes[rng.uniform(0, 3)];
+        int ksize = rng.uniform(1, 4)*2 + 1;
+        if( op == 4 || op == 5 )
+        {
+            // the morphology does not support 16-bit signed images
+            type = CV_MAT_DEPTH(type) == CV_16S ? CV_8UC1 : type;
+            borderType = BORDER_CONSTANT;
+        }
+
+        Size sz(rng.uniform(1, 300), rng.uniform(1, 300));
+        Mat big(sz.height + 10, sz.width + 10, type), src, dst0, dst1;
+        rng.fill(big, RNG::UNIFORM, Scalar::all(0), Scalar::all(100));
+        // a ROI of a bigger image, so the stripes also read the pixels outside of the ROI
+        src = rng.uniform(0, 2) ? big(Rect(5, 5, sz.width, sz.height)) : big;
+
+        Mat kernel(ksize, ksize, CV_32F);
+        rng.fill(kernel, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+
+        int nstripes = rng.uniform(2, 9);
+        setNumFilterStripes(1);
+        filter(op, src, dst0, kernel, borderType);
+        setNumFilterStripes(nstripes);
+        filter(op, src, dst1, kernel, borderType);
+        setNumFilterStripes(stripes0);
+
+        double err = norm(dst0, dst1, NORM_INF);
+        if( err != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The striped result differs from the serial one: "
+                       "op=%d, type=%d, size=%dx%d, ksize=%d, border=%d, %d stripes, err=%g\n",
+                       op, type, sz.width, sz.height, ksize, borderType, nstripes, err);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
+//////////////////////////////////// bilateral filter ////////////////////////////////////
+
+class CV_BilateralGridTest : public cvtest::BaseTest
+{
+public:
+    CV_BilateralGridTest() {}
+protected:
+    void run(int);
+};
+
+
+void CV_BilateralGridTest::run(int)
+{
+    const int ntests = 20;
+    const int types[] = { CV_8UC1, CV_8UC3, CV_32FC1, CV_32FC3 };
+    RNG& rng = ts->get_rng();
+    int nthreads0 = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = types[rng.uniform(0, 4)];
+        Size sz(rng.uniform(20, 120), rng.uniform(20, 120));
+        double scale = CV_MAT_DEPTH(type) == CV_8U ? 1 : 1./255;
+        double sigmaSpace = rng.uniform(2., 5.), sigmaColor = rng.uniform(20., 40.)*scale;
+        int d = cvRound(sigmaSpace*3)*2 + 1;
+
+        // a few flat rectangles with sharp edges, plus some noise. The grid separates
+        // colors by their brightness only, so the rectangles are tinted, not arbitrary colors
+        Mat src(sz, type, Scalar::all(128*scale)), noise(sz, type);
+        for( int k = 0; k < 4; k++ )
+        {
+            Point pt1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+            Point pt2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+            int v = rng.uniform(20, 236);
+            Scalar color(v + rng.uniform(-20, 20), v + rng.uniform(-20, 20), v + rng.uniform(-20, 20));
+            rectangle(src, pt1, pt2, color*scale, CV_FILLED);
+        }
+        rng.fill(noise, RNG::NORMAL, Scalar::all(0), Scalar::all(5*scale));
+        add(src, noise, src);
+
+        Mat exact0, exact1, grid1, grid2;
+        setNumThreads(1);
+        bilateralFilter(src, exact0, d, sigmaColor, sigmaSpace, BORDER_REPLICATE);
+        setNumThreads(rng.uniform(2, 5));
+        bilateralFilter(src, exact1, d, sigmaColor, sigmaSpace, BORDER_REPLICATE);
+        bilateralFilter(src, grid1, 0, sigmaColor, sigmaSpace, BORDER_DEFAULT, BILATERAL_GRID, 1);
+        bilateralFilter(src, grid2, 0, sigmaColor, sigmaSpace, BORDER_DEFAULT, BILATERAL_GRID, 2);
+        setNumThreads(nthreads0);
+
+        double err = norm(exact0, exact1, NORM_INF);
+        if( err != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The parallel exact filter differs from the serial one: "
+                       "type=%d, size=%dx%d, d=%d, err=%g\n", type, sz.width, sz.height, d, err);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+
+        // the grid is an approximation, so only the average deviation is checked
+        double npix = (double)src.total()*src.channels();
+        double err1 = norm(exact0, grid1, NORM_L1)/(npix*scale);
+        double err2 = norm(exact0, grid2, NORM_L1)/(npix*scale);
+        if( err1 > 4 || err2 > err1*1.1 + 0.1 )
+        {
+            ts->printf(cvtest::TS::LOG, "Bad bilateral grid accuracy: type=%d, size=%dx%d, "
+                       "sigmaColor=%g, sigmaSpace=%g, err(quality=1)=%g, err(quality=2)=%g\n",
+                       type, sz.width, sz.height, sigmaColor, sigmaSpace, err1, err2);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+
+        // in-place processing must give the same result
+        Mat inplace = src.clone();
+        bilateralFilter(inplace, inplace, 0, sigmaColor, sigmaSpace, BORDER_DEFAULT, BILATERAL_GRID, 1);
+        if( norm(inplace, grid1, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "In-place bilateral grid differs from the out-of-place one\n");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////
 
 TEST(Imgproc_Erode, accuracy) { CV_ErodeTest test; test.safe_run(); }
@@ -1769,9 +2020,12 @@ TEST(Imgproc_Laplace, accuracy) { CV_LaplaceTest test; test.safe_run(); }
 TEST(Imgproc_Blur, accuracy) { CV_BlurTest test; test.safe_run(); }
 TEST(Imgproc_GaussianBlur, accuracy) { CV_GaussianBlurTest test; test.safe_run(); }
 TEST(Imgproc_MedianBlur, accuracy) { CV_MedianBlurTest test; test.safe_run(); }
+TEST(Imgproc_MedianBlurDepths, accuracy) { CV_MedianBlurDepthsTest test; test.safe_run(); }
 TEST(Imgproc_PyramidDown, accuracy) { CV_PyramidDownTest test; test.safe_run(); }
 //TEST(Imgproc_PyramidUp, accuracy) { CV_PyramidUpTest test; test.safe_run(); }
 TEST(Imgproc_MinEigenVal, accuracy) { CV_MinEigenValTest test; test.safe_run(); }
 TEST(Imgproc_EigenValsVecs, accuracy) { CV_EigenValVecTest test; test.safe_run(); }
 TEST(Imgproc_PreCornerDetect, accuracy) { CV_PreCornerDetectTest test; test.safe_run(); }
 TEST(Imgproc_Integral, accuracy) { CV_IntegralTest test; test.safe_run(); }
+TEST(Imgproc_FilterStripes, accuracy) { CV_FilterStripesTest test; test.safe_run(); }
+TEST(Imgproc_BilateralGrid, accuracy) { CV_BilateralGridTest test; test.safe_run(); }
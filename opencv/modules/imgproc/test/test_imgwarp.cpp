@@ -1375,6 +1375,267 @@ void CV_GetQuadSubPixTest::prepare_to_validation( int /*test_case_idx*/ )
 
 //////////////////////////////////////////////////////////////////////////
 
+//////////////////////////// fused cvtColor + resize + convertTo /////////////////////////////
+
+class CV_PreprocessImageTest : public cvtest::BaseTest
+{
+public:
+    CV_PreprocessImageTest() {}
+protected:
+    void run(int);
+};
+
+
+void CV_PreprocessImageTest::run(int)
+{
+    const int ntests = 200;
+    const int types[] = { CV_8UC3, CV_8UC1, CV_16UC3, CV_32FC3 };
+    const int codes[] = { -1, CV_BGR2GRAY, CV_BGR2RGB, CV_BGR2HSV, CV_BayerBG2BGR };
+    const int interps[] = { INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_AREA, INTER_LANCZOS4 };
+    RNG& rng = ts->get_rng();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = types[rng.uniform(0, 4)];
+        int code = codes[rng.uniform(0, 5)];
+        int interp = interps[rng.uniform(0, 5)];
+        bool planar = rng.uniform(0, 2) != 0;
+        double alpha = rng.uniform(-1., 1.), beta = rng.uniform(-10., 10.);
+
+        if( code == CV_BGR2HSV && CV_MAT_DEPTH(type) == CV_16U )
+            type = CV_8UC3;
+        if( code == CV_BayerBG2BGR )
+            type = CV_8UC1;
+        else if( code >= 0 && CV_MAT_CN(type) == 1 )
+            type = CV_8UC3;
+
+        Size ssize(rng.uniform(2, 1000), rng.uniform(2, 1000));
+        Size dsize = rng.uniform(0, 10) == 0 ? Size() :
+            Size(rng.uniform(1, 1000), rng.uniform(1, 1000));
+        Mat src(ssize, type), dst0, dst1;
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(CV_MAT_DEPTH(type) == CV_32F ? 1 : 255));
+
+        // reference: the separate steps
+        Mat cvt, rsz, f;
+        if( code >= 0 )
+            cvtColor(src, cvt, code);
+        else
+            cvt = src;
+        rsz = cvt;
+        if( dsize != Size() && dsize != ssize )
+            resize(cvt, rsz, dsize, 0, 0, interp);
+        rsz.convertTo(f, CV_32F, alpha, beta);
+        if( planar )
+        {
+            int cn = f.channels();
+            vector<Mat> planes;
+            split(f, planes);
+            dst0.create(f.rows*cn, f.cols, CV_32F);
+            for( int c = 0; c < cn; c++ )
+            {
+                Mat plane = dst0.rowRange(c*f.rows, (c+1)*f.rows);
+                planes[c].copyTo(plane);
+            }
+        }
+        else
+            dst0 = f;
+
+        preprocessImage(src, dst1, dsize, code, interp, alpha, beta, planar);
+
+        if( dst0.size() != dst1.size() || dst0.type() != dst1.type() ||
+            norm(dst0, dst1, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The fused result differs from the separate steps: "
+                       "type=%d, code=%d, interpolation=%d, planar=%d, %dx%d -> %dx%d\n",
+                       type, code, interp, (int)planar, ssize.width, ssize.height,
+                       dsize.width, dsize.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+
+
+//////////////////////////// compiled warp /////////////////////////////
+
+class CV_WarpPlanTest : public cvtest::BaseTest
+{
+public:
+    CV_WarpPlanTest() {}
+protected:
+    void run(int);
+};
+
+
+void CV_WarpPlanTest::run(int)
+{
+    const int ntests = 150;
+    const int types[] = { CV_8UC1, CV_8UC3, CV_8UC4, CV_16UC1, CV_16UC4, CV_16SC1, CV_32FC1, CV_32FC3, CV_32FC4 };
+    const int interps[] = { INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_AREA, INTER_LANCZOS4 };
+    const int borders[] = { BORDER_CONSTANT, BORDER_REPLICATE, BORDER_REFLECT_101, BORDER_TRANSPARENT };
+    RNG& rng = ts->get_rng();
+    int nthreads = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = types[rng.uniform(0, 9)], depth = CV_MAT_DEPTH(type);
+        int interp = interps[rng.uniform(0, 5)];
+        int border = borders[rng.uniform(0, 4)];
+        int mode = rng.uniform(0, 4);
+        Scalar borderValue = Scalar::all(rng.uniform(0, 100));
+        Size ssize(rng.uniform(1, 300), rng.uniform(1, 300));
+        Size dsize(rng.uniform(1, 400), rng.uniform(1, 400));
+
+        Mat src(ssize, type), dst0(dsize, type), dst1, dst2;
+        double maxval = depth == CV_16S ? 30000 : depth == CV_16U ? 65535 : 255;
+        rng.fill(src, RNG::UNIFORM, Scalar::all(depth == CV_16S ? -maxval : 0), Scalar::all(maxval));
+        rng.fill(dst0, RNG::UNIFORM, Scalar::all(0), Scalar::all(100));
+        dst0.copyTo(dst1);
+        dst0.copyTo(dst2);
+
+        WarpPlan plan;
+        Mat M, map1, map2;
+        if( mode < 2 )
+        {
+            Point2f center(ssize.width*0.5f, ssize.height*0.5f);
+            M = getRotationMatrix2D(center, rng.uniform(-180., 180.), rng.uniform(0.5, 2.));
+            M.at<double>(0,2) += rng.uniform(-20., 20.);
+            if( mode == 1 )
+            {
+                Mat H = Mat::eye(3, 3, CV_64F);
+                Mat H2 = H.rowRange(0, 2);
+                M.copyTo(H2);
+                H.at<double>(2,0) = rng.uniform(-1e-3, 1e-3);
+                H.at<double>(2,1) = rng.uniform(-1e-3, 1e-3);
+                M = H;
+            }
+            int flags = interp | (rng.uniform(0, 2) ? WARP_INVERSE_MAP : 0);
+            plan.create(M, dsize, flags);
+            if( mode == 0 )
+                warpAffine(src, dst0, M, dsize, flags, border, borderValue);
+            else
+                warpPerspective(src, dst0, M, dsize, flags, border, borderValue);
+        }
+        else
+        {
+            map1.create(dsize, CV_32FC2);
+            rng.fill(map1, RNG::UNIFORM, Scalar::all(-10), Scalar(ssize.width + 10, ssize.height + 10));
+            if( mode == 3 )
+                convertMaps(map1, Mat(), map1, map2, CV_16SC2, interp == INTER_NEAREST);
+            plan.createMaps(map1, map2, interp);
+            remap(src, dst0, map1, map2, interp, border, borderValue);
+        }
+
+        plan(src, dst1, border, borderValue);
+        setNumThreads(1);
+        plan(src, dst2, border, borderValue);
+        setNumThreads(nthreads);
+
+        if( plan.size() != dsize || norm(dst0, dst1, NORM_INF) != 0 || norm(dst1, dst2, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The compiled warp differs from the direct one or depends on the number of threads: "
+                       "mode=%d, type=%d, interpolation=%d, border=%d, %dx%d -> %dx%d\n",
+                       mode, type, interp, border, ssize.width, ssize.height, dsize.width, dsize.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+
+        // the vectorized kernels vs the scalar double-precision ones
+        if( depth != CV_8U && interp != INTER_NEAREST && border != BORDER_TRANSPARENT )
+        {
+            Mat src64, dst64, dst64c;
+            src.convertTo(src64, CV_64F);
+            plan(src64, dst64, border, borderValue);
+            dst64.convertTo(dst64c, type);
+            double err = norm(dst64c, dst1, NORM_INF);
+            if( err > (depth == CV_32F ? 1e-2 : 1) )
+            {
+                ts->printf(cvtest::TS::LOG, "The result is too far from the double-precision one (%g): "
+                           "mode=%d, type=%d, interpolation=%d, border=%d\n", err, mode, type, interp, border);
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                return;
+            }
+        }
+    }
+}
+
+
+//////////////////////////// parallel resize /////////////////////////////
+
+class CV_ResizeParallelTest : public cvtest::BaseTest
+{
+public:
+    CV_ResizeParallelTest() {}
+protected:
+    void run(int);
+};
+
+
+void CV_ResizeParallelTest::run(int)
+{
+    const int ntests = 200;
+    const int types[] = { CV_8UC1, CV_8UC2, CV_8UC3, CV_8UC4, CV_16UC1, CV_16UC3, CV_16SC1, CV_32FC1, CV_32FC3, CV_32FC4 };
+    const int interps[] = { INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_AREA, INTER_LANCZOS4 };
+    RNG& rng = ts->get_rng();
+    int nthreads = getNumThreads();
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        int type = types[rng.uniform(0, 10)], depth = CV_MAT_DEPTH(type);
+        int interp = interps[rng.uniform(0, 5)];
+        Size ssize(rng.uniform(1, 700), rng.uniform(1, 700)), dsize;
+        // mostly the decimations, including the integer ones and the very big ones
+        int mode = rng.uniform(0, 4);
+        if( mode == 0 )
+            dsize = Size(rng.uniform(1, 800), rng.uniform(1, 800));
+        else if( mode == 1 )
+        {
+            int sx = rng.uniform(1, 5), sy = rng.uniform(1, 5);
+            ssize = Size(std::max(ssize.width/sx, 1)*sx, std::max(ssize.height/sy, 1)*sy);
+            dsize = Size(ssize.width/sx, ssize.height/sy);
+        }
+        else
+            dsize = Size(rng.uniform(1, ssize.width + 1), rng.uniform(1, ssize.height + 1));
+
+        Mat src(ssize, type), dst1, dst2;
+        double maxval = depth == CV_16S ? 30000 : depth == CV_16U ? 65535 : 255;
+        rng.fill(src, RNG::UNIFORM, Scalar::all(depth == CV_16S ? -maxval : 0), Scalar::all(maxval));
+
+        resize(src, dst1, dsize, 0, 0, interp);
+        setNumThreads(1);
+        resize(src, dst2, dsize, 0, 0, interp);
+        setNumThreads(nthreads);
+
+        if( dst1.size() != dsize || norm(dst1, dst2, NORM_INF) != 0 )
+        {
+            ts->printf(cvtest::TS::LOG, "The result depends on the number of threads: "
+                       "type=%d, interpolation=%d, %dx%d -> %dx%d\n",
+                       type, interp, ssize.width, ssize.height, dsize.width, dsize.height);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+
+        // the vectorized area decimation vs the plain double-precision one
+        if( interp == INTER_AREA )
+        {
+            Mat src64, dst64, dst64c;
+            src.convertTo(src64, CV_64F);
+            resize(src64, dst64, dsize, 0, 0, interp);
+            dst64.convertTo(dst64c, type);
+            double err = norm(dst64c, dst1, NORM_INF);
+            if( err > (depth == CV_32F ? 1e-3 : 1) )
+            {
+                ts->printf(cvtest::TS::LOG, "The result is too far from the double-precision one (%g): "
+                           "type=%d, %dx%d -> %dx%d\n", err, type,
+                           ssize.width, ssize.height, dsize.width, dsize.height);
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                return;
+            }
+        }
+    }
+}
+
+
 TEST(Imgproc_Resize, accuracy) { CV_ResizeTest test; test.safe_run(); }
 TEST(Imgproc_WarpAffine, accuracy) { CV_WarpAffineTest test; test.safe_run(); }
 TEST(Imgproc_WarpPerspective, accuracy) { CV_WarpPerspectiveTest test; test.safe_run(); }
@@ -1383,5 +1644,8 @@ TEST(Imgproc_Undistort, accuracy) { CV_UndistortTest test; test.safe_run(); }
 TEST(Imgproc_InitUndistortMap, accuracy) { CV_UndistortMapTest test; test.safe_run(); }
 TEST(Imgproc_GetRectSubPix, accuracy) { CV_GetRectSubPixTest test; test.safe_run(); }
 TEST(Imgproc_GetQuadSubPix, accuracy) { CV_GetQuadSubPixTest test; test.safe_run(); }
+TEST(Imgproc_PreprocessImage, accuracy) { CV_PreprocessImageTest test; test.safe_run(); }
+TEST(Imgproc_WarpPlan, accuracy) { CV_WarpPlanTest test; test.safe_run(); }
+TEST(Imgproc_Resize, parallel) { CV_ResizeParallelTest test; test.safe_run(); }
 
 /* End of file. */
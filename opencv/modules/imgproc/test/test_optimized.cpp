@@ -0,0 +1,149 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace std;
+
+/* Compares the results of the optimized code paths (SSE2 and the runtime-dispatched
+   SSSE3/SSE4.1/AVX kernels) with the results of the generic C code. */
+class CV_OptimizedPathsTest : public cvtest::BaseTest
+{
+public:
+    CV_OptimizedPathsTest() {}
+protected:
+    void run(int);
+    bool check(const Mat& generic, const Mat& optimized, double maxDiff, const char* name);
+};
+
+bool CV_OptimizedPathsTest::check(const Mat& generic, const Mat& optimized, double maxDiff, const char* name)
+{
+    double diff = norm(generic, optimized, NORM_INF);
+    if( diff > maxDiff )
+    {
+        ts->printf(cvtest::TS::LOG, "%s: the optimized result differs from the generic one by %g\n", name, diff);
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return false;
+    }
+    return true;
+}
+
+void CV_OptimizedPathsTest::run(int)
+{
+    RNG& rng = ts->get_rng();
+    const int ntests = 10;
+
+    for( int iter = 0; iter < ntests; iter++ )
+    {
+        Size sz(rng.uniform(1, 100), rng.uniform(1, 100));
+        Mat res[2][8];
+
+        Mat src32f(sz, CV_32FC(rng.uniform(1, 5)));
+        rng.fill(src32f, RNG::UNIFORM, Scalar::all(-100), Scalar::all(100));
+        Mat src8u3(sz, CV_8UC3), src8u4(sz, CV_8UC4);
+        rng.fill(src8u3, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        rng.fill(src8u4, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+        Mat mapx(sz, CV_32F), mapy(sz, CV_32F), mapxy;
+        rng.fill(mapx, RNG::UNIFORM, Scalar::all(-5), Scalar::all(sz.width + 5));
+        rng.fill(mapy, RNG::UNIFORM, Scalar::all(-5), Scalar::all(sz.height + 5));
+        Mat xy[] = { mapx, mapy };
+        merge(xy, 2, mapxy);
+
+        Point2f center(sz.width*0.5f, sz.height*0.5f);
+        Mat M = getRotationMatrix2D(center, rng.uniform(0., 360.), rng.uniform(0.5, 2.));
+        int ksize = rng.uniform(1, 8)*2 + 1;
+
+        for( int k = 0; k < 2; k++ )
+        {
+            setUseOptimized(k != 0);
+            GaussianBlur(src32f, res[k][0], Size(ksize, ksize), 0, 0, BORDER_REFLECT_101);
+            Sobel(src32f, res[k][1], CV_32F, 1, 0, 3);
+            remap(src8u3, res[k][2], mapx, mapy, INTER_LINEAR, BORDER_CONSTANT);
+            remap(src8u3, res[k][3], mapxy, Mat(), INTER_LINEAR, BORDER_REPLICATE);
+            warpAffine(src8u4, res[k][4], M, sz, INTER_NEAREST);
+            warpAffine(src8u4, res[k][5], M, sz, INTER_LINEAR);
+            cvtColor(src8u3, res[k][6], CV_BGR2RGBA);
+            cvtColor(src8u4, res[k][7], CV_BGRA2RGB);
+        }
+        setUseOptimized(true);
+
+        const char* names[] = { "GaussianBlur", "Sobel", "remap (planar maps)", "remap (interleaved map)",
+            "warpAffine (INTER_NEAREST)", "warpAffine (INTER_LINEAR)", "cvtColor (BGR2RGBA)", "cvtColor (BGRA2RGB)" };
+        for( int i = 0; i < 8; i++ )
+            if( !check(res[0][i], res[1][i], i < 2 ? 1e-3 : 0, names[i]) )
+                return;
+
+        Mat rgb0, rgb1, rgba0, rgba1;
+        setUseOptimized(false);
+        cvtColor(src8u3, rgb0, CV_BGR2RGB);
+        cvtColor(src8u4, rgba0, CV_BGRA2RGBA);
+        setUseOptimized(true);
+        cvtColor(src8u3, rgb1, CV_BGR2RGB);
+        src8u4.copyTo(rgba1);
+        cvtColor(rgba1, rgba1, CV_BGRA2RGBA);
+        if( !check(rgb0, rgb1, 0, "cvtColor (BGR2RGB)") || !check(rgba0, rgba1, 0, "cvtColor (BGRA2RGBA, in-place)") )
+            return;
+
+        Mat yuv(sz.height*3, sz.width*2, CV_8U), hsv[2], hsvFull[2], nv12[2], i420[2];
+        rng.fill(yuv, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        for( int k = 0; k < 2; k++ )
+        {
+            setUseOptimized(k != 0);
+            cvtColor(src8u3, hsv[k], CV_BGR2HSV);
+            cvtColor(src8u4, hsvFull[k], CV_RGB2HSV_FULL);
+            cvtColor(yuv, nv12[k], CV_YUV2BGR_NV12);
+            cvtColor(yuv, i420[k], CV_YUV2RGBA_I420);
+        }
+        setUseOptimized(true);
+        if( !check(hsv[0], hsv[1], 0, "cvtColor (BGR2HSV)") ||
+            !check(hsvFull[0], hsvFull[1], 0, "cvtColor (RGB2HSV_FULL, 4 channels)") ||
+            !check(nv12[0], nv12[1], 0, "cvtColor (YUV2BGR_NV12)") ||
+            !check(i420[0], i420[1], 0, "cvtColor (YUV2RGBA_I420)") )
+            return;
+    }
+    ts->set_failed_test_info(cvtest::TS::OK);
+}
+
+TEST(Imgproc_OptimizedPaths, accuracy) { CV_OptimizedPathsTest test; test.safe_run(); }
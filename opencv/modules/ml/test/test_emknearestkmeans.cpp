@@ -230,6 +230,35 @@ void CV_KMeansTest::run( int /*start_from*/ )
         code = cvtest::TS::FAIL_BAD_ACCURACY;
     }
 
+    // 4. flag==KMEANS_MINI_BATCH
+    kmeans( data, 3, bestLabels, TermCriteria( TermCriteria::COUNT, iters, 0.0), 0,
+            KMEANS_PP_CENTERS | KMEANS_MINI_BATCH, noArray(), 500 );
+    if( calcErr( bestLabels, labels, sizes, false ) > 0.01f )
+    {
+        ts->printf( cvtest::TS::LOG, "bad accuracy if flag==KMEANS_MINI_BATCH" );
+        code = cvtest::TS::FAIL_BAD_ACCURACY;
+    }
+
+    // 5. flag==KMEANS_HAMERLY must give the same clustering as the plain iterations
+    Mat initLabels( pointsCount, 1, CV_32SC1 ), hamerlyLabels, centers, hamerlyCenters;
+    for( int i = 0; i < pointsCount; i++ )
+        initLabels.at<int>(i, 0) = rng.next() % 10;
+    initLabels.copyTo( bestLabels );
+    initLabels.copyTo( hamerlyLabels );
+    // the empty clusters get random centers, so both runs start from the same generator state
+    theRNG() = RNG(1);
+    double compactness = kmeans( data, 10, bestLabels, TermCriteria( TermCriteria::COUNT, iters, 0.0), 1,
+                                 KMEANS_USE_INITIAL_LABELS, centers );
+    theRNG() = RNG(1);
+    double hamerlyCompactness = kmeans( data, 10, hamerlyLabels, TermCriteria( TermCriteria::COUNT, iters, 0.0), 1,
+                                        KMEANS_USE_INITIAL_LABELS | KMEANS_HAMERLY, hamerlyCenters );
+    if( norm( bestLabels, hamerlyLabels, NORM_INF ) != 0 || norm( centers, hamerlyCenters, NORM_INF ) != 0 ||
+        compactness != hamerlyCompactness )
+    {
+        ts->printf( cvtest::TS::LOG, "flag==KMEANS_HAMERLY changes the clustering" );
+        code = cvtest::TS::FAIL_BAD_ACCURACY;
+    }
+
     ts->set_failed_test_info( code );
 }
 
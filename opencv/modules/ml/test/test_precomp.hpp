@@ -68,13 +68,14 @@ protected:
 class CV_SLMLTest : public CV_MLBaseTest
 {
 public:
-    CV_SLMLTest( const char* _modelName ); 
+    CV_SLMLTest( const char* _modelName, const char* _fileSuffix=0 ); 
 protected:
     virtual int run_test_case( int testCaseIdx );
     virtual int validate_test_results( int testCaseIdx );
 
     std::vector<float> test_resps1, test_resps2; // predicted responses for test data
     std::string fname1, fname2;
+    const char* fileSuffix;
 };
 
 #endif
@@ -47,7 +47,8 @@
 using namespace cv;
 using namespace std;
 
-CV_SLMLTest::CV_SLMLTest( const char* _modelName ) : CV_MLBaseTest( _modelName )
+CV_SLMLTest::CV_SLMLTest( const char* _modelName, const char* _fileSuffix ) :
+    CV_MLBaseTest( _modelName ), fileSuffix( _fileSuffix )
 {
     validationFN = "slvalidation.xml";
 }
@@ -64,11 +65,11 @@ int CV_SLMLTest::run_test_case( int testCaseIdx )
             if( code == cvtest::TS::OK )
             {
                 get_error( testCaseIdx, CV_TEST_ERROR, &test_resps1 );
-                fname1 = tempfile();
+                fname1 = tempfile( fileSuffix );
                 save( fname1.c_str() );
                 load( fname1.c_str() );
                 get_error( testCaseIdx, CV_TEST_ERROR, &test_resps2 );
-                fname2 = tempfile();
+                fname2 = tempfile( fileSuffix );
                 save( fname2.c_str() );
             }
             else
@@ -133,4 +134,9 @@ TEST(ML_Boost, save_load) { CV_SLMLTest test( CV_BOOST ); test.safe_run(); }
 TEST(ML_RTrees, save_load) { CV_SLMLTest test( CV_RTREES ); test.safe_run(); }
 TEST(ML_ERTrees, save_load) { CV_SLMLTest test( CV_ERTREES ); test.safe_run(); }
 
+TEST(ML_SVM, save_load_binary) { CV_SLMLTest test( CV_SVM, ".bin" ); test.safe_run(); }
+TEST(ML_ANN, save_load_binary) { CV_SLMLTest test( CV_ANN, ".bin" ); test.safe_run(); }
+TEST(ML_Boost, save_load_binary) { CV_SLMLTest test( CV_BOOST, ".bin" ); test.safe_run(); }
+TEST(ML_RTrees, save_load_binary) { CV_SLMLTest test( CV_RTREES, ".bin" ); test.safe_run(); }
+
 /* End of file. */
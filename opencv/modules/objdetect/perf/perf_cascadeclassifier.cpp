@@ -0,0 +1,37 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef std::tr1::tuple<string, int> Cascade_MinSize_t;
+typedef PerfTestWithParam<Cascade_MinSize_t> CascadeClassifier_detectMultiScale;
+
+PERF_TEST_P(CascadeClassifier_detectMultiScale, lena,
+            testing::Combine(testing::Values(string("cascadeandhog/cascades/haarcascade_frontalface_alt.xml"),
+                                             string("cascadeandhog/cascades/lbpcascade_frontalface.xml")),
+                             testing::Values(24, 60)))
+{
+    string cascadeName = get<0>(GetParam());
+    int minSize = get<1>(GetParam());
+    CascadeClassifier cc;
+    ASSERT_TRUE(cc.load(getDataPath(cascadeName))) << "Unable to load " << cascadeName;
+    Mat img = imread(getDataPath("shared/lena.jpg"), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load shared/lena.jpg";
+    equalizeHist(img, img);
+    vector<Rect> faces;
+
+    TEST_CYCLE() cc.detectMultiScale(img, faces, 1.1, 3, 0, Size(minSize, minSize));
+}
+
+PERF_TEST(HOGDescriptor, detectMultiScale)
+{
+    HOGDescriptor hog;
+    hog.setSVMDetector(HOGDescriptor::getDefaultPeopleDetector());
+    Mat img = imread(getDataPath("shared/lena.jpg"), 0);
+    ASSERT_FALSE(img.empty()) << "Unable to load shared/lena.jpg";
+    vector<Rect> found;
+
+    TEST_CYCLE() hog.detectMultiScale(img, found);
+}
@@ -1052,7 +1052,7 @@ bool CascadeClassifier::setImage( Ptr<FeatureEvaluator>& featureEvaluator, const
 struct CascadeClassifierInvoker
 {
     CascadeClassifierInvoker( CascadeClassifier& _cc, Size _sz1, int _stripSize, int _yStep, double _factor, 
-        ConcurrentRectVector& _vec, vector<int>& _levels, vector<double>& _weights, bool outputLevels = false  )
+        ConcurrentRectVector& _vec, vector<int>& _levels, vector<double>& _weights, Mutex& _mtx, bool outputLevels = false  )
     {
         classifier = &_cc;
         processingRectSize = _sz1;
@@ -1062,6 +1062,7 @@ struct CascadeClassifierInvoker
         rectangles = &_vec;
         rejectLevels  = outputLevels ? &_levels : 0;
         levelWeights  = outputLevels ? &_weights : 0;
+        mtx = &_mtx;
     }
     
     void operator()(const BlockedRange& range) const
@@ -1083,6 +1084,8 @@ struct CascadeClassifierInvoker
                         result =  -1*classifier->data.stages.size();
                     if( classifier->data.stages.size() + result < 4 )
                     {
+                        // the three vectors must stay in sync, so they are filled under the same lock
+                        AutoLock lock(*mtx);
                         rectangles->push_back(Rect(cvRound(x*scalingFactor), cvRound(y*scalingFactor), winSize.width, winSize.height)); 
                         rejectLevels->push_back(-result);
                         levelWeights->push_back(gypWeight);
@@ -1104,6 +1107,7 @@ struct CascadeClassifierInvoker
     double scalingFactor;
     vector<int> *rejectLevels;
     vector<double> *levelWeights;
+    Mutex* mtx;
 };
     
 struct getRect { Rect operator ()(const CvAvgComp& e) const { return e.rect; } };
@@ -1118,17 +1122,18 @@ bool CascadeClassifier::detectSingleScale( const Mat& image, int stripCount, Siz
     ConcurrentRectVector concurrentCandidates;
     vector<int> rejectLevels;
     vector<double> levelWeights;
+    Mutex mtx;
     if( outputRejectLevels )
     {
         parallel_for(BlockedRange(0, stripCount), CascadeClassifierInvoker( *this, processingRectSize, stripSize, yStep, factor,
-            concurrentCandidates, rejectLevels, levelWeights, true));
+            concurrentCandidates, rejectLevels, levelWeights, mtx, true));
         levels.insert( levels.end(), rejectLevels.begin(), rejectLevels.end() );
         weights.insert( weights.end(), levelWeights.begin(), levelWeights.end() );
     }
     else
     {
          parallel_for(BlockedRange(0, stripCount), CascadeClassifierInvoker( *this, processingRectSize, stripSize, yStep, factor,
-            concurrentCandidates, rejectLevels, levelWeights, false));
+            concurrentCandidates, rejectLevels, levelWeights, mtx, false));
     }
     candidates.insert( candidates.end(), concurrentCandidates.begin(), concurrentCandidates.end() );
 
@@ -1163,6 +1168,8 @@ void CascadeClassifier::detectMultiScale( const Mat& image, vector<Rect>& object
                                           int flags, Size minObjectSize, Size maxObjectSize, 
                                           bool outputRejectLevels )
 {
+    CV_TRACE_REGION("cv::CascadeClassifier::detectMultiScale");
+    CV_TRACE_BYTES(image.total()*image.elemSize());
     const double GROUP_EPS = 0.2;
     
     CV_Assert( scaleFactor > 1 && image.depth() == CV_8U );
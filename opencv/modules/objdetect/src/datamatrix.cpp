@@ -11,6 +11,7 @@ using namespace std;
 
 #undef NDEBUG
 #include <assert.h>
+#include <stdio.h>
 
 class Sampler {
 public:
@@ -830,7 +830,7 @@ struct HaarDetectObjects_ScaleImage_Invoker
                                           const Mat& _sum1, const Mat& _sqsum1, Mat* _norm1,
                                           Mat* _mask1, Rect _equRect, ConcurrentRectVector& _vec, 
                                           std::vector<int>& _levels, std::vector<double>& _weights,
-                                          bool _outputLevels  )
+                                          Mutex& _mtx, bool _outputLevels  )
     {
         cascade = _cascade;
         stripSize = _stripSize;
@@ -843,6 +843,7 @@ struct HaarDetectObjects_ScaleImage_Invoker
         vec = &_vec;
         rejectLevels = _outputLevels ? &_levels : 0;
         levelWeights = _outputLevels ? &_weights : 0;
+        mtx = &_mtx;
     }
     
     void operator()( const BlockedRange& range ) const
@@ -924,6 +925,7 @@ struct HaarDetectObjects_ScaleImage_Invoker
                             result = -1*cascade->count;
                         if( cascade->count + result < 4 )
                         {
+                            AutoLock lock(*mtx);
                             vec->push_back(Rect(cvRound(x*factor), cvRound(y*factor),
                                            winSize.width, winSize.height));
                             rejectLevels->push_back(-result);
@@ -947,6 +949,7 @@ struct HaarDetectObjects_ScaleImage_Invoker
     ConcurrentRectVector* vec;
     std::vector<int>* rejectLevels;
     std::vector<double>* levelWeights;
+    Mutex* mtx;
 };
     
 
@@ -1029,6 +1032,7 @@ cvHaarDetectObjectsForROC( const CvArr* _img,
     cv::Ptr<CvMemStorage> temp_storage;
 
     cv::ConcurrentRectVector allCandidates;
+    cv::Mutex mtx;
     std::vector<cv::Rect> rectList;
     std::vector<int> rweights;
     double factor;
@@ -1153,7 +1157,7 @@ cvHaarDetectObjectsForROC( const CvArr* _img,
                          cv::HaarDetectObjects_ScaleImage_Invoker(cascade,
                                 (((sz1.height + stripCount - 1)/stripCount + ystep-1)/ystep)*ystep,
                                 factor, cv::Mat(&sum1), cv::Mat(&sqsum1), &_norm1, &_mask1,
-                                cv::Rect(equRect), allCandidates, rejectLevels, levelWeights, outputRejectLevels));
+                                cv::Rect(equRect), allCandidates, rejectLevels, levelWeights, mtx, outputRejectLevels));
         }
     }
     else
@@ -941,7 +941,7 @@ struct HOGInvoker
 {
     HOGInvoker( const HOGDescriptor* _hog, const Mat& _img,
                 double _hitThreshold, Size _winStride, Size _padding,
-                const double* _levelScale, ConcurrentRectVector* _vec, 
+                const double* _levelScale, ConcurrentRectVector* _vec, Mutex* _mtx,
                 vector<double>* _weights=0, vector<double>* _scales=0 ) 
     {
         hog = _hog;
@@ -953,6 +953,7 @@ struct HOGInvoker
         vec = _vec;
         weights = _weights;
         scales = _scales;
+        mtx = _mtx;
     }
 
     void operator()( const BlockedRange& range ) const
@@ -975,6 +976,8 @@ struct HOGInvoker
                 resize(img, smallerImg, sz);
             hog->detect(smallerImg, locations, hitsWeights, hitThreshold, winStride, padding);
             Size scaledWinSize = Size(cvRound(hog->winSize.width*scale), cvRound(hog->winSize.height*scale));
+            // the rectangles, weights and scales must stay in sync
+            AutoLock lock(*mtx);
             for( size_t j = 0; j < locations.size(); j++ )
             {
                 vec->push_back(Rect(cvRound(locations[j].x*scale),
@@ -1004,6 +1007,7 @@ struct HOGInvoker
     ConcurrentRectVector* vec;
     vector<double>* weights;
     vector<double>* scales;
+    Mutex* mtx;
 };
 
 
@@ -1012,6 +1016,8 @@ void HOGDescriptor::detectMultiScale(
     double hitThreshold, Size winStride, Size padding,
     double scale0, double finalThreshold, bool useMeanshiftGrouping) const  
 {
+    CV_TRACE_REGION("cv::HOGDescriptor::detectMultiScale");
+    CV_TRACE_BYTES(img.total()*img.elemSize());
     double scale = 1.;
     int levels = 0;
 
@@ -1031,9 +1037,10 @@ void HOGDescriptor::detectMultiScale(
     ConcurrentRectVector allCandidates;
 
     vector<double> foundScales;
+    Mutex mtx;
     
     parallel_for(BlockedRange(0, (int)levelScale.size()),
-                 HOGInvoker(this, img, hitThreshold, winStride, padding, &levelScale[0], &allCandidates, &foundWeights, &foundScales));
+                 HOGInvoker(this, img, hitThreshold, winStride, padding, &levelScale[0], &allCandidates, &mtx, &foundWeights, &foundScales));
 
     foundLocations.resize(allCandidates.size());
     std::copy(allCandidates.begin(), allCandidates.end(), foundLocations.begin());
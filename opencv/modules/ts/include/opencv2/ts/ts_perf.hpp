@@ -0,0 +1,152 @@
+#ifndef __OPENCV_TS_PERF_HPP__
+#define __OPENCV_TS_PERF_HPP__
+
+#include "opencv2/ts/ts.hpp"
+
+namespace cvtest
+{
+
+/*!
+  The timing statistics of a single performance test. All the times are in milliseconds.
+*/
+struct CV_EXPORTS PerfMetrics
+{
+    PerfMetrics();
+
+    string name; //!< the full test name, "TestCase.Test/param"
+    int samples; //!< the number of measured iterations (the warm-up ones are not counted)
+    double min; //!< the fastest iteration
+    double median;
+    double mean;
+    double stddev;
+    double p90; //!< 90th percentile
+    double p99; //!< 99th percentile
+    double bytesPerSec; //!< the throughput if the test has declared the amount of processed data, 0 otherwise
+    double baseline; //!< the baseline median or 0 if the test is not in the baseline
+};
+
+/*!
+  The timing machinery of the performance tests, see cvtest::PerfTest.
+
+  The measured code is placed into the TEST_CYCLE() loop, which runs it a few times
+  to warm up the caches and then repeats it until both the minimum number of samples
+  is collected and the time limit is reached (or the maximum number of samples is collected).
+  The per-iteration times are reduced into cvtest::PerfMetrics, printed, added to the gtest
+  XML report (see --gtest_output) and optionally written to a separate XML/YAML/JSON file
+  and compared with the baseline.
+
+  The policy is controlled with the command-line options:
+  <ul>
+  <li> --perf_min_samples=<n> (10 by default), --perf_max_samples=<n> (100 by default)
+  <li> --perf_time_limit=<sec> (3 by default) - the time limit for a single test
+  <li> --perf_warmup=<n> (1 by default) - the number of the iterations that are not measured
+  <li> --perf_output=<file.xml|file.yml|file.json> - writes the results of all the tests
+  <li> --perf_baseline=<file.xml|file.yml> - the results of a previous run (written with --perf_output);
+       the test fails if its median time exceeds the baseline one by more than the threshold
+  <li> --perf_threshold=<ratio> (0.1 by default) - the allowed relative slowdown
+  <li> --perf_threads=<n> - calls cv::setNumThreads(n) before running the tests
+  </ul>
+*/
+class CV_EXPORTS PerfTestBase
+{
+public:
+    PerfTestBase();
+    virtual ~PerfTestBase();
+
+    //! parses the --perf_* options; must be called after ::testing::InitGoogleTest
+    static void init(int argc, const char* const argv[]);
+    //! runs all the tests, writes the results and returns the gtest exit code
+    static int runAll();
+
+    static const vector<PerfMetrics>& getResults();
+    //! returns the full name of a test data file (OPENCV_TEST_DATA_PATH + module subdirectory + relativePath)
+    static string getDataPath(const string& relativePath);
+
+protected:
+    //! resets the timer; called before the test body
+    void startTest();
+    //! computes, reports and checks the metrics; called after the test body
+    void finishTest();
+
+    //! returns true while more iterations are needed; starts timing the next iteration
+    bool next();
+    //! finishes timing the iteration
+    void stopTimer();
+    //! declares the number of bytes processed by a single iteration, to report the throughput
+    void declareBytes(size_t bytes) { bytesPerIteration = bytes; }
+    //! declares the processed data size equal to the total size of the arrays
+    void declareBytes(const Mat& a, const Mat& b=Mat(), const Mat& c=Mat());
+
+    PerfMetrics calcMetrics() const;
+
+    vector<int64> times;
+    int64 startTime;
+    int64 totalTime;
+    int iteration;
+    size_t bytesPerIteration;
+};
+
+//! the base class for the performance tests, see PERF_TEST
+class CV_EXPORTS PerfTest : public ::testing::Test, public PerfTestBase
+{
+protected:
+    virtual void SetUp() { startTest(); }
+    virtual void TearDown() { finishTest(); }
+};
+
+//! the base class for the parametrized performance tests, see PERF_TEST_P
+template<typename T> class PerfTestWithParam : public ::testing::TestWithParam<T>, public PerfTestBase
+{
+protected:
+    virtual void SetUp() { startTest(); }
+    virtual void TearDown() { finishTest(); }
+};
+
+/*!
+  The loop that runs and measures the code of a performance test:
+
+  \code
+  PERF_TEST(Core, gemm_512)
+  {
+      Mat a(512, 512, CV_32F), b(512, 512, CV_32F), c;
+      randu(a, 0, 1); randu(b, 0, 1);
+      TEST_CYCLE() gemm(a, b, 1, noArray(), 0, c);
+  }
+  \endcode
+*/
+#define TEST_CYCLE() for( ; next(); stopTimer() )
+
+//! defines a non-parametrized performance test
+#define PERF_TEST(test_case_name, test_name) \
+    GTEST_TEST_(test_case_name, test_name, ::cvtest::PerfTest, ::testing::internal::GetTypeId< ::cvtest::PerfTest >())
+
+/*!
+  defines a parametrized performance test; "fixture" is a cvtest::PerfTestWithParam<T> instance
+  and "params" is the gtest parameter generator, e.g. testing::Combine(testing::Values(...), ...)
+*/
+#define PERF_TEST_P(fixture, test_name, params) \
+    class fixture##_##test_name : public fixture \
+    { \
+    public: \
+        fixture##_##test_name() {} \
+    }; \
+    INSTANTIATE_TEST_CASE_P(Perf, fixture##_##test_name, params); \
+    TEST_P(fixture##_##test_name, test_name)
+
+const cv::Size szQVGA(320, 240), szVGA(640, 480), sz720p(1280, 720), sz1080p(1920, 1080);
+
+typedef std::tr1::tuple<cv::Size, int> Size_MatType_t;
+typedef PerfTestWithParam<Size_MatType_t> Size_MatType;
+
+}
+
+#define CV_PERF_TEST_MAIN(resourcesubdir) \
+int main(int argc, char **argv) \
+{ \
+    cvtest::TS::ptr()->init(resourcesubdir); \
+    ::testing::InitGoogleTest(&argc, argv); \
+    cvtest::PerfTest::init(argc, argv); \
+    return cvtest::PerfTest::runAll(); \
+}
+
+#endif
@@ -0,0 +1,310 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+#include "opencv2/ts/ts_perf.hpp"
+#include <map>
+
+namespace cvtest
+{
+
+static int perfMinSamples = 10;
+static int perfMaxSamples = 100;
+static int perfWarmup = 1;
+static double perfTimeLimit = 3.;
+static double perfThreshold = 0.1;
+static string perfOutputFile;
+static vector<PerfMetrics> perfResults;
+static std::map<string, double> perfBaseline;
+
+PerfMetrics::PerfMetrics()
+    : samples(0), min(0), median(0), mean(0), stddev(0), p90(0), p99(0), bytesPerSec(0), baseline(0)
+{
+}
+
+static bool parseOption(const char* arg, const char* name, string& value)
+{
+    size_t len = strlen(name);
+    if( strncmp(arg, name, len) != 0 || arg[len] != '=' )
+        return false;
+    value = arg + len + 1;
+    return true;
+}
+
+static string getExtension(const string& filename)
+{
+    size_t dot = filename.rfind('.');
+    string ext = dot == string::npos ? string() : filename.substr(dot + 1);
+    for( size_t i = 0; i < ext.size(); i++ )
+        ext[i] = (char)tolower(ext[i]);
+    return ext;
+}
+
+static void loadBaseline(const string& filename)
+{
+    cv::FileStorage fs(filename, cv::FileStorage::READ);
+    if( !fs.isOpened() )
+        CV_Error_(CV_StsError, ("Can not open the baseline file %s", filename.c_str()));
+    cv::FileNode results = fs["perf_results"];
+    for( cv::FileNodeIterator it = results.begin(); it != results.end(); ++it )
+    {
+        string name = (string)(*it)["name"];
+        double median = (double)(*it)["median"];
+        if( !name.empty() && median > 0 )
+            perfBaseline[name] = median;
+    }
+}
+
+static void writeJSONString(FILE* f, const string& str)
+{
+    fputc('\"', f);
+    for( size_t i = 0; i < str.size(); i++ )
+    {
+        char c = str[i];
+        if( c == '\"' || c == '\\' )
+            fputc('\\', f);
+        fputc(c, f);
+    }
+    fputc('\"', f);
+}
+
+static void writeResults(const string& filename)
+{
+    if( getExtension(filename) == "json" )
+    {
+        FILE* f = fopen(filename.c_str(), "wt");
+        if( !f )
+            CV_Error_(CV_StsError, ("Can not open %s for writing", filename.c_str()));
+        fprintf(f, "{\n  \"perf_results\": [");
+        for( size_t i = 0; i < perfResults.size(); i++ )
+        {
+            const PerfMetrics& m = perfResults[i];
+            fprintf(f, "%s\n    { \"name\": ", i == 0 ? "" : ",");
+            writeJSONString(f, m.name);
+            fprintf(f, ", \"samples\": %d, \"min\": %.6g, \"median\": %.6g, \"mean\": %.6g, "
+                    "\"stddev\": %.6g, \"p90\": %.6g, \"p99\": %.6g, \"bytes_per_sec\": %.6g",
+                    m.samples, m.min, m.median, m.mean, m.stddev, m.p90, m.p99, m.bytesPerSec);
+            if( m.baseline > 0 )
+                fprintf(f, ", \"baseline\": %.6g", m.baseline);
+            fprintf(f, " }");
+        }
+        fprintf(f, "\n  ]\n}\n");
+        fclose(f);
+        return;
+    }
+
+    cv::FileStorage fs(filename, cv::FileStorage::WRITE);
+    if( !fs.isOpened() )
+        CV_Error_(CV_StsError, ("Can not open %s for writing", filename.c_str()));
+    fs << "perf_results" << "[";
+    for( size_t i = 0; i < perfResults.size(); i++ )
+    {
+        const PerfMetrics& m = perfResults[i];
+        fs << "{" << "name" << m.name << "samples" << m.samples << "min" << m.min <<
+            "median" << m.median << "mean" << m.mean << "stddev" << m.stddev <<
+            "p90" << m.p90 << "p99" << m.p99 << "bytes_per_sec" << m.bytesPerSec;
+        if( m.baseline > 0 )
+            fs << "baseline" << m.baseline;
+        fs << "}";
+    }
+    fs << "]";
+}
+
+PerfTestBase::PerfTestBase()
+    : startTime(0), totalTime(0), iteration(0), bytesPerIteration(0)
+{
+}
+
+PerfTestBase::~PerfTestBase()
+{
+}
+
+void PerfTestBase::init(int argc, const char* const argv[])
+{
+    string baselineFile;
+    for( int i = 1; i < argc; i++ )
+    {
+        string val;
+        if( parseOption(argv[i], "--perf_min_samples", val) )
+            perfMinSamples = std::max(atoi(val.c_str()), 1);
+        else if( parseOption(argv[i], "--perf_max_samples", val) )
+            perfMaxSamples = std::max(atoi(val.c_str()), 1);
+        else if( parseOption(argv[i], "--perf_warmup", val) )
+            perfWarmup = std::max(atoi(val.c_str()), 0);
+        else if( parseOption(argv[i], "--perf_time_limit", val) )
+            perfTimeLimit = atof(val.c_str());
+        else if( parseOption(argv[i], "--perf_threshold", val) )
+            perfThreshold = atof(val.c_str());
+        else if( parseOption(argv[i], "--perf_output", val) )
+            perfOutputFile = val;
+        else if( parseOption(argv[i], "--perf_baseline", val) )
+            baselineFile = val;
+        else if( parseOption(argv[i], "--perf_threads", val) )
+            cv::setNumThreads(atoi(val.c_str()));
+        else if( strncmp(argv[i], "--perf_", 7) == 0 )
+            ::printf("Unknown option %s is ignored\n", argv[i]);
+    }
+    perfMaxSamples = std::max(perfMaxSamples, perfMinSamples);
+    if( !baselineFile.empty() )
+        loadBaseline(baselineFile);
+}
+
+int PerfTestBase::runAll()
+{
+    int code = RUN_ALL_TESTS();
+    if( !perfOutputFile.empty() )
+        writeResults(perfOutputFile);
+    return code;
+}
+
+const vector<PerfMetrics>& PerfTestBase::getResults()
+{
+    return perfResults;
+}
+
+string PerfTestBase::getDataPath(const string& relativePath)
+{
+    return TS::ptr()->get_data_path() + relativePath;
+}
+
+void PerfTestBase::startTest()
+{
+    times.clear();
+    startTime = totalTime = 0;
+    iteration = 0;
+    bytesPerIteration = 0;
+}
+
+bool PerfTestBase::next()
+{
+    int nsamples = (int)times.size();
+    if( nsamples >= perfMaxSamples ||
+        (nsamples >= perfMinSamples && totalTime >= perfTimeLimit*cv::getTickFrequency()) )
+        return false;
+    startTime = cv::getTickCount();
+    return true;
+}
+
+void PerfTestBase::stopTimer()
+{
+    int64 t = cv::getTickCount() - startTime;
+    if( iteration++ < perfWarmup )
+        return;
+    times.push_back(t);
+    totalTime += t;
+}
+
+void PerfTestBase::declareBytes(const Mat& a, const Mat& b, const Mat& c)
+{
+    bytesPerIteration = a.total()*a.elemSize() + b.total()*b.elemSize() + c.total()*c.elemSize();
+}
+
+PerfMetrics PerfTestBase::calcMetrics() const
+{
+    PerfMetrics m;
+    int n = (int)times.size();
+    if( n == 0 )
+        return m;
+
+    vector<double> t(n);
+    double scale = 1000./cv::getTickFrequency(), sum = 0, sqsum = 0;
+    for( int i = 0; i < n; i++ )
+    {
+        t[i] = times[i]*scale;
+        sum += t[i];
+        sqsum += t[i]*t[i];
+    }
+    std::sort(t.begin(), t.end());
+
+    m.samples = n;
+    m.min = t[0];
+    m.median = n % 2 ? t[n/2] : (t[n/2-1] + t[n/2])*0.5;
+    m.mean = sum/n;
+    m.stddev = std::sqrt(std::max(sqsum/n - m.mean*m.mean, 0.));
+    m.p90 = t[std::min(cvCeil(n*0.9), n) - 1];
+    m.p99 = t[std::min(cvCeil(n*0.99), n) - 1];
+    if( bytesPerIteration > 0 && m.median > 0 )
+        m.bytesPerSec = bytesPerIteration/(m.median*1e-3);
+    return m;
+}
+
+void PerfTestBase::finishTest()
+{
+    const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    string name = string(info->test_case_name()) + "." + info->name();
+    if( times.empty() )
+    {
+        ::printf("[ PERFSTAT ] %s: no samples, the test does not use TEST_CYCLE()\n", name.c_str());
+        return;
+    }
+
+    PerfMetrics m = calcMetrics();
+    m.name = name;
+
+    ::testing::Test::RecordProperty("samples", m.samples);
+    ::testing::Test::RecordProperty("median", cv::format("%.6g", m.median).c_str());
+    ::testing::Test::RecordProperty("mean", cv::format("%.6g", m.mean).c_str());
+    ::testing::Test::RecordProperty("stddev", cv::format("%.6g", m.stddev).c_str());
+    ::testing::Test::RecordProperty("min", cv::format("%.6g", m.min).c_str());
+    ::testing::Test::RecordProperty("p90", cv::format("%.6g", m.p90).c_str());
+    ::testing::Test::RecordProperty("p99", cv::format("%.6g", m.p99).c_str());
+
+    string extra;
+    if( m.bytesPerSec > 0 )
+        extra += cv::format(", %.1f MB/s", m.bytesPerSec/(1 << 20));
+
+    std::map<string, double>::const_iterator it = perfBaseline.find(name);
+    if( it != perfBaseline.end() )
+    {
+        m.baseline = it->second;
+        extra += cv::format(", baseline %.3f ms (%+.1f%%)", m.baseline, (m.median/m.baseline - 1)*100);
+        EXPECT_LE(m.median, m.baseline*(1 + perfThreshold))
+            << "The median time of " << name << " exceeds the baseline by more than "
+            << perfThreshold*100 << "%";
+    }
+
+    ::printf("[ PERFSTAT ] samples=%d median=%.3f ms mean=%.3f ms stddev=%.3f ms min=%.3f ms p90=%.3f ms p99=%.3f ms%s\n",
+             m.samples, m.median, m.mean, m.stddev, m.min, m.p90, m.p99, extra.c_str());
+    perfResults.push_back(m);
+}
+
+}
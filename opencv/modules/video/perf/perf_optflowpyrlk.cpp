@@ -0,0 +1,24 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cvtest;
+using std::tr1::get;
+
+typedef std::tr1::tuple<int, int> NPoints_WinSize_t;
+typedef PerfTestWithParam<NPoints_WinSize_t> OpticalFlowPyrLK;
+
+PERF_TEST_P(OpticalFlowPyrLK, full, testing::Combine(testing::Values(100, 1000), testing::Values(11, 21)))
+{
+    int npoints = get<0>(GetParam()), winSize = get<1>(GetParam());
+    Mat frame0 = imread(getDataPath("optflow/rock_1.bmp"), 0);
+    Mat frame1 = imread(getDataPath("optflow/rock_2.bmp"), 0);
+    ASSERT_FALSE(frame0.empty() || frame1.empty()) << "Unable to load optflow/rock_*.bmp";
+
+    vector<Point2f> prevPts, nextPts;
+    goodFeaturesToTrack(frame0, prevPts, npoints, 0.001, 5);
+    vector<uchar> status;
+    vector<float> err;
+
+    TEST_CYCLE() calcOpticalFlowPyrLK(frame0, frame1, prevPts, nextPts, status, err, Size(winSize, winSize), 3);
+}
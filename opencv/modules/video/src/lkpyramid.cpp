@@ -458,6 +458,7 @@ void cv::calcOpticalFlowPyrLK( InputArray _prevImg, InputArray _nextImg,
                            double derivLambda,
                            int flags )
 {
+    CV_TRACE_REGION("cv::calcOpticalFlowPyrLK");
 #ifdef HAVE_TEGRA_OPTIMIZATION
     if (tegra::calcOpticalFlowPyrLK(_prevImg, _nextImg, _prevPts, _nextPts, _status, _err, winSize, maxLevel, criteria, derivLambda, flags))
         return;